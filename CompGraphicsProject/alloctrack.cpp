@@ -0,0 +1,114 @@
+#include "alloctrack.h"
+#include "profiler.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+// ============================ COUNTERS ============================
+static std::atomic<unsigned long long> totalCount(0);
+static std::atomic<unsigned long long> totalBytes(0);
+static std::atomic<bool> guardArmed(false);
+
+int allocationGuardFrames = -1;
+thread_local unsigned long long threadAllocationCount = 0;
+thread_local int threadAllocationPhase = -1;
+static thread_local int allowDepth = 0;
+
+AllocationTotals allocationTotals() {
+    return { totalCount.load(std::memory_order_relaxed), totalBytes.load(std::memory_order_relaxed) };
+}
+
+void armAllocationGuard() {
+    guardArmed.store(true, std::memory_order_relaxed);
+}
+
+bool allocationGuardArmed() {
+    return guardArmed.load(std::memory_order_relaxed);
+}
+
+AllowAllocations::AllowAllocations() { ++allowDepth; }
+AllowAllocations::~AllowAllocations() { --allowDepth; }
+
+static void countAllocation(std::size_t bytes) {
+    totalCount.fetch_add(1, std::memory_order_relaxed);
+    totalBytes.fetch_add(bytes, std::memory_order_relaxed);
+    ++threadAllocationCount;
+    if (allowDepth == 0 && guardArmed.load(std::memory_order_relaxed)) {
+        guardArmed.store(false, std::memory_order_relaxed); // Reporting may allocate in turn
+        // Straight to stderr: the logger's writer may never get to run
+        std::fprintf(stderr, "[error] allocation of %zu bytes in the steady-state loop (phase: %s)\n", bytes,
+                     threadAllocationPhase >= 0 ? profilerPhaseName(static_cast<ProfilePhase>(threadAllocationPhase)) : "none");
+        std::fflush(stderr);
+#ifdef _MSC_VER
+        __debugbreak();
+#endif
+        std::abort();
+    }
+}
+
+// ============================ OPERATOR NEW / DELETE ============================
+static void* allocate(std::size_t bytes) {
+    countAllocation(bytes);
+    for (;;) {
+        if (void* p = std::malloc(bytes ? bytes : 1)) return p;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+static void* allocateAligned(std::size_t bytes, std::align_val_t alignment) {
+    countAllocation(bytes);
+    const std::size_t a = static_cast<std::size_t>(alignment);
+    bytes = (bytes + a - 1) / a * a; // aligned_alloc wants a multiple of the alignment
+    for (;;) {
+#ifdef _MSC_VER
+        if (void* p = _aligned_malloc(bytes ? bytes : a, a)) return p;
+#else
+        if (void* p = std::aligned_alloc(a, bytes ? bytes : a)) return p;
+#endif
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+static void releaseAligned(void* p) {
+#ifdef _MSC_VER
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+void* operator new(std::size_t bytes) { return allocate(bytes); }
+void* operator new[](std::size_t bytes) { return allocate(bytes); }
+void* operator new(std::size_t bytes, const std::nothrow_t&) noexcept {
+    try { return allocate(bytes); } catch (...) { return nullptr; }
+}
+void* operator new[](std::size_t bytes, const std::nothrow_t&) noexcept {
+    try { return allocate(bytes); } catch (...) { return nullptr; }
+}
+void* operator new(std::size_t bytes, std::align_val_t alignment) { return allocateAligned(bytes, alignment); }
+void* operator new[](std::size_t bytes, std::align_val_t alignment) { return allocateAligned(bytes, alignment); }
+void* operator new(std::size_t bytes, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    try { return allocateAligned(bytes, alignment); } catch (...) { return nullptr; }
+}
+void* operator new[](std::size_t bytes, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    try { return allocateAligned(bytes, alignment); } catch (...) { return nullptr; }
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { releaseAligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { releaseAligned(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { releaseAligned(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { releaseAligned(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { releaseAligned(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { releaseAligned(p); }
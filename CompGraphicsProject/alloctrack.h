@@ -0,0 +1,31 @@
+#pragma once
+
+// ============================ ALLOCATION TRACKING ============================
+// Replacements for the global operator new/delete count every heap allocation made through them,
+// per process and per thread. The profiler turns the counts into per-frame and per-phase figures.
+// With the guard armed (--alloc-guard N arms it after N frames), any allocation outside an
+// AllowAllocations scope prints what allocated, breaks into the debugger and aborts: the steady-state
+// game loop is meant to allocate nothing. malloc and driver-internal allocators are not seen.
+
+struct AllocationTotals {
+    unsigned long long count;
+    unsigned long long bytes;
+};
+
+AllocationTotals allocationTotals(); // Every thread, since startup
+
+extern int allocationGuardFrames; // Frames before the guard arms (-1: never)
+void armAllocationGuard();
+bool allocationGuardArmed();
+
+// Per-thread state, read inline by ProfileScope
+extern thread_local unsigned long long threadAllocationCount;
+extern thread_local int threadAllocationPhase; // ProfilePhase being timed on this thread (-1: none)
+
+// Lets the enclosing scope allocate with the guard armed (resizes, on-demand reports)
+struct AllowAllocations {
+    AllowAllocations();
+    ~AllowAllocations();
+    AllowAllocations(const AllowAllocations&) = delete;
+    AllowAllocations& operator=(const AllowAllocations&) = delete;
+};
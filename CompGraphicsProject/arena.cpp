@@ -0,0 +1,595 @@
+#include "arena.h"
+#include "collision.h"
+#include "fastmath.h"
+#include "jobs.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <glm/gtc/constants.hpp>
+
+Arena arena;
+bool arenaMode = false;
+
+const float ARENA_SPAWN_INTERVAL = 0.25f; // Seconds between top-ups while the arena is short of rocks
+
+// ============================ CHUNKS ============================
+template <typename... Vectors>
+static size_t capacityBytes(const Vectors&... vectors) {
+    return ((vectors.capacity() * sizeof(typename Vectors::value_type)) + ... + 0);
+}
+
+size_t ArenaChunk::memoryBytes() const {
+    return capacityBytes(x, y, vx, vy, rot, rotSpeed, px, py, prot, sizeClass, paletteIndex, shapeIndex, destroyed);
+}
+
+void ArenaChunk::reserve(size_t n) {
+    x.reserve(n); y.reserve(n); vx.reserve(n); vy.reserve(n); rot.reserve(n); rotSpeed.reserve(n);
+    px.reserve(n); py.reserve(n); prot.reserve(n);
+    sizeClass.reserve(n); paletteIndex.reserve(n); shapeIndex.reserve(n); destroyed.reserve(n);
+}
+
+void ArenaChunk::push(const Asteroid& rock) {
+    x.push_back(rock.position.x); y.push_back(rock.position.y);
+    vx.push_back(rock.velocity.x); vy.push_back(rock.velocity.y);
+    rot.push_back(rock.rotation); rotSpeed.push_back(rock.rotationSpeed);
+    px.push_back(rock.position.x); py.push_back(rock.position.y); prot.push_back(rock.rotation);
+    sizeClass.push_back(rock.size); paletteIndex.push_back(rock.paletteIndex);
+    shapeIndex.push_back(rock.shapeIndex);
+    destroyed.push_back(0);
+}
+
+Asteroid ArenaChunk::get(size_t i) const {
+    Asteroid rock;
+    rock.position = glm::vec2(x[i], y[i]);
+    rock.velocity = glm::vec2(vx[i], vy[i]);
+    rock.rotation = rot[i]; rock.rotationSpeed = rotSpeed[i];
+    rock.size = sizeClass[i]; rock.paletteIndex = paletteIndex[i];
+    rock.shapeIndex = shapeIndex[i];
+    rock.destroyed = destroyed[i] != 0;
+    return rock;
+}
+
+void ArenaChunk::moveTo(size_t i, ArenaChunk& to) {
+    to.push(get(i));
+    to.px.back() = px[i]; to.py.back() = py[i]; to.prot.back() = prot[i];
+    remove(i);
+}
+
+void ArenaChunk::remove(size_t i) {
+    const size_t last = count() - 1;
+    if (i != last) {
+        x[i] = x[last]; y[i] = y[last]; vx[i] = vx[last]; vy[i] = vy[last];
+        rot[i] = rot[last]; rotSpeed[i] = rotSpeed[last];
+        px[i] = px[last]; py[i] = py[last]; prot[i] = prot[last];
+        sizeClass[i] = sizeClass[last]; paletteIndex[i] = paletteIndex[last];
+        shapeIndex[i] = shapeIndex[last]; destroyed[i] = destroyed[last];
+    }
+    x.pop_back(); y.pop_back(); vx.pop_back(); vy.pop_back(); rot.pop_back(); rotSpeed.pop_back();
+    px.pop_back(); py.pop_back(); prot.pop_back();
+    sizeClass.pop_back(); paletteIndex.pop_back(); shapeIndex.pop_back(); destroyed.pop_back();
+}
+
+// ============================ ARENA ============================
+int Arena::chunkAt(glm::vec2 position) const {
+    const int cx = std::clamp(static_cast<int>(position.x / ARENA_CHUNK_SIZE), 0, config.chunksX - 1);
+    const int cy = std::clamp(static_cast<int>(position.y / ARENA_CHUNK_SIZE), 0, config.chunksY - 1);
+    return chunkIndex(cx, cy);
+}
+
+size_t Arena::memoryBytes() const {
+    size_t bytes = capacityBytes(chunks, activeChunks, regions, scratchX, scratchY, scratchR, candidates, splits, splitFirst, children, childChunks);
+    for (const ArenaChunk& chunk : chunks) bytes += chunk.memoryBytes();
+    for (const ArenaRegion& region : regions) bytes += capacityBytes(region.outbox);
+    return bytes + bullets.memoryBytes();
+}
+
+// Into [0, extent)
+static float wrapInto(float v, float extent) {
+    v -= extent * std::floor(v / extent);
+    return v < extent ? v : 0.0f; // A value just below 0 can round up to extent itself
+}
+
+// Sets the chunk's newest rock, placed at the arena's current tick, back to the chunk's own time
+static void rewindToChunkTime(const Arena& a, ArenaChunk& chunk) {
+    if (chunk.movedAt == a.clock) return;
+    const float lag = static_cast<float>(a.clock - chunk.movedAt);
+    chunk.x.back() -= chunk.vx.back() * lag;
+    chunk.y.back() -= chunk.vy.back() * lag;
+    chunk.rot.back() -= chunk.rotSpeed.back() * lag;
+    chunk.px.back() = chunk.x.back();
+    chunk.py.back() = chunk.y.back();
+    chunk.prot.back() = chunk.rot.back();
+}
+
+// A rock as GameWorld::makeAsteroid makes one: a split child flies off at 0.3-0.7 in any direction,
+// a new rock drifts in at 0.1-0.3 (in any direction too: there is no screen edge to come in from)
+static Asteroid makeArenaRock(const Arena& a, EventRng& rng, glm::vec2 position, AsteroidSize size, bool child) {
+    Asteroid rock;
+    rock.size = size;
+    rock.rotation = 0.0f;
+    rock.rotationSpeed = 0.3f + rng.uniform() * 0.5f;
+    rock.paletteIndex = static_cast<uint8_t>(rng.below(ASTEROID_PALETTE_SIZE));
+    rock.position = glm::vec2(wrapInto(position.x, a.width), wrapInto(position.y, a.height));
+    const float angle = rng.uniform() * 2.0f * glm::pi<float>();
+    const float speed = child ? 0.3f + rng.uniform() * 0.4f : 0.1f + rng.uniform() * 0.2f;
+    fastSinCos(angle, rock.velocity.y, rock.velocity.x);
+    rock.velocity *= speed;
+    rock.shapeIndex = rng.below(ASTEROID_SHAPE_COUNT);
+    return rock;
+}
+
+static size_t arenaRockTarget(const Arena& a) { return a.chunks.size() * static_cast<size_t>(a.config.rocksPerChunk); }
+
+// A LARGE rock somewhere in a chunk out of the ship's 3x3 (so never on top of it, nor popping into view)
+static void spawnArenaRock(Arena& a) {
+    const int shipChunk = a.chunkAt(a.ship.position);
+    const int shipX = shipChunk % a.config.chunksX, shipY = shipChunk / a.config.chunksX;
+    EventRng rng(a.seed, RNG_PURPOSE_SPAWN, 0, a.spawned++);
+    int cx, cy;
+    do {
+        cx = rng.below(a.config.chunksX);
+        cy = rng.below(a.config.chunksY);
+    } while (std::abs(Arena::wrapDelta(static_cast<float>(cx), static_cast<float>(shipX), static_cast<float>(a.config.chunksX))) <= 1.0f &&
+             std::abs(Arena::wrapDelta(static_cast<float>(cy), static_cast<float>(shipY), static_cast<float>(a.config.chunksY))) <= 1.0f);
+    const glm::vec2 position((cx + rng.uniform()) * ARENA_CHUNK_SIZE, (cy + rng.uniform()) * ARENA_CHUNK_SIZE);
+    const Asteroid rock = makeArenaRock(a, rng, position, LARGE, false);
+    ArenaChunk& chunk = a.chunks[static_cast<size_t>(a.chunkAt(rock.position))];
+    chunk.push(rock);
+    rewindToChunkTime(a, chunk);
+    ++a.rockCount;
+}
+
+void initArena(Arena& target, const ArenaConfig& config, uint64_t seed, size_t maxBullets) {
+    Arena& a = target;
+    a.config = config;
+    a.config.chunksX = std::max(config.chunksX, ARENA_MIN_CHUNKS);
+    a.config.chunksY = std::max(config.chunksY, ARENA_MIN_CHUNKS);
+    a.config.rocksPerChunk = std::max(config.rocksPerChunk, 0);
+    a.config.activeRings = std::max(config.activeRings, 1);
+    a.config.distantInterval = std::max(config.distantInterval, 1);
+    a.width = a.config.chunksX * ARENA_CHUNK_SIZE;
+    a.height = a.config.chunksY * ARENA_CHUNK_SIZE;
+
+    a.chunks.assign(static_cast<size_t>(a.config.chunksX) * static_cast<size_t>(a.config.chunksY), ArenaChunk());
+    a.activeChunks.assign(a.chunks.size(), 0);
+    a.regions.clear();
+    for (int row = 0; row < a.config.chunksY; row += ARENA_REGION_ROWS) {
+        ArenaRegion region;
+        region.firstRow = row;
+        region.endRow = std::min(row + ARENA_REGION_ROWS, a.config.chunksY);
+        a.regions.push_back(std::move(region));
+    }
+    a.tick = 0;
+    a.clock = 0.0;
+    // Room for a chunk's share and as much again, before a crowded chunk grows its block
+    for (ArenaChunk& chunk : a.chunks) chunk.reserve(2 * static_cast<size_t>(a.config.rocksPerChunk) + 1);
+    a.rockCount = 0;
+
+    a.ship = Ship();
+    a.ship.position = a.ship.prevPosition = glm::vec2(0.5f * a.width, 0.5f * a.height);
+    a.bulletCooldown = 0.0f;
+    a.isThrusting = a.shieldActive = false;
+    a.shieldTimer = a.shieldCooldownTimer = 0.0f;
+    a.bullets.reserve(maxBullets);
+    a.bullets.clock = 0.0;
+
+    a.isGameOver = false;
+    a.score = 0;
+    a.spawnTimer = ARENA_SPAWN_INTERVAL;
+    a.seed = seed;
+    a.spawned = 0;
+    a.stats = ArenaStats();
+    a.scratchX.resize(COLLISION_MASK_BITS);
+    a.scratchY.resize(COLLISION_MASK_BITS);
+    a.scratchR.resize(COLLISION_MASK_BITS);
+    a.candidates.reserve(9 * a.chunks.front().x.capacity());
+
+    while (a.rockCount < arenaRockTarget(a)) spawnArenaRock(a);
+}
+
+// ============================ STEP ============================
+// The ship's controls, as GameWorld::steerShip and applyInput apply them
+static void steerArenaShip(Arena& a, const InputState& input, float dt) {
+    Ship& ship = a.ship;
+    if (input.left) ship.rotation += ROTATION_SPEED * dt;
+    if (input.right) ship.rotation -= ROTATION_SPEED * dt;
+    ship.rotation = std::fmod(ship.rotation, 2.0f * glm::pi<float>());
+
+    const float angleFromXAxis = ship.rotation + glm::half_pi<float>(); // The model points up
+    glm::vec2 direction;
+    fastSinCos(angleFromXAxis, direction.y, direction.x);
+    a.isThrusting = input.thrust;
+    if (input.thrust) ship.velocity += direction * THRUST_SPEED * dt;
+
+    if (input.fire && a.bulletCooldown <= 0.0f) {
+        Bullet bullet;
+        bullet.position = ship.position + direction * (ship.radius * 1.5f);
+        bullet.velocity = direction * BULLET_SPEED + ship.velocity;
+        bullet.owner = 0;
+        a.bullets.push(bullet);
+        a.bulletCooldown = FIRE_RATE;
+    }
+
+    if (input.shield && !a.shieldActive && a.shieldCooldownTimer <= 0.0f) {
+        a.shieldActive = true;
+        a.shieldTimer = SHIELD_DURATION;
+    }
+}
+
+static void updateArenaTimers(Arena& a, float dt) {
+    a.bulletCooldown -= dt;
+    if (a.shieldActive) {
+        a.shieldTimer -= dt;
+        if (a.shieldTimer <= 0.0f) {
+            a.shieldActive = false;
+            a.shieldCooldownTimer = SHIELD_COOLDOWN;
+        }
+    }
+    if (a.shieldCooldownTimer > 0.0f) a.shieldCooldownTimer -= dt;
+}
+
+// Flags the rock and queues its children, spawned after the sweep (the offset may put one across
+// the parent's chunk boundary: each goes into the chunk it lands in)
+static void breakArenaRock(Arena& a, int chunk, size_t i) {
+    ArenaChunk& c = a.chunks[static_cast<size_t>(chunk)];
+    c.destroyed[i] = 1;
+    if (!splitsOnHit(c.sizeClass[i])) return;
+    a.splits.push_back({ glm::vec2(c.x[i], c.y[i]), static_cast<uint64_t>(chunk) << 32 | i, c.sizeClass[i] });
+}
+
+// Every rock of the ship's 3x3 chunks at its image nearest the ship, in batches for the mask kernel.
+// The shield takes the first rock it meets and drops; the first rock the hull meets ends the game.
+static bool collideArenaShip(Arena& a) {
+    const glm::vec2 position = a.ship.position;
+    a.candidates.clear();
+    a.forEachChunkAround(position, 1, [&a](int chunk) {
+        const ArenaChunk& c = a.chunks[static_cast<size_t>(chunk)];
+        for (size_t i = 0; i < c.count(); ++i) a.candidates.push_back({ chunk, static_cast<int>(i) });
+    });
+
+    for (size_t first = 0; first < a.candidates.size(); first += COLLISION_MASK_BITS) {
+        const size_t n = std::min(COLLISION_MASK_BITS, a.candidates.size() - first);
+        for (size_t k = 0; k < n; ++k) {
+            const ArenaRockRef rock = a.candidates[first + k];
+            const ArenaChunk& c = a.chunks[static_cast<size_t>(rock.chunk)];
+            const size_t i = static_cast<size_t>(rock.index);
+            const glm::vec2 delta = a.wrapDelta(glm::vec2(c.x[i], c.y[i]), position);
+            a.scratchX[k] = position.x + delta.x;
+            a.scratchY[k] = position.y + delta.y;
+            a.scratchR[k] = c.destroyed[i] ? -1.0f : c.radius(i); // Never overlaps: already broken this tick
+        }
+        float radius = a.shieldActive ? SHIELD_RADIUS_FACTOR : a.ship.radius;
+        uint64_t hits = circleOverlapMask(position, radius, a.scratchX.data(), a.scratchY.data(), a.scratchR.data(), n);
+        while (hits != 0) {
+            const size_t k = static_cast<size_t>(std::countr_zero(hits));
+            hits &= hits - 1;
+            if (!a.shieldActive) return false;
+            const ArenaRockRef rock = a.candidates[first + k];
+            breakArenaRock(a, rock.chunk, static_cast<size_t>(rock.index));
+            a.shieldActive = false;
+            a.shieldCooldownTimer = SHIELD_COOLDOWN;
+            // The hull is smaller than the shield: re-test the candidates not visited yet
+            radius = a.ship.radius;
+            const uint64_t remaining = k + 1 < COLLISION_MASK_BITS ? ~((uint64_t(1) << (k + 1)) - 1) : 0;
+            hits = circleOverlapMask(position, radius, a.scratchX.data(), a.scratchY.data(), a.scratchR.data(), n) & remaining;
+        }
+    }
+    return true;
+}
+
+// Each bullet against the rocks of its 3x3 chunks; the first one it touches takes it, for the points
+static void collideArenaBullets(Arena& a) {
+    BulletStore& bullets = a.bullets;
+    for (size_t j = 0; j < bullets.capacity(); ++j) {
+        if (!bullets.live(j)) continue;
+        const glm::vec2 position = bullets.position(j);
+        const float radius = bullets.radius[j];
+        a.forEachChunkAround(position, 1, [&](int chunk) {
+            if (!bullets.live(j)) return;
+            const ArenaChunk& c = a.chunks[static_cast<size_t>(chunk)];
+            for (size_t i = 0; i < c.count(); ++i) {
+                if (c.destroyed[i]) continue;
+                const glm::vec2 delta = a.wrapDelta(glm::vec2(c.x[i], c.y[i]), position);
+                const float reach = radius + c.radius(i);
+                if (delta.x * delta.x + delta.y * delta.y >= reach * reach) continue;
+                bullets.tombstone(j);
+                a.score += getAsteroidPoints(c.sizeClass[i]);
+                breakArenaRock(a, chunk, i);
+                return;
+            }
+        });
+    }
+}
+
+// Takes the region's broken rocks out of their chunks. Only a chunk at full rate this tick can hold
+// one: the collisions look at no other.
+static void sweepArenaRegion(Arena& a, size_t r) {
+    ArenaRegion& region = a.regions[r];
+    region.swept = 0;
+    const size_t first = static_cast<size_t>(region.firstRow * a.config.chunksX), end = static_cast<size_t>(region.endRow * a.config.chunksX);
+    for (size_t chunk = first; chunk < end; ++chunk) {
+        if (!a.activeChunks[chunk]) continue;
+        ArenaChunk& c = a.chunks[chunk];
+        for (size_t i = c.count(); i > 0; --i) {
+            if (!c.destroyed[i - 1]) continue;
+            c.remove(i - 1);
+            ++region.swept;
+        }
+    }
+}
+
+// Sweeps the broken rocks out of their chunks and spawns the queued children, each slightly offset
+// from its parent as the game's are, while the arena has room (twice its target, as the game's pool
+// has): the splits in queue order take what room there is, the last ones going short. Every phase
+// after the prefix sum runs in parallel; none changes the outcome (see the header).
+static void resolveArenaBreaks(Arena& a) {
+    parallelFor(0, a.regions.size(), 1, [&a](size_t begin, size_t end) {
+        for (size_t r = begin; r < end; ++r) sweepArenaRegion(a, r);
+    });
+    for (const ArenaRegion& region : a.regions) a.rockCount -= region.swept;
+    if (a.splits.empty()) return;
+
+    // The slots: each split's children follow the previous split's, up to the room left
+    const size_t limit = 2 * arenaRockTarget(a), room = a.rockCount < limit ? limit - a.rockCount : 0;
+    a.splitFirst.resize(a.splits.size() + 1);
+    size_t total = 0;
+    for (size_t k = 0; k < a.splits.size(); ++k) {
+        a.splitFirst[k] = total;
+        total = std::min(room, total + static_cast<size_t>(asteroidTraits(a.splits[k].parentSize).childCount));
+    }
+    a.splitFirst[a.splits.size()] = total;
+    a.children.resize(total);
+    a.childChunks.resize(total);
+
+    parallelFor(0, a.splits.size(), ARENA_SPLIT_GRAIN, [&a](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; ++k) {
+            const ArenaSplit& split = a.splits[k];
+            const AsteroidSizeTraits& parent = asteroidTraits(split.parentSize);
+            EventRng rng(a.seed, RNG_PURPOSE_SPLIT, a.tick, split.parent);
+            for (size_t child = a.splitFirst[k]; child < a.splitFirst[k + 1]; ++child) {
+                const float offsetX = (rng.uniform() - 0.5f) * parent.scale * 0.5f;
+                const float offsetY = (rng.uniform() - 0.5f) * parent.scale * 0.5f;
+                a.children[child] = makeArenaRock(a, rng, split.position + glm::vec2(offsetX, offsetY), parent.child, true);
+                a.childChunks[child] = a.chunkAt(a.children[child].position);
+            }
+        }
+    });
+
+    parallelFor(0, a.regions.size(), 1, [&a, total](size_t begin, size_t end) {
+        for (size_t r = begin; r < end; ++r) {
+            const int first = a.regions[r].firstRow * a.config.chunksX, last = a.regions[r].endRow * a.config.chunksX;
+            for (size_t child = 0; child < total; ++child) {
+                if (a.childChunks[child] < first || a.childChunks[child] >= last) continue;
+                ArenaChunk& chunk = a.chunks[static_cast<size_t>(a.childChunks[child])];
+                chunk.push(a.children[child]);
+                rewindToChunkTime(a, chunk);
+            }
+        }
+    });
+    a.rockCount += total;
+    a.splits.clear();
+}
+
+// ============================ REGIONS ============================
+// The chunk rows are split into bands of ARENA_REGION_ROWS, each moved and migrated by one job. A
+// band is contiguous in the row-major chunk array and its job is the only one writing to it, so
+// nothing is shared while the rocks move. The bands do not depend on the number of workers, and
+// neither does the order migrants arrive in, so the arena plays the same on any core count.
+
+// Moves the region's chunks that are due (every active one, a distant one on its turn, staggered by
+// index) through the kernels, for all the time since each last moved, then walks the ones with
+// leavers backwards: a leaver bound for a chunk of the region moves there now (the rock that fills
+// its hole has already been looked at, and a rock that lands in a chunk not walked yet is past where
+// that walk starts); one bound for another region goes into the outbox.
+static void stepArenaRegion(Arena& a, size_t r, uint64_t interval) {
+    ArenaRegion& region = a.regions[r];
+    region.outbox.clear();
+    region.activeChunks = region.distantMoved = region.rocksMoved = 0;
+    region.migrations = 0;
+    const size_t first = static_cast<size_t>(a.chunkIndex(0, region.firstRow)), last = static_cast<size_t>(a.chunkIndex(0, region.endRow));
+    for (size_t c = first; c < last; ++c) {
+        if (!a.activeChunks[c] && (a.tick + c) % interval != 0) continue;
+        ArenaChunk& chunk = a.chunks[c];
+        const float step = static_cast<float>(a.clock - chunk.movedAt);
+        chunk.movedAt = a.clock;
+        const size_t n = chunk.count();
+        std::copy(chunk.x.begin(), chunk.x.end(), chunk.px.begin());
+        std::copy(chunk.y.begin(), chunk.y.end(), chunk.py.begin());
+        std::copy(chunk.rot.begin(), chunk.rot.end(), chunk.prot.begin());
+        integrateLinear(chunk.x.data(), chunk.vx.data(), n, step);
+        integrateLinear(chunk.y.data(), chunk.vy.data(), n, step);
+        integrateLinear(chunk.rot.data(), chunk.rotSpeed.data(), n, step);
+        const float minX = static_cast<float>(c % a.config.chunksX) * ARENA_CHUNK_SIZE, minY = static_cast<float>(c / a.config.chunksX) * ARENA_CHUNK_SIZE;
+        int leaving = 0;
+        for (size_t i = 0; i < n; ++i) {
+            leaving += (chunk.x[i] < minX) | (chunk.x[i] >= minX + ARENA_CHUNK_SIZE) | (chunk.y[i] < minY) | (chunk.y[i] >= minY + ARENA_CHUNK_SIZE);
+        }
+        chunk.leaving = leaving;
+        region.rocksMoved += n;
+        if (a.activeChunks[c]) ++region.activeChunks;
+        else ++region.distantMoved;
+    }
+
+    for (size_t c = first; c < last; ++c) {
+        ArenaChunk& chunk = a.chunks[c];
+        if (chunk.leaving == 0) continue;
+        for (size_t i = chunk.count(); i > 0; --i) {
+            chunk.x[i - 1] = wrapInto(chunk.x[i - 1], a.width);
+            chunk.y[i - 1] = wrapInto(chunk.y[i - 1], a.height);
+            const size_t to = static_cast<size_t>(a.chunkAt(glm::vec2(chunk.x[i - 1], chunk.y[i - 1])));
+            if (to == c) continue;
+            if (to >= first && to < last) {
+                chunk.moveTo(i - 1, a.chunks[to]);
+                rewindToChunkTime(a, a.chunks[to]);
+                ++region.migrations;
+            }
+            else {
+                region.outbox.push_back({ static_cast<int>(to), chunk.get(i - 1), chunk.px[i - 1], chunk.py[i - 1], chunk.prot[i - 1] });
+                chunk.remove(i - 1);
+            }
+        }
+        chunk.leaving = 0;
+    }
+}
+
+// The halo exchange: takes the rocks the neighbouring regions (the bands above and below, across the
+// wrap) kept for this one, the band before first, each in its outbox's order. A rock moving into a
+// chunk that has not moved this tick is set back to the chunk's time (which may put it back over the
+// line: the chunk's next move carries it across again).
+static void receiveArenaMigrants(Arena& a, size_t r, const unsigned char* ownedRegions) {
+    const size_t count = a.regions.size();
+    if (count == 1) return;
+    const size_t neighbours[2] = { (r + count - 1) % count, (r + 1) % count };
+    const int firstRow = a.regions[r].firstRow, endRow = a.regions[r].endRow;
+    for (int side = 0; side < (neighbours[0] == neighbours[1] ? 1 : 2); ++side) {
+        if (ownedRegions && !ownedRegions[neighbours[side]]) continue; // Hosted elsewhere: its rocks come as messages
+        for (const ArenaMigrant& migrant : a.regions[neighbours[side]].outbox) {
+            const int row = migrant.chunk / a.config.chunksX;
+            if (row >= firstRow && row < endRow) acceptArenaMigrant(a, migrant);
+        }
+    }
+}
+
+void acceptArenaMigrant(Arena& a, const ArenaMigrant& migrant) {
+    ArenaChunk& chunk = a.chunks[static_cast<size_t>(migrant.chunk)];
+    chunk.push(migrant.rock);
+    chunk.px.back() = migrant.px; chunk.py.back() = migrant.py; chunk.prot.back() = migrant.prot;
+    rewindToChunkTime(a, chunk);
+}
+
+void advanceArenaClock(Arena& a, float dt) {
+    ++a.tick;
+    a.clock += dt;
+    std::fill(a.activeChunks.begin(), a.activeChunks.end(), 0);
+}
+
+void moveArenaRegions(Arena& a, const unsigned char* ownedRegions) {
+    const uint64_t interval = static_cast<uint64_t>(a.config.distantInterval);
+    parallelFor(0, a.regions.size(), 1, [&a, interval, ownedRegions](size_t begin, size_t end) {
+        for (size_t r = begin; r < end; ++r) {
+            if (!ownedRegions || ownedRegions[r]) stepArenaRegion(a, r, interval);
+        }
+    });
+    parallelFor(0, a.regions.size(), 1, [&a, ownedRegions](size_t begin, size_t end) {
+        for (size_t r = begin; r < end; ++r) {
+            if (!ownedRegions || ownedRegions[r]) receiveArenaMigrants(a, r, ownedRegions);
+        }
+    });
+    a.stats.activeChunks = a.stats.distantMoved = a.stats.rocksMoved = 0;
+    a.stats.migrations = a.stats.regionMigrations = 0;
+    for (size_t r = 0; r < a.regions.size(); ++r) {
+        if (ownedRegions && !ownedRegions[r]) continue;
+        const ArenaRegion& region = a.regions[r];
+        a.stats.activeChunks += region.activeChunks;
+        a.stats.distantMoved += region.distantMoved;
+        a.stats.rocksMoved += region.rocksMoved;
+        a.stats.migrations += region.migrations + region.outbox.size();
+        a.stats.regionMigrations += region.outbox.size();
+    }
+    a.stats.distantChunks = a.chunks.size() - a.stats.activeChunks;
+    profilerCount(COUNTER_ARENA_ACTIVE_CHUNKS, static_cast<long long>(a.stats.activeChunks));
+    profilerCount(COUNTER_ARENA_DISTANT_CHUNKS, static_cast<long long>(a.stats.distantChunks));
+    profilerCount(COUNTER_ARENA_ROCKS_MOVED, static_cast<long long>(a.stats.rocksMoved));
+}
+
+void stepArena(Arena& target, float dt, const InputState& input) {
+    Arena& a = target;
+    a.ship.prevPosition = a.ship.position;
+    a.ship.prevRotation = a.ship.rotation;
+    a.bullets.savePrevious();
+    updateArenaTimers(a, dt);
+    if (a.isGameOver) return; // The rocks stay where they were, as the game's do
+
+    steerArenaShip(a, input, dt);
+    a.ship.velocity *= FRICTION_PER_TICK;
+    a.ship.position += a.ship.velocity * dt;
+    a.ship.position = glm::vec2(wrapInto(a.ship.position.x, a.width), wrapInto(a.ship.position.y, a.height));
+
+    // --- Bullets: the ring through the kernels, wrapping like the ship; they leave by lifetime only ---
+    BulletStore& bullets = a.bullets;
+    bullets.clock += dt;
+    integrateLinear(bullets.x.data(), bullets.vx.data(), bullets.capacity(), dt);
+    integrateLinear(bullets.y.data(), bullets.vy.data(), bullets.capacity(), dt);
+    for (size_t j = 0; j < bullets.capacity(); ++j) {
+        if (!bullets.live(j)) continue;
+        bullets.x[j] = wrapInto(bullets.x[j], a.width);
+        bullets.y[j] = wrapInto(bullets.y[j], a.height);
+    }
+    bullets.popExpired();
+
+    // --- Tiers: full rate around the ship and around every bullet (the 3x3 its hit test reads) ---
+    advanceArenaClock(a, dt);
+    a.forEachChunkAround(a.ship.position, a.config.activeRings, [&a](int chunk) { a.activeChunks[static_cast<size_t>(chunk)] = 1; });
+    for (size_t j = 0; j < bullets.capacity(); ++j) {
+        if (bullets.live(j)) a.forEachChunkAround(bullets.position(j), 1, [&a](int chunk) { a.activeChunks[static_cast<size_t>(chunk)] = 1; });
+    }
+
+    // --- Rocks, region by region ---
+    moveArenaRegions(a, nullptr);
+
+    // --- Collisions, then the breaks ---
+    if (!collideArenaShip(a)) {
+        a.isGameOver = true;
+        a.isThrusting = a.shieldActive = false;
+        a.ship.velocity = glm::vec2(0.0f, 0.0f);
+        return;
+    }
+    collideArenaBullets(a);
+    resolveArenaBreaks(a);
+    bullets.popExpired();
+
+    a.spawnTimer -= dt;
+    if (a.spawnTimer <= 0.0f && a.rockCount < arenaRockTarget(a)) {
+        spawnArenaRock(a);
+        a.spawnTimer = ARENA_SPAWN_INTERVAL;
+    }
+}
+
+// ============================ VIEW ============================
+void captureArenaView(Arena& source, AsteroidStore& rocks, BulletStore& bullets, Ship& ship) {
+    Arena& a = source;
+    const glm::vec2 camera = a.ship.position, previousCamera = a.ship.prevPosition;
+
+    // The chunks the view overlaps: two or three per side (it is a little over a chunk across)
+    const int firstX = static_cast<int>(std::floor((camera.x - ARENA_VIEW_REACH) / ARENA_CHUNK_SIZE));
+    const int lastX = static_cast<int>(std::floor((camera.x + ARENA_VIEW_REACH) / ARENA_CHUNK_SIZE));
+    const int firstY = static_cast<int>(std::floor((camera.y - ARENA_VIEW_REACH) / ARENA_CHUNK_SIZE));
+    const int lastY = static_cast<int>(std::floor((camera.y + ARENA_VIEW_REACH) / ARENA_CHUNK_SIZE));
+
+    rocks.sweep([](size_t) { return true; });
+    a.stats.visibleChunks = 0;
+    for (int cy = firstY; cy <= lastY; ++cy) {
+        for (int cx = firstX; cx <= lastX; ++cx) {
+            const ArenaChunk& chunk = a.chunks[static_cast<size_t>(a.chunkIndex((cx % a.config.chunksX + a.config.chunksX) % a.config.chunksX,
+                                                                                (cy % a.config.chunksY + a.config.chunksY) % a.config.chunksY))];
+            ++a.stats.visibleChunks;
+            for (size_t i = 0; i < chunk.count() && !rocks.handles.full(); ++i) {
+                Asteroid rock = chunk.get(i);
+                rock.position = a.wrapDelta(rock.position, camera);
+                if (std::abs(rock.position.x) > ARENA_VIEW_REACH || std::abs(rock.position.y) > ARENA_VIEW_REACH) continue;
+                rocks.push(rock);
+                const size_t k = rocks.count() - 1;
+                const glm::vec2 previous = a.wrapDelta(glm::vec2(chunk.px[i], chunk.py[i]), previousCamera);
+                rocks.px[k] = previous.x;
+                rocks.py[k] = previous.y;
+                rocks.prot[k] = chunk.prot[i];
+            }
+        }
+    }
+    a.stats.visibleRocks = rocks.count();
+
+    // The ring whole (it is no bigger than the game's), each live bullet moved into the camera's frame
+    bullets = a.bullets;
+    for (size_t j = 0; j < bullets.capacity(); ++j) {
+        if (!bullets.live(j)) continue;
+        const glm::vec2 position = a.wrapDelta(bullets.position(j), camera);
+        const glm::vec2 previous = a.wrapDelta(glm::vec2(bullets.px[j], bullets.py[j]), previousCamera);
+        bullets.x[j] = position.x; bullets.y[j] = position.y;
+        bullets.px[j] = previous.x; bullets.py[j] = previous.y;
+    }
+
+    ship = a.ship;
+    ship.position = ship.prevPosition = glm::vec2(0.0f, 0.0f); // The camera is on it
+}
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "simulation.h"
+
+// Scrolling arena: a field many screens wide with the camera on the ship, next to the one-screen
+// game (GameWorld, whose [-1,1] field, wrap and spawns the replays, snapshots, server and rollback
+// all rely on). The arena is a torus of chunks, each one screen (FIELD_WIDTH) across, and every rock
+// lives in the SoA block of the chunk it is in. After the move, a rock that crossed a chunk boundary
+// migrates to its new chunk's block (swap-and-pop out of the old one), so the chunks are always the
+// broadphase: the ship and each bullet look only at the 3x3 chunks around them, and a frame copies
+// out only the chunks the camera sees. What a frame costs depends on the view, not the arena's size;
+// a tick's integration stays linear in the rocks, a handful per chunk.
+// Chunks away from the action tick at a reduced rate: only those near the ship (activeRings) or
+// around a live bullet, where collisions are tested and the camera looks, move every tick. A distant
+// chunk moves once every distantInterval ticks, by all the time since it last did; rocks in the arena
+// fly straight and meet nothing out there, so the long step lands exactly where the short ones would.
+// A rock that migrates into a chunk last moved earlier is set back to that chunk's time, so a block's
+// rocks always share one; a distant chunk promoted to full rate catches up on its first tick.
+// The move is decomposed spatially: bands of chunk rows (regions) are each moved by one job, which
+// also migrates the rocks that stay in its band; rocks crossing into another band wait in the band's
+// outbox until that band's job takes them in, so no two jobs ever write to the same chunk.
+// Gameplay follows GameWorld's rules (friction, firing, shield, splits, points) for one ship, in
+// float. Rocks do not collide with each other. Arena coordinates run over [0, width) x [0, height);
+// the view (captureArenaView) is camera-relative, in the one-screen game's [-1,1] units, so the
+// renderer draws it unchanged, without the edge ghosts.
+// The random numbers come from the event generator (random.h), not from streams: a spawn's are keyed
+// by its number since the start, a split's by the tick and where its parent was, so spawns and splits
+// can be resolved on any thread, in any order, with the same outcome. The breaks are resolved in
+// parallel too: the regions sweep their broken rocks out, a prefix sum over the splits gives each its
+// children's slots, the children are made concurrently into them, and each region takes in the ones
+// landing in its rows, in slot order, so every chunk ends up as a single thread would leave it.
+// Like simulation.h, nothing here depends on GL.
+
+// ============================ CONFIGURATION ============================
+const float ARENA_CHUNK_SIZE = FIELD_WIDTH; // One screen
+const int ARENA_MIN_CHUNKS = 4; // Per side: the 3x3 around the ship, and somewhere out of view to spawn
+const int ARENA_REGION_ROWS = 4; // Chunk rows per region (the unit of work of the parallel move)
+const size_t ARENA_SPLIT_GRAIN = 64; // Splits per job when their children are made
+const float ARENA_VIEW_REACH = 1.0f + ASTEROID_MAX_OUTLINE_RADIUS * 0.15f; // Half the view, plus the largest rock's outline
+
+struct ArenaConfig {
+    int chunksX = 16, chunksY = 16;
+    int rocksPerChunk = 4; // Rocks the arena is kept topped up to, per chunk (LARGE ones, out of view)
+    int activeRings = 2; // Chunks around the ship's that tick at full rate (at least 1: what the camera sees)
+    int distantInterval = 8; // Ticks between moves of a chunk out of reach (1: every chunk every tick)
+};
+
+// ============================ CHUNKS ============================
+// One chunk's rocks, in the same SoA layout as AsteroidStore without the handles and anchors
+// (nothing refers to an arena rock across ticks)
+struct ArenaChunk {
+    std::vector<float> x, y, vx, vy, rot, rotSpeed;
+    std::vector<float> px, py, prot; // Previous tick (interpolation)
+    std::vector<AsteroidSize> sizeClass; // Scale and radius come from it
+    std::vector<uint8_t> paletteIndex;
+    std::vector<int> shapeIndex;
+    std::vector<unsigned char> destroyed; // Broken this tick, swept before the next step phase
+    int leaving = 0; // Rocks that crossed out this tick (counted by the move, cleared by the migration)
+    double movedAt = 0.0; // Arena time its rocks' positions are for
+
+    size_t count() const { return x.size(); }
+    float scale(size_t i) const { return getScaleFactor(sizeClass[i]); }
+    float radius(size_t i) const { return getRadiusFactor(sizeClass[i]); }
+    size_t memoryBytes() const;
+    void reserve(size_t n);
+    void push(const Asteroid& rock); // Previous state = current
+    Asteroid get(size_t i) const;
+    void moveTo(size_t i, ArenaChunk& to); // Appends rock i to `to` (previous state included), then removes it here
+    void remove(size_t i); // Swap-and-pop: the last rock takes index i
+};
+
+struct ArenaRockRef {
+    int chunk, index;
+};
+
+struct ArenaSplit { // A broken rock's children, queued until the sweep
+    glm::vec2 position;
+    uint64_t parent; // Its chunk and index when it broke (unique within the tick): the event's id
+    AsteroidSize parentSize; // Its children's size, count and spread come from it
+};
+
+// A rock leaving its region, kept until the region it goes to takes it in (previous state included)
+struct ArenaMigrant {
+    int chunk;
+    Asteroid rock;
+    float px, py, prot;
+};
+
+struct ArenaRegion { // A band of chunk rows [firstRow, endRow), moved by one job
+    int firstRow = 0, endRow = 0;
+    std::vector<ArenaMigrant> outbox; // Its rocks bound for other regions, last tick
+    size_t activeChunks = 0, distantMoved = 0, rocksMoved = 0;
+    uint64_t migrations = 0; // Within the region
+    size_t swept = 0; // Broken rocks it took out, last tick
+};
+
+struct ArenaStats {
+    uint64_t migrations = 0; // Rocks that changed chunk, last tick
+    uint64_t regionMigrations = 0; // ... of which changed region
+    size_t activeChunks = 0, distantChunks = 0; // Tiers, last tick
+    size_t distantMoved = 0; // Distant chunks whose turn to move it was, last tick
+    size_t rocksMoved = 0; // Rocks integrated, last tick
+    size_t visibleChunks = 0, visibleRocks = 0; // Last capture
+};
+
+// ============================ ARENA ============================
+struct Arena {
+    ArenaConfig config;
+    float width = 0.0f, height = 0.0f;
+    std::vector<ArenaChunk> chunks; // Row-major
+    std::vector<unsigned char> activeChunks; // Per chunk: at full rate this tick
+    std::vector<ArenaRegion> regions;
+    size_t rockCount = 0;
+    uint64_t tick = 0;
+    double clock = 0.0; // Game time of this tick's state
+
+    // --- The ship ---
+    Ship ship;
+    float bulletCooldown = 0.0f;
+    bool isThrusting = false;
+    bool shieldActive = false;
+    float shieldTimer = 0.0f, shieldCooldownTimer = 0.0f;
+    BulletStore bullets; // Arena coordinates; they wrap like the ship instead of leaving the field
+
+    bool isGameOver = false;
+    int score = 0;
+    float spawnTimer = 0.0f;
+    uint64_t seed = 0; // Keys the event generator
+    uint64_t spawned = 0; // Rocks spawned so far (not split off): the next spawn's id
+    ArenaStats stats;
+    std::vector<ArenaRockRef> candidates; // The rocks around the ship
+    std::vector<float> scratchX, scratchY, scratchR; // A batch of them for the mask kernel
+    std::vector<ArenaSplit> splits;
+    std::vector<size_t> splitFirst; // Per split, its first child's slot; then the number of children
+    std::vector<Asteroid> children; // The splits' children, in the order a single thread would make them
+    std::vector<int> childChunks; // The chunk each lands in
+
+    int chunkIndex(int cx, int cy) const { return cy * config.chunksX + cx; }
+    // Chunk of an arena position (already wrapped into the arena)
+    int chunkAt(glm::vec2 position) const;
+    // Shortest difference a - b on an axis of length `extent` (through the wrap)
+    static float wrapDelta(float a, float b, float extent) {
+        float d = a - b;
+        if (d > 0.5f * extent) d -= extent;
+        else if (d < -0.5f * extent) d += extent;
+        return d;
+    }
+    glm::vec2 wrapDelta(glm::vec2 a, glm::vec2 b) const { return glm::vec2(wrapDelta(a.x, b.x, width), wrapDelta(a.y, b.y, height)); }
+    size_t memoryBytes() const;
+
+    // Calls fn(chunk) for every chunk within `rings` chunks of the one at `position` (each once)
+    template <typename Fn>
+    void forEachChunkAround(glm::vec2 position, int rings, Fn&& fn) const {
+        const int center = chunkAt(position);
+        const int cx = center % config.chunksX, cy = center / config.chunksX;
+        for (int dy = -rings; dy <= rings; ++dy) {
+            const int y = (cy + dy + config.chunksY) % config.chunksY;
+            for (int dx = -rings; dx <= rings; ++dx) fn(chunkIndex((cx + dx + config.chunksX) % config.chunksX, y));
+        }
+    }
+};
+extern Arena arena; // The game's own, with --arena
+extern bool arenaMode;
+
+// ============================ ARENA API ============================
+// Sizes every chunk's block, fills the arena and puts the ship in the middle of it
+void initArena(Arena& target, const ArenaConfig& config, uint64_t seed, size_t maxBullets);
+void stepArena(Arena& target, float dt, const InputState& input);
+// --- The rock part of a step, for hosting regions apart (arenanode.h) ---
+// Counts a tick: the clock moves on and every chunk drops to the distant tier until marked again
+void advanceArenaClock(Arena& a, float dt);
+// Moves the rocks of the regions flagged in ownedRegions (nullptr: all of them), each region's job
+// migrating what stays in it, then the halo exchange between them. Rocks bound for a region not
+// flagged stay in their region's outbox for the caller to send on.
+void moveArenaRegions(Arena& a, const unsigned char* ownedRegions);
+// Places a migrant in its chunk, at the chunk's time
+void acceptArenaMigrant(Arena& a, const ArenaMigrant& migrant);
+// The camera's view (centred on the ship) in camera-relative [-1,1] units: the rocks of the chunks it
+// overlaps into `rocks` (cleared; as many as fit), the bullets into `bullets` (the same capacity as
+// the arena's), the ship at the centre into `ship`
+void captureArenaView(Arena& source, AsteroidStore& rocks, BulletStore& bullets, Ship& ship);
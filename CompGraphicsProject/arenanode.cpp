@@ -0,0 +1,376 @@
+#include "arenanode.h"
+#include "jobs.h"
+#include "log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+// ============================ MESSAGES ============================
+static ArenaNodeHeader makeNodeHeader(const ArenaNode& node, ArenaNodeMessageType type) {
+    ArenaNodeHeader header = {};
+    header.magic = ARENA_NODE_MAGIC;
+    header.version = ARENA_NODE_VERSION;
+    header.type = type;
+    header.from = static_cast<uint8_t>(node.id);
+    header.tick = node.arena.tick;
+    return header;
+}
+
+static void sendNodeDatagram(ArenaNode& node, int to, const ArenaNodeHeader& header, const ArenaWireRock* rocks, size_t count) {
+    ArenaNodeDatagram datagram;
+    datagram.to = to;
+    datagram.bytes.resize(sizeof(ArenaNodeHeader) + count * sizeof(ArenaWireRock));
+    ArenaNodeHeader sent = header;
+    sent.count = static_cast<uint32_t>(count);
+    std::memcpy(datagram.bytes.data(), &sent, sizeof(sent));
+    if (count > 0) std::memcpy(datagram.bytes.data() + sizeof(sent), rocks, count * sizeof(ArenaWireRock));
+    ++node.load.messagesOut;
+    node.load.bytesOut += datagram.bytes.size();
+    node.sent.push_back(std::move(datagram));
+}
+
+// As many datagrams as the rocks need (one, empty, for none)
+static void sendNodeRocks(ArenaNode& node, int to, const ArenaNodeHeader& header, const std::vector<ArenaWireRock>& rocks) {
+    size_t sent = 0;
+    do {
+        const size_t count = std::min(rocks.size() - sent, ARENA_NODE_ROCKS_PER_DATAGRAM);
+        sendNodeDatagram(node, to, header, rocks.data() + sent, count);
+        sent += count;
+    } while (sent < rocks.size());
+}
+
+// Rock i of a chunk, moved on by `lag` seconds (ghosts: to the sender's clock)
+static ArenaWireRock wireRock(const ArenaChunk& chunk, int index, size_t i, float lag) {
+    ArenaWireRock rock = {};
+    rock.chunk = index;
+    rock.x = chunk.x[i] + chunk.vx[i] * lag; rock.y = chunk.y[i] + chunk.vy[i] * lag;
+    rock.vx = chunk.vx[i]; rock.vy = chunk.vy[i];
+    rock.rot = chunk.rot[i] + chunk.rotSpeed[i] * lag; rock.rotSpeed = chunk.rotSpeed[i];
+    rock.px = lag == 0.0f ? chunk.px[i] : rock.x;
+    rock.py = lag == 0.0f ? chunk.py[i] : rock.y;
+    rock.prot = lag == 0.0f ? chunk.prot[i] : rock.rot;
+    rock.palette = chunk.paletteIndex[i];
+    rock.size = static_cast<uint8_t>(chunk.sizeClass[i]);
+    rock.shape = static_cast<uint16_t>(chunk.shapeIndex[i]);
+    return rock;
+}
+
+static ArenaWireRock wireRock(const ArenaMigrant& migrant) {
+    ArenaWireRock rock = {};
+    rock.chunk = migrant.chunk;
+    rock.x = migrant.rock.position.x; rock.y = migrant.rock.position.y;
+    rock.vx = migrant.rock.velocity.x; rock.vy = migrant.rock.velocity.y;
+    rock.rot = migrant.rock.rotation; rock.rotSpeed = migrant.rock.rotationSpeed;
+    rock.px = migrant.px; rock.py = migrant.py; rock.prot = migrant.prot;
+    rock.palette = migrant.rock.paletteIndex;
+    rock.size = static_cast<uint8_t>(migrant.rock.size);
+    rock.shape = static_cast<uint16_t>(migrant.rock.shapeIndex);
+    return rock;
+}
+
+static ArenaMigrant migrantOf(const ArenaWireRock& wire) {
+    ArenaMigrant migrant;
+    migrant.chunk = wire.chunk;
+    migrant.rock.position = glm::vec2(wire.x, wire.y);
+    migrant.rock.velocity = glm::vec2(wire.vx, wire.vy);
+    migrant.rock.rotation = wire.rot; migrant.rock.rotationSpeed = wire.rotSpeed;
+    migrant.rock.size = static_cast<AsteroidSize>(wire.size);
+    migrant.rock.paletteIndex = wire.palette;
+    migrant.rock.shapeIndex = wire.shape;
+    migrant.px = wire.px; migrant.py = wire.py; migrant.prot = wire.prot;
+    return migrant;
+}
+
+// Appends a rock to its chunk as it came (no set-back: ghosts and region rocks are at the chunk's time)
+static void placeWireRock(Arena& a, const ArenaWireRock& wire) {
+    const ArenaMigrant migrant = migrantOf(wire);
+    ArenaChunk& chunk = a.chunks[static_cast<size_t>(migrant.chunk)];
+    chunk.push(migrant.rock);
+    chunk.px.back() = migrant.px; chunk.py.back() = migrant.py; chunk.prot.back() = migrant.prot;
+}
+
+// ============================ NODES ============================
+static int regionOfChunk(const Arena& a, int chunk) { return chunk / a.config.chunksX / ARENA_REGION_ROWS; }
+
+static size_t clearArenaChunks(Arena& a, int firstRow, int endRow) {
+    size_t removed = 0;
+    for (int c = a.chunkIndex(0, firstRow); c < a.chunkIndex(0, endRow); ++c) {
+        ArenaChunk& chunk = a.chunks[static_cast<size_t>(c)];
+        removed += chunk.count();
+        while (chunk.count() > 0) chunk.remove(chunk.count() - 1);
+    }
+    return removed;
+}
+
+// The node's share of a tick: its regions' move, the handoffs for other nodes' regions and the ghost
+// rows along its borders, then (on report ticks) its load to the coordinator
+static void tickArenaNode(ArenaNode& node, float dt, bool report) {
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point start = Clock::now();
+    Arena& a = node.arena;
+    advanceArenaClock(a, dt);
+    moveArenaRegions(a, node.ownedRegions.data());
+
+    // --- Handoffs: per receiving node, every region's outbox in region order ---
+    const int nodeCount = static_cast<int>(node.reports.size());
+    std::vector<std::vector<ArenaWireRock>> handoffs(static_cast<size_t>(nodeCount));
+    for (size_t r = 0; r < a.regions.size(); ++r) {
+        if (!node.ownedRegions[r]) continue;
+        for (const ArenaMigrant& migrant : a.regions[r].outbox) {
+            const int owner = node.regionOwner[static_cast<size_t>(regionOfChunk(a, migrant.chunk))];
+            if (owner == node.id) continue; // Taken in by the move
+            handoffs[static_cast<size_t>(owner)].push_back(wireRock(migrant));
+            --a.rockCount;
+        }
+    }
+    for (int to = 0; to < nodeCount; ++to) {
+        const std::vector<ArenaWireRock>& rocks = handoffs[static_cast<size_t>(to)];
+        if (rocks.empty()) continue;
+        sendNodeRocks(node, to, makeNodeHeader(node, NODE_HANDOFF), rocks);
+        node.load.handoffsOut += rocks.size();
+    }
+
+    // --- Ghosts: a region's edge row, to the node across that edge ---
+    const size_t regionCount = a.regions.size();
+    std::vector<ArenaWireRock> ghosts;
+    for (size_t r = 0; r < regionCount; ++r) {
+        if (!node.ownedRegions[r]) continue;
+        const ArenaRegion& region = a.regions[r];
+        const size_t across[2] = { (r + regionCount - 1) % regionCount, (r + 1) % regionCount };
+        const int rows[2] = { region.firstRow, region.endRow - 1 };
+        for (int side = 0; side < 2; ++side) {
+            const int owner = node.regionOwner[across[side]];
+            if (owner == node.id) continue;
+            ghosts.clear();
+            for (int c = a.chunkIndex(0, rows[side]); c < a.chunkIndex(0, rows[side] + 1); ++c) {
+                const ArenaChunk& chunk = a.chunks[static_cast<size_t>(c)];
+                const float lag = static_cast<float>(a.clock - chunk.movedAt);
+                for (size_t i = 0; i < chunk.count(); ++i) ghosts.push_back(wireRock(chunk, c, i, lag));
+            }
+            ArenaNodeHeader header = makeNodeHeader(node, NODE_GHOSTS);
+            header.target = rows[side];
+            sendNodeRocks(node, owner, header, ghosts); // Even empty: it clears the row's old ghosts
+            node.load.ghostRocksOut += ghosts.size();
+        }
+    }
+
+    const int64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    node.load.windowNs += elapsed;
+    ++node.load.windowTicks;
+    node.load.tickNs += elapsed;
+    ++node.load.ticks;
+    if (report) {
+        node.load.meanTickNs = node.load.windowNs / static_cast<int64_t>(node.load.windowTicks);
+        node.load.windowNs = 0;
+        node.load.windowTicks = 0;
+        node.load.rocks = a.rockCount;
+        node.load.regions = static_cast<size_t>(std::count(node.ownedRegions.begin(), node.ownedRegions.end(), 1));
+        ArenaNodeHeader header = makeNodeHeader(node, NODE_LOAD);
+        header.meanTickNs = node.load.meanTickNs;
+        header.rocks = static_cast<uint32_t>(node.load.rocks);
+        header.regions = static_cast<uint32_t>(node.load.regions);
+        sendNodeDatagram(node, 0, header, nullptr, 0);
+    }
+}
+
+// Applies the node's inbox in arrival order. Malformed datagrams are dropped.
+static void receiveArenaNode(ArenaNode& node) {
+    Arena& a = node.arena;
+    for (const std::vector<unsigned char>& bytes : node.inbox) {
+        ArenaNodeHeader header;
+        if (bytes.size() < sizeof(header)) continue;
+        std::memcpy(&header, bytes.data(), sizeof(header));
+        if (header.magic != ARENA_NODE_MAGIC || header.version != ARENA_NODE_VERSION) continue;
+        if (bytes.size() != sizeof(header) + header.count * sizeof(ArenaWireRock)) continue;
+        std::vector<ArenaWireRock> rocks(header.count);
+        if (header.count > 0) std::memcpy(rocks.data(), bytes.data() + sizeof(header), header.count * sizeof(ArenaWireRock));
+        if (std::any_of(rocks.begin(), rocks.end(), [&a](const ArenaWireRock& rock) { return rock.chunk < 0 || static_cast<size_t>(rock.chunk) >= a.chunks.size(); })) continue;
+
+        switch (header.type) {
+        case NODE_HANDOFF: // Migrants, as a neighbouring region in the same arena would hand them over
+            for (const ArenaWireRock& rock : rocks) acceptArenaMigrant(a, migrantOf(rock));
+            a.rockCount += rocks.size();
+            node.load.handoffsIn += rocks.size();
+            break;
+        case NODE_GHOSTS: {
+            const int row = header.target;
+            if (row < 0 || row >= a.config.chunksY || node.ownedRegions[static_cast<size_t>(row / ARENA_REGION_ROWS)]) break;
+            if (node.ghostRowTick[static_cast<size_t>(row)] != a.tick) { // The row's first datagram this tick
+                clearArenaChunks(a, row, row + 1);
+                for (int c = a.chunkIndex(0, row); c < a.chunkIndex(0, row + 1); ++c) a.chunks[static_cast<size_t>(c)].movedAt = a.clock;
+                node.ghostRowTick[static_cast<size_t>(row)] = a.tick;
+            }
+            for (const ArenaWireRock& rock : rocks) placeWireRock(a, rock);
+            break;
+        }
+        case NODE_LOAD:
+            if (node.id == 0 && header.from < node.reports.size()) {
+                ArenaNodeLoad& load = node.reports[header.from];
+                load.meanTickNs = header.meanTickNs;
+                load.rocks = header.rocks;
+                load.regions = header.regions;
+            }
+            break;
+        case NODE_OWNERSHIP: { // The old owner sends the region's chunks; the new one empties them for those
+            if (header.target < 0 || static_cast<size_t>(header.target) >= a.regions.size()) break;
+            const size_t r = static_cast<size_t>(header.target);
+            const ArenaRegion& region = a.regions[r];
+            node.regionOwner[r] = header.owner;
+            if (node.ownedRegions[r] && header.owner != node.id) {
+                std::vector<ArenaWireRock> chunkRocks;
+                for (int c = a.chunkIndex(0, region.firstRow); c < a.chunkIndex(0, region.endRow); ++c) {
+                    const ArenaChunk& chunk = a.chunks[static_cast<size_t>(c)];
+                    chunkRocks.clear();
+                    for (size_t i = 0; i < chunk.count(); ++i) chunkRocks.push_back(wireRock(chunk, c, i, 0.0f));
+                    ArenaNodeHeader out = makeNodeHeader(node, NODE_REGION);
+                    out.target = c;
+                    out.movedAt = chunk.movedAt;
+                    sendNodeRocks(node, header.owner, out, chunkRocks);
+                }
+                a.rockCount -= clearArenaChunks(a, region.firstRow, region.endRow);
+                node.ownedRegions[r] = 0;
+            }
+            else if (!node.ownedRegions[r] && header.owner == node.id) {
+                clearArenaChunks(a, region.firstRow, region.endRow); // Ghosts
+                node.ownedRegions[r] = 1;
+            }
+            break;
+        }
+        case NODE_REGION: {
+            if (header.target < 0 || static_cast<size_t>(header.target) >= a.chunks.size()) break;
+            a.chunks[static_cast<size_t>(header.target)].movedAt = header.movedAt;
+            for (const ArenaWireRock& rock : rocks) placeWireRock(a, rock);
+            a.rockCount += rocks.size();
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    node.inbox.clear();
+
+    // Ghost rows no longer across a border (their region or its neighbour changed hands) go
+    for (int row = 0; row < a.config.chunksY; ++row) {
+        uint64_t& replaced = node.ghostRowTick[static_cast<size_t>(row)];
+        if (replaced == 0 || replaced == a.tick) continue;
+        if (!node.ownedRegions[static_cast<size_t>(row / ARENA_REGION_ROWS)]) clearArenaChunks(a, row, row + 1);
+        replaced = 0;
+    }
+}
+
+// Moves every datagram to its node's inbox, senders in node order (so a node's inbox does not depend
+// on which job ran first)
+static void deliverArenaDatagrams(ArenaCluster& cluster) {
+    for (std::unique_ptr<ArenaNode>& sender : cluster.nodes) {
+        for (ArenaNodeDatagram& datagram : sender->sent) cluster.nodes[static_cast<size_t>(datagram.to)]->inbox.push_back(std::move(datagram.bytes));
+        sender->sent.clear();
+    }
+}
+
+static void runArenaNodes(ArenaCluster& cluster, float dt, bool report) {
+    parallelFor(0, cluster.nodes.size(), 1, [&cluster, dt, report](size_t begin, size_t end) {
+        for (size_t n = begin; n < end; ++n) tickArenaNode(*cluster.nodes[n], dt, report);
+    });
+    deliverArenaDatagrams(cluster);
+}
+
+static void receiveArenaNodes(ArenaCluster& cluster) {
+    parallelFor(0, cluster.nodes.size(), 1, [&cluster](size_t begin, size_t end) {
+        for (size_t n = begin; n < end; ++n) receiveArenaNode(*cluster.nodes[n]);
+    });
+}
+
+// The coordinator's decision, from the last reports: one region from the busiest node to the idlest,
+// if the busiest costs ARENA_REBALANCE_MARGIN more and has a region to spare. It prefers a region next
+// to one the idlest already owns (its handoffs and ghosts then stay between the two), else one on the
+// busiest node's own border. Returns false if nothing moves.
+static bool rebalanceArenaCluster(ArenaNode& coordinator) {
+    const std::vector<ArenaNodeLoad>& reports = coordinator.reports;
+    size_t busiest = 0, idlest = 0;
+    for (size_t n = 1; n < reports.size(); ++n) {
+        if (reports[n].meanTickNs > reports[busiest].meanTickNs) busiest = n;
+        if (reports[n].meanTickNs < reports[idlest].meanTickNs) idlest = n;
+    }
+    if (busiest == idlest || reports[busiest].regions < 2) return false;
+    if (static_cast<double>(reports[busiest].meanTickNs) < (1.0 + ARENA_REBALANCE_MARGIN) * static_cast<double>(reports[idlest].meanTickNs)) return false;
+
+    const std::vector<int>& owner = coordinator.regionOwner;
+    const size_t count = owner.size();
+    int chosen = -1, fallback = -1;
+    for (size_t r = 0; r < count && chosen < 0; ++r) {
+        if (owner[r] != static_cast<int>(busiest)) continue;
+        const int before = owner[(r + count - 1) % count], after = owner[(r + 1) % count];
+        if (before == static_cast<int>(idlest) || after == static_cast<int>(idlest)) chosen = static_cast<int>(r);
+        else if (fallback < 0 && (before != static_cast<int>(busiest) || after != static_cast<int>(busiest))) fallback = static_cast<int>(r);
+    }
+    if (chosen < 0) chosen = fallback;
+    if (chosen < 0) return false;
+
+    ArenaNodeHeader header = makeNodeHeader(coordinator, NODE_OWNERSHIP);
+    header.target = chosen;
+    header.owner = static_cast<int32_t>(idlest);
+    for (size_t n = 0; n < reports.size(); ++n) sendNodeDatagram(coordinator, static_cast<int>(n), header, nullptr, 0);
+    return true;
+}
+
+// ============================ CLUSTER API ============================
+void initArenaCluster(ArenaCluster& cluster, const ArenaConfig& config, uint64_t seed, int nodeCount, const std::vector<int>& owners) {
+    nodeCount = std::clamp(nodeCount, 1, ARENA_MAX_NODES);
+    cluster.nodes.clear();
+    cluster.tick = 0;
+    cluster.regionMoves = 0;
+    for (int n = 0; n < nodeCount; ++n) {
+        std::unique_ptr<ArenaNode> node = std::make_unique<ArenaNode>();
+        node->id = n;
+        initArena(node->arena, config, seed, 0);
+        Arena& a = node->arena;
+        const size_t regionCount = a.regions.size();
+        node->regionOwner.resize(regionCount);
+        for (size_t r = 0; r < regionCount; ++r) {
+            const int given = r < owners.size() ? owners[r] : -1;
+            node->regionOwner[r] = given >= 0 && given < nodeCount ? given : static_cast<int>(r * static_cast<size_t>(nodeCount) / regionCount);
+        }
+        node->ownedRegions.assign(regionCount, 0);
+        for (size_t r = 0; r < regionCount; ++r) {
+            if (node->regionOwner[r] == n) node->ownedRegions[r] = 1;
+            else a.rockCount -= clearArenaChunks(a, a.regions[r].firstRow, a.regions[r].endRow);
+        }
+        node->ghostRowTick.assign(static_cast<size_t>(a.config.chunksY), 0);
+        node->reports.assign(static_cast<size_t>(nodeCount), ArenaNodeLoad());
+        cluster.nodes.push_back(std::move(node));
+    }
+}
+
+void stepArenaCluster(ArenaCluster& cluster, float dt) {
+    ++cluster.tick;
+    const bool report = cluster.tick % ARENA_REBALANCE_TICKS == 0;
+    runArenaNodes(cluster, dt, report);
+    receiveArenaNodes(cluster);
+    if (!report) return;
+
+    if (!rebalanceArenaCluster(*cluster.nodes.front())) return;
+    ++cluster.regionMoves;
+    deliverArenaDatagrams(cluster); // Ownership
+    receiveArenaNodes(cluster);
+    deliverArenaDatagrams(cluster); // The region's rocks
+    receiveArenaNodes(cluster);
+}
+
+size_t arenaClusterRocks(const ArenaCluster& cluster) {
+    size_t rocks = 0;
+    for (const std::unique_ptr<ArenaNode>& node : cluster.nodes) rocks += node->arena.rockCount;
+    return rocks;
+}
+
+void logArenaClusterReport(const ArenaCluster& cluster) {
+    for (const std::unique_ptr<ArenaNode>& node : cluster.nodes) {
+        const ArenaNodeLoad& load = node->load;
+        const size_t regions = static_cast<size_t>(std::count(node->ownedRegions.begin(), node->ownedRegions.end(), 1));
+        LOG_INFO("Arena node %d: %zu regions, %zu rocks, %.1f us/tick, %llu handoffs out, %llu in, %llu ghost rocks, %llu datagrams, %llu bytes",
+                 node->id, regions, node->arena.rockCount, load.ticks > 0 ? static_cast<double>(load.tickNs) / load.ticks / 1000.0 : 0.0,
+                 static_cast<unsigned long long>(load.handoffsOut), static_cast<unsigned long long>(load.handoffsIn),
+                 static_cast<unsigned long long>(load.ghostRocksOut), static_cast<unsigned long long>(load.messagesOut),
+                 static_cast<unsigned long long>(load.bytesOut));
+    }
+}
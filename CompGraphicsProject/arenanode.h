@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "arena.h"
+
+// Distributed arena: the arena's regions (arena.h: bands of chunk rows) hosted by several server
+// nodes, for a shared world too big for one machine. Every node keeps the whole chunk grid, but only
+// the regions it owns are live; it moves them each tick exactly as one arena would (moveArenaRegions)
+// and talks to the others in datagrams:
+// - handoff: the rocks that left one of its regions for a region another node owns;
+// - ghosts: the border row of each of its regions next to another node's, every tick, so that node
+//   sees (and could collide with) what lies just across its edge. A ghost row is read only: it is
+//   overwritten by the next one and never moved;
+// - load: every node's tick cost, rocks and regions, to the coordinator (node 0) each rebalance;
+// - ownership and region: the coordinator moves a region from the busiest node to the idlest when
+//   their costs are far enough apart; the old owner sends the region's rocks to the new one.
+// Nodes tick in lockstep: move, send, deliver, receive. Handoffs carry every field and are applied
+// with the same set-back as a local migration, so a cluster moves its rocks bit for bit as a single
+// arena does (benchmark --arena-nodes checks it). Ships and gameplay stay with the single arena;
+// the cluster hosts the rock field.
+// ArenaCluster runs the nodes in one process (a job per node and phase) and routes their datagrams
+// itself; the messages are already the wire format, so nodes on separate hosts differ only in how
+// a datagram gets to its node.
+// Like simulation.h, nothing here depends on GL.
+
+// ============================ PROTOCOL ============================
+// Little-endian structs: a header, then `count` rocks. A message that would not fit a datagram is
+// split into several.
+const uint32_t ARENA_NODE_MAGIC = 0x444F4E41; // "ANOD"
+const uint32_t ARENA_NODE_VERSION = 3; // 2: palette entries instead of colors; 3: no rock scale and radius (from the size)
+const size_t ARENA_NODE_MAX_DATAGRAM = 65507; // UDP over IPv4, as the match server's
+
+enum ArenaNodeMessageType : uint8_t { NODE_HANDOFF = 1, NODE_GHOSTS = 2, NODE_LOAD = 3, NODE_OWNERSHIP = 4, NODE_REGION = 5 };
+
+struct ArenaNodeHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint8_t type; // ArenaNodeMessageType
+    uint8_t from; // Sending node
+    uint8_t reserved[2];
+    uint32_t count; // Rocks following (handoff, ghosts, region)
+    uint64_t tick; // The sender's tick
+    int32_t target; // Ghosts: the chunk row; ownership: the region; region: the chunk
+    int32_t owner; // Ownership: the region's new node
+    double movedAt; // Region: the chunk's time (the rocks are as it last moved them)
+    // Load
+    int64_t meanTickNs;
+    uint32_t rocks, regions;
+};
+
+// One rock on the wire: handoffs and regions as the sender holds it, ghosts at the sender's clock
+struct ArenaWireRock {
+    int32_t chunk;
+    float x, y, vx, vy, rot, rotSpeed;
+    float px, py, prot;
+    uint8_t size; // AsteroidSize (scale and radius follow from it)
+    uint8_t palette; // asteroidPalette entry
+    uint16_t shape;
+};
+
+const size_t ARENA_NODE_ROCKS_PER_DATAGRAM = (ARENA_NODE_MAX_DATAGRAM - sizeof(ArenaNodeHeader)) / sizeof(ArenaWireRock);
+
+// ============================ NODES ============================
+const int ARENA_MAX_NODES = 255; // The header's sender byte
+const int ARENA_REBALANCE_TICKS = 240; // Two seconds between load reports (and possible moves)
+const float ARENA_REBALANCE_MARGIN = 0.25f; // The busiest node must cost this much more than the idlest for a region to move
+
+struct ArenaNodeLoad {
+    int64_t windowNs = 0; // Its moves and sends since the last report
+    uint64_t windowTicks = 0;
+    int64_t meanTickNs = 0; // As last reported (the coordinator's copies hold only these three)
+    size_t rocks = 0, regions = 0;
+    // So far
+    int64_t tickNs = 0;
+    uint64_t ticks = 0;
+    uint64_t handoffsOut = 0, handoffsIn = 0, ghostRocksOut = 0;
+    uint64_t messagesOut = 0, bytesOut = 0;
+};
+
+struct ArenaNodeDatagram {
+    int to;
+    std::vector<unsigned char> bytes;
+};
+
+struct ArenaNode {
+    int id = 0;
+    Arena arena; // Its regions live, the border rows of the neighbours' as ghosts, the rest empty
+    std::vector<unsigned char> ownedRegions;
+    std::vector<int> regionOwner; // Its view of the map (the coordinator's, as last announced)
+    std::vector<ArenaNodeDatagram> sent; // This phase's, until the cluster delivers them
+    std::vector<std::vector<unsigned char>> inbox;
+    std::vector<uint64_t> ghostRowTick; // Per chunk row: the tick its ghosts were last replaced on
+    std::vector<ArenaNodeLoad> reports; // The last load of every node (the coordinator's)
+    ArenaNodeLoad load;
+};
+
+struct ArenaCluster {
+    std::vector<std::unique_ptr<ArenaNode>> nodes;
+    uint64_t tick = 0;
+    uint64_t regionMoves = 0; // Ownership changes so far
+};
+
+// ============================ CLUSTER API ============================
+// Every node builds the same arena from the seed and keeps its own regions of it. `owners` gives each
+// region's node; empty: contiguous, even blocks of regions.
+void initArenaCluster(ArenaCluster& cluster, const ArenaConfig& config, uint64_t seed, int nodeCount, const std::vector<int>& owners);
+// One lockstep tick of every node; every ARENA_REBALANCE_TICKS, the load reports and possibly one move
+void stepArenaCluster(ArenaCluster& cluster, float dt);
+size_t arenaClusterRocks(const ArenaCluster& cluster); // Live rocks over every node
+// Per node: regions, rocks, tick cost and traffic so far
+void logArenaClusterReport(const ArenaCluster& cluster);
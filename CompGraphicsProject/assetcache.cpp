@@ -0,0 +1,164 @@
+#include "assetcache.h"
+#include "log.h"
+#include "mappedfile.h"
+#include "shaders.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+const char* ASSET_CACHE_PATH = "shader_cache/assets.bin";
+
+static const uint32_t ASSET_CACHE_MAGIC = 0x31484341; // "ACH1"
+static const size_t ASSET_SECTION_ALIGNMENT = 16;
+
+struct AssetFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t sectionCount;
+    uint32_t reserved;
+};
+
+struct AssetDirectoryEntry {
+    uint32_t id;
+    uint32_t reserved;
+    uint64_t key;
+    uint64_t offset;
+    uint64_t bytes;
+    uint64_t checksum;
+};
+
+// A section as it stands for the next save: the mapped one that passed, or a new bake
+struct AssetEntry {
+    bool present = false;
+    bool stored = false; // Replaced this launch: the file needs writing
+    bool checked = false; // The mapped bytes' checksum was checked (present still says whether it held)
+    uint64_t key = 0;
+    uint64_t checksum = 0; // The directory's, for the mapped bytes
+    const unsigned char* mapped = nullptr;
+    std::vector<unsigned char> bytes; // When stored
+    size_t mappedBytes = 0;
+};
+
+static MappedFile assetFile;
+static AssetEntry assetEntries[ASSET_SECTION_COUNT];
+
+uint64_t assetHash(uint64_t hash, const void* data, size_t bytes) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < bytes; ++i) {
+        hash ^= p[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// ============================ READ ============================
+void openAssetCache() {
+    if (!assetFile.open(ASSET_CACHE_PATH)) return;
+    AssetFileHeader header;
+    if (assetFile.size < sizeof(header)) return assetFile.close();
+    std::memcpy(&header, assetFile.data, sizeof(header));
+    const size_t directoryEnd = sizeof(header) + static_cast<size_t>(header.sectionCount) * sizeof(AssetDirectoryEntry);
+    if (header.magic != ASSET_CACHE_MAGIC || header.version != ASSET_CACHE_VERSION || directoryEnd > assetFile.size) {
+        LOG_INFO("Asset cache %s is from another version; baking everything", ASSET_CACHE_PATH);
+        return assetFile.close();
+    }
+
+    // A section's checksum is checked on its first lookup (intact), on whichever thread makes it, so
+    // the reads of a section that loads on a worker are the worker's; a torn or stale write only costs
+    // the sections it hit
+    int usable = 0;
+    for (uint32_t i = 0; i < header.sectionCount; ++i) {
+        AssetDirectoryEntry entry;
+        std::memcpy(&entry, assetFile.data + sizeof(header) + i * sizeof(entry), sizeof(entry));
+        if (entry.id >= ASSET_SECTION_COUNT || entry.offset > assetFile.size || entry.bytes > assetFile.size - entry.offset) continue;
+        AssetEntry& target = assetEntries[entry.id];
+        target.present = true;
+        target.key = entry.key;
+        target.checksum = entry.checksum;
+        target.mapped = assetFile.data + entry.offset;
+        target.mappedBytes = static_cast<size_t>(entry.bytes);
+        ++usable;
+    }
+    LOG_INFO("Asset cache: %d of %u sections mapped (%zu bytes)", usable, header.sectionCount, assetFile.size);
+}
+
+// Checks a mapped section's checksum the first time; one that fails is dropped, as if never written
+static bool intact(AssetEntry& entry) {
+    if (!entry.checked && entry.present && !entry.stored) {
+        entry.checked = true;
+        entry.present = assetHash(ASSET_HASH_START, entry.mapped, entry.mappedBytes) == entry.checksum;
+        if (!entry.present) LOG_INFO("Asset cache: a section failed its checksum; baking it again");
+    }
+    return entry.present;
+}
+
+const void* findAsset(AssetSection section, uint64_t key, size_t& bytes) {
+    AssetEntry& entry = assetEntries[section];
+    if (entry.stored || entry.key != key || !intact(entry)) return nullptr;
+    bytes = entry.mappedBytes;
+    return entry.mapped;
+}
+
+// ============================ WRITE ============================
+void storeAsset(AssetSection section, uint64_t key, const void* data, size_t bytes) {
+    AssetEntry& entry = assetEntries[section];
+    entry.present = true;
+    entry.stored = true;
+    entry.key = key;
+    entry.mapped = nullptr;
+    entry.mappedBytes = 0;
+    entry.bytes.assign(static_cast<const unsigned char*>(data), static_cast<const unsigned char*>(data) + bytes);
+}
+
+void saveAssetCache() {
+    bool changed = false;
+    for (const AssetEntry& entry : assetEntries) changed = changed || entry.stored;
+    if (!changed) {
+        assetFile.close();
+        for (AssetEntry& entry : assetEntries) entry = AssetEntry();
+        return;
+    }
+    uint32_t sectionCount = 0;
+    for (AssetEntry& entry : assetEntries) {
+        if (intact(entry)) ++sectionCount; // One never looked up is only written back if it still holds
+    }
+
+    // Laid out in memory first: the sections still good come from the mapping, which has to be gone
+    // before the file is replaced (Windows will not replace a mapped file)
+    const AssetFileHeader header = { ASSET_CACHE_MAGIC, ASSET_CACHE_VERSION, sectionCount, 0 };
+    std::vector<unsigned char> file(sizeof(header) + sectionCount * sizeof(AssetDirectoryEntry));
+    std::memcpy(file.data(), &header, sizeof(header));
+    size_t directory = sizeof(header);
+    for (uint32_t id = 0; id < ASSET_SECTION_COUNT; ++id) {
+        const AssetEntry& entry = assetEntries[id];
+        if (!entry.present) continue;
+        const unsigned char* data = entry.stored ? entry.bytes.data() : entry.mapped;
+        const size_t bytes = entry.stored ? entry.bytes.size() : entry.mappedBytes;
+        file.resize((file.size() + ASSET_SECTION_ALIGNMENT - 1) / ASSET_SECTION_ALIGNMENT * ASSET_SECTION_ALIGNMENT);
+        const AssetDirectoryEntry record = { id, 0, entry.key, file.size(), bytes, assetHash(ASSET_HASH_START, data, bytes) };
+        std::memcpy(file.data() + directory, &record, sizeof(record));
+        directory += sizeof(record);
+        file.insert(file.end(), data, data + bytes);
+    }
+    assetFile.close();
+    for (AssetEntry& entry : assetEntries) entry = AssetEntry();
+
+    // Written beside the old file and renamed over it, so a crash mid-write leaves the old one
+    std::error_code error;
+    std::filesystem::create_directories(SHADER_CACHE_DIR, error);
+    const std::string temporary = std::string(ASSET_CACHE_PATH) + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(file.data()), static_cast<std::streamsize>(file.size()));
+        if (!out) {
+            LOG_WARN("Could not write the asset cache to %s", temporary.c_str());
+            return;
+        }
+    }
+    std::filesystem::rename(temporary, ASSET_CACHE_PATH, error);
+    if (error) LOG_WARN("Could not replace %s: %s", ASSET_CACHE_PATH, error.message().c_str());
+    else LOG_INFO("Asset cache: wrote %u sections (%zu bytes)", sectionCount, file.size());
+}
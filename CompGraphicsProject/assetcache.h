@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ============================ ASSET CACHE ============================
+// What startup bakes on the CPU (the asteroid shape atlas and its SDF, the nebula noise, the HUD font)
+// and the quality benchmark's verdict, kept from one launch to the next in ASSET_CACHE_PATH next to the
+// shader binaries. The file is memory-mapped, and a section that is still good is handed to GL straight
+// from the mapping instead of being baked again.
+// Every section is stored under a key: a hash of whatever its bake depends on (the shape generator's
+// RNG state, the texture sizes, the renderer string). A section whose key differs, whose checksum does
+// not hold, or from a file of another ASSET_CACHE_VERSION is baked again as if there were no cache,
+// and the file is rewritten once the asset loads are done. Bump ASSET_CACHE_VERSION when a bake's code changes
+// without its inputs changing.
+// File layout (native endianness; the file never leaves the machine):
+//   header: magic, version, section count, 0
+//   directory: per section { id, 0, key, offset, bytes, checksum }
+//   the sections, each at a 16-byte aligned offset
+extern const char* ASSET_CACHE_PATH;
+const uint32_t ASSET_CACHE_VERSION = 1;
+
+enum AssetSection {
+    ASSET_SHAPE_ATLAS, // Asteroid atlas vertices (float x, y)
+    ASSET_SHAPE_TABLE, // asteroidShapes, then the shape RNG's state as the bake left it
+    ASSET_SHAPE_SDF, // Asteroid SDF distances (float)
+    ASSET_NOISE, // Baked nebula noise (R8 texels)
+    ASSET_FONT, // HUD font atlas (R8 texels)
+    ASSET_QUALITY, // The benchmarked QualityLevel (int32)
+    ASSET_SECTION_COUNT
+};
+
+// FNV-1a, 64-bit, over `bytes` bytes, continuing from `hash`
+const uint64_t ASSET_HASH_START = 14695981039346656037ull;
+uint64_t assetHash(uint64_t hash, const void* data, size_t bytes);
+template <typename T>
+uint64_t assetHash(uint64_t hash, const T& value) { return assetHash(hash, &value, sizeof(value)); }
+
+// Maps ASSET_CACHE_PATH (nothing if it is missing or from another version). Call once, before
+// anything looks a section up; the bakes and asset loads may look up from worker threads after that,
+// one thread per section (its checksum is checked on its first lookup, by that thread).
+void openAssetCache();
+// The section's bytes in the mapping if it was stored under `key` and is intact, else nullptr. Valid
+// until saveAssetCache.
+const void* findAsset(AssetSection section, uint64_t key, size_t& bytes);
+// Replaces the section (copied) for the file saveAssetCache writes. One thread at a time (startup, then
+// the asset loads' uploads on the thread that records frames).
+void storeAsset(AssetSection section, uint64_t key, const void* data, size_t bytes);
+// Writes the file again if anything was stored, then unmaps it either way. Call once the asset loads
+// are done (they read from the mapping).
+void saveAssetCache();
@@ -0,0 +1,95 @@
+#include "assetloader.h"
+#include "alloctrack.h"
+#include "jobs.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <mutex>
+#include <vector>
+
+// ============================ LOADER STATE ============================
+struct QueuedUpload {
+    std::coroutine_handle<> load;
+    size_t bytes;
+};
+
+static std::vector<AssetLoad> loads; // Started and not yet reaped; the thread that records frames only
+static std::mutex uploadMutex;
+static std::vector<QueuedUpload> uploads; // Waiting for a frame's budget, oldest first (uploadMutex)
+static JobCounter workerLoads; // Loads on (or queued for) a worker
+
+// ============================ AWAITABLES ============================
+bool AssetWorkerHop::await_ready() const noexcept {
+    return jobWorkerCount() == 0; // Nobody to hand it to: carry on inline
+}
+
+// Resumes the load on a worker (the job's one index); loading allocates by nature, so it may
+static void resumeOnWorker(void* context, size_t, size_t) {
+    AllowAllocations allow;
+    std::coroutine_handle<>::from_address(context).resume();
+}
+
+void AssetWorkerHop::await_suspend(std::coroutine_handle<> waiting) {
+    Job job;
+    job.function = resumeOnWorker;
+    job.context = waiting.address();
+    job.begin = 0;
+    job.end = 1;
+    job.counter = &workerLoads;
+    workerLoads.pending.fetch_add(1, std::memory_order_relaxed);
+    submitJob(job);
+}
+
+void AssetUploadSlot::await_suspend(std::coroutine_handle<> waiting) {
+    std::lock_guard<std::mutex> lock(uploadMutex);
+    uploads.push_back({ waiting, bytes });
+}
+
+// ============================ ASSET LOADER API ============================
+void startAssetLoad(AssetLoad load) {
+    AllowAllocations allow;
+    loads.push_back(std::move(load));
+    loads.back().handle.resume();
+}
+
+bool pumpAssetUploads(size_t budget) {
+    if (loads.empty()) return true;
+    AllowAllocations allow; // Uploads size GL objects and free what was baked
+    QueuedUpload ready[8];
+    size_t count = 0;
+    {
+        // The oldest that fit in the budget (the first always does); the rest wait for the next frame
+        std::lock_guard<std::mutex> lock(uploadMutex);
+        while (count < uploads.size() && count < std::size(ready) && (count == 0 || uploads[count].bytes <= budget)) {
+            budget -= std::min(budget, uploads[count].bytes);
+            ready[count] = uploads[count];
+            ++count;
+        }
+        uploads.erase(uploads.begin(), uploads.begin() + static_cast<std::ptrdiff_t>(count));
+    }
+    for (size_t i = 0; i < count; ++i) ready[i].load.resume();
+
+    std::erase_if(loads, [](const AssetLoad& load) { return load.handle.done(); });
+    return loads.empty();
+}
+
+bool assetLoadsPending() {
+    return !loads.empty();
+}
+
+void finishAssetLoads() {
+    while (!loads.empty()) {
+        waitForJobs(workerLoads);
+        pumpAssetUploads(SIZE_MAX);
+    }
+}
+
+void cancelAssetLoads() {
+    waitForJobs(workerLoads); // Every load is then queued for an upload or done
+    {
+        std::lock_guard<std::mutex> lock(uploadMutex);
+        uploads.clear();
+    }
+    loads.clear(); // Destroys the frames, and what they held with them
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <utility>
+
+// ============================ ASSET LOADER ============================
+// Assets the first frame can do without are loaded after the window shows, as C++20 coroutines that
+// read like the load they are:
+//     co_await onAssetWorker();       // Find or bake the bytes (the asset cache's mapping, a file)
+//     co_await assetUpload(bytes);    // Wait for room in a frame's upload budget
+//     ... the GL calls ...            // On the thread that records frames
+// onAssetWorker moves the coroutine onto a job system worker, where it reads from memory-mapped files
+// and bakes without holding up the frame. assetUpload parks it in the upload queue, which the frame
+// drains once per frame (pumpAssetUploads) up to ASSET_UPLOAD_FRAME_BYTES, oldest first; a load
+// bigger than the budget goes up alone in a frame of its own. Until its upload has run, whatever the
+// asset feeds keeps its fallback (the analytic nebula, the rocks' fans), so a load is never waited on.
+// With no job workers the worker part runs inline, at startAssetLoad. A load ends on the thread that
+// records frames, after an upload (that is where it is reaped).
+const size_t ASSET_UPLOAD_FRAME_BYTES = 256 * 1024; // Texture bytes handed to GL per frame at most
+
+// A load (move only); startAssetLoad takes it over
+struct AssetLoad {
+    struct promise_type {
+        AssetLoad get_return_object() { return AssetLoad(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; } // Runs from startAssetLoad
+        std::suspend_always final_suspend() noexcept { return {}; } // Reaped by the frame
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    explicit AssetLoad(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+    AssetLoad(AssetLoad&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    AssetLoad& operator=(AssetLoad&& other) noexcept {
+        if (this != &other) {
+            if (handle) handle.destroy();
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+    ~AssetLoad() { if (handle) handle.destroy(); }
+
+    std::coroutine_handle<promise_type> handle = nullptr;
+};
+
+// ============================ AWAITABLES ============================
+struct AssetWorkerHop {
+    bool await_ready() const noexcept;
+    void await_suspend(std::coroutine_handle<> waiting);
+    void await_resume() const noexcept {}
+};
+
+struct AssetUploadSlot {
+    size_t bytes;
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> waiting);
+    void await_resume() const noexcept {}
+};
+
+inline AssetWorkerHop onAssetWorker() { return {}; }
+inline AssetUploadSlot assetUpload(size_t bytes) { return { bytes }; }
+
+// ============================ ASSET LOADER API ============================
+// Starts the load (it runs to its first co_await at once). The thread that records frames only, like the rest.
+void startAssetLoad(AssetLoad load);
+// Resumes the queued uploads that fit this frame's budget and reaps the finished loads. True once
+// none is left (and stays so until the next start).
+bool pumpAssetUploads(size_t budget = ASSET_UPLOAD_FRAME_BYTES);
+bool assetLoadsPending();
+// Runs every load to its end now, waiting for the workers and ignoring the budget (for the measured
+// runs, which start with every asset in place)
+void finishAssetLoads();
+// At exit: waits for the loads on workers to reach the queue, then drops every load still unfinished
+// (their uploads never run)
+void cancelAssetLoads();
@@ -0,0 +1,349 @@
+#include "audio.h"
+#include "simulation.h"
+#include "memreport.h"
+#include "random.h"
+#include "trace.h"
+#include "log.h"
+#include "threadconfig.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#include <glm/gtc/constants.hpp>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <mmsystem.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+bool useAudio = true;
+
+static_assert((AUDIO_QUEUE_CAPACITY & (AUDIO_QUEUE_CAPACITY - 1)) == 0, "The command ring is indexed by masking");
+
+// ============================ COMMAND QUEUE ============================
+// Single producer (the thread stepping the game), single consumer (the audio thread). Each side owns
+// one index and only reads the other's: the producer publishes a command by storing the head after
+// writing the slot, the consumer frees it by storing the tail after reading it.
+enum AudioCommandType : uint8_t { AUDIO_PLAY, AUDIO_LOOP_START, AUDIO_LOOP_STOP };
+
+struct AudioCommand {
+    AudioCommandType type;
+    Sound sound;
+    float gain;
+    float pan;
+};
+
+static AudioCommand commands[AUDIO_QUEUE_CAPACITY];
+alignas(64) static std::atomic<size_t> commandHead(0); // Written by the producer
+alignas(64) static std::atomic<size_t> commandTail(0); // Written by the audio thread
+static std::atomic<unsigned int> droppedCommands(0);
+
+static void pushCommand(const AudioCommand& command) {
+    const size_t head = commandHead.load(std::memory_order_relaxed);
+    if (head - commandTail.load(std::memory_order_acquire) == AUDIO_QUEUE_CAPACITY) {
+        droppedCommands.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    commands[head & (AUDIO_QUEUE_CAPACITY - 1)] = command;
+    commandHead.store(head + 1, std::memory_order_release);
+}
+
+// ============================ SOUNDS ============================
+// Mono PCM at AUDIO_SAMPLE_RATE, made once by startAudio
+static std::vector<float> soundSamples[SOUND_COUNT];
+
+// Scales the sound so its loudest sample is `peak`
+static void normalize(std::vector<float>& samples, float peak) {
+    float loudest = 0.0f;
+    for (float s : samples) loudest = std::max(loudest, std::fabs(s));
+    if (loudest > 0.0f) for (float& s : samples) s *= peak / loudest;
+}
+
+// A square wave sweeping down from `from` to `to` Hz, decaying fast
+static std::vector<float> synthesizeSweep(float seconds, float from, float to, float decay) {
+    std::vector<float> samples(static_cast<size_t>(seconds * AUDIO_SAMPLE_RATE));
+    float phase = 0.0f;
+    for (size_t i = 0; i < samples.size(); ++i) {
+        const float t = static_cast<float>(i) / AUDIO_SAMPLE_RATE;
+        phase += from * std::pow(to / from, t / seconds) / AUDIO_SAMPLE_RATE;
+        phase -= std::floor(phase);
+        samples[i] = (phase < 0.5f ? 1.0f : -1.0f) * std::exp(-decay * t);
+    }
+    return samples;
+}
+
+// White noise through a one-pole low-pass whose cutoff falls from `from` to `to` Hz, with a short
+// attack and an exponential decay (0: held level, for a loop)
+static std::vector<float> synthesizeNoise(Rng& rng, float seconds, float from, float to, float decay) {
+    std::vector<float> samples(static_cast<size_t>(seconds * AUDIO_SAMPLE_RATE));
+    float filtered = 0.0f;
+    for (size_t i = 0; i < samples.size(); ++i) {
+        const float t = static_cast<float>(i) / AUDIO_SAMPLE_RATE;
+        const float cutoff = from * std::pow(to / from, t / seconds);
+        filtered += (1.0f - std::exp(-glm::two_pi<float>() * cutoff / AUDIO_SAMPLE_RATE)) * (rng.range(-1.0f, 1.0f) - filtered);
+        const float attack = std::min(t / 0.002f, 1.0f);
+        samples[i] = filtered * attack * std::exp(-decay * t);
+    }
+    return samples;
+}
+
+static void synthesizeSounds(uint64_t seed) {
+    Rng rng;
+    rng.seed(seed, RNG_STREAM_AUDIO);
+    soundSamples[SOUND_SHOT] = synthesizeSweep(0.12f, 1600.0f, 400.0f, 25.0f);
+    soundSamples[SOUND_ROCK_DESTROYED] = synthesizeNoise(rng, 0.35f, 3000.0f, 600.0f, 10.0f);
+    soundSamples[SOUND_ROCK_SPLIT] = synthesizeNoise(rng, 0.7f, 1800.0f, 300.0f, 6.0f);
+    std::vector<float>& ship = soundSamples[SOUND_SHIP_DESTROYED] = synthesizeNoise(rng, 1.6f, 1200.0f, 150.0f, 2.5f);
+    for (size_t i = 0; i < ship.size(); ++i) { // A low rumble under the blast
+        const float t = static_cast<float>(i) / AUDIO_SAMPLE_RATE;
+        ship[i] += 0.15f * std::sin(glm::two_pi<float>() * 55.0f * t) * std::exp(-2.0f * t);
+    }
+    soundSamples[SOUND_THRUST] = synthesizeNoise(rng, 0.5f, 400.0f, 400.0f, 0.0f);
+    for (std::vector<float>& samples : soundSamples) normalize(samples, 0.8f);
+}
+
+// ============================ MIXER ============================
+const float AUDIO_MASTER_GAIN = 0.5f;
+const float AUDIO_RELEASE_SECONDS = 0.01f; // Fade of a stopped loop, so it ends without a click
+
+struct Voice {
+    const float* samples;
+    uint32_t length, cursor;
+    float left, right; // Gains
+    float fade; // 1 while it plays; falls by fadeStep per frame once released
+    float fadeStep;
+    uint64_t started; // Block it started on
+    Sound sound;
+    bool active, loop;
+};
+
+static Voice voices[AUDIO_MAX_VOICES];
+static float mixBuffer[AUDIO_BLOCK_FRAMES * 2];
+static uint64_t blocksMixed = 0, voicesStolen = 0;
+
+// What a voice has left to give: its louder side's gain over the part still to play
+static float voiceWorth(const Voice& voice) {
+    return std::max(voice.left, voice.right) * voice.fade * static_cast<float>(voice.length - voice.cursor) / static_cast<float>(voice.length);
+}
+
+static void startVoice(Sound sound, float gain, float pan, bool loop) {
+    Voice* chosen = nullptr;
+    for (Voice& voice : voices) {
+        if (!voice.active) {
+            chosen = &voice;
+            break;
+        }
+    }
+    if (!chosen) { // Steal the voice worth least (the older on a tie); never a loop
+        for (Voice& voice : voices) {
+            if (voice.loop) continue;
+            if (!chosen || voiceWorth(voice) < voiceWorth(*chosen) || (voiceWorth(voice) == voiceWorth(*chosen) && voice.started < chosen->started)) {
+                chosen = &voice;
+            }
+        }
+        if (!chosen) return;
+        ++voicesStolen;
+    }
+    const std::vector<float>& samples = soundSamples[sound];
+    const float angle = (std::clamp(pan, -1.0f, 1.0f) + 1.0f) * glm::quarter_pi<float>(); // Constant-power pan
+    *chosen = { samples.data(), static_cast<uint32_t>(samples.size()), 0, gain * std::cos(angle), gain * std::sin(angle), 1.0f, 0.0f,
+                blocksMixed, sound, !samples.empty(), loop };
+}
+
+static void applyCommands() {
+    const size_t head = commandHead.load(std::memory_order_acquire);
+    size_t tail = commandTail.load(std::memory_order_relaxed);
+    for (; tail != head; ++tail) {
+        const AudioCommand& command = commands[tail & (AUDIO_QUEUE_CAPACITY - 1)];
+        switch (command.type) {
+        case AUDIO_PLAY:
+            startVoice(command.sound, command.gain, command.pan, false);
+            break;
+        case AUDIO_LOOP_START: {
+            bool playing = false;
+            for (Voice& voice : voices) {
+                if (!voice.active || !voice.loop || voice.sound != command.sound) continue;
+                voice.fadeStep = 0.0f; // Released but not yet silent: it carries on
+                voice.fade = 1.0f;
+                playing = true;
+            }
+            if (!playing) startVoice(command.sound, command.gain, command.pan, true);
+            break;
+        }
+        case AUDIO_LOOP_STOP:
+            for (Voice& voice : voices) {
+                if (voice.active && voice.loop && voice.sound == command.sound) voice.fadeStep = 1.0f / (AUDIO_RELEASE_SECONDS * AUDIO_SAMPLE_RATE);
+            }
+            break;
+        }
+    }
+    commandTail.store(tail, std::memory_order_release);
+}
+
+// Mixes the next block into `out` (interleaved stereo)
+static void mixBlock(int16_t* out) {
+    applyCommands();
+    std::fill(std::begin(mixBuffer), std::end(mixBuffer), 0.0f);
+    for (Voice& voice : voices) {
+        for (int f = 0; voice.active && f < AUDIO_BLOCK_FRAMES; ++f) {
+            const float sample = voice.samples[voice.cursor] * voice.fade;
+            mixBuffer[2 * f] += sample * voice.left;
+            mixBuffer[2 * f + 1] += sample * voice.right;
+            voice.fade -= voice.fadeStep;
+            if (++voice.cursor == voice.length) {
+                voice.cursor = 0;
+                voice.active = voice.loop;
+            }
+            if (voice.fade <= 0.0f) voice.active = false;
+        }
+    }
+    for (int i = 0; i < 2 * AUDIO_BLOCK_FRAMES; ++i) {
+        out[i] = static_cast<int16_t>(std::clamp(mixBuffer[i] * AUDIO_MASTER_GAIN, -1.0f, 1.0f) * 32767.0f);
+    }
+    ++blocksMixed;
+}
+
+// ============================ DEVICE ============================
+static int16_t deviceBlocks[AUDIO_DEVICE_BLOCKS][AUDIO_BLOCK_FRAMES * 2];
+static std::thread audioThread;
+static std::atomic<bool> audioRunning(false);
+static bool started = false;
+
+#if defined(_WIN32)
+// waveOut with an event signalled as each block finishes; every finished block is mixed again and
+// queued behind the others
+static HWAVEOUT device = NULL;
+static HANDLE blockDone = NULL;
+static WAVEHDR headers[AUDIO_DEVICE_BLOCKS];
+
+static bool openDevice() {
+    blockDone = CreateEventA(NULL, FALSE, FALSE, NULL);
+    WAVEFORMATEX format = {};
+    format.wFormatTag = WAVE_FORMAT_PCM;
+    format.nChannels = 2;
+    format.nSamplesPerSec = AUDIO_SAMPLE_RATE;
+    format.wBitsPerSample = 16;
+    format.nBlockAlign = 2 * sizeof(int16_t);
+    format.nAvgBytesPerSec = AUDIO_SAMPLE_RATE * format.nBlockAlign;
+    if (!blockDone || waveOutOpen(&device, WAVE_MAPPER, &format, reinterpret_cast<DWORD_PTR>(blockDone), 0, CALLBACK_EVENT) != MMSYSERR_NOERROR) {
+        if (blockDone) CloseHandle(blockDone);
+        blockDone = NULL;
+        return false;
+    }
+    for (int b = 0; b < AUDIO_DEVICE_BLOCKS; ++b) {
+        headers[b] = {};
+        headers[b].lpData = reinterpret_cast<LPSTR>(deviceBlocks[b]);
+        headers[b].dwBufferLength = sizeof(deviceBlocks[b]);
+        waveOutPrepareHeader(device, &headers[b], sizeof(WAVEHDR));
+    }
+    return true;
+}
+
+static void closeDevice() {
+    waveOutReset(device); // Returns every queued block
+    for (WAVEHDR& header : headers) waveOutUnprepareHeader(device, &header, sizeof(WAVEHDR));
+    waveOutClose(device);
+    CloseHandle(blockDone);
+    device = NULL;
+    blockDone = NULL;
+}
+
+static void audioLoop() {
+    nameTraceThread("audio");
+    registerThread(THREAD_AUDIO);
+    while (audioRunning.load(std::memory_order_acquire)) {
+        for (WAVEHDR& header : headers) {
+            if (header.dwFlags & WHDR_INQUEUE) continue;
+            mixBlock(reinterpret_cast<int16_t*>(header.lpData));
+            waveOutWrite(device, &header, sizeof(WAVEHDR));
+        }
+        WaitForSingleObject(blockDone, 100);
+    }
+}
+#else
+// No device: blocks are mixed on the device's schedule and thrown away
+static bool openDevice() { return true; }
+static void closeDevice() {}
+
+static void audioLoop() {
+    nameTraceThread("audio");
+    registerThread(THREAD_AUDIO);
+    typedef std::chrono::steady_clock Clock;
+    const Clock::duration blockDuration = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(static_cast<double>(AUDIO_BLOCK_FRAMES) / AUDIO_SAMPLE_RATE));
+    Clock::time_point nextBlock = Clock::now();
+    int block = 0;
+    while (audioRunning.load(std::memory_order_acquire)) {
+        mixBlock(deviceBlocks[block]);
+        block = (block + 1) % AUDIO_DEVICE_BLOCKS;
+        nextBlock += blockDuration;
+        std::this_thread::sleep_until(nextBlock);
+    }
+}
+#endif
+
+// ============================ API ============================
+bool startAudio(uint64_t seed) {
+    if (started) return true;
+    synthesizeSounds(seed);
+    if (!openDevice()) {
+        useAudio = false;
+        return false;
+    }
+    for (Voice& voice : voices) voice.active = false;
+    commandHead.store(0, std::memory_order_relaxed);
+    commandTail.store(0, std::memory_order_relaxed);
+    started = true;
+    audioRunning.store(true, std::memory_order_release);
+    audioThread = std::thread(audioLoop);
+    LOG_INFO("Audio: %d Hz, %d-frame blocks x %d, %d voices", AUDIO_SAMPLE_RATE, AUDIO_BLOCK_FRAMES, AUDIO_DEVICE_BLOCKS, AUDIO_MAX_VOICES);
+    return true;
+}
+
+void stopAudio() {
+    if (!started) return;
+    audioRunning.store(false, std::memory_order_release);
+    audioThread.join();
+    closeDevice();
+    started = false;
+    LOG_INFO("Audio: %llu blocks mixed, %llu voices stolen, %u commands dropped", static_cast<unsigned long long>(blocksMixed),
+             static_cast<unsigned long long>(voicesStolen), droppedCommands.load(std::memory_order_relaxed));
+}
+
+void collectAudioMemory(MemoryReport& report) {
+    if (!started) return;
+    size_t pcmBytes = 0;
+    for (const std::vector<float>& samples : soundSamples) pcmBytes += samples.capacity() * sizeof(float);
+    report.add("audio", "sound PCM", MEMORY_CPU, pcmBytes);
+    report.add("audio", "mixer", MEMORY_CPU, sizeof(commands) + sizeof(voices) + sizeof(mixBuffer) + sizeof(deviceBlocks));
+}
+
+// ============================ PRODUCER ============================
+void playSound(Sound sound, float gain, float pan) {
+    if (!audioRunning.load(std::memory_order_relaxed)) return;
+    pushCommand({ AUDIO_PLAY, sound, gain, pan });
+}
+
+void setThrustSound(bool on) {
+    static bool thrusting = false;
+    if (!audioRunning.load(std::memory_order_relaxed) || on == thrusting) return;
+    thrusting = on;
+    pushCommand({ on ? AUDIO_LOOP_START : AUDIO_LOOP_STOP, SOUND_THRUST, 0.35f, 0.0f });
+}
+
+void playEffectSound(const EffectEvent& effect) {
+    const float pan = 0.8f * effect.position.x;
+    switch (effect.type) {
+    case EFFECT_SHOT_FIRED: playSound(SOUND_SHOT, 0.25f, pan); break;
+    case EFFECT_ROCK_DESTROYED: playSound(SOUND_ROCK_DESTROYED, 0.5f, pan); break;
+    case EFFECT_ROCK_SPLIT: playSound(SOUND_ROCK_SPLIT, 0.7f, pan); break;
+    case EFFECT_SHIP_DESTROYED: playSound(SOUND_SHIP_DESTROYED, 1.0f, pan); break;
+    }
+}
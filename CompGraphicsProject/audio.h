@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+struct EffectEvent;
+struct MemoryReport;
+
+// Sound (on by default in the window, --no-audio turns it off). Everything audible happens on a
+// thread of its own: the thread that steps the game only pushes small commands into a bounded
+// lock-free single-producer single-consumer ring, as it takes each tick's effect events (simthread.h),
+// and never waits, decodes or mixes. The audio thread drains the ring once per block, starts and
+// stops voices, and mixes them into the device's next buffer, so a frame that stalls does not make
+// the sound stall with it. The sounds are synthesized into PCM once at startup; a fixed budget of
+// AUDIO_MAX_VOICES plays them, and a new sound past the budget steals the voice with the least left
+// to give (quietest times shortest remaining; never the thrust loop). Nothing allocates once it runs.
+// The device is waveOut on Windows; elsewhere the mixer runs against a null sink paced by the clock.
+
+// ============================ AUDIO CONSTANTS ============================
+extern bool useAudio; // Start the mixer with the window (--no-audio)
+const int AUDIO_SAMPLE_RATE = 48000;
+const int AUDIO_BLOCK_FRAMES = 512; // Stereo frames mixed at a time (about 11 ms)
+const int AUDIO_DEVICE_BLOCKS = 4; // Blocks queued at the device: the latency, and the stall it rides out
+const int AUDIO_MAX_VOICES = 24;
+const size_t AUDIO_QUEUE_CAPACITY = 1024; // Commands; a power of two. When full, new ones are dropped and counted.
+
+enum Sound : uint8_t {
+    SOUND_SHOT,
+    SOUND_ROCK_DESTROYED,
+    SOUND_ROCK_SPLIT,
+    SOUND_SHIP_DESTROYED,
+    SOUND_THRUST, // Looped while the player's engine is on
+    SOUND_COUNT
+};
+
+// ============================ AUDIO API ============================
+// Synthesizes the sounds, opens the device and starts the thread; false (and useAudio off) without a device
+bool startAudio(uint64_t seed);
+void stopAudio(); // Joins the thread and closes the device (safe to call twice)
+void collectAudioMemory(MemoryReport& report); // Nothing unless started
+
+// The producer side, for the one thread that steps the game. Each queues a command and returns; all
+// do nothing while the mixer is not running.
+void playSound(Sound sound, float gain, float pan); // pan: -1 left to 1 right
+void setThrustSound(bool on); // Queued only when it changes
+void playEffectSound(const EffectEvent& effect); // Its sound, panned by where it happened
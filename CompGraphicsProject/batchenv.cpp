@@ -0,0 +1,136 @@
+#include "batchenv.h"
+#include "jobs.h"
+#include "log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+// ============================ OBSERVATIONS ============================
+void writeObservation(const GameWorld& source, float* observation) {
+    const Ship ship = source.ships.ship(0);
+    observation[0] = ship.position.x;
+    observation[1] = ship.position.y;
+    observation[2] = ship.velocity.x;
+    observation[3] = ship.velocity.y;
+    observation[4] = std::sin(ship.rotation);
+    observation[5] = std::cos(ship.rotation);
+    observation[6] = source.ships.shieldActive[0] ? 1.0f : 0.0f;
+    observation[7] = !source.ships.shieldActive[0] && source.tick + 1 >= source.ships.shieldReadyTick[0] ? 1.0f : 0.0f; // On the next tick
+
+    // Nearest rocks by insertion into a short sorted list (the field holds a few dozen at most)
+    int nearest[BATCH_NEAREST_ASTEROIDS];
+    float nearestDistanceSq[BATCH_NEAREST_ASTEROIDS];
+    int found = 0;
+    const AsteroidStore& rocks = source.asteroids;
+    for (size_t i = 0; i < rocks.count(); ++i) {
+        float dx = nearestImage(rocks.x[i], ship.position.x) - ship.position.x;
+        float dy = nearestImage(rocks.y[i], ship.position.y) - ship.position.y;
+        float distanceSq = dx * dx + dy * dy;
+        if (found == BATCH_NEAREST_ASTEROIDS && distanceSq >= nearestDistanceSq[found - 1]) continue;
+        int slot = std::min(found, BATCH_NEAREST_ASTEROIDS - 1);
+        while (slot > 0 && nearestDistanceSq[slot - 1] > distanceSq) {
+            nearest[slot] = nearest[slot - 1];
+            nearestDistanceSq[slot] = nearestDistanceSq[slot - 1];
+            --slot;
+        }
+        nearest[slot] = static_cast<int>(i);
+        nearestDistanceSq[slot] = distanceSq;
+        found = std::min(found + 1, BATCH_NEAREST_ASTEROIDS);
+    }
+
+    float* rock = observation + BATCH_SHIP_FEATURES;
+    for (int k = 0; k < BATCH_NEAREST_ASTEROIDS; ++k, rock += BATCH_ASTEROID_FEATURES) {
+        if (k >= found) {
+            std::fill(rock, rock + BATCH_ASTEROID_FEATURES, 0.0f);
+            continue;
+        }
+        size_t i = static_cast<size_t>(nearest[k]);
+        rock[0] = nearestImage(rocks.x[i], ship.position.x) - ship.position.x;
+        rock[1] = nearestImage(rocks.y[i], ship.position.y) - ship.position.y;
+        rock[2] = rocks.vx[i];
+        rock[3] = rocks.vy[i];
+        rock[4] = rocks.radius(i);
+    }
+}
+
+// ============================ BATCH ENVIRONMENT ============================
+// Worlds per job: a world step is a few microseconds, so a handful each keeps the queue traffic small
+const size_t BATCH_WORLDS_PER_JOB = 4;
+
+void BatchEnvironment::init(int worldCount, uint64_t seedValue, const SimulationLimits& worldLimits) {
+    seed = seedValue;
+    worlds.clear(); // A world is not copyable (its wave script), so they are made in place
+    worlds.resize(static_cast<size_t>(std::max(worldCount, 1)));
+    for (size_t i = 0; i < worlds.size(); ++i) {
+        worlds[i].instrumented = false; // No logger or profiler traffic from the workers
+        worlds[i].init(worldLimits);
+        worlds[i].seed(seed + i);
+    }
+}
+
+void BatchEnvironment::reset(float* observations) {
+    for (size_t i = 0; i < worlds.size(); ++i) {
+        worlds[i].reset();
+        worlds[i].seed(seed + i);
+        writeObservation(worlds[i], observations + i * BATCH_OBSERVATION_SIZE);
+    }
+}
+
+void BatchEnvironment::step(const uint8_t* inputs, float* observations, float* rewards, uint8_t* dones) {
+    parallelFor(0, worlds.size(), BATCH_WORLDS_PER_JOB, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            GameWorld& w = worlds[i];
+            const InputState input = unpackInput(inputs[i]);
+            const int scoreBefore = w.score;
+            for (int tick = 0; tick < ticksPerStep && !w.isGameOver; ++tick) w.step(SIM_DT, input);
+
+            float reward = static_cast<float>(w.score - scoreBefore);
+            uint8_t done = 0;
+            if (w.isGameOver) {
+                reward += BATCH_GAME_OVER_REWARD;
+                done = 1;
+                w.reset(); // The random streams carry on, so the next episode differs
+            }
+            rewards[i] = reward;
+            dones[i] = done;
+            writeObservation(w, observations + i * BATCH_OBSERVATION_SIZE);
+        }
+    });
+}
+
+// ============================ HEADLESS RUN ============================
+void runBatchHeadless(int worldCount, long long steps, uint64_t seed) {
+    BatchEnvironment env;
+    env.init(worldCount, seed);
+    const size_t count = env.worlds.size();
+    std::vector<float> observations(count * BATCH_OBSERVATION_SIZE);
+    std::vector<float> rewards(count);
+    std::vector<uint8_t> dones(count);
+
+    InputState policy; // Same as the single-world headless run
+    policy.left = true;
+    policy.fire = true;
+    policy.shield = true;
+    std::vector<uint8_t> inputs(count, packInput(policy));
+
+    env.reset(observations.data());
+    long long episodes = 0;
+    double totalReward = 0.0;
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+    for (long long s = 0; s < steps; ++s) {
+        env.step(inputs.data(), observations.data(), rewards.data(), dones.data());
+        for (size_t i = 0; i < count; ++i) {
+            totalReward += rewards[i];
+            episodes += dones[i];
+        }
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    double worldSteps = static_cast<double>(steps) * static_cast<double>(count);
+    LOG_INFO("[batch] %zu worlds on %d threads: %lld steps in %g s = %.0f world steps/s (%.0f ticks/s)", count,
+             jobWorkerCount() + 1, steps, seconds, seconds > 0.0 ? worldSteps / seconds : 0.0,
+             seconds > 0.0 ? worldSteps * env.ticksPerStep / seconds : 0.0);
+    LOG_INFO("[batch] %lld episodes finished, total reward %.0f", episodes, totalReward);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "simulation.h"
+
+// Batched environments for bot training: K independent headless GameWorlds stepped in lock-step,
+// the worlds spread over the job system's workers (jobs.h). Each step takes one packed input per world (packInput bits)
+// and writes observations, rewards and done flags into caller-provided contiguous arrays; nothing
+// is allocated after init. A world whose ship is lost is reset on the spot: its done flag is set
+// for that step and its observation already shows the fresh game, so a batch never waits on a
+// finished episode. Like simulation.h, nothing here depends on GL.
+
+// ============================ OBSERVATIONS ============================
+// BATCH_OBSERVATION_SIZE floats per world, worlds back to back:
+//   ship: x, y, vx, vy, sin(rotation), cos(rotation), shield up (0/1), shield ready (0/1)
+//   then the BATCH_NEAREST_ASTEROIDS nearest rocks, nearest first: dx, dy (from the ship to the
+//   rock's nearest wrapped image), vx, vy, radius; slots past the last rock are zero
+const int BATCH_SHIP_FEATURES = 8;
+const int BATCH_ASTEROID_FEATURES = 5;
+const int BATCH_NEAREST_ASTEROIDS = 8;
+const int BATCH_OBSERVATION_SIZE = BATCH_SHIP_FEATURES + BATCH_ASTEROID_FEATURES * BATCH_NEAREST_ASTEROIDS;
+
+// Reward for a step: the points scored (getAsteroidPoints), plus this on the step the ship is lost
+const float BATCH_GAME_OVER_REWARD = -100.0f;
+
+// ============================ BATCH ENVIRONMENT ============================
+struct BatchEnvironment {
+    std::vector<GameWorld> worlds;
+    int ticksPerStep = 1; // Simulation ticks per step, all with the step's input (action repeat)
+    uint64_t seed = 0;
+
+    // Sizes everything; world i is seeded with seed + i
+    void init(int worldCount, uint64_t seedValue, const SimulationLimits& worldLimits = SimulationLimits());
+
+    // Every world back to a fresh game with its initial seed; fills `observations`
+    void reset(float* observations);
+    // inputs: worlds.size() packed inputs; observations: worlds.size() * BATCH_OBSERVATION_SIZE floats;
+    // rewards and dones: worlds.size() each. Returns once every world has stepped.
+    void step(const uint8_t* inputs, float* observations, float* rewards, uint8_t* dones);
+};
+
+// Writes one world's observation (BATCH_OBSERVATION_SIZE floats)
+void writeObservation(const GameWorld& source, float* observation);
+
+// ============================ HEADLESS RUN ============================
+// Steps a batch for `steps` steps with the headless mode's spin-fire-shield input, then logs the
+// throughput and the episodes finished
+void runBatchHeadless(int worldCount, long long steps, uint64_t seed);
@@ -0,0 +1,360 @@
+#include "batchrender.h"
+#include "batchenv.h"
+#include "shaders.h"
+#include "simulation.h"
+#include "log.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// ============================ BATCH RENDERER DATA ============================
+// One per drawn image: a rock (or one of its ghosts across an edge), a ship or a bullet
+struct TileInstance {
+    glm::vec4 transform; // x, y, rotation, scale
+    glm::vec4 colorTile; // rgb, world index (exact as a float up to 2^24 worlds)
+};
+
+// Draw groups: every atlas shape at its coarsest level, then the ship, then the bullets
+const int BATCH_SHIP_GROUP = ASTEROID_SHAPE_COUNT;
+const int BATCH_BULLET_GROUP = ASTEROID_SHAPE_COUNT + 1;
+const int BATCH_GROUP_COUNT = ASTEROID_SHAPE_COUNT + 2;
+
+static unsigned int tileProgram;
+static int tileGridLoc;
+static unsigned int meshVAO, meshBuffer, instanceBuffer;
+static unsigned int targetFBO, targetTexture;
+static int worlds = 0, tile = 0;
+static int tilesPerColumn = 0, columns = 0;
+static int shipFirst = 0, bulletFirst = 0; // In meshBuffer, after the atlas
+static size_t instanceCapacity = 0; // TileInstances instanceBuffer holds
+
+static std::vector<TileInstance> instances; // Sorted by group
+static std::vector<int> groupStart;
+static std::vector<int> groupCursor;
+
+struct ObservationReadback {
+    unsigned int buffer = 0;
+    GLsync fence = 0;
+};
+static ObservationReadback readbacks[BATCH_RENDER_READBACKS];
+static int readbackHead = 0; // Oldest queued
+static int readbackCount = 0;
+static bool readbackMapped = false;
+
+// ============================ SHADERS ============================
+// The world's field (-1..1, wrapping) fills the world's tile. y is flipped so the first row in memory
+// is the top of the field; the clip distances cut whatever reaches past the tile's edges.
+static const char* tileVertexShaderSource = R"(
+    #version 330 core
+    layout (location = 0) in vec2 aPos;
+    layout (location = 1) in vec4 iTransform; // x, y, rotation, scale
+    layout (location = 2) in vec4 iColorTile; // rgb, world index
+    uniform ivec2 tileGrid; // Tiles per column, columns
+    out vec3 color;
+    out float gl_ClipDistance[4];
+
+    void main()
+    {
+        float c = cos(iTransform.z), s = sin(iTransform.z);
+        vec2 world = mat2(c, s, -s, c) * (aPos * iTransform.w) + iTransform.xy;
+        int tile = int(iColorTile.w);
+        vec2 cell = vec2(tile / tileGrid.x, tile % tileGrid.x);
+        vec2 local = vec2(world.x, -world.y) * 0.5 + 0.5;
+        gl_ClipDistance[0] = local.x;
+        gl_ClipDistance[1] = 1.0 - local.x;
+        gl_ClipDistance[2] = local.y;
+        gl_ClipDistance[3] = 1.0 - local.y;
+        gl_Position = vec4((cell + local) / vec2(tileGrid.y, tileGrid.x) * 2.0 - 1.0, 0.0, 1.0);
+        color = iColorTile.rgb;
+    }
+)";
+
+static const char* tileFragmentShaderSource = R"(
+    #version 330 core
+    in vec3 color;
+    out vec4 FragColor;
+
+    void main()
+    {
+        FragColor = vec4(color, 1.0);
+    }
+)";
+
+// ============================ SETUP ============================
+bool setupBatchRenderer(int worldCount, int tileSize, const std::vector<float>& atlasVertices) {
+    worlds = std::max(worldCount, 1);
+    tile = std::max(tileSize, 1);
+    GLint maxSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+    tilesPerColumn = std::min(worlds, static_cast<int>(maxSize) / tile);
+    if (tilesPerColumn < 1) {
+        LOG_ERROR("Batch render: %d-pixel tiles do not fit in a %d-pixel texture", tile, maxSize);
+        return false;
+    }
+    columns = (worlds + tilesPerColumn - 1) / tilesPerColumn;
+    if (columns * tile > maxSize) {
+        LOG_ERROR("Batch render: %d worlds of %d pixels do not fit in one %dx%d texture", worlds, tile, maxSize, maxSize);
+        return false;
+    }
+
+    tileProgram = buildProgram("batch tiles", tileVertexShaderSource, tileFragmentShaderSource);
+    if (!tileProgram) return false;
+    tileGridLoc = glGetUniformLocation(tileProgram, "tileGrid");
+
+    // Mesh buffer: the asteroid atlas, then the ship's triangle and a bullet point
+    std::vector<float> meshVertices = atlasVertices;
+    shipFirst = static_cast<int>(meshVertices.size() / 2);
+    const float ship[] = { 0.0f, 1.0f, -1.0f, -1.0f, 1.0f, -1.0f };
+    meshVertices.insert(meshVertices.end(), ship, ship + 6);
+    bulletFirst = static_cast<int>(meshVertices.size() / 2);
+    meshVertices.push_back(0.0f);
+    meshVertices.push_back(0.0f);
+
+    glGenVertexArrays(1, &meshVAO);
+    glGenBuffers(1, &meshBuffer);
+    glGenBuffers(1, &instanceBuffer);
+    glBindVertexArray(meshVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, meshBuffer);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(meshVertices.size() * sizeof(float)), meshVertices.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(1, 1);
+    glVertexAttribDivisor(2, 1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glGenTextures(1, &targetTexture);
+    glBindTexture(GL_TEXTURE_2D, targetTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, columns * tile, tilesPerColumn * tile, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glGenFramebuffers(1, &targetFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, targetFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, targetTexture, 0);
+    const bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (!complete) {
+        LOG_ERROR("Batch render: framebuffer incomplete");
+        return false;
+    }
+
+    const size_t bytes = batchObservationBytes() * static_cast<size_t>(worlds);
+    for (ObservationReadback& readback : readbacks) {
+        glGenBuffers(1, &readback.buffer);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(bytes), NULL, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    groupStart.assign(BATCH_GROUP_COUNT + 1, 0);
+    groupCursor.assign(BATCH_GROUP_COUNT, 0);
+    LOG_INFO("Batch render: %d worlds in %dx%d tiles (%d columns of %d), %zu KB per readback",
+             worlds, tile, tile, columns, tilesPerColumn, bytes / 1024);
+    return true;
+}
+
+void destroyBatchRenderer() {
+    if (readbackMapped) releaseBatchObservations();
+    for (ObservationReadback& readback : readbacks) {
+        if (readback.fence) glDeleteSync(readback.fence);
+        glDeleteBuffers(1, &readback.buffer);
+        readback = ObservationReadback();
+    }
+    readbackHead = readbackCount = 0;
+    glDeleteFramebuffers(1, &targetFBO);
+    glDeleteTextures(1, &targetTexture);
+    glDeleteVertexArrays(1, &meshVAO);
+    glDeleteBuffers(1, &meshBuffer);
+    glDeleteBuffers(1, &instanceBuffer);
+    glDeleteProgram(tileProgram);
+    targetFBO = targetTexture = meshVAO = meshBuffer = instanceBuffer = tileProgram = 0;
+    instanceCapacity = 0;
+}
+
+size_t batchObservationBytes() {
+    return static_cast<size_t>(tile) * tile * 4;
+}
+
+// ============================ RENDER ============================
+// Counting sort of every world's images into the draw groups (two passes over the same loop)
+template <typename Visit>
+static void forEachImage(const BatchEnvironment& env, Visit visit) {
+    for (size_t w = 0; w < env.worlds.size(); ++w) {
+        const GameWorld& world = env.worlds[w];
+        const float tileIndex = static_cast<float>(w);
+        const AsteroidStore& rocks = world.asteroids; // Batch worlds integrate, so x/y are current
+        for (size_t i = 0; i < rocks.count(); ++i) {
+            const glm::vec2 position(rocks.x[i], rocks.y[i]);
+            const TileInstance rock = { glm::vec4(position, rocks.rot[i], rocks.scale(i)), glm::vec4(asteroidPalette[rocks.paletteIndex[i]], tileIndex) };
+            visit(rocks.shapeIndex[i], rock);
+            glm::vec2 offsets[3];
+            const int ghosts = wrapGhostOffsets(position, ASTEROID_MAX_OUTLINE_RADIUS * rocks.scale(i), offsets);
+            for (int g = 0; g < ghosts; ++g) {
+                TileInstance ghost = rock;
+                ghost.transform.x += offsets[g].x;
+                ghost.transform.y += offsets[g].y;
+                visit(rocks.shapeIndex[i], ghost);
+            }
+        }
+        const ShipStore& ships = world.ships;
+        for (size_t s = 0; s < ships.count(); ++s) {
+            if (!ships.alive[s]) continue;
+            visit(BATCH_SHIP_GROUP, TileInstance{ glm::vec4(ships.x[s], ships.y[s], ships.rot[s], ships.scale[s]), glm::vec4(0.5f, 1.0f, 1.0f, tileIndex) });
+        }
+        const BulletStore& bullets = world.bullets;
+        for (size_t j = 0; j < bullets.capacity(); ++j) {
+            if (!bullets.live(j)) continue;
+            visit(BATCH_BULLET_GROUP, TileInstance{ glm::vec4(bullets.x[j], bullets.y[j], 0.0f, 1.0f), glm::vec4(1.0f, 0.0f, 0.0f, tileIndex) });
+        }
+    }
+}
+
+bool renderBatchObservations(const BatchEnvironment& env) {
+    if (readbackCount == BATCH_RENDER_READBACKS) return false;
+
+    std::fill(groupStart.begin(), groupStart.end(), 0);
+    forEachImage(env, [](int group, const TileInstance&) { ++groupStart[group + 1]; });
+    for (int g = 0; g < BATCH_GROUP_COUNT; ++g) groupStart[g + 1] += groupStart[g];
+    std::copy(groupStart.begin(), groupStart.end() - 1, groupCursor.begin());
+    instances.resize(static_cast<size_t>(groupStart[BATCH_GROUP_COUNT]));
+    forEachImage(env, [](int group, const TileInstance& instance) { instances[groupCursor[group]++] = instance; });
+
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    if (instances.size() > instanceCapacity) {
+        instanceCapacity = std::max(instances.size(), instanceCapacity * 2);
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(instanceCapacity * sizeof(TileInstance)), NULL, GL_STREAM_DRAW);
+    }
+    else {
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(instanceCapacity * sizeof(TileInstance)), NULL, GL_STREAM_DRAW); // Orphan
+    }
+    if (!instances.empty()) glBufferSubData(GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(instances.size() * sizeof(TileInstance)), instances.data());
+
+    glBindFramebuffer(GL_FRAMEBUFFER, targetFBO);
+    glViewport(0, 0, columns * tile, tilesPerColumn * tile);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glUseProgram(tileProgram);
+    glUniform2i(tileGridLoc, tilesPerColumn, columns);
+    glBindVertexArray(meshVAO);
+    for (int plane = 0; plane < 4; ++plane) glEnable(GL_CLIP_DISTANCE0 + plane);
+    glPointSize(1.0f);
+    for (int g = 0; g < BATCH_GROUP_COUNT; ++g) {
+        const GLsizei count = groupStart[g + 1] - groupStart[g];
+        if (count == 0) continue;
+        // GL 3.3 has no base instance: point the instance attributes at the group instead
+        const size_t base = static_cast<size_t>(groupStart[g]) * sizeof(TileInstance);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(TileInstance), (void*)(base + offsetof(TileInstance, transform)));
+        glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(TileInstance), (void*)(base + offsetof(TileInstance, colorTile)));
+        if (g == BATCH_SHIP_GROUP) glDrawArraysInstanced(GL_TRIANGLES, shipFirst, 3, count);
+        else if (g == BATCH_BULLET_GROUP) glDrawArraysInstanced(GL_POINTS, bulletFirst, 1, count);
+        else {
+            const AsteroidMesh& mesh = asteroidShapes[g].lods[0];
+            glDrawArraysInstanced(GL_TRIANGLE_FAN, mesh.baseVertex, mesh.vertexCount, count);
+        }
+    }
+    for (int plane = 0; plane < 4; ++plane) glDisable(GL_CLIP_DISTANCE0 + plane);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // One read per column: a column's tiles are consecutive rows, so each world's tile is contiguous
+    ObservationReadback& readback = readbacks[(readbackHead + readbackCount) % BATCH_RENDER_READBACKS];
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    for (int column = 0; column < columns; ++column) {
+        const int first = column * tilesPerColumn;
+        const int rows = std::min(tilesPerColumn, worlds - first);
+        glReadPixels(column * tile, 0, tile, rows * tile, GL_RGBA, GL_UNSIGNED_BYTE,
+                     (void*)(static_cast<size_t>(first) * batchObservationBytes()));
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush(); // So the fence reaches the GPU while the CPU steps the next batch
+    ++readbackCount;
+    return true;
+}
+
+const uint8_t* mapBatchObservations() {
+    if (readbackCount == 0) return nullptr;
+    ObservationReadback& readback = readbacks[readbackHead];
+    if (readback.fence) {
+        glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        glDeleteSync(readback.fence);
+        readback.fence = 0;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+    void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(batchObservationBytes() * worlds), GL_MAP_READ_BIT);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    readbackMapped = pixels != nullptr;
+    if (!pixels) releaseBatchObservations(); // Lost: drop it rather than hand out nothing forever
+    return static_cast<const uint8_t*>(pixels);
+}
+
+void releaseBatchObservations() {
+    if (readbackCount == 0) return;
+    if (readbackMapped) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readbacks[readbackHead].buffer);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        readbackMapped = false;
+    }
+    readbackHead = (readbackHead + 1) % BATCH_RENDER_READBACKS;
+    --readbackCount;
+}
+
+// ============================ HEADLESS RUN ============================
+void runBatchRendered(int worldCount, long long steps, uint64_t seed, int tileSize, const std::vector<float>& atlasVertices) {
+    BatchEnvironment env;
+    env.init(worldCount, seed);
+    if (!setupBatchRenderer(static_cast<int>(env.worlds.size()), tileSize, atlasVertices)) return;
+    const size_t count = env.worlds.size();
+    std::vector<float> observations(count * BATCH_OBSERVATION_SIZE);
+    std::vector<float> rewards(count);
+    std::vector<uint8_t> dones(count);
+
+    InputState policy; // Same as the unrendered batch run
+    policy.left = true;
+    policy.fire = true;
+    policy.shield = true;
+    std::vector<uint8_t> inputs(count, packInput(policy));
+
+    // A bot would read the pixels here; the run only touches every world's first pixel
+    unsigned long long pixelSum = 0;
+    long long frames = 0;
+    auto consume = [&]() {
+        if (const uint8_t* pixels = mapBatchObservations()) {
+            for (size_t i = 0; i < count; ++i) pixelSum += pixels[i * batchObservationBytes()];
+            ++frames;
+            releaseBatchObservations();
+        }
+    };
+
+    env.reset(observations.data());
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+    for (long long s = 0; s < steps; ++s) {
+        env.step(inputs.data(), observations.data(), rewards.data(), dones.data());
+        if (!renderBatchObservations(env)) {
+            consume();
+            renderBatchObservations(env);
+        }
+        if (s > 0) consume(); // The previous step's pixels, copied while this step was simulated
+    }
+    while (frames < steps) {
+        const long long before = frames;
+        consume();
+        if (frames == before) break;
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    double worldSteps = static_cast<double>(steps) * static_cast<double>(count);
+    LOG_INFO("[batch render] %zu worlds, %dx%d tiles: %lld steps in %g s = %.0f observations/s (%.1f MB/s read back, checksum %llu)",
+             count, tileSize, tileSize, steps, seconds, seconds > 0.0 ? worldSteps / seconds : 0.0,
+             seconds > 0.0 ? frames * batchObservationBytes() * static_cast<double>(count) / seconds / 1.0e6 : 0.0, pixelSum);
+    destroyBatchRenderer();
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct BatchEnvironment;
+
+// Rendered observations for vision-based agents (--batch N --batch-render SIZE): every world of a
+// BatchEnvironment is drawn into its own SIZE x SIZE tile of one RGBA8 render target, all worlds in one
+// pass (one instanced draw per mesh, the world picking the tile and gl_ClipDistance keeping each
+// world inside it), and read back through a ring of pixel pack buffers, so the CPU steps the next
+// batch while the GPU draws and copies this one. Tiles are stacked in columns and each column is
+// read back on its own, so world i's pixels are one contiguous block of batchObservationBytes()
+// (RGBA, top row first). Needs a current GL 3.3 context; the worlds themselves stay GL-free.
+const int BATCH_RENDER_READBACKS = 3;
+
+// ============================ BATCH RENDERER API ============================
+// Builds the target, the readback ring and a mesh buffer from the asteroid atlas; false if the
+// tiles do not fit in one texture or the program fails to build
+bool setupBatchRenderer(int worldCount, int tileSize, const std::vector<float>& atlasVertices);
+void destroyBatchRenderer();
+size_t batchObservationBytes(); // Bytes of one world's tile
+
+// Draws every world's current state into its tile and queues the readback. Returns false (and
+// draws nothing) when every readback is still queued or held.
+bool renderBatchObservations(const BatchEnvironment& env);
+// Pixels of the oldest queued render, waiting for the GPU if it has not finished it yet; nullptr if
+// nothing is queued. Valid until releaseBatchObservations.
+const uint8_t* mapBatchObservations();
+void releaseBatchObservations();
+
+// ============================ HEADLESS RUN ============================
+// runBatchHeadless with observations: each step's render overlaps the next step on the CPU. Logs the
+// throughput; needs a current context.
+void runBatchRendered(int worldCount, long long steps, uint64_t seed, int tileSize, const std::vector<float>& atlasVertices);
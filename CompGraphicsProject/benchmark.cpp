@@ -0,0 +1,763 @@
+#include "simulation.h"
+#include "scenario.h"
+#include "snapshot.h"
+#include "rollback.h"
+#include "arena.h"
+#include "arenanode.h"
+#include "rasterbench.h"
+#include "bots.h"
+#include "waves.h"
+#include "loadshed.h"
+#include "random.h"
+#include "log.h"
+#include "jobs.h"
+#include "entitymemory.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+// Nanoseconds per call, the call repeated (doubling up) until it has run for minSeconds
+template <typename Call>
+static double timePerCall(double minSeconds, Call&& call) {
+    long long iterations = 1;
+    while (true) {
+        const Clock::time_point start = Clock::now();
+        for (long long i = 0; i < iterations; ++i) call();
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        if (seconds >= minSeconds || iterations >= (1LL << 30)) return seconds * 1e9 / iterations;
+        const double scale = seconds > 0.0 ? minSeconds * 1.4 / seconds : 10.0;
+        iterations = std::max(iterations + 1, static_cast<long long>(iterations * std::min(scale, 10.0)));
+    }
+}
+
+// ============================ SNAPSHOT BENCHMARK ============================
+// Times saving and restoring the world as the scenario left it (each repeated until it has run for
+// minSeconds), then checks the round trip: a restored world must save back byte for byte, and must
+// play the same ticks to the same state as the world it was saved from.
+static std::string runSnapshotBenchmark(double minSeconds) {
+    const size_t capacity = worldSnapshotBytes(world.limits);
+    std::vector<unsigned char> saved(capacity), scratch(capacity), replayed(capacity);
+    const size_t bytes = saveWorldSnapshot(world, saved.data(), capacity);
+    const size_t rocks = world.asteroids.count();
+
+    const double saveNs = timePerCall(minSeconds, [&] { saveWorldSnapshot(world, scratch.data(), capacity); });
+    const double restoreNs = timePerCall(minSeconds, [&] { restoreWorldSnapshot(world, saved.data(), bytes); });
+
+    const bool roundTrip = saveWorldSnapshot(world, scratch.data(), capacity) == bytes && std::memcmp(saved.data(), scratch.data(), bytes) == 0;
+    // The scenario's top-ups draw from a stream outside the world, so the replayed ticks run without them
+    const bool scenarioDriven = world.scenarioDriven;
+    world.scenarioDriven = false;
+    InputState input;
+    input.left = input.fire = true;
+    const int rollbackTicks = 120;
+    for (int tick = 0; tick < rollbackTicks; ++tick) world.step(SIM_DT, input);
+    const size_t first = saveWorldSnapshot(world, scratch.data(), capacity);
+    restoreWorldSnapshot(world, saved.data(), bytes);
+    for (int tick = 0; tick < rollbackTicks; ++tick) world.step(SIM_DT, input);
+    const size_t second = saveWorldSnapshot(world, replayed.data(), capacity);
+    const bool rollback = first == second && std::memcmp(scratch.data(), replayed.data(), first) == 0;
+    world.scenarioDriven = scenarioDriven;
+
+    char line[768];
+    std::snprintf(line, sizeof(line),
+                  "{\"benchmark\":\"snapshot\",\"scenario\":\"%s\",\"asteroids\":%zu,\"bullet_slots\":%zu,\"bytes\":%zu,"
+                  "\"save_us\":%.2f,\"restore_us\":%.2f,\"round_trip\":%s,\"rollback_exact\":%s}",
+                  activeScenario.name.c_str(), rocks, world.bullets.capacity(), bytes, saveNs / 1000.0, restoreNs / 1000.0, roundTrip ? "true" : "false", rollback ? "true" : "false");
+    if (!roundTrip || !rollback) LOG_ERROR("Snapshot of %s did not %s", activeScenario.name.c_str(), roundTrip ? "replay exactly" : "round-trip");
+    return line;
+}
+
+// ============================ ROLLBACK BENCHMARK ============================
+// The worst frame a rollback session (rollback.h) can have, on the world as the scenario left it: a
+// prediction ROLLBACK_MAX_TICKS back turns out wrong, so one restore and ROLLBACK_MAX_TICKS ticks
+// stepped (and saved) again, repeated until it has run for minSeconds and set against a 60 Hz frame.
+// Then two peers play a game over a link that delays each input by 1 to 6 ticks, and must end
+// exactly where a world stepped with every input on time does.
+static std::string runRollbackBenchmark(double minSeconds, uint64_t seed) {
+    const bool scenarioDriven = world.scenarioDriven;
+    world.scenarioDriven = false; // Top-ups drawn outside the world would make every resimulation differ
+    RollbackSession session;
+    startRollbackSession(session, world, 0);
+    while (advanceRollback(session, INPUT_LEFT | INPUT_FIRE)) {} // Nothing from the partner: stalls ROLLBACK_MAX_TICKS in
+    const double resimulateNs = timePerCall(minSeconds, [&] { resimulateRollback(session, session.tick - ROLLBACK_MAX_TICKS); });
+    world.scenarioDriven = scenarioDriven;
+    const size_t rocks = world.asteroids.count();
+
+    // Two peers at the game's own limits with a ship each, and the reference they must agree with
+    const uint64_t gameTicks = 3600;
+    Rng rng;
+    rng.seed(seed, RNG_STREAM_VALIDATION); // The players' keys
+    std::vector<uint8_t> keys[ROLLBACK_PLAYERS];
+    for (std::vector<uint8_t>& played : keys) {
+        uint8_t held = 0;
+        for (uint64_t tick = 0; tick < gameTicks; ++tick) {
+            if (rng.below(24) == 0) held = static_cast<uint8_t>(rng.below(32));
+            played.push_back(held);
+        }
+    }
+    std::vector<std::unique_ptr<GameWorld>> worlds;
+    for (int k = 0; k <= ROLLBACK_PLAYERS; ++k) {
+        worlds.push_back(std::make_unique<GameWorld>());
+        worlds.back()->instrumented = false;
+        SimulationLimits limits;
+        limits.ships = ROLLBACK_PLAYERS;
+        limits.maxBullets = ROLLBACK_PLAYERS * maxBulletsFor(world.weapon);
+        worlds.back()->weapon = world.weapon;
+        worlds.back()->init(limits);
+        worlds.back()->seed(seed);
+    }
+    RollbackSession peers[ROLLBACK_PLAYERS];
+    struct InFlight { uint64_t tick; uint8_t input; uint64_t arrives; };
+    std::vector<InFlight> links[ROLLBACK_PLAYERS]; // To each peer, in order (a later input never overtakes)
+    for (int p = 0; p < ROLLBACK_PLAYERS; ++p) startRollbackSession(peers[p], *worlds[p], p);
+    for (uint64_t frame = 0; peers[0].tick < gameTicks || peers[1].tick < gameTicks; ++frame) {
+        for (int p = 0; p < ROLLBACK_PLAYERS; ++p) {
+            std::vector<InFlight>& link = links[p];
+            size_t delivered = 0;
+            while (delivered < link.size() && link[delivered].arrives <= frame) {
+                addRollbackInput(peers[p], 1 - p, link[delivered].tick, link[delivered].input);
+                ++delivered;
+            }
+            link.erase(link.begin(), link.begin() + static_cast<std::ptrdiff_t>(delivered));
+        }
+        for (int p = 0; p < ROLLBACK_PLAYERS; ++p) {
+            if (peers[p].tick >= gameTicks) continue;
+            const uint64_t tick = peers[p].tick;
+            if (!advanceRollback(peers[p], keys[p][tick])) continue;
+            std::vector<InFlight>& link = links[1 - p];
+            const uint64_t arrives = std::max(frame + 1 + static_cast<uint64_t>(rng.below(6)), link.empty() ? 0 : link.back().arrives);
+            link.push_back({ tick, keys[p][tick], arrives });
+        }
+    }
+    for (int p = 0; p < ROLLBACK_PLAYERS; ++p) {
+        for (const InFlight& sent : links[p]) addRollbackInput(peers[p], 1 - p, sent.tick, sent.input);
+        if (peers[p].correctFrom != UINT64_MAX) resimulateRollback(peers[p], peers[p].correctFrom);
+    }
+    GameWorld& reference = *worlds[ROLLBACK_PLAYERS];
+    for (uint64_t tick = 0; tick < gameTicks; ++tick) {
+        const InputState inputs[ROLLBACK_PLAYERS] = { unpackInput(keys[0][tick]), unpackInput(keys[1][tick]) };
+        reference.step(SIM_DT, inputs, ROLLBACK_PLAYERS);
+    }
+    const uint64_t expected = worldChecksum(reference);
+    const bool converged = worldChecksum(*worlds[0]) == expected && worldChecksum(*worlds[1]) == expected;
+    const RollbackStats& stats = peers[0].stats;
+
+    char line[768];
+    std::snprintf(line, sizeof(line),
+                  "{\"benchmark\":\"rollback\",\"scenario\":\"%s\",\"asteroids\":%zu,\"resimulate_ticks\":%d,\"resimulate_us\":%.1f,"
+                  "\"per_tick_us\":%.1f,\"share_of_60hz_frame\":%.3f,\"peer_ticks\":%llu,\"predicted_ticks\":%llu,\"rollbacks\":%llu,"
+                  "\"resimulated_ticks\":%llu,\"deepest_rollback\":%d,\"stalls\":%llu,\"converged\":%s}",
+                  activeScenario.name.c_str(), rocks, ROLLBACK_MAX_TICKS, resimulateNs / 1000.0, resimulateNs / ROLLBACK_MAX_TICKS / 1000.0,
+                  resimulateNs / (1e9 / 60.0), static_cast<unsigned long long>(gameTicks),
+                  static_cast<unsigned long long>(stats.predictedTicks), static_cast<unsigned long long>(stats.rollbacks),
+                  static_cast<unsigned long long>(stats.resimulatedTicks), stats.deepestRollback,
+                  static_cast<unsigned long long>(stats.stalls), converged ? "true" : "false");
+    if (!converged) LOG_ERROR("Rollback peers did not converge on the reference world");
+    return line;
+}
+
+// ============================ ARENA BENCHMARK ============================
+// The scrolling arena (arena.h) at growing sizes, the same rock density in each: a tick (the ship
+// spinning and firing, as headless mode flies it) against capturing the camera's view. The tick grows
+// with the arena's rocks (the ones in distant chunks only on their turns); the capture only with
+// what is in view, so it should stay flat.
+static std::string runArenaBenchmark(int chunksPerSide, int distantInterval, long long ticks, double minSeconds, uint64_t seed) {
+    ArenaConfig config;
+    config.chunksX = config.chunksY = chunksPerSide;
+    if (distantInterval > 0) config.distantInterval = distantInterval;
+    initArena(arena, config, seed, MAX_BULLETS);
+    InputState input;
+    input.left = true;
+    input.fire = true;
+    input.shield = true;
+
+    uint64_t migrations = 0, regionMigrations = 0, rocksMoved = 0;
+    long long played = 0;
+    const Clock::time_point start = Clock::now();
+    for (; played < ticks && !arena.isGameOver; ++played) {
+        stepArena(arena, SIM_DT, input);
+        migrations += arena.stats.migrations;
+        regionMigrations += arena.stats.regionMigrations;
+        rocksMoved += arena.stats.rocksMoved;
+    }
+    const double tickNs = played > 0 ? std::chrono::duration<double>(Clock::now() - start).count() * 1e9 / played : 0.0;
+
+    AsteroidStore rocks;
+    BulletStore bullets;
+    Ship ship;
+    rocks.reserve(static_cast<size_t>(simulationLimits.asteroidPoolCapacity())); // As a render snapshot is
+    bullets.reserve(MAX_BULLETS);
+    const double captureNs = timePerCall(minSeconds, [&] { captureArenaView(arena, rocks, bullets, ship); });
+
+    char line[768];
+    std::snprintf(line, sizeof(line),
+                  "{\"benchmark\":\"arena\",\"chunks_per_side\":%d,\"rocks\":%zu,\"ticks\":%lld,\"tick_us\":%.1f,\"capture_us\":%.2f,"
+                  "\"visible_chunks\":%zu,\"visible_rocks\":%zu,\"migrations_per_tick\":%.2f,\"regions\":%zu,"
+                  "\"region_migrations_per_tick\":%.2f,\"distant_interval\":%d,"
+                  "\"active_chunks\":%zu,\"distant_chunks\":%zu,\"rocks_moved_per_tick\":%.1f,\"arena_bytes\":%zu,\"game_over\":%s}",
+                  arena.config.chunksX, arena.rockCount, played, tickNs / 1000.0, captureNs / 1000.0, arena.stats.visibleChunks,
+                  arena.stats.visibleRocks, played > 0 ? static_cast<double>(migrations) / played : 0.0, arena.regions.size(),
+                  played > 0 ? static_cast<double>(regionMigrations) / played : 0.0, arena.config.distantInterval,
+                  arena.stats.activeChunks, arena.stats.distantChunks, played > 0 ? static_cast<double>(rocksMoved) / played : 0.0, arena.memoryBytes(),
+                  arena.isGameOver ? "true" : "false");
+    return line;
+}
+
+// The arena's rock field split over `nodeCount` nodes (arenanode.h), node 0 starting with half the
+// regions so the rebalancer has something to do, next to one arena moving the same field alone (no
+// ship: every chunk on the distant schedule). Reports the cluster's tick, its traffic and region
+// moves, each node's share, and whether it ended with the same rocks, bit for bit, as the single arena.
+typedef std::tuple<int, double, float, float, float, float, float, float, float, float> ArenaRockState;
+
+static void appendArenaRocks(const Arena& a, const std::vector<unsigned char>* ownedRegions, std::vector<ArenaRockState>& out) {
+    for (size_t r = 0; r < a.regions.size(); ++r) {
+        if (ownedRegions && !(*ownedRegions)[r]) continue;
+        for (int c = a.chunkIndex(0, a.regions[r].firstRow); c < a.chunkIndex(0, a.regions[r].endRow); ++c) {
+            const ArenaChunk& chunk = a.chunks[static_cast<size_t>(c)];
+            for (size_t i = 0; i < chunk.count(); ++i) {
+                out.emplace_back(c, chunk.movedAt, chunk.x[i], chunk.y[i], chunk.vx[i], chunk.vy[i], chunk.rot[i], chunk.px[i], chunk.py[i], chunk.prot[i]);
+            }
+        }
+    }
+}
+
+static std::string runArenaClusterBenchmark(int chunksPerSide, int nodeCount, int distantInterval, long long ticks, uint64_t seed) {
+    ArenaConfig config;
+    config.chunksX = config.chunksY = chunksPerSide;
+    if (distantInterval > 0) config.distantInterval = distantInterval;
+    initArena(arena, config, seed, 0);
+    const size_t regionCount = arena.regions.size();
+    std::vector<int> owners(regionCount);
+    const size_t half = nodeCount > 1 ? (regionCount + 1) / 2 : regionCount;
+    for (size_t r = 0; r < regionCount; ++r) {
+        owners[r] = r < half ? 0 : 1 + static_cast<int>((r - half) * static_cast<size_t>(nodeCount - 1) / (regionCount - half));
+    }
+    ArenaCluster cluster;
+    initArenaCluster(cluster, config, seed, nodeCount, owners);
+    const size_t rocks = arena.rockCount;
+
+    Clock::time_point start = Clock::now();
+    for (long long t = 0; t < ticks; ++t) {
+        advanceArenaClock(arena, SIM_DT);
+        moveArenaRegions(arena, nullptr);
+    }
+    const double singleNs = std::chrono::duration<double>(Clock::now() - start).count() * 1e9 / ticks;
+    start = Clock::now();
+    for (long long t = 0; t < ticks; ++t) stepArenaCluster(cluster, SIM_DT);
+    const double clusterNs = std::chrono::duration<double>(Clock::now() - start).count() * 1e9 / ticks;
+
+    std::vector<ArenaRockState> single, distributed;
+    appendArenaRocks(arena, nullptr, single);
+    uint64_t handoffs = 0, ghosts = 0, bytes = 0;
+    std::string regions = "[", tickUs = "[";
+    for (const std::unique_ptr<ArenaNode>& node : cluster.nodes) {
+        appendArenaRocks(node->arena, &node->ownedRegions, distributed);
+        handoffs += node->load.handoffsOut;
+        ghosts += node->load.ghostRocksOut;
+        bytes += node->load.bytesOut;
+        char field[64];
+        std::snprintf(field, sizeof(field), "%s%td", node->id > 0 ? "," : "", std::count(node->ownedRegions.begin(), node->ownedRegions.end(), 1));
+        regions += field;
+        std::snprintf(field, sizeof(field), "%s%.1f", node->id > 0 ? "," : "", node->load.ticks > 0 ? node->load.tickNs / 1000.0 / node->load.ticks : 0.0);
+        tickUs += field;
+    }
+    regions += "]";
+    tickUs += "]";
+    std::sort(single.begin(), single.end());
+    std::sort(distributed.begin(), distributed.end());
+    const bool conserved = arenaClusterRocks(cluster) == rocks && arena.rockCount == rocks;
+    const bool matches = single == distributed;
+    if (!conserved || !matches) LOG_ERROR("Arena cluster of %d nodes diverged from the single arena (%zu rocks against %zu)", nodeCount, arenaClusterRocks(cluster), arena.rockCount);
+    logArenaClusterReport(cluster);
+
+    std::string line(1024 + regions.size() + tickUs.size(), '\0');
+    const int length = std::snprintf(line.data(), line.size(),
+                  "{\"benchmark\":\"arena_nodes\",\"chunks_per_side\":%d,\"nodes\":%zu,\"regions\":%zu,\"rocks\":%zu,\"ticks\":%lld,"
+                  "\"tick_us\":%.1f,\"single_tick_us\":%.1f,\"handoffs_per_tick\":%.2f,\"ghost_rocks_per_tick\":%.1f,\"bytes_per_tick\":%.0f,"
+                  "\"region_moves\":%llu,\"node_regions\":%s,\"node_tick_us\":%s,\"conserved\":%s,\"matches_single\":%s}",
+                  arena.config.chunksX, cluster.nodes.size(), regionCount, rocks, ticks, clusterNs / 1000.0, singleNs / 1000.0,
+                  static_cast<double>(handoffs) / ticks, static_cast<double>(ghosts) / ticks, static_cast<double>(bytes) / ticks,
+                  static_cast<unsigned long long>(cluster.regionMoves), regions.c_str(), tickUs.c_str(),
+                  conserved ? "true" : "false", matches ? "true" : "false");
+    line.resize(static_cast<size_t>(std::max(length, 0)));
+    return line;
+}
+
+// ============================ BACKEND COMPARISON ============================
+// Every collision backend over the same ticks: the scenario is recorded with the grid, a snapshot
+// saved at BACKEND_SAMPLES points along it, and each backend restored to each and stepped on from
+// there. From each sample, BACKEND_CHECKED_TICKS ticks in a row are checked (every backend stepping
+// once from the same state, which then moves on by a grid tick), so they take in a volley from a
+// ship that fires at its fastest. Each is checked against brute force (every rock pair, every bullet
+// against every rock), which finds what the narrow tests alone say: the bullet hits, the rock pairs
+// and the ship contacts, as sets (each backend finds them in its own order). The kinetic schedule
+// predicts against circles, so its bullet hits are held to a brute-force tick with circle hits,
+// leaving out the rocks that wrap, bounce or are spawned in that tick: the search follows them from
+// where they were (or holds them still), the schedule along their velocity as it is after the tick. Then BACKEND_TIMED_TICKS from each sample are timed. Candidates and
+// hits are per checked tick; memory_bytes is what the backend builds on top of the pair lists they
+// all share.
+const int BACKEND_SAMPLES = 4;
+const int BACKEND_CHECKED_TICKS = static_cast<int>(ticksFor(FIRE_RATE));
+const int BACKEND_TIMED_TICKS = 4; // Brute force on 10k colliding rocks takes half a second a tick
+
+struct CollisionBackend {
+    const char* name;
+    AsteroidBroadphase broadphase;
+    bool pairBatch;
+    bool kinetic;
+    const char* structures[3]; // Its memory report entries (collectMemory), NULL past the last
+};
+
+static const CollisionBackend COLLISION_BACKENDS[] = {
+    { "brute", BROADPHASE_BRUTE_FORCE, false, false, { NULL } }, // The reference: first
+    { "grid", BROADPHASE_GRID, false, false, { "asteroid grid", "bullet grids", NULL } },
+    { "sap", BROADPHASE_SWEEP_AND_PRUNE, false, false, { "asteroid sweep", "bullet grids", NULL } },
+    { "pair-batch", BROADPHASE_GRID, true, false, { "asteroid grid", "bullet grids", "bullet pair buffers" } },
+    { "kinetic", BROADPHASE_GRID, false, true, { "asteroid grid", "kinetic schedule", NULL } },
+};
+
+// This tick's hits as sorted keys: the kind in the top two bits, then its indices
+const uint64_t HIT_KEY_BULLET = 0, HIT_KEY_ROCK_PAIR = 1ull << 62, HIT_KEY_SHIP = 2ull << 62;
+
+static void collectHitKeys(const GameWorld& source, std::vector<uint64_t>& keys) {
+    keys.clear();
+    for (size_t list = 0; list < source.bulletHitLists; ++list) {
+        for (const BulletHit& hit : source.bulletHits[list]) {
+            keys.push_back(HIT_KEY_BULLET | (static_cast<uint64_t>(hit.rock) << 31) | static_cast<uint64_t>(hit.bullet));
+        }
+    }
+    for (size_t list = 0; list < source.asteroidPairLists; ++list) {
+        for (size_t k = 0; k < source.asteroidPairCounts[list]; ++k) {
+            const AsteroidPair& pair = source.asteroidPairs[list][k];
+            const uint64_t a = static_cast<uint64_t>(std::min(pair.a, pair.b)), b = static_cast<uint64_t>(std::max(pair.a, pair.b));
+            keys.push_back(HIT_KEY_ROCK_PAIR | (a << 31) | b);
+        }
+    }
+    for (const GameEvent& event : source.shipEvents) {
+        keys.push_back(HIT_KEY_SHIP | (static_cast<uint64_t>(event.ship) << 40) | (static_cast<uint64_t>(event.type) << 32) | static_cast<uint64_t>(event.rock));
+    }
+    std::sort(keys.begin(), keys.end());
+}
+
+// Drops the bullet hits on the given rocks (sorted) and on those from firstSpawned up
+static void dropBulletHits(std::vector<uint64_t>& keys, const std::vector<uint64_t>& rocks, uint64_t firstSpawned) {
+    std::erase_if(keys, [&](uint64_t key) {
+        return key < HIT_KEY_ROCK_PAIR && ((key >> 31) >= firstSpawned || std::binary_search(rocks.begin(), rocks.end(), key >> 31));
+    });
+}
+
+// Keys in one set but not the other
+static size_t hitKeyMismatches(const std::vector<uint64_t>& a, const std::vector<uint64_t>& b) {
+    size_t i = 0, j = 0, mismatches = 0;
+    while (i < a.size() || j < b.size()) {
+        if (j == b.size() || (i < a.size() && a[i] < b[j])) { ++mismatches; ++i; }
+        else if (i == a.size() || b[j] < a[i]) { ++mismatches; ++j; }
+        else { ++i; ++j; }
+    }
+    return mismatches;
+}
+
+// Runs the active scenario on the game's world (initialized) and writes one line per backend;
+// returns how many did not match the reference
+static int runBackendBenchmark(long long ticks, uint64_t seed, const char* outPath) {
+    const size_t capacity = worldSnapshotBytes(world.limits);
+    std::vector<unsigned char> sample(capacity), checked(capacity);
+    size_t sampleBytes = 0, checkedBytes = 0;
+    InputState input;
+    input.left = true; // As the headless run flies it
+    const std::vector<InputState> inputs(world.ships.count(), input);
+    const AsteroidBroadphase broadphase = world.asteroidBroadphase;
+    const bool kinetic = world.kineticBulletHits, pairBatch = world.pairBatchedHits, circles = !world.silhouetteHits;
+
+    // One backend from the checked state: restored, set up, and stepped once with the tick's top-ups.
+    // Rocks are only appended to before the hit search, so the indices of the ones that wrap in the
+    // tick, and of the first one spawned, can be taken before it.
+    std::vector<uint64_t> unpredicted;
+    uint64_t firstSpawned = 0;
+    auto stepFrom = [&](const std::vector<unsigned char>& state, size_t bytes, const CollisionBackend& backend, bool circleHits, uint64_t stream) {
+        restoreWorldSnapshot(world, state.data(), bytes);
+        unpredicted.clear();
+        for (size_t i = 0; i < world.asteroids.count(); ++i) {
+            const float x = world.asteroids.x[i] + world.asteroids.vx[i] * SIM_DT, y = world.asteroids.y[i] + world.asteroids.vy[i] * SIM_DT;
+            if (std::fabs(x) > 1.0f || std::fabs(y) > 1.0f) unpredicted.push_back(i);
+        }
+        firstSpawned = world.asteroids.count();
+        world.asteroidBroadphase = backend.broadphase;
+        world.pairBatchedHits = backend.pairBatch;
+        world.kineticBulletHits = backend.kinetic;
+        if (circleHits) world.silhouetteHits = false;
+        reseedScenario(stream);
+        world.step(SIM_DT, inputs.data(), inputs.size());
+    };
+
+    struct BackendTotals {
+        size_t hits = 0, mismatches = 0, bulletCandidates = 0, rockCandidates = 0, shipCandidates = 0;
+        double tickNs = 0.0;
+    };
+    const size_t backendCount = std::size(COLLISION_BACKENDS);
+    std::vector<BackendTotals> totals(backendCount);
+    std::vector<uint64_t> reference, circleReference, expected, keys;
+    long long recorded = 0;
+    for (int s = 0; s < BACKEND_SAMPLES; ++s) {
+        world.asteroidBroadphase = BROADPHASE_GRID;
+        world.kineticBulletHits = world.pairBatchedHits = false;
+        for (; recorded < ticks * (s + 1) / BACKEND_SAMPLES; ++recorded) world.step(SIM_DT, inputs.data(), inputs.size());
+        sampleBytes = saveWorldSnapshot(world, sample.data(), capacity);
+        checked = sample;
+        checkedBytes = sampleBytes;
+
+        for (int c = 0; c < BACKEND_CHECKED_TICKS; ++c) {
+            const uint64_t stream = seed + static_cast<uint64_t>(s * BACKEND_CHECKED_TICKS + c);
+            if (!circles) {
+                stepFrom(checked, checkedBytes, COLLISION_BACKENDS[0], true, stream);
+                collectHitKeys(world, circleReference);
+            }
+            for (size_t b = 0; b < backendCount; ++b) {
+                const CollisionBackend& backend = COLLISION_BACKENDS[b];
+                BackendTotals& total = totals[b];
+                stepFrom(checked, checkedBytes, backend, false, stream);
+                total.bulletCandidates += world.bulletCandidates;
+                total.rockCandidates += world.asteroidCandidates;
+                total.shipCandidates += world.shipCandidates;
+                collectHitKeys(world, keys);
+                total.hits += keys.size();
+                if (b == 0) reference = keys;
+                else if (backend.kinetic) {
+                    // The circle reference's bullet hits, with the rock pairs and ship contacts of the one it runs with
+                    expected.clear();
+                    for (uint64_t key : circles ? reference : circleReference) if (key < HIT_KEY_ROCK_PAIR) expected.push_back(key);
+                    for (uint64_t key : reference) {
+                        if (key < HIT_KEY_ROCK_PAIR || key >= HIT_KEY_SHIP) continue;
+                        expected.push_back(key);
+                        unpredicted.push_back((key >> 31) & 0x7FFFFFFF); // Bounced
+                        unpredicted.push_back(key & 0x7FFFFFFF);
+                    }
+                    for (uint64_t key : reference) if (key >= HIT_KEY_SHIP) expected.push_back(key);
+                    std::sort(unpredicted.begin(), unpredicted.end());
+                    dropBulletHits(expected, unpredicted, firstSpawned);
+                    dropBulletHits(keys, unpredicted, firstSpawned);
+                    total.mismatches += hitKeyMismatches(keys, expected);
+                }
+                else total.mismatches += hitKeyMismatches(keys, reference);
+            }
+            // On by a grid tick, as recorded
+            stepFrom(checked, checkedBytes, COLLISION_BACKENDS[1], false, stream);
+            checkedBytes = saveWorldSnapshot(world, checked.data(), capacity);
+        }
+
+        for (size_t b = 0; b < backendCount; ++b) {
+            stepFrom(sample, sampleBytes, COLLISION_BACKENDS[b], false, seed + static_cast<uint64_t>(s));
+            const Clock::time_point start = Clock::now();
+            for (int tick = 0; tick < BACKEND_TIMED_TICKS; ++tick) world.step(SIM_DT, inputs.data(), inputs.size());
+            totals[b].tickNs += std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        }
+        restoreWorldSnapshot(world, sample.data(), sampleBytes); // The recording goes on from the sample
+    }
+
+    MemoryReport memory;
+    world.collectMemory(memory);
+    const double checks = BACKEND_SAMPLES * BACKEND_CHECKED_TICKS;
+    int failures = 0;
+    for (size_t b = 0; b < backendCount; ++b) {
+        const CollisionBackend& backend = COLLISION_BACKENDS[b];
+        const BackendTotals& total = totals[b];
+        size_t memoryBytes = 0;
+        for (const MemoryEntry& entry : memory.entries) {
+            for (const char* structure : backend.structures) {
+                if (structure && std::strcmp(entry.name, structure) == 0) memoryBytes += entry.bytes;
+            }
+        }
+        char line[768];
+        std::snprintf(line, sizeof(line),
+                      "{\"benchmark\":\"backends\",\"scenario\":\"%s\",\"backend\":\"%s\",\"asteroids\":%zu,\"tick_us\":%.1f,"
+                      "\"bullet_candidates\":%.0f,\"rock_candidates\":%.0f,\"ship_candidates\":%.0f,\"memory_bytes\":%zu,"
+                      "\"hits\":%.1f,\"mismatches\":%zu,\"matches_reference\":%s}",
+                      activeScenario.name.c_str(), backend.name, world.asteroids.count(), total.tickNs / (BACKEND_SAMPLES * BACKEND_TIMED_TICKS) / 1000.0,
+                      total.bulletCandidates / checks, total.rockCandidates / checks, total.shipCandidates / checks, memoryBytes,
+                      total.hits / checks, total.mismatches, total.mismatches == 0 ? "true" : "false");
+        if (total.mismatches != 0) {
+            LOG_ERROR("Backend %s disagreed with brute force on %zu hits in %s", backend.name, total.mismatches, activeScenario.name.c_str());
+            ++failures;
+        }
+        writeScenarioResult(outPath, line);
+    }
+    world.asteroidBroadphase = broadphase;
+    world.kineticBulletHits = kinetic;
+    world.pairBatchedHits = pairBatch;
+    world.silhouetteHits = !circles;
+    return failures;
+}
+
+// ============================ GRAVITY BENCHMARK ============================
+// The Barnes-Hut pass (GravityTree) against direct summation over the same bodies: `bodies` of equal
+// mass scattered over the field, every one of them pulled by all the others. Times the tree's build
+// and one pull per body through it, then the same pull summed over every body on its own, both spread
+// over the job system as the world's pass is; the error is the tree's pull against the direct one's,
+// as an RMS over the bodies relative to the RMS pull, and at the worst body relative to its own.
+// The tree is walked at every size, also below GRAVITY_DIRECT_BODIES, where the world sums directly.
+static std::string runGravityBenchmark(size_t bodies, float theta, double minSeconds, uint64_t seed) {
+    Rng rng;
+    rng.seed(seed, RNG_STREAM_VALIDATION);
+    std::vector<float> x(bodies), y(bodies), mass(bodies, 1.0f);
+    for (size_t i = 0; i < bodies; ++i) {
+        x[i] = rng.range(-1.0f, 1.0f);
+        y[i] = rng.range(-1.0f, 1.0f);
+    }
+    GravityTree tree;
+    tree.init(bodies);
+    std::vector<glm::vec2> approximate(bodies), exact(bodies);
+    std::vector<size_t> interactions(bodies);
+    const double buildNs = timePerCall(minSeconds, [&] { tree.build(x.data(), y.data(), mass.data(), bodies); });
+    const double treeNs = timePerCall(minSeconds, [&] {
+        parallelFor(0, bodies, GRAVITY_GRAIN, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                interactions[i] = 0;
+                approximate[i] = tree.field(x[i], y[i], static_cast<int>(i), theta, &interactions[i]);
+            }
+        });
+    });
+    const double directNs = timePerCall(minSeconds, [&] {
+        parallelFor(0, bodies, GRAVITY_GRAIN, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) exact[i] = tree.fieldDirect(x[i], y[i], static_cast<int>(i));
+        });
+    });
+
+    double errorSq = 0.0, pullSq = 0.0, worst = 0.0, summed = 0.0;
+    for (size_t i = 0; i < bodies; ++i) {
+        const glm::vec2 difference = approximate[i] - exact[i];
+        const double error = glm::dot(difference, difference), pull = glm::dot(exact[i], exact[i]);
+        errorSq += error;
+        pullSq += pull;
+        if (pull > 0.0) worst = std::max(worst, std::sqrt(error / pull));
+        summed += static_cast<double>(interactions[i]);
+    }
+    char line[512];
+    std::snprintf(line, sizeof(line),
+                  "{\"benchmark\":\"gravity\",\"bodies\":%zu,\"theta\":%.2f,\"cells\":%zu,\"build_us\":%.1f,\"tree_us\":%.1f,"
+                  "\"direct_us\":%.1f,\"speedup\":%.1f,\"interactions_per_body\":%.1f,\"rms_error\":%.2e,\"max_error\":%.2e}",
+                  bodies, theta, tree.cells.size(), buildNs / 1000.0, treeNs / 1000.0, directNs / 1000.0,
+                  directNs / std::max(buildNs + treeNs, 1.0), summed / std::max<size_t>(bodies, 1),
+                  pullSq > 0.0 ? std::sqrt(errorSq / pullSq) : 0.0, worst);
+    return line;
+}
+
+// ============================ STRESS BENCHMARK ============================
+// Headless scaling benchmark: runs every scenario preset (or the ones named with --scenario) for a
+// fixed number of ticks and prints one JSON line per scenario. The rendered counterpart is the game
+// itself with --scenario NAME (frame percentiles, draw calls and upload bytes per frame).
+//
+// --scenario NAME: run only this preset (repeatable); --ticks N: ticks per scenario (default 600)
+// --out FILE: append the results to FILE instead of printing them; --seed N: random streams (default 1)
+// --micro [FILTER]: run the CPU rasterizer microbenchmarks instead (only the cases whose name contains
+// FILTER, if given); --min-time S: minimum seconds per microbenchmark case (default 0.2)
+// --jobs N: job system workers for the scenarios (default: one per core but one; 0: single-threaded)
+// --broadphase grid|sap|brute: the asteroid broadphase the scenarios run with (default grid)
+// --kinetic: bullet hits from the kinetic schedule instead of the per-tick search
+// --lazy-rocks: rock positions from their motion anchors instead of per-tick integration
+// --circle-hits: ship and bullet hits against the rocks' circles instead of their outlines
+// --pair-batch: bullet hits searched by gathering every candidate pair into one buffer per chunk of
+// rocks, then testing it in one SIMD pass (the results' bullet_pairs and pair_hit_ratio)
+// --sort-rocks: re-sort the rocks into Z-order of their grid cells every ASTEROID_SORT_TICKS (compare
+// the results' collision_ms with and without)
+// --waves: the wave script spawns rocks alongside the scenario's (--snapshot then checks it is restored too)
+// --waves-file FILE: the same with a compiled wave file's script (waves.h) instead of the built-in one
+// --shed-budget MS: load shedding against a per-tick budget (loadshed.h); the results' rocks_shed
+// counts what it turned away (not with --snapshot or --rollback)
+// --fixed-point: Q16.16 kinematics instead of float (overrides --lazy-rocks); --micro's integrate/
+// and heading/ cases compare the two kernels alone
+// --snapshot: after each scenario's ticks, time saving and restoring the whole world (default
+// scenario "10k") and check that a restored world replays exactly; --min-time applies per timing
+// --rollback: after each scenario's ticks, time the worst rollback (ROLLBACK_MAX_TICKS resimulated,
+// default scenario "10k"), then check that two peers on a lagging link converge
+// --backends: run each collision backend (brute force, grid, sap, pair-batch, kinetic) over the same
+// samples of the scenario's --ticks and check every one's hits against brute force's (default
+// scenarios "1k", "10k-bounce", "10k-bullets" and "100k"); one line per backend
+// --ships N: ships in every scenario (default 1), all flying the same keys, with N times the ship bullets
+// --weapon blaster|spread|burst|missiles: what the ships fire (default blaster); the ring grows to hold
+// their volleys (missiles not with --fixed-point or --kinetic)
+// --bots: the ships after the first fly themselves (bots.h); the log line gives their thinking time
+// --large-pages: entity arrays of 2 MiB and up on large pages (entitymemory.h); compare the big
+// scenarios' tick times with and without
+// --arena [N]: time the scrolling arena's tick and view capture at 4, 16, 64 and 256 chunks per side
+// (or only N) for --ticks ticks, instead of the scenarios; --arena-interval N: ticks between moves
+// of the chunks out of the ship's reach (default ArenaConfig's; 1 moves every chunk every tick)
+// --arena-nodes N: with --arena, split the arena's rock field over N nodes (node 0 starting with half
+// the regions) and time it against one arena moving the same field, checking they end identical
+// --gravity off|wells|rocks|both: the scenarios' rocks pulled by the wells and/or the large rocks
+// (not with --lazy-rocks, --fixed-point or --kinetic); --gravity-theta T: the tree's opening angle
+// --nbody [N]: time the Barnes-Hut pull against direct summation over 1000 and 10000 bodies (or only
+// N), at opening angles 0.3, 0.5 and 0.8 (or only --gravity-theta's), instead of the scenarios
+int main(int argc, char** argv)
+{
+    startLogger();
+    std::vector<std::string> names;
+    long long ticks = 600;
+    const char* outPath = NULL;
+    uint64_t seed = 1; // Fixed, so successive runs measure the same field
+    bool micro = false;
+    const char* microFilter = NULL;
+    double minSeconds = 0.2;
+    int jobWorkers = -1;
+    bool snapshot = false;
+    bool rollback = false;
+    bool backends = false;
+    int ships = 1;
+    bool botShips = false;
+    bool largePages = false;
+    bool arenaBenchmark = false;
+    int arenaSize = 0;
+    int arenaInterval = 0; // ArenaConfig's
+    int arenaNodes = 0; // 0: the single arena with its ship
+    bool nbody = false;
+    size_t nbodyBodies = 0; // 0: 1000 and 10000
+    bool thetaGiven = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--scenario") == 0 && i + 1 < argc) names.push_back(argv[++i]);
+        else if (std::strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) ticks = std::max(1LL, std::atoll(argv[++i]));
+        else if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc) outPath = argv[++i];
+        else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = std::strtoull(argv[++i], NULL, 10);
+        else if (std::strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) minSeconds = std::max(0.001, std::atof(argv[++i]));
+        else if (std::strcmp(argv[i], "--micro") == 0) {
+            micro = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') microFilter = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--broadphase") == 0 && i + 1 < argc) {
+            world.asteroidBroadphase = BROADPHASE_GRID;
+            if (!parseBroadphase(argv[++i], world.asteroidBroadphase)) LOG_WARN("Unknown broadphase %s, using the grid", argv[i]);
+        }
+        else if (std::strcmp(argv[i], "--kinetic") == 0) world.kineticBulletHits = true;
+        else if (std::strcmp(argv[i], "--lazy-rocks") == 0) world.lazyAsteroidMotion = true;
+        else if (std::strcmp(argv[i], "--circle-hits") == 0) world.silhouetteHits = false;
+        else if (std::strcmp(argv[i], "--pair-batch") == 0) world.pairBatchedHits = true;
+        else if (std::strcmp(argv[i], "--sort-rocks") == 0) world.spatialSortAsteroids = true;
+        else if (std::strcmp(argv[i], "--waves") == 0) world.scriptedWaves = true;
+        else if (std::strcmp(argv[i], "--shed-budget") == 0 && i + 1 < argc) shedBudgetMs = std::max(0.0f, static_cast<float>(std::atof(argv[++i])));
+        else if (std::strcmp(argv[i], "--waves-file") == 0 && i + 1 < argc) {
+            if (!loadWaveFile(argv[++i])) return 1;
+            world.scriptedWaves = true;
+        }
+        else if (std::strcmp(argv[i], "--fixed-point") == 0) world.fixedPointKinematics = true;
+        else if (std::strcmp(argv[i], "--weapon") == 0 && i + 1 < argc) {
+            if (!parseWeapon(argv[++i], world.weapon)) LOG_WARN("Unknown weapon %s, using the blaster", argv[i]);
+        }
+        else if (std::strcmp(argv[i], "--snapshot") == 0) snapshot = true;
+        else if (std::strcmp(argv[i], "--rollback") == 0) rollback = true;
+        else if (std::strcmp(argv[i], "--backends") == 0) backends = true;
+        else if (std::strcmp(argv[i], "--arena") == 0) {
+            arenaBenchmark = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') arenaSize = std::max(ARENA_MIN_CHUNKS, std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--arena-interval") == 0 && i + 1 < argc) arenaInterval = std::max(1, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--arena-nodes") == 0 && i + 1 < argc) arenaNodes = std::clamp(std::atoi(argv[++i]), 1, ARENA_MAX_NODES);
+        else if (std::strcmp(argv[i], "--large-pages") == 0) largePages = true;
+        else if (std::strcmp(argv[i], "--ships") == 0 && i + 1 < argc) ships = std::max(1, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--bots") == 0) botShips = true;
+        else if (std::strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) jobWorkers = std::max(0, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--gravity") == 0 && i + 1 < argc) {
+            world.gravityWells = world.rockGravity = false;
+            if (!parseGravity(argv[++i], world.gravityWells, world.rockGravity)) LOG_WARN("Unknown gravity %s, running without", argv[i]);
+        }
+        else if (std::strcmp(argv[i], "--gravity-theta") == 0 && i + 1 < argc) {
+            world.gravityTheta = gravityThetaFrom(static_cast<float>(std::atof(argv[++i])));
+            thetaGiven = true;
+        }
+        else if (std::strcmp(argv[i], "--nbody") == 0) {
+            nbody = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') nbodyBodies = static_cast<size_t>(std::max(2, std::atoi(argv[++i])));
+        }
+    }
+    if (micro) {
+        seedRandomStreams(seed); // The asteroid generator draws from the shape stream
+        return runRasterBenchmarks(microFilter, minSeconds, outPath) > 0 ? 0 : 1;
+    }
+    if (world.fixedPointKinematics && world.lazyAsteroidMotion) {
+        LOG_WARN("--lazy-rocks keeps its anchors in floating point; ignored with --fixed-point");
+        world.lazyAsteroidMotion = false;
+    }
+    if ((world.gravityWells || world.rockGravity) && (world.lazyAsteroidMotion || world.fixedPointKinematics || world.kineticBulletHits)) {
+        LOG_WARN("--gravity curves the rocks' paths, which --lazy-rocks, --fixed-point and --kinetic take as straight; ignored");
+        world.gravityWells = world.rockGravity = false;
+    }
+    if (WEAPON_TRAITS[world.weapon].homing && (world.fixedPointKinematics || world.kineticBulletHits)) {
+        LOG_WARN("Missiles steer in floating point along curves, which --fixed-point and --kinetic do not follow; using the blaster");
+        world.weapon = WEAPON_BLASTER;
+    }
+    if (shedBudgetMs > 0.0f && (snapshot || rollback)) {
+        LOG_WARN("--shed-budget caps the rocks from outside the world, so not with --snapshot or --rollback; ignored");
+        shedBudgetMs = 0.0f;
+    }
+    setEntityLargePages(largePages);
+    startJobSystem(jobWorkers);
+    if (nbody) {
+        std::vector<size_t> counts = { 1000, 10000 };
+        if (nbodyBodies > 0) counts = { nbodyBodies };
+        std::vector<float> thetas = { 0.3f, 0.5f, 0.8f };
+        if (thetaGiven) thetas = { world.gravityTheta };
+        for (size_t bodies : counts) {
+            for (float theta : thetas) writeScenarioResult(outPath, runGravityBenchmark(bodies, theta, minSeconds, seed));
+        }
+        return 0;
+    }
+    if (arenaBenchmark) {
+        seedRandomStreams(seed);
+        std::vector<float> atlasVertices; // The rocks draw shape indices
+        generateAsteroidShapes(atlasVertices);
+        const int sizes[] = { 4, 16, 64, 256 };
+        const auto runSize = [&](int size) {
+            writeScenarioResult(outPath, arenaNodes > 0 ? runArenaClusterBenchmark(size, arenaNodes, arenaInterval, ticks, seed)
+                                                        : runArenaBenchmark(size, arenaInterval, ticks, minSeconds, seed));
+        };
+        for (int size : sizes) {
+            if (arenaSize == 0 || arenaSize == size) runSize(size);
+        }
+        if (arenaSize != 0 && std::find(std::begin(sizes), std::end(sizes), arenaSize) == std::end(sizes)) runSize(arenaSize);
+        return 0;
+    }
+    if (names.empty() && (snapshot || rollback)) names.push_back("10k");
+    if (names.empty() && backends) names = { "1k", "10k-bounce", "10k-bullets", "100k" };
+    if (names.empty()) {
+        int count = 0;
+        const char* const* presets = scenarioPresetNames(count);
+        names.assign(presets, presets + count);
+    }
+
+    std::vector<float> atlasVertices; // Shapes are still needed for the asteroid shape indices
+    int failures = 0;
+    for (const std::string& name : names) {
+        Scenario scenario;
+        if (!findScenario(name, scenario)) {
+            LOG_ERROR("Unknown scenario %s", name.c_str());
+            ++failures;
+            continue;
+        }
+        seedRandomStreams(seed);
+        atlasVertices.clear();
+        generateAsteroidShapes(atlasVertices);
+        world.reset();
+        world.seed(seed);
+        applyScenario(scenario);
+        simulationLimits.ships = ships;
+        simulationLimits.maxBullets += ships * maxBulletsFor(world.weapon) - MAX_BULLETS;
+        world.init(simulationLimits);
+        botCount = botShips ? static_cast<size_t>(ships - 1) : 0;
+        if (botCount > 0) bots.init(simulationLimits);
+        if (backends) {
+            failures += runBackendBenchmark(ticks, seed, outPath);
+            continue;
+        }
+        const std::string result = runScenarioHeadless(ticks); // With --snapshot or --rollback, only what fills the field
+        if (snapshot) writeScenarioResult(outPath, runSnapshotBenchmark(minSeconds));
+        if (rollback) writeScenarioResult(outPath, runRollbackBenchmark(minSeconds, seed));
+        if (!snapshot && !rollback) writeScenarioResult(outPath, result);
+    }
+    return failures == 0 ? 0 : 1;
+}
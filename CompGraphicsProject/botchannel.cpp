@@ -0,0 +1,226 @@
+#include "botchannel.h"
+#include "log.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <thread>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// The layout agents outside C++ map by hand
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+              "The counters are shared across processes, so they must not hide a lock");
+static_assert(offsetof(BotChannelLayout, observed) == 64 && offsetof(BotChannelLayout, acted) == 128 &&
+              offsetof(BotChannelLayout, closed) == 192 && offsetof(BotChannelLayout, attached) == 196 &&
+              offsetof(BotChannelLayout, inputs) == 256 && offsetof(BotChannelLayout, observations) == 256 + BOT_CHANNEL_SLOTS,
+              "BotChannelLayout offsets are part of the channel format");
+static_assert(offsetof(BotChannelObservation, step) == 8 && offsetof(BotChannelObservation, score) == 16 &&
+              offsetof(BotChannelObservation, reward) == 20 && offsetof(BotChannelObservation, done) == 24 &&
+              offsetof(BotChannelObservation, observation) == 28 && sizeof(BotChannelObservation) == 256,
+              "BotChannelObservation offsets are part of the channel format");
+
+// Spins on `ready`, then yields between checks; gives up once `peerClosed` is set and still not ready
+template <typename Ready>
+static bool waitUntil(const BotChannelLayout& layout, uint32_t peerClosed, Ready&& ready) {
+    for (int spins = 0; !ready(); ++spins) {
+        if (layout.closed.load(std::memory_order_acquire) & peerClosed) return ready();
+        if (spins >= BOT_CHANNEL_WAIT_SPINS) std::this_thread::yield();
+    }
+    return true;
+}
+
+// ============================ MAPPING ============================
+static std::string systemName(const char* channel) {
+#if defined(_WIN32)
+    return std::string("Local\\asteroids-bot-") + channel;
+#else
+    return std::string("/asteroids-bot-") + channel;
+#endif
+}
+
+// Maps the block, creating it (zero-filled) when `create`; nullptr if that fails
+static BotChannelLayout* mapLayout(BotChannel& channel, bool create) {
+    const size_t bytes = sizeof(BotChannelLayout);
+#if defined(_WIN32)
+    if (create) {
+        channel.mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, static_cast<DWORD>(bytes), channel.name.c_str());
+        if (channel.mapping && GetLastError() == ERROR_ALREADY_EXISTS) {
+            CloseHandle(channel.mapping);
+            channel.mapping = nullptr;
+        }
+    }
+    else channel.mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, channel.name.c_str());
+    if (!channel.mapping) return nullptr;
+    void* view = MapViewOfFile(channel.mapping, FILE_MAP_ALL_ACCESS, 0, 0, bytes);
+    return static_cast<BotChannelLayout*>(view);
+#else
+    int fd = shm_open(channel.name.c_str(), create ? O_RDWR | O_CREAT | O_EXCL : O_RDWR, 0600);
+    if (fd < 0 && create && errno == EEXIST) {
+        // Left behind by a game that did not close it; a live one would still be polling it, but
+        // two games on one name is a setup error either way
+        LOG_WARN("Bot channel %s already exists; replacing it", channel.name.c_str());
+        shm_unlink(channel.name.c_str());
+        fd = shm_open(channel.name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    }
+    if (fd < 0) return nullptr;
+    struct stat info;
+    if ((create && ftruncate(fd, static_cast<off_t>(bytes)) != 0) || fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < bytes) {
+        ::close(fd);
+        return nullptr;
+    }
+    void* view = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd); // The mapping keeps the object
+    return view == MAP_FAILED ? nullptr : static_cast<BotChannelLayout*>(view);
+#endif
+}
+
+bool BotChannel::create(const char* channel) {
+    close();
+    name = systemName(channel);
+    layout = mapLayout(*this, true);
+    if (!layout) {
+        LOG_ERROR("Could not create bot channel %s", name.c_str());
+        close();
+        return false;
+    }
+    owner = true;
+    new (layout) BotChannelLayout();
+    layout->version = BOT_CHANNEL_VERSION;
+    layout->slots = BOT_CHANNEL_SLOTS;
+    layout->observationFloats = BATCH_OBSERVATION_SIZE;
+    layout->magic.store(BOT_CHANNEL_MAGIC, std::memory_order_release);
+    return true;
+}
+
+bool BotChannel::attach(const char* channel) {
+    close();
+    name = systemName(channel);
+    layout = mapLayout(*this, false);
+    if (!layout || layout->magic.load(std::memory_order_acquire) != BOT_CHANNEL_MAGIC) {
+        close();
+        return false;
+    }
+    if (layout->version != BOT_CHANNEL_VERSION || layout->slots != BOT_CHANNEL_SLOTS || layout->observationFloats != BATCH_OBSERVATION_SIZE) {
+        LOG_ERROR("Bot channel %s is version %u with %u slots of %u floats; this build speaks version %u", name.c_str(),
+                  layout->version, layout->slots, layout->observationFloats, BOT_CHANNEL_VERSION);
+        close();
+        return false;
+    }
+    layout->attached.store(1, std::memory_order_release);
+    return true;
+}
+
+void BotChannel::close() {
+    if (layout) {
+        layout->closed.fetch_or(owner ? BOT_CHANNEL_GAME_CLOSED : BOT_CHANNEL_AGENT_CLOSED, std::memory_order_release);
+#if defined(_WIN32)
+        UnmapViewOfFile(layout);
+#else
+        munmap(layout, sizeof(BotChannelLayout));
+        if (owner) shm_unlink(name.c_str()); // The agent keeps its mapping until it closes too
+#endif
+    }
+#if defined(_WIN32)
+    if (mapping) CloseHandle(mapping);
+    mapping = nullptr;
+#endif
+    layout = nullptr;
+    owner = false;
+}
+
+// ============================ GAME SIDE ============================
+void BotChannel::publish(const GameWorld& source, uint64_t step, float reward, bool done) {
+    BotChannelObservation& slot = layout->observations[step % BOT_CHANNEL_SLOTS];
+    slot.sequence.store(2 * step + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release); // The odd number lands before any of the new fields
+    slot.step = step;
+    slot.score = source.score;
+    slot.reward = reward;
+    slot.done = done ? 1 : 0;
+    writeObservation(source, slot.observation);
+    slot.sequence.store(2 * step + 2, std::memory_order_release);
+    layout->observed.store(step + 1, std::memory_order_release);
+}
+
+bool BotChannel::waitInput(uint64_t step, uint8_t& bits) {
+    if (!waitUntil(*layout, BOT_CHANNEL_AGENT_CLOSED, [&] { return layout->acted.load(std::memory_order_acquire) > step; })) return false;
+    bits = layout->inputs[step % BOT_CHANNEL_SLOTS];
+    return true;
+}
+
+// ============================ AGENT SIDE ============================
+const BotChannelObservation* BotChannel::waitObservation(uint64_t step) {
+    if (!waitUntil(*layout, BOT_CHANNEL_GAME_CLOSED, [&] { return layout->observed.load(std::memory_order_acquire) > step; })) return nullptr;
+    const BotChannelObservation& slot = layout->observations[step % BOT_CHANNEL_SLOTS];
+    return slot.sequence.load(std::memory_order_acquire) == 2 * step + 2 ? &slot : nullptr;
+}
+
+bool BotChannel::observationIntact(const BotChannelObservation& slot, uint64_t step) const {
+    std::atomic_thread_fence(std::memory_order_acquire); // The reads of the fields before the recheck
+    return slot.sequence.load(std::memory_order_relaxed) == 2 * step + 2;
+}
+
+bool BotChannel::submitInput(uint64_t step, uint8_t bits) {
+    if (layout->acted.load(std::memory_order_relaxed) != step) return false; // Out of order
+    // The slot last held step - BOT_CHANNEL_SLOTS's input, which the game is done with once it has
+    // published the observation after it
+    if (!waitUntil(*layout, BOT_CHANNEL_GAME_CLOSED,
+                   [&] { return step + 1 < layout->observed.load(std::memory_order_acquire) + BOT_CHANNEL_SLOTS; })) {
+        return false;
+    }
+    layout->inputs[step % BOT_CHANNEL_SLOTS] = bits;
+    layout->acted.store(step + 1, std::memory_order_release);
+    return true;
+}
+
+// ============================ REFERENCE AGENT ============================
+int runBotAgent(const char* channelName, long long steps) {
+    BotChannel channel;
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point deadline = Clock::now() + std::chrono::seconds(10);
+    while (!channel.attach(channelName)) {
+        if (Clock::now() >= deadline) {
+            LOG_ERROR("No game on bot channel %s", channelName);
+            return 1;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    LOG_INFO("[bot agent] Attached to %s", channel.name.c_str());
+
+    InputState policy; // Same as the headless run
+    policy.left = true;
+    policy.fire = true;
+    policy.shield = true;
+    const uint8_t bits = packInput(policy);
+
+    long long episodes = 0;
+    double totalReward = 0.0;
+    uint64_t step = 0;
+    Clock::time_point start = Clock::now();
+    for (; static_cast<long long>(step) < steps; ++step) {
+        const BotChannelObservation* observation = channel.waitObservation(step);
+        if (!observation) break; // The game closed
+        totalReward += observation->reward;
+        episodes += observation->done;
+        if (!channel.observationIntact(*observation, step)) {
+            LOG_WARN("[bot agent] Observation %llu overwritten while read", static_cast<unsigned long long>(step));
+        }
+        if (!channel.submitInput(step, bits)) break;
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    channel.close();
+    LOG_INFO("[bot agent] %llu steps in %g s = %.0f steps/s; %lld episodes finished, total reward %.0f",
+             static_cast<unsigned long long>(step), seconds, seconds > 0.0 ? step / seconds : 0.0, episodes, totalReward);
+    return 0;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "batchenv.h"
+
+// ============================ BOT CHANNEL ============================
+// Drives the headless game from an agent in another process (--bot-channel NAME) through a block of
+// shared memory: no socket, no serialization, and no locks. The game writes each step's observation
+// (writeObservation's BATCH_OBSERVATION_SIZE floats, the same features as the batch environment)
+// straight into a slot of a ring and bumps `observed`; the agent writes the packed input (packInput
+// bits) for that step into the input ring and bumps `acted`. Each side only ever stores its own
+// counter and waits on the other's, spinning BOT_CHANNEL_WAIT_SPINS checks before it starts yielding
+// its core, so a step costs a couple of cache-line transfers. The game plays step N once the agent's
+// input for it is in; an agent may queue inputs up to BOT_CHANNEL_SLOTS steps ahead (action repeat,
+// open-loop plans). An observation slot is reused BOT_CHANNEL_SLOTS steps later, so it carries a
+// sequence number, odd while it is being written: an agent reading an old step checks it afterwards.
+// A lost ship resets the world on the spot, as in the batch environment: that step is marked done
+// and its observation already shows the fresh game. Either side closing ends the session; an agent
+// killed before it could close leaves the game waiting on its next input.
+//
+// The block is "/asteroids-bot-NAME" (shm_open; /dev/shm on Linux) or "Local\asteroids-bot-NAME"
+// (a named file mapping on Windows), laid out as BotChannelLayout below; the offsets are fixed by
+// the static_asserts in botchannel.cpp, so agents in other languages can map it directly.
+const uint32_t BOT_CHANNEL_MAGIC = 0x544F4241; // "ABOT"
+const uint32_t BOT_CHANNEL_VERSION = 1;
+const int BOT_CHANNEL_SLOTS = 64;
+const int BOT_CHANNEL_WAIT_SPINS = 4096;
+
+const uint32_t BOT_CHANNEL_GAME_CLOSED = 1;
+const uint32_t BOT_CHANNEL_AGENT_CLOSED = 2;
+
+struct alignas(64) BotChannelObservation {
+    std::atomic<uint64_t> sequence; // 2 * step + 2 once step's observation is in; odd while it is written
+    uint64_t step;
+    int32_t score;
+    float reward; // Points scored by the step, plus BATCH_GAME_OVER_REWARD when it lost the ship
+    uint8_t done; // The step lost the ship; the observation is of the fresh game
+    float observation[BATCH_OBSERVATION_SIZE];
+};
+
+struct BotChannelLayout {
+    std::atomic<uint32_t> magic; // Stored last by the game, once the rest is set up
+    uint32_t version;
+    uint32_t slots;
+    uint32_t observationFloats;
+    alignas(64) std::atomic<uint64_t> observed; // Steps whose observation is published (the game's)
+    alignas(64) std::atomic<uint64_t> acted; // Steps the agent has given an input for (the agent's)
+    alignas(64) std::atomic<uint32_t> closed; // BOT_CHANNEL_GAME_CLOSED | BOT_CHANNEL_AGENT_CLOSED
+    std::atomic<uint32_t> attached; // An agent has mapped the block
+    alignas(64) uint8_t inputs[BOT_CHANNEL_SLOTS]; // Step N's at N % BOT_CHANNEL_SLOTS
+    BotChannelObservation observations[BOT_CHANNEL_SLOTS]; // Step N's at N % BOT_CHANNEL_SLOTS
+};
+
+struct BotChannel {
+    BotChannelLayout* layout = nullptr;
+    bool owner = false; // Created the block (the game side): removes its name on close
+    std::string name; // The system name of the block
+#if defined(_WIN32)
+    void* mapping = nullptr; // HANDLE
+#endif
+
+    bool create(const char* channel); // The game side; false if the name is taken or the system refuses
+    bool attach(const char* channel); // The agent side; false until the game has created it
+    void close(); // Tells the other side, then unmaps
+    ~BotChannel() { close(); }
+
+    // Game side. publish() writes the observation of the world after `step` steps.
+    void publish(const GameWorld& source, uint64_t step, float reward, bool done);
+    bool waitInput(uint64_t step, uint8_t& bits); // false if the agent closed without giving one
+
+    // Agent side. The observation is read in place; after reading it, observationIntact() says
+    // whether the game overwrote it meanwhile (an agent more than BOT_CHANNEL_SLOTS steps behind).
+    // nullptr once the game has closed, or if the step's slot has already been reused
+    const BotChannelObservation* waitObservation(uint64_t step);
+    bool observationIntact(const BotChannelObservation& slot, uint64_t step) const;
+    bool submitInput(uint64_t step, uint8_t bits); // In step order; false once the game has closed
+};
+
+// ============================ REFERENCE AGENT ============================
+// --bot-agent NAME: attaches to a game's channel and flies the headless mode's spin-fire-shield
+// policy for up to `steps` steps, then logs the steps per second and the episodes finished. The
+// template for an agent, and the channel's throughput test.
+int runBotAgent(const char* channel, long long steps);
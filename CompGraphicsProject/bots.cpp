@@ -0,0 +1,222 @@
+#include "bots.h"
+#include "jobs.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <glm/gtc/constants.hpp>
+
+// SIMD: as simulation.cpp
+#if defined(__AVX__)
+#include <immintrin.h>
+#define BOT_SIMD_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BOT_SIMD_SSE2 1
+#endif
+
+size_t botCount = 0;
+bool botPilot = false;
+BotController bots;
+
+const float BOT_NO_THREAT = std::numeric_limits<float>::max(); // The gap of a bot nothing is closing in on
+const size_t BOT_GRAIN = 64; // Bots per job (a multiple of every SIMD width)
+
+// ============================ SETUP ============================
+void BotController::init(const SimulationLimits& limits) {
+    const size_t shipCount = static_cast<size_t>(std::max(limits.ships, 1));
+    const size_t rockCapacity = static_cast<size_t>(limits.asteroidPoolCapacity());
+    rocks.init(rockCapacity);
+    rockX.assign(rockCapacity, 0.0f);
+    rockY.assign(rockCapacity, 0.0f);
+    centers.assign(shipCount, glm::vec2(0.0f));
+    hits.assign(shipCount * BOT_NEIGHBOURS, { 0, 0.0f });
+    counts.assign(shipCount, 0);
+    const size_t lanes = paddedEntityCount<float>(shipCount);
+    for (EntityArray<float>* lane : { &facingX, &facingY, &aimX, &aimY, &evadeX, &evadeY, &gap, &speed }) lane->assign(lanes, 0.0f);
+    keys.assign(lanes, 0);
+    inputs.assign(shipCount, InputState());
+}
+
+size_t BotController::memoryBytes() const {
+    const SpatialGrid& grid = rocks.grid;
+    return (grid.cellStart.capacity() + grid.entries.capacity() + grid.entityCell.capacity() + grid.chunkOffsets.capacity()) * sizeof(int) +
+           grid.occupied.capacity() * sizeof(uint64_t) +
+           (rockX.capacity() + rockY.capacity()) * sizeof(float) + centers.capacity() * sizeof(glm::vec2) +
+           hits.capacity() * sizeof(QueryHit) + counts.capacity() * sizeof(uint32_t) + 8 * facingX.capacity() * sizeof(float) +
+           keys.capacity() + inputs.capacity() * sizeof(InputState);
+}
+
+// ============================ STEERING ============================
+// One bot's keys. Away from a threat, otherwise towards its aim: it turns until the way it wants to
+// go is within BOT_AIM_TOLERANCE of its facing, thrusts along it (while hunting, only up to
+// BOT_CRUISE_SPEED and not inside BOT_STANDOFF), fires whenever its facing is on the aim point within
+// range, and raises the shield when a rock is all but touching.
+static uint8_t steerLane(float fx, float fy, float ax, float ay, float ex, float ey, float gap, float speed) {
+    const bool evading = gap < BOT_THREAT_GAP;
+    const float dx = evading ? ex : ax;
+    const float dy = evading ? ey : ay;
+    const float cross = fx * dy - fy * dx;
+    const float dot = fx * dx + fy * dy;
+    const float tolerance = BOT_AIM_TOLERANCE * std::sqrt(dx * dx + dy * dy);
+    const float aimSq = ax * ax + ay * ay;
+    const float aimCross = fx * ay - fy * ax;
+    const float aimDot = fx * ax + fy * ay;
+    const float aimTolerance = BOT_AIM_TOLERANCE * std::sqrt(aimSq);
+    const bool aligned = dot > 0.0f && cross <= tolerance && cross >= -tolerance;
+    uint8_t bits = 0;
+    if (cross > tolerance) bits |= INPUT_LEFT;
+    if (cross < -tolerance) bits |= INPUT_RIGHT;
+    if (aligned && (evading || (speed < BOT_CRUISE_SPEED && aimSq > BOT_STANDOFF * BOT_STANDOFF))) bits |= INPUT_THRUST;
+    if (aimDot > 0.0f && aimCross <= aimTolerance && aimCross >= -aimTolerance && aimSq < BOT_FIRE_RANGE * BOT_FIRE_RANGE) bits |= INPUT_FIRE;
+    if (gap < BOT_SHIELD_GAP) bits |= INPUT_SHIELD;
+    return bits;
+}
+
+// Sets the key bits of `lanes` lanes from their decision masks (a bit per lane each)
+static void packLanes(uint8_t* keys, int lanes, int left, int right, int thrust, int fire, int shield) {
+    for (int l = 0; l < lanes; ++l) {
+        keys[l] = static_cast<uint8_t>(((left >> l) & 1) * INPUT_LEFT | ((right >> l) & 1) * INPUT_RIGHT | ((thrust >> l) & 1) * INPUT_THRUST |
+                                       ((fire >> l) & 1) * INPUT_FIRE | ((shield >> l) & 1) * INPUT_SHIELD);
+    }
+}
+
+// steerLane over bots [begin, end), a SIMD register of them at a time. `begin` is a multiple of
+// BOT_GRAIN and the lanes are padded to whole cache lines (init), so every load is aligned and the
+// last register simply runs into the padding: the keys it writes past `end` are never read.
+static void steerBots(BotController& c, size_t begin, size_t end) {
+    size_t b = begin;
+#if defined(BOT_SIMD_AVX)
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 threatGap = _mm256_set1_ps(BOT_THREAT_GAP), shieldGap = _mm256_set1_ps(BOT_SHIELD_GAP);
+    const __m256 aimTolerance = _mm256_set1_ps(BOT_AIM_TOLERANCE), cruise = _mm256_set1_ps(BOT_CRUISE_SPEED);
+    const __m256 standoffSq = _mm256_set1_ps(BOT_STANDOFF * BOT_STANDOFF), rangeSq = _mm256_set1_ps(BOT_FIRE_RANGE * BOT_FIRE_RANGE);
+    for (; b < end; b += 8) {
+        const __m256 fx = _mm256_load_ps(&c.facingX[b]), fy = _mm256_load_ps(&c.facingY[b]);
+        const __m256 ax = _mm256_load_ps(&c.aimX[b]), ay = _mm256_load_ps(&c.aimY[b]);
+        const __m256 gap = _mm256_load_ps(&c.gap[b]);
+        const __m256 evading = _mm256_cmp_ps(gap, threatGap, _CMP_LT_OQ);
+        const __m256 dx = _mm256_blendv_ps(ax, _mm256_load_ps(&c.evadeX[b]), evading);
+        const __m256 dy = _mm256_blendv_ps(ay, _mm256_load_ps(&c.evadeY[b]), evading);
+        const __m256 cross = _mm256_sub_ps(_mm256_mul_ps(fx, dy), _mm256_mul_ps(fy, dx));
+        const __m256 dot = _mm256_add_ps(_mm256_mul_ps(fx, dx), _mm256_mul_ps(fy, dy));
+        const __m256 tolerance = _mm256_mul_ps(aimTolerance, _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy))));
+        const __m256 aimSq = _mm256_add_ps(_mm256_mul_ps(ax, ax), _mm256_mul_ps(ay, ay));
+        const __m256 aimCross = _mm256_sub_ps(_mm256_mul_ps(fx, ay), _mm256_mul_ps(fy, ax));
+        const __m256 aimDot = _mm256_add_ps(_mm256_mul_ps(fx, ax), _mm256_mul_ps(fy, ay));
+        const __m256 aimLimit = _mm256_mul_ps(aimTolerance, _mm256_sqrt_ps(aimSq));
+        const __m256 negTolerance = _mm256_sub_ps(zero, tolerance), negAimLimit = _mm256_sub_ps(zero, aimLimit);
+        const __m256 aligned = _mm256_and_ps(_mm256_cmp_ps(dot, zero, _CMP_GT_OQ),
+                                             _mm256_and_ps(_mm256_cmp_ps(cross, tolerance, _CMP_LE_OQ), _mm256_cmp_ps(cross, negTolerance, _CMP_GE_OQ)));
+        const __m256 hunting = _mm256_and_ps(_mm256_cmp_ps(_mm256_load_ps(&c.speed[b]), cruise, _CMP_LT_OQ), _mm256_cmp_ps(aimSq, standoffSq, _CMP_GT_OQ));
+        const __m256 onTarget = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(aimDot, zero, _CMP_GT_OQ), _mm256_cmp_ps(aimSq, rangeSq, _CMP_LT_OQ)),
+                                              _mm256_and_ps(_mm256_cmp_ps(aimCross, aimLimit, _CMP_LE_OQ), _mm256_cmp_ps(aimCross, negAimLimit, _CMP_GE_OQ)));
+        packLanes(&c.keys[b], 8, _mm256_movemask_ps(_mm256_cmp_ps(cross, tolerance, _CMP_GT_OQ)),
+                  _mm256_movemask_ps(_mm256_cmp_ps(cross, negTolerance, _CMP_LT_OQ)),
+                  _mm256_movemask_ps(_mm256_and_ps(aligned, _mm256_or_ps(evading, hunting))), _mm256_movemask_ps(onTarget),
+                  _mm256_movemask_ps(_mm256_cmp_ps(gap, shieldGap, _CMP_LT_OQ)));
+    }
+#elif defined(BOT_SIMD_SSE2)
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 threatGap = _mm_set1_ps(BOT_THREAT_GAP), shieldGap = _mm_set1_ps(BOT_SHIELD_GAP);
+    const __m128 aimTolerance = _mm_set1_ps(BOT_AIM_TOLERANCE), cruise = _mm_set1_ps(BOT_CRUISE_SPEED);
+    const __m128 standoffSq = _mm_set1_ps(BOT_STANDOFF * BOT_STANDOFF), rangeSq = _mm_set1_ps(BOT_FIRE_RANGE * BOT_FIRE_RANGE);
+    for (; b < end; b += 4) {
+        const __m128 fx = _mm_load_ps(&c.facingX[b]), fy = _mm_load_ps(&c.facingY[b]);
+        const __m128 ax = _mm_load_ps(&c.aimX[b]), ay = _mm_load_ps(&c.aimY[b]);
+        const __m128 gap = _mm_load_ps(&c.gap[b]);
+        const __m128 evading = _mm_cmplt_ps(gap, threatGap);
+        const __m128 dx = _mm_or_ps(_mm_and_ps(evading, _mm_load_ps(&c.evadeX[b])), _mm_andnot_ps(evading, ax));
+        const __m128 dy = _mm_or_ps(_mm_and_ps(evading, _mm_load_ps(&c.evadeY[b])), _mm_andnot_ps(evading, ay));
+        const __m128 cross = _mm_sub_ps(_mm_mul_ps(fx, dy), _mm_mul_ps(fy, dx));
+        const __m128 dot = _mm_add_ps(_mm_mul_ps(fx, dx), _mm_mul_ps(fy, dy));
+        const __m128 tolerance = _mm_mul_ps(aimTolerance, _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy))));
+        const __m128 aimSq = _mm_add_ps(_mm_mul_ps(ax, ax), _mm_mul_ps(ay, ay));
+        const __m128 aimCross = _mm_sub_ps(_mm_mul_ps(fx, ay), _mm_mul_ps(fy, ax));
+        const __m128 aimDot = _mm_add_ps(_mm_mul_ps(fx, ax), _mm_mul_ps(fy, ay));
+        const __m128 aimLimit = _mm_mul_ps(aimTolerance, _mm_sqrt_ps(aimSq));
+        const __m128 negTolerance = _mm_sub_ps(zero, tolerance), negAimLimit = _mm_sub_ps(zero, aimLimit);
+        const __m128 aligned = _mm_and_ps(_mm_cmpgt_ps(dot, zero), _mm_and_ps(_mm_cmple_ps(cross, tolerance), _mm_cmpge_ps(cross, negTolerance)));
+        const __m128 hunting = _mm_and_ps(_mm_cmplt_ps(_mm_load_ps(&c.speed[b]), cruise), _mm_cmpgt_ps(aimSq, standoffSq));
+        const __m128 onTarget = _mm_and_ps(_mm_and_ps(_mm_cmpgt_ps(aimDot, zero), _mm_cmplt_ps(aimSq, rangeSq)),
+                                           _mm_and_ps(_mm_cmple_ps(aimCross, aimLimit), _mm_cmpge_ps(aimCross, negAimLimit)));
+        packLanes(&c.keys[b], 4, _mm_movemask_ps(_mm_cmpgt_ps(cross, tolerance)), _mm_movemask_ps(_mm_cmplt_ps(cross, negTolerance)),
+                  _mm_movemask_ps(_mm_and_ps(aligned, _mm_or_ps(evading, hunting))), _mm_movemask_ps(onTarget),
+                  _mm_movemask_ps(_mm_cmplt_ps(gap, shieldGap)));
+    }
+#endif
+    for (; b < end; ++b) {
+        c.keys[b] = steerLane(c.facingX[b], c.facingY[b], c.aimX[b], c.aimY[b], c.evadeX[b], c.evadeY[b], c.gap[b], c.speed[b]);
+    }
+}
+
+// ============================ THINKING ============================
+void BotController::think(const GameWorld& world, size_t first, InputState* out) {
+    const ShipStore& ships = world.ships;
+    const AsteroidStore& store = world.asteroids;
+    const size_t n = ships.count() > first ? std::min(ships.count() - first, centers.size()) : 0;
+    if (n == 0) return;
+
+    // 1. Every bot's nearest rocks
+    const float* px = store.x.data();
+    const float* py = store.y.data();
+    if (world.lazyAsteroidMotion) {
+        for (size_t i = 0; i < store.count(); ++i) {
+            const glm::vec2 position = store.positionAt(i, store.clock);
+            rockX[i] = position.x;
+            rockY[i] = position.y;
+        }
+        px = rockX.data();
+        py = rockY.data();
+    }
+    rocks.build(px, py, store.count());
+    for (size_t b = 0; b < n; ++b) centers[b] = ships.position(first + b);
+    queryKNearestBatch(rocks, centers.data(), n, BOT_NEIGHBOURS, hits.data(), counts.data());
+
+    // 2 and 3. Each job gathers its bots' lanes, then steers them
+    parallelFor(0, n, BOT_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t b = begin; b < end; ++b) {
+            const size_t s = first + b;
+            const glm::vec2 position = centers[b];
+            const glm::vec2 velocity(ships.vx[s], ships.vy[s]);
+            const glm::vec2 facing = world.heading(ships.rot[s] + glm::half_pi<float>());
+            glm::vec2 aim(0.0f), evade(0.0f);
+            float closest = BOT_NO_THREAT;
+            bool targeted = false;
+            for (uint32_t h = 0; h < counts[b]; ++h) {
+                const QueryHit& hit = hits[b * BOT_NEIGHBOURS + h];
+                const size_t i = static_cast<size_t>(hit.index);
+                if (store.destroyed[i]) continue;
+                const glm::vec2 offset(nearestImage(px[i], position.x) - position.x, nearestImage(py[i], position.y) - position.y);
+                const glm::vec2 closing = glm::vec2(store.vx[i], store.vy[i]) - velocity; // The rock's velocity as the bot sees it
+                const float distance = std::sqrt(hit.distanceSq);
+                if (!targeted) {
+                    aim = offset + closing * (distance / BULLET_SPEED); // Where a bullet fired now meets it
+                    targeted = true;
+                }
+                const float edge = distance - store.radius(i) - ships.radius[s];
+                if (distance <= 0.0f || edge >= BOT_THREAT_GAP || glm::dot(offset, closing) >= 0.0f) continue; // Not closing in
+                evade -= offset / distance * (BOT_THREAT_GAP - edge);
+                closest = std::min(closest, edge);
+            }
+            facingX[b] = facing.x;
+            facingY[b] = facing.y;
+            aimX[b] = aim.x;
+            aimY[b] = aim.y;
+            evadeX[b] = evade.x;
+            evadeY[b] = evade.y;
+            gap[b] = closest;
+            speed[b] = glm::dot(velocity, facing);
+        }
+        steerBots(*this, begin, end);
+        for (size_t b = begin; b < end; ++b) out[first + b] = ships.alive[first + b] ? unpackInput(keys[b]) : InputState();
+    });
+}
+
+void stepWithBots(GameWorld& target, BotController& controller, const InputState& player) {
+    const size_t shipCount = std::min(target.ships.count(), controller.inputs.size());
+    controller.inputs[0] = player;
+    controller.think(target, botPilot ? 0 : 1, controller.inputs.data());
+    target.step(SIM_DT, controller.inputs.data(), shipCount);
+}
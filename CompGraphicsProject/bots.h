@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "simulation.h"
+#include "spatialquery.h"
+
+// AI ships for attract mode and load tests (--bots N): every ship after the player flies itself,
+// its keys worked out from the world after each tick exactly as a player's would be sampled, so the
+// step cannot tell them apart. All the bots think in one batched pass per tick:
+//   1. an index over the rocks (spatialquery.h) answers every bot's BOT_NEIGHBOURS nearest rocks in
+//      one kNN batch spread over the job system;
+//   2. a gather pass turns each bot's neighbours into a few numbers, lane by lane in struct-of-arrays
+//      form: where to aim (the nearest rock, led by its speed relative to a bullet), which way to get
+//      clear of the rocks closing in, and how close the closest one is;
+//   3. one SIMD pass over those lanes steers (turn towards the aim or away from the threat), decides
+//      thrust, fire and shield, and packs the keys.
+// The bots read only the world, so a world stepped with them stays deterministic: the same seed
+// plays out the same. Like simulation.h, nothing here depends on GL.
+
+// ============================ BOT TUNING ============================
+const size_t BOT_NEIGHBOURS = 4; // Rocks each bot looks at
+const float BOT_FIRE_RANGE = 0.9f; // Field units to the (led) aim point it fires within
+const float BOT_AIM_TOLERANCE = 0.06f; // Sine of the angle off its aim it holds its turn and fires within
+const float BOT_THREAT_GAP = 0.2f; // Field units between hull and a closing rock's edge that turn it away
+const float BOT_SHIELD_GAP = 0.05f; // ... and that raise the shield
+const float BOT_CRUISE_SPEED = 0.25f; // Field units per second along its facing it thrusts up to while hunting
+const float BOT_STANDOFF = 0.35f; // Field units to its target it stops closing in at
+
+// ============================ BOT CONTROLLER ============================
+struct BotController {
+    SpatialQueryIndex rocks;
+    std::vector<float> rockX, rockY; // Lazy rocks' positions this tick (the store's are stale)
+    std::vector<glm::vec2> centers; // Per bot: its position (the kNN batch's query points)
+    std::vector<QueryHit> hits; // BOT_NEIGHBOURS per bot
+    std::vector<uint32_t> counts;
+    // Per bot, from the gather: facing, the aim point, the way out of trouble (weighted by how close
+    // it is), the closest closing gap and its speed along its facing
+    EntityArray<float> facingX, facingY, aimX, aimY, evadeX, evadeY, gap, speed;
+    EntityArray<uint8_t> keys; // Per bot, packInput bits
+    std::vector<InputState> inputs; // Per ship (stepWithBots)
+
+    // Sized for `limits` (its ships, its asteroid pool); thinking never allocates after
+    void init(const SimulationLimits& limits);
+    size_t memoryBytes() const;
+    // Fills inputs[first, world's ship count) with the keys of the ships from `first` on (nothing
+    // for a ship out of play)
+    void think(const GameWorld& world, size_t first, InputState* inputs);
+};
+
+// ============================ BOT API ============================
+extern size_t botCount; // Ships after the player flown by `bots` (--bots N)
+extern bool botPilot; // The player's ship is flown by `bots` too, its keys ignored (--autopilot)
+extern BotController bots; // For the global world
+
+// One tick of `target` with ship 0 on `player` (flown by `controller` too with botPilot) and every
+// ship after it flown by `controller`
+void stepWithBots(GameWorld& target, BotController& controller, const InputState& player);
@@ -0,0 +1,193 @@
+#include "broadphaseview.h"
+#include "gldebug.h"
+#include "glstate.h"
+#include "hud.h"
+#include "log.h"
+#include "shaders.h"
+#include "streambuffer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <glad/glad.h>
+
+// ============================ BROADPHASE VIEW STATE ============================
+static unsigned int heatmapProgram;
+static unsigned int heatmapVAO; // Instance attributes only: the quad's corners come from gl_VertexID
+static int dimLoc, cellSizeLoc, maxCandidatesLoc, maxRocksLoc;
+static GLsizei stagedCells = 0;
+
+// ============================ SHADERS ============================
+// The field is clip space (-1..1 on both axes), so a cell's corners are its grid coordinates times
+// the cell size. The fragment shader gets the cell-local coordinate for the edges and the inset.
+static const char* heatmapVertexShaderSource = R"(
+    #version 330 core
+    layout (location = 0) in uint rocks;
+    layout (location = 1) in uint candidates;
+    uniform int dim;
+    uniform float cellSize;
+    uniform float maxCandidates;
+    uniform float maxRocks;
+
+    out vec2 local;
+    flat out float heat;
+    flat out float fill;
+
+    void main()
+    {
+        vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+        vec2 cell = vec2(gl_InstanceID % dim, gl_InstanceID / dim);
+        local = corner;
+        heat = candidates == 0u ? -1.0 : log(1.0 + float(candidates)) / log(1.0 + maxCandidates);
+        fill = sqrt(float(rocks) / maxRocks);
+        gl_Position = vec4((cell + corner) * cellSize - 1.0, 0.0, 1.0);
+    }
+)";
+
+static const char* heatmapFragmentShaderSource = R"(
+    #version 330 core
+    in vec2 local;
+    flat in float heat;
+    flat in float fill;
+
+    out vec4 FragColor;
+
+    void main()
+    {
+        // One pixel of grid line along the cell's low edges (its neighbours draw the high ones)
+        vec2 pixel = fwidth(local);
+        if (local.x < pixel.x || local.y < pixel.y) {
+            FragColor = vec4(0.5, 0.5, 0.6, 0.35);
+            return;
+        }
+        // Rocks: the outline of a centred square, as wide as the cell at the fullest cell
+        vec2 inset = abs(local - 0.5) * 2.0;
+        float edge = max(inset.x, inset.y);
+        if (fill > 0.0 && edge <= fill && edge > fill - 2.0 * max(pixel.x, pixel.y)) {
+            FragColor = vec4(1.0, 1.0, 1.0, 0.8);
+            return;
+        }
+        if (heat < 0.0) discard;
+        // Candidates: blue, yellow, red
+        vec3 color = heat < 0.5 ? mix(vec3(0.1, 0.2, 1.0), vec3(1.0, 0.9, 0.1), heat * 2.0)
+                                : mix(vec3(1.0, 0.9, 0.1), vec3(1.0, 0.1, 0.05), heat * 2.0 - 1.0);
+        FragColor = vec4(color, 0.2 + 0.35 * heat);
+    }
+)";
+
+// ============================ SETUP ============================
+bool setupBroadphaseView()
+{
+    heatmapProgram = buildProgram("broadphase heatmap", heatmapVertexShaderSource, heatmapFragmentShaderSource);
+    if (!heatmapProgram) return false;
+    dimLoc = glGetUniformLocation(heatmapProgram, "dim");
+    cellSizeLoc = glGetUniformLocation(heatmapProgram, "cellSize");
+    maxCandidatesLoc = glGetUniformLocation(heatmapProgram, "maxCandidates");
+    maxRocksLoc = glGetUniformLocation(heatmapProgram, "maxRocks");
+
+    // The two count arrays are pointed at the stream buffer per draw, one binding each
+    if (useDirectStateAccess) {
+        glCreateVertexArrays(1, &heatmapVAO);
+        for (unsigned int attrib = 0; attrib <= 1; ++attrib) {
+            glVertexArrayAttribIFormat(heatmapVAO, attrib, 1, GL_UNSIGNED_INT, 0);
+            glVertexArrayAttribBinding(heatmapVAO, attrib, attrib);
+            glEnableVertexArrayAttrib(heatmapVAO, attrib);
+            glVertexArrayBindingDivisor(heatmapVAO, attrib, 1);
+        }
+    }
+    else {
+        glGenVertexArrays(1, &heatmapVAO);
+        glBindVertexArray(heatmapVAO);
+        for (unsigned int attrib = 0; attrib <= 1; ++attrib) {
+            glEnableVertexAttribArray(attrib);
+            glVertexAttribDivisor(attrib, 1);
+        }
+        glBindVertexArray(0);
+    }
+    labelGlObject(GL_VERTEX_ARRAY, heatmapVAO, "broadphase heatmap");
+    glState.invalidate();
+    return true;
+}
+
+void destroyBroadphaseView()
+{
+    glDeleteVertexArrays(1, &heatmapVAO);
+    glDeleteProgram(heatmapProgram);
+    heatmapVAO = heatmapProgram = 0;
+}
+
+// ============================ DRAWING ============================
+bool stageBroadphaseView(const BroadphaseHeatmap& map)
+{
+    stagedCells = 0;
+    if (!heatmapProgram || map.level < 0 || map.rocks.empty()) return false;
+    const size_t bytes = map.rocks.size() * sizeof(uint32_t);
+    glState.bindVertexArray(heatmapVAO);
+    const uint32_t* const arrays[2] = { map.rocks.data(), map.candidates.data() };
+    for (unsigned int attrib = 0; attrib <= 1; ++attrib) {
+        const size_t offset = streamBuffer.write(arrays[attrib], bytes, sizeof(uint32_t));
+        if (offset == STREAM_WRITE_FAILED) return false;
+        if (useDirectStateAccess) glVertexArrayVertexBuffer(heatmapVAO, attrib, streamBuffer.vbo, static_cast<GLintptr>(offset), sizeof(uint32_t));
+        else glVertexAttribIPointer(attrib, 1, GL_UNSIGNED_INT, sizeof(uint32_t), (void*)offset); // write() left the stream buffer bound
+    }
+    glState.useProgram(heatmapProgram);
+    glUniform1i(dimLoc, map.dim);
+    glUniform1f(cellSizeLoc, map.cellSize);
+    glUniform1f(maxCandidatesLoc, static_cast<float>(std::max(map.maxCandidates, 1u)));
+    glUniform1f(maxRocksLoc, static_cast<float>(std::max(map.maxRocks, 1u)));
+    stagedCells = static_cast<GLsizei>(map.rocks.size());
+    return true;
+}
+
+int drawBroadphaseView()
+{
+    if (stagedCells == 0) return 0;
+    glState.useProgram(heatmapProgram);
+    glState.bindVertexArray(heatmapVAO);
+    glState.setEnabled(GL_BLEND, true);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, stagedCells);
+    glState.setEnabled(GL_BLEND, false);
+    return 1;
+}
+
+// ============================ HUD ============================
+void queueBroadphaseHud(const BroadphaseHeatmap& map, int width)
+{
+    static const char* const levelNames[ASTEROID_SIZE_COUNT] = { "SMALL", "MEDIUM", "LARGE" };
+    if (map.level < 0) return;
+    // The hottest cells, busiest first (a pass per cell over a list of a few)
+    int hot[HEATMAP_HOT_CELLS];
+    int hotCount = 0;
+    for (int cell = 0; cell < static_cast<int>(map.candidates.size()); ++cell) {
+        const uint32_t candidates = map.candidates[static_cast<size_t>(cell)];
+        if (candidates == 0) continue;
+        int k = std::min(hotCount, HEATMAP_HOT_CELLS - 1);
+        if (hotCount == HEATMAP_HOT_CELLS && candidates <= map.candidates[static_cast<size_t>(hot[k])]) continue;
+        for (; k > 0 && map.candidates[static_cast<size_t>(hot[k - 1])] < candidates; --k) hot[k] = hot[k - 1];
+        hot[k] = cell;
+        hotCount = std::min(hotCount + 1, HEATMAP_HOT_CELLS);
+    }
+
+    const float scale = 2.0f;
+    const float line = HUD_CELL_HEIGHT * scale + 2.0f;
+    const float panelWidth = 44.0f * HUD_CELL_WIDTH * scale + 16.0f;
+    const float left = width - panelWidth - 12.0f, top = 12.0f;
+    hudRect(left, top, panelWidth, line * static_cast<float>(2 + hotCount) + 16.0f, glm::vec4(0.0f, 0.0f, 0.0f, 0.6f));
+    const glm::vec4 text(0.9f, 0.95f, 1.0f, 1.0f);
+    const float x = left + 8.0f;
+    float y = top + 8.0f;
+    uint32_t rocks = 0;
+    for (uint32_t count : map.rocks) rocks += count;
+    hudPrintf(x, y, scale, text, "GRID %s  %dX%d CELLS OF %.3f", levelNames[map.level], map.dim, map.dim, map.cellSize);
+    y += line;
+    hudPrintf(x, y, scale, text, "%u ROCKS  %llu CANDIDATES", rocks, static_cast<unsigned long long>(map.totalCandidates));
+    y += line;
+    for (int k = 0; k < hotCount; ++k) {
+        const size_t cell = static_cast<size_t>(hot[k]);
+        const float share = map.totalCandidates > 0 ? 100.0f * map.candidates[cell] / static_cast<float>(map.totalCandidates) : 0.0f;
+        hudPrintf(x, y, scale, glm::vec4(1.0f, 0.75f, 0.4f, 1.0f), "CELL %2d,%2d  %3u ROCKS  %5u PAIRS %4.1f%%",
+                  hot[k] % map.dim, hot[k] / map.dim, map.rocks[cell], map.candidates[cell], share);
+        y += line;
+    }
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "simulation.h"
+
+// Broadphase heatmap (F3, --heatmap): one level of the asteroid grid drawn over the field, to see
+// why collision time spikes and to tune the cell sizes. Each cell is tinted by the candidate pairs
+// the searches took from it (BroadphaseHeatmap, simulation.h), on a log scale from clear through
+// blue and yellow to red at the busiest cell, with an inset square growing with its rocks; the cell
+// edges draw the grid itself. The snapshot carries the level's counts, and all the cells go out in
+// one instanced draw: the counts are the only instance data, uploaded to the stream buffer, and the
+// vertex shader places each quad from gl_InstanceID. The HUD lists the hottest cells.
+// F3 steps through the levels, SMALL first, then turns the heatmap off.
+
+// ============================ BROADPHASE VIEW API ============================
+const int HEATMAP_HOT_CELLS = 5; // Listed in the HUD
+
+bool setupBroadphaseView();
+void destroyBroadphaseView();
+
+// Writes the snapshot's counts into the stream buffer once (false: no heatmap, or no room this frame)...
+bool stageBroadphaseView(const BroadphaseHeatmap& map);
+// ... then draws every cell in one instanced draw, per viewport; returns the draw calls issued
+int drawBroadphaseView();
+// Queues the level's totals and its hottest cells for the HUD, at the top right
+void queueBroadphaseHud(const BroadphaseHeatmap& map, int width);
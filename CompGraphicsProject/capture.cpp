@@ -0,0 +1,281 @@
+#include "capture.h"
+#include "alloctrack.h"
+#include "log.h"
+#include "threadconfig.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <glad/glad.h>
+
+// ============================ READBACK RING ============================
+// A buffer goes FREE -> READING (copy queued, fenced) -> MAPPED (the writer's) -> WRITTEN -> FREE.
+// Buffers are filled and handed over in ring order, so the writer takes them in ring order too and
+// video frames stay in sequence.
+enum SlotState { SLOT_FREE, SLOT_READING, SLOT_MAPPED, SLOT_WRITTEN };
+
+struct ReadbackSlot {
+    unsigned int buffer = 0;
+    size_t capacity = 0; // Bytes allocated for buffer
+    GLsync fence = 0;
+    SlotState state = SLOT_FREE; // Guarded by captureMutex
+    const unsigned char* pixels = nullptr; // Mapped RGBA, bottom row first as GL reads it
+    int width = 0, height = 0;
+    bool screenshot = false;
+    bool video = false; // A frame can be both
+};
+
+static ReadbackSlot ring[CAPTURE_RING_SIZE];
+static int fillNext = 0; // Next slot to read into
+static int collectNext = 0; // Oldest slot that may still be reading
+
+static std::atomic<bool> screenshotRequested(false);
+static bool videoActive = false;
+static long long capturedFrames = 0;
+static long long droppedFrames = 0;
+
+// ============================ WRITER THREAD ============================
+static std::thread writerThread;
+static std::mutex captureMutex;
+static std::condition_variable captureSignal;
+static bool writerStopping = false;
+static int writeNext = 0; // Writer thread only
+
+static std::FILE* videoFile = nullptr;
+static int videoFps = 60;
+static int videoWidth = 0, videoHeight = 0; // Set by the first video frame
+static long long videoSizeMismatches = 0;
+static int screenshotIndex = 0;
+static std::vector<unsigned char> encodeScratch; // Writer thread only: one YUV frame or one RGB row
+
+static unsigned char clampByte(int value) {
+    return static_cast<unsigned char>(std::min(255, std::max(0, value)));
+}
+
+static void ensureScratch(size_t bytes) {
+    if (encodeScratch.size() >= bytes) return;
+    AllowAllocations grow; // Once per size, not per frame
+    encodeScratch.resize(bytes);
+}
+
+static void writeScreenshot(const ReadbackSlot& slot) {
+    char path[64];
+    std::snprintf(path, sizeof(path), "screenshot-%04d.ppm", screenshotIndex++);
+    std::FILE* file = std::fopen(path, "wb");
+    if (!file) {
+        LOG_WARN("Could not write %s", path);
+        return;
+    }
+    std::fprintf(file, "P6\n%d %d\n255\n", slot.width, slot.height);
+    ensureScratch(static_cast<size_t>(slot.width) * 3);
+    for (int y = slot.height - 1; y >= 0; --y) {
+        const unsigned char* row = slot.pixels + static_cast<size_t>(y) * slot.width * 4;
+        for (int x = 0; x < slot.width; ++x) {
+            encodeScratch[x * 3 + 0] = row[x * 4 + 0];
+            encodeScratch[x * 3 + 1] = row[x * 4 + 1];
+            encodeScratch[x * 3 + 2] = row[x * 4 + 2];
+        }
+        std::fwrite(encodeScratch.data(), 1, static_cast<size_t>(slot.width) * 3, file);
+    }
+    std::fclose(file);
+    LOG_INFO("Screenshot: %s", path);
+}
+
+// BT.601 full range (C420jpeg), chroma from the average of each 2x2 block; rows flipped to top first
+static void writeVideoFrame(const ReadbackSlot& slot) {
+    if (!videoFile) return;
+    if (videoWidth == 0) {
+        videoWidth = slot.width;
+        videoHeight = slot.height;
+        std::fprintf(videoFile, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", videoWidth, videoHeight, videoFps);
+    }
+    if (slot.width != videoWidth || slot.height != videoHeight) {
+        ++videoSizeMismatches;
+        return;
+    }
+    const int width = slot.width, height = slot.height;
+    const int chromaWidth = (width + 1) / 2, chromaHeight = (height + 1) / 2;
+    const size_t lumaBytes = static_cast<size_t>(width) * height;
+    const size_t chromaBytes = static_cast<size_t>(chromaWidth) * chromaHeight;
+    ensureScratch(lumaBytes + 2 * chromaBytes);
+    unsigned char* lumaPlane = encodeScratch.data();
+    unsigned char* cbPlane = lumaPlane + lumaBytes;
+    unsigned char* crPlane = cbPlane + chromaBytes;
+    auto pixel = [&](int x, int y) { return slot.pixels + (static_cast<size_t>(height - 1 - y) * width + x) * 4; };
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const unsigned char* p = pixel(x, y);
+            lumaPlane[static_cast<size_t>(y) * width + x] = clampByte((77 * p[0] + 150 * p[1] + 29 * p[2] + 128) >> 8);
+        }
+    }
+    for (int cy = 0; cy < chromaHeight; ++cy) {
+        for (int cx = 0; cx < chromaWidth; ++cx) {
+            int r = 0, g = 0, b = 0, n = 0;
+            for (int dy = 0; dy < 2 && cy * 2 + dy < height; ++dy) {
+                for (int dx = 0; dx < 2 && cx * 2 + dx < width; ++dx) {
+                    const unsigned char* p = pixel(cx * 2 + dx, cy * 2 + dy);
+                    r += p[0]; g += p[1]; b += p[2]; ++n;
+                }
+            }
+            r /= n; g /= n; b /= n;
+            cbPlane[static_cast<size_t>(cy) * chromaWidth + cx] = clampByte(128 + ((-43 * r - 85 * g + 128 * b + 128) >> 8));
+            crPlane[static_cast<size_t>(cy) * chromaWidth + cx] = clampByte(128 + ((128 * r - 107 * g - 21 * b + 128) >> 8));
+        }
+    }
+    std::fputs("FRAME\n", videoFile);
+    std::fwrite(encodeScratch.data(), 1, lumaBytes + 2 * chromaBytes, videoFile);
+}
+
+static void writerLoop() {
+    registerThread(THREAD_BACKGROUND);
+    for (;;) {
+        ReadbackSlot* slot;
+        {
+            std::unique_lock<std::mutex> lock(captureMutex);
+            captureSignal.wait(lock, [] { return ring[writeNext].state == SLOT_MAPPED || writerStopping; });
+            if (ring[writeNext].state != SLOT_MAPPED) break; // Stopping with nothing left to write
+            slot = &ring[writeNext];
+        }
+        if (slot->pixels && slot->screenshot) writeScreenshot(*slot);
+        if (slot->pixels && slot->video) writeVideoFrame(*slot);
+        {
+            std::lock_guard<std::mutex> lock(captureMutex);
+            slot->state = SLOT_WRITTEN;
+        }
+        writeNext = (writeNext + 1) % CAPTURE_RING_SIZE;
+    }
+}
+
+static void ensureWriter() {
+    if (writerThread.joinable()) return;
+    AllowAllocations start;
+    writerStopping = false;
+    writerThread = std::thread(writerLoop);
+}
+
+// ============================ RENDER-THREAD SIDE ============================
+// Maps every readback whose fence has signalled, oldest first, and hands it to the writer. With
+// `wait`, waits for each fence instead (shutdown).
+static void collectReadbacks(bool wait) {
+    for (int i = 0; i < CAPTURE_RING_SIZE; ++i) {
+        ReadbackSlot& slot = ring[collectNext];
+        if (slot.state != SLOT_READING) break;
+        GLenum status = glClientWaitSync(slot.fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? 1000000000ull : 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) break;
+        glDeleteSync(slot.fence);
+        slot.fence = 0;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+        slot.pixels = static_cast<const unsigned char*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+            static_cast<GLsizeiptr>(static_cast<size_t>(slot.width) * slot.height * 4), GL_MAP_READ_BIT));
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        {
+            std::lock_guard<std::mutex> lock(captureMutex);
+            slot.state = SLOT_MAPPED; // The writer skips a failed map, but takes its turn
+        }
+        captureSignal.notify_all();
+        collectNext = (collectNext + 1) % CAPTURE_RING_SIZE;
+    }
+}
+
+// Unmaps the buffers the writer has finished with
+static void reclaimWritten() {
+    for (ReadbackSlot& slot : ring) {
+        {
+            std::lock_guard<std::mutex> lock(captureMutex);
+            if (slot.state != SLOT_WRITTEN) continue;
+        }
+        if (slot.pixels) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            slot.pixels = nullptr;
+        }
+        std::lock_guard<std::mutex> lock(captureMutex);
+        slot.state = SLOT_FREE;
+    }
+}
+
+// ============================ API ============================
+bool startVideoCapture(const char* path, int fps) {
+    videoFile = std::fopen(path, "wb");
+    if (!videoFile) {
+        LOG_WARN("Could not open %s for video capture", path);
+        return false;
+    }
+    videoFps = std::max(1, fps);
+    videoWidth = videoHeight = 0;
+    videoActive = true;
+    LOG_INFO("Capturing video to %s (%d fps header, %d readback buffers)", path, videoFps, CAPTURE_RING_SIZE);
+    return true;
+}
+
+void requestScreenshot() {
+    screenshotRequested.store(true, std::memory_order_relaxed);
+}
+
+void captureFrame(int width, int height) {
+    reclaimWritten();
+    collectReadbacks(false);
+
+    const bool screenshot = screenshotRequested.load(std::memory_order_relaxed);
+    if (!screenshot && !videoActive) return;
+    ensureWriter();
+    ReadbackSlot& slot = ring[fillNext];
+    if (slot.state != SLOT_FREE) {
+        ++droppedFrames; // GPU or writer behind; the screenshot request stays for the next frame
+        return;
+    }
+    screenshotRequested.store(false, std::memory_order_relaxed);
+
+    const size_t bytes = static_cast<size_t>(width) * height * 4;
+    if (slot.buffer == 0) glGenBuffers(1, &slot.buffer);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    if (slot.capacity < bytes) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(bytes), NULL, GL_STREAM_READ);
+        slot.capacity = bytes;
+    }
+    glPixelStorei(GL_PACK_ALIGNMENT, 4); // RGBA rows are always 4-byte aligned
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, (void*)0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.width = width;
+    slot.height = height;
+    slot.screenshot = screenshot;
+    slot.video = videoActive;
+    {
+        std::lock_guard<std::mutex> lock(captureMutex);
+        slot.state = SLOT_READING;
+    }
+    fillNext = (fillNext + 1) % CAPTURE_RING_SIZE;
+    ++capturedFrames;
+}
+
+void stopCapture() {
+    if (writerThread.joinable()) {
+        collectReadbacks(true);
+        {
+            std::lock_guard<std::mutex> lock(captureMutex);
+            writerStopping = true;
+        }
+        captureSignal.notify_all();
+        writerThread.join();
+        reclaimWritten();
+    }
+    for (ReadbackSlot& slot : ring) {
+        if (slot.fence) glDeleteSync(slot.fence);
+        if (slot.buffer) glDeleteBuffers(1, &slot.buffer);
+        slot = ReadbackSlot();
+    }
+    if (videoFile) {
+        std::fclose(videoFile);
+        videoFile = nullptr;
+        LOG_INFO("Video capture: %lld frames read back, %lld dropped, %lld of another size skipped",
+                 capturedFrames, droppedFrames, videoSizeMismatches);
+    }
+    videoActive = false;
+}
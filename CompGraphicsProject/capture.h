@@ -0,0 +1,23 @@
+#pragma once
+
+// ============================ FRAME CAPTURE ============================
+// Screenshots (F12) and video (--capture PATH) without stalling the frame. A captured frame is read
+// from the back buffer into one of CAPTURE_RING_SIZE pixel pack buffers: glReadPixels into a bound
+// GL_PIXEL_PACK_BUFFER only queues the copy. A fence follows it, and a later frame maps the buffer
+// once the fence has signalled, so the render thread never waits for the GPU. The writer thread
+// encodes straight from the mapped memory (screenshots as binary PPM, video as one YUV4MPEG2 stream,
+// converted to 4:2:0 there, which ffmpeg and most players read) and hands the buffer back to be
+// unmapped and reused. A frame that finds no free buffer is dropped and counted, never waited for.
+const int CAPTURE_RING_SIZE = 4;
+
+// Video: every recorded frame from now on goes to `path` (a .y4m file), with `fps` in its header, until
+// stopCapture. The first frame sets the video size; frames of another size (after a resize) are dropped.
+bool startVideoCapture(const char* path, int fps);
+// Any thread; the next recorded frame is saved as screenshot-NNNN.ppm in the working directory
+void requestScreenshot();
+// After the frame's last draw, before the swap (context current): queues this frame's readback if
+// one is wanted, passes signalled readbacks to the writer and reclaims the buffers it has finished
+void captureFrame(int width, int height);
+// Context current: waits for the readbacks in flight, lets the writer finish, joins it and deletes
+// the buffers (safe to call without a capture)
+void stopCapture();
@@ -0,0 +1,144 @@
+#include "checkpoint.h"
+#include "log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <type_traits>
+
+static_assert(std::is_trivially_copyable<CheckpointHeader>::value, "The checkpoint header is copied as raw bytes");
+
+// ============================ PACKING ============================
+static void appendVarint(std::vector<unsigned char>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<unsigned char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<unsigned char>(value));
+}
+
+static bool readVarint(const unsigned char*& in, const unsigned char* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && in < end; shift += 7) {
+        const unsigned char byte = *in++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (byte < 0x80) return true;
+    }
+    return false;
+}
+
+void packCheckpoint(const void* snapshot, size_t bytes, std::vector<unsigned char>& out) {
+    const unsigned char* source = static_cast<const unsigned char*>(snapshot);
+    size_t i = 0;
+    while (i < bytes) {
+        const size_t zerosFrom = i;
+        while (i < bytes && source[i] == 0) ++i;
+        // The literal runs to the next zero run long enough to be worth a token of its own
+        const size_t literalFrom = i;
+        size_t literalTo = bytes, run = 0;
+        for (size_t k = i; k < bytes; ++k) {
+            run = source[k] == 0 ? run + 1 : 0;
+            if (run == CHECKPOINT_MIN_ZERO_RUN) {
+                literalTo = k + 1 - CHECKPOINT_MIN_ZERO_RUN;
+                break;
+            }
+        }
+        appendVarint(out, literalFrom - zerosFrom);
+        appendVarint(out, literalTo - literalFrom);
+        out.insert(out.end(), source + literalFrom, source + literalTo);
+        i = literalTo;
+    }
+}
+
+bool unpackCheckpoint(const unsigned char* packed, size_t packedBytes, size_t bytes, std::vector<unsigned char>& out) {
+    out.assign(bytes, 0);
+    const unsigned char* in = packed;
+    const unsigned char* end = packed + packedBytes;
+    size_t at = 0;
+    while (at < bytes) {
+        uint64_t zeros = 0, literal = 0;
+        if (!readVarint(in, end, zeros) || !readVarint(in, end, literal)) return false;
+        if (zeros > bytes - at || literal > bytes - at - zeros || literal > static_cast<uint64_t>(end - in)) return false;
+        at += static_cast<size_t>(zeros); // Already zero
+        std::memcpy(out.data() + at, in, static_cast<size_t>(literal));
+        in += literal;
+        at += static_cast<size_t>(literal);
+    }
+    return in == end;
+}
+
+// ============================ FILES ============================
+std::string checkpointPath(const char* directory, uint32_t match) {
+    return (std::filesystem::path(directory) / ("match-" + std::to_string(match) + CHECKPOINT_EXTENSION)).string();
+}
+
+bool writeCheckpointFile(const char* directory, uint32_t match, uint64_t ticks, const void* snapshot, size_t bytes,
+                         std::vector<unsigned char>& scratch) {
+    scratch.resize(sizeof(CheckpointHeader));
+    packCheckpoint(snapshot, bytes, scratch);
+    CheckpointHeader header = {};
+    header.magic = CHECKPOINT_MAGIC;
+    header.version = CHECKPOINT_VERSION;
+    header.match = match;
+    header.ticks = ticks;
+    header.snapshotBytes = bytes;
+    header.packedBytes = scratch.size() - sizeof(header);
+    std::memcpy(scratch.data(), &header, sizeof(header));
+
+    // Written beside the last checkpoint and renamed over it, so a crash mid-write leaves that one
+    const std::string path = checkpointPath(directory, match);
+    const std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(scratch.data()), static_cast<std::streamsize>(scratch.size()));
+        if (!out) {
+            LOG_WARN("Could not write the checkpoint of match %u to %s", match, temporary.c_str());
+            return false;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    if (error) {
+        LOG_WARN("Could not replace %s: %s", path.c_str(), error.message().c_str());
+        return false;
+    }
+    return true;
+}
+
+void removeCheckpointFile(const char* directory, uint32_t match) {
+    std::error_code error;
+    std::filesystem::remove(checkpointPath(directory, match), error);
+}
+
+static bool readCheckpointFile(const std::filesystem::path& path, LoadedCheckpoint& checkpoint) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) return false;
+    std::vector<unsigned char> buffer(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+    CheckpointHeader header;
+    if (!file || buffer.size() < sizeof(header)) return false;
+    std::memcpy(&header, buffer.data(), sizeof(header));
+    if (header.magic != CHECKPOINT_MAGIC || header.version != CHECKPOINT_VERSION) return false;
+    if (header.packedBytes != buffer.size() - sizeof(header)) return false; // Cut short
+    checkpoint.match = header.match;
+    checkpoint.ticks = header.ticks;
+    return unpackCheckpoint(buffer.data() + sizeof(header), static_cast<size_t>(header.packedBytes),
+                            static_cast<size_t>(header.snapshotBytes), checkpoint.snapshot);
+}
+
+std::vector<LoadedCheckpoint> loadCheckpoints(const char* directory) {
+    std::vector<LoadedCheckpoint> checkpoints;
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    for (std::filesystem::directory_iterator it(directory, error), end; !error && it != end; it.increment(error)) {
+        if (it->path().extension() != CHECKPOINT_EXTENSION) continue; // A .tmp a crash left behind among them
+        LoadedCheckpoint checkpoint;
+        if (readCheckpointFile(it->path(), checkpoint)) checkpoints.push_back(std::move(checkpoint));
+        else LOG_WARN("%s is not a version %u checkpoint; left as is", it->path().string().c_str(), CHECKPOINT_VERSION);
+    }
+    if (error) LOG_WARN("Could not list the checkpoints in %s: %s", directory, error.message().c_str());
+    std::sort(checkpoints.begin(), checkpoints.end(), [](const LoadedCheckpoint& a, const LoadedCheckpoint& b) { return a.match < b.match; });
+    return checkpoints;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Match checkpoints for the server (server.h): a match's world snapshot (snapshot.h) packed and
+// written to a file of its own, so a server that dies loses only the play since each match's last
+// checkpoint and a restarted one resumes them where they stood. The match's thread only copies its
+// world into a buffer at a tick boundary (the snapshot's memcpys); packing and writing are the
+// server's checkpoint thread's, and go through this file.
+// Packing: about half of a snapshot is zero bytes (the handle tables, dead bullet slots, flags and
+// the high bytes of small counts), so it is stored as alternating zero runs and literal stretches;
+// a zero run shorter than CHECKPOINT_MIN_ZERO_RUN stays in the literal around it. Packing and
+// unpacking are one pass each, with no dictionary to build.
+// A checkpoint is written beside the old one and renamed over it, so a crash mid-write leaves the
+// previous checkpoint whole. Like simulation.h, nothing here depends on GL.
+
+// ============================ FILE FORMAT ============================
+// CheckpointHeader, then the packed snapshot: (varint zero count, varint literal count, literal
+// bytes) until `snapshotBytes` are unpacked
+const uint32_t CHECKPOINT_MAGIC = 0x54504B43; // "CKPT"
+const uint32_t CHECKPOINT_VERSION = 1;
+const size_t CHECKPOINT_MIN_ZERO_RUN = 4;
+const char* const CHECKPOINT_EXTENSION = ".ckpt";
+
+struct CheckpointHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t match; // The server's match id
+    uint32_t reserved;
+    uint64_t ticks; // The match's ticks so far: the world as it stands after them
+    uint64_t snapshotBytes; // Unpacked
+    uint64_t packedBytes; // What follows the header
+};
+
+struct LoadedCheckpoint {
+    uint32_t match;
+    uint64_t ticks;
+    std::vector<unsigned char> snapshot; // Unpacked, for restoreWorldSnapshot
+};
+
+// ============================ CHECKPOINT API ============================
+// Appends the snapshot's packed form to `out`
+void packCheckpoint(const void* snapshot, size_t bytes, std::vector<unsigned char>& out);
+// Unpacks exactly `bytes` into `out`; false if the packed data is cut short or runs over
+bool unpackCheckpoint(const unsigned char* packed, size_t packedBytes, size_t bytes, std::vector<unsigned char>& out);
+
+// `directory`/match-<id>.ckpt
+std::string checkpointPath(const char* directory, uint32_t match);
+// Packs the snapshot into `scratch` (grown as needed, reused across calls) and writes it; false
+// (and a warning) if the file cannot be written, the previous checkpoint then kept
+bool writeCheckpointFile(const char* directory, uint32_t match, uint64_t ticks, const void* snapshot, size_t bytes,
+                         std::vector<unsigned char>& scratch);
+void removeCheckpointFile(const char* directory, uint32_t match);
+// Every readable checkpoint in the directory (created if missing), in match id order; the ones that
+// do not read are left where they are with a warning
+std::vector<LoadedCheckpoint> loadCheckpoints(const char* directory);
@@ -0,0 +1,224 @@
+#include "collision.h"
+
+#include <algorithm>
+#include <bit>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define COLLISION_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define COLLISION_TARGET_AVX2
+#else
+#define COLLISION_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+// ============================ KERNEL SELECTION ============================
+CollisionKernel bestCollisionKernel() {
+#if defined(COLLISION_X86)
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    bool osSavesAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+    __cpuidex(info, 7, 0);
+    if (osSavesAvx && (info[1] & (1 << 5)) != 0) return COLLISION_KERNEL_AVX2;
+#else
+    if (__builtin_cpu_supports("avx2")) return COLLISION_KERNEL_AVX2;
+#endif
+    return COLLISION_KERNEL_SSE2; // Baseline on x64
+#else
+    return COLLISION_KERNEL_SCALAR;
+#endif
+}
+
+static CollisionKernel activeKernel = bestCollisionKernel();
+
+void setCollisionKernel(CollisionKernel kernel) {
+    activeKernel = std::min(kernel, bestCollisionKernel());
+}
+
+CollisionKernel activeCollisionKernel() {
+    return activeKernel;
+}
+
+const char* collisionKernelName(CollisionKernel kernel) {
+    switch (kernel) {
+    case COLLISION_KERNEL_AVX2: return "avx2";
+    case COLLISION_KERNEL_SSE2: return "sse2";
+    default: return "scalar";
+    }
+}
+
+// ============================ CIRCLE OVERLAP ============================
+static uint64_t circleOverlapScalar(glm::vec2 center, float radius, const float* x, const float* y, const float* r,
+                                    size_t begin, size_t n) {
+    float distanceSq[COLLISION_MASK_BITS];
+    distanceSquaredBatch(center, x + begin, y + begin, n - begin, distanceSq);
+    uint64_t mask = 0;
+    for (size_t i = begin; i < n; ++i) {
+        float reach = radius + r[i];
+        if (distanceSq[i - begin] < reach * reach) mask |= uint64_t(1) << i;
+    }
+    return mask;
+}
+
+#if defined(COLLISION_X86)
+static uint64_t circleOverlapSse2(glm::vec2 center, float radius, const float* x, const float* y, const float* r, size_t n) {
+    const __m128 cx = _mm_set1_ps(center.x), cy = _mm_set1_ps(center.y), rad = _mm_set1_ps(radius);
+    uint64_t mask = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(x + i), cx);
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(y + i), cy);
+        __m128 reach = _mm_add_ps(_mm_loadu_ps(r + i), rad);
+        __m128 hit = _mm_cmplt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(reach, reach));
+        mask |= static_cast<uint64_t>(_mm_movemask_ps(hit)) << i;
+    }
+    return mask | circleOverlapScalar(center, radius, x, y, r, i, n);
+}
+
+COLLISION_TARGET_AVX2
+static uint64_t circleOverlapAvx2(glm::vec2 center, float radius, const float* x, const float* y, const float* r, size_t n) {
+    const __m256 cx = _mm256_set1_ps(center.x), cy = _mm256_set1_ps(center.y), rad = _mm256_set1_ps(radius);
+    uint64_t mask = 0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(x + i), cx);
+        __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(y + i), cy);
+        __m256 reach = _mm256_add_ps(_mm256_loadu_ps(r + i), rad);
+        // No FMA, so the sums round exactly like the SSE2 and scalar paths
+        __m256 distanceSq = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+        __m256 hit = _mm256_cmp_ps(distanceSq, _mm256_mul_ps(reach, reach), _CMP_LT_OQ);
+        mask |= static_cast<uint64_t>(_mm256_movemask_ps(hit)) << i;
+    }
+    _mm256_zeroupper(); // The tail and the caller are legacy SSE code: avoid the AVX/SSE transition stall
+    return mask | circleOverlapSse2(center, radius, x + i, y + i, r + i, n - i) << i;
+}
+#endif
+
+uint64_t circleOverlapMask(glm::vec2 center, float radius, const float* x, const float* y, const float* r, size_t n) {
+    n = std::min(n, COLLISION_MASK_BITS);
+#if defined(COLLISION_X86)
+    if (activeKernel == COLLISION_KERNEL_AVX2) return circleOverlapAvx2(center, radius, x, y, r, n);
+    if (activeKernel == COLLISION_KERNEL_SSE2) return circleOverlapSse2(center, radius, x, y, r, n);
+#endif
+    return circleOverlapScalar(center, radius, x, y, r, 0, n);
+}
+
+// ============================ DISTANCE BATCHES ============================
+// Plain loops over contiguous arrays (no aliasing, no branches) so the compiler can vectorize them.
+void distanceSquaredBatch(glm::vec2 center, const float* __restrict x, const float* __restrict y,
+                          size_t n, float* __restrict out) {
+    for (size_t i = 0; i < n; ++i) {
+        float dx = x[i] - center.x;
+        float dy = y[i] - center.y;
+        out[i] = dx * dx + dy * dy;
+    }
+}
+
+// Each segment runs from (px, py) - rockPrevious to (x, y) - rock, i.e. the motion in the rock's frame;
+// out is the squared distance from its closest point to the rock's centre
+void sweptDistanceSquaredBatch(glm::vec2 rockPrevious, glm::vec2 rock,
+                               const float* __restrict px, const float* __restrict py,
+                               const float* __restrict x, const float* __restrict y,
+                               size_t n, float* __restrict out) {
+    for (size_t i = 0; i < n; ++i) {
+        float sx = px[i] - rockPrevious.x;
+        float sy = py[i] - rockPrevious.y;
+        float tx = (x[i] - rock.x) - sx;
+        float ty = (y[i] - rock.y) - sy;
+        float lengthSq = tx * tx + ty * ty;
+        float t = lengthSq > 0.0f ? -(sx * tx + sy * ty) / lengthSq : 0.0f;
+        t = std::min(std::max(t, 0.0f), 1.0f);
+        float cx = sx + tx * t;
+        float cy = sy + ty * t;
+        out[i] = cx * cx + cy * cy;
+    }
+}
+
+// ============================ PAIR TESTS ============================
+static size_t sweptPairHitsScalar(const float* sx, const float* sy, const float* ex, const float* ey, const float* rock, const float* r,
+                                  float travel, size_t begin, size_t n, uint8_t* hit) {
+    size_t hits = 0;
+    for (size_t i = begin; i < n; ++i) {
+        const float nearReach = rock[i] + travel + r[i];
+        const float tx = ex[i] - sx[i];
+        const float ty = ey[i] - sy[i];
+        const float lengthSq = tx * tx + ty * ty;
+        float t = lengthSq > 0.0f ? -(sx[i] * tx + sy[i] * ty) / lengthSq : 0.0f;
+        t = std::min(std::max(t, 0.0f), 1.0f);
+        const float cx = sx[i] + tx * t;
+        const float cy = sy[i] + ty * t;
+        const float reach = rock[i] + r[i];
+        hit[i] = ex[i] * ex[i] + ey[i] * ey[i] < nearReach * nearReach && cx * cx + cy * cy < reach * reach;
+        hits += hit[i];
+    }
+    return hits;
+}
+
+#if defined(COLLISION_X86)
+static size_t sweptPairHitsSse2(const float* sx, const float* sy, const float* ex, const float* ey, const float* rock, const float* r,
+                                float travel, size_t n, uint8_t* hit) {
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f), tr = _mm_set1_ps(travel);
+    size_t hits = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m128 fromX = _mm_loadu_ps(sx + i), fromY = _mm_loadu_ps(sy + i);
+        const __m128 toX = _mm_loadu_ps(ex + i), toY = _mm_loadu_ps(ey + i);
+        const __m128 radius = _mm_loadu_ps(rock + i), bullet = _mm_loadu_ps(r + i);
+        const __m128 nearReach = _mm_add_ps(_mm_add_ps(radius, tr), bullet);
+        const __m128 tx = _mm_sub_ps(toX, fromX), ty = _mm_sub_ps(toY, fromY);
+        const __m128 lengthSq = _mm_add_ps(_mm_mul_ps(tx, tx), _mm_mul_ps(ty, ty));
+        const __m128 dot = _mm_add_ps(_mm_mul_ps(fromX, tx), _mm_mul_ps(fromY, ty));
+        __m128 t = _mm_and_ps(_mm_cmpgt_ps(lengthSq, zero), _mm_div_ps(_mm_sub_ps(zero, dot), lengthSq)); // 0 for a still path
+        t = _mm_min_ps(_mm_max_ps(t, zero), one);
+        const __m128 cx = _mm_add_ps(fromX, _mm_mul_ps(tx, t)), cy = _mm_add_ps(fromY, _mm_mul_ps(ty, t));
+        const __m128 reach = _mm_add_ps(radius, bullet);
+        const __m128 ends = _mm_cmplt_ps(_mm_add_ps(_mm_mul_ps(toX, toX), _mm_mul_ps(toY, toY)), _mm_mul_ps(nearReach, nearReach));
+        const __m128 passes = _mm_cmplt_ps(_mm_add_ps(_mm_mul_ps(cx, cx), _mm_mul_ps(cy, cy)), _mm_mul_ps(reach, reach));
+        const int mask = _mm_movemask_ps(_mm_and_ps(ends, passes));
+        for (int k = 0; k < 4; ++k) hit[i + k] = static_cast<uint8_t>((mask >> k) & 1);
+        hits += static_cast<size_t>(std::popcount(static_cast<unsigned>(mask)));
+    }
+    return hits + sweptPairHitsScalar(sx, sy, ex, ey, rock, r, travel, i, n, hit);
+}
+
+COLLISION_TARGET_AVX2
+static size_t sweptPairHitsAvx2(const float* sx, const float* sy, const float* ex, const float* ey, const float* rock, const float* r,
+                                float travel, size_t n, uint8_t* hit) {
+    const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f), tr = _mm256_set1_ps(travel);
+    size_t hits = 0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256 fromX = _mm256_loadu_ps(sx + i), fromY = _mm256_loadu_ps(sy + i);
+        const __m256 toX = _mm256_loadu_ps(ex + i), toY = _mm256_loadu_ps(ey + i);
+        const __m256 radius = _mm256_loadu_ps(rock + i), bullet = _mm256_loadu_ps(r + i);
+        const __m256 nearReach = _mm256_add_ps(_mm256_add_ps(radius, tr), bullet);
+        // No FMA here either, so every pair rounds as the scalar path does
+        const __m256 tx = _mm256_sub_ps(toX, fromX), ty = _mm256_sub_ps(toY, fromY);
+        const __m256 lengthSq = _mm256_add_ps(_mm256_mul_ps(tx, tx), _mm256_mul_ps(ty, ty));
+        const __m256 dot = _mm256_add_ps(_mm256_mul_ps(fromX, tx), _mm256_mul_ps(fromY, ty));
+        __m256 t = _mm256_and_ps(_mm256_cmp_ps(lengthSq, zero, _CMP_GT_OQ), _mm256_div_ps(_mm256_sub_ps(zero, dot), lengthSq));
+        t = _mm256_min_ps(_mm256_max_ps(t, zero), one);
+        const __m256 cx = _mm256_add_ps(fromX, _mm256_mul_ps(tx, t)), cy = _mm256_add_ps(fromY, _mm256_mul_ps(ty, t));
+        const __m256 reach = _mm256_add_ps(radius, bullet);
+        const __m256 ends = _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(toX, toX), _mm256_mul_ps(toY, toY)), _mm256_mul_ps(nearReach, nearReach), _CMP_LT_OQ);
+        const __m256 passes = _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(cx, cx), _mm256_mul_ps(cy, cy)), _mm256_mul_ps(reach, reach), _CMP_LT_OQ);
+        const int mask = _mm256_movemask_ps(_mm256_and_ps(ends, passes));
+        for (int k = 0; k < 8; ++k) hit[i + k] = static_cast<uint8_t>((mask >> k) & 1);
+        hits += static_cast<size_t>(std::popcount(static_cast<unsigned>(mask)));
+    }
+    _mm256_zeroupper();
+    return hits + sweptPairHitsScalar(sx, sy, ex, ey, rock, r, travel, i, n, hit);
+}
+#endif
+
+size_t sweptPairHits(const float* sx, const float* sy, const float* ex, const float* ey, const float* rock, const float* r,
+                     float travel, size_t n, uint8_t* hit) {
+#if defined(COLLISION_X86)
+    if (activeKernel == COLLISION_KERNEL_AVX2) return sweptPairHitsAvx2(sx, sy, ex, ey, rock, r, travel, n, hit);
+    if (activeKernel == COLLISION_KERNEL_SSE2) return sweptPairHitsSse2(sx, sy, ex, ey, rock, r, travel, n, hit);
+#endif
+    return sweptPairHitsScalar(sx, sy, ex, ey, rock, r, travel, 0, n, hit);
+}
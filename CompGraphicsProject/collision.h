@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+// Batched collision kernels over gathered candidate arrays (structure of arrays, contiguous).
+// The one-vs-many overlap test picks its instruction set at runtime: AVX2 (8 wide) when the CPU
+// and OS support it, otherwise SSE2 (4 wide), otherwise scalar. All three give identical results.
+
+// ============================ KERNEL SELECTION ============================
+enum CollisionKernel { COLLISION_KERNEL_SCALAR, COLLISION_KERNEL_SSE2, COLLISION_KERNEL_AVX2 };
+
+CollisionKernel bestCollisionKernel(); // Widest kernel this machine can run
+void setCollisionKernel(CollisionKernel kernel); // Clamped to bestCollisionKernel() (e.g. --simd scalar for comparisons)
+CollisionKernel activeCollisionKernel();
+const char* collisionKernelName(CollisionKernel kernel);
+
+// ============================ KERNELS ============================
+const size_t COLLISION_MASK_BITS = 64; // Max circles per circleOverlapMask call
+
+// Bit i set if circle (x[i], y[i], r[i]) overlaps the circle (center, radius); n <= COLLISION_MASK_BITS
+uint64_t circleOverlapMask(glm::vec2 center, float radius, const float* x, const float* y, const float* r, size_t n);
+
+// out[i] = |(x[i], y[i]) - center|^2
+void distanceSquaredBatch(glm::vec2 center, const float* x, const float* y, size_t n, float* out);
+// out[i] = squared closest approach of a bullet's motion this tick (prev -> current) to a moving rock
+void sweptDistanceSquaredBatch(glm::vec2 rockPrevious, glm::vec2 rock, const float* px, const float* py,
+                               const float* x, const float* y, size_t n, float* out);
+
+// ============================ PAIR TESTS ============================
+// Many rocks at once: pair i is a bullet's path this tick in its rock's frame, from (sx, sy) to (ex, ey)
+// relative to the rock's centre then and now, with the rock's radius `rock` and the bullet's `r`. hit[i]
+// is 1 if the path ends within rock + travel + r of the centre and passes within rock + r of it: the
+// tests circleOverlapMask and sweptDistanceSquaredBatch make of one rock's candidates, rounded the
+// same way. Returns the hits.
+size_t sweptPairHits(const float* sx, const float* sy, const float* ex, const float* ey, const float* rock, const float* r,
+                     float travel, size_t n, uint8_t* hit);
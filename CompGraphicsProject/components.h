@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "simulation.h"
+
+// ============================ COMPONENTS ============================
+// Optional parts of an entity (a shield of its own, AI state, a trail, an emitter, a network id),
+// kept out of the stores' hot arrays (simulation.h) so that what only a few entities have costs the
+// rest nothing. Each component type has a pool: a sparse set over the owning store's handle slots,
+// `sparse` giving a slot's place in the dense arrays, which hold the owners' handles and the values
+// packed together, so walking a component touches only the entities that have it. Adding, finding
+// and removing are O(1); a removal moves the last one into the hole, as the stores do.
+// A pool's slots are one store's (the rocks' HandleTable, the bullet ring's slots), so a registry
+// belongs to one kind of entity. A component outlives its entity unless it is removed with it: a
+// handle whose generation has moved on no longer finds it, and prune() sweeps such leftovers in one
+// pass (once a tick, after the store's sweep, is enough).
+// In use: the shape stream's per-rock choice of a drawn shape (shapestream.cpp).
+const uint32_t NO_COMPONENT = UINT32_MAX;
+
+template <typename T>
+struct ComponentPool {
+    std::vector<uint32_t> sparse; // Per slot: its dense index, or NO_COMPONENT (grows to the highest slot given one)
+    std::vector<EntityHandle> owners; // Dense
+    std::vector<T> values; // Dense, alongside owners
+
+    size_t size() const { return values.size(); }
+
+    // Dense index of h's component, or NO_COMPONENT (none, or one left by an earlier entity in its slot)
+    uint32_t find(EntityHandle h) const {
+        if (h.slot >= sparse.size()) return NO_COMPONENT;
+        const uint32_t i = sparse[h.slot];
+        return i != NO_COMPONENT && owners[i].generation == h.generation ? i : NO_COMPONENT;
+    }
+    bool has(EntityHandle h) const { return find(h) != NO_COMPONENT; }
+    T* get(EntityHandle h) {
+        const uint32_t i = find(h);
+        return i == NO_COMPONENT ? nullptr : &values[i];
+    }
+    const T* get(EntityHandle h) const {
+        const uint32_t i = find(h);
+        return i == NO_COMPONENT ? nullptr : &values[i];
+    }
+
+    // Gives h the component, replacing its own or one left in the slot by an earlier entity
+    T& set(EntityHandle h, const T& value) {
+        if (h.slot >= sparse.size()) sparse.resize(static_cast<size_t>(h.slot) + 1, NO_COMPONENT);
+        const uint32_t i = sparse[h.slot];
+        if (i != NO_COMPONENT) {
+            owners[i] = h;
+            values[i] = value;
+            return values[i];
+        }
+        sparse[h.slot] = static_cast<uint32_t>(values.size());
+        owners.push_back(h);
+        values.push_back(value);
+        return values.back();
+    }
+
+    void remove(EntityHandle h) {
+        const uint32_t i = find(h);
+        if (i != NO_COMPONENT) removeAt(i);
+    }
+
+    void removeAt(uint32_t i) {
+        const uint32_t last = static_cast<uint32_t>(values.size() - 1);
+        sparse[owners[i].slot] = NO_COMPONENT;
+        if (i != last) {
+            owners[i] = owners[last];
+            values[i] = std::move(values[last]);
+            sparse[owners[i].slot] = i;
+        }
+        owners.pop_back();
+        values.pop_back();
+    }
+
+    // Drops every component whose entity is gone; `generation` is the owning store's, per slot
+    // (HandleTable::generation, BulletStore::generation). Returns how many went.
+    size_t prune(const std::vector<uint32_t>& generation) {
+        size_t removed = 0;
+        for (size_t i = values.size(); i > 0; --i) {
+            const EntityHandle owner = owners[i - 1];
+            if (owner.slot < generation.size() && generation[owner.slot] == owner.generation) continue;
+            removeAt(static_cast<uint32_t>(i - 1));
+            ++removed;
+        }
+        return removed;
+    }
+
+    void clear() {
+        sparse.clear();
+        owners.clear();
+        values.clear();
+    }
+
+    // Room for the store's `slots` and `n` components, so adding them allocates nothing
+    void reserve(size_t slots, size_t n) {
+        if (sparse.size() < slots) sparse.resize(slots, NO_COMPONENT);
+        owners.reserve(n);
+        values.reserve(n);
+    }
+
+    size_t memoryBytes() const {
+        return sparse.capacity() * sizeof(uint32_t) + owners.capacity() * sizeof(EntityHandle) + values.capacity() * sizeof(T);
+    }
+};
+
+// A pool per component type (each type once) for one kind of entity
+template <typename... Components>
+struct ComponentRegistry {
+    std::tuple<ComponentPool<Components>...> pools;
+
+    template <typename T> ComponentPool<T>& pool() { return std::get<ComponentPool<T>>(pools); }
+    template <typename T> const ComponentPool<T>& pool() const { return std::get<ComponentPool<T>>(pools); }
+    template <typename T> T& set(EntityHandle h, const T& value) { return pool<T>().set(h, value); }
+    template <typename T> T* get(EntityHandle h) { return pool<T>().get(h); }
+    template <typename T> const T* get(EntityHandle h) const { return pool<T>().get(h); }
+    template <typename T> bool has(EntityHandle h) const { return pool<T>().has(h); }
+
+    void remove(EntityHandle h) { (pool<Components>().remove(h), ...); } // Every component h has
+    size_t prune(const std::vector<uint32_t>& generation) { return (pool<Components>().prune(generation) + ... + size_t(0)); }
+    void clear() { (pool<Components>().clear(), ...); }
+    size_t memoryBytes() const { return (pool<Components>().memoryBytes() + ... + size_t(0)); }
+
+    // Calls fn(handle, first, rest...) with references to the values of every entity that has all of
+    // First, Rest..., in First's dense order (lead with the rarest: the others are looked up). fn may
+    // change the values, but not add or remove components of these types.
+    template <typename First, typename... Rest, typename Fn>
+    void view(Fn&& fn) {
+        ComponentPool<First>& lead = pool<First>();
+        for (size_t i = 0; i < lead.size(); ++i) {
+            const EntityHandle h = lead.owners[i];
+            const std::tuple<Rest*...> others(pool<Rest>().get(h)...);
+            if (!std::apply([](Rest*... parts) { return ((parts != nullptr) && ... && true); }, others)) continue;
+            std::apply([&](Rest*... parts) { fn(h, lead.values[i], *parts...); }, others);
+        }
+    }
+};
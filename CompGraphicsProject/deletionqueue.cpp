@@ -0,0 +1,52 @@
+#include "deletionqueue.h"
+
+DeletionQueue deletionQueue;
+
+static void deleteObject(const DeletionQueue::Retired& object)
+{
+    switch (object.type) {
+    case RETIRED_BUFFER: glDeleteBuffers(1, &object.name); break;
+    case RETIRED_VERTEX_ARRAY: glDeleteVertexArrays(1, &object.name); break;
+    case RETIRED_TEXTURE: glDeleteTextures(1, &object.name); break;
+    case RETIRED_FRAMEBUFFER: glDeleteFramebuffers(1, &object.name); break;
+    case RETIRED_PROGRAM: glDeleteProgram(object.name); break;
+    }
+}
+
+static void deleteBatch(DeletionQueue::Batch& batch)
+{
+    for (const DeletionQueue::Retired& object : batch.objects) deleteObject(object);
+    if (batch.fence) glDeleteSync(batch.fence);
+}
+
+void DeletionQueue::retire(RetiredObjectType type, unsigned int name)
+{
+    if (name == 0) return;
+    if (batches.empty() || batches.back().fence) batches.emplace_back();
+    batches.back().objects.push_back({ type, name });
+}
+
+void DeletionQueue::endFrame()
+{
+    if (batches.empty() || batches.back().fence) return;
+    batches.back().fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void DeletionQueue::collect()
+{
+    // Fences signal in submission order, so stop at the first batch that is still pending
+    size_t done = 0;
+    while (done < batches.size() && batches[done].fence) {
+        GLenum state = glClientWaitSync(batches[done].fence, 0, 0);
+        if (state != GL_ALREADY_SIGNALED && state != GL_CONDITION_SATISFIED) break;
+        deleteBatch(batches[done]);
+        ++done;
+    }
+    batches.erase(batches.begin(), batches.begin() + done);
+}
+
+void DeletionQueue::flush()
+{
+    for (Batch& batch : batches) deleteBatch(batch);
+    batches.clear();
+}
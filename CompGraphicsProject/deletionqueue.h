@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <glad/glad.h>
+
+// ============================ DEFERRED GL DELETION ============================
+// GL objects that draws still in flight may reference are retired here instead of being deleted on
+// the spot, which can make the driver wait for the GPU. Everything retired during a frame waits
+// behind one fence inserted at the end of that frame and is deleted once the fence has signalled.
+enum RetiredObjectType {
+    RETIRED_BUFFER,
+    RETIRED_VERTEX_ARRAY,
+    RETIRED_TEXTURE,
+    RETIRED_FRAMEBUFFER,
+    RETIRED_PROGRAM
+};
+
+struct DeletionQueue {
+    struct Retired {
+        RetiredObjectType type;
+        unsigned int name;
+    };
+    struct Batch {
+        GLsync fence = 0; // Fenced by endFrame(); 0 while the frame is still being recorded
+        std::vector<Retired> objects;
+    };
+    std::vector<Batch> batches; // Oldest first
+
+    void retire(RetiredObjectType type, unsigned int name);
+    // Fences what this frame retired; call after the frame's last draw
+    void endFrame();
+    // Deletes every batch whose fence has signalled, without waiting for the others
+    void collect();
+    // Deletes everything now (at shutdown, while the context is still current)
+    void flush();
+};
+
+extern DeletionQueue deletionQueue;
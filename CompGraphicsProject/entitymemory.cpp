@@ -0,0 +1,273 @@
+#include "entitymemory.h"
+#include "log.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <string>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Each block starts with this header, a cache line long so the array after it keeps its alignment
+struct alignas(ENTITY_ARRAY_ALIGNMENT) EntityBlock {
+    size_t bytes; // The array's, padded
+    size_t alignment; // The operator new alignment it came from (0: VirtualAlloc)
+    bool largePages;
+    int node; // The NUMA node it is bound to (-1: none)
+};
+static_assert(sizeof(EntityBlock) == ENTITY_ARRAY_ALIGNMENT, "The header is one cache line");
+
+const size_t LARGE_PAGE_BYTES = size_t(2) << 20;
+
+static std::atomic<bool> largePages(false);
+static std::atomic<size_t> liveBytes(0);
+static std::atomic<size_t> liveLargePageBytes(0);
+static std::atomic<size_t> liveNodeBytes[ENTITY_MAX_NUMA_NODES];
+static thread_local int memoryNode = -1;
+const size_t NUMA_PAGE_BYTES = 4096;
+
+// ============================ LARGE PAGES ============================
+#if defined(_WIN32)
+// Large pages must be locked, which takes SeLockMemoryPrivilege: granted by the "Lock pages in memory"
+// policy, then switched on in the process token
+static bool enableLockMemoryPrivilege() {
+    HANDLE token;
+    if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token)) return false;
+    TOKEN_PRIVILEGES privileges = {};
+    privileges.PrivilegeCount = 1;
+    privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+    bool enabled = LookupPrivilegeValueA(NULL, "SeLockMemoryPrivilege", &privileges.Privileges[0].Luid) &&
+                   AdjustTokenPrivileges(token, FALSE, &privileges, 0, NULL, NULL) && GetLastError() == ERROR_SUCCESS;
+    CloseHandle(token);
+    return enabled;
+}
+#endif
+
+void setEntityLargePages(bool enabled) {
+#if defined(_WIN32)
+    if (enabled && (GetLargePageMinimum() == 0 || !enableLockMemoryPrivilege())) {
+        LOG_WARN("Large pages need the \"Lock pages in memory\" right; entity arrays stay on ordinary pages");
+        enabled = false;
+    }
+#elif !defined(__linux__)
+    if (enabled) {
+        LOG_WARN("Large pages are only supported on Windows and Linux; entity arrays stay on ordinary pages");
+        enabled = false;
+    }
+#endif
+    largePages.store(enabled, std::memory_order_relaxed);
+}
+
+bool entityLargePagesEnabled() {
+    return largePages.load(std::memory_order_relaxed);
+}
+
+EntityMemoryTotals entityMemoryTotals() {
+    return { liveBytes.load(std::memory_order_relaxed), liveLargePageBytes.load(std::memory_order_relaxed) };
+}
+
+// ============================ NUMA NODES ============================
+struct NumaLayout {
+    int nodes = 1;
+    int nodeOfCpu[64] = {};
+};
+
+#if defined(__linux__)
+// A sysfs CPU or node list ("0-3,8,10-11") as a mask of its first 64 entries; 0 if the file is missing
+static uint64_t readSysfsList(const std::string& path) {
+    std::ifstream in(path);
+    std::string list;
+    if (!std::getline(in, list)) return 0;
+    uint64_t mask = 0;
+    const char* p = list.c_str();
+    while (*p) {
+        char* end = nullptr;
+        const long first = std::strtol(p, &end, 10);
+        if (end == p) break;
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            last = std::strtol(p + 1, &end, 10);
+            p = end;
+        }
+        for (long k = first; k <= last && k < 64; ++k) mask |= uint64_t(1) << k;
+        if (*p == ',') ++p;
+        else break;
+    }
+    return mask;
+}
+#endif
+
+static NumaLayout readNumaLayout() {
+    NumaLayout layout;
+#if defined(_WIN32)
+    ULONG highest = 0;
+    if (!GetNumaHighestNodeNumber(&highest)) return layout;
+    layout.nodes = std::min(static_cast<int>(highest) + 1, ENTITY_MAX_NUMA_NODES);
+    for (int cpu = 0; cpu < 64; ++cpu) {
+        PROCESSOR_NUMBER processor = {};
+        processor.Number = static_cast<BYTE>(cpu);
+        USHORT node = 0;
+        if (GetNumaProcessorNodeEx(&processor, &node) && node < layout.nodes) layout.nodeOfCpu[cpu] = node;
+    }
+#elif defined(__linux__)
+    const uint64_t online = readSysfsList("/sys/devices/system/node/online");
+    for (int node = 1; node < ENTITY_MAX_NUMA_NODES; ++node) {
+        if (online & (uint64_t(1) << node)) layout.nodes = node + 1;
+    }
+    for (int node = 0; node < layout.nodes; ++node) {
+        const uint64_t cpus = readSysfsList("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        for (int cpu = 0; cpu < 64; ++cpu) {
+            if (cpus & (uint64_t(1) << cpu)) layout.nodeOfCpu[cpu] = node;
+        }
+    }
+#endif
+    return layout;
+}
+
+static const NumaLayout& numaLayout() {
+    static const NumaLayout layout = readNumaLayout();
+    return layout;
+}
+
+int numaNodeCount() {
+    return numaLayout().nodes;
+}
+
+int numaNodeOfCpu(int cpu) {
+    return cpu >= 0 && cpu < 64 ? numaLayout().nodeOfCpu[cpu] : 0;
+}
+
+void setEntityMemoryNode(int node) {
+    memoryNode = node >= 0 && node < numaNodeCount() ? node : -1;
+}
+
+size_t entityNodeBytes(int node) {
+    return node >= 0 && node < ENTITY_MAX_NUMA_NODES ? liveNodeBytes[node].load(std::memory_order_relaxed) : 0;
+}
+
+// Prefers `node` for the pages of [block, block + bytes), which must be whole pages of the block's own
+static bool bindToNode(void* block, size_t bytes, int node) {
+#if defined(__linux__)
+    const int MPOL_PREFERRED_MODE = 1; // <numaif.h>'s MPOL_PREFERRED, without needing libnuma
+    unsigned long mask = 1ul << node;
+    return syscall(SYS_mbind, block, bytes, MPOL_PREFERRED_MODE, &mask, sizeof(mask) * 8, 0) == 0;
+#else
+    (void)block; (void)bytes; (void)node;
+    return false;
+#endif
+}
+
+// A block of `total` bytes (header included) on whole pages bound to `node`, or nullptr if the
+// system will not bind them
+static EntityBlock* allocateOnNode(size_t total, int node) {
+#if defined(_WIN32)
+    void* block = VirtualAllocExNuma(GetCurrentProcess(), NULL, total, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE, static_cast<DWORD>(node));
+    if (!block) return nullptr;
+    EntityBlock* header = static_cast<EntityBlock*>(block);
+    header->alignment = 0;
+    return header;
+#elif defined(__linux__)
+    // Untouched until bound, so the first faults already land on the node
+    const size_t rounded = (total + NUMA_PAGE_BYTES - 1) / NUMA_PAGE_BYTES * NUMA_PAGE_BYTES;
+    void* block = ::operator new(rounded, std::align_val_t(NUMA_PAGE_BYTES));
+    if (!bindToNode(block, rounded, node)) {
+        ::operator delete(block, std::align_val_t(NUMA_PAGE_BYTES));
+        return nullptr;
+    }
+    EntityBlock* header = static_cast<EntityBlock*>(block);
+    header->alignment = NUMA_PAGE_BYTES;
+    return header;
+#else
+    (void)total; (void)node;
+    return nullptr;
+#endif
+}
+
+// A block of `total` bytes (header included) on large pages (bound to `node` unless it is -1), or
+// nullptr if the system has none to give
+static EntityBlock* allocateLargePages(size_t total, int node) {
+#if defined(_WIN32)
+    const size_t page = GetLargePageMinimum();
+    const size_t rounded = (total + page - 1) / page * page;
+    const DWORD flags = MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES;
+    void* block = node >= 0 ? VirtualAllocExNuma(GetCurrentProcess(), NULL, rounded, flags, PAGE_READWRITE, static_cast<DWORD>(node))
+                            : VirtualAlloc(NULL, rounded, flags, PAGE_READWRITE);
+    if (!block) return nullptr;
+    EntityBlock* header = static_cast<EntityBlock*>(block);
+    header->alignment = 0;
+    return header;
+#elif defined(__linux__)
+    // Aligned to the huge page so khugepaged (or the fault handler) can back all of it; the memory is
+    // only touched after the advice, so the first faults already get huge pages where THP allows
+    const size_t rounded = (total + LARGE_PAGE_BYTES - 1) / LARGE_PAGE_BYTES * LARGE_PAGE_BYTES;
+    void* block = ::operator new(rounded, std::align_val_t(LARGE_PAGE_BYTES));
+    if (madvise(block, rounded, MADV_HUGEPAGE) != 0 || (node >= 0 && !bindToNode(block, rounded, node))) {
+        ::operator delete(block, std::align_val_t(LARGE_PAGE_BYTES));
+        return nullptr;
+    }
+    EntityBlock* header = static_cast<EntityBlock*>(block);
+    header->alignment = LARGE_PAGE_BYTES;
+    return header;
+#else
+    (void)total; (void)node;
+    return nullptr;
+#endif
+}
+
+// ============================ ALLOCATION ============================
+void* allocateEntityArray(size_t bytes) {
+    bytes = (bytes + ENTITY_ARRAY_PADDING - 1) / ENTITY_ARRAY_PADDING * ENTITY_ARRAY_PADDING;
+    const size_t total = sizeof(EntityBlock) + bytes;
+    EntityBlock* header = nullptr;
+    const int node = bytes >= ENTITY_NUMA_BIND_BYTES ? memoryNode : -1;
+    if (bytes >= LARGE_PAGE_BYTES && largePages.load(std::memory_order_relaxed)) {
+        header = allocateLargePages(total, node);
+        if (!header) {
+            LOG_WARN("No large pages for a %zu-byte entity array; entity arrays stay on ordinary pages from here on", bytes);
+            largePages.store(false, std::memory_order_relaxed);
+        }
+    }
+    if (header) {
+        header->largePages = true;
+        liveLargePageBytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+    else {
+        header = node >= 0 ? allocateOnNode(total, node) : nullptr;
+        if (!header) {
+            header = static_cast<EntityBlock*>(::operator new(total, std::align_val_t(ENTITY_ARRAY_ALIGNMENT)));
+            header->alignment = ENTITY_ARRAY_ALIGNMENT;
+        }
+        header->largePages = false;
+    }
+    header->node = node >= 0 && header->alignment != ENTITY_ARRAY_ALIGNMENT ? node : -1;
+    if (header->node >= 0) liveNodeBytes[header->node].fetch_add(bytes, std::memory_order_relaxed);
+    header->bytes = bytes;
+    liveBytes.fetch_add(bytes, std::memory_order_relaxed);
+    return header + 1;
+}
+
+void freeEntityArray(void* pointer) {
+    if (!pointer) return;
+    EntityBlock* header = static_cast<EntityBlock*>(pointer) - 1;
+    liveBytes.fetch_sub(header->bytes, std::memory_order_relaxed);
+    if (header->largePages) liveLargePageBytes.fetch_sub(header->bytes, std::memory_order_relaxed);
+    if (header->node >= 0) liveNodeBytes[header->node].fetch_sub(header->bytes, std::memory_order_relaxed);
+#if defined(_WIN32)
+    if (header->alignment == 0) {
+        VirtualFree(header, 0, MEM_RELEASE);
+        return;
+    }
+#endif
+    ::operator delete(header, std::align_val_t(header->alignment));
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// ============================ ENTITY MEMORY ============================
+// Backing store for the entity stores' structure-of-arrays fields (simulation.h) and the bots' lanes.
+// Every array starts on a cache line and its block is padded to a whole number of them, so a SIMD
+// kernel's aligned register loads never straddle a line and the last one never leaves the block: lanes
+// sized with paddedEntityCount() can be run in whole registers, with no remainder loop. With large pages on (--large-pages, before any world is built) arrays of a large page or more
+// are mapped on 2 MiB pages instead (VirtualAlloc with MEM_LARGE_PAGES, which needs the "Lock pages in
+// memory" right; transparent huge pages through madvise on Linux), cutting the TLB misses of worlds
+// with hundreds of thousands of rocks. An allocation the system refuses large pages for falls back to
+// ordinary ones. Everything but the Windows large-page blocks goes through the tracked operator new
+// (alloctrack.h), so the allocation guard still sees a store that grows in the steady state.
+// On a multi-socket host a thread may ask for its arrays on one NUMA node (setEntityMemoryNode; the
+// match server's threads ask for their own): arrays of ENTITY_NUMA_BIND_BYTES or more are then
+// given whole pages of their own, bound to that node (mbind with MPOL_PREFERRED on Linux, so a full
+// node still spills over; VirtualAllocExNuma on Windows, outside the tracked operator new like the
+// large-page blocks). Smaller ones are left to the system's first-touch placement.
+const size_t ENTITY_ARRAY_ALIGNMENT = 64; // A cache line, and a whole AVX-512 register
+const size_t ENTITY_ARRAY_PADDING = 64;
+const size_t ENTITY_NUMA_BIND_BYTES = size_t(64) << 10; // Smaller arrays are not worth whole pages of their own
+const int ENTITY_MAX_NUMA_NODES = 16;
+
+void setEntityLargePages(bool enabled);
+bool entityLargePagesEnabled();
+// Bytes of the live entity arrays on large pages, and in all
+struct EntityMemoryTotals {
+    size_t bytes;
+    size_t largePageBytes;
+};
+EntityMemoryTotals entityMemoryTotals();
+
+// ============================ NUMA NODES ============================
+// Read once from the system: /sys/devices/system/node on Linux, the NUMA API on Windows. A host
+// without NUMA (or one whose layout cannot be read) is one node holding every CPU.
+int numaNodeCount(); // At most ENTITY_MAX_NUMA_NODES
+int numaNodeOfCpu(int cpu); // Logical CPU (the first 64, as for thread affinity) to its node
+// The calling thread's later entity arrays go on `node` (-1: wherever the system puts them)
+void setEntityMemoryNode(int node);
+size_t entityNodeBytes(int node); // Bytes of the live entity arrays bound to `node`
+
+void* allocateEntityArray(size_t bytes);
+void freeEntityArray(void* pointer);
+
+// Elements of T in n rounded up to whole ENTITY_ARRAY_PADDING blocks: size a lane with this to
+// process it a register at a time with no remainder
+template <typename T>
+constexpr size_t paddedEntityCount(size_t n) {
+    constexpr size_t perBlock = ENTITY_ARRAY_PADDING / sizeof(T);
+    return (n + perBlock - 1) / perBlock * perBlock;
+}
+
+// std allocator adapter over allocateEntityArray
+template <typename T>
+struct EntityAllocator {
+    using value_type = T;
+
+    EntityAllocator() = default;
+    template <typename U>
+    EntityAllocator(const EntityAllocator<U>&) {}
+
+    T* allocate(size_t count) { return static_cast<T*>(allocateEntityArray(count * sizeof(T))); }
+    void deallocate(T* pointer, size_t) { freeEntityArray(pointer); }
+
+    template <typename U>
+    bool operator==(const EntityAllocator<U>&) const { return true; }
+};
+
+template <typename T>
+using EntityArray = std::vector<T, EntityAllocator<T>>;
@@ -0,0 +1,81 @@
+#include "exhaust.h"
+#include "simulation.h"
+#include "fastmath.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/gtc/constants.hpp>
+
+// SIMD: as simulation.cpp
+#if defined(__AVX__)
+#include <immintrin.h>
+#define EXHAUST_SIMD_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define EXHAUST_SIMD_SSE2 1
+#endif
+
+// age[i] += dt
+static void advanceAges(float* age, size_t n, float dt) {
+    size_t i = 0;
+#if defined(EXHAUST_SIMD_AVX)
+    __m256 dt8 = _mm256_set1_ps(dt);
+    for (; i + 8 <= n; i += 8) _mm256_storeu_ps(age + i, _mm256_add_ps(_mm256_loadu_ps(age + i), dt8));
+#elif defined(EXHAUST_SIMD_SSE2)
+    __m128 dt4 = _mm_set1_ps(dt);
+    for (; i + 4 <= n; i += 4) _mm_storeu_ps(age + i, _mm_add_ps(_mm_loadu_ps(age + i), dt4));
+#endif
+    for (; i < n; ++i) age[i] += dt;
+}
+
+void ExhaustPool::init(size_t capacity, uint64_t seed) {
+    for (std::vector<float>* field : { &x, &y, &vx, &vy, &rotation, &age, &lifetime, &scale }) field->assign(capacity, 0.0f);
+    count = 0;
+    owed = 0.0f;
+    rng.seed(seed, RNG_STREAM_EXHAUST);
+}
+
+size_t ExhaustPool::memoryBytes() const {
+    return 8 * x.capacity() * sizeof(float);
+}
+
+void ExhaustPool::step(float dt) {
+    integrateLinear(x.data(), vx.data(), count, dt);
+    integrateLinear(y.data(), vy.data(), count, dt);
+    const float damping = std::pow(EXHAUST_DRAG, dt);
+    dampVelocity(vx.data(), count, damping);
+    dampVelocity(vy.data(), count, damping);
+    advanceAges(age.data(), count, dt);
+    for (size_t i = count; i > 0; --i) {
+        const size_t p = i - 1;
+        if (age[p] < lifetime[p]) continue;
+        const size_t last = --count;
+        for (std::vector<float>* field : { &x, &y, &vx, &vy, &rotation, &age, &lifetime, &scale }) (*field)[p] = (*field)[last];
+    }
+    owed += EXHAUST_RATE * dt;
+    perShip = static_cast<int>(owed);
+    owed -= static_cast<float>(perShip);
+}
+
+void ExhaustPool::emit(glm::vec2 position, float shipRotation, glm::vec2 velocity, float shipScale) {
+    const float angle = shipRotation + glm::half_pi<float>(); // As GameWorld::steerShip: the model points up
+    glm::vec2 back;
+    fastSinCos(angle, back.y, back.x);
+    back = -back;
+    const glm::vec2 side(-back.y, back.x);
+    for (int k = 0; k < perShip && count < capacity(); ++k) {
+        const size_t p = count++;
+        const float spread = rng.range(-0.5f, 0.5f);
+        const glm::vec2 start = position + back * shipScale * rng.range(0.3f, 0.7f) + side * shipScale * 0.3f * spread;
+        const glm::vec2 drift = velocity + back * EXHAUST_SPEED * rng.range(0.6f, 1.4f) + side * 0.15f * spread;
+        x[p] = start.x;
+        y[p] = start.y;
+        vx[p] = drift.x;
+        vy[p] = drift.y;
+        rotation[p] = shipRotation + spread * 0.6f;
+        age[p] = 0.0f;
+        lifetime[p] = rng.range(EXHAUST_MIN_LIFETIME, EXHAUST_MAX_LIFETIME);
+        scale[p] = shipScale * rng.range(0.25f, 0.45f);
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "random.h"
+
+// Thrust exhaust: a plume of short-lived flame particles behind every ship with its engine on, in
+// place of the one static fire triangle. The particles are a struct of arrays sized once for every
+// ship there can be, so a frame never allocates: each frame ages and moves them all with the
+// simulation's SIMD kernels, drops the dead by moving the last live one into their place, and adds
+// the new ones at the end. The batched pass draws every ship's plume as instances of the fire mesh
+// in one draw. Cosmetic only, stepped on the render thread at the frame rate; like simulation.h,
+// nothing here depends on GL.
+
+// ============================ EXHAUST CONSTANTS ============================
+const int EXHAUST_PARTICLES_PER_SHIP = 256; // Pool capacity per ship (the rate times the longest life, with room)
+const float EXHAUST_RATE = 240.0f; // Particles per second behind each thrusting ship
+const float EXHAUST_SPEED = 0.6f; // Field units per second out of the nozzle, on top of the ship's own velocity
+const float EXHAUST_DRAG = 0.02f; // Of the velocity, what is left after a second
+const float EXHAUST_MIN_LIFETIME = 0.2f, EXHAUST_MAX_LIFETIME = 0.45f; // Seconds
+
+// ============================ EXHAUST POOL ============================
+struct ExhaustPool {
+    // One entry per particle; the live ones are [0, count)
+    std::vector<float> x, y, vx, vy, rotation, age, lifetime, scale;
+    size_t count = 0;
+    int perShip = 0; // Particles each thrusting ship adds this frame (set by step)
+    float owed = 0.0f; // The fraction of a particle the last frame's rate left over
+    Rng rng;
+
+    void init(size_t capacity, uint64_t seed);
+    size_t capacity() const { return x.size(); }
+    size_t memoryBytes() const;
+    // Ages and moves every particle by dt seconds, drops the dead and works out perShip
+    void step(float dt);
+    // Adds perShip particles at the nozzle of a ship drawn at `position` and `rotation` (its model
+    // points up at rotation 0), moving at `velocity`; those past the capacity are dropped
+    void emit(glm::vec2 position, float rotation, glm::vec2 velocity, float shipScale);
+    // Shrinks from full size at birth to nothing at the end of its life
+    float drawScale(size_t i) const { return scale[i] * (1.0f - age[i] / lifetime[i]); }
+};
@@ -0,0 +1,91 @@
+#include "fastmath.h"
+#include "collision.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define FASTMATH_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#define FASTMATH_TARGET_AVX2
+#else
+#define FASTMATH_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+// ============================ BATCH ============================
+// The vector paths follow fastSinCos operation for operation (no FMA), so every lane rounds like the
+// scalar code; they run on the instruction set the collision kernels picked (--simd)
+static void fastSinCosScalar(const float* angles, size_t begin, size_t n, float* sines, float* cosines) {
+    for (size_t i = begin; i < n; ++i) fastSinCos(angles[i], sines[i], cosines[i]);
+}
+
+#if defined(FASTMATH_X86)
+static void fastSinCosSse2(const float* angles, size_t n, float* sines, float* cosines) {
+    const __m128 round = _mm_set1_ps(12582912.0f);
+    const __m128i one = _mm_set1_epi32(1), two = _mm_set1_epi32(2);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m128 angle = _mm_loadu_ps(angles + i);
+        const __m128 quadrant = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(angle, _mm_set1_ps(0.63661977236758134f)), round), round);
+        __m128 x = _mm_sub_ps(angle, _mm_mul_ps(quadrant, _mm_set1_ps(1.5703125f)));
+        x = _mm_sub_ps(x, _mm_mul_ps(quadrant, _mm_set1_ps(4.837512969970703125e-4f)));
+        x = _mm_sub_ps(x, _mm_mul_ps(quadrant, _mm_set1_ps(7.54978995489188216e-8f)));
+
+        const __m128 x2 = _mm_mul_ps(x, x);
+        __m128 sp = _mm_add_ps(_mm_set1_ps(8.3321608736e-3f), _mm_mul_ps(x2, _mm_set1_ps(-1.9515295891e-4f)));
+        sp = _mm_add_ps(_mm_set1_ps(-1.6666654611e-1f), _mm_mul_ps(x2, sp));
+        const __m128 s = _mm_add_ps(x, _mm_mul_ps(_mm_mul_ps(x, x2), sp));
+        __m128 cp = _mm_add_ps(_mm_set1_ps(-1.388731625493765e-3f), _mm_mul_ps(x2, _mm_set1_ps(2.443315711809948e-5f)));
+        cp = _mm_add_ps(_mm_set1_ps(4.166664568298827e-2f), _mm_mul_ps(x2, cp));
+        const __m128 c = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_set1_ps(0.5f), x2)), _mm_mul_ps(_mm_mul_ps(x2, x2), cp));
+
+        const __m128i q = _mm_cvttps_epi32(quadrant);
+        const __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(q, one), one));
+        const __m128 sineSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(q, two), 30));
+        const __m128 cosineSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(q, one), two), 30));
+        const __m128 swappedSine = _mm_or_ps(_mm_and_ps(swap, c), _mm_andnot_ps(swap, s));
+        const __m128 swappedCosine = _mm_or_ps(_mm_and_ps(swap, s), _mm_andnot_ps(swap, c));
+        _mm_storeu_ps(sines + i, _mm_xor_ps(swappedSine, sineSign));
+        _mm_storeu_ps(cosines + i, _mm_xor_ps(swappedCosine, cosineSign));
+    }
+    fastSinCosScalar(angles, i, n, sines, cosines);
+}
+
+FASTMATH_TARGET_AVX2
+static void fastSinCosAvx2(const float* angles, size_t n, float* sines, float* cosines) {
+    const __m256 round = _mm256_set1_ps(12582912.0f);
+    const __m256i one = _mm256_set1_epi32(1), two = _mm256_set1_epi32(2);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256 angle = _mm256_loadu_ps(angles + i);
+        const __m256 quadrant = _mm256_sub_ps(_mm256_add_ps(_mm256_mul_ps(angle, _mm256_set1_ps(0.63661977236758134f)), round), round);
+        __m256 x = _mm256_sub_ps(angle, _mm256_mul_ps(quadrant, _mm256_set1_ps(1.5703125f)));
+        x = _mm256_sub_ps(x, _mm256_mul_ps(quadrant, _mm256_set1_ps(4.837512969970703125e-4f)));
+        x = _mm256_sub_ps(x, _mm256_mul_ps(quadrant, _mm256_set1_ps(7.54978995489188216e-8f)));
+
+        const __m256 x2 = _mm256_mul_ps(x, x);
+        __m256 sp = _mm256_add_ps(_mm256_set1_ps(8.3321608736e-3f), _mm256_mul_ps(x2, _mm256_set1_ps(-1.9515295891e-4f)));
+        sp = _mm256_add_ps(_mm256_set1_ps(-1.6666654611e-1f), _mm256_mul_ps(x2, sp));
+        const __m256 s = _mm256_add_ps(x, _mm256_mul_ps(_mm256_mul_ps(x, x2), sp));
+        __m256 cp = _mm256_add_ps(_mm256_set1_ps(-1.388731625493765e-3f), _mm256_mul_ps(x2, _mm256_set1_ps(2.443315711809948e-5f)));
+        cp = _mm256_add_ps(_mm256_set1_ps(4.166664568298827e-2f), _mm256_mul_ps(x2, cp));
+        const __m256 c = _mm256_add_ps(_mm256_sub_ps(_mm256_set1_ps(1.0f), _mm256_mul_ps(_mm256_set1_ps(0.5f), x2)), _mm256_mul_ps(_mm256_mul_ps(x2, x2), cp));
+
+        const __m256i q = _mm256_cvttps_epi32(quadrant);
+        const __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(q, one), one));
+        const __m256 sineSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(q, two), 30));
+        const __m256 cosineSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(q, one), two), 30));
+        _mm256_storeu_ps(sines + i, _mm256_xor_ps(_mm256_blendv_ps(s, c, swap), sineSign));
+        _mm256_storeu_ps(cosines + i, _mm256_xor_ps(_mm256_blendv_ps(c, s, swap), cosineSign));
+    }
+    _mm256_zeroupper(); // The tail and the caller are legacy SSE code: avoid the AVX/SSE transition stall
+    fastSinCosSse2(angles + i, n - i, sines + i, cosines + i);
+}
+#endif
+
+void fastSinCosBatch(const float* angles, size_t n, float* sines, float* cosines) {
+#if defined(FASTMATH_X86)
+    if (activeCollisionKernel() == COLLISION_KERNEL_AVX2) return fastSinCosAvx2(angles, n, sines, cosines);
+    if (activeCollisionKernel() == COLLISION_KERNEL_SSE2) return fastSinCosSse2(angles, n, sines, cosines);
+#endif
+    fastSinCosScalar(angles, 0, n, sines, cosines);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+
+// Sine and cosine as polynomials, for the simulation's directions (ship facing, spawn and fire
+// headings) and the asteroid shapes, in place of libm's. The angle is reduced to [-pi/4, pi/4] around
+// the nearest multiple of pi/2 (the multiple subtracted in three exact parts), then fed to minimax
+// polynomials: degree 7 for the sine, 8 for the cosine. Against the true value the error is under
+// 1e-7 (under 2 float steps near 1) for |angle| up to 1e4, and under 1e-6 up to FAST_SINCOS_MAX_ANGLE,
+// where the reduction stops being exact; past that the result is not meaningful. Only + - * and a
+// float-to-int conversion are used, so with contraction off (see fixedpoint.h) every compiler and CPU
+// gives the same bits, which libm does not promise. The fixed-point mode keeps its table (fixedSinCos).
+
+// ============================ CONSTANTS ============================
+const float FAST_SINCOS_MAX_ANGLE = 65536.0f; // The reduction's multiple of pi/2 must fit 16 bits
+
+// ============================ SCALAR ============================
+inline void fastSinCos(float angle, float& sine, float& cosine) {
+    // Nearest multiple of pi/2 (rounded by the add of 1.5 * 2^23, ties to even, as the vector code does)
+    const float quadrant = (angle * 0.63661977236758134f + 12582912.0f) - 12582912.0f;
+    // pi/2 in three parts, the first two short enough that quadrant * part is exact
+    float x = angle - quadrant * 1.5703125f;
+    x -= quadrant * 4.837512969970703125e-4f;
+    x -= quadrant * 7.54978995489188216e-8f;
+
+    const float x2 = x * x;
+    const float s = x + x * x2 * (-1.6666654611e-1f + x2 * (8.3321608736e-3f + x2 * -1.9515295891e-4f));
+    const float c = 1.0f - 0.5f * x2 + x2 * x2 * (4.166664568298827e-2f + x2 * (-1.388731625493765e-3f + x2 * 2.443315711809948e-5f));
+
+    // Quadrant q: sin(x + q pi/2) cycles through s, c, -s, -c
+    const int q = static_cast<int>(quadrant);
+    const float swappedSine = (q & 1) ? c : s;
+    const float swappedCosine = (q & 1) ? s : c;
+    sine = (q & 2) ? -swappedSine : swappedSine;
+    cosine = ((q + 1) & 2) ? -swappedCosine : swappedCosine;
+}
+
+inline float fastSin(float angle) { float s, c; fastSinCos(angle, s, c); return s; }
+inline float fastCos(float angle) { float s, c; fastSinCos(angle, s, c); return c; }
+
+// ============================ BATCH ============================
+// sines[i], cosines[i] for angles[i]: the same bits as fastSinCos, 8 or 4 at a time (AVX2, SSE2)
+void fastSinCosBatch(const float* angles, size_t n, float* sines, float* cosines);
@@ -0,0 +1,64 @@
+#include "fixedpoint.h"
+
+#include <array>
+
+// ============================ SINE TABLE ============================
+// Taylor series on [-pi, pi]; the terms past x^27 are far below a Q16.16 step
+static constexpr double taylorSine(double x) {
+    double term = x, sum = x;
+    for (int k = 1; k < 14; ++k) {
+        term *= -x * x / static_cast<double>((2 * k) * (2 * k + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+// One guard entry past the full turn, so the interpolation never wraps the index
+static constexpr std::array<int32_t, FIXED_SINE_TABLE_SIZE + 1> buildSineTable() {
+    const double pi = 3.14159265358979323846;
+    std::array<int32_t, FIXED_SINE_TABLE_SIZE + 1> table{};
+    for (int k = 0; k <= FIXED_SINE_TABLE_SIZE; ++k) {
+        double x = 2.0 * pi * k / FIXED_SINE_TABLE_SIZE;
+        if (x > pi) x -= 2.0 * pi;
+        const double s = taylorSine(x) * FIXED_ONE;
+        table[k] = static_cast<int32_t>(s < 0.0 ? s - 0.5 : s + 0.5);
+    }
+    return table;
+}
+
+static constexpr std::array<int32_t, FIXED_SINE_TABLE_SIZE + 1> sineTable = buildSineTable();
+static_assert(sineTable[FIXED_SINE_TABLE_SIZE / 4] == FIXED_ONE && sineTable[FIXED_SINE_TABLE_SIZE / 2] == 0);
+
+// A turn is 2^PHASE_BITS phase steps: the table index above FIXED_FRACTION_BITS, the blend below
+const int PHASE_BITS = FIXED_SINE_TABLE_BITS + FIXED_FRACTION_BITS;
+const int32_t PHASE_MASK = (1 << PHASE_BITS) - 1;
+
+// angle * 2^PHASE_BITS / 2 pi, the division done as a multiply by its 32.32 reciprocal
+const int64_t PHASE_PER_RADIAN = ((int64_t(1) << (PHASE_BITS + 32)) + FIXED_TWO_PI / 2) / FIXED_TWO_PI;
+
+static int32_t phaseOf(int32_t angle) {
+    const int32_t wrapped = angle >= 0 && angle < FIXED_TWO_PI ? angle : wrapFixedAngle(angle);
+    return static_cast<int32_t>((wrapped * PHASE_PER_RADIAN) >> 32) & PHASE_MASK;
+}
+
+static int32_t sineOfPhase(int32_t phase) {
+    const int32_t index = phase >> FIXED_FRACTION_BITS;
+    const int32_t blend = phase & (FIXED_ONE - 1);
+    const int32_t a = sineTable[index], b = sineTable[index + 1];
+    return a + (((b - a) * blend + (FIXED_ONE >> 1)) >> FIXED_FRACTION_BITS);
+}
+
+int32_t fixedSin(int32_t angle) {
+    return sineOfPhase(phaseOf(angle));
+}
+
+// A quarter turn ahead, exactly (in phase steps, not through the rounded pi / 2)
+int32_t fixedCos(int32_t angle) {
+    return sineOfPhase((phaseOf(angle) + (1 << (PHASE_BITS - 2))) & PHASE_MASK);
+}
+
+void fixedSinCos(int32_t angle, int32_t& sine, int32_t& cosine) {
+    const int32_t phase = phaseOf(angle);
+    sine = sineOfPhase(phase);
+    cosine = sineOfPhase((phase + (1 << (PHASE_BITS - 2))) & PHASE_MASK);
+}
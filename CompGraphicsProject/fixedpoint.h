@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+// Q16.16 fixed point for the deterministic kinematics mode (GameWorld::fixedPointKinematics).
+// Float kinematics give bits that depend on the compiler and CPU: libm's sin, cos and pow differ
+// between vendors, and a multiply-add may or may not be contracted into one FMA. That is harmless
+// while a machine replays its own recordings, but lockstep peers on different builds drift apart.
+// Integer adds, multiplies and shifts come out the same everywhere, and the sine table is computed
+// by the compiler from + and * alone, so nothing in this mode reaches the platform's libm.
+// The world keeps its float arrays: in this mode the kinematic ones only ever hold Q16.16 values,
+// which a float represents exactly below 256 in magnitude, so the rest of the game reads them as before.
+// The float code this mode leaves (spawn draws, bounces, collision tests) uses + - * / and sqrt only,
+// which IEEE 754 rounds the same everywhere provided the compiler does not fuse a multiply and add:
+// MSVC's /fp:precise does not, GCC and Clang need -ffp-contract=off.
+
+// ============================ Q16.16 ============================
+const int FIXED_FRACTION_BITS = 16;
+const int32_t FIXED_ONE = 1 << FIXED_FRACTION_BITS;
+const int32_t FIXED_TWO_PI = 411775; // 2 pi, rounded
+
+// Nearest Q16.16 value (ties to even, like the SIMD kernels' conversion)
+inline int32_t toFixed(float v) { return static_cast<int32_t>(std::nearbyint(v * static_cast<float>(FIXED_ONE))); }
+inline float fromFixed(int32_t q) { return static_cast<float>(q) * (1.0f / static_cast<float>(FIXED_ONE)); }
+// For constants: evaluated by the compiler (ties away from zero)
+constexpr int32_t fixedConstant(float v) { return static_cast<int32_t>(v * static_cast<float>(FIXED_ONE) + (v < 0.0f ? -0.5f : 0.5f)); }
+
+// Product rounded to the nearest Q16.16 value (the SIMD kernels round the same way in 32-bit lanes)
+inline int32_t fixedMul(int32_t a, int32_t b) {
+    return static_cast<int32_t>((static_cast<int64_t>(a) * b + (FIXED_ONE >> 1)) >> FIXED_FRACTION_BITS);
+}
+
+// Into [0, 2 pi)
+inline int32_t wrapFixedAngle(int32_t angle) {
+    angle %= FIXED_TWO_PI;
+    return angle < 0 ? angle + FIXED_TWO_PI : angle;
+}
+
+// ============================ SINE TABLE ============================
+// A full turn in FIXED_SINE_TABLE_SIZE steps, linearly interpolated: the blend's error (under 5e-6)
+// is below Q16.16's own resolution, so results are within about one step of the true value
+const int FIXED_SINE_TABLE_BITS = 10;
+const int FIXED_SINE_TABLE_SIZE = 1 << FIXED_SINE_TABLE_BITS;
+
+int32_t fixedSin(int32_t angle); // Any angle in Q16.16 radians
+int32_t fixedCos(int32_t angle);
+void fixedSinCos(int32_t angle, int32_t& sine, int32_t& cosine); // Both from one phase: the same values as the two above
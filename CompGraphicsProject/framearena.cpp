@@ -0,0 +1,56 @@
+#include "framearena.h"
+#include "log.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+
+FrameArena frameArena;
+
+void FrameArena::init(size_t bytes) {
+    destroy();
+    block = static_cast<unsigned char*>(::operator new(bytes, std::align_val_t(alignof(std::max_align_t))));
+    capacity = bytes;
+    cursor = 0;
+    overflowBytes = 0;
+}
+
+void FrameArena::destroy() {
+    if (block) ::operator delete(block, std::align_val_t(alignof(std::max_align_t)));
+    block = nullptr;
+    capacity = 0;
+    cursor = 0;
+    peak = 0;
+}
+
+void* FrameArena::allocate(size_t bytes, size_t alignment) {
+    const size_t start = (cursor + alignment - 1) & ~(alignment - 1);
+    if (block && start + bytes <= capacity) {
+        cursor = start + bytes;
+        peak = std::max(peak, cursor + overflowBytes);
+        return block + start;
+    }
+    overflowBytes += bytes + alignment;
+    peak = std::max(peak, cursor + overflowBytes);
+    return ::operator new(bytes, std::align_val_t(alignof(std::max_align_t))); // Nothing here is over-aligned
+}
+
+void FrameArena::deallocate(void* pointer, size_t bytes) {
+    unsigned char* p = static_cast<unsigned char*>(pointer);
+    if (block && p >= block && p < block + capacity) {
+        if (p + bytes == block + cursor) cursor = p - block; // Last in, first out: give it back
+        return;
+    }
+    ::operator delete(pointer, std::align_val_t(alignof(std::max_align_t)));
+}
+
+void FrameArena::reset() {
+    if (overflowBytes > 0) {
+        const size_t bytes = std::max(capacity * 2, capacity + overflowBytes);
+        LOG_WARN("Frame arena overflowed by %zu bytes; growing it from %zu to %zu bytes", overflowBytes, capacity, bytes);
+        init(bytes);
+    }
+    cursor = 0;
+    overflowBytes = 0;
+    peak = 0;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// ============================ FRAME ARENA ============================
+// One preallocated block handed out by bumping a pointer, for render-side temporaries that live for a
+// single frame (instance arrays, draw lists, restart indices, the render queue). reset() rewinds it at
+// the top of every recorded frame, so nothing allocated from it may outlive its frame: containers
+// using FrameAllocator are dropped and re-reserved around the reset. An allocation that does not fit
+// comes from the heap instead, and the block grows to fit at the next reset. Render thread only.
+struct FrameArena {
+    unsigned char* block = nullptr;
+    size_t capacity = 0;
+    size_t cursor = 0; // Next free byte
+    size_t overflowBytes = 0; // Heap fallbacks this frame; the block grows by this much at the next reset
+    size_t peak = 0; // Most bytes in use at once this frame (block and fallbacks)
+
+    void init(size_t bytes);
+    void destroy();
+    void* allocate(size_t bytes, size_t alignment);
+    // Heap fallbacks are freed; arena memory is only reclaimed if it was the last allocation
+    void deallocate(void* pointer, size_t bytes);
+    // Forgets every allocation of the frame. Grows the block first if the frame overflowed it.
+    void reset();
+};
+
+extern FrameArena frameArena;
+
+// std allocator adapter over frameArena
+template <typename T>
+struct FrameAllocator {
+    using value_type = T;
+
+    FrameAllocator() = default;
+    template <typename U>
+    FrameAllocator(const FrameAllocator<U>&) {}
+
+    T* allocate(size_t count) { return static_cast<T*>(frameArena.allocate(count * sizeof(T), alignof(T))); }
+    void deallocate(T* pointer, size_t count) { frameArena.deallocate(pointer, count * sizeof(T)); }
+
+    template <typename U>
+    bool operator==(const FrameAllocator<U>&) const { return true; }
+};
+
+template <typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+// Frees a frame vector's storage (call before the arena is reset, then reserve again after it)
+template <typename T>
+void releaseFrameVector(FrameVector<T>& vector) {
+    FrameVector<T>().swap(vector);
+}
@@ -0,0 +1,80 @@
+#include "frameconstants.h"
+#include "gldebug.h"
+#include "glstate.h"
+
+#include <glad/glad.h>
+
+FrameConstants frameConstants;
+
+static unsigned int frameConstantsUBO;
+static unsigned int paletteUBO;
+
+void setupFrameConstants()
+{
+    if (useDirectStateAccess) {
+        glCreateBuffers(1, &frameConstantsUBO);
+        glNamedBufferData(frameConstantsUBO, sizeof(FrameConstants), &frameConstants, GL_DYNAMIC_DRAW);
+    }
+    else {
+        glGenBuffers(1, &frameConstantsUBO);
+        glBindBuffer(GL_UNIFORM_BUFFER, frameConstantsUBO);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameConstants), &frameConstants, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_CONSTANTS_BINDING, frameConstantsUBO);
+    labelGlObject(GL_BUFFER, frameConstantsUBO, "frame constants");
+
+    const glm::vec4 black[PALETTE_ENTRIES] = {};
+    if (useDirectStateAccess) {
+        glCreateBuffers(1, &paletteUBO);
+        glNamedBufferData(paletteUBO, sizeof(black), black, GL_STATIC_DRAW);
+    }
+    else {
+        glGenBuffers(1, &paletteUBO);
+        glBindBuffer(GL_UNIFORM_BUFFER, paletteUBO);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(black), black, GL_STATIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+    glBindBufferBase(GL_UNIFORM_BUFFER, PALETTE_BINDING, paletteUBO);
+    labelGlObject(GL_BUFFER, paletteUBO, "palette");
+}
+
+void destroyFrameConstants()
+{
+    glDeleteBuffers(1, &frameConstantsUBO);
+    glDeleteBuffers(1, &paletteUBO);
+}
+
+void bindFrameConstants(unsigned int program)
+{
+    // GLSL 3.30 has no layout(binding), so the block index is mapped here
+    if (!program) return; // Failed build
+    unsigned int block = glGetUniformBlockIndex(program, "FrameConstants");
+    if (block != GL_INVALID_INDEX) glUniformBlockBinding(program, block, FRAME_CONSTANTS_BINDING);
+    block = glGetUniformBlockIndex(program, "Palette");
+    if (block != GL_INVALID_INDEX) glUniformBlockBinding(program, block, PALETTE_BINDING);
+}
+
+void uploadPalette(const glm::vec3* colors, size_t count)
+{
+    glm::vec4 entries[PALETTE_ENTRIES] = {};
+    for (size_t i = 0; i < count && i < PALETTE_ENTRIES; ++i) entries[i] = glm::vec4(colors[i], 1.0f);
+    if (useDirectStateAccess) {
+        glNamedBufferSubData(paletteUBO, 0, sizeof(entries), entries);
+        return;
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, paletteUBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(entries), entries);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void updateFrameConstants()
+{
+    if (useDirectStateAccess) {
+        glNamedBufferSubData(frameConstantsUBO, 0, sizeof(FrameConstants), &frameConstants);
+        return;
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, frameConstantsUBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameConstants), &frameConstants);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+// ============================ FRAME CONSTANTS ============================
+// One std140 uniform buffer with the data every shader may need for the whole frame. It is written
+// once per frame and stays bound at FRAME_CONSTANTS_BINDING, so programs never set these as uniforms.
+const unsigned int FRAME_CONSTANTS_BINDING = 0;
+
+// Mirrors the GLSL block below (std140: scalars at 0 and 4, vec2 at 8, vec4 at 16, scalars at 32
+// to 44, the block 48)
+struct FrameConstants {
+    float time = 0.0f; // Seconds since startup, wrapped (shaderTime in timebase.h)
+    float aspect = 1.0f; // Framebuffer width / height
+    glm::vec2 viewportSize = glm::vec2(1.0f); // Framebuffer size in pixels
+    glm::vec4 tint = glm::vec4(1.0f); // Multiplied into every game object and the background
+    float gameTime = 0.0f; // The game time drawn (between the last two ticks), from the resident rocks' epoch
+    float instancePositionScale = 1.0f; // Multiplies the instance position attribute (INSTANCE_POSITION_RANGE for compact records)
+    int circleFanBase = 0; // First atlas vertex of the unit-circle fans (polarShape in polarshapes.h)
+    int polarShapes = 0; // Nonzero: a fan instance's shape is a polar table entry plus one, not a procedural seed
+};
+static_assert(sizeof(FrameConstants) == 48, "FrameConstants must match the std140 block");
+
+// Paste into a shader source right after the #version line (string literal concatenation)
+#define FRAME_CONSTANTS_GLSL \
+    "layout (std140) uniform FrameConstants {\n" \
+    "    float time;\n" \
+    "    float aspect;\n" \
+    "    vec2 viewportSize;\n" \
+    "    vec4 tint;\n" \
+    "    float gameTime;\n" \
+    "    float instancePositionScale;\n" \
+    "    int circleFanBase;\n" \
+    "    int polarShapes;\n" \
+    "};\n"
+
+extern FrameConstants frameConstants; // Filled in by the frame, uploaded by updateFrameConstants
+
+// ============================ PALETTE ============================
+// A second std140 block holding every color an instance can be drawn in, written once at startup.
+// Instances carry a 32-bit paint instead of a color: the entry in the low byte and a shade above it
+// (PAINT_FILL darkens as a rock's fill, PAINT_OUTLINE brightens as its outline), which paintColor
+// turns back into the color the CPU used to compute per instance.
+const unsigned int PALETTE_BINDING = 1;
+const int PALETTE_ENTRIES = 16;
+const uint32_t PAINT_FILL = 1u << 8;
+const uint32_t PAINT_OUTLINE = 2u << 8;
+
+#define PALETTE_GLSL \
+    "layout (std140) uniform Palette {\n" \
+    "    vec4 paletteColors[16];\n" \
+    "};\n" \
+    "vec3 paintColor(uint paint)\n" \
+    "{\n" \
+    "    vec3 color = paletteColors[paint & 0xFFu].rgb;\n" \
+    "    uint shade = paint >> 8;\n" \
+    "    if (shade == 1u) return color * 0.5;\n" \
+    "    if (shade == 2u) return clamp(color * 1.5, 0.0, 1.0);\n" \
+    "    return color;\n" \
+    "}\n"
+
+// ============================ FRAME CONSTANTS API ============================
+void setupFrameConstants();
+void destroyFrameConstants();
+// Points the program's FrameConstants and Palette blocks at the shared bindings (no-op for a block
+// it does not use)
+void bindFrameConstants(unsigned int program);
+// Fills the palette's first `count` entries (at most PALETTE_ENTRIES); the rest stay black
+void uploadPalette(const glm::vec3* colors, size_t count);
+// Uploads frameConstants; call once per frame before the first draw
+void updateFrameConstants();
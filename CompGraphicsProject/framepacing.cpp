@@ -0,0 +1,115 @@
+#include "framepacing.h"
+#include "log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <timeapi.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+PresentMode presentMode = PRESENT_VSYNC;
+double frameLimitHz = 60.0;
+bool lowLatencyMode = false;
+
+typedef std::chrono::steady_clock Clock;
+
+// Sleeps end up to a scheduler quantum late; the last stretch before a deadline is spun instead
+static const std::chrono::microseconds SPIN_MARGIN(1500);
+// Slack kept between the end of a low-latency frame and the refresh it targets
+static const std::chrono::microseconds LOW_LATENCY_SLACK(1000);
+
+static double refreshPeriodSeconds = 1.0 / 60.0;
+static Clock::time_point nextDeadline; // Limiter: when the next frame may start
+static Clock::time_point frameBegin; // When the current frame's work started (after pacing)
+static Clock::time_point lastPresent; // Low latency: when the last swap completed
+static double frameCostSeconds = 0.0; // Low latency: smoothed CPU + GPU cost of a frame
+
+// ============================ PRESENT MODES ============================
+static const char* const PRESENT_MODE_NAMES[PRESENT_MODE_COUNT] = { "vsync", "adaptive", "uncapped", "limit" };
+
+const char* presentModeName(PresentMode mode) {
+    return PRESENT_MODE_NAMES[mode];
+}
+
+bool parsePresentMode(const char* name, PresentMode& mode) {
+    for (int i = 0; i < PRESENT_MODE_COUNT; ++i) {
+        if (std::strcmp(name, PRESENT_MODE_NAMES[i]) == 0) {
+            mode = static_cast<PresentMode>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+void applyPresentMode(GLFWwindow* window) {
+    (void)window;
+    int interval = 0;
+    if (presentMode == PRESENT_VSYNC) interval = 1;
+    else if (presentMode == PRESENT_ADAPTIVE) {
+        bool tear = glfwExtensionSupported("WGL_EXT_swap_control_tear") || glfwExtensionSupported("GLX_EXT_swap_control_tear");
+        if (!tear) LOG_WARN("Adaptive vsync unsupported (no swap_control_tear), using vsync");
+        interval = tear ? -1 : 1;
+    }
+    glfwSwapInterval(interval);
+
+    GLFWmonitor* monitor = glfwGetPrimaryMonitor();
+    const GLFWvidmode* videoMode = monitor ? glfwGetVideoMode(monitor) : NULL;
+    if (videoMode && videoMode->refreshRate > 0) refreshPeriodSeconds = 1.0 / videoMode->refreshRate;
+
+#if defined(_WIN32)
+    // 1 ms scheduler resolution for the limiter's sleeps (the default is ~15.6 ms)
+    static bool timerResolutionSet = false;
+    if (!timerResolutionSet) timerResolutionSet = timeBeginPeriod(1) == TIMERR_NOERROR;
+#endif
+
+    nextDeadline = Clock::now();
+    lastPresent = Clock::now();
+    LOG_INFO("Present mode: %s%s", presentModeName(presentMode), lowLatencyMode ? ", low latency" : "");
+}
+
+// ============================ FRAME PACING ============================
+// Sleeps until shortly before `deadline`, then spins the rest for sub-millisecond accuracy
+static void waitUntil(Clock::time_point deadline) {
+    if (Clock::now() + SPIN_MARGIN < deadline) std::this_thread::sleep_until(deadline - SPIN_MARGIN);
+    while (Clock::now() < deadline) std::this_thread::yield();
+}
+
+void beginPacedFrame() {
+    if (presentMode == PRESENT_LIMITED) {
+        const Clock::duration period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / frameLimitHz));
+        waitUntil(nextDeadline);
+        // A frame that ran long starts a new schedule instead of bursting to catch up
+        nextDeadline = std::max(nextDeadline + period, Clock::now());
+    }
+    else if (lowLatencyMode && presentMode != PRESENT_UNCAPPED) {
+        // Start just late enough to finish right before the next refresh
+        const std::chrono::duration<double> lead(refreshPeriodSeconds - frameCostSeconds);
+        waitUntil(lastPresent + std::chrono::duration_cast<Clock::duration>(lead) - LOW_LATENCY_SLACK);
+    }
+    frameBegin = Clock::now();
+}
+
+void beforeSwap() {
+    if (!lowLatencyMode) return;
+    glFinish(); // The frame is fully rendered: its cost is known and nothing is left queued
+    double cost = std::chrono::duration<double>(Clock::now() - frameBegin).count();
+    // Rises at once (a late frame misses the refresh), decays slowly
+    frameCostSeconds = cost > frameCostSeconds ? cost : frameCostSeconds * 0.95 + cost * 0.05;
+    frameCostSeconds = std::min(frameCostSeconds, refreshPeriodSeconds);
+}
+
+void afterSwap() {
+    if (!lowLatencyMode) return;
+    glFinish(); // Returns once the swap has been performed, so lastPresent tracks the refresh
+    lastPresent = Clock::now();
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+struct GLFWwindow;
+
+// Presentation and frame pacing. Without an explicit swap interval the driver default decides
+// whether frames are vsync'd or rendered as fast as possible, so the mode is always set at startup.
+
+// ============================ PRESENT MODES ============================
+enum PresentMode {
+    PRESENT_VSYNC,    // Swap interval 1
+    PRESENT_ADAPTIVE, // Swap interval -1: vsync, but tear instead of waiting a whole refresh when late
+                      // (needs WGL/GLX_EXT_swap_control_tear, otherwise plain vsync)
+    PRESENT_UNCAPPED, // Swap interval 0
+    PRESENT_LIMITED,  // Swap interval 0 plus a sleep-then-spin limiter at frameLimitHz
+    PRESENT_MODE_COUNT
+};
+
+extern PresentMode presentMode; // --present, cycled with V
+extern double frameLimitHz; // Target rate of PRESENT_LIMITED (--fps)
+// Low latency (--low-latency): the GPU queue is drained every frame (glFinish) so the CPU never runs
+// frames ahead, and under vsync the frame starts as late before the next refresh as the measured
+// frame cost allows, so input is sampled just before it is needed
+extern bool lowLatencyMode;
+
+const char* presentModeName(PresentMode mode);
+bool parsePresentMode(const char* name, PresentMode& mode);
+
+// ============================ FRAME PACING API ============================
+// Sets the swap interval for presentMode (the window's context must be current)
+void applyPresentMode(GLFWwindow* window);
+// Call at the top of every frame, before polling input: sleeps as the mode requires
+void beginPacedFrame();
+// Call around glfwSwapBuffers
+void beforeSwap();
+void afterSwap();
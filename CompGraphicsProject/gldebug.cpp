@@ -0,0 +1,114 @@
+#include "gldebug.h"
+#include "alloctrack.h"
+#include "log.h"
+#include "profiler.h"
+
+#include <cstring>
+
+#include <GLFW/glfw3.h>
+
+#ifdef NDEBUG
+GlContextMode glContextMode = GL_CONTEXT_PRODUCTION;
+#else
+GlContextMode glContextMode = GL_CONTEXT_DEVELOPMENT;
+#endif
+
+static bool debugOutputEnabled = false; // Set by the game window's context before the compiler thread starts
+
+bool parseGlContextMode(const char* name, GlContextMode& mode) {
+    if (std::strcmp(name, "plain") == 0) mode = GL_CONTEXT_PLAIN;
+    else if (std::strcmp(name, "development") == 0 || std::strcmp(name, "debug") == 0) mode = GL_CONTEXT_DEVELOPMENT;
+    else if (std::strcmp(name, "production") == 0) mode = GL_CONTEXT_PRODUCTION;
+    else return false;
+    return true;
+}
+
+const char* glContextModeName(GlContextMode mode) {
+    switch (mode) {
+    case GL_CONTEXT_DEVELOPMENT: return "development";
+    case GL_CONTEXT_PRODUCTION: return "production";
+    default: return "plain";
+    }
+}
+
+void applyGlContextHints() {
+    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, glContextMode == GL_CONTEXT_DEVELOPMENT ? GLFW_TRUE : GLFW_FALSE);
+    glfwWindowHint(GLFW_CONTEXT_NO_ERROR, glContextMode == GL_CONTEXT_PRODUCTION ? GLFW_TRUE : GLFW_FALSE);
+}
+
+// ============================ DEBUG OUTPUT ============================
+static const char* debugSourceName(GLenum source) {
+    switch (source) {
+    case GL_DEBUG_SOURCE_API: return "api";
+    case GL_DEBUG_SOURCE_WINDOW_SYSTEM: return "window system";
+    case GL_DEBUG_SOURCE_SHADER_COMPILER: return "shader compiler";
+    case GL_DEBUG_SOURCE_THIRD_PARTY: return "third party";
+    case GL_DEBUG_SOURCE_APPLICATION: return "application";
+    default: return "other";
+    }
+}
+
+static const char* debugTypeName(GLenum type) {
+    switch (type) {
+    case GL_DEBUG_TYPE_ERROR: return "error";
+    case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "deprecated";
+    case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR: return "undefined behavior";
+    case GL_DEBUG_TYPE_PORTABILITY: return "portability";
+    case GL_DEBUG_TYPE_PERFORMANCE: return "performance";
+    case GL_DEBUG_TYPE_MARKER: return "marker";
+    default: return "other";
+    }
+}
+
+// Synchronous output runs this on the thread that made the call, inside it, so the profiler phase is
+// that call's and the debugger's call stack leads straight to it
+static void APIENTRY logDebugMessage(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei, const GLchar* message, const void*) {
+    AllowAllocations report; // Logging may allocate, and a message can arrive mid-frame
+    const char* phase = threadAllocationPhase >= 0 ? profilerPhaseName(static_cast<ProfilePhase>(threadAllocationPhase)) : "none";
+    switch (severity) {
+    case GL_DEBUG_SEVERITY_HIGH:
+        LOG_ERROR("GL %s %s %u (phase: %s): %s", debugSourceName(source), debugTypeName(type), id, phase, message);
+        break;
+    case GL_DEBUG_SEVERITY_MEDIUM:
+        LOG_WARN("GL %s %s %u (phase: %s): %s", debugSourceName(source), debugTypeName(type), id, phase, message);
+        break;
+    case GL_DEBUG_SEVERITY_LOW:
+        LOG_INFO("GL %s %s %u (phase: %s): %s", debugSourceName(source), debugTypeName(type), id, phase, message);
+        break;
+    default:
+        LOG_DEBUG("GL %s %s %u (phase: %s): %s", debugSourceName(source), debugTypeName(type), id, phase, message);
+        break;
+    }
+#if defined(_MSC_VER) && defined(_DEBUG)
+    if (type == GL_DEBUG_TYPE_ERROR) __debugbreak();
+#endif
+}
+
+void installGlDebugOutput() {
+    if (glContextMode != GL_CONTEXT_DEVELOPMENT || !GLAD_GL_VERSION_4_3 || !glDebugMessageCallback) return;
+    GLint flags = 0;
+    glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
+    if (!(flags & GL_CONTEXT_FLAG_DEBUG_BIT)) return;
+
+    glEnable(GL_DEBUG_OUTPUT);
+    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    glDebugMessageCallback(logDebugMessage, nullptr);
+    // Notifications are mostly buffer placement chatter; everything above them is logged
+    glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr, GL_FALSE);
+    debugOutputEnabled = true;
+}
+
+void logGlContextMode() {
+    GLint flags = 0;
+    glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
+    const char* granted = "plain";
+    if (debugOutputEnabled) granted = "debug, messages logged";
+    else if (flags & GL_CONTEXT_FLAG_DEBUG_BIT) granted = "debug, no debug output (needs GL 4.3)";
+    else if (flags & GL_CONTEXT_FLAG_NO_ERROR_BIT) granted = "no error";
+    LOG_INFO("GL context: %s mode requested, %s granted", glContextModeName(glContextMode), granted);
+}
+
+void labelGlObject(GLenum identifier, unsigned int name, const char* label) {
+    if (!debugOutputEnabled || !name) return;
+    glObjectLabel(identifier, name, -1, label);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// ============================ GL CONTEXT MODES ============================
+// Development: a debug context whose KHR_debug messages go through the logger, synchronously, so a
+// breakpoint in the callback (debug builds break there on errors) stops at the offending call. Each
+// message names the profiler phase it came from and any labeled object it mentions.
+// Production: a KHR_no_error context, so the driver skips validation altogether (a GL error is then
+// undefined behaviour rather than a message). Plain: neither, the driver's default validation.
+// Debug builds default to development and release builds to production; --gl-context overrides.
+enum GlContextMode {
+    GL_CONTEXT_PLAIN,
+    GL_CONTEXT_DEVELOPMENT,
+    GL_CONTEXT_PRODUCTION
+};
+
+extern GlContextMode glContextMode;
+
+// Parses a --gl-context value ("plain", "development"/"debug", "production"); false if unknown
+bool parseGlContextMode(const char* name, GlContextMode& mode);
+const char* glContextModeName(GlContextMode mode);
+
+// Sets the GLFW hints for glContextMode; call before creating the window. Shared contexts created
+// afterwards (the shader compiler's) inherit them, which GL requires for no-error contexts.
+void applyGlContextHints();
+// After the context is current and GL is loaded: routes debug output to the logger on a debug
+// context (needs GL 4.3). Call once per context.
+void installGlDebugOutput();
+// Logs the mode asked for and what the current context's flags say the driver granted
+void logGlContextMode();
+// Names an object in debug messages (nothing unless debug output is on)
+void labelGlObject(GLenum identifier, unsigned int name, const char* label);
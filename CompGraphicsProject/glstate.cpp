@@ -0,0 +1,112 @@
+#include "glstate.h"
+
+#include "profiler.h"
+
+#include <cstring>
+
+GlStateCache glState;
+bool useDirectStateAccess = false;
+
+// Counts the call and reports whether it has to reach GL
+static bool issue(bool changed)
+{
+    profilerCount(changed ? COUNTER_GL_STATE_ISSUED : COUNTER_GL_STATE_FILTERED, 1);
+    return changed;
+}
+
+void GlStateCache::useProgram(unsigned int name)
+{
+    if (!issue(program != name)) return;
+    program = name;
+    glUseProgram(name);
+}
+
+void GlStateCache::bindVertexArray(unsigned int name)
+{
+    if (!issue(vertexArray != name)) return;
+    vertexArray = name;
+    glBindVertexArray(name);
+}
+
+void GlStateCache::setPointSize(float size)
+{
+    if (!issue(pointSize != size)) return;
+    pointSize = size;
+    glPointSize(size);
+}
+
+void GlStateCache::setLineWidth(float width)
+{
+    if (!issue(lineWidth != width)) return;
+    lineWidth = width;
+    glLineWidth(width);
+}
+
+void GlStateCache::setEnabled(GLenum capability, bool enabled)
+{
+    CapabilityState* state = nullptr;
+    for (CapabilityState& c : capabilities) {
+        if (c.capability == capability) state = &c;
+    }
+    if (!issue(!state || state->enabled != enabled)) return;
+    if (state) state->enabled = enabled;
+    else capabilities.push_back({ capability, enabled });
+    if (enabled) glEnable(capability);
+    else glDisable(capability);
+}
+
+void GlStateCache::uniform3f(int location, float x, float y, float z)
+{
+    Uniform3State* state = nullptr;
+    for (Uniform3State& u : uniforms) {
+        if (u.program == program && u.location == location) state = &u;
+    }
+    if (!issue(!state || state->x != x || state->y != y || state->z != z)) return;
+    if (state) *state = { program, location, x, y, z };
+    else uniforms.push_back({ program, location, x, y, z });
+    glUniform3f(location, x, y, z);
+}
+
+void GlStateCache::invalidate()
+{
+    program = UNKNOWN_NAME;
+    vertexArray = UNKNOWN_NAME;
+    pointSize = -1.0f;
+    lineWidth = -1.0f;
+    capabilities.clear();
+    uniforms.clear();
+}
+
+bool directStateAccessSupported()
+{
+    return GLAD_GL_VERSION_4_5 && glCreateBuffers && glNamedBufferData && glNamedBufferStorage && glNamedBufferSubData
+        && glMapNamedBufferRange && glUnmapNamedBuffer && glCreateVertexArrays && glVertexArrayVertexBuffer
+        && glVertexArrayAttribFormat && glVertexArrayAttribIFormat && glVertexArrayAttribBinding
+        && glVertexArrayBindingDivisor && glVertexArrayElementBuffer && glEnableVertexArrayAttrib && glCreateTextures && glTextureBuffer
+        && glBindTextureUnit && glGetNamedBufferParameteri64v;
+}
+
+bool hasGlExtension(const char* name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i) {
+        const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+        if (extension && std::strcmp(extension, name) == 0) return true;
+    }
+    return false;
+}
+
+size_t glBufferBytes(unsigned int buffer)
+{
+    if (!buffer) return 0;
+    GLint64 bytes = 0;
+    if (useDirectStateAccess) {
+        glGetNamedBufferParameteri64v(buffer, GL_BUFFER_SIZE, &bytes);
+        return static_cast<size_t>(bytes);
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+    glGetBufferParameteri64v(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &bytes);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    return static_cast<size_t>(bytes);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <glad/glad.h>
+
+// ============================ GL STATE CACHE ============================
+// Remembers the last program, vertex array, point size, line width, a few capabilities and the
+// vec3 uniforms set through it, and drops calls that would not change anything. Every call is
+// counted as issued or filtered in the profiler (COUNTER_GL_STATE_ISSUED / _FILTERED).
+// Only the per-frame render code goes through the cache; setup code calls GL directly and must
+// call invalidate() afterwards so the next call of each kind is always issued.
+struct GlStateCache {
+    struct CapabilityState {
+        GLenum capability;
+        bool enabled;
+    };
+    struct Uniform3State {
+        unsigned int program;
+        int location;
+        float x, y, z;
+    };
+
+    static constexpr unsigned int UNKNOWN_NAME = ~0u;
+
+    unsigned int program = UNKNOWN_NAME;
+    unsigned int vertexArray = UNKNOWN_NAME;
+    float pointSize = -1.0f; // Negative: unknown
+    float lineWidth = -1.0f;
+    std::vector<CapabilityState> capabilities; // Only capabilities set through the cache
+    std::vector<Uniform3State> uniforms; // Per program, since uniform values live in the program
+
+    void useProgram(unsigned int name);
+    void bindVertexArray(unsigned int name);
+    void setPointSize(float size);
+    void setLineWidth(float width);
+    void setEnabled(GLenum capability, bool enabled);
+    // glUniform3f on the bound program (useProgram must have been called through the cache)
+    void uniform3f(int location, float x, float y, float z);
+    // Forgets everything; the next call of each kind reaches GL
+    void invalidate();
+};
+
+extern GlStateCache glState;
+
+// ============================ DIRECT STATE ACCESS ============================
+// GL 4.5: buffers, vertex arrays and texture buffers are created and edited by name (glCreateBuffers,
+// glNamedBufferSubData, glVertexArrayVertexBuffer, ...) instead of being bound to edit them. Chosen
+// once after the context is created, before any buffer or vertex array exists (the two paths lay out
+// vertex arrays differently); otherwise the GL 3.3 core code runs unchanged.
+extern bool useDirectStateAccess;
+// GL 4.5 and every entry point the DSA paths call
+bool directStateAccessSupported();
+
+// ============================ EXTENSIONS ============================
+// The current context lists `name` among its extensions (GL 3.0 glGetStringi; walks the list)
+bool hasGlExtension(const char* name);
+
+// Allocated size of a buffer object's store (0 for none). Without DSA it binds the buffer to
+// GL_COPY_READ_BUFFER, which the cache does not track; for the memory report, not for per-frame use.
+size_t glBufferBytes(unsigned int buffer);
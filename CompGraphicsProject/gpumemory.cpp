@@ -0,0 +1,261 @@
+#include "gpumemory.h"
+#include "alloctrack.h"
+#include "glstate.h"
+#include "log.h"
+#include "profiler.h"
+#include "telemetry.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#include <glad/glad.h>
+
+// Not in the loader's headers (neither extension is loaded through it: both are queries only)
+const GLenum GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX = 0x9047;
+const GLenum GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX = 0x9048;
+const GLenum GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX = 0x9049;
+const GLenum GL_GPU_MEMORY_INFO_EVICTION_COUNT_NVX = 0x904A;
+const GLenum GL_GPU_MEMORY_INFO_EVICTED_MEMORY_NVX = 0x904B;
+const GLenum GL_VBO_FREE_MEMORY_ATI = 0x87FB;
+
+enum DriverMemoryInfo { DRIVER_INFO_NONE, DRIVER_INFO_NVX, DRIVER_INFO_ATI };
+
+static DriverMemoryInfo driverInfo = DRIVER_INFO_NONE;
+
+// Ours: written by whichever context calls the wrappers (the shader compiler's shares the names)
+static std::mutex bufferMutex;
+static std::vector<int64_t> bufferSizes; // By buffer name, under bufferMutex (-1: no such buffer)
+static std::atomic<int64_t> liveBuffers{ 0 }, liveBufferBytes{ 0 }, liveVertexArrays{ 0 };
+static std::atomic<int64_t> buffersCreated{ 0 }, vertexArraysCreated{ 0 };
+
+// The driver's, from the render thread's last sample
+static std::atomic<int64_t> driverTotalKB{ -1 }, driverAvailableKB{ -1 }, driverEvictions{ -1 }, driverEvictedKB{ -1 };
+static std::chrono::steady_clock::time_point lastSample;
+
+// ============================ COUNTING WRAPPERS ============================
+static PFNGLGENBUFFERSPROC realGenBuffers;
+static PFNGLCREATEBUFFERSPROC realCreateBuffers;
+static PFNGLDELETEBUFFERSPROC realDeleteBuffers;
+static PFNGLBUFFERDATAPROC realBufferData;
+static PFNGLBUFFERSTORAGEPROC realBufferStorage;
+static PFNGLNAMEDBUFFERDATAPROC realNamedBufferData;
+static PFNGLNAMEDBUFFERSTORAGEPROC realNamedBufferStorage;
+static PFNGLGENVERTEXARRAYSPROC realGenVertexArrays;
+static PFNGLCREATEVERTEXARRAYSPROC realCreateVertexArrays;
+static PFNGLDELETEVERTEXARRAYSPROC realDeleteVertexArrays;
+
+static void countBuffers(GLsizei count, const GLuint* names) {
+    liveBuffers.fetch_add(count, std::memory_order_relaxed);
+    buffersCreated.fetch_add(count, std::memory_order_relaxed);
+    telemetryAdd(TELEMETRY_GPU_BUFFERS_CREATED, count);
+    std::lock_guard<std::mutex> lock(bufferMutex);
+    for (GLsizei i = 0; i < count; ++i) {
+        if (names[i] >= bufferSizes.size()) {
+            AllowAllocations grow; // Only when a name is higher than any before
+            bufferSizes.resize(names[i] + 1 + names[i] / 2, -1);
+        }
+        bufferSizes[names[i]] = 0;
+    }
+}
+
+// A buffer's store is now `bytes` (ignored for a name not created through the wrappers)
+static void setBufferBytes(GLuint name, int64_t bytes) {
+    std::lock_guard<std::mutex> lock(bufferMutex);
+    if (name >= bufferSizes.size() || bufferSizes[name] < 0) return;
+    liveBufferBytes.fetch_add(bytes - bufferSizes[name], std::memory_order_relaxed);
+    bufferSizes[name] = bytes;
+}
+
+static void forgetBuffer(GLuint name) {
+    std::lock_guard<std::mutex> lock(bufferMutex);
+    if (name >= bufferSizes.size() || bufferSizes[name] < 0) return; // Never created, or deleted already (GL ignores both)
+    liveBufferBytes.fetch_sub(bufferSizes[name], std::memory_order_relaxed);
+    bufferSizes[name] = -1;
+    liveBuffers.fetch_sub(1, std::memory_order_relaxed);
+}
+
+// The buffer bound to a glBufferData target (0 for a target not listed)
+static GLuint boundBuffer(GLenum target) {
+    GLenum binding = 0;
+    switch (target) {
+    case GL_ARRAY_BUFFER: binding = GL_ARRAY_BUFFER_BINDING; break;
+    case GL_ELEMENT_ARRAY_BUFFER: binding = GL_ELEMENT_ARRAY_BUFFER_BINDING; break;
+    case GL_COPY_READ_BUFFER: binding = GL_COPY_READ_BUFFER_BINDING; break;
+    case GL_COPY_WRITE_BUFFER: binding = GL_COPY_WRITE_BUFFER_BINDING; break;
+    case GL_PIXEL_PACK_BUFFER: binding = GL_PIXEL_PACK_BUFFER_BINDING; break;
+    case GL_PIXEL_UNPACK_BUFFER: binding = GL_PIXEL_UNPACK_BUFFER_BINDING; break;
+    case GL_TEXTURE_BUFFER: binding = GL_TEXTURE_BUFFER_BINDING; break;
+    case GL_UNIFORM_BUFFER: binding = GL_UNIFORM_BUFFER_BINDING; break;
+    case GL_TRANSFORM_FEEDBACK_BUFFER: binding = GL_TRANSFORM_FEEDBACK_BUFFER_BINDING; break;
+    case GL_DRAW_INDIRECT_BUFFER: binding = GL_DRAW_INDIRECT_BUFFER_BINDING; break;
+    case GL_DISPATCH_INDIRECT_BUFFER: binding = GL_DISPATCH_INDIRECT_BUFFER_BINDING; break;
+    case GL_SHADER_STORAGE_BUFFER: binding = GL_SHADER_STORAGE_BUFFER_BINDING; break;
+    case GL_ATOMIC_COUNTER_BUFFER: binding = GL_ATOMIC_COUNTER_BUFFER_BINDING; break;
+    case GL_QUERY_BUFFER: binding = GL_QUERY_BUFFER_BINDING; break;
+    default: return 0;
+    }
+    GLint name = 0;
+    glGetIntegerv(binding, &name);
+    return static_cast<GLuint>(name);
+}
+
+static void APIENTRY countedGenBuffers(GLsizei count, GLuint* names) {
+    realGenBuffers(count, names);
+    countBuffers(count, names);
+}
+
+static void APIENTRY countedCreateBuffers(GLsizei count, GLuint* names) {
+    realCreateBuffers(count, names);
+    countBuffers(count, names);
+}
+
+static void APIENTRY countedDeleteBuffers(GLsizei count, const GLuint* names) {
+    for (GLsizei i = 0; i < count; ++i) forgetBuffer(names[i]);
+    realDeleteBuffers(count, names);
+}
+
+static void APIENTRY countedBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage) {
+    realBufferData(target, size, data, usage);
+    setBufferBytes(boundBuffer(target), static_cast<int64_t>(size));
+}
+
+static void APIENTRY countedBufferStorage(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags) {
+    realBufferStorage(target, size, data, flags);
+    setBufferBytes(boundBuffer(target), static_cast<int64_t>(size));
+}
+
+static void APIENTRY countedNamedBufferData(GLuint buffer, GLsizeiptr size, const void* data, GLenum usage) {
+    realNamedBufferData(buffer, size, data, usage);
+    setBufferBytes(buffer, static_cast<int64_t>(size));
+}
+
+static void APIENTRY countedNamedBufferStorage(GLuint buffer, GLsizeiptr size, const void* data, GLbitfield flags) {
+    realNamedBufferStorage(buffer, size, data, flags);
+    setBufferBytes(buffer, static_cast<int64_t>(size));
+}
+
+static void APIENTRY countedGenVertexArrays(GLsizei count, GLuint* names) {
+    realGenVertexArrays(count, names);
+    liveVertexArrays.fetch_add(count, std::memory_order_relaxed);
+    vertexArraysCreated.fetch_add(count, std::memory_order_relaxed);
+    telemetryAdd(TELEMETRY_GPU_VERTEX_ARRAYS_CREATED, count);
+}
+
+static void APIENTRY countedCreateVertexArrays(GLsizei count, GLuint* names) {
+    realCreateVertexArrays(count, names);
+    liveVertexArrays.fetch_add(count, std::memory_order_relaxed);
+    vertexArraysCreated.fetch_add(count, std::memory_order_relaxed);
+    telemetryAdd(TELEMETRY_GPU_VERTEX_ARRAYS_CREATED, count);
+}
+
+static void APIENTRY countedDeleteVertexArrays(GLsizei count, const GLuint* names) {
+    for (GLsizei i = 0; i < count; ++i) {
+        if (names[i] != 0) liveVertexArrays.fetch_sub(1, std::memory_order_relaxed);
+    }
+    realDeleteVertexArrays(count, names);
+}
+
+// ============================ DRIVER QUERIES ============================
+static void queryDriver() {
+    if (driverInfo == DRIVER_INFO_NVX) {
+        GLint total = 0, available = 0, evictions = 0, evicted = 0;
+        glGetIntegerv(GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX, &total);
+        glGetIntegerv(GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, &available);
+        glGetIntegerv(GL_GPU_MEMORY_INFO_EVICTION_COUNT_NVX, &evictions);
+        glGetIntegerv(GL_GPU_MEMORY_INFO_EVICTED_MEMORY_NVX, &evicted);
+        driverTotalKB.store(total, std::memory_order_relaxed);
+        driverAvailableKB.store(available, std::memory_order_relaxed);
+        driverEvictions.store(evictions, std::memory_order_relaxed);
+        driverEvictedKB.store(evicted, std::memory_order_relaxed);
+    }
+    else if (driverInfo == DRIVER_INFO_ATI) {
+        GLint pool[4] = {}; // Free, largest free block, free auxiliary, largest auxiliary block (KB)
+        glGetIntegerv(GL_VBO_FREE_MEMORY_ATI, pool);
+        driverAvailableKB.store(pool[0], std::memory_order_relaxed);
+    }
+}
+
+// ============================ GPU MEMORY API ============================
+void installGpuMemoryTracking() {
+    if (hasGlExtension("GL_NVX_gpu_memory_info")) driverInfo = DRIVER_INFO_NVX;
+    else if (hasGlExtension("GL_ATI_meminfo")) driverInfo = DRIVER_INFO_ATI;
+    // Each wrapper only where the entry point loaded (a null one stays null, so checks for it still work)
+    if (glad_glGenBuffers) { realGenBuffers = glad_glGenBuffers; glad_glGenBuffers = countedGenBuffers; }
+    if (glad_glCreateBuffers) { realCreateBuffers = glad_glCreateBuffers; glad_glCreateBuffers = countedCreateBuffers; }
+    if (glad_glDeleteBuffers) { realDeleteBuffers = glad_glDeleteBuffers; glad_glDeleteBuffers = countedDeleteBuffers; }
+    if (glad_glBufferData) { realBufferData = glad_glBufferData; glad_glBufferData = countedBufferData; }
+    if (glad_glBufferStorage) { realBufferStorage = glad_glBufferStorage; glad_glBufferStorage = countedBufferStorage; }
+    if (glad_glNamedBufferData) { realNamedBufferData = glad_glNamedBufferData; glad_glNamedBufferData = countedNamedBufferData; }
+    if (glad_glNamedBufferStorage) { realNamedBufferStorage = glad_glNamedBufferStorage; glad_glNamedBufferStorage = countedNamedBufferStorage; }
+    if (glad_glGenVertexArrays) { realGenVertexArrays = glad_glGenVertexArrays; glad_glGenVertexArrays = countedGenVertexArrays; }
+    if (glad_glCreateVertexArrays) { realCreateVertexArrays = glad_glCreateVertexArrays; glad_glCreateVertexArrays = countedCreateVertexArrays; }
+    if (glad_glDeleteVertexArrays) { realDeleteVertexArrays = glad_glDeleteVertexArrays; glad_glDeleteVertexArrays = countedDeleteVertexArrays; }
+    queryDriver();
+    lastSample = std::chrono::steady_clock::now();
+    if (driverInfo == DRIVER_INFO_NVX) {
+        GLint dedicated = 0;
+        glGetIntegerv(GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX, &dedicated);
+        LOG_INFO("GPU memory: %.0f MB dedicated, %.0f MB available now (GL_NVX_gpu_memory_info)", dedicated / 1024.0,
+                 driverAvailableKB.load(std::memory_order_relaxed) / 1024.0);
+    }
+    else if (driverInfo == DRIVER_INFO_ATI) {
+        LOG_INFO("GPU memory: %.0f MB free in the buffer pool (GL_ATI_meminfo)", driverAvailableKB.load(std::memory_order_relaxed) / 1024.0);
+    }
+    else LOG_INFO("GPU memory: the driver reports none; counting the game's own buffers and vertex arrays only");
+}
+
+void sampleGpuMemory() {
+    static int64_t evictionsReported = -1;
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (driverInfo != DRIVER_INFO_NONE && now - lastSample >= std::chrono::milliseconds(GPU_MEMORY_SAMPLE_MS)) {
+        queryDriver();
+        lastSample = now;
+    }
+    const GpuMemoryStats stats = gpuMemoryStats();
+    profilerCount(COUNTER_GPU_BUFFERS, stats.buffers);
+    profilerCount(COUNTER_GPU_BUFFER_KB, stats.bufferBytes / 1024);
+    profilerCount(COUNTER_GPU_VERTEX_ARRAYS, stats.vertexArrays);
+    telemetrySet(TELEMETRY_GPU_BUFFERS, stats.buffers);
+    telemetrySet(TELEMETRY_GPU_BUFFER_KB, stats.bufferBytes / 1024);
+    telemetrySet(TELEMETRY_GPU_VERTEX_ARRAYS, stats.vertexArrays);
+    telemetrySet(TELEMETRY_GPU_AVAILABLE_KB, stats.availableKB);
+    if (stats.availableKB >= 0) profilerCount(COUNTER_GPU_AVAILABLE_MB, stats.availableKB / 1024);
+    if (stats.evictions >= 0) {
+        // The driver's count runs from context creation: only the new ones, frame by frame
+        if (evictionsReported >= 0 && stats.evictions > evictionsReported) {
+            profilerCount(COUNTER_GPU_EVICTIONS, stats.evictions - evictionsReported);
+            telemetryAdd(TELEMETRY_GPU_EVICTIONS, stats.evictions - evictionsReported);
+        }
+        evictionsReported = stats.evictions;
+    }
+}
+
+GpuMemoryStats gpuMemoryStats() {
+    GpuMemoryStats stats;
+    stats.buffers = liveBuffers.load(std::memory_order_relaxed);
+    stats.bufferBytes = liveBufferBytes.load(std::memory_order_relaxed);
+    stats.vertexArrays = liveVertexArrays.load(std::memory_order_relaxed);
+    stats.buffersCreated = buffersCreated.load(std::memory_order_relaxed);
+    stats.vertexArraysCreated = vertexArraysCreated.load(std::memory_order_relaxed);
+    stats.totalKB = driverTotalKB.load(std::memory_order_relaxed);
+    stats.availableKB = driverAvailableKB.load(std::memory_order_relaxed);
+    stats.evictions = driverEvictions.load(std::memory_order_relaxed);
+    stats.evictedKB = driverEvictedKB.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void logGpuMemory() {
+    const GpuMemoryStats stats = gpuMemoryStats();
+    LOG_INFO("GPU memory: %lld buffers (%.1f MB), %lld vertex arrays; %lld buffers and %lld vertex arrays created since startup",
+             static_cast<long long>(stats.buffers), stats.bufferBytes / (1024.0 * 1024.0), static_cast<long long>(stats.vertexArrays),
+             static_cast<long long>(stats.buffersCreated), static_cast<long long>(stats.vertexArraysCreated));
+    if (driverInfo == DRIVER_INFO_NVX) {
+        LOG_INFO("GPU memory: driver reports %.0f of %.0f MB available, %lld evictions (%.1f MB evicted)", stats.availableKB / 1024.0,
+                 stats.totalKB / 1024.0, static_cast<long long>(stats.evictions), stats.evictedKB / 1024.0);
+    }
+    else if (driverInfo == DRIVER_INFO_ATI) {
+        LOG_INFO("GPU memory: driver reports %.0f MB free in the buffer pool", stats.availableKB / 1024.0);
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+
+// ============================ GPU MEMORY ============================
+// What the driver says about video memory, next to what the game itself holds, sampled while the
+// game runs so a slow leak (buffers or vertex arrays created every frame and never deleted) shows
+// up as a climbing line long before the driver starts evicting.
+// Our side: after GLAD has loaded, installGpuMemoryTracking swaps the loaded buffer and vertex array
+// entry points (create, delete, and the store allocations) for counting wrappers, so every buffer
+// and vertex array the game creates is counted, with each buffer's allocated bytes, at the cost of
+// a table update per allocation (a glBufferData on an existing buffer stays a lookup).
+// The driver's side: GL_NVX_gpu_memory_info (total and available video memory, evictions and the
+// bytes evicted) or GL_ATI_meminfo (free memory in the buffer pool only), whichever the context
+// has; neither, and only our side is reported. The driver is asked every GPU_MEMORY_SAMPLE_MS.
+// Each frame's figures go to the profiler counters (COUNTER_GPU_*) and to the telemetry gauges.
+const int GPU_MEMORY_SAMPLE_MS = 500; // Between driver queries (the counts of our own are exact every frame)
+
+struct GpuMemoryStats {
+    // Ours, from the wrappers
+    int64_t buffers = 0;
+    int64_t bufferBytes = 0;
+    int64_t vertexArrays = 0;
+    int64_t buffersCreated = 0; // Since startup, so churn shows even when the live count holds
+    int64_t vertexArraysCreated = 0;
+    // The driver's (-1: not reported)
+    int64_t totalKB = -1;
+    int64_t availableKB = -1;
+    int64_t evictions = -1; // Since the context was created
+    int64_t evictedKB = -1;
+};
+
+// After GLAD has loaded, on the context that creates the game's objects and before any of them
+// exists (and before any shared context starts creating its own); logs what the driver reports
+void installGpuMemoryTracking();
+// Once a frame on the render thread: queries the driver when a sample is due and hands the figures
+// to the profiler and telemetry
+void sampleGpuMemory();
+GpuMemoryStats gpuMemoryStats(); // The latest figures (any thread)
+void logGpuMemory(); // One line: ours, then the driver's
@@ -0,0 +1,225 @@
+#include "gpuraster.h"
+#include "shaders.h"
+#include "log.h"
+#include "frameconstants.h"
+#include "glstate.h"
+#include "memreport.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include <glad/glad.h>
+
+// ============================ GPU RASTER STATE ============================
+bool useGpuRaster = false;
+
+static unsigned int rasterProgram;
+static unsigned int rasterVAO; // No attributes: every point comes from gl_VertexID
+static unsigned int captureBuffer; // Transform feedback target for the validation helpers
+static int modeLoc, linesLoc, lineStartLoc, lineCountLoc, circleLoc, screenSizeLoc, colorLoc;
+
+const int GPU_RASTER_MAX_LINES = 3;
+
+// ============================ SHADERS ============================
+// Lines: vertex i of a line is its i-th step along the major axis. The minor-axis offset
+// (2*i*minor + major - 1) / (2*major) matches the error-term walk in drawBresenhamLine exactly,
+// including its tie-breaking. Circle: vertex = step * 8 + octant; each vertex replays `step`
+// iterations of the midpoint decision loop and is clipped away once x > y (where the CPU loop stops).
+static const char* rasterVertexShaderSource = R"(
+    #version 330 core
+    uniform int mode; // 0 = lines, 1 = circle
+    uniform ivec4 lines[3]; // x0, y0, x1, y1
+    uniform int lineStart[4]; // First vertex of each line; lineStart[lineCount] is the total
+    uniform int lineCount;
+    uniform ivec3 circle; // cx, cy, radius
+    uniform vec2 screenSize;
+
+    flat out ivec3 pixel; // xy = pixel, z = 1 if the point is drawn
+
+    void main()
+    {
+        ivec2 p;
+        bool visible = true;
+        if (mode == 0) {
+            int l = 0;
+            while (l + 1 < lineCount && gl_VertexID >= lineStart[l + 1]) l++;
+            int i = gl_VertexID - lineStart[l];
+            ivec4 e = lines[l];
+            int dx = abs(e.z - e.x);
+            int dy = abs(e.w - e.y);
+            int sx = e.x < e.z ? 1 : -1;
+            int sy = e.y < e.w ? 1 : -1;
+            if (dx >= dy) {
+                int m = dx > 0 ? (2 * i * dy + dx - 1) / (2 * dx) : 0;
+                p = ivec2(e.x + sx * i, e.y + sy * m);
+            }
+            else {
+                int m = (2 * i * dx + dy - 1) / (2 * dy);
+                p = ivec2(e.x + sx * m, e.y + sy * i);
+            }
+        }
+        else {
+            int step = gl_VertexID / 8;
+            int octant = gl_VertexID - step * 8;
+            int x = 0;
+            int y = circle.z;
+            int d = 1 - circle.z;
+            for (int s = 0; s < step; ++s) {
+                x++;
+                if (d < 0) d = d + 2 * x + 1;
+                else { y--; d = d + 2 * (x - y) + 1; }
+            }
+            visible = x <= y;
+            ivec2 o;
+            if (octant == 0) o = ivec2(x, y);
+            else if (octant == 1) o = ivec2(-x, y);
+            else if (octant == 2) o = ivec2(x, -y);
+            else if (octant == 3) o = ivec2(-x, -y);
+            else if (octant == 4) o = ivec2(y, x);
+            else if (octant == 5) o = ivec2(-y, x);
+            else if (octant == 6) o = ivec2(y, -x);
+            else o = ivec2(-y, -x);
+            p = circle.xy + o;
+        }
+        pixel = ivec3(p, visible ? 1 : 0);
+        gl_Position = visible ? vec4(vec2(p) / (screenSize * 0.5) - 1.0, 0.0, 1.0) : vec4(2.0, 2.0, 2.0, 1.0);
+    }
+)";
+
+static const char* rasterFragmentShaderSource = R"(
+    #version 330 core
+)" FRAME_CONSTANTS_GLSL R"(
+    out vec4 FragColor;
+
+    uniform vec3 lineColor;
+
+    void main()
+    {
+        FragColor = vec4(lineColor, 1.0f) * tint;
+    }
+)";
+
+// ============================ SETUP ============================
+void setupGpuRaster(unsigned int screenWidth, unsigned int screenHeight)
+{
+    const char* captured[] = { "pixel" }; // Transform feedback output for the validation helpers
+    rasterProgram = buildProgram("gpu raster", rasterVertexShaderSource, rasterFragmentShaderSource, captured, 1);
+    if (!rasterProgram) LOG_WARN("GPU raster backend unavailable; G will have no effect");
+    bindFrameConstants(rasterProgram);
+
+    modeLoc = glGetUniformLocation(rasterProgram, "mode");
+    linesLoc = glGetUniformLocation(rasterProgram, "lines");
+    lineStartLoc = glGetUniformLocation(rasterProgram, "lineStart");
+    lineCountLoc = glGetUniformLocation(rasterProgram, "lineCount");
+    circleLoc = glGetUniformLocation(rasterProgram, "circle");
+    screenSizeLoc = glGetUniformLocation(rasterProgram, "screenSize");
+    colorLoc = glGetUniformLocation(rasterProgram, "lineColor");
+
+    setGpuRasterScreenSize(screenWidth, screenHeight);
+
+    glGenVertexArrays(1, &rasterVAO);
+    glGenBuffers(1, &captureBuffer);
+}
+
+void setGpuRasterScreenSize(unsigned int screenWidth, unsigned int screenHeight)
+{
+    glState.useProgram(rasterProgram);
+    glUniform2f(screenSizeLoc, static_cast<float>(screenWidth), static_cast<float>(screenHeight));
+    glState.useProgram(0);
+}
+
+void destroyGpuRaster()
+{
+    glDeleteBuffers(1, &captureBuffer);
+    glDeleteVertexArrays(1, &rasterVAO);
+    glDeleteProgram(rasterProgram);
+}
+
+void collectGpuRasterMemory(MemoryReport& report)
+{
+    report.add("gpu raster", "capture buffer", MEMORY_GPU, glBufferBytes(captureBuffer));
+}
+
+// ============================ DRAWING ============================
+// Sets the line uniforms and returns the vertex count (one per Bresenham step, endpoints included)
+static int prepareLines(const int* endpoints, int lineCount)
+{
+    lineCount = std::min(lineCount, GPU_RASTER_MAX_LINES);
+    int lineStart[GPU_RASTER_MAX_LINES + 1] = { 0 };
+    for (int l = 0; l < lineCount; ++l) {
+        const int* e = endpoints + l * 4;
+        lineStart[l + 1] = lineStart[l] + std::max(std::abs(e[2] - e[0]), std::abs(e[3] - e[1])) + 1;
+    }
+    glUniform1i(modeLoc, 0);
+    glUniform4iv(linesLoc, lineCount, endpoints);
+    glUniform1iv(lineStartLoc, lineCount + 1, lineStart);
+    glUniform1i(lineCountLoc, lineCount);
+    return lineStart[lineCount];
+}
+
+// Sets the circle uniforms and returns the vertex count (8 per step, enough steps to pass x > y)
+static int prepareCircle(int cx, int cy, int radius)
+{
+    glUniform1i(modeLoc, 1);
+    glUniform3i(circleLoc, cx, cy, radius);
+    return (radius + 1) * 8;
+}
+
+void drawGpuBresenhamLines(const int* endpoints, int lineCount, const glm::vec3& color, float pointSize)
+{
+    glState.useProgram(rasterProgram);
+    int vertexCount = prepareLines(endpoints, lineCount);
+    glState.uniform3f(colorLoc, color.x, color.y, color.z);
+    glState.setPointSize(pointSize);
+    glState.bindVertexArray(rasterVAO);
+    glDrawArrays(GL_POINTS, 0, vertexCount);
+}
+
+void drawGpuMidpointCircle(int cx, int cy, int radius, const glm::vec3& color, float pointSize)
+{
+    glState.useProgram(rasterProgram);
+    int vertexCount = prepareCircle(cx, cy, radius);
+    glState.uniform3f(colorLoc, color.x, color.y, color.z);
+    glState.setPointSize(pointSize);
+    glState.bindVertexArray(rasterVAO);
+    glDrawArrays(GL_POINTS, 0, vertexCount);
+}
+
+// ============================ VALIDATION CAPTURE ============================
+static std::vector<glm::ivec2> capture(int vertexCount)
+{
+    std::vector<glm::ivec3> captured(vertexCount);
+    glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, captureBuffer);
+    glBufferData(GL_TRANSFORM_FEEDBACK_BUFFER, vertexCount * sizeof(glm::ivec3), NULL, GL_STREAM_READ);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, captureBuffer);
+
+    glState.setEnabled(GL_RASTERIZER_DISCARD, true);
+    glState.bindVertexArray(rasterVAO);
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArrays(GL_POINTS, 0, vertexCount);
+    glEndTransformFeedback();
+    glState.setEnabled(GL_RASTERIZER_DISCARD, false);
+
+    glGetBufferSubData(GL_TRANSFORM_FEEDBACK_BUFFER, 0, vertexCount * sizeof(glm::ivec3), captured.data());
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+
+    std::vector<glm::ivec2> pixels;
+    pixels.reserve(vertexCount);
+    for (const glm::ivec3& p : captured) {
+        if (p.z) pixels.push_back(glm::ivec2(p.x, p.y));
+    }
+    return pixels;
+}
+
+std::vector<glm::ivec2> captureGpuBresenhamLine(int x0, int y0, int x1, int y1)
+{
+    int endpoints[4] = { x0, y0, x1, y1 };
+    glState.useProgram(rasterProgram);
+    return capture(prepareLines(endpoints, 1));
+}
+
+std::vector<glm::ivec2> captureGpuMidpointCircle(int cx, int cy, int radius)
+{
+    glState.useProgram(rasterProgram);
+    return capture(prepareCircle(cx, cy, radius));
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+struct MemoryReport;
+
+// GPU backend for the Bresenham line and midpoint circle rasterizers. Only the endpoints (or the
+// center and radius) are sent as uniforms; a vertex shader derives one pixel per gl_VertexID with
+// the same integer math as the CPU versions, so the point set is identical and nothing is uploaded.
+
+// ============================ GPU RASTER STATE ============================
+extern bool useGpuRaster; // Draw the ship outline and shield with the GPU backend (toggle with G)
+
+// ============================ GPU RASTER API ============================
+void setupGpuRaster(unsigned int screenWidth, unsigned int screenHeight);
+void destroyGpuRaster();
+void collectGpuRasterMemory(MemoryReport& report); // The validation capture buffer
+// Pixel space the shaders map to clip space; call when the framebuffer is resized
+void setGpuRasterScreenSize(unsigned int screenWidth, unsigned int screenHeight);
+
+// Draws up to 3 Bresenham lines; `endpoints` holds x0,y0,x1,y1 per line in pixels
+void drawGpuBresenhamLines(const int* endpoints, int lineCount, const glm::vec3& color, float pointSize);
+// Draws a midpoint circle in pixels
+void drawGpuMidpointCircle(int cx, int cy, int radius, const glm::vec3& color, float pointSize);
+
+// Validation helpers: run the same shaders with transform feedback and return the generated pixels
+// (points the circle shader clips away are left out)
+std::vector<glm::ivec2> captureGpuBresenhamLine(int x0, int y0, int x1, int y1);
+std::vector<glm::ivec2> captureGpuMidpointCircle(int cx, int cy, int radius);
@@ -0,0 +1,419 @@
+#include "hud.h"
+#include "assetcache.h"
+#include "glstate.h"
+#include "log.h"
+#include "memreport.h"
+#include "profiler.h"
+#include "shaders.h"
+#include "streambuffer.h"
+#include "gldebug.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include <glad/glad.h>
+
+bool showPerfOverlay = false;
+
+// ============================ FONT ============================
+// Columns of ' ' (32) to '_' (95), bit 0 the top row. Lower case borrows the upper-case glyphs; codes
+// without a glyph draw nothing, and the cell after the last one (127) is solid, for rectangles.
+const int FONT_FIRST = 32;
+const int FONT_GLYPHS = 64;
+const int FONT_SOLID = 127;
+const int FONT_COLUMNS = 16; // Atlas cells per row, for codes 32..127
+const int FONT_ROWS = 6;
+static const unsigned char fontColumns[FONT_GLYPHS][5] = {
+    { 0x00, 0x00, 0x00, 0x00, 0x00 }, // space
+    { 0x00, 0x00, 0x5F, 0x00, 0x00 }, // !
+    { 0x00, 0x07, 0x00, 0x07, 0x00 }, // "
+    { 0x14, 0x7F, 0x14, 0x7F, 0x14 }, // #
+    { 0x24, 0x2A, 0x7F, 0x2A, 0x12 }, // $
+    { 0x23, 0x13, 0x08, 0x64, 0x62 }, // %
+    { 0x36, 0x49, 0x56, 0x20, 0x50 }, // &
+    { 0x00, 0x00, 0x07, 0x00, 0x00 }, // '
+    { 0x00, 0x1C, 0x22, 0x41, 0x00 }, // (
+    { 0x00, 0x41, 0x22, 0x1C, 0x00 }, // )
+    { 0x14, 0x08, 0x3E, 0x08, 0x14 }, // *
+    { 0x08, 0x08, 0x3E, 0x08, 0x08 }, // +
+    { 0x00, 0x50, 0x30, 0x00, 0x00 }, // ,
+    { 0x08, 0x08, 0x08, 0x08, 0x08 }, // -
+    { 0x00, 0x60, 0x60, 0x00, 0x00 }, // .
+    { 0x20, 0x10, 0x08, 0x04, 0x02 }, // /
+    { 0x3E, 0x51, 0x49, 0x45, 0x3E }, // 0
+    { 0x00, 0x42, 0x7F, 0x40, 0x00 }, // 1
+    { 0x42, 0x61, 0x51, 0x49, 0x46 }, // 2
+    { 0x21, 0x41, 0x45, 0x4B, 0x31 }, // 3
+    { 0x18, 0x14, 0x12, 0x7F, 0x10 }, // 4
+    { 0x27, 0x45, 0x45, 0x45, 0x39 }, // 5
+    { 0x3C, 0x4A, 0x49, 0x49, 0x30 }, // 6
+    { 0x01, 0x71, 0x09, 0x05, 0x03 }, // 7
+    { 0x36, 0x49, 0x49, 0x49, 0x36 }, // 8
+    { 0x06, 0x49, 0x49, 0x29, 0x1E }, // 9
+    { 0x00, 0x36, 0x36, 0x00, 0x00 }, // :
+    { 0x00, 0x56, 0x36, 0x00, 0x00 }, // ;
+    { 0x08, 0x14, 0x22, 0x41, 0x00 }, // <
+    { 0x14, 0x14, 0x14, 0x14, 0x14 }, // =
+    { 0x00, 0x41, 0x22, 0x14, 0x08 }, // >
+    { 0x02, 0x01, 0x51, 0x09, 0x06 }, // ?
+    { 0x32, 0x49, 0x79, 0x41, 0x3E }, // @
+    { 0x7E, 0x11, 0x11, 0x11, 0x7E }, // A
+    { 0x7F, 0x49, 0x49, 0x49, 0x36 }, // B
+    { 0x3E, 0x41, 0x41, 0x41, 0x22 }, // C
+    { 0x7F, 0x41, 0x41, 0x22, 0x1C }, // D
+    { 0x7F, 0x49, 0x49, 0x49, 0x41 }, // E
+    { 0x7F, 0x09, 0x09, 0x09, 0x01 }, // F
+    { 0x3E, 0x41, 0x49, 0x49, 0x7A }, // G
+    { 0x7F, 0x08, 0x08, 0x08, 0x7F }, // H
+    { 0x00, 0x41, 0x7F, 0x41, 0x00 }, // I
+    { 0x20, 0x40, 0x41, 0x3F, 0x01 }, // J
+    { 0x7F, 0x08, 0x14, 0x22, 0x41 }, // K
+    { 0x7F, 0x40, 0x40, 0x40, 0x40 }, // L
+    { 0x7F, 0x02, 0x0C, 0x02, 0x7F }, // M
+    { 0x7F, 0x04, 0x08, 0x10, 0x7F }, // N
+    { 0x3E, 0x41, 0x41, 0x41, 0x3E }, // O
+    { 0x7F, 0x09, 0x09, 0x09, 0x06 }, // P
+    { 0x3E, 0x41, 0x51, 0x21, 0x5E }, // Q
+    { 0x7F, 0x09, 0x19, 0x29, 0x46 }, // R
+    { 0x46, 0x49, 0x49, 0x49, 0x31 }, // S
+    { 0x01, 0x01, 0x7F, 0x01, 0x01 }, // T
+    { 0x3F, 0x40, 0x40, 0x40, 0x3F }, // U
+    { 0x1F, 0x20, 0x40, 0x20, 0x1F }, // V
+    { 0x3F, 0x40, 0x38, 0x40, 0x3F }, // W
+    { 0x63, 0x14, 0x08, 0x14, 0x63 }, // X
+    { 0x07, 0x08, 0x70, 0x08, 0x07 }, // Y
+    { 0x61, 0x51, 0x49, 0x45, 0x43 }, // Z
+    { 0x00, 0x7F, 0x41, 0x41, 0x00 }, // [
+    { 0x02, 0x04, 0x08, 0x10, 0x20 }, // backslash
+    { 0x00, 0x41, 0x41, 0x7F, 0x00 }, // ]
+    { 0x04, 0x02, 0x01, 0x02, 0x04 }, // ^
+    { 0x40, 0x40, 0x40, 0x40, 0x40 }, // _
+};
+
+// ============================ HUD STATE ============================
+struct HudGlyph {
+    float x, y, width, height; // Framebuffer pixels, top-left corner
+    float code; // Character code; FONT_SOLID for a rectangle
+    uint32_t color; // RGBA8
+};
+
+static unsigned int hudProgram;
+static int hudScreenSizeLoc;
+static unsigned int hudVAO;
+static unsigned int fontTexture;
+static HudGlyph glyphs[HUD_MAX_GLYPHS];
+static int glyphCount = 0;
+static long long glyphsDropped = 0;
+
+// Overlay figures, refreshed a few times a second so they can be read
+const double OVERLAY_REFRESH_SECONDS = 0.25;
+const int OVERLAY_PHASES_SHOWN = 6;
+struct OverlayFigures {
+    ProfileStats frame, gpuTotal;
+    float asteroids, drawn, bullets, drawCalls, uploadKB, allocations;
+    int phaseCount;
+    ProfilePhase phases[OVERLAY_PHASES_SHOWN]; // Busiest first
+    float phaseMs[OVERLAY_PHASES_SHOWN];
+};
+static OverlayFigures overlay = {};
+static std::chrono::steady_clock::time_point overlayRefreshed;
+static float frameTimes[PROFILE_HISTORY];
+
+// ============================ SHADERS ============================
+static const char* hudVertexSource = R"(
+    #version 330 core
+    layout (location = 0) in vec4 iRect; // x, y, width, height in pixels from the top-left
+    layout (location = 1) in float iCode;
+    layout (location = 2) in vec4 iColor;
+    uniform vec2 screenSize;
+    out vec2 uv;
+    out vec4 color;
+
+    const vec2 CELL = vec2(6.0, 8.0);
+    const vec2 ATLAS = vec2(16.0 * 6.0, 6.0 * 8.0);
+
+    void main()
+    {
+        vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+        vec2 pixel = iRect.xy + corner * iRect.zw;
+        gl_Position = vec4(pixel.x / screenSize.x * 2.0 - 1.0, 1.0 - pixel.y / screenSize.y * 2.0, 0.0, 1.0);
+        int cell = int(iCode) - 32;
+        uv = (vec2(cell % 16, cell / 16) + corner) * CELL / ATLAS;
+        color = iColor;
+    }
+)";
+
+static const char* hudFragmentSource = R"(
+    #version 330 core
+    in vec2 uv;
+    in vec4 color;
+    uniform sampler2D font;
+    out vec4 FragColor;
+
+    void main()
+    {
+        FragColor = vec4(color.rgb, color.a * texture(font, uv).r);
+    }
+)";
+
+// ============================ SETUP ============================
+bool setupHud() {
+    hudProgram = buildProgram("hud", hudVertexSource, hudFragmentSource);
+    if (!hudProgram) return false;
+    hudScreenSizeLoc = glGetUniformLocation(hudProgram, "screenSize");
+    glUseProgram(hudProgram);
+    glUniform1i(glGetUniformLocation(hudProgram, "font"), 0);
+    glUseProgram(0);
+    glState.invalidate();
+
+    // Codes 32..127 in FONT_COLUMNS x FONT_ROWS cells, each glyph in its cell's top-left 5x7; from the
+    // asset cache when it holds this font and cell size
+    const int atlasWidth = FONT_COLUMNS * HUD_CELL_WIDTH, atlasHeight = FONT_ROWS * HUD_CELL_HEIGHT;
+    unsigned char baked[FONT_COLUMNS * HUD_CELL_WIDTH * FONT_ROWS * HUD_CELL_HEIGHT] = {};
+    const uint64_t fontKey = assetHash(assetHash(assetHash(ASSET_HASH_START, fontColumns), HUD_CELL_WIDTH), HUD_CELL_HEIGHT);
+    size_t cachedBytes = 0;
+    const unsigned char* texels = static_cast<const unsigned char*>(findAsset(ASSET_FONT, fontKey, cachedBytes));
+    if (!texels || cachedBytes != sizeof(baked)) {
+        for (int code = FONT_FIRST; code <= FONT_SOLID; ++code) {
+            const int cell = code - FONT_FIRST;
+            const int left = (cell % FONT_COLUMNS) * HUD_CELL_WIDTH, top = (cell / FONT_COLUMNS) * HUD_CELL_HEIGHT;
+            for (int y = 0; y < HUD_CELL_HEIGHT; ++y) {
+                for (int x = 0; x < HUD_CELL_WIDTH; ++x) {
+                    bool on = code == FONT_SOLID;
+                    if (cell < FONT_GLYPHS && x < 5 && y < 7) on = (fontColumns[cell][x] >> y) & 1;
+                    baked[(top + y) * atlasWidth + left + x] = on ? 255 : 0;
+                }
+            }
+        }
+        storeAsset(ASSET_FONT, fontKey, baked, sizeof(baked));
+        texels = baked;
+    }
+    glGenTextures(1, &fontTexture);
+    glBindTexture(GL_TEXTURE_2D, fontTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, atlasWidth, atlasHeight, 0, GL_RED, GL_UNSIGNED_BYTE, texels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    labelGlObject(GL_TEXTURE, fontTexture, "hud font");
+
+    // Instance attributes only: the quad's corners come from gl_VertexID. They are pointed at the
+    // stream buffer per draw (bind-to-edit) or through binding 0 (DSA).
+    if (useDirectStateAccess) {
+        glCreateVertexArrays(1, &hudVAO);
+        glVertexArrayAttribFormat(hudVAO, 0, 4, GL_FLOAT, GL_FALSE, offsetof(HudGlyph, x));
+        glVertexArrayAttribFormat(hudVAO, 1, 1, GL_FLOAT, GL_FALSE, offsetof(HudGlyph, code));
+        glVertexArrayAttribFormat(hudVAO, 2, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(HudGlyph, color));
+        for (unsigned int attrib = 0; attrib <= 2; ++attrib) {
+            glVertexArrayAttribBinding(hudVAO, attrib, 0);
+            glEnableVertexArrayAttrib(hudVAO, attrib);
+        }
+        glVertexArrayBindingDivisor(hudVAO, 0, 1);
+    }
+    else {
+        glGenVertexArrays(1, &hudVAO);
+        glBindVertexArray(hudVAO);
+        for (unsigned int attrib = 0; attrib <= 2; ++attrib) {
+            glEnableVertexAttribArray(attrib);
+            glVertexAttribDivisor(attrib, 1);
+        }
+        glBindVertexArray(0);
+    }
+    labelGlObject(GL_VERTEX_ARRAY, hudVAO, "hud");
+    overlayRefreshed = std::chrono::steady_clock::now() - std::chrono::seconds(1);
+    return true;
+}
+
+void destroyHud() {
+    glDeleteProgram(hudProgram);
+    glDeleteVertexArrays(1, &hudVAO);
+    glDeleteTextures(1, &fontTexture);
+    hudProgram = hudVAO = fontTexture = 0;
+    if (glyphsDropped > 0) LOG_INFO("HUD: %lld glyphs did not fit the queue (HUD_MAX_GLYPHS)", glyphsDropped);
+}
+
+void collectHudMemory(MemoryReport& report) {
+    if (!hudProgram) return;
+    report.add("hud", "font atlas", MEMORY_GPU, static_cast<size_t>(FONT_COLUMNS * HUD_CELL_WIDTH * FONT_ROWS * HUD_CELL_HEIGHT));
+    report.add("hud", "glyph queue", MEMORY_CPU, sizeof(glyphs));
+}
+
+// ============================ QUEUEING ============================
+static uint32_t packColor(const glm::vec4& color) {
+    const glm::vec4 c = glm::clamp(color, 0.0f, 1.0f) * 255.0f + 0.5f;
+    return static_cast<uint32_t>(c.r) | static_cast<uint32_t>(c.g) << 8 | static_cast<uint32_t>(c.b) << 16 | static_cast<uint32_t>(c.a) << 24;
+}
+
+static void queueGlyph(float x, float y, float width, float height, int code, uint32_t color) {
+    if (glyphCount == HUD_MAX_GLYPHS) {
+        ++glyphsDropped;
+        return;
+    }
+    glyphs[glyphCount++] = { x, y, width, height, static_cast<float>(code), color };
+}
+
+void hudText(float x, float y, float scale, const glm::vec4& color, const char* text) {
+    const uint32_t packed = packColor(color);
+    const float startX = x;
+    for (const char* c = text; *c; ++c) {
+        int code = static_cast<unsigned char>(*c);
+        if (code == '\n') {
+            x = startX;
+            y += HUD_CELL_HEIGHT * scale;
+            continue;
+        }
+        if (code >= 'a' && code <= 'z') code -= 'a' - 'A';
+        if (code > FONT_FIRST && code < FONT_FIRST + FONT_GLYPHS) queueGlyph(x, y, HUD_CELL_WIDTH * scale, HUD_CELL_HEIGHT * scale, code, packed);
+        x += HUD_CELL_WIDTH * scale;
+    }
+}
+
+void hudPrintf(float x, float y, float scale, const glm::vec4& color, const char* format, ...) {
+    char text[256];
+    va_list args;
+    va_start(args, format);
+    std::vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    hudText(x, y, scale, color, text);
+}
+
+void hudRect(float x, float y, float width, float height, const glm::vec4& color) {
+    queueGlyph(x, y, width, height, FONT_SOLID, packColor(color));
+}
+
+float hudTextWidth(const char* text, float scale) {
+    return static_cast<float>(std::strlen(text)) * HUD_CELL_WIDTH * scale;
+}
+
+// ============================ PERF OVERLAY ============================
+static void refreshOverlay() {
+    overlay.frame = profilerPhaseStats(PHASE_FRAME);
+    overlay.gpuTotal = ProfileStats{ 0.0f, 0.0f, 0.0f };
+    overlay.phaseCount = 0;
+    for (int p = 0; p < PHASE_COUNT; ++p) {
+        const ProfilePhase phase = static_cast<ProfilePhase>(p);
+        overlay.gpuTotal.average += profilerGpuStats(phase).average;
+        if (phase == PHASE_FRAME || phase == PHASE_SWAP_BUFFERS) continue; // The swap mostly waits for vsync
+        const float ms = profilerPhaseStats(phase).average;
+        if (ms < 0.005f) continue;
+        // Insertion into the busiest OVERLAY_PHASES_SHOWN
+        int slot = std::min(overlay.phaseCount, OVERLAY_PHASES_SHOWN - 1);
+        if (overlay.phaseCount == OVERLAY_PHASES_SHOWN && ms <= overlay.phaseMs[slot]) continue;
+        while (slot > 0 && overlay.phaseMs[slot - 1] < ms) {
+            overlay.phases[slot] = overlay.phases[slot - 1];
+            overlay.phaseMs[slot] = overlay.phaseMs[slot - 1];
+            --slot;
+        }
+        overlay.phases[slot] = phase;
+        overlay.phaseMs[slot] = ms;
+        overlay.phaseCount = std::min(overlay.phaseCount + 1, OVERLAY_PHASES_SHOWN);
+    }
+    overlay.drawn = profilerCounterStats(COUNTER_ASTEROIDS_DRAWN).average;
+    overlay.asteroids = overlay.drawn + profilerCounterStats(COUNTER_ASTEROIDS_CULLED).average;
+    overlay.bullets = profilerCounterStats(COUNTER_BULLETS_LIVE).average;
+    overlay.drawCalls = profilerCounterStats(COUNTER_DRAW_CALLS).average;
+    overlay.uploadKB = profilerCounterStats(COUNTER_UPLOAD_KB).average;
+    overlay.allocations = profilerCounterStats(COUNTER_ALLOCATIONS).average;
+}
+
+static void queuePerfOverlay(float left, float top) {
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (std::chrono::duration<double>(now - overlayRefreshed).count() >= OVERLAY_REFRESH_SECONDS) {
+        refreshOverlay();
+        overlayRefreshed = now;
+    }
+    const float scale = 2.0f;
+    const float line = HUD_CELL_HEIGHT * scale + 2.0f;
+    const glm::vec4 text(0.9f, 0.95f, 1.0f, 1.0f);
+    const glm::vec4 dim(0.6f, 0.7f, 0.8f, 1.0f);
+
+    // Panel behind everything: header lines, graph, counts, phases
+    const float graphHeight = 72.0f; // 36 ms at 2 px per ms
+    const float pixelsPerMs = 2.0f;
+    const float width = PROFILE_HISTORY + 16.0f;
+    const float height = line * (4 + overlay.phaseCount) + graphHeight + 24.0f;
+    hudRect(left, top, width, height, glm::vec4(0.0f, 0.0f, 0.0f, 0.6f));
+    float x = left + 8.0f, y = top + 8.0f;
+
+    const float fps = overlay.frame.average > 0.0f ? 1000.0f / overlay.frame.average : 0.0f;
+    hudPrintf(x, y, scale, text, "FPS %.0f  FRAME %.2f MS  P99 %.2f", fps, overlay.frame.average, overlay.frame.p99);
+    y += line;
+    hudPrintf(x, y, scale, text, "GPU %.2f MS  %s", overlay.gpuTotal.average,
+              overlay.gpuTotal.average > overlay.frame.average ? "GPU-BOUND" : "CPU-BOUND");
+    y += line + 4.0f;
+
+    // Frame-time graph, newest on the right, with 60 and 30 FPS lines
+    const int frames = profilerPhaseHistory(PHASE_FRAME, frameTimes, PROFILE_HISTORY);
+    const float graphBottom = y + graphHeight;
+    hudRect(x, y, static_cast<float>(PROFILE_HISTORY), graphHeight, glm::vec4(0.1f, 0.1f, 0.15f, 0.8f));
+    for (int i = 0; i < frames; ++i) {
+        const float ms = frameTimes[i];
+        const float barHeight = std::min(ms * pixelsPerMs, graphHeight);
+        const glm::vec4 color = ms > 33.4f ? glm::vec4(1.0f, 0.25f, 0.2f, 1.0f) : ms > 16.7f ? glm::vec4(1.0f, 0.85f, 0.2f, 1.0f)
+                                                                                        : glm::vec4(0.3f, 0.9f, 0.4f, 1.0f);
+        hudRect(x + PROFILE_HISTORY - frames + i, graphBottom - barHeight, 1.0f, barHeight, color);
+    }
+    hudRect(x, graphBottom - 16.67f * pixelsPerMs, static_cast<float>(PROFILE_HISTORY), 1.0f, glm::vec4(1.0f, 1.0f, 1.0f, 0.35f));
+    hudRect(x, graphBottom - 33.33f * pixelsPerMs, static_cast<float>(PROFILE_HISTORY), 1.0f, glm::vec4(1.0f, 1.0f, 1.0f, 0.35f));
+    y = graphBottom + 8.0f;
+
+    hudPrintf(x, y, scale, text, "ROCKS %.0f (%.0f DRAWN)  BULLETS %.0f", overlay.asteroids, overlay.drawn, overlay.bullets);
+    y += line;
+    hudPrintf(x, y, scale, text, "DRAWS %.0f  UPLOAD %.0f KB  ALLOCS %.0f", overlay.drawCalls, overlay.uploadKB, overlay.allocations);
+    y += line;
+    for (int i = 0; i < overlay.phaseCount; ++i) {
+        hudPrintf(x, y, scale, dim, "%-18s %6.2f MS", profilerPhaseName(overlay.phases[i]), overlay.phaseMs[i]);
+        y += line;
+    }
+}
+
+void queueHud(int width, int height, int score, bool gameOver, bool canRestart) {
+    const glm::vec4 white(1.0f);
+    hudPrintf(12.0f, 12.0f, 3.0f, white, "SCORE %d", score);
+    if (gameOver) {
+        const char* text = "GAME OVER";
+        const float scale = std::max(4.0f, std::floor(width / 160.0f));
+        const float y = (height - HUD_CELL_HEIGHT * scale) * 0.5f;
+        hudText((width - hudTextWidth(text, scale)) * 0.5f, y, scale, white, text);
+        if (canRestart) {
+            const char* hint = "PRESS ENTER";
+            const float hintScale = std::max(2.0f, std::floor(scale * 0.5f));
+            hudText((width - hudTextWidth(hint, hintScale)) * 0.5f, y + HUD_CELL_HEIGHT * (scale + hintScale), hintScale, white, hint);
+        }
+    }
+    if (showPerfOverlay) queuePerfOverlay(12.0f, 12.0f + HUD_CELL_HEIGHT * 3.0f + 12.0f);
+}
+
+// ============================ DRAW ============================
+int drawHud(int width, int height) {
+    const int count = glyphCount;
+    glyphCount = 0;
+    if (count == 0 || !hudProgram) return 0;
+    const size_t offset = streamBuffer.write(glyphs, count * sizeof(HudGlyph), sizeof(float));
+    if (offset == STREAM_WRITE_FAILED) return 0;
+
+    glState.useProgram(hudProgram);
+    glUniform2f(hudScreenSizeLoc, static_cast<float>(width), static_cast<float>(height));
+    glState.bindVertexArray(hudVAO);
+    if (useDirectStateAccess) glVertexArrayVertexBuffer(hudVAO, 0, streamBuffer.vbo, static_cast<GLintptr>(offset), sizeof(HudGlyph));
+    else {
+        // write() left the stream buffer bound to GL_ARRAY_BUFFER
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(HudGlyph), (void*)(offset + offsetof(HudGlyph, x)));
+        glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, sizeof(HudGlyph), (void*)(offset + offsetof(HudGlyph, code)));
+        glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(HudGlyph), (void*)(offset + offsetof(HudGlyph, color)));
+    }
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, fontTexture);
+    glState.setEnabled(GL_BLEND, true);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
+    glState.setEnabled(GL_BLEND, false);
+    return 1;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+struct MemoryReport;
+
+// Text and flat rectangles drawn over the finished frame. A 5x7 bitmap font (printable ASCII, lower
+// case drawn as upper case) is packed into one small R8 texture; every string and rectangle queued
+// during the frame becomes one instance (a screen rectangle, a glyph cell and a color) in the stream
+// buffer, and the whole HUD is one instanced triangle-strip draw whose vertex shader builds the quads
+// from gl_VertexID. Rectangles are the font's solid cell stretched, so the frame-time graph and its
+// backing panel go out in the same draw as the text.
+// The perf overlay (H, --perf-hud) shows what the profiler's rolling window holds: frame rate, frame
+// and GPU times, the frame-time graph, entity, draw-call and upload counts and the busiest phases.
+extern bool showPerfOverlay;
+
+const int HUD_MAX_GLYPHS = 4096; // Instances per frame; the rest of a frame's text is dropped
+const int HUD_CELL_WIDTH = 6; // Font pixels per character advance (5 wide + 1 spacing)
+const int HUD_CELL_HEIGHT = 8; // Font pixels per line (7 high + 1 spacing)
+
+// ============================ HUD API ============================
+bool setupHud();
+void destroyHud();
+void collectHudMemory(MemoryReport& report);
+
+// Queue for this frame's draw. Positions are framebuffer pixels from the top-left corner; `scale`
+// is screen pixels per font pixel.
+void hudText(float x, float y, float scale, const glm::vec4& color, const char* text);
+void hudPrintf(float x, float y, float scale, const glm::vec4& color, const char* format, ...);
+void hudRect(float x, float y, float width, float height, const glm::vec4& color);
+// Width in pixels of `text` at `scale`
+float hudTextWidth(const char* text, float scale);
+
+// Queues the score (and GAME OVER once the game has ended, with the key to play again when
+// `canRestart`) and, when shown, the perf overlay
+void queueHud(int width, int height, int score, bool gameOver, bool canRestart);
+// Uploads the queued instances and draws them over the frame; returns the draw calls issued (0 or 1)
+int drawHud(int width, int height);
@@ -0,0 +1,193 @@
+#include "inputlatency.h"
+#include "log.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstdio>
+
+#include <glad/glad.h>
+
+typedef std::chrono::steady_clock Clock;
+
+bool inputLatencyEnabled = false;
+
+// ============================ PRESS RECORDS ============================
+// By stamp; each field written by one thread and read by the render thread once a snapshot (or the
+// frame before it) has made it visible
+struct PressRecord {
+    std::atomic<int64_t> pressedNs{ 0 }; // Clock ticks since its epoch, in nanoseconds
+    std::atomic<int64_t> appliedNs{ 0 };
+};
+
+static PressRecord records[INPUT_LATENCY_RECORDS];
+static std::atomic<uint32_t> nextStamp{ 1 }; // 0: no press
+static uint32_t newestApplied = 0; // The consumer only
+
+static int64_t clockNs(Clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+uint32_t stampKeyPress(Clock::time_point pressed) {
+    if (!inputLatencyEnabled) return 0;
+    const uint32_t stamp = nextStamp.fetch_add(1, std::memory_order_relaxed);
+    PressRecord& record = records[stamp % INPUT_LATENCY_RECORDS];
+    record.appliedNs.store(0, std::memory_order_relaxed);
+    record.pressedNs.store(clockNs(pressed), std::memory_order_relaxed);
+    return stamp;
+}
+
+void noteKeyPressApplied(uint32_t stamp) {
+    if (stamp == 0) return;
+    records[stamp % INPUT_LATENCY_RECORDS].appliedNs.store(clockNs(Clock::now()), std::memory_order_relaxed);
+    newestApplied = std::max(newestApplied, stamp);
+}
+
+uint32_t appliedKeyPress() {
+    return newestApplied;
+}
+
+// ============================ HISTOGRAMS ============================
+// The render thread only
+enum LatencyStage { STAGE_TICK, STAGE_SUBMIT, STAGE_SWAP, STAGE_GPU, STAGE_COUNT };
+static const char* stageNames[STAGE_COUNT] = { "key -> tick", "key -> frame submitted", "key -> swap returned", "key -> GPU done" };
+
+struct StageHistogram {
+    uint32_t counts[INPUT_LATENCY_BUCKETS] = {};
+    uint64_t samples = 0;
+    int64_t maxNs = 0;
+
+    void add(int64_t ns) {
+        const uint64_t v = static_cast<uint64_t>(std::max<int64_t>(ns / 1000, 0)) + 1;
+        const int octave = static_cast<int>(std::bit_width(v)) - 1;
+        const int quarter = static_cast<int>((octave >= 2 ? v >> (octave - 2) : v << (2 - octave)) & 3u);
+        ++counts[std::min(4 * octave + quarter, INPUT_LATENCY_BUCKETS - 1)];
+        ++samples;
+        maxNs = std::max(maxNs, ns);
+    }
+};
+
+static StageHistogram stages[STAGE_COUNT];
+
+// The upper edge of bucket b, in milliseconds
+static double bucketEdgeMs(int b) {
+    return (std::ldexp(5.0 + b % 4, b / 4) / 4.0 - 1.0) / 1000.0;
+}
+
+// The upper edge of the bucket holding the `fraction` quantile, in milliseconds
+static double percentileMs(const StageHistogram& histogram, double fraction) {
+    if (histogram.samples == 0) return 0.0;
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(histogram.samples))));
+    uint64_t seen = 0;
+    int b = 0;
+    while (b < INPUT_LATENCY_BUCKETS - 1 && (seen += histogram.counts[b]) < rank) ++b;
+    return bucketEdgeMs(b);
+}
+
+// ============================ GPU TIMESTAMPS ============================
+// The render thread only: one query per frame that showed a press, with the stamps it showed
+struct PendingQuery {
+    uint32_t first, last; // (first, last]
+};
+
+static GLuint queries[INPUT_LATENCY_QUERIES];
+static PendingQuery pending[INPUT_LATENCY_QUERIES];
+static bool queriesMade = false;
+static int pendingHead = 0, pendingCount = 0;
+static int64_t gpuToCpuNs = 0; // Add to a GPU timestamp for the CPU clock
+static Clock::time_point lastCalibration;
+static uint32_t lastPresented = 0;
+static uint64_t gpuSkipped = 0; // Frames that showed a press while every query was in flight
+static Clock::time_point lastReport = Clock::now();
+
+static void calibrate(Clock::time_point now) {
+    GLint64 gpuNow = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+    gpuToCpuNs = clockNs(Clock::now()) - gpuNow;
+    lastCalibration = now;
+}
+
+// Reads back the oldest queries that have finished, without waiting
+static void collectQueries() {
+    while (pendingCount > 0) {
+        const GLuint query = queries[pendingHead];
+        GLint available = 0;
+        glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) return;
+        GLuint64 gpuNs = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &gpuNs);
+        const int64_t doneNs = static_cast<int64_t>(gpuNs) + gpuToCpuNs;
+        const PendingQuery& shown = pending[pendingHead];
+        for (uint32_t stamp = shown.first + 1; stamp != shown.last + 1; ++stamp) {
+            stages[STAGE_GPU].add(doneNs - records[stamp % INPUT_LATENCY_RECORDS].pressedNs.load(std::memory_order_relaxed));
+        }
+        pendingHead = (pendingHead + 1) % INPUT_LATENCY_QUERIES;
+        --pendingCount;
+    }
+}
+
+// ============================ FRAMES ============================
+void noteFramePresented(uint32_t stamp, Clock::time_point submitted, Clock::time_point swapped) {
+    if (!inputLatencyEnabled) return;
+    if (!queriesMade) {
+        glGenQueries(INPUT_LATENCY_QUERIES, queries);
+        queriesMade = true;
+        calibrate(swapped);
+    }
+    collectQueries();
+    if (swapped - lastCalibration > std::chrono::milliseconds(INPUT_LATENCY_CALIBRATE_MS)) calibrate(swapped);
+
+    if (stamp != lastPresented && stamp - lastPresented < 0x80000000u) {
+        // Every press since the last frame that showed one (a record overwritten since is lost)
+        const uint32_t first = std::max(lastPresented, stamp > INPUT_LATENCY_RECORDS ? stamp - INPUT_LATENCY_RECORDS : 0u);
+        const int64_t submittedNs = clockNs(submitted), swappedNs = clockNs(swapped);
+        for (uint32_t s = first + 1; s != stamp + 1; ++s) {
+            const PressRecord& record = records[s % INPUT_LATENCY_RECORDS];
+            const int64_t pressedNs = record.pressedNs.load(std::memory_order_relaxed);
+            const int64_t appliedNs = record.appliedNs.load(std::memory_order_relaxed);
+            if (appliedNs != 0) stages[STAGE_TICK].add(appliedNs - pressedNs);
+            stages[STAGE_SUBMIT].add(submittedNs - pressedNs);
+            stages[STAGE_SWAP].add(swappedNs - pressedNs);
+        }
+        if (pendingCount < INPUT_LATENCY_QUERIES) {
+            const int slot = (pendingHead + pendingCount) % INPUT_LATENCY_QUERIES;
+            glQueryCounter(queries[slot], GL_TIMESTAMP); // Behind the swap: reached once the frame is done
+            pending[slot] = { first, stamp };
+            ++pendingCount;
+        }
+        else ++gpuSkipped;
+        lastPresented = stamp;
+    }
+
+    if (profilerPeriodicReport && swapped - lastReport > std::chrono::duration<float>(PROFILE_REPORT_INTERVAL)) reportInputLatency();
+}
+
+void reportInputLatency() {
+    lastReport = Clock::now();
+    if (!inputLatencyEnabled || stages[STAGE_SUBMIT].samples == 0) return;
+    LOG_INFO("---- Input latency (%llu presses since the last report, ms) ----", static_cast<unsigned long long>(stages[STAGE_SUBMIT].samples));
+    LOG_INFO("%-24s%9s%9s%9s%9s%9s", "stage", "samples", "p50", "p90", "p99", "max");
+    for (int s = 0; s < STAGE_COUNT; ++s) {
+        const StageHistogram& histogram = stages[s];
+        LOG_INFO("%-24s%9llu%9.2f%9.2f%9.2f%9.2f", stageNames[s], static_cast<unsigned long long>(histogram.samples),
+                 percentileMs(histogram, 0.5), percentileMs(histogram, 0.9), percentileMs(histogram, 0.99), histogram.maxNs / 1e6);
+    }
+    // The whole press-to-GPU distribution, one row per bucket that has any
+    const StageHistogram& gpu = stages[STAGE_GPU];
+    uint32_t largest = 0;
+    for (int b = 0; b < INPUT_LATENCY_BUCKETS; ++b) largest = std::max(largest, gpu.counts[b]);
+    for (int b = 0; b < INPUT_LATENCY_BUCKETS; ++b) {
+        if (gpu.counts[b] == 0) continue;
+        char bar[41];
+        const int length = static_cast<int>(40ull * gpu.counts[b] / largest);
+        std::fill(bar, bar + length, '#');
+        bar[length] = '\0';
+        LOG_INFO("  <= %7.2f ms %6u %s", bucketEdgeMs(b), gpu.counts[b], bar);
+    }
+    if (gpuSkipped > 0) LOG_INFO("  %llu frames showed a press with every timestamp query in flight (no GPU sample)",
+                                 static_cast<unsigned long long>(gpuSkipped));
+    for (StageHistogram& histogram : stages) histogram = StageHistogram();
+    gpuSkipped = 0;
+}
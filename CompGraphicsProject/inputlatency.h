@@ -0,0 +1,35 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+// ============================ INPUT LATENCY ============================
+// --latency: follows every game key press from the key callback to the screen, so frame pacing can
+// be tuned by numbers instead of by feel. A press is stamped when it is queued (pushInputEvent), its
+// record noting when the key callback saw it; the tick that applies it notes when it ran, and the
+// snapshots published after that tick carry the newest stamp applied. The first frame drawn from such
+// a snapshot notes, for every press it is the first to show, when its commands were submitted and
+// when the swap returned, and puts a GL timestamp query (GL_ARB_timer_query, core in 3.3) right
+// behind the swap; read back a few frames later without waiting, and moved onto the CPU clock by a
+// calibration of GL_TIMESTAMP against it, that is when the GPU had finished the frame, the nearest
+// to the photons GL can see (the display's scan-out is not counted).
+// Each stage goes into a histogram (4 buckets per doubling of microseconds), reported as percentiles
+// next to the frame profile (P, --profile) and once at exit, with the press-to-GPU stage in full.
+// Off, a press costs nothing more than before.
+const int INPUT_LATENCY_RECORDS = 256; // Presses in flight (far more than a few frames ever hold)
+const int INPUT_LATENCY_QUERIES = 8; // Timestamp queries in flight, one per frame that showed a press
+const int INPUT_LATENCY_BUCKETS = 64;
+const int INPUT_LATENCY_CALIBRATE_MS = 1000; // Between GPU-to-CPU clock calibrations
+
+extern bool inputLatencyEnabled;
+
+// The producer (the thread that polls GLFW): a stamp for a press seen at `pressed` (0 when off)
+uint32_t stampKeyPress(std::chrono::steady_clock::time_point pressed);
+// The consumer (the thread that ticks): the press `stamp` was applied by the tick running now
+void noteKeyPressApplied(uint32_t stamp);
+uint32_t appliedKeyPress(); // The newest stamp applied so far, for the snapshot (the consumer)
+// The render thread, after the swap of a frame drawn from a snapshot carrying `stamp`, whose commands
+// were all submitted at `submitted`; also reads back the finished timestamp queries
+void noteFramePresented(uint32_t stamp, std::chrono::steady_clock::time_point submitted, std::chrono::steady_clock::time_point swapped);
+// The render thread: each stage's percentiles since the last report, then the press-to-GPU histogram
+void reportInputLatency();
@@ -0,0 +1,55 @@
+#include "instanceformat.h"
+
+#include <cmath>
+
+#include <glad/glad.h>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/packing.hpp>
+
+// ============================ PACKING ============================
+void packInstances(const ObjectInstance* instances, size_t count, CompactInstance* out) {
+    const float toUnit = 1.0f / INSTANCE_POSITION_RANGE;
+    for (size_t i = 0; i < count; ++i) {
+        const ObjectInstance& in = instances[i];
+        const uint32_t folded = (in.shape ^ (in.shape >> 16)) & 0xFFFFu;
+        out[i] = {
+            { static_cast<int16_t>(glm::packSnorm1x16(in.position.x * toUnit)),
+              static_cast<int16_t>(glm::packSnorm1x16(in.position.y * toUnit)) },
+            glm::packHalf1x16(std::remainder(in.rotation, glm::two_pi<float>())),
+            glm::packHalf1x16(in.scale),
+            static_cast<uint16_t>(in.paint),
+            static_cast<uint16_t>(folded != 0 || in.shape == 0 ? folded : 1)
+        };
+    }
+}
+
+// ============================ VERTEX FORMAT ============================
+void instanceAttributePointers(bool compact, size_t base) {
+    if (compact) {
+        const GLsizei stride = sizeof(CompactInstance);
+        glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, stride, (void*)(base + offsetof(CompactInstance, position)));
+        glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(CompactInstance, rotation)));
+        glVertexAttribIPointer(3, 1, GL_UNSIGNED_SHORT, stride, (void*)(base + offsetof(CompactInstance, paint)));
+        glVertexAttribIPointer(4, 1, GL_UNSIGNED_SHORT, stride, (void*)(base + offsetof(CompactInstance, shape)));
+        return;
+    }
+    const GLsizei stride = sizeof(ObjectInstance);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(ObjectInstance, position)));
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(ObjectInstance, rotation)));
+    glVertexAttribIPointer(3, 1, GL_UNSIGNED_INT, stride, (void*)(base + offsetof(ObjectInstance, paint)));
+    glVertexAttribIPointer(4, 1, GL_UNSIGNED_INT, stride, (void*)(base + offsetof(ObjectInstance, shape)));
+}
+
+void instanceAttributeFormats(unsigned int vao, bool compact) {
+    if (compact) {
+        glVertexArrayAttribFormat(vao, 1, 2, GL_SHORT, GL_TRUE, offsetof(CompactInstance, position));
+        glVertexArrayAttribFormat(vao, 2, 2, GL_HALF_FLOAT, GL_FALSE, offsetof(CompactInstance, rotation));
+        glVertexArrayAttribIFormat(vao, 3, 1, GL_UNSIGNED_SHORT, offsetof(CompactInstance, paint));
+        glVertexArrayAttribIFormat(vao, 4, 1, GL_UNSIGNED_SHORT, offsetof(CompactInstance, shape));
+        return;
+    }
+    glVertexArrayAttribFormat(vao, 1, 2, GL_FLOAT, GL_FALSE, offsetof(ObjectInstance, position));
+    glVertexArrayAttribFormat(vao, 2, 2, GL_FLOAT, GL_FALSE, offsetof(ObjectInstance, rotation));
+    glVertexArrayAttribIFormat(vao, 3, 1, GL_UNSIGNED_INT, offsetof(ObjectInstance, paint));
+    glVertexArrayAttribIFormat(vao, 4, 1, GL_UNSIGNED_INT, offsetof(ObjectInstance, shape));
+}
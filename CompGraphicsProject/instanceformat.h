@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+// ============================ INSTANCE RECORDS ============================
+// Per-instance record streamed for the batched objects (attributes 1-4 of meshVAO). The paint is a
+// palette entry and shade (frameconstants.h) the shaders turn into the color: fills and outlines of
+// the same rock are separate instances.
+struct ObjectInstance {
+    glm::vec2 position;
+    float rotation;
+    float scale;
+    uint32_t paint;
+    uint32_t shape; // Circle fans: procedural silhouette seed, 0 draws the mesh as it is (left 0 by brace-init);
+                    // SDF quads: the shape's layer in asteroidSdfTexture
+};
+
+// The same record in half the bytes, packed from an ObjectInstance as it goes into the stream buffer.
+// The vertex fetch unpacks the attributes (normalized shorts, half floats, 16-bit integers); the
+// shaders only scale the position back by the frame constants' instancePositionScale.
+//   position  int16 x 2, normalized over +-INSTANCE_POSITION_RANGE: steps of 1.2e-4, a twentieth of a
+//             pixel in a 800-pixel window, and room for ghosts and rocks half off the view
+//   rotation  half float, wrapped to [-pi, pi] first (steps of 0.002 radians at the ends)
+//   scale     half float
+//   paint     uint16 (the palette byte and the shade above it)
+//   shape     uint16: the SDF layer, or the procedural seed folded to 16 bits (still never 0)
+struct CompactInstance {
+    int16_t position[2];
+    uint16_t rotation;
+    uint16_t scale;
+    uint16_t paint;
+    uint16_t shape;
+};
+static_assert(sizeof(CompactInstance) == 12, "A compact instance is three 32-bit words");
+const float INSTANCE_POSITION_RANGE = 4.0f;
+
+inline size_t instanceRecordSize(bool compact) {
+    return compact ? sizeof(CompactInstance) : sizeof(ObjectInstance);
+}
+
+void packInstances(const ObjectInstance* instances, size_t count, CompactInstance* out);
+
+// Attributes 1-4 (position, rotation and scale, paint, shape) of the bound vertex array from the
+// buffer bound to GL_ARRAY_BUFFER, records of either format starting `base` bytes in
+void instanceAttributePointers(bool compact, size_t base);
+// The same attributes' formats on `vao` (DSA), relative to the binding that holds the records
+void instanceAttributeFormats(unsigned int vao, bool compact);
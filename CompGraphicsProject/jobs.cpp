@@ -0,0 +1,181 @@
+#include "jobs.h"
+#include "log.h"
+#include "profiler.h"
+#include "threadconfig.h"
+
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ============================ QUEUES ============================
+// A fixed ring behind a spinlock (held for a few instructions): the owner works at the back,
+// thieves take from the front. A job whose dependency is not done yet goes back in at the front,
+// so the owner reaches the jobs it is waiting on first.
+struct JobQueue {
+    std::atomic_flag lock; // Clear on construction (C++20)
+    Job jobs[JOB_QUEUE_CAPACITY];
+    size_t front = 0; // Oldest job; front <= back, both taken modulo the capacity
+    size_t back = 0;
+
+    void acquire() { while (lock.test_and_set(std::memory_order_acquire)) {} }
+    void release() { lock.clear(std::memory_order_release); }
+
+    bool pushBack(const Job& job) {
+        acquire();
+        bool room = back - front < static_cast<size_t>(JOB_QUEUE_CAPACITY);
+        if (room) jobs[back++ % JOB_QUEUE_CAPACITY] = job;
+        release();
+        return room;
+    }
+    bool pushFront(const Job& job) {
+        acquire();
+        bool room = back - front < static_cast<size_t>(JOB_QUEUE_CAPACITY);
+        if (room) {
+            front += JOB_QUEUE_CAPACITY - 1; // front - 1 without wrapping below zero
+            back += JOB_QUEUE_CAPACITY;
+            jobs[front % JOB_QUEUE_CAPACITY] = job;
+        }
+        release();
+        return room;
+    }
+    bool popBack(Job& job) {
+        acquire();
+        bool found = back != front;
+        if (found) job = jobs[--back % JOB_QUEUE_CAPACITY];
+        release();
+        return found;
+    }
+    bool popFront(Job& job) {
+        acquire();
+        bool found = back != front;
+        if (found) job = jobs[front++ % JOB_QUEUE_CAPACITY];
+        release();
+        return found;
+    }
+};
+
+// ============================ JOB SYSTEM STATE ============================
+static std::unique_ptr<JobQueue[]> queues; // 0: shared by every thread that is not a worker; 1..N: the workers
+static int queueCount = 0;
+static std::vector<std::thread> workers;
+static std::atomic<bool> jobsRunning(false);
+static std::atomic<int> queuedJobs(0); // Jobs sitting in any queue; idle workers sleep while it is zero
+static std::mutex sleepMutex;
+static std::condition_variable wakeSignal;
+static thread_local int ownQueue = 0;
+
+static void runJob(const Job& job) {
+    if (traceActive()) {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        job.function(job.context, job.begin, job.end);
+        traceSpan(job.phase >= 0 ? profilerPhaseName(static_cast<ProfilePhase>(job.phase)) : "job", "job",
+                  start, std::chrono::steady_clock::now(), job.begin, job.end);
+    }
+    else job.function(job.context, job.begin, job.end);
+    if (job.counter) job.counter->pending.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+// Takes a job: the newest of the thread's own queue, else the oldest of the next non-empty one
+static bool takeJob(Job& job) {
+    if (queues[ownQueue].popBack(job)) return true;
+    for (int k = 1; k < queueCount; ++k) {
+        if (queues[(ownQueue + k) % queueCount].popFront(job)) return true;
+    }
+    return false;
+}
+
+// Runs one ready job; false if there was none (or only jobs still waiting on a dependency)
+static bool runOneJob() {
+    Job job;
+    if (!takeJob(job)) return false;
+    if (job.dependency && !job.dependency->done()) {
+        if (!queues[ownQueue].pushFront(job)) {
+            while (!job.dependency->done()) std::this_thread::yield(); // Nowhere to park it: wait it out
+            queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+            runJob(job);
+            return true;
+        }
+        return false;
+    }
+    queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+    runJob(job);
+    return true;
+}
+
+static void workerLoop(int queue) {
+    ownQueue = queue;
+    char name[32];
+    std::snprintf(name, sizeof(name), "worker %d", queue);
+    nameTraceThread(name);
+    registerThread(THREAD_WORKER, queue);
+    while (jobsRunning.load(std::memory_order_acquire)) {
+        if (runOneJob()) continue;
+        if (queuedJobs.load(std::memory_order_acquire) > 0) {
+            std::this_thread::yield(); // Only deferred jobs left; their dependencies are running elsewhere
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeSignal.wait(lock, [] { return !jobsRunning.load(std::memory_order_acquire) || queuedJobs.load(std::memory_order_acquire) > 0; });
+    }
+}
+
+// ============================ JOB SYSTEM API ============================
+void startJobSystem(int workerCount) {
+    stopJobSystem();
+    if (workerCount < 0) workerCount = static_cast<int>(std::thread::hardware_concurrency()) - 1;
+    workerCount = std::max(workerCount, 0);
+
+    queueCount = workerCount + 1;
+    queues.reset(new JobQueue[queueCount]);
+    queuedJobs.store(0);
+    jobsRunning.store(true, std::memory_order_release);
+    workers.reserve(static_cast<size_t>(workerCount));
+    for (int w = 1; w <= workerCount; ++w) workers.emplace_back(workerLoop, w);
+
+    static bool registered = false;
+    if (!registered) {
+        std::atexit(stopJobSystem);
+        registered = true;
+    }
+    LOG_INFO("Job system: %d worker thread%s%s", workerCount, workerCount == 1 ? "" : "s",
+             workerCount == 0 ? " (every job runs inline)" : "");
+}
+
+void stopJobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        jobsRunning.store(false, std::memory_order_release);
+    }
+    wakeSignal.notify_all();
+    for (std::thread& worker : workers) worker.join();
+    workers.clear();
+}
+
+int jobWorkerCount() {
+    return static_cast<int>(workers.size());
+}
+
+void submitJob(const Job& submitted) {
+    Job job = submitted;
+    job.phase = threadAllocationPhase;
+    if (workers.empty() || !queues[ownQueue].pushBack(job)) {
+        if (job.dependency) waitForJobs(*job.dependency); // Already done in the serial fallback
+        runJob(job); // Serial fallback, or the queue is full
+        return;
+    }
+    queuedJobs.fetch_add(1, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex); // So a worker about to sleep cannot miss the wake-up
+    }
+    wakeSignal.notify_one();
+}
+
+void waitForJobs(JobCounter& counter) {
+    while (!counter.done()) {
+        if (!runOneJob()) std::this_thread::yield();
+    }
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+
+// Small work-stealing job system for spreading the simulation's per-entity loops over the cores.
+// Every worker owns a queue: it pushes and pops its own jobs at the back (newest first, still hot
+// in cache) and, when that is empty, steals the oldest job from the front of another queue.
+// Threads that are not workers (main, simulation, callers of the batch API) share one extra queue
+// and run jobs themselves while they wait. With no workers every job runs on the submitting thread
+// the moment it is submitted, in program order: the single-thread reference for determinism checks.
+
+// ============================ JOBS ============================
+typedef void (*JobFunction)(void* context, size_t begin, size_t end);
+
+// Counts unfinished jobs. A job may also name one as its dependency: it is not started before
+// that counter is done.
+struct JobCounter {
+    std::atomic<int> pending{ 0 };
+    bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+};
+
+struct Job {
+    JobFunction function = nullptr;
+    void* context = nullptr;
+    size_t begin = 0, end = 0;
+    JobCounter* counter = nullptr;    // Decremented once the job has run
+    JobCounter* dependency = nullptr; // Must be done before the job starts (null: none)
+    int phase = -1; // Profile phase it was submitted from (submitJob fills it in; names its trace span)
+};
+
+const int JOB_QUEUE_CAPACITY = 1024; // Per queue; a job pushed to a full queue runs at once instead
+
+// ============================ JOB SYSTEM API ============================
+// Starts `workerCount` worker threads (-1: one per hardware thread but the caller's; 0: none, every
+// job runs inline). The workers are stopped at exit, or earlier by stopJobSystem.
+void startJobSystem(int workerCount);
+void stopJobSystem(); // Joins the workers (safe to call twice); jobs then run inline again
+int jobWorkerCount();
+
+void submitJob(const Job& job); // job.counter must already count it
+void waitForJobs(JobCounter& counter); // Runs queued jobs until counter is done
+
+// Submits [begin, end) as jobs of up to `grain` indices each, calling fn(chunkBegin, chunkEnd), and
+// returns without waiting; `counter` is done once every chunk has run. fn must outlive the jobs.
+// A range that fits in one chunk runs inline if its dependency is already done.
+template <typename Fn>
+void parallelForAsync(size_t begin, size_t end, size_t grain, Fn& fn, JobCounter& counter, JobCounter* dependency = nullptr) {
+    grain = std::max<size_t>(grain, 1);
+    if (end - begin <= grain && (!dependency || dependency->done())) {
+        if (begin < end) fn(begin, end);
+        return;
+    }
+    for (size_t chunk = begin; chunk < end; chunk += grain) {
+        Job job;
+        job.function = [](void* context, size_t b, size_t e) { (*static_cast<Fn*>(context))(b, e); };
+        job.context = &fn;
+        job.begin = chunk;
+        job.end = std::min(end, chunk + grain);
+        job.counter = &counter;
+        job.dependency = dependency;
+        counter.pending.fetch_add(1, std::memory_order_relaxed);
+        submitJob(job);
+    }
+}
+
+// Same, but returns once every chunk has run (the caller runs chunks too)
+template <typename Fn>
+void parallelFor(size_t begin, size_t end, size_t grain, Fn&& fn) {
+    JobCounter counter;
+    parallelForAsync(begin, end, grain, fn, counter);
+    waitForJobs(counter);
+}
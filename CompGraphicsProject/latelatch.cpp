@@ -0,0 +1,103 @@
+#include "latelatch.h"
+#include "gldebug.h"
+#include "glstate.h"
+#include "streambuffer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <glad/glad.h>
+#include <glm/gtc/constants.hpp>
+
+bool useLateLatch = false;
+
+static unsigned int latchUBO;
+static unsigned char* latchData = nullptr; // Persistent mapping of every slot (GL 4.4 only)
+static size_t slotStride = 0; // sizeof(ShipLatch) rounded up to the uniform buffer offset alignment
+
+// ============================ SETUP ============================
+void setupLateLatch()
+{
+    GLint alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    slotStride = (sizeof(ShipLatch) + alignment - 1) / alignment * alignment;
+    const GLsizeiptr totalSize = static_cast<GLsizeiptr>(slotStride * STREAM_BUFFER_FRAMES);
+
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    if (useDirectStateAccess) {
+        glCreateBuffers(1, &latchUBO);
+        glNamedBufferStorage(latchUBO, totalSize, NULL, flags);
+        latchData = static_cast<unsigned char*>(glMapNamedBufferRange(latchUBO, 0, totalSize, flags));
+    }
+    else {
+        glGenBuffers(1, &latchUBO);
+        glBindBuffer(GL_UNIFORM_BUFFER, latchUBO);
+        if (GLAD_GL_VERSION_4_4 && glBufferStorage) {
+            glBufferStorage(GL_UNIFORM_BUFFER, totalSize, NULL, flags);
+            latchData = static_cast<unsigned char*>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, totalSize, flags));
+        }
+        else {
+            glBufferData(GL_UNIFORM_BUFFER, totalSize, NULL, GL_STREAM_DRAW);
+            latchData = nullptr; // Each latch is a glBufferSubData of its slot instead
+        }
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+    labelGlObject(GL_BUFFER, latchUBO, "ship latch");
+}
+
+void destroyLateLatch()
+{
+    if (latchData && useDirectStateAccess) glUnmapNamedBuffer(latchUBO);
+    else if (latchData) {
+        glBindBuffer(GL_UNIFORM_BUFFER, latchUBO);
+        glUnmapBuffer(GL_UNIFORM_BUFFER);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+    latchData = nullptr;
+    glDeleteBuffers(1, &latchUBO);
+    latchUBO = 0;
+}
+
+void bindShipLatch(unsigned int program)
+{
+    if (!program) return; // Failed build
+    const unsigned int block = glGetUniformBlockIndex(program, "ShipLatch");
+    if (block != GL_INVALID_INDEX) glUniformBlockBinding(program, block, SHIP_LATCH_BINDING);
+}
+
+// ============================ EXTRAPOLATION ============================
+Ship extrapolateShip(const Ship& newest, const InputState& held, float lead)
+{
+    Ship ship = newest;
+    if (held.left) ship.rotation += ROTATION_SPEED * lead;
+    if (held.right) ship.rotation -= ROTATION_SPEED * lead;
+    if (held.thrust) {
+        const float heading = ship.rotation + glm::half_pi<float>(); // The model points up (+Y)
+        ship.velocity += glm::vec2(std::cos(heading), std::sin(heading)) * (THRUST_SPEED * lead);
+    }
+    // moveShips' friction once per tick of lead, and the matching fraction of it between ticks
+    ship.velocity *= std::pow(FRICTION_PER_TICK, lead / SIM_DT);
+    ship.position += ship.velocity * lead;
+    for (float* axis : { &ship.position.x, &ship.position.y }) {
+        if (*axis > 1.0f) *axis -= FIELD_WIDTH;
+        else if (*axis < -1.0f) *axis += FIELD_WIDTH;
+    }
+    return ship;
+}
+
+// ============================ LATCH ============================
+void latchShipPose(const Ship& pose, int slot)
+{
+    const ShipLatch latch = { glm::vec4(pose.position, pose.rotation, pose.scale) };
+    const size_t offset = static_cast<size_t>(slot) * slotStride;
+    // The slot was last read by the frame that used this stream segment, which beginFrame waited for
+    if (latchData) std::memcpy(latchData + offset, &latch, sizeof(latch));
+    else if (useDirectStateAccess) glNamedBufferSubData(latchUBO, static_cast<GLintptr>(offset), sizeof(latch), &latch);
+    else {
+        glBindBuffer(GL_UNIFORM_BUFFER, latchUBO);
+        glBufferSubData(GL_UNIFORM_BUFFER, static_cast<GLintptr>(offset), sizeof(latch), &latch);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+    glBindBufferRange(GL_UNIFORM_BUFFER, SHIP_LATCH_BINDING, latchUBO, static_cast<GLintptr>(offset), sizeof(latch));
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "simulation.h"
+
+// Late-latched ship (--late-latch): the snapshot a frame draws is a tick or more old by the time the
+// ship goes out, and interpolating between its last two ticks shows the ship later still. Right
+// before the player's ship is drawn, the render thread takes the keys held now (the input producer's
+// view, ahead of every tick) and extrapolates the ship from the snapshot's newest tick to the
+// present: the turn and thrust those keys give over the time since that tick was due, at most
+// LATE_LATCH_MAX_LEAD. The pose goes into a small uniform buffer, persistently mapped where GL 4.4
+// allows, one slot per frame in flight (the stream buffer's frame fences cover their reuse), and
+// the ship's hull and outline read it in their vertex shader. Nothing goes back to the simulation,
+// which stays authoritative: the next snapshot replaces the guess. The shield, the exhaust and the
+// bloom's glow stay at the interpolated pose.
+const unsigned int SHIP_LATCH_BINDING = 2;
+const float LATE_LATCH_MAX_LEAD = 2.0f * SIM_DT; // A stalled simulation is not extrapolated further
+
+// Mirrors the GLSL block below (std140: one vec4)
+struct ShipLatch {
+    glm::vec4 pose; // x, y, rotation, scale
+};
+static_assert(sizeof(ShipLatch) == 16, "ShipLatch must match the std140 block");
+
+// Paste into a vertex shader source after the #version line
+#define SHIP_LATCH_GLSL \
+    "layout (std140) uniform ShipLatch {\n" \
+    "    vec4 shipPose;\n" \
+    "};\n"
+
+extern bool useLateLatch;
+
+// ============================ LATE LATCH API ============================
+void setupLateLatch();
+void destroyLateLatch();
+void bindShipLatch(unsigned int program); // Points the program's ShipLatch block at SHIP_LATCH_BINDING
+
+// `newest` (a snapshot's ship at its last tick) moved on by `lead` seconds under `held`, as steerShip
+// and moveShips would move it: turned, then thrust along the new heading, then slowed by the friction
+// of the ticks the lead spans, then moved and wrapped
+Ship extrapolateShip(const Ship& newest, const InputState& held, float lead);
+// Writes the pose into frame slot `slot` (0 .. STREAM_BUFFER_FRAMES - 1, the frame's stream segment)
+// and binds that slot for the draws that follow
+void latchShipPose(const Ship& pose, int slot);
@@ -0,0 +1,58 @@
+#include "loadshed.h"
+#include "simulation.h"
+#include "profiler.h"
+#include "log.h"
+
+#include <algorithm>
+#include <atomic>
+
+float shedBudgetMs = 0.0f;
+
+static std::atomic<size_t> spawnCap(0); // 0: no cap
+static int framesSinceDecision = 0;
+static size_t lowestCap = 0;
+
+// Average cost of the latest SHED_WINDOW_FRAMES profiler frames: each the larger of the frame's
+// time and its simulation phases' sum
+static float windowCost() {
+    float frame[SHED_WINDOW_FRAMES], phase[SHED_WINDOW_FRAMES], simulation[SHED_WINDOW_FRAMES] = {};
+    const int frames = profilerPhaseHistory(PHASE_FRAME, frame, SHED_WINDOW_FRAMES);
+    for (int p = PHASE_SPAWN; p <= PHASE_BULLET_COLLISION; ++p) {
+        const int count = profilerPhaseHistory(static_cast<ProfilePhase>(p), phase, SHED_WINDOW_FRAMES);
+        for (int i = 0; i < std::min(count, frames); ++i) simulation[i] += phase[i];
+    }
+    float total = 0.0f;
+    for (int i = 0; i < frames; ++i) total += std::max(frame[i], simulation[i]);
+    return frames > 0 ? total / frames : 0.0f;
+}
+
+void updateLoadShedding(size_t maxAsteroids, size_t liveAsteroids) {
+    if (shedBudgetMs <= 0.0f || ++framesSinceDecision < SHED_WINDOW_FRAMES) return;
+    framesSinceDecision = 0;
+    const float cost = windowCost();
+    const size_t previous = spawnCap.load(std::memory_order_relaxed);
+    size_t cap = previous;
+    if (cost > shedBudgetMs) {
+        const size_t onField = previous > 0 ? std::min(previous, liveAsteroids) : liveAsteroids;
+        cap = std::max(SHED_MIN_ROCKS, onField * 3 / 4);
+    }
+    else if (previous > 0 && cost < shedBudgetMs * SHED_RECOVER_FRACTION) {
+        cap = previous + previous / 4 + 1;
+        if (cap >= maxAsteroids) cap = 0;
+    }
+    if (cap == previous) return;
+    spawnCap.store(cap, std::memory_order_relaxed);
+    if (cap > 0 && (lowestCap == 0 || cap < lowestCap)) lowestCap = cap;
+    if (cap > 0) LOG_INFO("Load shedding: at most %zu rocks (%.2f ms per frame, budget %.2f ms)", cap, cost, shedBudgetMs);
+    else LOG_INFO("Load shedding: lifted (%.2f ms per frame, budget %.2f ms)", cost, shedBudgetMs);
+}
+
+void applyLoadShedding(GameWorld& target) {
+    target.spawnCap = spawnCap.load(std::memory_order_relaxed);
+}
+
+void reportLoadShedding(const GameWorld& source) {
+    if (shedBudgetMs <= 0.0f) return;
+    LOG_INFO("Load shedding: %llu spawns and %llu split children shed (lowest cap %zu rocks, budget %.2f ms)",
+             static_cast<unsigned long long>(source.shedSpawns), static_cast<unsigned long long>(source.shedChildren), lowestCap, shedBudgetMs);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+
+struct GameWorld;
+
+// Load shedding (--shed-budget MS): on a machine or in a stress config that cannot keep up, new rocks
+// are turned away before the frame rate goes. Once a second the governor averages the profiler's
+// latest frames, each costed as the larger of its frame time and its simulation phases (so it sees
+// the cost with and without the simulation thread, and headless, where a profiler frame is a tick).
+// Over the budget it lowers a cap on live rocks to three quarters of what is on the field; well under
+// it (70%), it raises the cap a quarter at a time until it is past the asteroid limit and lifted.
+// The world checks spawns and split children against the cap (GameWorld::spawnCap) and counts what
+// it sheds; the spawn timer's ramp and the wave script carry on regardless, so difficulty keeps its
+// curve and only the crowd thins. Rocks already on the field are never taken away.
+// The cap is set from outside the world, so it is not in recordings: no shedding with --record,
+// --replay or rollback. Nothing here depends on GL.
+
+// ============================ LOAD SHEDDING CONSTANTS ============================
+extern float shedBudgetMs; // Milliseconds a frame may cost (0: off)
+const int SHED_WINDOW_FRAMES = 60; // Profiler frames averaged per decision, and between decisions
+const size_t SHED_MIN_ROCKS = 4; // The cap never goes below this
+const float SHED_RECOVER_FRACTION = 0.7f; // Of the budget, under which the cap is raised
+
+// ============================ LOAD SHEDDING API ============================
+// After each profilerEndFrame, on the thread that closes frames: every SHED_WINDOW_FRAMES, moves the
+// cap for a world limited to `maxAsteroids` that has `liveAsteroids` on the field
+void updateLoadShedding(size_t maxAsteroids, size_t liveAsteroids);
+// Before each tick, on the thread that steps `target`: hands it the current cap
+void applyLoadShedding(GameWorld& target);
+// Logs what `source` shed since its reset, and the lowest cap it ran under
+void reportLoadShedding(const GameWorld& source);
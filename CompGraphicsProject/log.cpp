@@ -0,0 +1,129 @@
+#include "log.h"
+#include "threadconfig.h"
+
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <cstdio>
+#include <cstdarg>
+#include <cstdlib>
+#include <cstddef>
+
+// ============================ QUEUE ============================
+// Bounded multi-producer ring (Vyukov): each slot's sequence number says whether it is free for
+// the producer at that position or holds a message for the consumer. Producers claim a position
+// with a CAS on the head; the single writer thread owns the tail.
+struct LogSlot {
+    std::atomic<size_t> sequence;
+    LogLevel level;
+    char text[LOG_MESSAGE_SIZE];
+};
+
+static LogSlot slots[LOG_QUEUE_CAPACITY];
+static std::atomic<size_t> head(0);
+static size_t tail = 0;
+static std::atomic<unsigned int> droppedMessages(0);
+static std::atomic<unsigned int> pendingMessages(0); // Wakes the writer (C++20 atomic wait)
+
+static std::thread writerThread;
+static std::atomic<bool> running(false);      // Keeps the writer loop alive
+static std::atomic<bool> writerActive(false); // Producers hand messages to the writer while set
+
+static const char* levelPrefix(LogLevel level) {
+    switch (level) {
+    case LOG_LEVEL_WARN: return "[warn] ";
+    case LOG_LEVEL_ERROR: return "[error] ";
+    default: return ""; // Debug and info keep the console output unchanged
+    }
+}
+
+static bool tryClaim(size_t& position) {
+    position = head.load(std::memory_order_relaxed);
+    for (;;) {
+        LogSlot& slot = slots[position & (LOG_QUEUE_CAPACITY - 1)];
+        size_t sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence == position) {
+            if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) return true;
+        }
+        else if (sequence < position) {
+            return false; // Full: the writer has not released this slot yet
+        }
+        else {
+            position = head.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+// Writes every queued message with one flush; returns how many were written
+static int drain() {
+    int written = 0;
+    for (;;) {
+        LogSlot& slot = slots[tail & (LOG_QUEUE_CAPACITY - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != tail + 1) break;
+        std::fputs(levelPrefix(slot.level), stdout);
+        std::fputs(slot.text, stdout);
+        std::fputc('\n', stdout);
+        slot.sequence.store(tail + LOG_QUEUE_CAPACITY, std::memory_order_release);
+        ++tail;
+        ++written;
+    }
+    unsigned int dropped = droppedMessages.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0) std::fprintf(stdout, "[warn] log queue full, %u messages dropped\n", dropped);
+    if (written > 0 || dropped > 0) std::fflush(stdout);
+    return written;
+}
+
+static void writerLoop() {
+    registerThread(THREAD_LOGGER);
+    while (running.load(std::memory_order_acquire)) {
+        unsigned int seen = pendingMessages.load(std::memory_order_acquire);
+        drain();
+        pendingMessages.wait(seen, std::memory_order_acquire);
+    }
+    drain();
+}
+
+// ============================ API ============================
+void startLogger() {
+    static bool initialized = false;
+    if (!initialized) {
+        for (size_t i = 0; i < static_cast<size_t>(LOG_QUEUE_CAPACITY); ++i) slots[i].sequence.store(i, std::memory_order_relaxed);
+        initialized = true;
+        std::atexit(stopLogger);
+    }
+    if (running.exchange(true)) return;
+    writerActive.store(true, std::memory_order_release);
+    writerThread = std::thread(writerLoop);
+}
+
+void stopLogger() {
+    if (!running.exchange(false)) return;
+    pendingMessages.fetch_add(1, std::memory_order_release);
+    pendingMessages.notify_one();
+    writerThread.join();
+    writerActive.store(false, std::memory_order_release);
+    drain(); // Anything queued after the writer's final pass
+}
+
+void logMessage(LogLevel level, const char* format, ...) {
+    size_t position;
+    if (!tryClaim(position)) {
+        droppedMessages.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    LogSlot& slot = slots[position & (LOG_QUEUE_CAPACITY - 1)];
+    slot.level = level;
+    va_list args;
+    va_start(args, format);
+    std::vsnprintf(slot.text, sizeof(slot.text), format, args);
+    va_end(args);
+    slot.sequence.store(position + 1, std::memory_order_release);
+
+    if (writerActive.load(std::memory_order_acquire)) {
+        pendingMessages.fetch_add(1, std::memory_order_release);
+        pendingMessages.notify_one();
+    }
+    else {
+        drain(); // No writer thread (before startLogger or after stopLogger): write in place
+    }
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+// ============================ ASYNC LOGGER ============================
+// printf-style messages are formatted into fixed-size slots of a bounded lock-free ring and
+// written to stdout by a background thread, so gameplay events never block the caller on a
+// console flush. Nothing allocates after startup. When the ring is full a message is dropped
+// and counted; the count is reported with the next written batch.
+
+enum LogLevel { LOG_LEVEL_DEBUG = 0, LOG_LEVEL_INFO = 1, LOG_LEVEL_WARN = 2, LOG_LEVEL_ERROR = 3 };
+
+// Compile-time filter: calls below this level compile to nothing (e.g. /DLOG_MIN_LEVEL=2)
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+const int LOG_QUEUE_CAPACITY = 256; // Slots; must be a power of two
+const int LOG_MESSAGE_SIZE = 1024;  // Bytes per slot, longer messages are truncated
+
+void startLogger(); // Spawns the writer thread; registered with atexit to drain and join on exit
+void stopLogger();  // Writes everything still queued and joins the writer (safe to call twice)
+void logMessage(LogLevel level, const char* format, ...);
+
+#define LOG_AT(level, ...) do { if constexpr ((level) >= LOG_MIN_LEVEL) logMessage((level), __VA_ARGS__); } while (0)
+#define LOG_DEBUG(...) LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define LOG_INFO(...) LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_WARN(...) LOG_AT(LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
@@ -1,9 +1,11 @@
-#include <iostream>
 #include <cmath>
 #include <vector>
 #include <cstdlib>
 #include <ctime>
 #include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <limits>
 #include <stddef.h> 
 
 
@@ -14,153 +16,463 @@
 
 // GLM includes for vector math and transformations
 #include <glm/glm.hpp>
-#include <glm/gtc/matrix_transform.hpp>
-#include <glm/gtc/type_ptr.hpp>
 #include <glm/gtc/constants.hpp> 
 
+#include "simulation.h"
+#include "profiler.h"
+#include "trace.h"
+#include "telemetry.h"
+#include "streambuffer.h"
+#include "instanceformat.h"
+#include "deletionqueue.h"
+#include "framearena.h"
+#include "memreport.h"
+#include "glstate.h"
+#include "gldebug.h"
+#include "quality.h"
+#include "capture.h"
+#include "batchrender.h"
+#include "softrender.h"
+#include "latelatch.h"
+#include "renderqueue.h"
+#include "swarm.h"
+#include "residentbullets.h"
+#include "residentrocks.h"
+#include "particles.h"
+#include "exhaust.h"
+#include "trails.h"
+#include "audio.h"
+#include "bots.h"
+#include "waves.h"
+#include "loadshed.h"
+#include "shapestream.h"
+#include "polarshapes.h"
+#include "gpuraster.h"
+#include "shieldring.h"
+#include "hud.h"
+#include "broadphaseview.h"
+#include "raster.h"
+#include "shaders.h"
+#include "assetcache.h"
+#include "assetloader.h"
+#include "uploadbench.h"
+#include "log.h"
+#include "simthread.h"
+#include "arena.h"
+#include "renderthread.h"
+#include "random.h"
+#include "replay.h"
+#include "collision.h"
+#include "frameconstants.h"
+#include "framepacing.h"
+#include "timebase.h"
+#include "scenario.h"
+#include "batchenv.h"
+#include "jobs.h"
+#include "threadconfig.h"
+#include "entitymemory.h"
+#include "botchannel.h"
+#include "spectator.h"
+#include "gpumemory.h"
+#include "inputlatency.h"
+#include "rendergraph.h"
+
 // ============================ SETTINGS ============================
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
 
-// ============================ SHIELD CONSTANTS ============================
-const float SHIELD_RADIUS_FACTOR = 0.18f; // Radius of the shield in normalized coordinates
-const float SHIELD_DURATION = 3.0f; // Shield active time in seconds
-const float SHIELD_COOLDOWN = 5.0f; // Cooldown after shield deactivates
-
-// ============================ ASTEROID SIZE DEFINITIONS ============================
-enum AsteroidSize { SMALL, MEDIUM, LARGE };
-
-// Helper function to get the scale factor based on size
-float getScaleFactor(AsteroidSize size) {
-    switch (size) {
-    case LARGE: return 0.15f;
-    case MEDIUM: return 0.08f;
-    case SMALL: return 0.04f;
-    default: return 0.15f;
-    }
-}
-
-// Helper function to get the radius based on size (used for collision)
-float getRadiusFactor(AsteroidSize size) {
-    // These factors are relative to the internal 1.0f base radius of the generated shape
-    switch (size) {
-    case LARGE: return 0.15f;
-    case MEDIUM: return 0.08f;
-    case SMALL: return 0.04f;
-    default: return 0.15f;
-    }
-}
-
-// ============================ SHIP/GAME STATE STRUCT ============================
-struct Ship {
-    glm::vec2 position = glm::vec2(0.0f, 0.0f);
-    glm::vec2 velocity = glm::vec2(0.0f, 0.0f);
-    float rotation = 0.0f;
-    float scale = getScaleFactor(SMALL); // Ship size is now based on a small scale
-    float radius = getRadiusFactor(SMALL);
-};
-Ship player;
-
-// ============================ PHYSICS CONSTANTS ============================
-const float THRUST_SPEED = 2.5f;
-const float ROTATION_SPEED = 2.0f;
-const float FRICTION = 0.995f;
-
-// ============================ BULLET CONSTANTS ============================
-const float BULLET_SPEED = 2.5f;
-const float FIRE_RATE = 0.2f;
-
-// ============================ SPAWNING CONSTANTS ============================
-const float INITIAL_SPAWN_RATE = 5.0f;
-const float MIN_SPAWN_RATE = 1.0f;
-const int MAX_ASTEROIDS = 20;
-
 // ============================ GLOBAL STATE ============================
-float deltaTime = 0.0f;
-float lastFrame = 0.0f;
-float bulletCooldown = 0.0f;
-bool isGameOver = false;
-bool isThrusting = false;
-float asteroidSpawnTimer = 0.0f;
-float currentSpawnRate = INITIAL_SPAWN_RATE;
-// --- SHIELD STATE ---
-bool shieldActive = false;
-float shieldTimer = 0.0f;
-float shieldCooldownTimer = 0.0f;
+float deltaTime = 0.0f; // Rendered frame time (the simulation always steps by SIM_DT)
+int64_t lastFrameTicks = 0; // clockTicks at the last frame's start (0: no frame yet)
+float simAccumulator = 0.0f;
+RenderSnapshot mainThreadSnapshot; // What the frame draws when the simulation runs on the main thread (--single-thread)
+const int MAX_SIM_TICKS_PER_FRAME = 8; // Drop time instead of spiralling after a long hitch
+bool framebufferResized = false; // Set by the callback; the frame reallocates the raster buffers
+
+// --- IDLE THROTTLING ---
+// Minimized: no frames, simulation paused. Unfocused: simulation paused, redrawn at IDLE_REFRESH_HZ.
+// Game over: the rocks keep drifting, redrawn at IDLE_REFRESH_HZ. Meanwhile the loop blocks in
+// glfwWaitEventsTimeout instead of spinning. Scenario runs are never throttled.
+bool windowIconified = false;
+bool windowFocused = true;
+bool gameOverShown = false; // The last frame drew a finished game
+const double IDLE_REFRESH_HZ = 10.0;
+const double MINIMIZED_POLL_SECONDS = 0.25; // Still wakes up for close requests
+double lastIdleFrame = 0.0;
+
+// --- FRAME HANDOFF ---
+// What recordFrame draws, filled in by the main loop. With --render-thread the main loop only
+// writes it (and anything else recordFrame reads) after waitForRenderFrameRecorded.
+struct FrameInput {
+    const RenderSnapshot* view = nullptr;
+    float alpha = 0.0f; // Interpolation factor between the snapshot's previous and current tick
+    double time = 0.0; // sessionSeconds at the frame start (shaders get it through shaderTime)
+    std::chrono::steady_clock::time_point start;
+};
+FrameInput frameInput;
+std::chrono::steady_clock::time_point presentedFrameStart; // Render side copy of frameInput.start
+size_t presentedAsteroids = 0; // Rocks in the frame being presented (load shedding's view of the field)
+uint32_t presentedInputStamp = 0; // Newest key press the frame being presented shows (inputlatency.h)
+bool presentModeChanged = false; // V was pressed; the frame applies it where the context is current
+bool profilerReportRequested = false; // P was pressed; the frame prints the report
+bool memoryReportRequested = false; // M was pressed; the frame prints the memory report
 
 // ============================ GLOBAL GRAPHICS HANDLES ============================
-unsigned int bulletVAO, bulletVBO;
-unsigned int fireVAO, fireVBO;
 unsigned int gradientVAO, gradientVBO;
-unsigned int shipFillVAO, shipFillVBO;
-unsigned int bresenhamShipVAO, bresenhamShipVBO;
-unsigned int gameOverTextVAO, gameOverTextVBO;
-unsigned int shieldVAO, shieldVBO;
+unsigned int streamPointVAO; // Clip-space point lists written to streamBuffer (bullets)
+unsigned int streamPixelVAO; // GL_SHORT pixel points written to streamBuffer (outline, shield)
+unsigned int meshVAO, meshVBO; // Every static mesh: asteroid shapes, ship fill, thrust fire, bullet point
+unsigned int nebulaFBO, nebulaTexture;
+unsigned int noiseTexture; // Baked tileable fBm (R8, GL_REPEAT)
+unsigned int asteroidSdfTexture; // Signed distance to every atlas shape's outline (R16F array, one layer per shape)
 
 // ============================ GLOBAL SHADER PROGRAMS ============================
-unsigned int backgroundProgram;
+// One background program per quality preset; they differ only in compiled-in defines
+struct BackgroundVariant {
+    unsigned int program;
+    unsigned int passLoc, sourceLoc, hashStarsLoc;
+};
+BackgroundVariant backgroundVariants[QUALITY_LEVEL_COUNT];
 unsigned int shaderProgram;
+unsigned int instancedProgram;
+unsigned int pixelPointProgram; // CPU-rasterized pixels; the vertex shader maps them to clip space
+unsigned int latchedShipProgram; // The player's hull and outline at the late-latched pose (--late-latch only)
+unsigned int sdfProgram; // Asteroids as quads shaded from asteroidSdfTexture
+unsigned int restartProgram; // Batched fans and loops as two indexed draws (see PRIMITIVE RESTART BATCHING)
+unsigned int starProgram; // Star sprites (see STAR SPRITES)
+unsigned int bloomProgram; // Bloom blur and composite (see BLOOM)
+int restartInstanceBaseLoc;
+int restartCompactLoc;
+unsigned int thickLineProgram; // Batched outlines as screen-space quads (see THICK OUTLINES)
+int thickLineWidthLoc;
+int pixelColorLoc;
+int pixelOffsetLoc;
+int latchedShipColorLoc;
 
 // ============================ GLOBAL DATA BUFFERS ============================
-std::vector<float> bresenhamOutputBuffer;
-// --- SHIELD DATA BUFFER ---
-std::vector<float> shieldOutputBuffer;
-
-// ============================ STRUCTS ============================
-struct Asteroid {
-    glm::vec2 position, velocity;
-    float rotation, rotationSpeed;
-    AsteroidSize size;
-    float scale;
-    float radius;
-    glm::vec3 color;
-    unsigned int VAO_Fill = 0, VBO_Fill = 0; // Initialize handles
-    int vertexCount = 0;
+// --- SHIELD OCTANT (rows of the midpoint walk; the outline and shield points go straight to the stream buffer) ---
+std::vector<int> shieldRows;
+std::vector<ShieldRing> shieldRings; // With useShieldRing: this frame's, one per ship with its shield up
+// --- BULLET DATA BUFFER (interpolated positions, streamed every frame) ---
+FrameVector<float> bulletVertexBuffer;
+
+// --- BENCHMARK STATISTICS ---
+long long drawCallCount = 0; // Every draw call issued since startup (scenario results)
+const char* scenarioOutputPath = NULL; // --bench-out; NULL prints the result line
+const char* botChannelName = NULL; // --bot-channel: the headless ship's input comes from an agent process
+
+// Instance records (ObjectInstance, instanceformat.h) built for streamBuffer each frame
+const GLuint INSTANCE_BINDING = 1; // meshVAO's vertex buffer binding for the instance records (DSA path)
+FrameVector<ObjectInstance> objectInstanceBuffer;
+// Palette entries after the rocks' (asteroidPalette's, entries 0 on)
+const uint32_t PAINT_SHIP = ASTEROID_PALETTE_SIZE;
+const uint32_t PAINT_FIRE = ASTEROID_PALETTE_SIZE + 1;
+const uint32_t PAINT_SHIP_GLOW = ASTEROID_PALETTE_SIZE + 2; // The Bresenham outline's color
+const uint32_t PAINT_BULLET = ASTEROID_PALETTE_SIZE + 3;
+static_assert(ASTEROID_PALETTE_SIZE + 4 <= PALETTE_ENTRIES, "The palette block holds every paint");
+// Scratch for the batched pass: one entry per asteroid instance drawn (a rock, or a ghost of one
+// across a screen edge) with its interpolated position and draw group
+struct AsteroidDraw {
+    glm::vec2 position;
+    int rock;
+    int group;
 };
-std::vector<Asteroid> asteroids;
-
-struct Bullet {
-    glm::vec2 position = glm::vec2(0.0f, 0.0f);
-    glm::vec2 velocity = glm::vec2(0.0f, 0.0f);
-    float scale = 0.01f;
-    float radius = 0.01f;
-    float lifetime = 1.0f;
+FrameVector<AsteroidDraw> asteroidDraws;
+
+// Where each static mesh lives in meshVBO (asteroid shapes use asteroidShapes[k] instead)
+struct MeshRange {
+    GLint first;
+    GLsizei count;
+};
+MeshRange shipFillMesh, fireMesh, bulletMesh;
+MeshRange circleFans[ASTEROID_LOD_COUNT]; // Unit-circle fans at every level of detail (procedural and polar silhouettes)
+MeshRange sdfQuadMesh; // Triangle strip covering ASTEROID_SDF_EXTENT around a rock's center
+int streamedShapeBase = 0; // First vertex of the shape stream's spare slots (shapestream.h)
+
+// Matches the layout glMultiDrawArraysIndirect reads
+struct DrawArraysIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint first;
+    GLuint baseInstance;
+};
+FrameVector<DrawArraysIndirectCommand> fanDraws, loopDraws, pointDraws;
+
+// --- OBJECT RENDER MODE ---
+// true: ship body, thrust, asteroids and bullets are instances of meshes in one VAO, submitted
+//       as one draw list per primitive type (glMultiDrawArraysIndirect on GL 4.3+)
+// false: legacy path, one mat4 and color upload + draw call(s) per object (kept for comparison, toggle with I)
+bool useBatchedObjects = true;
+bool useIndirectDraw = false; // GL 4.3: one glMultiDrawArraysIndirect per primitive type, else one draw per group
+
+// --- COMPACT INSTANCES ---
+// true: the instance records go into the stream buffer as CompactInstance (12 bytes: normalized
+//       16-bit position, half-float rotation and scale, 16-bit paint and shape), unpacked by the
+//       vertex fetch, half the upload of the float records
+// false: ObjectInstance as built (24 bytes; toggle with Z, --compact-instances starts with it on)
+bool useCompactInstances = false;
+bool compactInstanceRecords = false; // What this frame streams; set once per frame by useInstanceFormat
+
+// --- PRIMITIVE RESTART BATCHING ---
+// true: the batched pass sends every fan (ship, fire, asteroid fills) in one glDrawElements and every
+//       outline in another, with GL_PRIMITIVE_RESTART between objects. The indices are built per frame
+//       from the same draw lists; the shader fetches each vertex and its instance from buffer
+//       textures. Works on plain GL 3.3, where the multi-draw above is one call per group.
+// false: the draw lists go out as they are (toggle with K)
+bool useRestartBatching = false;
+unsigned int restartVAO; // No attributes; holds the index buffer binding
+unsigned int atlasTexture, instanceTexture; // Buffer texture views of meshVBO and the stream buffer
+unsigned int instanceTextureGeneration = 0; // streamBuffer.generation instanceTexture views (0: none yet)
+bool instanceTextureCompact = false; // Its texel format: R32UI for compact records, else RG32UI
+FrameVector<GLuint> restartIndices;
+
+// --- THICK OUTLINES ---
+// true: the batched pass draws outlines as two triangles per segment, widened to outlineWidthPixels
+//       in the vertex shader, so every driver draws the same width (core profiles may clamp
+//       glLineWidth to 1 or emulate wide lines slowly)
+// false: GL_LINE_LOOP with glLineWidth (toggle with T; --line-width N sets the width in pixels)
+bool useThickOutlines = true;
+float outlineWidthPixels = 2.0f;
+
+// --- INSTANCED SHIPS ---
+// true: the batched pass draws every ship's outline too, as a loop of the hull mesh over the same
+//       ship instances (one draw for the hulls, one for the outlines, one for the plumes, however
+//       many ships), so bots get outlines and nothing is rasterized on the CPU
+// false: the player's outline alone is the Bresenham one, on top (--instanced-ships turns it on)
+bool useInstancedShips = false;
+
+// --- SHIP OUTLINE ATLAS ---
+// The player's Bresenham outline from a table instead of rasterized every frame (--ship-atlas [N]):
+// the outline at shipAtlasRotations rotations is rasterized once per framebuffer size into a static
+// buffer, and the frame draws the run nearest the ship's rotation, moved onto the ship's centre pixel
+// by the pixel point shader. Exact Bresenham lines still, with the rotation snapped to the table and
+// the corners truncated relative to the centre pixel rather than each on its own: the two truncations
+// can part by a pixel on each axis, so the outline strays up to 2 pixels from drawBresenhamShip's.
+bool useShipAtlas = false;
+int shipAtlasRotations = 512;
+const int SHIP_ATLAS_MAX_ROTATIONS = 4096;
+unsigned int shipAtlasVAO, shipAtlasVBO;
+std::vector<uint32_t> shipAtlasFirsts; // Run r is [shipAtlasFirsts[r], shipAtlasFirsts[r + 1])
+FrameVector<DrawArraysIndirectCommand> thickLineDraws;
+GLint maxTextureBufferTexels = 0; // The whole stream buffer must fit in one RGBA32F buffer texture
+
+// --- FRAME TEMPORARIES ---
+// The FrameVectors above come from frameArena and are dropped and reserved again at the top of every
+// recorded frame (beginFrameTemporaries), with the capacities set up next to the other buffers
+struct FrameReservations {
+    size_t objectInstances;
+    size_t asteroidDraws;
+    size_t fanDraws, loopDraws, pointDraws;
+    size_t bulletFloats;
+};
+FrameReservations frameReservations = {};
+ExhaustPool exhaust; // Every ship's plume, drawn by the batched pass (the render queue keeps the fire triangle)
+
+// --- ASTEROID LEVEL OF DETAIL ---
+// Each size class draws the coarsest atlas level whose edges stay under ASTEROID_LOD_EDGE_PIXELS at the
+// current framebuffer size, so small rocks and small windows send fewer vertices (toggle with L;
+// off always draws the finest level)
+bool useAsteroidLod = true;
+
+// --- ASTEROID SILHOUETTES ---
+// SILHOUETTES_ATLAS: the 32 pre-generated shapes from the atlas, and the streamed ones as they arrive
+//                    (shapestream.h)
+// SILHOUETTES_PROCEDURAL: the batched pass draws every rock as a shared unit-circle fan whose boundary
+//                         radii the vertex shader jitters from a per-instance seed (the rock's handle),
+//                         so every rock has its own silhouette and the instances only group by level of detail
+// SILHOUETTES_POLAR: the same shared fans, with each rock's radii read from the byte table of
+//                    polarshapes.h (thousands of shapes, the atlas's own among them)
+// (S cycles through them; the legacy path always uses the rock's own). The render thread settles the
+// mode once a frame into frameSilhouettes, which the batched pass and the frame constants both follow.
+enum AsteroidSilhouettes { SILHOUETTES_ATLAS, SILHOUETTES_PROCEDURAL, SILHOUETTES_POLAR };
+AsteroidSilhouettes asteroidSilhouettes = SILHOUETTES_ATLAS;
+AsteroidSilhouettes frameSilhouettes = SILHOUETTES_ATLAS;
+
+// --- SDF ASTEROIDS ---
+// true: the batched pass draws each rock as one quad whose fragment shader reads the signed distance
+//       to its atlas shape's outline, shading the fill, a 2-pixel outline and an anti-aliased edge in
+//       one pass (no GL_LINE_LOOP, no glLineWidth); takes precedence over procedural and polar silhouettes
+// false: a fan fill and a line loop outline per rock (toggle with F; the legacy path always uses them)
+bool useSdfAsteroids = false;
+const int ASTEROID_SDF_SIZE = 64; // Texels per side of each layer
+const float ASTEROID_SDF_EXTENT = 1.4f; // Half-size of a layer in shape units: the outline's outermost radius plus room for the edge
+
+// --- BACKGROUND RESOLUTION ---
+// 1 draws the nebula at full resolution (original path). 2 or 4 computes it into nebulaTexture at
+// 1/2 or 1/4 of the window and upscales it bilinearly; the stars are always drawn at full resolution.
+// The nebula only drifts (time * 0.02), so it can also be refreshed every Nth frame.
+int backgroundScale = 1; // Cycle 1 -> 2 -> 4 with B
+int backgroundUpdateInterval = 1; // Frames between nebula refreshes (scaled modes only)
+int nebulaWidth = 0, nebulaHeight = 0; // Size nebulaTexture was allocated with
+long long frameIndex = 0;
+long long nebulaFrame = -1; // Frame the low-res nebula was last drawn (-1 forces a refresh)
+
+// --- VARIABLE-RATE SHADING ---
+// The other way to cheapen the nebula, where GL_NV_shading_rate_image is available: drawn at full
+// resolution in one pass, but with the fragment shader run once per 2x2 or 4x4 pixels wherever the
+// picture is only the low-frequency fbm, and once per pixel over the sun core (whose falloff is
+// steep near the centre). A shading rate image (one R8UI texel per tile of the driver's size,
+// indexing a three-entry palette: 1x1, 2x2, 4x4) says which is which, rebuilt when the window or
+// the rate changes. Only for the full-resolution pass with the stars drawn as sprites (per-pixel
+// hash stars would grow into blocks) in a single viewport (the sun sits at each viewport's centre);
+// otherwise the nebula is shaded per pixel as before. --bench-background times it next to the
+// reduced-resolution target.
+int nebulaShadingRate = 1; // 1: per pixel; 2 or 4: coarse outside the sun core (--bg-vrs N)
+const float SHADING_RATE_SUN_RADIUS = 0.35f; // Background-space radius shaded per pixel (the sun is under 9% of its peak beyond)
+bool shadingRateSupported = false; // The extension and its entry points (checked once GL is loaded)
+unsigned int shadingRateImage = 0;
+int shadingRateWidth = 0, shadingRateHeight = 0, shadingRateImageRate = 0; // What shadingRateImage was built for
+int shadingRateTexelWidth = 16, shadingRateTexelHeight = 16; // Pixels per texel, from the driver
+
+// --- SPLIT SCREEN ---
+// 2 or 4 viewports over the one world, for local co-op (see RenderQueue): every pass prepares its
+// instances once and draws them in each viewport. The HUD spans the window; bloom is off.
+int splitScreenViewports = 1;
+
+// --- DYNAMIC RESOLUTION ---
+// With a frame budget (--frame-budget MS, toggle with D) the nebula resolution follows the GPU frame
+// time from the timer queries instead of backgroundScale: one step of 1/16 down when the frame is over
+// 90% of the budget, one step up when it is under 60%, between 1/4 and full resolution. Stars and
+// game objects are always drawn at native resolution.
+bool useDynamicResolution = false;
+float frameBudgetMs = 16.6f;
+const int DYNAMIC_RESOLUTION_STEPS = 16;
+const int DYNAMIC_RESOLUTION_MIN_STEP = 4;
+// Timer results arrive GPU_TIMER_FRAMES late; wait this long after a change so the new size is measured
+const int DYNAMIC_RESOLUTION_SETTLE_FRAMES = 8;
+int dynamicResolutionStep = DYNAMIC_RESOLUTION_STEPS;
+long long dynamicResolutionFrame = 0; // Frame of the last step change
+
+// --- BAKED NEBULA NOISE ---
+// Instead of 5 octaves of analytic hash noise per pixel, sample a tileable fBm texture baked at
+// startup. The lattice of every octave wraps at NOISE_PERIOD, so the texture tiles seamlessly.
+bool useBakedNebula = false; // Toggle with N
+const int NOISE_TEXTURE_SIZE = 512;
+const int NOISE_PERIOD = 8; // Noise-space units covered by one tile (the field spans about 8 x 5)
+
+// --- STAR SPRITES ---
+// The stars are a fixed set of points drawn with one GL_POINTS call after the background, instead of
+// a hash threshold on every pixel of it (which finds nothing on 99.9% of them). Twinkle and drift are
+// worked out per star in the vertex shader. Every STAR_LAYERS-th star is in the same parallax layer;
+// nearer layers drift faster and are drawn larger. The number drawn keeps the preset's density per
+// pixel (1 - starThreshold), up to STAR_SPRITE_COUNT.
+bool useStarSprites = true; // Toggle with O (off: the background shader's per-pixel hash)
+const int STAR_SPRITE_COUNT = 16384; // About 0.2% of a 4K window, the ultra density
+const int STAR_LAYERS = 3; // Also in starVertexShaderSource
+unsigned int starVAO, starVBO; // One vec4 per star: position in [0, 1), twinkle phase, brightness
+
+// --- BLOOM ---
+// Vector-monitor glow: after the batched pass, the outlines, the ship's outline and the bullets are
+// drawn again into a target at 1/bloomScale of the window, blurred with a separable Gaussian (9 taps
+// in 5 bilinear fetches per direction: horizontal into a second target, vertical into a third) and
+// added onto the frame. The targets are the render graph's, which puts the third in the first's
+// texture. Only the small target is blurred, so its cost falls with the square of bloomScale. The
+// legacy per-object path (I) draws without it.
+bool useBloom = false; // Cycle off -> 1/2 -> 1/4 -> off with U (--bloom 2|4)
+int bloomScale = 2;
+const float BLOOM_INTENSITY = 1.2f;
+int bloomDirectionLoc;
+// What the batched pass left for the bloom to draw again (valid for the frame being recorded)
+struct BloomSource {
+    bool valid;
+    size_t instanceOffset; // Where drawBatchedObjects' instances start in the stream buffer
+    size_t shipInstance; // Instance holding the ship's outline color, or NO_SHIP_INSTANCE
+    double bulletTime; // Game time the resident bullets were drawn at
 };
-std::vector<Bullet> bullets;
+const size_t NO_SHIP_INSTANCE = ~static_cast<size_t>(0);
+BloomSource bloomSource = {};
+
+// ============================ GPU TIMER QUERIES ============================
+// One GL_TIME_ELAPSED query per render pass, in GPU_TIMER_FRAMES sets used round-robin. A set is read
+// back when it comes round again (two frames later), so the CPU does not wait on the GPU.
+// Passes are issued in enum order; beginGpuTimerFrame waits on the last. While a trace records, each
+// pass also gets a GL_TIMESTAMP query at its start, so it can be placed on the trace's timeline.
+// These are the scene's parts; the render graph's own passes (background, bloom, HUD) are timed by
+// the graph (see rendergraph.h).
+enum GpuPass { GPU_PASS_SWARM, GPU_PASS_SHIELD, GPU_PASS_SHIP, GPU_PASS_ASTEROIDS, GPU_PASS_BULLETS, GPU_PASS_COUNT };
+const ProfilePhase gpuPassPhases[GPU_PASS_COUNT] = {
+    PHASE_SWARM, PHASE_SHIELD_DRAW, PHASE_SHIP_DRAW, PHASE_ASTEROID_DRAW, PHASE_BULLET_DRAW
+};
+const int GPU_TIMER_FRAMES = 3;
+unsigned int gpuTimerQueries[GPU_TIMER_FRAMES][GPU_PASS_COUNT];
+bool gpuTimerIssued[GPU_TIMER_FRAMES] = { false };
+unsigned int gpuTimestampQueries[GPU_TIMER_FRAMES][GPU_PASS_COUNT];
+bool gpuTimestampsIssued[GPU_TIMER_FRAMES] = { false };
+int gpuTimerFrame = 0; // Set used by the frame being recorded
 
 // ============================ FUNCTION PROTOTYPES ============================
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void window_iconify_callback(GLFWwindow* window, int iconified);
+void window_focus_callback(GLFWwindow* window, int focused);
 void processInput(GLFWwindow* window);
-bool checkCollision(glm::vec2 pos1, float rad1, glm::vec2 pos2, float rad2);
-void spawnNewAsteroid(glm::vec2 pos, AsteroidSize size);
-void splitAsteroid(const Asteroid& rock, size_t index);
-void drawBresenhamLine(int x0, int y0, int x1, int y1, std::vector<float>& vertexBuffer);
-void drawBresenhamShip(const Ship& player, unsigned int vbo, std::vector<float>& vertexBuffer);
-// --- MIDPOINT CIRCLE ALGORITHM PROTOTYPES ---
-void drawMidpointCircle(int cx, int cy, int radius, unsigned int vbo, std::vector<float>& vertexBuffer);
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
+// --- RENDER INTERPOLATION ---
+float interpolateWrapped(float prev, float cur, float alpha);
+float interpolateAngle(float prev, float cur, float alpha);
+glm::vec2 interpolatedAsteroidPosition(const AsteroidStore& rocks, bool lazy, size_t i, float alpha);
+float interpolatedAsteroidRotation(const AsteroidStore& rocks, bool lazy, size_t i, float alpha);
+// --- SDF ASTEROIDS ---
+void drawSdfAsteroids(size_t base, size_t count);
+// --- PRIMITIVE RESTART BATCHING ---
+void setupRestartBatching();
 
 // ============================ SHADERS ============================
 const char* vertexShaderSource = R"(
     #version 330 core
     layout (location = 0) in vec2 aPos;
     
-    uniform mat4 transform;
+    uniform vec2 position;
+    uniform vec2 rotationScale; // x = rotation, y = scale
     
     void main()
     {
-        gl_Position = transform * vec4(aPos.x, aPos.y, 0.0, 1.0);
+        float c = cos(rotationScale.x);
+        float s = sin(rotationScale.x);
+        vec2 world = mat2(c, s, -s, c) * (aPos * rotationScale.y) + position;
+        gl_Position = vec4(world, 0.0, 1.0);
+    }
+)";
+
+// The player's ship under --late-latch: the game object shader with its pose read from the
+// ShipLatch block, written just before the draw (latelatch.h)
+const char* latchedShipVertexShaderSource = R"(
+    #version 330 core
+)" SHIP_LATCH_GLSL R"(
+    layout (location = 0) in vec2 aPos;
+
+    void main()
+    {
+        float c = cos(shipPose.z);
+        float s = sin(shipPose.z);
+        vec2 world = mat2(c, s, -s, c) * (aPos * shipPose.w) + shipPose.xy;
+        gl_Position = vec4(world, 0.0, 1.0);
     }
 )";
 
 const char* fragmentShaderSource = R"(
     #version 330 core
+)" FRAME_CONSTANTS_GLSL R"(
     out vec4 FragColor;
     
     uniform vec3 lineColor; 
     
     void main()
     {
-        FragColor = vec4(lineColor, 1.0f);
+        FragColor = vec4(lineColor, 1.0f) * tint;
+    }
+)";
+
+// Pixel point shader: integer pixel coordinates from the CPU rasterizers (same mapping as the GPU
+// raster backend), colored by the game object fragment shader
+const char* pixelVertexShaderSource = R"(
+    #version 330 core
+)" FRAME_CONSTANTS_GLSL R"(
+    layout (location = 0) in ivec2 aPixel;
+    uniform ivec2 pixelOffset; // The ship outline atlas's centre pixel; 0 for streamed points
+
+    void main()
+    {
+        gl_Position = vec4(vec2(aPixel + pixelOffset) / (viewportSize * 0.5) - 1.0, 0.0, 1.0);
     }
 )";
 
@@ -174,11 +486,17 @@ const char* bgVertexShader = R"(
     }
 )";
 
-const char* bgFragmentShader = R"(
-    #version 330 core
+// Everything after the #version line: startup prepends that and the quality preset's OCTAVES and
+// STAR_THRESHOLD defines (see QUALITY PRESETS)
+const char* bgFragmentShaderBody = FRAME_CONSTANTS_GLSL R"(
     out vec4 FragColor;
     in vec2 uv;
-    uniform float time;
+    uniform int pass; // 0 = nebula + stars, 1 = nebula only (low-res target), 2 = upscaled nebula + stars
+    uniform sampler2D nebulaTexture;
+    uniform int nebulaSource; // 0 = analytic fbm, 1 = baked noise texture
+    uniform sampler2D noiseTexture;
+    uniform float noisePeriod;
+    uniform int hashStars; // 1 = per-pixel hash stars, 0 = drawn as sprites afterwards
 
     // Pseudo-random hash function
     float hash(vec2 p) {
@@ -196,814 +514,3810 @@ const char* bgFragmentShader = R"(
     }
     float fbm(vec2 p){
         float v=0.0,a=0.5;
-        for(int i=0;i<5;i++){ v+=a*noise(p); p*=2.0; a*=0.5; } 
+        for(int i=0;i<OCTAVES;i++){ v+=a*noise(p); p*=2.0; a*=0.5; } 
         return v;
     }
 
     void main(){
-        vec2 p = uv*2.0-1.0;
-        p.x *= 1.6;
+        vec3 background;
+        if (pass == 2) {
+            background = texture(nebulaTexture, uv).rgb;
+        }
+        else {
+            vec2 p = uv*2.0-1.0;
+            p.x *= 1.2 * aspect; // 1.6 at the default 4:3 window, and no stretching after a resize
 
-        float n = fbm(p*2.5 + time*0.02);
+            vec2 q = p*2.5 + time*0.02;
+            float n = nebulaSource == 1 ? texture(noiseTexture, q / noisePeriod).r : fbm(q);
         
-        // Nebula colors (Dark and deep purple)
-        vec3 darkBlue = vec3(0.02, 0.01, 0.05);  
-        vec3 deepPurple = vec3(0.3, 0.1, 0.5);   
-        vec3 nebula = mix(darkBlue, deepPurple, n * 0.7); 
-
-        float d = length(p);
-        vec3 sun = vec3(1.0,0.9,0.6) * exp(-d*8.0) * 3.0;
+            // Nebula colors (Dark and deep purple)
+            vec3 darkBlue = vec3(0.02, 0.01, 0.05);  
+            vec3 deepPurple = vec3(0.3, 0.1, 0.5);   
+            vec3 nebula = mix(darkBlue, deepPurple, n * 0.7); 
+
+            float d = length(p);
+            vec3 sun = vec3(1.0,0.9,0.6) * exp(-d*8.0) * 3.0;
+            background = nebula + sun;
+        }
+        if (pass == 1) {
+            FragColor = vec4(background, 1.0); // Tinted when the upscale pass samples it
+            return;
+        }
 
         // FINAL STAR FIX FOR UNIFORMITY AND NO BIAS:
         // Adds a large offset and time to starCoords to ensure the hash function is sampled
         // randomly across the entire UV space, eliminating spatial clumping/bias.
         vec2 starCoords = uv * 512.0 + vec2(123.45, 543.21) + time * 1.0; 
         
-        // Threshold set to 0.999 for low density (0.1% chance).
-        float stars = step(0.999, hash(starCoords)); 
+        // Threshold 0.999 (the high preset) for low density (0.1% chance).
+        float stars = hashStars == 1 ? step(STAR_THRESHOLD, hash(starCoords)) : 0.0;
         
-        FragColor = vec4(nebula + sun + vec3(stars), 1.0);
+        FragColor = vec4(background + vec3(stars), 1.0) * tint;
     }
 )";
 
-// ============================ BRESENHAM (FOR SHIP OUTLINE) ============================
-void drawBresenhamLine(int x0, int y0, int x1, int y1, std::vector<float>& vertexBuffer) {
-    int dx = abs(x1 - x0);
-    int dy = abs(y1 - y0);
-    int sx = x0 < x1 ? 1 : -1;
-    int sy = y0 < y1 ? 1 : -1;
-    int err = dx - dy;
+// Star sprites: drift of the star's parallax layer, per-star twinkle, soft round points added on top
+// of the background
+const char* starVertexShaderSource = R"(
+    #version 330 core
+)" FRAME_CONSTANTS_GLSL R"(
+    layout (location = 0) in vec4 aStar; // xy in [0, 1), twinkle phase, brightness
+    out float brightness;
+    const int STAR_LAYERS = 3;
 
-    int x = x0;
-    int y = y0;
+    void main()
+    {
+        float depth = float(gl_VertexID % STAR_LAYERS + 1);
+        vec2 uv = fract(aStar.xy + time * 0.002 * depth);
+        float phase = aStar.z * 6.28318530718;
+        brightness = aStar.w * (0.7 + 0.3 * sin(time * (1.0 + 2.0 * aStar.z) + phase));
+        gl_PointSize = depth;
+        gl_Position = vec4(uv * 2.0 - 1.0, 0.0, 1.0);
+    }
+)";
 
-    while (true) {
-        float glX = (float)x / (SCR_WIDTH / 2.0f) - 1.0f;
-        float glY = (float)y / (SCR_HEIGHT / 2.0f) - 1.0f;
+const char* starFragmentShaderSource = R"(
+    #version 330 core
+)" FRAME_CONSTANTS_GLSL R"(
+    in float brightness;
+    out vec4 FragColor;
 
-        vertexBuffer.push_back(glX);
-        vertexBuffer.push_back(glY);
+    void main()
+    {
+        vec2 d = gl_PointCoord * 2.0 - 1.0; // The centre of a 1-pixel point is 0
+        float falloff = max(0.0, 1.0 - dot(d, d));
+        FragColor = vec4(vec3(brightness * falloff), 1.0) * tint;
+    }
+)";
 
-        if (x == x1 && y == y1) break;
+// Bloom: with a direction, one axis of a 9-tap Gaussian (sigma about 2 texels) in 5 fetches, each
+// pair of outer taps merged into one bilinear fetch between them; with direction (0, 0), the blurred
+// glow added onto the frame
+const char* bloomFragmentShaderSource = R"(
+    #version 330 core
+    in vec2 uv;
+    out vec4 FragColor;
+    uniform sampler2D source;
+    uniform vec2 direction; // One texel of the source along the blur axis
+    uniform float intensity;
+    const float OFFSETS[3] = float[](0.0, 1.3846153846, 3.2307692308);
+    const float WEIGHTS[3] = float[](0.2270270270, 0.3162162162, 0.0702702703);
 
-        int e2 = 2 * err;
-        if (e2 > -dy) {
-            err -= dy;
-            x += sx;
+    void main()
+    {
+        if (direction == vec2(0.0)) {
+            FragColor = vec4(texture(source, uv).rgb * intensity, 1.0);
+            return;
         }
-        if (e2 < dx) {
-            err += dx;
-            y += sy;
+        vec3 sum = texture(source, uv).rgb * WEIGHTS[0];
+        for (int i = 1; i < 3; ++i) {
+            sum += texture(source, uv + direction * OFFSETS[i]).rgb * WEIGHTS[i];
+            sum += texture(source, uv - direction * OFFSETS[i]).rgb * WEIGHTS[i];
         }
+        FragColor = vec4(sum, 1.0);
     }
-}
-
-void drawBresenhamShip(const Ship& player, unsigned int vbo, std::vector<float>& vertexBuffer) {
-    glm::vec2 localVertices[] = {
-        glm::vec2(0.0f,  1.0f),
-        glm::vec2(-1.0f, -1.0f),
-        glm::vec2(1.0f, -1.0f)
-    };
-
-    vertexBuffer.clear();
+)";
 
-    glm::mat4 model = glm::mat4(1.0f);
-    model = glm::translate(model, glm::vec3(player.position, 0.0f));
-    model = glm::rotate(model, player.rotation, glm::vec3(0.0f, 0.0f, 1.0f));
-    model = glm::scale(model, glm::vec3(player.scale, player.scale, 1.0f));
+// Instanced object shader: builds the model transform from per-instance position/rotation/scale,
+// and takes the per-draw color from the instance too (no uniforms but the polar table). With a shape
+// seed the mesh is a unit-circle fan and each boundary point gets the same 0.8-1.2 radius jitter that
+// generateFilledAsteroidVertices applies, keyed on its index on the finest level so every level of
+// detail keeps the silhouette; with polar silhouettes the seed is a table entry plus one instead and
+// polarShape builds the vertex from gl_VertexID alone.
+static_assert(ASTEROID_LOD_SEGMENTS[ASTEROID_LOD_COUNT - 1] == 64, "The shader's FINEST_SEGMENTS must match the finest level");
+// Shared by the instanced, primitive-restart and thick outline shaders (after FRAME_CONSTANTS_GLSL);
+// the integer hash (lowbias32) is exact on every GPU, unlike the background's sin hash
+#define PROCEDURAL_SHAPE_GLSL \
+    "const uint FINEST_SEGMENTS = 64u;\n" \
+    "uint hash(uint x) {\n" \
+    "    x ^= x >> 16; x *= 0x7feb352du;\n" \
+    "    x ^= x >> 15; x *= 0x846ca68bu;\n" \
+    "    x ^= x >> 16;\n" \
+    "    return x;\n" \
+    "}\n" \
+    "vec2 proceduralShape(vec2 p, uint seed) {\n" \
+    "    if (seed == 0u || p == vec2(0.0)) return p;\n" \
+    "    float turn = fract(atan(p.y, p.x) / 6.28318530718 + 1.0);\n" \
+    "    uint point = uint(round(turn * float(FINEST_SEGMENTS))) % FINEST_SEGMENTS;\n" \
+    "    float jitter = float(hash(seed * FINEST_SEGMENTS + point) >> 8) / 16777216.0;\n" \
+    "    return p * (1.0 + (jitter - 0.5) * 0.4);\n" \
+    "}\n" \
+    POLAR_SHAPE_GLSL \
+    "vec2 fanShape(vec2 p, int vertex, uint seed) {\n" \
+    "    if (polarShapes != 0 && seed != 0u) return polarShape(vertex, seed - 1u);\n" \
+    "    return proceduralShape(p, seed);\n" \
+    "}\n"
+
+const char* instancedVertexShaderSource = R"(
+    #version 330 core
+)" FRAME_CONSTANTS_GLSL R"(
+    layout (location = 0) in vec2 aPos;
+    layout (location = 1) in vec2 iPosition;
+    layout (location = 2) in vec2 iRotationScale; // x = rotation, y = scale
+    layout (location = 3) in uint iPaint;
+    layout (location = 4) in uint iShapeSeed;
 
-    int pixelVertices[6];
+    out vec3 vertexColor;
+)" PALETTE_GLSL PROCEDURAL_SHAPE_GLSL R"(
+    void main()
+    {
+        vec2 shape = fanShape(aPos, gl_VertexID, iShapeSeed);
+        float c = cos(iRotationScale.x);
+        float s = sin(iRotationScale.x);
+        vec2 world = mat2(c, s, -s, c) * (shape * iRotationScale.y) + iPosition * instancePositionScale;
+        vertexColor = paintColor(iPaint);
+        gl_Position = vec4(world, 0.0, 1.0);
+    }
+)";
 
-    for (int i = 0; i < 3; ++i) {
-        glm::vec4 temp = model * glm::vec4(localVertices[i], 0.0f, 1.0f);
+const char* instancedFragmentShaderSource = R"(
+    #version 330 core
+)" FRAME_CONSTANTS_GLSL R"(
+    in vec3 vertexColor;
+    out vec4 FragColor;
 
-        pixelVertices[i * 2] = static_cast<int>((temp.x + 1.0f) * (SCR_WIDTH / 2.0f));
-        pixelVertices[i * 2 + 1] = static_cast<int>((temp.y + 1.0f) * (SCR_HEIGHT / 2.0f));
+    void main()
+    {
+        FragColor = vec4(vertexColor, 1.0f) * tint;
     }
+)";
 
-    drawBresenhamLine(pixelVertices[0], pixelVertices[1], pixelVertices[2], pixelVertices[3], vertexBuffer);
-    drawBresenhamLine(pixelVertices[2], pixelVertices[3], pixelVertices[4], pixelVertices[5], vertexBuffer);
-    drawBresenhamLine(pixelVertices[4], pixelVertices[5], pixelVertices[0], pixelVertices[1], vertexBuffer);
-
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(vertexBuffer.size() * sizeof(float)), vertexBuffer.data());
-}
+// Primitive-restart shader: no vertex attributes at all. Each index packs an instance and an atlas
+// vertex, (instance << RESTART_VERTEX_BITS) | vertex, and both are fetched from buffer textures, so
+// one indexed draw can hold every mesh of every instance. Compact records are read as three R32UI
+// texels and unpacked by hand (GLSL 3.30 has no unpackHalf2x16).
+const int RESTART_VERTEX_BITS = 13; // Atlas vertices addressable by an index (the atlas holds ~4300, ~7900 with the shape stream's slots)
+const GLuint RESTART_INDEX = 0xFFFFFFFFu;
+static_assert(RESTART_VERTEX_BITS == 13, "The restart shader unpacks indices with 13 vertex bits");
+const char* restartVertexShaderSource = R"(
+    #version 330 core
+)" FRAME_CONSTANTS_GLSL R"(
+    uniform samplerBuffer atlas; // meshVBO as RG32F
+    uniform usamplerBuffer instances; // The stream buffer as RG32UI, three texels per ObjectInstance, or R32UI, three per CompactInstance
+    uniform int instanceBase; // This frame's first instance record
+    uniform bool compactInstances;
+
+    out vec3 vertexColor;
+)" PALETTE_GLSL PROCEDURAL_SHAPE_GLSL R"(
+    // The low 16 bits as a normalized short
+    float snorm16(uint bits)
+    {
+        return max(float(int(bits << 16) >> 16) / 32767.0, -1.0);
+    }
 
-// ============================ MIDPOINT CIRCLE ALGORITHM ============================
+    // The low 16 bits as a half float (no infinities or NaNs in a record)
+    float half16(uint bits)
+    {
+        uint exponent = (bits >> 10) & 0x1Fu;
+        float magnitude = exponent == 0u ? float(bits & 0x3FFu) * exp2(-24.0)
+                                         : uintBitsToFloat(((exponent + 112u) << 23) | ((bits & 0x3FFu) << 13));
+        return (bits & 0x8000u) != 0u ? -magnitude : magnitude;
+    }
 
-void drawCirclePoints(int cx, int cy, int x, int y, std::vector<float>& vertexBuffer) {
-    if (x == 0) {
-        // Points on the axes
-        vertexBuffer.push_back((float)cx / (SCR_WIDTH / 2.0f) - 1.0f); vertexBuffer.push_back(((float)cy + y) / (SCR_HEIGHT / 2.0f) - 1.0f);
-        vertexBuffer.push_back((float)cx / (SCR_WIDTH / 2.0f) - 1.0f); vertexBuffer.push_back(((float)cy - y) / (SCR_HEIGHT / 2.0f) - 1.0f);
-        vertexBuffer.push_back(((float)cx + y) / (SCR_WIDTH / 2.0f) - 1.0f); vertexBuffer.push_back((float)cy / (SCR_HEIGHT / 2.0f) - 1.0f);
-        vertexBuffer.push_back(((float)cx - y) / (SCR_WIDTH / 2.0f) - 1.0f); vertexBuffer.push_back((float)cy / (SCR_HEIGHT / 2.0f) - 1.0f);
+    void main()
+    {
+        int record = (instanceBase + (gl_VertexID >> 13)) * 3;
+        vec2 position, rotationScale;
+        uvec2 paintShape;
+        if (compactInstances) {
+            uint word0 = texelFetch(instances, record).x;
+            uint word1 = texelFetch(instances, record + 1).x;
+            uint word2 = texelFetch(instances, record + 2).x;
+            position = vec2(snorm16(word0), snorm16(word0 >> 16)) * instancePositionScale;
+            rotationScale = vec2(half16(word1), half16(word1 >> 16));
+            paintShape = uvec2(word2 & 0xFFFFu, word2 >> 16);
+        }
+        else {
+            position = uintBitsToFloat(texelFetch(instances, record).xy);
+            rotationScale = uintBitsToFloat(texelFetch(instances, record + 1).xy);
+            paintShape = texelFetch(instances, record + 2).xy;
+        }
+        vec2 shape = fanShape(texelFetch(atlas, gl_VertexID & 8191).xy, gl_VertexID & 8191, paintShape.y);
+        float c = cos(rotationScale.x);
+        float s = sin(rotationScale.x);
+        vec2 world = mat2(c, s, -s, c) * (shape * rotationScale.y) + position;
+        vertexColor = paintColor(paintShape.x);
+        gl_Position = vec4(world, 0.0, 1.0);
     }
-    else if (x == y) {
-        // Points on the 45-degree lines
-        vertexBuffer.push_back(((float)cx + x) / (SCR_WIDTH / 2.0f) - 1.0f); vertexBuffer.push_back(((float)cy + y) / (SCR_HEIGHT / 2.0f) - 1.0f);
-        vertexBuffer.push_back(((float)cx - x) / (SCR_WIDTH / 2.0f) - 1.0f); vertexBuffer.push_back(((float)cy + y) / (SCR_HEIGHT / 2.0f) - 1.0f);
-        vertexBuffer.push_back(((float)cx + x) / (SCR_WIDTH / 2.0f) - 1.0f); vertexBuffer.push_back(((float)cy - y) / (SCR_HEIGHT / 2.0f) - 1.0f);
-        vertexBuffer.push_back(((float)cx - x) / (SCR_WIDTH / 2.0f) - 1.0f); vertexBuffer.push_back(((float)cy - y) / (SCR_HEIGHT / 2.0f) - 1.0f);
+)";
+static_assert(sizeof(ObjectInstance) == 24, "The restart shader reads an ObjectInstance as three uvec2 texels");
+static_assert(offsetof(CompactInstance, rotation) == 4 && offsetof(CompactInstance, paint) == 8, "The restart shader unpacks a CompactInstance word by word");
+
+// Thick outline shader: draws an outline as 6 vertices (two triangles) per segment instead of a
+// GL_LINE_LOOP. gl_VertexID / 6 is the segment's first atlas vertex (the draw's `first` is scaled by
+// 6 to match); both ends come from the atlas buffer texture and the quad is widened in pixels, with
+// square ends half a width past each point so neighbouring segments overlap at the corners.
+const char* thickLineVertexShaderSource = R"(
+    #version 330 core
+)" FRAME_CONSTANTS_GLSL R"(
+    layout (location = 1) in vec2 iPosition;
+    layout (location = 2) in vec2 iRotationScale; // x = rotation, y = scale
+    layout (location = 3) in uint iPaint;
+    layout (location = 4) in uint iShapeSeed;
+    uniform samplerBuffer atlas; // meshVBO as RG32F
+    uniform float lineWidth; // Pixels
+
+    out vec3 vertexColor;
+)" PALETTE_GLSL PROCEDURAL_SHAPE_GLSL R"(
+    // An atlas vertex of this instance, in pixels from the center of the view
+    vec2 pixelPosition(int vertex)
+    {
+        vec2 shape = fanShape(texelFetch(atlas, vertex).xy, vertex, iShapeSeed);
+        float c = cos(iRotationScale.x);
+        float s = sin(iRotationScale.x);
+        return (mat2(c, s, -s, c) * (shape * iRotationScale.y) + iPosition * instancePositionScale) * viewportSize * 0.5;
     }
-    else if (x < y) {
-        // All eight octants
-        vertexBuffer.push_back(((float)cx + x) / (SCR_WIDTH / 2.0f) - 1.0f); vertexBuffer.push_back(((float)cy + y) / (SCR_HEIGHT / 2.0f) - 1.0f);
-        vertexBuffer.push_back(((float)cx - x) / (SCR_WIDTH / 2.0f) - 1.0f); vertexBuffer.push_back(((float)cy + y) / (SCR_HEIGHT / 2.0f) - 1.0f);
-        vertexBuffer.push_back(((float)cx + x) / (SCR_WIDTH / 2.0f) - 1.0f); vertexBuffer.push_back(((float)cy - y) / (SCR_HEIGHT / 2.0f) - 1.0f);
-        vertexBuffer.push_back(((float)cx - x) / (SCR_WIDTH / 2.0f) - 1.0f); vertexBuffer.push_back(((float)cy - y) / (SCR_HEIGHT / 2.0f) - 1.0f);
-        vertexBuffer.push_back(((float)cx + y) / (SCR_WIDTH / 2.0f) - 1.0f); vertexBuffer.push_back(((float)cy + x) / (SCR_HEIGHT / 2.0f) - 1.0f);
-        vertexBuffer.push_back(((float)cx - y) / (SCR_WIDTH / 2.0f) - 1.0f); vertexBuffer.push_back(((float)cy + x) / (SCR_HEIGHT / 2.0f) - 1.0f);
-        vertexBuffer.push_back(((float)cx + y) / (SCR_WIDTH / 2.0f) - 1.0f); vertexBuffer.push_back(((float)cy - x) / (SCR_HEIGHT / 2.0f) - 1.0f);
-        vertexBuffer.push_back(((float)cx - y) / (SCR_WIDTH / 2.0f) - 1.0f); vertexBuffer.push_back(((float)cy - x) / (SCR_HEIGHT / 2.0f) - 1.0f);
+
+    const int CORNER_END[6] = int[6](0, 0, 1, 1, 0, 1);
+    const float CORNER_SIDE[6] = float[6](-1.0, 1.0, -1.0, -1.0, 1.0, 1.0);
+
+    void main()
+    {
+        int segment = gl_VertexID / 6;
+        int corner = gl_VertexID % 6;
+        vec2 a = pixelPosition(segment);
+        vec2 b = pixelPosition(segment + 1);
+        float segmentLength = distance(a, b);
+        vec2 along = segmentLength > 0.0 ? (b - a) / segmentLength : vec2(1.0, 0.0);
+        vec2 across = vec2(-along.y, along.x);
+        float halfWidth = lineWidth * 0.5;
+        vec2 end = CORNER_END[corner] == 0 ? a - along * halfWidth : b + along * halfWidth;
+        vec2 p = end + across * CORNER_SIDE[corner] * halfWidth;
+        vertexColor = paintColor(iPaint);
+        gl_Position = vec4(p / (viewportSize * 0.5), 0.0, 1.0);
     }
-}
+)";
+
+// SDF asteroid shader: the quad corner in shape units is rotated and scaled like a mesh vertex, and
+// the fragment shader converts the sampled distance to pixels for the outline band and coverage
+const char* sdfVertexShaderSource = R"(
+    #version 330 core
+)" FRAME_CONSTANTS_GLSL R"(
+    layout (location = 0) in vec2 aPos;
+    layout (location = 1) in vec2 iPosition;
+    layout (location = 2) in vec2 iRotationScale; // x = rotation, y = scale
+    layout (location = 3) in uint iPaint;
+    layout (location = 4) in uint iShape;
 
-void drawMidpointCircle(int cx, int cy, int radius, unsigned int vbo, std::vector<float>& vertexBuffer) {
-    vertexBuffer.clear();
+    out vec2 shapePosition;
+    flat out uint rockPaint;
+    flat out uint shapeLayer;
+
+    void main()
+    {
+        float c = cos(iRotationScale.x);
+        float s = sin(iRotationScale.x);
+        vec2 world = mat2(c, s, -s, c) * (aPos * iRotationScale.y) + iPosition * instancePositionScale;
+        shapePosition = aPos;
+        rockPaint = iPaint;
+        shapeLayer = iShape;
+        gl_Position = vec4(world, 0.0, 1.0);
+    }
+)";
 
-    int x = 0;
-    int y = radius;
-    // The decision parameter P_k for midpoint circle algorithm
-    int p = 1 - radius; // P0 = 1 - r
+const char* sdfFragmentShaderSource = R"(
+    #version 330 core
+)" FRAME_CONSTANTS_GLSL PALETTE_GLSL R"(
+    in vec2 shapePosition;
+    flat in uint rockPaint; // Its palette entry, unshaded
+    flat in uint shapeLayer;
+    out vec4 FragColor;
 
-    drawCirclePoints(cx, cy, x, y, vertexBuffer);
+    uniform sampler2DArray asteroidSdf;
+    uniform float sdfExtent;
 
-    while (x < y) {
-        x++;
-        if (p < 0) {
-            // Select E: P_k+1 = P_k + 2x_k+1 + 1
-            p = p + 2 * x + 1;
-        }
-        else {
-            // Select SE: P_k+1 = P_k + 2x_k+1 + 1 - 2y_k+1
-            y--;
-            p = p + 2 * (x - y) + 1;
-        }
-        drawCirclePoints(cx, cy, x, y, vertexBuffer);
+    void main()
+    {
+        vec2 uv = shapePosition / (2.0 * sdfExtent) + 0.5;
+        float distance = texture(asteroidSdf, vec3(uv, float(shapeLayer))).r; // Shape units, negative inside
+        float pixel = max(length(vec2(dFdx(shapePosition.x), dFdy(shapePosition.x))), 1e-6);
+        float d = distance / pixel;
+        // 2-pixel outline centered on the boundary (as the old 2.0 line width), fill inside it
+        float coverage = clamp(1.5 - d, 0.0, 1.0);
+        if (coverage <= 0.0) discard;
+        float outline = clamp(d + 1.5, 0.0, 1.0);
+        vec3 color = mix(paintColor(rockPaint | 0x100u), paintColor(rockPaint | 0x200u), outline); // PAINT_FILL, PAINT_OUTLINE
+        FragColor = vec4(color, coverage) * tint;
     }
+)";
 
-    // Update VBO with the new circle points
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(vertexBuffer.size() * sizeof(float)), vertexBuffer.data());
+// Points instance attributes 1-4 of meshVAO at the instance that starts `base` bytes into the stream
+// buffer: one vertex buffer binding with DSA, else the four attributes of the bound VAO (meshVAO) from
+// the buffer bound to GL_ARRAY_BUFFER. Without base-instance draws (GL < 4.2) each draw group
+// re-specifies its offset instead.
+void bindInstanceAttributes(size_t base) {
+    if (useDirectStateAccess) {
+        glVertexArrayVertexBuffer(meshVAO, INSTANCE_BINDING, streamBuffer.vbo, static_cast<GLintptr>(base),
+                                  static_cast<GLsizei>(instanceRecordSize(compactInstanceRecords)));
+        return;
+    }
+    instanceAttributePointers(compactInstanceRecords, base);
 }
 
-// ============================ ASTEROID VERTEX GENERATION ============================
-std::vector<float> generateFilledAsteroidVertices(int segments, float radius) {
-    std::vector<float> vertices;
-    vertices.push_back(0.0f); // Center point (Index 0 for TRIANGLE_FAN)
-    vertices.push_back(0.0f);
-
-    // Ensure we have enough segments for a detailed shape
-    int actualSegments = std::max(segments, 20);
+// Settles the record format for the frame (the toggle may flip on the main thread while the render
+// thread draws): the DSA attribute formats follow it, and the shaders scale positions by the frame
+// constants. Call before updateFrameConstants.
+void useInstanceFormat(bool compact) {
+    if (useDirectStateAccess && meshVAO && compact != compactInstanceRecords) instanceAttributeFormats(meshVAO, compact);
+    compactInstanceRecords = compact;
+    frameConstants.instancePositionScale = compact ? INSTANCE_POSITION_RANGE : 1.0f;
+}
 
-    for (int i = 0; i <= actualSegments; ++i) { // Note: Loop goes to <= segments to close the fan
-        float angle = (float)i / (float)actualSegments * 2.0f * glm::pi<float>();
+// Writes a 2D point list into this frame's stream segment and points streamPointVAO at it.
+// Returns the vertex count to draw (0 if there was nothing to draw or no room this frame).
+GLsizei streamPoints(const FrameVector<float>& vertexBuffer) {
+    if (vertexBuffer.empty()) return 0;
+    size_t offset = streamBuffer.write(vertexBuffer.data(), vertexBuffer.size() * sizeof(float), sizeof(float));
+    if (offset == STREAM_WRITE_FAILED) return 0;
+    if (useDirectStateAccess) glVertexArrayVertexBuffer(streamPointVAO, 0, streamBuffer.vbo, static_cast<GLintptr>(offset), 2 * sizeof(float));
+    glState.bindVertexArray(streamPointVAO);
+    if (!useDirectStateAccess) glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)offset);
+    return static_cast<GLsizei>(vertexBuffer.size() / 2);
+}
 
-        // Add irregularity (radius factor between 0.8 and 1.2)
-        float currentRadius = radius * (1.0f + ((float)std::rand() / RAND_MAX - 0.5f) * 0.4f);
+// Reserves room for `points` pixel points in this frame's stream segment, points streamPixelVAO at it
+// and returns where to write them (nullptr if there is no room this frame). Call streamBuffer.commit()
+// once they are written.
+PixelPoint* mapStreamPixels(size_t points) {
+    size_t offset = 0;
+    void* target = streamBuffer.allocate(points * sizeof(PixelPoint), sizeof(PixelPoint), offset);
+    if (!target) return nullptr;
+    if (useDirectStateAccess) glVertexArrayVertexBuffer(streamPixelVAO, 0, streamBuffer.vbo, static_cast<GLintptr>(offset), sizeof(PixelPoint));
+    glState.bindVertexArray(streamPixelVAO);
+    if (!useDirectStateAccess) glVertexAttribIPointer(0, 2, GL_SHORT, sizeof(PixelPoint), (void*)offset);
+    return static_cast<PixelPoint*>(target);
+}
 
-        float x = currentRadius * cos(angle);
-        float y = currentRadius * sin(angle);
+// Draws the pixel points mapped last with the pixel point shader, then rebinds the game object shader
+void drawStreamPixels(GLsizei points, const glm::vec3& color, float pointSize) {
+    glState.useProgram(pixelPointProgram);
+    glState.uniform3f(pixelColorLoc, color.x, color.y, color.z);
+    glState.setPointSize(pointSize);
+    glState.bindVertexArray(streamPixelVAO);
+    glDrawArrays(GL_POINTS, 0, points);
+    ++drawCallCount;
+    glState.useProgram(shaderProgram);
+}
 
-        vertices.push_back(x);
-        vertices.push_back(y);
+// ============================ ASTEROID LEVEL OF DETAIL ============================
+// Atlas level for each AsteroidSize this frame (a rock's scale only depends on its size class). The
+// quality preset scales the radius, so lower presets drop to coarser levels sooner.
+void asteroidLodsForFrame(int lods[3]) {
+    // Clip space is stretched to the viewport, so a rock is widest along the longer axis
+    const RenderViewport& viewport = renderQueue.viewports[0]; // Split viewports are all (nearly) the same size
+    const float pixelsPerUnit = 0.5f * static_cast<float>(std::max(viewport.width, viewport.height)) *
+                                qualityPresets[qualityLevel].lodPixelScale;
+    for (int size = SMALL; size <= LARGE; ++size) {
+        float pixelRadius = getScaleFactor(static_cast<AsteroidSize>(size)) * pixelsPerUnit;
+        lods[size] = useAsteroidLod ? asteroidLodForPixelRadius(pixelRadius) : ASTEROID_LOD_COUNT - 1;
     }
-    return vertices;
 }
 
-void setupAsteroidGraphics(Asteroid& rock, int segments) {
-    float baseRadius = 1.0f; // Internal normalized radius
+// ============================ PROCEDURAL SILHOUETTES ============================
+// A rock's handle is stable for its whole life and never reused with the same generation, so it
+// seeds a silhouette that neither changes while the rock lives nor repeats for the next one (never 0)
+uint32_t proceduralShapeSeed(const AsteroidStore& rocks, size_t i) {
+    const EntityHandle handle = rocks.handles.handle(i);
+    const uint32_t seed = (handle.slot + 1) * 0x9E3779B1u + handle.generation;
+    return seed != 0 ? seed : 1;
+}
+
+// ============================ ASTEROID CULLING ============================
+// The view is clip space [-1, 1] on both axes (the mesh is not aspect-corrected, so neither is the
+// test). A rock is skipped when its bounding circle, at the outermost outline radius, misses the view.
+bool asteroidOnScreen(const glm::vec2& position, float scale) {
+    const float reach = 1.0f + ASTEROID_MAX_OUTLINE_RADIUS * scale;
+    return std::abs(position.x) <= reach && std::abs(position.y) <= reach;
+}
 
-    // --- [C] UPDATE FUNCTION CALL ---
-    std::vector<float> fillVertices = generateFilledAsteroidVertices(segments, baseRadius);
+// ============================ STATIC MESH ATLAS UPLOAD ============================
+// The asteroid outlines come first, every level of detail (their baseVertex values index straight into the buffer),
+// followed by the ship fill, the thrust flame and a single point for bullets, and last the shape
+// stream's spare slots, zeros until their shapes are uploaded.
+static MeshRange appendMesh(std::vector<float>& vertices, const float* mesh, int vertexCount) {
+    MeshRange range = { static_cast<GLint>(vertices.size() / 2), vertexCount };
+    vertices.insert(vertices.end(), mesh, mesh + vertexCount * 2);
+    return range;
+}
 
-    // The vertex count is now for GL_TRIANGLE_FAN (includes center + boundary)
-    rock.vertexCount = static_cast<int>(fillVertices.size() / 2);
+void setupMeshAtlas(std::vector<float> atlasVertices) {
+    // Ship FILL (GL_TRIANGLE_FAN)
+    const float shipFillVertices[] = {
+        0.0f, 0.0f,
+        0.0f, 1.0f,
+        -1.0f, -1.0f,
+         1.0f, -1.0f,
+        0.0f, 1.0f
+    };
+    // Thrust Fire (Filled Triangle)
+    const float fireVertices[] = {
+        0.0f, 0.0f,
+        -0.5f, -1.0f,
+         0.5f, -1.0f,
+         0.0f, 0.0f
+    };
+    const float bulletVertices[] = { 0.0f, 0.0f };
+    shipFillMesh = appendMesh(atlasVertices, shipFillVertices, 5);
+    fireMesh = appendMesh(atlasVertices, fireVertices, 4);
+    bulletMesh = appendMesh(atlasVertices, bulletVertices, 1);
+    // Circle fans for procedural silhouettes, laid out like the atlas shapes (center, closed boundary)
+    for (int lod = 0; lod < ASTEROID_LOD_COUNT; ++lod) {
+        const int segments = ASTEROID_LOD_SEGMENTS[lod];
+        std::vector<float> fan = { 0.0f, 0.0f };
+        for (int i = 0; i <= segments; ++i) {
+            float angle = static_cast<float>(i % segments) / segments * 2.0f * glm::pi<float>();
+            fan.push_back(cos(angle));
+            fan.push_back(sin(angle));
+        }
+        circleFans[lod] = appendMesh(atlasVertices, fan.data(), segments + 2);
+    }
+    frameConstants.circleFanBase = circleFans[0].first; // polarShape counts the levels from here
+    const float e = ASTEROID_SDF_EXTENT;
+    const float sdfQuadVertices[] = { -e, -e,  e, -e,  -e, e,  e, e };
+    sdfQuadMesh = appendMesh(atlasVertices, sdfQuadVertices, 4);
+    streamedShapeBase = static_cast<int>(atlasVertices.size() / 2);
+    if (useShapeStream) atlasVertices.resize(atlasVertices.size() + static_cast<size_t>(2 * ASTEROID_SHAPE_VERTICES * SHAPE_STREAM_SLOTS), 0.0f);
+
+    if (useDirectStateAccess) {
+        // Binding 0: the atlas vertices. Binding 1: the instance records in the stream buffer, advanced
+        // once per instance; bindInstanceAttributes moves it. The attributes keep their record offsets.
+        glCreateBuffers(1, &meshVBO);
+        glNamedBufferData(meshVBO, atlasVertices.size() * sizeof(float), atlasVertices.data(), GL_STATIC_DRAW);
+        glCreateVertexArrays(1, &meshVAO);
+        glVertexArrayVertexBuffer(meshVAO, 0, meshVBO, 0, 2 * sizeof(float));
+        glVertexArrayAttribFormat(meshVAO, 0, 2, GL_FLOAT, GL_FALSE, 0);
+        glVertexArrayAttribBinding(meshVAO, 0, 0);
+        glEnableVertexArrayAttrib(meshVAO, 0);
+        instanceAttributeFormats(meshVAO, compactInstanceRecords);
+        for (unsigned int attrib = 1; attrib <= 4; ++attrib) glVertexArrayAttribBinding(meshVAO, attrib, INSTANCE_BINDING);
+        glVertexArrayBindingDivisor(meshVAO, INSTANCE_BINDING, 1);
+        bindInstanceAttributes(0);
+        return;
+    }
 
-    // Use GL_LINES or GL_POINTS for rendering (not fill)
-    glGenVertexArrays(1, &rock.VAO_Fill);
-    glGenBuffers(1, &rock.VBO_Fill);
+    glGenVertexArrays(1, &meshVAO);
+    glGenBuffers(1, &meshVBO);
 
-    glBindVertexArray(rock.VAO_Fill);
-    glBindBuffer(GL_ARRAY_BUFFER, rock.VBO_Fill);
+    glBindVertexArray(meshVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, meshVBO);
 
-    glBufferData(GL_ARRAY_BUFFER, fillVertices.size() * sizeof(float), fillVertices.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, atlasVertices.size() * sizeof(float), atlasVertices.data(), GL_STATIC_DRAW);
 
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
 
+    // Per-instance attributes come from the shared instance buffer (advanced once per instance).
+    // The legacy path leaves them disabled and sets the transform and color as uniforms instead.
+    glBindBuffer(GL_ARRAY_BUFFER, streamBuffer.vbo);
+    for (unsigned int attrib = 1; attrib <= 4; ++attrib) glVertexAttribDivisor(attrib, 1);
+    bindInstanceAttributes(0);
+
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
 }
 
-// ============================ ASTEROID LOGIC ============================
+static void setInstanceAttributesEnabled(bool enabled) {
+    for (unsigned int attrib = 1; attrib <= 4; ++attrib) {
+        if (enabled) glEnableVertexAttribArray(attrib);
+        else glDisableVertexAttribArray(attrib);
+    }
+}
 
-void spawnNewAsteroid(glm::vec2 pos, AsteroidSize size)
-{
-    if (asteroids.size() >= static_cast<size_t>(MAX_ASTEROIDS)) return;
+// Appends one draw of `instanceCount` instances starting at `baseInstance`
+static void addDraw(FrameVector<DrawArraysIndirectCommand>& draws, GLint first, GLsizei count, size_t baseInstance, size_t instanceCount) {
+    if (instanceCount == 0) return;
+    draws.push_back({ static_cast<GLuint>(count), static_cast<GLuint>(instanceCount), static_cast<GLuint>(first), static_cast<GLuint>(baseInstance) });
+}
 
-    Asteroid newRock;
-    newRock.size = size;
-    newRock.scale = getScaleFactor(size);
-    newRock.radius = getRadiusFactor(size);
-    newRock.rotation = 0.0f;
-    newRock.rotationSpeed = 0.3f + ((float)std::rand() / RAND_MAX * 0.5f);
+// Streams a draw list's indirect commands for submitDraws (written once, however many viewports draw
+// them). Returns STREAM_WRITE_FAILED without indirect draws or room.
+static size_t uploadDraws(const FrameVector<DrawArraysIndirectCommand>& draws) {
+    if (draws.empty() || !useIndirectDraw) return STREAM_WRITE_FAILED;
+    return streamBuffer.write(draws.data(), draws.size() * sizeof(DrawArraysIndirectCommand), sizeof(GLuint));
+}
 
-    // --- [D] ADD COLOR PALETTE & ASSIGNMENT ---
-    glm::vec3 palette[] = {
-        glm::vec3(1.0f, 0.4f, 0.0f),  // Orange
-        glm::vec3(0.0f, 0.8f, 0.8f),  // Cyan
-        glm::vec3(0.8f, 0.0f, 0.8f),  // Magenta
-        glm::vec3(1.0f, 1.0f, 0.0f),  // Yellow
-        glm::vec3(0.1f, 1.0f, 0.1f)   // Green
-    };
-    int colorIndex = std::rand() % (sizeof(palette) / sizeof(glm::vec3));
-    newRock.color = palette[colorIndex];
+// Submits one primitive type's draw list: a single indirect multi-draw of the commands uploadDraws
+// wrote at commandOffset, or one instanced draw per entry
+static void submitDraws(GLenum mode, const FrameVector<DrawArraysIndirectCommand>& draws, size_t commandOffset, size_t instanceOffset) {
+    if (draws.empty()) return;
+    if (useIndirectDraw) {
+        if (commandOffset == STREAM_WRITE_FAILED) return;
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, streamBuffer.vbo);
+        glMultiDrawArraysIndirect(mode, (void*)commandOffset, static_cast<GLsizei>(draws.size()), 0);
+        ++drawCallCount;
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        return;
+    }
+    for (const DrawArraysIndirectCommand& draw : draws) {
+        bindInstanceAttributes(instanceOffset + draw.baseInstance * instanceRecordSize(compactInstanceRecords));
+        glDrawArraysInstanced(mode, draw.first, draw.count, draw.instanceCount);
+        ++drawCallCount;
+    }
+}
 
-    // If splitting (internal spawn)
-    if (pos != glm::vec2(0.0f, 0.0f)) {
-        newRock.position = pos;
+// A draw list as primitive restart indices in the stream: where, and how many
+struct RestartIndices {
+    size_t offset = STREAM_WRITE_FAILED;
+    GLsizei count = 0;
+};
 
-        // Give new asteroids a random velocity
-        float angle = ((float)std::rand() / RAND_MAX) * 2.0f * glm::pi<float>();
-        glm::vec2 direction = glm::vec2(cos(angle), sin(angle));
-        float speed = 0.3f + ((float)std::rand() / RAND_MAX * 0.4f);
-        newRock.velocity = direction * speed;
+// Streams a draw list as indices (instance, vertex) as the restart shader expects, each loop or fan
+// ended by RESTART_INDEX
+static RestartIndices uploadRestartIndices(const FrameVector<DrawArraysIndirectCommand>& draws) {
+    if (draws.empty()) return {};
+    restartIndices.clear();
+    for (const DrawArraysIndirectCommand& draw : draws) {
+        for (GLuint instance = draw.baseInstance; instance < draw.baseInstance + draw.instanceCount; ++instance) {
+            const GLuint base = instance << RESTART_VERTEX_BITS;
+            for (GLuint v = draw.first; v < draw.first + draw.count; ++v) restartIndices.push_back(base | v);
+            restartIndices.push_back(RESTART_INDEX);
+        }
     }
-    // If external spawn (off screen)
-    else {
-        float side = (float)std::rand() / RAND_MAX * 4.0f;
-        if (side < 1.0f) { newRock.position = glm::vec2(((float)std::rand() / RAND_MAX * 2.0f) - 1.0f, 1.1f); }
-        else if (side < 2.0f) { newRock.position = glm::vec2(((float)std::rand() / RAND_MAX * 2.0f) - 1.0f, -1.1f); }
-        else if (side < 3.0f) { newRock.position = glm::vec2(-1.1f, ((float)std::rand() / RAND_MAX * 2.0f) - 1.0f); }
-        else { newRock.position = glm::vec2(1.1f, ((float)std::rand() / RAND_MAX * 2.0f) - 1.0f); }
+    size_t indexOffset = streamBuffer.write(restartIndices.data(), restartIndices.size() * sizeof(GLuint), sizeof(GLuint));
+    if (indexOffset == STREAM_WRITE_FAILED) return {};
+    return { indexOffset, static_cast<GLsizei>(restartIndices.size()) };
+}
 
-        glm::vec2 target = glm::vec2(0.0f, 0.0f);
-        glm::vec2 direction = glm::normalize(target - newRock.position);
-        float scatter = 0.2f;
-        direction.x += ((float)std::rand() / RAND_MAX - 0.5f) * scatter;
-        direction.y += ((float)std::rand() / RAND_MAX - 0.5f) * scatter;
-        direction = glm::normalize(direction);
-        float speed = 0.1f + ((float)std::rand() / RAND_MAX * 0.2f);
-        newRock.velocity = direction * speed;
+// Submits uploaded restart indices as one indexed draw with primitive restart. Leaves the instanced
+// program bound.
+static void submitRestartDraws(GLenum mode, const RestartIndices& indices, size_t instanceOffset) {
+    if (indices.offset == STREAM_WRITE_FAILED) return;
+    glState.useProgram(restartProgram);
+    glUniform1i(restartInstanceBaseLoc, static_cast<GLint>(instanceOffset / instanceRecordSize(compactInstanceRecords)));
+    glUniform1i(restartCompactLoc, compactInstanceRecords ? 1 : 0);
+    if (instanceTextureGeneration != streamBuffer.generation || instanceTextureCompact != compactInstanceRecords) {
+        // The stream buffer is re-created when it grows; the texture itself stays on its unit
+        const GLenum format = compactInstanceRecords ? GL_R32UI : GL_RG32UI;
+        if (useDirectStateAccess) glTextureBuffer(instanceTexture, format, streamBuffer.vbo);
+        else {
+            glActiveTexture(GL_TEXTURE4);
+            glTexBuffer(GL_TEXTURE_BUFFER, format, streamBuffer.vbo);
+            glActiveTexture(GL_TEXTURE0);
+        }
+        instanceTextureGeneration = streamBuffer.generation;
+        instanceTextureCompact = compactInstanceRecords;
     }
-
-    setupAsteroidGraphics(newRock, 16);
-    asteroids.push_back(newRock);
+    if (useDirectStateAccess) {
+        glVertexArrayElementBuffer(restartVAO, streamBuffer.vbo);
+        glState.bindVertexArray(restartVAO);
+    }
+    else {
+        glState.bindVertexArray(restartVAO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, streamBuffer.vbo);
+    }
+    glState.setEnabled(GL_PRIMITIVE_RESTART, true);
+    glPrimitiveRestartIndex(RESTART_INDEX);
+    glDrawElements(mode, indices.count, GL_UNSIGNED_INT, (void*)indices.offset);
+    ++drawCallCount;
+    glState.setEnabled(GL_PRIMITIVE_RESTART, false);
+    glState.bindVertexArray(meshVAO);
+    glState.useProgram(instancedProgram);
 }
 
-void splitAsteroid(const Asteroid& rock, size_t index) {
-    AsteroidSize nextSize;
-
-    if (rock.size == LARGE) nextSize = MEDIUM;
-    else if (rock.size == MEDIUM) nextSize = SMALL;
-    else return; // Small asteroids are destroyed, not split
-
-    // Delete the original asteroid's graphics handles
-    glDeleteVertexArrays(1, &asteroids[index].VAO_Fill);
-    glDeleteBuffers(1, &asteroids[index].VBO_Fill);
+// Turns the outline draw list into screen-space quads in thickLineDraws: each loop of count points
+// becomes (count - 1) * 6 triangle vertices, with first scaled by 6 for the shader's segment lookup.
+// Every loop must end on a copy of its first point, which closes it here.
+// Returns the quads' uploadDraws offset.
+static size_t uploadThickOutlines(const FrameVector<DrawArraysIndirectCommand>& loops) {
+    thickLineDraws.clear();
+    for (const DrawArraysIndirectCommand& loop : loops) {
+        thickLineDraws.push_back({ (loop.count - 1) * 6, loop.instanceCount, loop.first * 6, loop.baseInstance });
+    }
+    return uploadDraws(thickLineDraws);
+}
 
-    // Remove the original rock from the vector
-    asteroids.erase(asteroids.begin() + index);
+// Submits the quads uploadThickOutlines made. Leaves the instanced program bound.
+static void submitThickOutlines(size_t commandOffset, size_t instanceOffset) {
+    if (thickLineDraws.empty()) return;
+    glState.useProgram(thickLineProgram);
+    glUniform1f(thickLineWidthLoc, outlineWidthPixels);
+    glDisableVertexAttribArray(0); // Vertices come from the atlas texture; gl_VertexID runs past meshVBO
+    submitDraws(GL_TRIANGLES, thickLineDraws, commandOffset, instanceOffset);
+    glEnableVertexAttribArray(0);
+    glState.useProgram(instancedProgram);
+}
 
-    // Spawn two new, smaller rocks
-    for (int i = 0; i < 2; ++i) {
-        if (asteroids.size() < static_cast<size_t>(MAX_ASTEROIDS)) {
-            // Spawn new asteroids slightly offset from the collision point
-            float offsetX = ((float)std::rand() / RAND_MAX - 0.5f) * rock.scale * 0.5f;
-            float offsetY = ((float)std::rand() / RAND_MAX - 0.5f) * rock.scale * 0.5f;
-            glm::vec2 spawnPos = rock.position + glm::vec2(offsetX, offsetY);
+// Rasterizes the outline table for the current framebuffer into its static buffer (at startup and
+// after a resize)
+void buildShipAtlas()
+{
+    std::vector<PixelPoint> points;
+    buildShipOutlineAtlas(Ship().scale, shipAtlasRotations, points, shipAtlasFirsts);
+    glBindBuffer(GL_ARRAY_BUFFER, shipAtlasVBO);
+    glBufferData(GL_ARRAY_BUFFER, points.size() * sizeof(PixelPoint), points.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    LOG_DEBUG("Ship outline atlas: %d rotations, %zu points (%zu KB)", shipAtlasRotations, points.size(), points.size() * sizeof(PixelPoint) / 1024);
+}
 
-            spawnNewAsteroid(spawnPos, nextSize);
+// Bresenham outline of the ship, from the atlas, the CPU rasterizer or the GPU backend (game object
+// shader bound). The pixels are the whole window's; each split-screen viewport draws them scaled into itself.
+void drawShipOutline(const Ship& renderShip) {
+    if (useShipAtlas) {
+        // Nothing rasterized or uploaded: a run of the table, moved by the shader
+        const int run = shipAtlasRun(renderShip.rotation, shipAtlasRotations);
+        const glm::ivec2 centre = fieldPixel(renderShip.position);
+        glState.useProgram(pixelPointProgram);
+        glState.uniform3f(pixelColorLoc, 0.5f, 1.0f, 1.0f);
+        glUniform2i(pixelOffsetLoc, centre.x, centre.y);
+        glState.setPointSize(2.0f);
+        glState.bindVertexArray(shipAtlasVAO);
+        renderQueue.forEachViewport([&] {
+            glDrawArrays(GL_POINTS, shipAtlasFirsts[run], shipAtlasFirsts[run + 1] - shipAtlasFirsts[run]);
+            ++drawCallCount;
+        });
+        glUniform2i(pixelOffsetLoc, 0, 0);
+        glState.useProgram(shaderProgram);
+    }
+    else if (useGpuRaster) {
+        // Only the three edges' endpoints go to the GPU
+        int v[6];
+        computeShipPixelVertices(renderShip, v);
+        int endpoints[12] = { v[0], v[1], v[2], v[3],  v[2], v[3], v[4], v[5],  v[4], v[5], v[0], v[1] };
+        renderQueue.forEachViewport([&] {
+            drawGpuBresenhamLines(endpoints, 3, glm::vec3(0.5f, 1.0f, 1.0f), 2.0f);
+            ++drawCallCount;
+        });
+        glState.useProgram(shaderProgram);
+    }
+    else {
+        // Exact point count up front, then one pass of stores into the mapped stream segment
+        int v[6];
+        computeShipPixelVertices(renderShip, v);
+        GLsizei outlinePoints = 0;
+        if (PixelPoint* out = mapStreamPixels(shipOutlinePointCount(v))) {
+            outlinePoints = static_cast<GLsizei>(drawBresenhamShip(v, out));
+            streamBuffer.commit();
         }
+        renderQueue.forEachViewport([&] { drawStreamPixels(outlinePoints, glm::vec3(0.5f, 1.0f, 1.0f), 2.0f); }); // Bright Outline Color
     }
 }
 
-// ============================ INPUT & CALLBACK DEFINITIONS ============================
-
-void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+// The player's hull and outline at the late-latched pose (--late-latch), in place of its hull in the
+// batch or the queue and of drawShipOutline: the keys held now, over the time since the snapshot's
+// newest tick was due. Not while fast-forwarding or paused, when that tick is not the present.
+static void drawLatchedShip(const RenderSnapshot& view, const Ship& renderShip)
 {
-    glViewport(0, 0, width, height);
+    Ship pose = renderShip;
+    if (!fastForwardActive() && !simulationPaused()) {
+        const float lead = std::chrono::duration<float>(std::chrono::steady_clock::now() - view.tickTime).count();
+        pose = extrapolateShip(view.player, heldInputNow(), std::clamp(lead, 0.0f, LATE_LATCH_MAX_LEAD));
+    }
+    latchShipPose(pose, streamBuffer.segment);
+    glState.useProgram(latchedShipProgram);
+    glState.bindVertexArray(meshVAO);
+    glState.setLineWidth(2.0f);
+    renderQueue.forEachViewport([] {
+        glState.uniform3f(latchedShipColorLoc, 0.2f, 0.7f, 0.7f);
+        glDrawArrays(GL_TRIANGLE_FAN, shipFillMesh.first, shipFillMesh.count);
+        glState.uniform3f(latchedShipColorLoc, 0.5f, 1.0f, 1.0f);
+        glDrawArrays(GL_LINE_LOOP, shipFillMesh.first + 1, shipFillMesh.count - 2); // Skips the center and the closing point
+        drawCallCount += 2;
+    });
+    glState.useProgram(shaderProgram);
 }
 
-void processInput(GLFWwindow* window)
+// A shield's color: blue/cyan, fading out as its time runs down
+static glm::vec3 shieldColor(float timeLeft)
 {
-    // ... (Rotation and Escape checks remain the same) ...
-
-    if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS)
-        player.rotation += ROTATION_SPEED * deltaTime;
-    if (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS)
-        player.rotation -= ROTATION_SPEED * deltaTime;
-    player.rotation = fmod(player.rotation, 2.0f * glm::pi<float>());
+    const float fade = timeLeft / SHIELD_DURATION;
+    return glm::vec3(0.0f, 0.8f * fade + 0.2f, 1.0f * fade + 0.2f);
+}
 
-    isThrusting = false;
+// Every ship's shield as a quad with the ring evaluated per pixel (shieldring.h), all in one instanced
+// draw per viewport; the player's at its interpolated pose, the bots' at theirs
+static void drawShieldQuads(const RenderSnapshot& view, const Ship& renderShip, float alpha)
+{
+    const int pixelRadius = shieldPixelRadius();
+    const auto addRing = [pixelRadius](glm::vec2 position, float timeLeft) {
+        shieldRings.push_back({ static_cast<int>((position.x + 1.0f) * (framebufferWidth / 2.0f)),
+                                static_cast<int>((position.y + 1.0f) * (framebufferHeight / 2.0f)), pixelRadius, shieldColor(timeLeft) });
+    };
+    shieldRings.clear();
+    if (view.shieldActive && !view.isGameOver) addRing(renderShip.position, view.shieldTimer);
+    for (size_t s = 0; s < view.others.size() && s < view.otherShieldTimers.size(); ++s) {
+        if (view.otherShieldTimers[s] <= 0.0f) continue;
+        const Ship& ship = view.others[s];
+        addRing(glm::vec2(interpolateWrapped(ship.prevPosition.x, ship.position.x, alpha), interpolateWrapped(ship.prevPosition.y, ship.position.y, alpha)),
+                view.otherShieldTimers[s]);
+    }
+    if (!stageShieldRings(shieldRings.data(), shieldRings.size())) return;
+    renderQueue.forEachViewport([] {
+        drawShieldRings();
+        ++drawCallCount;
+    });
+    glState.useProgram(shaderProgram);
+}
 
-    // --- Calculate the Ship's Facing Direction (Unit Vector) ---
-    // The ship's model (rotation=0) points UP (+Y).
-    // To use standard trigonometry (angle from +X axis), we must offset the angle by 90 degrees (pi/2).
-    float angleFromXAxis = player.rotation + glm::half_pi<float>();
+// Moves the exhaust on to this frame, then adds each thrusting ship's share at its interpolated pose
+static void stepExhaust(const RenderSnapshot& view, float alpha)
+{
+    static double lastTime = -1.0;
+    const float dt = lastTime < 0.0 ? 0.0f : std::min(std::max(static_cast<float>(frameInput.time - lastTime), 0.0f), MAX_SIM_TICKS_PER_FRAME * SIM_DT);
+    lastTime = frameInput.time;
+    exhaust.step(dt);
+    for (const Ship& ship : view.thrusters) {
+        const glm::vec2 position(interpolateWrapped(ship.prevPosition.x, ship.position.x, alpha),
+                                 interpolateWrapped(ship.prevPosition.y, ship.position.y, alpha));
+        exhaust.emit(position, interpolateAngle(ship.prevRotation, ship.rotation, alpha), ship.velocity, ship.scale);
+    }
+}
 
-    // Now use standard math for direction: X=cos, Y=sin
-    float dirX = cos(angleFromXAxis);
-    float dirY = sin(angleFromXAxis);
+// What drawBatchedObjects streamed, for submitObjectBatch to draw in each viewport (and the bloom)
+struct ObjectBatch {
+    bool instances = false; // Anything in objectInstanceBuffer (it went up at instanceOffset)
+    bool restart = false;
+    bool thickOutlines = false;
+    bool residentRocks = false;
+    size_t instanceOffset = 0;
+    size_t fillBase = 0;
+    size_t sdfCount = 0;
+    size_t fanCommands = STREAM_WRITE_FAILED, loopCommands = STREAM_WRITE_FAILED, pointCommands = STREAM_WRITE_FAILED;
+    size_t thickCommands = STREAM_WRITE_FAILED;
+    RestartIndices fanIndices, loopIndices;
+};
+static ObjectBatch objectBatch;
+
+static void submitObjectBatch() {
+    const ObjectBatch& batch = objectBatch;
+    if (!batch.instances) {
+        if (batch.residentRocks) drawCallCount += drawResidentRocks();
+        if (useResidentBullets) drawCallCount += drawResidentBullets(bloomSource.bulletTime, PAINT_BULLET, 5.0f);
+        glState.useProgram(shaderProgram);
+        return;
+    }
+    glState.useProgram(instancedProgram);
+    glState.bindVertexArray(meshVAO);
+    setInstanceAttributesEnabled(true);
+    bindInstanceAttributes(batch.instanceOffset); // Indirect draws select their instances with baseInstance
+    glState.setLineWidth(2.0f);
+    if (batch.restart) submitRestartDraws(GL_TRIANGLE_FAN, batch.fanIndices, batch.instanceOffset);
+    else submitDraws(GL_TRIANGLE_FAN, fanDraws, batch.fanCommands, batch.instanceOffset);
+    if (batch.sdfCount > 0) {
+        drawSdfAsteroids(batch.instanceOffset + batch.fillBase * instanceRecordSize(compactInstanceRecords), batch.sdfCount);
+        bindInstanceAttributes(batch.instanceOffset);
+    }
+    if (batch.residentRocks) {
+        drawCallCount += drawResidentRocks();
+        glState.useProgram(instancedProgram);
+        glState.bindVertexArray(meshVAO);
+    }
+    if (batch.thickOutlines) submitThickOutlines(batch.thickCommands, batch.instanceOffset);
+    else if (batch.restart) submitRestartDraws(GL_LINE_LOOP, batch.loopIndices, batch.instanceOffset);
+    else submitDraws(GL_LINE_LOOP, loopDraws, batch.loopCommands, batch.instanceOffset);
+    glState.setPointSize(5.0f);
+    submitDraws(GL_POINTS, pointDraws, batch.pointCommands, batch.instanceOffset);
+    setInstanceAttributesEnabled(false);
+    if (useResidentBullets) drawCallCount += drawResidentBullets(bloomSource.bulletTime, PAINT_BULLET, 5.0f);
+    glState.useProgram(shaderProgram);
+}
 
-    // Note: The previous logic (dirX=sin, dirY=cos) was effectively doing this offset,
-    // but the `glm::rotate` in rendering likely expects the standard angle,
-    // creating the mismatch you observed when rotating left/right.
-    // By using the standard X=cos, Y=sin, we align the physics direction.
+// Exhaust, ship hulls (and outlines, --instanced-ships), asteroids (fill + outline) and bullets as instances in one streamed write,
+// then one draw list per primitive type, submitted in each viewport
+void drawBatchedObjects(const RenderSnapshot& view, const Ship& renderShip, float alpha) {
+    objectInstanceBuffer.clear();
+    fanDraws.clear();
+    loopDraws.clear();
+    pointDraws.clear();
+    bloomSource = { false, 0, NO_SHIP_INSTANCE, view.bullets.clock - (1.0f - alpha) * SIM_DT };
+
+    // Every ship's plume is one draw of fire-mesh instances, under the hulls; it dims as it cools
+    stepExhaust(view, alpha);
+    if (exhaust.count > 0) {
+        addDraw(fanDraws, fireMesh.first, fireMesh.count, objectInstanceBuffer.size(), exhaust.count);
+        for (size_t i = 0; i < exhaust.count; ++i) {
+            const uint32_t paint = exhaust.age[i] < 0.5f * exhaust.lifetime[i] ? PAINT_FIRE : PAINT_FIRE | PAINT_FILL;
+            objectInstanceBuffer.push_back({ glm::vec2(exhaust.x[i], exhaust.y[i]), exhaust.rotation[i], exhaust.drawScale(i), paint });
+        }
+    }
 
-    // --- Thrust Movement ---
-    if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS)
-    {
-        isThrusting = true;
+    // Every ship's hull (the player's first, then the bots') is one draw of the same mesh
+    const size_t shipBase = objectInstanceBuffer.size();
+    if (!view.isGameOver && !useLateLatch) objectInstanceBuffer.push_back({ renderShip.position, renderShip.rotation, renderShip.scale, PAINT_SHIP });
+    for (const Ship& ship : view.others) {
+        const glm::vec2 position(interpolateWrapped(ship.prevPosition.x, ship.position.x, alpha),
+                                 interpolateWrapped(ship.prevPosition.y, ship.position.y, alpha));
+        objectInstanceBuffer.push_back({ position, interpolateAngle(ship.prevRotation, ship.rotation, alpha), ship.scale, PAINT_SHIP });
+    }
+    const size_t shipCount = objectInstanceBuffer.size() - shipBase;
+    if (shipCount > 0) addDraw(fanDraws, shipFillMesh.first, shipFillMesh.count, shipBase, shipCount);
+    // Instanced ships: the same records again in the outline color, drawn as one loop after the rocks'
+    // (which the bloom then draws too). Otherwise the bloom alone loops the player's, in the Bresenham
+    // outline's color.
+    const size_t shipOutlineBase = objectInstanceBuffer.size();
+    if (useInstancedShips) {
+        for (size_t k = 0; k < shipCount; ++k) {
+            ObjectInstance outline = objectInstanceBuffer[shipBase + k];
+            outline.paint = PAINT_SHIP_GLOW;
+            objectInstanceBuffer.push_back(outline);
+        }
+    }
+    else if (useBloom && !view.isGameOver && !useLateLatch) {
+        bloomSource.shipInstance = objectInstanceBuffer.size();
+        objectInstanceBuffer.push_back({ renderShip.position, renderShip.rotation, renderShip.scale, PAINT_SHIP_GLOW });
+    }
 
-        // Ship movement: Apply acceleration (thrust) in the direction the ship is facing.
-        player.velocity.x += dirX * THRUST_SPEED * deltaTime;
-        player.velocity.y += dirY * THRUST_SPEED * deltaTime;
+    // Resident rocks are already on the GPU (synced before the frame constants went up): no instances
+    const bool residentRocks = useResidentRocks && view.wrapsAtEdges && residentRocksReady() && asteroidSdfTexture;
+
+    // Counting sort of the asteroids by drawn shape and level of detail (group = shape * ASTEROID_LOD_COUNT + lod,
+    // or just lod for procedural and polar silhouettes) so every mesh is one contiguous group; the fills (PAINT_FILL) and outlines (PAINT_OUTLINE)
+    // are two copies of that sequence. Rocks whose bounding circle is off screen get no instances; rocks
+    // straddling an edge get one more per ghost image, in the same group.
+    const AsteroidStore& rocks = view.asteroids;
+    const int GROUP_COUNT = DRAWN_ASTEROID_SHAPES * ASTEROID_LOD_COUNT;
+    const bool sharedFans = frameSilhouettes != SILHOUETTES_ATLAS; // Procedural or polar: every rock on the circle fans
+    int sizeLods[3];
+    asteroidLodsForFrame(sizeLods);
+    asteroidDraws.clear();
+    int shapeStart[GROUP_COUNT + 1] = { 0 };
+    size_t visibleCount = 0;
+    for (size_t i = 0; i < (residentRocks ? 0 : rocks.count()); ++i) {
+        glm::vec2 position = interpolatedAsteroidPosition(rocks, view.lazyAsteroidMotion, i, alpha);
+        int group = sharedFans ? sizeLods[rocks.sizeClass[i]] : drawnAsteroidShape(rocks, i) * ASTEROID_LOD_COUNT + sizeLods[rocks.sizeClass[i]];
+        if (asteroidOnScreen(position, rocks.scale(i))) {
+            asteroidDraws.push_back({ position, static_cast<int>(i), group });
+            ++visibleCount;
+        }
+        glm::vec2 ghostOffsets[3];
+        int ghostCount = view.wrapsAtEdges ? wrapGhostOffsets(position, ASTEROID_MAX_OUTLINE_RADIUS * rocks.scale(i), ghostOffsets) : 0;
+        for (int g = 0; g < ghostCount; ++g) {
+            if (asteroidOnScreen(position + ghostOffsets[g], rocks.scale(i))) {
+                asteroidDraws.push_back({ position + ghostOffsets[g], static_cast<int>(i), group });
+            }
+        }
+    }
+    for (const AsteroidDraw& draw : asteroidDraws) shapeStart[draw.group + 1]++;
+    for (int k = 0; k < GROUP_COUNT; ++k) shapeStart[k + 1] += shapeStart[k];
+    int shapeCursor[GROUP_COUNT];
+    std::copy(shapeStart, shapeStart + GROUP_COUNT, shapeCursor);
+    if (!residentRocks) { // The vertex shader culls resident rocks
+        profilerCount(COUNTER_ASTEROIDS_DRAWN, static_cast<long long>(visibleCount));
+        profilerCount(COUNTER_ASTEROIDS_CULLED, static_cast<long long>(rocks.count() - visibleCount));
+        profilerCount(COUNTER_ASTEROID_GHOSTS, static_cast<long long>(asteroidDraws.size() - visibleCount));
     }
 
-    // --- Firing Bullet ---
-    if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS && bulletCooldown <= 0.0f)
-    {
-        Bullet newBullet;
+    const size_t fillBase = objectInstanceBuffer.size();
+    const size_t outlineBase = fillBase + asteroidDraws.size();
+    const bool sdfAsteroids = useSdfAsteroids && asteroidSdfTexture; // Fans until the SDF is loaded
+    const size_t sdfCount = sdfAsteroids ? asteroidDraws.size() : 0;
+    objectInstanceBuffer.resize(sdfAsteroids ? outlineBase : outlineBase + asteroidDraws.size());
+    for (const AsteroidDraw& draw : asteroidDraws) {
+        const size_t i = static_cast<size_t>(draw.rock);
+        float rotation = interpolatedAsteroidRotation(rocks, view.lazyAsteroidMotion, i, alpha);
+        size_t slot = static_cast<size_t>(shapeCursor[draw.group]++);
+        if (sdfAsteroids) {
+            // One quad per image; the shader derives the fill and outline colors itself
+            objectInstanceBuffer[fillBase + slot] = { draw.position, rotation, rocks.scale(i), rocks.paletteIndex[i], static_cast<uint32_t>(rocks.shapeIndex[i]) };
+            continue;
+        }
+        uint32_t seed = 0;
+        if (frameSilhouettes == SILHOUETTES_PROCEDURAL) seed = proceduralShapeSeed(rocks, i);
+        else if (frameSilhouettes == SILHOUETTES_POLAR) seed = static_cast<uint32_t>(polarAsteroidShape(rocks, i)) + 1;
+        objectInstanceBuffer[fillBase + slot] = { draw.position, rotation, rocks.scale(i), rocks.paletteIndex[i] | PAINT_FILL, seed };
+        objectInstanceBuffer[outlineBase + slot] = { draw.position, rotation, rocks.scale(i), rocks.paletteIndex[i] | PAINT_OUTLINE, seed };
+    }
+    for (int k = 0; k < (sdfAsteroids ? 0 : sharedFans ? ASTEROID_LOD_COUNT : GROUP_COUNT); ++k) {
+        size_t groupSize = static_cast<size_t>(shapeStart[k + 1] - shapeStart[k]);
+        if (groupSize == 0) continue; // Streamed shapes not uploaded yet have no meshes either
+        MeshRange mesh = circleFans[k];
+        if (!sharedFans) {
+            const AsteroidMesh& shape = drawnAsteroidMesh(k / ASTEROID_LOD_COUNT, k % ASTEROID_LOD_COUNT);
+            mesh = { shape.baseVertex, shape.vertexCount };
+        }
+        addDraw(fanDraws, mesh.first, mesh.count, fillBase + shapeStart[k], groupSize);
+        // Outline skips the center point
+        addDraw(loopDraws, mesh.first + 1, mesh.count - 1, outlineBase + shapeStart[k], groupSize);
+    }
+    if (useInstancedShips && shipCount > 0) {
+        // Skips the center but keeps the closing point, like the asteroids' loops: the thick outlines
+        // draw a segment per point after the first, so without it one hull edge would be missing
+        addDraw(loopDraws, shipFillMesh.first + 1, shipFillMesh.count - 1, shipOutlineBase, shipCount);
+    }
 
-        // Spawn the bullet slightly ahead of the ship's center.
-        float spawnDistance = player.radius * 1.5f;
+    // Resident bullets only send the records of the bullets fired or lost since the last frame
+    if (useResidentBullets) syncResidentBullets(view.bullets);
+    else {
+        addDraw(pointDraws, bulletMesh.first, bulletMesh.count, objectInstanceBuffer.size(), view.bullets.liveCount());
+        for (size_t i = 0; i < view.bullets.capacity(); ++i) {
+            if (!view.bullets.live(i)) continue;
+            glm::vec2 position(view.bullets.px[i] + (view.bullets.x[i] - view.bullets.px[i]) * alpha,
+                               view.bullets.py[i] + (view.bullets.y[i] - view.bullets.py[i]) * alpha);
+            objectInstanceBuffer.push_back({ position, 0.0f, 1.0f, PAINT_BULLET });
+        }
+    }
 
-        newBullet.position.x = player.position.x + dirX * spawnDistance;
-        newBullet.position.y = player.position.y + dirY * spawnDistance;
+    objectBatch = ObjectBatch();
+    objectBatch.instances = !objectInstanceBuffer.empty();
+    objectBatch.residentRocks = residentRocks;
+    objectBatch.fillBase = fillBase;
+    objectBatch.sdfCount = sdfCount;
+    if (objectBatch.instances) {
+        ObjectBatch& batch = objectBatch;
+        // The restart shader addresses whole records and packs the instance into the top index bits
+        const size_t recordSize = instanceRecordSize(compactInstanceRecords);
+        const size_t texelSize = (compactInstanceRecords ? 1 : 2) * sizeof(uint32_t);
+        batch.restart = useRestartBatching && restartProgram && objectInstanceBuffer.size() <= (RESTART_INDEX >> (RESTART_VERTEX_BITS + 1))
+            && streamBuffer.segmentSize * STREAM_BUFFER_FRAMES / texelSize <= static_cast<size_t>(maxTextureBufferTexels);
+        batch.thickOutlines = useThickOutlines && thickLineProgram;
+        const size_t alignment = batch.restart ? recordSize : sizeof(float);
+        if (compactInstanceRecords) {
+            // Packed straight into the stream segment; the float records never go up
+            if (void* target = streamBuffer.allocate(objectInstanceBuffer.size() * recordSize, alignment, batch.instanceOffset)) {
+                packInstances(objectInstanceBuffer.data(), objectInstanceBuffer.size(), static_cast<CompactInstance*>(target));
+                streamBuffer.commit();
+            }
+            else batch.instanceOffset = STREAM_WRITE_FAILED;
+        }
+        else batch.instanceOffset = streamBuffer.write(objectInstanceBuffer.data(), objectInstanceBuffer.size() * recordSize, alignment);
+        if (batch.instanceOffset == STREAM_WRITE_FAILED) return;
+        bloomSource.valid = true;
+        bloomSource.instanceOffset = batch.instanceOffset;
+
+        // The draw lists go up once; every viewport (and the bloom's loops) draws from the same copy
+        if (batch.restart) {
+            batch.fanIndices = uploadRestartIndices(fanDraws);
+            if (!batch.thickOutlines) batch.loopIndices = uploadRestartIndices(loopDraws);
+        }
+        else batch.fanCommands = uploadDraws(fanDraws);
+        if (batch.thickOutlines) batch.thickCommands = uploadThickOutlines(loopDraws);
+        else if (!batch.restart || useBloom) batch.loopCommands = uploadDraws(loopDraws); // The bloom draws plain loops
+        batch.pointCommands = uploadDraws(pointDraws);
+    }
+    renderQueue.forEachViewport(submitObjectBatch);
+}
 
-        // The bullet velocity is its own speed in the direction of fire, 
-        // PLUS the ship's current velocity (momentum).
-        newBullet.velocity.x = dirX * BULLET_SPEED + player.velocity.x;
-        newBullet.velocity.y = dirY * BULLET_SPEED + player.velocity.y;
+// ============================ GPU TIMER FUNCTIONS ============================
+void setupGpuTimers()
+{
+    glGenQueries(GPU_TIMER_FRAMES * GPU_PASS_COUNT, &gpuTimerQueries[0][0]);
+    glGenQueries(GPU_TIMER_FRAMES * GPU_PASS_COUNT, &gpuTimestampQueries[0][0]);
+    renderGraph.setup();
+}
 
-        bullets.push_back(newBullet);
-        bulletCooldown = FIRE_RATE;
-    }
-    // --- SHIELD ACTIVATION ---
-    if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS && !shieldActive && shieldCooldownTimer <= 0.0f) {
-        shieldActive = true;
-        shieldTimer = SHIELD_DURATION;
-        std::cout << "Shield Activated!" << std::endl;
-    }
+// Collects the set this frame is about to reuse. If the GPU has not finished it yet the sample is
+// dropped rather than stalling the pipeline.
+// Moves the dynamic resolution one step toward the frame budget (see DYNAMIC RESOLUTION)
+void updateDynamicResolution(double gpuFrameMs)
+{
+    if (!useDynamicResolution || frameIndex - dynamicResolutionFrame < DYNAMIC_RESOLUTION_SETTLE_FRAMES) return;
+    int step = dynamicResolutionStep;
+    if (gpuFrameMs > frameBudgetMs * 0.9) step = std::max(step - 1, DYNAMIC_RESOLUTION_MIN_STEP);
+    else if (gpuFrameMs < frameBudgetMs * 0.6) step = std::min(step + 1, DYNAMIC_RESOLUTION_STEPS);
+    if (step == dynamicResolutionStep) return;
+    dynamicResolutionStep = step;
+    dynamicResolutionFrame = frameIndex;
+    LOG_DEBUG("Dynamic resolution: %d/%d (GPU %.2f ms)", step, DYNAMIC_RESOLUTION_STEPS, gpuFrameMs);
 }
 
-// --- checkCollision with Shield ---
-bool checkCollision(glm::vec2 pos1, float rad1, glm::vec2 pos2, float rad2)
+void beginGpuTimerFrame()
 {
-    // If pos1 is the ship, use the shield radius if active
-    if (pos1 == player.position && rad1 == player.radius && shieldActive) {
-        rad1 = SHIELD_RADIUS_FACTOR;
+    const double graphMs = renderGraph.collectTimings();
+    if (gpuTimerIssued[gpuTimerFrame]) {
+        GLint available = 0;
+        glGetQueryObjectiv(gpuTimerQueries[gpuTimerFrame][GPU_PASS_COUNT - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available) {
+            // GPU timestamps run on their own clock: pair it with the steady clock once per set
+            GLint64 gpuNow = 0;
+            std::chrono::steady_clock::time_point cpuNow;
+            const bool traced = gpuTimestampsIssued[gpuTimerFrame] && traceActive();
+            if (traced) {
+                glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+                cpuNow = std::chrono::steady_clock::now();
+            }
+            double gpuFrameMs = graphMs;
+            for (int pass = 0; pass < GPU_PASS_COUNT; ++pass) {
+                GLuint64 nanoseconds = 0;
+                glGetQueryObjectui64v(gpuTimerQueries[gpuTimerFrame][pass], GL_QUERY_RESULT, &nanoseconds);
+                profilerAddGpu(gpuPassPhases[pass], nanoseconds / 1.0e6);
+                gpuFrameMs += nanoseconds / 1.0e6;
+                if (traced) {
+                    GLuint64 startedAt = 0;
+                    glGetQueryObjectui64v(gpuTimestampQueries[gpuTimerFrame][pass], GL_QUERY_RESULT, &startedAt);
+                    traceGpuSpan(profilerPhaseName(gpuPassPhases[pass]),
+                                 cpuNow - std::chrono::nanoseconds(gpuNow - static_cast<GLint64>(startedAt)), nanoseconds / 1.0e6);
+                }
+            }
+            updateDynamicResolution(gpuFrameMs);
+        }
     }
+    gpuTimerIssued[gpuTimerFrame] = true;
+    gpuTimestampsIssued[gpuTimerFrame] = traceActive();
+}
 
-    glm::vec2 distanceVec = pos1 - pos2;
-    float distanceSq = distanceVec.x * distanceVec.x + distanceVec.y * distanceVec.y;
-    float radiiSumSq = (rad1 + rad2) * (rad1 + rad2);
-
-    return distanceSq < radiiSumSq;
+void beginGpuTimer(GpuPass pass)
+{
+    if (gpuTimestampsIssued[gpuTimerFrame]) glQueryCounter(gpuTimestampQueries[gpuTimerFrame][pass], GL_TIMESTAMP);
+    glBeginQuery(GL_TIME_ELAPSED, gpuTimerQueries[gpuTimerFrame][pass]);
 }
 
+void endGpuTimer()
+{
+    glEndQuery(GL_TIME_ELAPSED);
+}
 
-// ============================ MAIN FUNCTION ============================
-int main()
+void endGpuTimerFrame()
 {
-    std::srand(static_cast<unsigned int>(std::time(0)));
+    gpuTimerFrame = (gpuTimerFrame + 1) % GPU_TIMER_FRAMES;
+}
 
-    // --- 1. GLFW/GLAD Initialization ---
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-#ifdef __APPLE__
-    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
-#endif
+// ============================ BAKED NOISE TEXTURE ============================
+// Integer lattice hash in [0, 1], wrapped at `period` so the noise tiles
+float latticeHash(int x, int y, int period) {
+    x = ((x % period) + period) % period;
+    y = ((y % period) + period) % period;
+    unsigned int h = static_cast<unsigned int>(x) * 374761393u + static_cast<unsigned int>(y) * 668265263u;
+    h = (h ^ (h >> 13)) * 1274126177u;
+    return static_cast<float>((h ^ (h >> 16)) & 0xFFFFu) / 65535.0f;
+}
 
-    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Asteroids", NULL, NULL);
-    if (window == NULL) {
-        std::cout << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
-        return -1;
-    }
-    glfwMakeContextCurrent(window);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+// Same smoothstep value noise as the shader's noise(), on a wrapping lattice
+float tileableNoise(float x, float y, int period) {
+    int ix = static_cast<int>(std::floor(x));
+    int iy = static_cast<int>(std::floor(y));
+    float fx = x - ix, fy = y - iy;
+    fx = fx * fx * (3.0f - 2.0f * fx);
+    fy = fy * fy * (3.0f - 2.0f * fy);
+    float a = latticeHash(ix, iy, period), b = latticeHash(ix + 1, iy, period);
+    float c = latticeHash(ix, iy + 1, period), d = latticeHash(ix + 1, iy + 1, period);
+    return (a + (b - a) * fx) + ((c + (d - c) * fx) - (a + (b - a) * fx)) * fy;
+}
 
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        std::cout << "Failed to initialize GLAD" << std::endl;
-        return -1;
+// CPU half of the baked noise: no GL, so it runs on a worker (loadNoiseTexture)
+std::vector<unsigned char> bakeNoiseTexels() {
+    std::vector<unsigned char> texels(NOISE_TEXTURE_SIZE * NOISE_TEXTURE_SIZE);
+    for (int j = 0; j < NOISE_TEXTURE_SIZE; ++j) {
+        for (int i = 0; i < NOISE_TEXTURE_SIZE; ++i) {
+            float x = (i + 0.5f) / NOISE_TEXTURE_SIZE * NOISE_PERIOD;
+            float y = (j + 0.5f) / NOISE_TEXTURE_SIZE * NOISE_PERIOD;
+            // 5 octaves like fbm(); each octave doubles the frequency, so its lattice period doubles too
+            float v = 0.0f, amplitude = 0.5f;
+            int period = NOISE_PERIOD;
+            for (int octave = 0; octave < 5; ++octave) {
+                v += amplitude * tileableNoise(x, y, period);
+                x *= 2.0f; y *= 2.0f; period *= 2; amplitude *= 0.5f;
+            }
+            texels[j * NOISE_TEXTURE_SIZE + i] = static_cast<unsigned char>(std::min(255.0f, v * 255.0f + 0.5f));
+        }
     }
+    return texels;
+}
 
+// Takes the texels from a bake or straight from the asset cache's mapping
+void setupNoiseTexture(const unsigned char* texels) {
+    glGenTextures(1, &noiseTexture);
+    glBindTexture(GL_TEXTURE_2D, noiseTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, NOISE_TEXTURE_SIZE, NOISE_TEXTURE_SIZE, 0, GL_RED, GL_UNSIGNED_BYTE, texels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
 
+// ============================ PRIMITIVE RESTART BATCHING SETUP ============================
+// Buffer texture views for the restart shader (the atlas view also feeds the thick outlines) and
+// its attribute-less VAO. Turns the restart path off for good if the atlas ever outgrows the vertex
+// bits of an index.
+void setupRestartBatching() {
+    if (useDirectStateAccess) {
+        glCreateTextures(GL_TEXTURE_BUFFER, 1, &atlasTexture);
+        glTextureBuffer(atlasTexture, GL_RG32F, meshVBO);
+    }
+    else {
+        glGenTextures(1, &atlasTexture);
+        glBindTexture(GL_TEXTURE_BUFFER, atlasTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32F, meshVBO);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    }
 
-    // --- 2. Shader Compilation ---
-
-    // A. Game Object Shader
-    unsigned int vShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vShader, 1, &vertexShaderSource, NULL);
-    glCompileShader(vShader);
-    unsigned int fShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fShader, 1, &fragmentShaderSource, NULL);
-    glCompileShader(fShader);
-    shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vShader);
-    glAttachShader(shaderProgram, fShader);
-    glLinkProgram(shaderProgram);
-    glDeleteShader(vShader);
-    glDeleteShader(fShader);
+    GLint atlasVertexCount = static_cast<GLint>(glBufferBytes(meshVBO) / (2 * sizeof(float)));
+    if (atlasVertexCount > (1 << RESTART_VERTEX_BITS)) {
+        LOG_WARN("Mesh atlas has %d vertices, more than a restart index can address; restart batching disabled", atlasVertexCount);
+        glDeleteProgram(restartProgram);
+        restartProgram = 0;
+        return;
+    }
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTextureBufferTexels);
+    if (useDirectStateAccess) {
+        glCreateVertexArrays(1, &restartVAO);
+        glCreateTextures(GL_TEXTURE_BUFFER, 1, &instanceTexture);
+    }
+    else {
+        glGenVertexArrays(1, &restartVAO);
+        glGenTextures(1, &instanceTexture);
+    }
+}
 
-    // B. Background Shader (Modified)
-    unsigned int bgVS = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(bgVS, 1, &bgVertexShader, NULL);
-    glCompileShader(bgVS);
-    unsigned int bgFS = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(bgFS, 1, &bgFragmentShader, NULL);
-    glCompileShader(bgFS);
-    backgroundProgram = glCreateProgram();
-    glAttachShader(backgroundProgram, bgVS);
-    glAttachShader(backgroundProgram, bgFS);
-    glLinkProgram(backgroundProgram);
-    glDeleteShader(bgVS);
-    glDeleteShader(bgFS);
+// ============================ ASTEROID SDF TEXTURE ============================
+// Signed distance from each texel center to the finest outline of each atlas shape, in shape units
+// (negative inside), found by brute force over the outline's edges. The outlines are star-shaped
+// around the center, so a crossing count decides inside. Baked on a worker by loadAsteroidSdf (no GL);
+// setupAsteroidSdf uploads the result, or the asset cache's copy of it.
+std::vector<float> bakeAsteroidSdf(const std::vector<float>& atlasVertices) {
+    const int finest = ASTEROID_LOD_COUNT - 1;
+    std::vector<float> distances(static_cast<size_t>(ASTEROID_SDF_SIZE) * ASTEROID_SDF_SIZE * ASTEROID_SHAPE_COUNT);
+    size_t texel = 0;
+    for (int k = 0; k < ASTEROID_SHAPE_COUNT; ++k) {
+        const AsteroidMesh& mesh = asteroidShapes[k].lods[finest];
+        const float* outline = &atlasVertices[static_cast<size_t>(mesh.baseVertex + 1) * 2];
+        const int edges = mesh.vertexCount - 2; // Boundary is closed on its first point
+        for (int j = 0; j < ASTEROID_SDF_SIZE; ++j) {
+            for (int i = 0; i < ASTEROID_SDF_SIZE; ++i) {
+                const glm::vec2 p = (glm::vec2(i + 0.5f, j + 0.5f) / static_cast<float>(ASTEROID_SDF_SIZE) * 2.0f - 1.0f) * ASTEROID_SDF_EXTENT;
+                float nearest = std::numeric_limits<float>::max();
+                bool inside = false;
+                for (int e = 0; e < edges; ++e) {
+                    const glm::vec2 a(outline[2 * e], outline[2 * e + 1]);
+                    const glm::vec2 b(outline[2 * e + 2], outline[2 * e + 3]);
+                    const glm::vec2 ab = b - a;
+                    const float t = glm::clamp(glm::dot(p - a, ab) / glm::dot(ab, ab), 0.0f, 1.0f);
+                    nearest = std::min(nearest, glm::length(p - (a + ab * t)));
+                    if ((a.y > p.y) != (b.y > p.y) && p.x < a.x + (p.y - a.y) / (b.y - a.y) * ab.x) inside = !inside;
+                }
+                distances[texel++] = inside ? -nearest : nearest;
+            }
+        }
+    }
+    return distances;
+}
 
-    // --- 3. Graphics Setup (VAOs/VBOs) ---
+void setupAsteroidSdf(const float* distances) {
+    glGenTextures(1, &asteroidSdfTexture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, asteroidSdfTexture);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_R16F, ASTEROID_SDF_SIZE, ASTEROID_SDF_SIZE, ASTEROID_SHAPE_COUNT, 0, GL_RED, GL_FLOAT, distances);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
 
-    // A. Setup Background Quad
-    float quad[] = { -1,-1, 1,-1, -1,1, 1,1 };
-    glGenVertexArrays(1, &gradientVAO);
-    glGenBuffers(1, &gradientVBO);
-    glBindVertexArray(gradientVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, gradientVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glBindVertexArray(0);
+// ============================ STATIC TEXTURE UNITS ============================
+// Every texture a pass samples, except the low-res nebula target on unit 0, has a unit of its own for
+// the whole run. They are bound once after setup, like a descriptor set recorded up front, and the
+// frame only re-attaches the instance view when the stream buffer is re-created.
+void bindStaticTextureUnits() {
+    const struct { GLenum unit; GLenum target; unsigned int texture; } bindings[] = {
+        { GL_TEXTURE1, GL_TEXTURE_2D, noiseTexture }, // Background: baked nebula noise
+        { GL_TEXTURE2, GL_TEXTURE_2D_ARRAY, asteroidSdfTexture }, // SDF asteroids
+        { GL_TEXTURE3, GL_TEXTURE_BUFFER, atlasTexture }, // Restart batching and thick outlines
+        { GL_TEXTURE4, GL_TEXTURE_BUFFER, instanceTexture }, // Restart batching
+        { GL_TEXTURE0 + POLAR_SHAPE_UNIT, GL_TEXTURE_BUFFER, polarShapeTexture }, // Polar silhouettes (unit 5 is the trails' ring)
+    };
+    for (const auto& binding : bindings) {
+        glActiveTexture(binding.unit);
+        glBindTexture(binding.target, binding.texture);
+    }
+    glActiveTexture(GL_TEXTURE0);
+}
 
-    // B. Ship FILL Setup (GL_TRIANGLE_FAN)
-    float shipFillVertices[] = {
-        0.0f, 0.0f,
-        0.0f, 1.0f,
-        -1.0f, -1.0f,
-         1.0f, -1.0f,
-        0.0f, 1.0f
+// ============================ ASSET LOADS ============================
+// The noise and the SDF are not needed for the first frame (the nebula is analytic and the rocks are
+// fans until they are in), so they load after the window shows (assetloader.h): found in the asset
+// cache's mapping or baked on a worker, uploaded within a frame's budget, put on their static units,
+// and stored for the next launch if they were baked.
+AssetLoad loadNoiseTexture(uint64_t key) {
+    co_await onAssetWorker();
+    const size_t expected = static_cast<size_t>(NOISE_TEXTURE_SIZE) * NOISE_TEXTURE_SIZE;
+    size_t bytes = 0;
+    const unsigned char* texels = static_cast<const unsigned char*>(findAsset(ASSET_NOISE, key, bytes));
+    std::vector<unsigned char> baked;
+    if (!texels || bytes != expected) {
+        baked = bakeNoiseTexels();
+        texels = baked.data();
+    }
+    co_await assetUpload(expected);
+    setupNoiseTexture(texels);
+    bindStaticTextureUnits();
+    if (!baked.empty()) storeAsset(ASSET_NOISE, key, baked.data(), baked.size());
+    LOG_INFO("Nebula noise texture loaded (%s)", baked.empty() ? "asset cache" : "baked");
+}
+
+// The atlas is a copy: setupMeshAtlas appends the ship's meshes to the original
+AssetLoad loadAsteroidSdf(uint64_t key, std::vector<float> atlasVertices) {
+    co_await onAssetWorker();
+    const size_t expected = static_cast<size_t>(ASTEROID_SDF_SIZE) * ASTEROID_SDF_SIZE * ASTEROID_SHAPE_COUNT * sizeof(float);
+    size_t bytes = 0;
+    const float* distances = static_cast<const float*>(findAsset(ASSET_SHAPE_SDF, key, bytes));
+    std::vector<float> baked;
+    if (!distances || bytes != expected) {
+        baked = bakeAsteroidSdf(atlasVertices);
+        distances = baked.data();
+    }
+    co_await assetUpload(expected);
+    setupAsteroidSdf(distances);
+    bindStaticTextureUnits();
+    if (!baked.empty()) storeAsset(ASSET_SHAPE_SDF, key, baked.data(), expected);
+    LOG_INFO("Asteroid SDF loaded (%s)", baked.empty() ? "asset cache" : "baked");
+}
+
+// Draws `count` SDF asteroid quads whose instances start `base` bytes into the stream buffer, with
+// blending for the anti-aliased edge; leaves the instanced program bound
+void drawSdfAsteroids(size_t base, size_t count) {
+    if (count == 0) return;
+    glState.useProgram(sdfProgram);
+    glState.setEnabled(GL_BLEND, true);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    bindInstanceAttributes(base);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, sdfQuadMesh.first, sdfQuadMesh.count, static_cast<GLsizei>(count));
+    ++drawCallCount;
+    glState.setEnabled(GL_BLEND, false);
+    glState.useProgram(instancedProgram);
+}
+
+// ============================ INPUT & CALLBACK DEFINITIONS ============================
+
+// No GL here: with --render-thread the context is current on the render thread, so the frame sets
+// the viewport (see resizeRasterTargets)
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    if (width <= 0 || height <= 0) return; // Minimized: nothing is visible, keep the last size
+    framebufferResized = framebufferResized || width != framebufferWidth || height != framebufferHeight;
+    framebufferWidth = width;
+    framebufferHeight = height;
+    frameConstants.viewportSize = glm::vec2(width, height);
+    frameConstants.aspect = static_cast<float>(width) / height;
+}
+
+static void updateSimulationPause()
+{
+    setSimulationPaused(!scenarioActive && (windowIconified || !windowFocused));
+}
+
+void window_iconify_callback(GLFWwindow* window, int iconified)
+{
+    windowIconified = iconified == GLFW_TRUE;
+    updateSimulationPause();
+}
+
+void window_focus_callback(GLFWwindow* window, int focused)
+{
+    windowFocused = focused == GLFW_TRUE;
+    updateSimulationPause();
+}
+
+// ============================ IDLE THROTTLING ============================
+// Seconds between frames while idle; 0 while the game is being played
+double idleFrameInterval()
+{
+    if (scenarioActive) return 0.0;
+    if (windowIconified) return MINIMIZED_POLL_SECONDS;
+    if (!windowFocused || gameOverShown) return 1.0 / IDLE_REFRESH_HZ;
+    return 0.0;
+}
+
+// Handles events until the next idle frame is due or the game wakes up (focus comes back, say).
+// Returns false if there is nothing to draw (still minimized).
+bool waitForIdleFrame(GLFWwindow* window)
+{
+    for (;;) {
+        const double interval = idleFrameInterval();
+        if (interval <= 0.0) break;
+        const double remaining = lastIdleFrame + interval - sessionSeconds();
+        if (remaining <= 0.0 || glfwWindowShouldClose(window)) break;
+        glfwWaitEventsTimeout(remaining);
+    }
+    lastIdleFrame = sessionSeconds();
+    return !windowIconified;
+}
+
+// ============================ RASTER TARGET SIZING ============================
+// One stream segment at the current framebuffer size: the exact ship outline and shield worst cases
+// plus room for bullets and asteroid instances
+size_t streamBytesPerFrame()
+{
+    return (maxBresenhamPoints() + maxShieldPoints()) * sizeof(PixelPoint)
+        + 4096 * 2 * sizeof(float) + 1024 * sizeof(ObjectInstance);
+}
+
+// Called once per frame after a resize, before the stream buffer's beginFrame: sets the viewport (and the split-screen ones),
+// grows the shield octant and the stream segments for the new worst case and hands the size to the GPU backend (the CPU rasterizers read framebufferWidth/Height
+// every frame)
+void resizeRasterTargets()
+{
+    glViewport(0, 0, framebufferWidth, framebufferHeight);
+    renderQueue.setViewports(splitScreenViewports, framebufferWidth, framebufferHeight);
+    shieldRows.reserve(static_cast<size_t>(shieldPixelRadius()) + 1);
+    streamBuffer.reserve(streamBytesPerFrame());
+    setGpuRasterScreenSize(framebufferWidth, framebufferHeight);
+    setShieldRingScreenSize(framebufferWidth, framebufferHeight);
+    if (useShipAtlas) buildShipAtlas();
+    framebufferResized = false;
+}
+
+// ============================ LOW-RES NEBULA TARGET ============================
+// Fraction of the window the nebula is computed at (1 = full resolution, drawn directly)
+float nebulaResolution()
+{
+    if (useDynamicResolution) return static_cast<float>(dynamicResolutionStep) / DYNAMIC_RESOLUTION_STEPS;
+    return 1.0f / backgroundScale;
+}
+
+// (Re)allocates nebulaTexture for the current window size and nebulaResolution()
+void ensureNebulaTarget()
+{
+    int width = std::max(1, static_cast<int>(framebufferWidth * nebulaResolution()));
+    int height = std::max(1, static_cast<int>(framebufferHeight * nebulaResolution()));
+    if (nebulaFBO != 0 && width == nebulaWidth && height == nebulaHeight) return;
+
+    if (nebulaFBO == 0) {
+        glGenFramebuffers(1, &nebulaFBO);
+        glGenTextures(1, &nebulaTexture);
+    }
+    glBindTexture(GL_TEXTURE_2D, nebulaTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR); // Bilinear upscale
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, nebulaFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, nebulaTexture, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        LOG_WARN("Nebula framebuffer incomplete, falling back to full resolution");
+        backgroundScale = 1;
+        useDynamicResolution = false;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    nebulaWidth = width;
+    nebulaHeight = height;
+    nebulaFrame = -1; // New texture has no contents yet
+}
+
+// ============================ VARIABLE-RATE SHADING ============================
+// GL_NV_shading_rate_image: not in the loader, so its tokens and entry points are declared here
+const GLenum GL_SHADING_RATE_IMAGE_NV = 0x9563;
+const GLenum GL_SHADING_RATE_1_INVOCATION_PER_PIXEL_NV = 0x9565;
+const GLenum GL_SHADING_RATE_1_INVOCATION_PER_2X2_PIXELS_NV = 0x9568;
+const GLenum GL_SHADING_RATE_1_INVOCATION_PER_4X4_PIXELS_NV = 0x956B;
+const GLenum GL_SHADING_RATE_IMAGE_TEXEL_WIDTH_NV = 0x955C;
+const GLenum GL_SHADING_RATE_IMAGE_TEXEL_HEIGHT_NV = 0x955D;
+typedef void (APIENTRYP PFNGLBINDSHADINGRATEIMAGENVPROC)(GLuint texture);
+typedef void (APIENTRYP PFNGLSHADINGRATEIMAGEPALETTENVPROC)(GLuint viewport, GLuint first, GLsizei count, const GLenum* rates);
+PFNGLBINDSHADINGRATEIMAGENVPROC glBindShadingRateImageNV = nullptr;
+PFNGLSHADINGRATEIMAGEPALETTENVPROC glShadingRateImagePaletteNV = nullptr;
+
+// After GLAD has loaded: looks up the extension and its entry points
+void initShadingRate()
+{
+    if (!hasGlExtension("GL_NV_shading_rate_image") || !glTexStorage2D) return;
+    glBindShadingRateImageNV = reinterpret_cast<PFNGLBINDSHADINGRATEIMAGENVPROC>(glfwGetProcAddress("glBindShadingRateImageNV"));
+    glShadingRateImagePaletteNV = reinterpret_cast<PFNGLSHADINGRATEIMAGEPALETTENVPROC>(glfwGetProcAddress("glShadingRateImagePaletteNV"));
+    if (!glBindShadingRateImageNV || !glShadingRateImagePaletteNV) return;
+    glGetIntegerv(GL_SHADING_RATE_IMAGE_TEXEL_WIDTH_NV, &shadingRateTexelWidth);
+    glGetIntegerv(GL_SHADING_RATE_IMAGE_TEXEL_HEIGHT_NV, &shadingRateTexelHeight);
+    shadingRateTexelWidth = std::max(shadingRateTexelWidth, 1);
+    shadingRateTexelHeight = std::max(shadingRateTexelHeight, 1);
+    shadingRateSupported = true;
+}
+
+// The nebula is drawn with a coarse shading rate this frame
+bool nebulaShadingCoarse()
+{
+    return nebulaShadingRate > 1 && shadingRateSupported && nebulaResolution() >= 1.0f && useStarSprites && splitScreenViewports == 1;
+}
+
+// (Re)builds shadingRateImage for the window size and nebulaShadingRate: palette entry 0 (per pixel)
+// on tiles reaching within SHADING_RATE_SUN_RADIUS of the sun, the coarse entry everywhere else
+void ensureShadingRateImage()
+{
+    if (shadingRateImage != 0 && shadingRateWidth == framebufferWidth && shadingRateHeight == framebufferHeight
+        && shadingRateImageRate == nebulaShadingRate) return;
+    AllowAllocations rebuild; // On a resize or a rate change only
+    const int columns = (framebufferWidth + shadingRateTexelWidth - 1) / shadingRateTexelWidth;
+    const int rows = (framebufferHeight + shadingRateTexelHeight - 1) / shadingRateTexelHeight;
+    const float aspect = static_cast<float>(framebufferWidth) / framebufferHeight;
+    const uint8_t coarse = nebulaShadingRate >= 4 ? 2 : 1;
+    std::vector<uint8_t> rates(static_cast<size_t>(columns) * rows);
+    for (int row = 0; row < rows; ++row) {
+        for (int column = 0; column < columns; ++column) {
+            // The tile's nearest point to the sun, in the background shader's p space
+            const float x0 = (2.0f * column * shadingRateTexelWidth / framebufferWidth - 1.0f) * 1.2f * aspect;
+            const float x1 = (2.0f * (column + 1) * shadingRateTexelWidth / framebufferWidth - 1.0f) * 1.2f * aspect;
+            const float y0 = 2.0f * row * shadingRateTexelHeight / framebufferHeight - 1.0f;
+            const float y1 = 2.0f * (row + 1) * shadingRateTexelHeight / framebufferHeight - 1.0f;
+            const float x = std::clamp(0.0f, x0, x1), y = std::clamp(0.0f, y0, y1);
+            rates[static_cast<size_t>(row) * columns + column] = x * x + y * y < SHADING_RATE_SUN_RADIUS * SHADING_RATE_SUN_RADIUS ? 0 : coarse;
+        }
+    }
+    if (shadingRateImage != 0) glDeleteTextures(1, &shadingRateImage); // Immutable storage: a new size is a new texture
+    glGenTextures(1, &shadingRateImage);
+    glBindTexture(GL_TEXTURE_2D, shadingRateImage);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_R8UI, columns, rows);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, columns, rows, GL_RED_INTEGER, GL_UNSIGNED_BYTE, rates.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    const GLenum palette[3] = { GL_SHADING_RATE_1_INVOCATION_PER_PIXEL_NV, GL_SHADING_RATE_1_INVOCATION_PER_2X2_PIXELS_NV,
+                                GL_SHADING_RATE_1_INVOCATION_PER_4X4_PIXELS_NV };
+    glShadingRateImagePaletteNV(0, 0, 3, palette);
+    shadingRateWidth = framebufferWidth;
+    shadingRateHeight = framebufferHeight;
+    shadingRateImageRate = nebulaShadingRate;
+}
+
+// ============================ BLOOM ============================
+// Render graph passes, declared by addBloomPasses
+
+// The batched pass's glowing parts again: asteroid outlines, the ship's outline and the bullets, from
+// the instances it already streamed (nothing if they did not fit in the stream buffer)
+static void drawBloomEmissive(const RenderPass&)
+{
+    if (!bloomSource.valid) return;
+    glState.useProgram(instancedProgram);
+    glState.bindVertexArray(meshVAO);
+    setInstanceAttributesEnabled(true);
+    bindInstanceAttributes(bloomSource.instanceOffset);
+    if (objectBatch.thickOutlines) submitThickOutlines(objectBatch.thickCommands, bloomSource.instanceOffset); // Widths stay in window pixels
+    else submitDraws(GL_LINE_LOOP, loopDraws, objectBatch.loopCommands, bloomSource.instanceOffset);
+    glState.setPointSize(std::max(1.0f, 5.0f / bloomScale));
+    submitDraws(GL_POINTS, pointDraws, objectBatch.pointCommands, bloomSource.instanceOffset);
+    if (bloomSource.shipInstance != NO_SHIP_INSTANCE) {
+        bindInstanceAttributes(bloomSource.instanceOffset + bloomSource.shipInstance * instanceRecordSize(compactInstanceRecords));
+        glDrawArraysInstanced(GL_LINE_LOOP, shipFillMesh.first + 1, shipFillMesh.count - 2, 1); // Skips the center and the closing point
+        ++drawCallCount;
+    }
+    setInstanceAttributesEnabled(false);
+    if (useResidentBullets) drawCallCount += drawResidentBullets(bloomSource.bulletTime, PAINT_BULLET, std::max(1.0f, 5.0f / bloomScale));
+}
+
+// The pass's input through the bloom shader, its taps `step` texels apart (0: one plain fetch)
+static void drawBloomQuad(const RenderPass& pass, glm::vec2 step)
+{
+    glState.useProgram(bloomProgram);
+    glState.bindVertexArray(gradientVAO);
+    glBindTexture(GL_TEXTURE_2D, pass.inputTextures[0]);
+    glUniform2f(bloomDirectionLoc, step.x, step.y);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    ++drawCallCount;
+}
+
+// Added onto the frame, upscaled bilinearly; leaves the game object shader bound
+static void drawBloomComposite(const RenderPass& pass)
+{
+    glState.setEnabled(GL_BLEND, true);
+    glBlendFunc(GL_ONE, GL_ONE);
+    drawBloomQuad(pass, glm::vec2(0.0f));
+    glState.setEnabled(GL_BLEND, false);
+    glState.useProgram(shaderProgram);
+}
+
+// Declares the glow's chain. The composite goes in only when the frame can show it (the batched pass,
+// in a single view); without it the graph culls the rest.
+void addBloomPasses(bool composite)
+{
+    const RenderTargetDesc desc = { std::max(1, framebufferWidth / bloomScale), std::max(1, framebufferHeight / bloomScale), RENDER_TARGET_RGB8 };
+    const RenderTarget glow = renderGraph.createTarget("bloom glow", desc);
+    const RenderTarget blurredX = renderGraph.createTarget("bloom blurred x", desc);
+    const RenderTarget blurred = renderGraph.createTarget("bloom blurred", desc);
+    renderGraph.addPass("bloom emissive", PHASE_BLOOM, {}, glow, RENDER_LOAD_CLEAR, drawBloomEmissive);
+    renderGraph.addPass("bloom blur x", PHASE_BLOOM, { glow }, blurredX, RENDER_LOAD_DONT_CARE,
+                        [](const RenderPass& pass) { drawBloomQuad(pass, glm::vec2(1.0f / pass.width, 0.0f)); });
+    renderGraph.addPass("bloom blur y", PHASE_BLOOM, { blurredX }, blurred, RENDER_LOAD_DONT_CARE,
+                        [](const RenderPass& pass) { drawBloomQuad(pass, glm::vec2(0.0f, 1.0f / pass.height)); });
+    if (composite) renderGraph.addPass("bloom composite", PHASE_BLOOM, { blurred }, RENDER_GRAPH_BACKBUFFER, RENDER_LOAD_KEEP, drawBloomComposite);
+}
+
+// ============================ BACKGROUND DRAW ============================
+// Added on top of the background quad, as the shader's hash stars were
+void drawStarSprites()
+{
+    const float density = 1.0f - qualityPresets[qualityLevel].starThreshold;
+    const int count = std::min(STAR_SPRITE_COUNT, static_cast<int>(density * framebufferWidth * framebufferHeight));
+    if (count <= 0) return;
+    glState.useProgram(starProgram);
+    glState.bindVertexArray(starVAO);
+    glState.setEnabled(GL_PROGRAM_POINT_SIZE, true);
+    glState.setEnabled(GL_BLEND, true);
+    glBlendFunc(GL_ONE, GL_ONE);
+    glDrawArrays(GL_POINTS, 0, count);
+    ++drawCallCount;
+    glState.setEnabled(GL_BLEND, false);
+    glState.setEnabled(GL_PROGRAM_POINT_SIZE, false);
+}
+
+static void bindBackgroundProgram(const BackgroundVariant& background)
+{
+    glState.useProgram(background.program);
+    glUniform1i(background.sourceLoc, useBakedNebula && noiseTexture ? 1 : 0); // Analytic until the noise is loaded
+    glUniform1i(background.hashStarsLoc, useStarSprites ? 0 : 1);
+    glState.bindVertexArray(gradientVAO);
+}
+
+// The low-res nebula is out of date (after ensureNebulaTarget)
+bool nebulaDue()
+{
+    return nebulaResolution() < 1.0f && (nebulaFrame < 0 || frameIndex - nebulaFrame >= backgroundUpdateInterval);
+}
+
+// Draws the low-res nebula into the bound target (nebulaFBO)
+void drawNebula()
+{
+    const BackgroundVariant& background = backgroundVariants[qualityLevel];
+    bindBackgroundProgram(background);
+    glUniform1i(background.passLoc, 1);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    ++drawCallCount;
+    nebulaFrame = frameIndex;
+}
+
+// Redraws the low-res nebula when it is due, outside the render graph (the background benchmarks)
+void refreshBackground()
+{
+    if (nebulaResolution() < 1.0f) ensureNebulaTarget(); // May drop back to 1 if the FBO is unsupported
+    if (!nebulaDue()) return;
+    glBindFramebuffer(GL_FRAMEBUFFER, nebulaFBO);
+    glViewport(0, 0, nebulaWidth, nebulaHeight);
+    drawNebula();
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, framebufferWidth, framebufferHeight);
+}
+
+void drawBackground()
+{
+    const BackgroundVariant& background = backgroundVariants[qualityLevel];
+    bindBackgroundProgram(background);
+    if (nebulaResolution() < 1.0f) {
+        // Upscale the low-res nebula (the nebula pass keeps it current) and add full-res stars
+        glBindTexture(GL_TEXTURE_2D, nebulaTexture);
+        glUniform1i(background.passLoc, 2);
+    }
+    else {
+        glUniform1i(background.passLoc, 0);
+    }
+    const bool coarse = nebulaShadingCoarse();
+    if (coarse) {
+        ensureShadingRateImage();
+        glBindShadingRateImageNV(shadingRateImage);
+        glEnable(GL_SHADING_RATE_IMAGE_NV);
+    }
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    ++drawCallCount;
+    if (coarse) glDisable(GL_SHADING_RATE_IMAGE_NV); // Everything after it, the star sprites first, per pixel
+    if (useStarSprites) drawStarSprites();
+}
+
+// Declares the background: the low-res nebula when it is due (an imported target, as it lives across
+// frames), then the window cleared and drawn over in every viewport, upscaling it
+void addBackgroundPasses()
+{
+    if (nebulaResolution() < 1.0f) ensureNebulaTarget(); // May drop back to 1 if the FBO is unsupported
+    if (nebulaResolution() >= 1.0f) {
+        renderGraph.addPass("background", PHASE_BACKGROUND_DRAW, {}, RENDER_GRAPH_BACKBUFFER, RENDER_LOAD_CLEAR,
+                            [](const RenderPass&) { renderQueue.forEachViewport(drawBackground); });
+        return;
+    }
+    const RenderTarget nebula = renderGraph.importTarget("nebula", nebulaFBO, nebulaTexture, nebulaWidth, nebulaHeight);
+    if (nebulaDue()) renderGraph.addPass("nebula", PHASE_BACKGROUND_DRAW, {}, nebula, RENDER_LOAD_DONT_CARE, [](const RenderPass&) { drawNebula(); });
+    renderGraph.addPass("background", PHASE_BACKGROUND_DRAW, { nebula }, RENDER_GRAPH_BACKBUFFER, RENDER_LOAD_CLEAR,
+                        [](const RenderPass&) { renderQueue.forEachViewport(drawBackground); });
+}
+
+// ============================ BACKGROUND BENCHMARK ============================
+// --bench-background: draws only the background for a fixed number of frames in every mode and
+// reports GPU time (timer query) and CPU submit time per frame, then exits.
+int runBackgroundBenchmark(GLFWwindow* window)
+{
+    struct BenchMode { const char* name; bool baked; int scale; int shadingRate; };
+    const BenchMode modes[] = {
+        { "analytic fbm, full res", false, 1, 1 },
+        { "analytic fbm, 1/2 res", false, 2, 1 },
+        { "analytic fbm, 1/4 res", false, 4, 1 },
+        { "analytic fbm, full res, 2x2 shading", false, 1, 2 },
+        { "analytic fbm, full res, 4x4 shading", false, 1, 4 },
+        { "baked noise, full res", true, 1, 1 },
+        { "baked noise, 1/2 res", true, 2, 1 },
     };
-    glGenVertexArrays(1, &shipFillVAO);
-    glGenBuffers(1, &shipFillVBO);
-    glBindVertexArray(shipFillVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, shipFillVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(shipFillVertices), shipFillVertices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glBindVertexArray(0);
+    const int WARMUP_FRAMES = 30;
+    const int BENCH_FRAMES = 300;
+
+    unsigned int query;
+    glGenQueries(1, &query);
+    LOG_INFO("Background benchmark (%dx%d, %d frames per mode, refresh every frame)", framebufferWidth, framebufferHeight, BENCH_FRAMES);
+    useDynamicResolution = false;
+    useStarSprites = true; // The coarse modes need the stars off the nebula pass
+    for (const BenchMode& mode : modes) {
+        if (mode.shadingRate > 1 && !shadingRateSupported) {
+            LOG_INFO("  %s: skipped (no GL_NV_shading_rate_image)", mode.name);
+            continue;
+        }
+        useBakedNebula = mode.baked;
+        backgroundScale = mode.scale;
+        nebulaShadingRate = mode.shadingRate;
+        backgroundUpdateInterval = 1;
+
+        double gpuTotal = 0.0, cpuTotal = 0.0;
+        for (int frame = 0; frame < WARMUP_FRAMES + BENCH_FRAMES; ++frame) {
+            float t = frame / 60.0f;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            frameConstants.time = t;
+            updateFrameConstants();
+            glBeginQuery(GL_TIME_ELAPSED, query);
+            refreshBackground();
+            drawBackground();
+            glEndQuery(GL_TIME_ELAPSED);
+            double cpu = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            GLuint64 nanoseconds = 0;
+            glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds); // Waits; fine for a benchmark
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+            ++frameIndex;
+            if (frame >= WARMUP_FRAMES) {
+                gpuTotal += nanoseconds / 1.0e6;
+                cpuTotal += cpu;
+            }
+        }
+        LOG_INFO("  %s: gpu %g ms, cpu %g ms", mode.name, gpuTotal / BENCH_FRAMES, cpuTotal / BENCH_FRAMES);
+    }
+    glDeleteQueries(1, &query);
+    return 0;
+}
 
-    // C. Ship OUTLINE Setup (Bresenham - Dynamic Buffer)
-    const size_t MAX_BRESENHAM_VERTICES = 3 * (SCR_WIDTH + SCR_HEIGHT) * 2 * sizeof(float);
-    glGenVertexArrays(1, &bresenhamShipVAO);
-    glGenBuffers(1, &bresenhamShipVBO);
-    glBindVertexArray(bresenhamShipVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, bresenhamShipVBO);
-    glBufferData(GL_ARRAY_BUFFER, MAX_BRESENHAM_VERTICES, NULL, GL_DYNAMIC_DRAW);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glBindVertexArray(0);
+// ============================ QUALITY PRESETS ============================
+// Switches the background variant and nebula resolution (the LOD scale is read every frame). No GL
+// calls, so the main thread can do it while the render thread draws.
+void applyQualityLevel(QualityLevel level)
+{
+    const QualityPreset& preset = qualityPresets[level];
+    qualityLevel = level;
+    backgroundScale = preset.backgroundScale;
+    nebulaFrame = -1; // The low-res nebula was drawn by the previous variant
+    LOG_INFO("Quality: %s (nebula %d octaves at 1/%d, asteroid LOD scale %g)",
+             preset.name, preset.nebulaOctaves, preset.backgroundScale, preset.lodPixelScale);
+}
 
-    // D. Bullet Setup (Point)
-    float bulletVertices[] = { 0.0f, 0.0f };
-    glGenVertexArrays(1, &bulletVAO);
-    glGenBuffers(1, &bulletVBO);
-    glBindVertexArray(bulletVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, bulletVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(bulletVertices), bulletVertices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glBindVertexArray(0);
+// First-run benchmark: times the whole background pass of each preset, finest first, into the back
+// buffer of the still hidden window (the first frame clears it), and returns the finest whose GPU
+// time fits QUALITY_NEBULA_BUDGET_MS. Leaves the background settings as it found them.
+QualityLevel benchmarkQualityLevel()
+{
+    const int WARMUP_DRAWS = 2; // Variants the warm-up did not draw compile on their first draw
+    const int BENCH_DRAWS = 8;
+    const int savedScale = backgroundScale;
+    const int savedInterval = backgroundUpdateInterval;
+    const bool savedBaked = useBakedNebula;
+    const bool savedDynamic = useDynamicResolution;
+    const QualityLevel savedLevel = qualityLevel;
+    const long long savedFrame = frameIndex;
+    glState.invalidate(); // The warm-up bound programs behind the cache's back
+    useBakedNebula = false;
+    useDynamicResolution = false;
+    backgroundUpdateInterval = 1;
+
+    unsigned int query;
+    glGenQueries(1, &query);
+    QualityLevel chosen = QUALITY_LOW;
+    for (int level = QUALITY_ULTRA; level >= QUALITY_LOW; --level) {
+        qualityLevel = static_cast<QualityLevel>(level);
+        backgroundScale = qualityPresets[level].backgroundScale;
+        double gpuTotal = 0.0;
+        for (int draw = 0; draw < WARMUP_DRAWS + BENCH_DRAWS; ++draw) {
+            glBeginQuery(GL_TIME_ELAPSED, query);
+            refreshBackground();
+            drawBackground();
+            glEndQuery(GL_TIME_ELAPSED);
+            GLuint64 nanoseconds = 0;
+            glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+            ++frameIndex;
+            if (draw >= WARMUP_DRAWS) gpuTotal += nanoseconds / 1.0e6;
+        }
+        const double gpuMs = gpuTotal / BENCH_DRAWS;
+        LOG_INFO("  %s: background %.3f ms", qualityPresets[level].name, gpuMs);
+        if (gpuMs <= QUALITY_NEBULA_BUDGET_MS) {
+            chosen = static_cast<QualityLevel>(level);
+            break;
+        }
+    }
+    glDeleteQueries(1, &query);
+
+    backgroundScale = savedScale;
+    backgroundUpdateInterval = savedInterval;
+    useBakedNebula = savedBaked;
+    useDynamicResolution = savedDynamic;
+    qualityLevel = savedLevel;
+    frameIndex = savedFrame;
+    nebulaFrame = -1;
+    return chosen;
+}
 
-    // E. Thrust Fire VAO/VBO (Filled Triangle)
-    float fireVertices[] = {
-        0.0f, 0.0f,
-        -0.5f, -1.0f,
-         0.5f, -1.0f,
-         0.0f, 0.0f
+// Game keys: forwarded to the simulation's input queue with the time GLFW delivered them
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    if (action == GLFW_REPEAT) return;
+    uint8_t bit = 0;
+    switch (key) {
+    case GLFW_KEY_LEFT: bit = INPUT_LEFT; break;
+    case GLFW_KEY_RIGHT: bit = INPUT_RIGHT; break;
+    case GLFW_KEY_UP: bit = INPUT_THRUST; break;
+    case GLFW_KEY_SPACE: bit = INPUT_FIRE; break;
+    case GLFW_KEY_E: bit = INPUT_SHIELD; break;
+    default: return;
+    }
+    pushInputEvent(bit, action == GLFW_PRESS, std::chrono::steady_clock::now());
+}
+
+// Renderer and debug toggles (the game keys come from key_callback)
+void processInput(GLFWwindow* window)
+{
+    // --- OBJECT RENDER MODE TOGGLE (edge-triggered) ---
+    static bool instanceKeyWasDown = false;
+    bool instanceKeyDown = glfwGetKey(window, GLFW_KEY_I) == GLFW_PRESS;
+    if (instanceKeyDown && !instanceKeyWasDown) {
+        useBatchedObjects = !useBatchedObjects;
+        LOG_INFO("Object renderer: %s", useBatchedObjects ? (useIndirectDraw ? "batched (multi-draw indirect)" : "batched") : "legacy");
+    }
+    instanceKeyWasDown = instanceKeyDown;
+
+    // --- RASTER BACKEND TOGGLE (edge-triggered) ---
+    static bool rasterKeyWasDown = false;
+    bool rasterKeyDown = glfwGetKey(window, GLFW_KEY_G) == GLFW_PRESS;
+    if (rasterKeyDown && !rasterKeyWasDown) {
+        useGpuRaster = !useGpuRaster;
+        LOG_INFO("Outline/shield rasterizer: %s", useGpuRaster ? "GPU" : "CPU");
+    }
+    rasterKeyWasDown = rasterKeyDown;
+
+    // --- BACKGROUND RESOLUTION TOGGLE (edge-triggered) ---
+    static bool backgroundKeyWasDown = false;
+    bool backgroundKeyDown = glfwGetKey(window, GLFW_KEY_B) == GLFW_PRESS;
+    if (backgroundKeyDown && !backgroundKeyWasDown) {
+        backgroundScale = backgroundScale >= 4 ? 1 : backgroundScale * 2;
+        useDynamicResolution = false;
+        LOG_INFO("Nebula resolution: 1/%d", backgroundScale);
+    }
+    backgroundKeyWasDown = backgroundKeyDown;
+
+    // --- QUALITY PRESET CYCLE (edge-triggered; not saved, unlike the benchmark's choice) ---
+    static bool qualityKeyWasDown = false;
+    bool qualityKeyDown = glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS;
+    if (qualityKeyDown && !qualityKeyWasDown) {
+        applyQualityLevel(static_cast<QualityLevel>((qualityLevel + 1) % QUALITY_LEVEL_COUNT));
+        useDynamicResolution = false;
+    }
+    qualityKeyWasDown = qualityKeyDown;
+
+    // --- DYNAMIC RESOLUTION TOGGLE (edge-triggered) ---
+    static bool dynamicKeyWasDown = false;
+    bool dynamicKeyDown = glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS;
+    if (dynamicKeyDown && !dynamicKeyWasDown) {
+        useDynamicResolution = !useDynamicResolution;
+        dynamicResolutionFrame = frameIndex;
+        LOG_INFO("Dynamic resolution: %s (budget %.1f ms)", useDynamicResolution ? "on" : "off", frameBudgetMs);
+    }
+    dynamicKeyWasDown = dynamicKeyDown;
+
+    // --- NEBULA SOURCE TOGGLE (edge-triggered) ---
+    static bool nebulaKeyWasDown = false;
+    bool nebulaKeyDown = glfwGetKey(window, GLFW_KEY_N) == GLFW_PRESS;
+    if (nebulaKeyDown && !nebulaKeyWasDown) {
+        useBakedNebula = !useBakedNebula;
+        LOG_INFO("Nebula noise: %s", useBakedNebula ? "baked texture" : "analytic");
+    }
+    nebulaKeyWasDown = nebulaKeyDown;
+
+    // --- STAR RENDERER TOGGLE (edge-triggered) ---
+    static bool starKeyWasDown = false;
+    bool starKeyDown = glfwGetKey(window, GLFW_KEY_O) == GLFW_PRESS;
+    if (starKeyDown && !starKeyWasDown) {
+        useStarSprites = !useStarSprites;
+        LOG_INFO("Stars: %s", useStarSprites ? "point sprites" : "per-pixel hash");
+    }
+    starKeyWasDown = starKeyDown;
+
+    // --- BLOOM CYCLE (edge-triggered) ---
+    static bool bloomKeyWasDown = false;
+    bool bloomKeyDown = glfwGetKey(window, GLFW_KEY_U) == GLFW_PRESS;
+    if (bloomKeyDown && !bloomKeyWasDown) {
+        if (!useBloom) {
+            useBloom = true;
+            bloomScale = 2;
+        }
+        else if (bloomScale == 2) bloomScale = 4;
+        else useBloom = false;
+        if (useBloom) LOG_INFO("Bloom: 1/%d resolution%s", bloomScale, useBatchedObjects ? "" : " (batched objects only)");
+        else LOG_INFO("Bloom: off");
+    }
+    bloomKeyWasDown = bloomKeyDown;
+
+    // --- ASTEROID LOD TOGGLE (edge-triggered) ---
+    static bool lodKeyWasDown = false;
+    bool lodKeyDown = glfwGetKey(window, GLFW_KEY_L) == GLFW_PRESS;
+    if (lodKeyDown && !lodKeyWasDown) {
+        useAsteroidLod = !useAsteroidLod;
+        int lods[3];
+        asteroidLodsForFrame(lods);
+        LOG_INFO("Asteroid LOD: %s (segments large %d, medium %d, small %d)", useAsteroidLod ? "on" : "off",
+                 ASTEROID_LOD_SEGMENTS[lods[LARGE]], ASTEROID_LOD_SEGMENTS[lods[MEDIUM]], ASTEROID_LOD_SEGMENTS[lods[SMALL]]);
+    }
+    lodKeyWasDown = lodKeyDown;
+
+    // --- ASTEROID SILHOUETTES CYCLE (edge-triggered) ---
+    static bool shapeKeyWasDown = false;
+    bool shapeKeyDown = glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS;
+    if (shapeKeyDown && !shapeKeyWasDown) {
+        asteroidSilhouettes = static_cast<AsteroidSilhouettes>((asteroidSilhouettes + 1) % 3);
+        static const char* const names[] = { "atlas", "procedural (vertex shader)", "polar (radius table)" };
+        LOG_INFO("Asteroid silhouettes: %s", names[asteroidSilhouettes]);
+    }
+    shapeKeyWasDown = shapeKeyDown;
+
+    // --- SDF ASTEROIDS TOGGLE (edge-triggered) ---
+    static bool sdfKeyWasDown = false;
+    bool sdfKeyDown = glfwGetKey(window, GLFW_KEY_F) == GLFW_PRESS;
+    if (sdfKeyDown && !sdfKeyWasDown) {
+        useSdfAsteroids = !useSdfAsteroids;
+        LOG_INFO("SDF asteroids: %s", useSdfAsteroids ? "on (one quad per rock)" : "off (fan + line loop)");
+    }
+    sdfKeyWasDown = sdfKeyDown;
+
+    // --- PRIMITIVE RESTART BATCHING TOGGLE (edge-triggered) ---
+    static bool restartKeyWasDown = false;
+    bool restartKeyDown = glfwGetKey(window, GLFW_KEY_K) == GLFW_PRESS;
+    if (restartKeyDown && !restartKeyWasDown) {
+        useRestartBatching = !useRestartBatching && restartProgram;
+        LOG_INFO("Primitive restart batching: %s", useRestartBatching ? "on (one indexed draw for fans, one for outlines)" : "off");
+    }
+    restartKeyWasDown = restartKeyDown;
+
+    // --- THICK OUTLINES TOGGLE (edge-triggered) ---
+    static bool thickKeyWasDown = false;
+    bool thickKeyDown = glfwGetKey(window, GLFW_KEY_T) == GLFW_PRESS;
+    if (thickKeyDown && !thickKeyWasDown) {
+        useThickOutlines = !useThickOutlines;
+        LOG_INFO("Asteroid outlines: %s", useThickOutlines ? "screen-space quads" : "GL_LINE_LOOP + glLineWidth");
+    }
+    thickKeyWasDown = thickKeyDown;
+
+    // --- COMPACT INSTANCES TOGGLE (edge-triggered) ---
+    static bool compactKeyWasDown = false;
+    bool compactKeyDown = glfwGetKey(window, GLFW_KEY_Z) == GLFW_PRESS;
+    if (compactKeyDown && !compactKeyWasDown) {
+        useCompactInstances = !useCompactInstances;
+        LOG_INFO("Instance records: %s", useCompactInstances ? "compact (12 bytes)" : "float (24 bytes)");
+    }
+    compactKeyWasDown = compactKeyDown;
+
+    // --- GPU SWARM TOGGLE (edge-triggered, only once --swarm set it up) ---
+    static bool swarmKeyWasDown = false;
+    bool swarmKeyDown = glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS;
+    if (swarmKeyDown && !swarmKeyWasDown && gpuSwarmCount() > 0) {
+        useGpuSwarm = !useGpuSwarm;
+        LOG_INFO("GPU swarm: %s", useGpuSwarm ? "on" : "off");
+    }
+    swarmKeyWasDown = swarmKeyDown;
+
+    // --- RESIDENT BULLETS TOGGLE (edge-triggered) ---
+    static bool residentKeyWasDown = false;
+    bool residentKeyDown = glfwGetKey(window, GLFW_KEY_X) == GLFW_PRESS;
+    if (residentKeyDown && !residentKeyWasDown) {
+        useResidentBullets = !useResidentBullets && residentBulletsReady() && !spectatorActive();
+        LOG_INFO("Bullets: %s", useResidentBullets ? "GPU-resident (records uploaded when fired or lost)" : "streamed every frame");
+    }
+    residentKeyWasDown = residentKeyDown;
+
+    // --- RESIDENT ROCKS TOGGLE (edge-triggered) ---
+    static bool rockRecordKeyWasDown = false;
+    bool rockRecordKeyDown = glfwGetKey(window, GLFW_KEY_J) == GLFW_PRESS;
+    if (rockRecordKeyDown && !rockRecordKeyWasDown) {
+        useResidentRocks = !useResidentRocks && residentRocksReady() && !spectatorActive();
+        LOG_INFO("Asteroids: %s", useResidentRocks ? "GPU-resident (SDF quads, records uploaded on spawn, loss or bounce)" : "streamed every frame");
+    }
+    rockRecordKeyWasDown = rockRecordKeyDown;
+
+    // --- PARTICLES TOGGLE (edge-triggered) ---
+    static bool particleKeyWasDown = false;
+    bool particleKeyDown = glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS;
+    if (particleKeyDown && !particleKeyWasDown) {
+        useParticles = !useParticles && particlesReady();
+        LOG_INFO("Debris and sparks: %s", useParticles ? "on" : "off");
+    }
+    particleKeyWasDown = particleKeyDown;
+
+    // --- TRAILS TOGGLE (edge-triggered) ---
+    static bool trailKeyWasDown = false;
+    bool trailKeyDown = glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS;
+    if (trailKeyDown && !trailKeyWasDown) {
+        useTrails = !useTrails && trailsReady();
+        LOG_INFO("Motion trails: %s", useTrails ? "on" : "off");
+    }
+    trailKeyWasDown = trailKeyDown;
+
+    // --- PERF OVERLAY TOGGLE (edge-triggered) ---
+    static bool hudKeyWasDown = false;
+    bool hudKeyDown = glfwGetKey(window, GLFW_KEY_H) == GLFW_PRESS;
+    if (hudKeyDown && !hudKeyWasDown) showPerfOverlay = !showPerfOverlay;
+    hudKeyWasDown = hudKeyDown;
+
+    // --- BROADPHASE HEATMAP (edge-triggered: each grid level in turn, then off) ---
+    static bool heatmapKeyWasDown = false;
+    bool heatmapKeyDown = glfwGetKey(window, GLFW_KEY_F3) == GLFW_PRESS;
+    if (heatmapKeyDown && !heatmapKeyWasDown) {
+        const int level = heatmapLevel.load(std::memory_order_relaxed) + 1;
+        heatmapLevel.store(level < ASTEROID_SIZE_COUNT ? level : -1, std::memory_order_relaxed);
+    }
+    heatmapKeyWasDown = heatmapKeyDown;
+
+    // --- PROFILER REPORT (edge-triggered) ---
+    static bool profileKeyWasDown = false;
+    bool profileKeyDown = glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS;
+    if (profileKeyDown && !profileKeyWasDown) profilerReportRequested = true;
+    profileKeyWasDown = profileKeyDown;
+
+    // --- MEMORY REPORT (edge-triggered) ---
+    static bool memoryKeyWasDown = false;
+    bool memoryKeyDown = glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS;
+    if (memoryKeyDown && !memoryKeyWasDown) memoryReportRequested = true;
+    memoryKeyWasDown = memoryKeyDown;
+
+    // --- SCREENSHOT (edge-triggered; read back by the frame, written by the capture thread) ---
+    static bool screenshotKeyWasDown = false;
+    bool screenshotKeyDown = glfwGetKey(window, GLFW_KEY_F12) == GLFW_PRESS;
+    if (screenshotKeyDown && !screenshotKeyWasDown) requestScreenshot();
+    screenshotKeyWasDown = screenshotKeyDown;
+
+    // --- TRACE (edge-triggered: the first press starts recording, the next writes trace-NNNN.json) ---
+    static bool traceKeyWasDown = false;
+    bool traceKeyDown = glfwGetKey(window, GLFW_KEY_F11) == GLFW_PRESS;
+    if (traceKeyDown && !traceKeyWasDown) {
+        if (traceActive()) stopTrace(NULL);
+        else startTrace();
+    }
+    traceKeyWasDown = traceKeyDown;
+
+    // --- FAST-FORWARD TOGGLE (edge-triggered) ---
+    static bool fastForwardKeyWasDown = false;
+    bool fastForwardKeyDown = glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS;
+    if (fastForwardKeyDown && !fastForwardKeyWasDown) setFastForward(!fastForwardActive());
+    fastForwardKeyWasDown = fastForwardKeyDown;
+
+    // --- PLAY AGAIN (edge-triggered; the simulating thread ignores it unless the game is over) ---
+    static bool playAgainKeyWasDown = false;
+    bool playAgainKeyDown = glfwGetKey(window, GLFW_KEY_ENTER) == GLFW_PRESS;
+    if (playAgainKeyDown && !playAgainKeyWasDown) requestRestart();
+    playAgainKeyWasDown = playAgainKeyDown;
+
+    // --- PRESENT MODE CYCLE (edge-triggered) ---
+    static bool presentKeyWasDown = false;
+    bool presentKeyDown = glfwGetKey(window, GLFW_KEY_V) == GLFW_PRESS;
+    if (presentKeyDown && !presentKeyWasDown) {
+        presentMode = static_cast<PresentMode>((presentMode + 1) % PRESENT_MODE_COUNT);
+        presentModeChanged = true;
+    }
+    presentKeyWasDown = presentKeyDown;
+}
+
+// ============================ RENDER INTERPOLATION ============================
+// Blends the previous and current tick. A jump of more than half the field means the entity
+// wrapped this tick, so it is drawn at its current position instead of sliding across the screen.
+float interpolateWrapped(float prev, float cur, float alpha) {
+    if (std::fabs(cur - prev) > 1.0f) return cur;
+    return prev + (cur - prev) * alpha;
+}
+
+// Same for wrapped angles (the ship's rotation, and the rocks' in fixed-point mode)
+float interpolateAngle(float prev, float cur, float alpha) {
+    if (std::fabs(cur - prev) > glm::pi<float>()) return cur;
+    return prev + (cur - prev) * alpha;
+}
+
+// A rock between the last two ticks. Lazy rocks keep no previous tick (or a current rotation):
+// they are read off their anchors at that moment instead.
+glm::vec2 interpolatedAsteroidPosition(const AsteroidStore& rocks, bool lazy, size_t i, float alpha) {
+    if (lazy) return rocks.positionAt(i, rocks.previousClock + (rocks.clock - rocks.previousClock) * alpha);
+    return glm::vec2(interpolateWrapped(rocks.px[i], rocks.x[i], alpha), interpolateWrapped(rocks.py[i], rocks.y[i], alpha));
+}
+
+float interpolatedAsteroidRotation(const AsteroidStore& rocks, bool lazy, size_t i, float alpha) {
+    if (lazy) return rocks.rotationAt(i, rocks.previousClock + (rocks.clock - rocks.previousClock) * alpha);
+    return interpolateAngle(rocks.prot[i], rocks.rot[i], alpha);
+}
+
+// ============================ GPU RASTER VALIDATION ============================
+// Widens a CPU point list to ivec2 pixels (samePixelSet sorts and drops duplicates)
+std::vector<glm::ivec2> pixelSetFromPoints(const std::vector<PixelPoint>& points) {
+    std::vector<glm::ivec2> pixels;
+    for (const PixelPoint& p : points) pixels.push_back(glm::ivec2(p.x, p.y));
+    return pixels;
+}
+
+bool samePixelSet(std::vector<glm::ivec2> a, std::vector<glm::ivec2> b) {
+    auto less = [](const glm::ivec2& p, const glm::ivec2& q) { return p.x < q.x || (p.x == q.x && p.y < q.y); };
+    std::sort(a.begin(), a.end(), less);
+    a.erase(std::unique(a.begin(), a.end()), a.end());
+    std::sort(b.begin(), b.end(), less);
+    b.erase(std::unique(b.begin(), b.end()), b.end());
+    return a == b;
+}
+
+// Compares the GPU rasterizers against the CPU reference, pixel for pixel (--validate-raster)
+int validateGpuRaster() {
+    int failures = 0;
+    std::vector<PixelPoint> reference;
+    Rng rng; // Fixed stream, so a failure reproduces on the next run
+    rng.seed(simulationSeed, RNG_STREAM_VALIDATION);
+
+    // Lines: every octant and the degenerate cases around a fixed point, then random lines
+    const int LINE_TESTS = 4000;
+    for (int test = 0; test < LINE_TESTS; ++test) {
+        int x0, y0, x1, y1;
+        if (test < 17 * 17) {
+            x0 = 400; y0 = 300;
+            x1 = x0 + (test % 17 - 8) * 7;
+            y1 = y0 + (test / 17 - 8) * 5;
+        }
+        else {
+            x0 = rng.below(framebufferWidth); y0 = rng.below(framebufferHeight);
+            x1 = rng.below(framebufferWidth); y1 = rng.below(framebufferHeight);
+        }
+        reference.clear();
+        drawBresenhamLine(x0, y0, x1, y1, reference);
+        if (!samePixelSet(pixelSetFromPoints(reference), captureGpuBresenhamLine(x0, y0, x1, y1))) {
+            if (failures++ < 10) LOG_ERROR("Line mismatch: (%d, %d) -> (%d, %d)", x0, y0, x1, y1);
+        }
+    }
+
+    // Circles: every radius up to 300 px at a random center
+    for (int radius = 0; radius <= 300; ++radius) {
+        int cx = rng.below(framebufferWidth);
+        int cy = rng.below(framebufferHeight);
+        reference.clear();
+        drawMidpointCircle(cx, cy, radius, reference);
+        if (!samePixelSet(pixelSetFromPoints(reference), captureGpuMidpointCircle(cx, cy, radius))) {
+            if (failures++ < 10) LOG_ERROR("Circle mismatch: center (%d, %d), radius %d", cx, cy, radius);
+        }
+    }
+
+    // Shield rings: the quad against the GPU points at the shield's point size, as drawn pixels
+    int rings = 0;
+    if (shieldRingReady()) {
+        for (int radius = 0; radius <= 300; ++radius, ++rings) {
+            int cx = rng.below(framebufferWidth);
+            int cy = rng.below(framebufferHeight);
+            if (!samePixelSet(captureShieldRing(cx, cy, radius, true), captureShieldRing(cx, cy, radius, false))) {
+                if (failures++ < 10) LOG_ERROR("Shield ring mismatch: center (%d, %d), radius %d", cx, cy, radius);
+            }
+        }
+    }
+    LOG_INFO("GPU raster validation: %s (%d lines, 301 circles, %d shield rings, %d mismatches)",
+             failures == 0 ? "all shapes match" : "FAILED", LINE_TESTS, rings, failures);
+    return failures == 0 ? 0 : 1;
+}
+
+// ============================ PROGRAM WARM-UP ============================
+// Many drivers only finish compiling a program (or its variant for the state it is drawn with) at
+// its first draw. One tiny draw per program, into a 1x1 viewport of the still hidden window's back
+// buffer, moves that hitch to startup; the first frame clears the buffer before drawing anything.
+// Returns the milliseconds taken, glFinish included. (The GPU raster and swarm programs are built
+// and used by their own modules and are not warmed up here.)
+double warmUpPrograms()
+{
+    struct WarmUp {
+        unsigned int program;
+        unsigned int vertexArray;
+        GLenum mode;
+        bool instanced; // Per-instance attributes on, as the batched pass draws it
+        bool blend;
     };
-    glGenVertexArrays(1, &fireVAO);
-    glGenBuffers(1, &fireVBO);
-    glBindVertexArray(fireVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, fireVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(fireVertices), fireVertices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+    const WarmUp warmUps[] = {
+        { backgroundVariants[qualityLevel].program, gradientVAO, GL_TRIANGLE_STRIP, false, false },
+        { starProgram, starVAO, GL_POINTS, false, false },
+        { bloomProgram, gradientVAO, GL_TRIANGLE_STRIP, false, false },
+        { shaderProgram, meshVAO, GL_TRIANGLE_FAN, false, false },
+        { pixelPointProgram, streamPixelVAO, GL_POINTS, false, false },
+        { instancedProgram, meshVAO, GL_TRIANGLE_FAN, true, false },
+        { thickLineProgram, meshVAO, GL_TRIANGLES, true, false },
+        { sdfProgram, meshVAO, GL_TRIANGLE_STRIP, true, true },
+        { restartProgram, restartVAO, GL_LINE_LOOP, false, false },
+    };
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    glViewport(0, 0, 1, 1);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    for (const WarmUp& warmUp : warmUps) {
+        if (!warmUp.program || !warmUp.vertexArray) continue;
+        glUseProgram(warmUp.program);
+        glBindVertexArray(warmUp.vertexArray);
+        if (warmUp.blend) glEnable(GL_BLEND);
+        if (warmUp.instanced) {
+            setInstanceAttributesEnabled(true);
+            glDrawArraysInstanced(warmUp.mode, 0, 3, 1);
+            setInstanceAttributesEnabled(false);
+        }
+        else {
+            glDrawArrays(warmUp.mode, 0, 3);
+        }
+        if (warmUp.blend) glDisable(GL_BLEND);
+    }
     glBindVertexArray(0);
+    glUseProgram(0);
+    glFinish();
+    glViewport(0, 0, framebufferWidth, framebufferHeight);
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
 
-    // --- SHIELD SETUP (Dynamic Buffer for Circle Points) ---
-    // The maximum possible vertices in a circle drawn with the midpoint algorithm in the given screen size.
-    const size_t MAX_SHIELD_VERTICES = 8 * (SCR_WIDTH + SCR_HEIGHT) * sizeof(float);
-    glGenVertexArrays(1, &shieldVAO);
-    glGenBuffers(1, &shieldVBO);
-    glBindVertexArray(shieldVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, shieldVBO);
-    glBufferData(GL_ARRAY_BUFFER, MAX_SHIELD_VERTICES, NULL, GL_DYNAMIC_DRAW);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glBindVertexArray(0);
+// ============================ FRAME RECORDING ============================
+// Every GL call of a frame, from the snapshot the main loop handed over in frameInput. Runs on the
+// render thread with --render-thread, otherwise straight from the main loop.
+// ============================ MEMORY REPORT ============================
+// GL sizes are measured where the context is current: buffers are queried, textures are worked out
+// from their formats (RGB8 counted as 4 bytes a texel, as drivers store it)
+void collectRenderMemory(MemoryReport& report)
+{
+    report.add("render", "stream buffer", MEMORY_GPU, glBufferBytes(streamBuffer.vbo));
+    report.add("render", "mesh atlas", MEMORY_GPU, glBufferBytes(meshVBO));
+    report.add("render", "background quad", MEMORY_GPU, glBufferBytes(gradientVBO));
+    report.add("render", "star sprites", MEMORY_GPU, glBufferBytes(starVBO));
+    report.add("render", "ship outline atlas", MEMORY_GPU, glBufferBytes(shipAtlasVBO));
+    report.add("render", "frame constants", MEMORY_GPU, sizeof(FrameConstants));
+    report.add("render", "asteroid sdf", MEMORY_GPU, asteroidSdfTexture ? sizeof(uint16_t) * ASTEROID_SDF_SIZE * ASTEROID_SDF_SIZE * ASTEROID_SHAPE_COUNT : 0);
+    report.add("render", "noise texture", MEMORY_GPU, noiseTexture ? NOISE_TEXTURE_SIZE * NOISE_TEXTURE_SIZE * 4 / 3 : 0); // With its mip chain
+    report.add("render", "nebula target", MEMORY_GPU, static_cast<size_t>(nebulaWidth) * nebulaHeight * 4);
+    report.add("render", "render graph targets", MEMORY_GPU, renderGraph.textureBytes());
+    report.add("render", "frame arena", MEMORY_CPU, frameArena.capacity);
+    report.addVector("render", "shield rows", shieldRows);
+    report.add("render", "exhaust pool", MEMORY_CPU, exhaust.memoryBytes());
+    if (!useSimThread) {
+        report.add("render", "main-thread snapshot", MEMORY_CPU,
+                   mainThreadSnapshot.asteroids.memoryBytes() + mainThreadSnapshot.bullets.memoryBytes());
+    }
+}
 
-    // Get uniform locations once
-    unsigned int transformLoc = glGetUniformLocation(shaderProgram, "transform");
-    unsigned int colorLoc = glGetUniformLocation(shaderProgram, "lineColor");
-    unsigned int timeLoc = glGetUniformLocation(backgroundProgram, "time");
+// Everything, from every subsystem (GL thread; waits up to a tick for the simulation thread)
+MemoryReport collectMemory()
+{
+    MemoryReport report;
+    collectSimulationMemory(report);
+    collectRenderMemory(report);
+    collectGpuRasterMemory(report);
+    collectGpuSwarmMemory(report);
+    collectResidentBulletMemory(report);
+    collectResidentRockMemory(report);
+    collectParticleMemory(report);
+    collectTrailMemory(report);
+    collectAudioMemory(report);
+    collectShapeStreamMemory(report);
+    collectPolarShapeMemory(report);
+    collectHudMemory(report);
+    return report;
+}
 
+// Releases last frame's temporaries, rewinds the frame arena and reserves this frame's
+void beginFrameTemporaries()
+{
+    releaseFrameVector(bulletVertexBuffer);
+    releaseFrameVector(objectInstanceBuffer);
+    releaseFrameVector(asteroidDraws);
+    releaseFrameVector(fanDraws);
+    releaseFrameVector(loopDraws);
+    releaseFrameVector(pointDraws);
+    releaseFrameVector(thickLineDraws);
+    releaseFrameVector(restartIndices);
+    renderQueue.releaseFrameStorage();
+    profilerCount(COUNTER_FRAME_ARENA_KB, static_cast<long long>(frameArena.peak / 1024));
+    frameArena.reset();
+
+    objectInstanceBuffer.reserve(frameReservations.objectInstances);
+    asteroidDraws.reserve(frameReservations.asteroidDraws); // Grows if the ghosts ever need more
+    fanDraws.reserve(frameReservations.fanDraws);
+    loopDraws.reserve(frameReservations.loopDraws);
+    thickLineDraws.reserve(frameReservations.loopDraws);
+    pointDraws.reserve(frameReservations.pointDraws);
+    bulletVertexBuffer.reserve(frameReservations.bulletFloats);
+}
 
-    // --- 4. Render/Game Loop ---
-    while (!glfwWindowShouldClose(window))
-    {
-        float t = (float)glfwGetTime();
-        deltaTime = t - lastFrame;
-        lastFrame = t;
-        bulletCooldown -= deltaTime;
-
-        // --- SHIELD TIMER UPDATE ---
-        if (shieldActive) {
-            shieldTimer -= deltaTime;
-            if (shieldTimer <= 0.0f) {
-                shieldActive = false;
-                shieldCooldownTimer = SHIELD_COOLDOWN;
-                std::cout << "Shield Deactivated. Cooldown started." << std::endl;
-            }
+// Queues a particle burst for each effect in the snapshot that no frame has taken yet (all of them
+// are taken, and dropped, while the particles are off)
+static void emitEffectParticles(const RenderSnapshot& view)
+{
+    static uint64_t effectsTaken = 0;
+    const uint64_t first = view.effectsEnd - view.effects.size();
+    for (uint64_t e = std::max(effectsTaken, first); useParticles && e < view.effectsEnd; ++e) {
+        const EffectEvent& effect = view.effects[static_cast<size_t>(e - first)];
+        if (effect.type == EFFECT_SHOT_FIRED) continue;
+        if (effect.type == EFFECT_SHIP_DESTROYED) {
+            emitParticleBurst(effect.position, effect.velocity, effect.scale, 4.0f, PAINT_SHIP | PAINT_OUTLINE, PAINT_FIRE);
+            continue;
         }
-        if (shieldCooldownTimer > 0.0f) {
-            shieldCooldownTimer -= deltaTime;
-            if (shieldCooldownTimer <= 0.0f) {
-                std::cout << "Shield ready." << std::endl;
+        const float energy = effect.type == EFFECT_ROCK_SPLIT ? 1.5f : 1.0f;
+        emitParticleBurst(effect.position, effect.velocity, effect.scale, energy, effect.paletteIndex | PAINT_OUTLINE, PAINT_FIRE);
+    }
+    effectsTaken = std::max(effectsTaken, view.effectsEnd);
+}
+
+// What the scene and HUD passes draw, for the frame being recorded
+struct SceneFrame {
+    const RenderSnapshot* view;
+    Ship ship; // Interpolated
+    float alpha;
+};
+
+// The scene pass: the swarm, the shields, the ships, rocks and bullets, trails and particles. Its
+// parts are timed on their own (GPU TIMER QUERIES).
+static void drawScene(const RenderPass& pass)
+{
+    const SceneFrame& scene = *static_cast<const SceneFrame*>(pass.context);
+    const RenderSnapshot& view = *scene.view;
+    const Ship& renderShip = scene.ship;
+    const float alpha = scene.alpha;
+
+    // 1b. GPU swarm: compute passes move it, shoot it down and cull it into indirect draws that read
+    // the same buffer (the hits come back through a readback ring, a frame or so late)
+    beginGpuTimer(GPU_PASS_SWARM);
+    if (useGpuSwarm) {
+        ProfileScope scope(PHASE_SWARM);
+        int lods[3];
+        asteroidLodsForFrame(lods);
+        profilerCount(COUNTER_SWARM_HITS, static_cast<long long>(collectGpuSwarmHits().size()));
+        stepGpuSwarm(std::min(deltaTime, MAX_SIM_TICKS_PER_FRAME * SIM_DT));
+        collideGpuSwarm(view.bullets);
+        cullGpuSwarm(lods[SMALL]);
+        renderQueue.forEachViewport([] { drawCallCount += drawGpuSwarm(); });
+    }
+    endGpuTimer();
+
+    // 2. Switch to the Main Game Object Shader
+    glState.useProgram(shaderProgram);
+
+    // --- Draw Shield (Midpoint Circle) ---
+    // (the GPU passes are timed even when they draw nothing, so every query in the set gets a result)
+    beginGpuTimer(GPU_PASS_SHIELD);
+    if (useShieldRing) {
+        ProfileScope scope(PHASE_SHIELD_DRAW);
+        drawShieldQuads(view, renderShip, alpha);
+    }
+    else if (view.shieldActive && !view.isGameOver) {
+        ProfileScope scope(PHASE_SHIELD_DRAW);
+        // Calculate screen pixel coordinates for the center and radius
+        int cx = static_cast<int>((renderShip.position.x + 1.0f) * (framebufferWidth / 2.0f));
+        int cy = static_cast<int>((renderShip.position.y + 1.0f) * (framebufferHeight / 2.0f));
+        int pixelRadius = shieldPixelRadius();
+
+        // Use a color that fades out as the timer runs down
+        const glm::vec3 color = shieldColor(view.shieldTimer);
+
+        if (useGpuRaster) {
+            // Only the center and radius go to the GPU
+            renderQueue.forEachViewport([&] {
+                drawGpuMidpointCircle(cx, cy, pixelRadius, color, 1.5f);
+                ++drawCallCount;
+            });
+            glState.useProgram(shaderProgram);
+        }
+        else {
+            // Walk one octant, then mirror it eight ways straight into the mapped stream segment
+            const size_t steps = walkMidpointCircle(pixelRadius, shieldRows);
+            GLsizei shieldPoints = 0;
+            if (PixelPoint* out = mapStreamPixels(8 * steps)) {
+                shieldPoints = static_cast<GLsizei>(drawMidpointCircle(cx, cy, shieldRows, out));
+                streamBuffer.commit();
             }
+
+            // Render the circle
+            renderQueue.forEachViewport([&] { drawStreamPixels(shieldPoints, color, 1.5f); });
         }
-        // ---------------------------------
+    }
 
-        // --- Input Handling ---
-        processInput(window);
+    endGpuTimer();
 
-        // --- Physics and Collision Update ---
-        if (!isGameOver)
+    if (useBatchedObjects) {
+        // --- Batched Objects: ship body, thrust, asteroids and bullets in one pass ---
+        // (timed as the asteroid pass; the ship pass is only the outline, drawn on top)
         {
-            asteroidSpawnTimer -= deltaTime;
+            ProfileScope scope(PHASE_ASTEROID_DRAW);
+            beginGpuTimer(GPU_PASS_ASTEROIDS);
+            drawBatchedObjects(view, renderShip, alpha);
+            endGpuTimer();
+        }
+
+        beginGpuTimer(GPU_PASS_SHIP);
+        if (!view.isGameOver && useLateLatch) {
+            ProfileScope scope(PHASE_SHIP_DRAW);
+            drawLatchedShip(view, renderShip);
+        }
+        else if (!view.isGameOver && !useInstancedShips) { // Instanced ships' outlines were in the batch
+            ProfileScope scope(PHASE_SHIP_DRAW);
+            drawShipOutline(renderShip);
+        }
+        endGpuTimer();
 
-            // Spawn initial LARGE asteroids
-            if (asteroidSpawnTimer <= 0.0f && asteroids.size() < static_cast<size_t>(MAX_ASTEROIDS)) {
-                spawnNewAsteroid(glm::vec2(0.0f, 0.0f), LARGE);
-                currentSpawnRate = glm::max(MIN_SPAWN_RATE, currentSpawnRate - 0.1f);
-                asteroidSpawnTimer = currentSpawnRate;
+        // Bullets were part of the batched pass; still timed so the query set completes
+        beginGpuTimer(GPU_PASS_BULLETS);
+        endGpuTimer();
+    }
+    else {
+        // --- Per-object draws through the render queue ---
+        // Ship, fire, asteroids and bullets are submitted as items and drawn sorted by state
+        // (fills, then outlines, then bullets on their own layer); the ship outline goes on top,
+        // as in the batched pass. The GPU time of the whole queue counts as the asteroid pass.
+        if (!view.isGameOver) {
+            ProfileScope scope(PHASE_SHIP_DRAW);
+            // FILL (GL_TRIANGLE_FAN) - Darker cyan (latched: drawn on top instead)
+            if (!useLateLatch) {
+                renderQueue.submit(RENDER_LAYER_BODIES, { shaderProgram, meshVAO, GL_TRIANGLE_FAN, shipFillMesh.first, shipFillMesh.count,
+                    renderShip.position, renderShip.rotation, renderShip.scale, glm::vec3(0.2f, 0.7f, 0.7f), 1.0f });
             }
 
-            // Player Physics Update
-            player.velocity *= FRICTION;
-            player.position += player.velocity * deltaTime;
-            if (player.position.x > 1.0f) player.position.x = -1.0f;
-            else if (player.position.x < -1.0f) player.position.x = 1.0f;
-            if (player.position.y > 1.0f) player.position.y = -1.0f;
-            else if (player.position.y < -1.0f) player.position.y = 1.0f;
-
-            // Asteroid Physics Update
-            for (auto& asteroid : asteroids) {
-                asteroid.position += asteroid.velocity * deltaTime;
-                asteroid.rotation += asteroid.rotationSpeed * deltaTime;
-                if (asteroid.position.x > 1.0f) asteroid.position.x = -1.0f;
-                else if (asteroid.position.x < -1.0f) asteroid.position.x = 1.0f;
-                if (asteroid.position.y > 1.0f) asteroid.position.y = -1.0f;
-                else if (asteroid.position.y < -1.0f) asteroid.position.y = 1.0f;
+            // THRUST COLOR: Yellow (Filled)
+            if (view.isThrusting) {
+                renderQueue.submit(RENDER_LAYER_BODIES, { shaderProgram, meshVAO, GL_TRIANGLE_FAN, fireMesh.first, fireMesh.count,
+                    renderShip.position, renderShip.rotation, renderShip.scale * 1.5f, glm::vec3(1.0f, 1.0f, 0.0f), 1.0f });
             }
+        }
 
-            // Bullet Physics Update
-            for (size_t i = 0; i < bullets.size(); /* no increment here */) {
-                bullets[i].position += bullets[i].velocity * deltaTime;
-                bullets[i].lifetime -= deltaTime;
+        // --- Asteroids (Filled and Scaled) ---
+        {
+            ProfileScope scope(PHASE_ASTEROID_DRAW);
+            int sizeLods[3];
+            asteroidLodsForFrame(sizeLods);
+            long long culled = 0;
+            long long ghosts = 0;
+            for (size_t i = 0; i < view.asteroids.count(); ++i) {
+                Asteroid asteroid = view.asteroids.get(i);
+                asteroid.position = interpolatedAsteroidPosition(view.asteroids, view.lazyAsteroidMotion, i, alpha);
+                asteroid.rotation = interpolatedAsteroidRotation(view.asteroids, view.lazyAsteroidMotion, i, alpha);
+
+                const AsteroidMesh& mesh = asteroidShapes[asteroid.shapeIndex].lods[sizeLods[asteroid.size]];
+                int vertexCount = mesh.vertexCount;
+                glm::vec3 fillColor = asteroidPalette[asteroid.paletteIndex] * 0.5f; // Darken for filled look
+                glm::vec3 outlineColor = asteroidPalette[asteroid.paletteIndex] * 1.5f; // Brighten for outline
+                outlineColor = glm::clamp(outlineColor, 0.0f, 1.0f); // Ensure color doesn't exceed 1.0
+
+                // The rock itself, then a ghost across each edge it straddles
+                glm::vec2 offsets[4] = { glm::vec2(0.0f) };
+                int imageCount = 1 + (view.wrapsAtEdges ? wrapGhostOffsets(asteroid.position, ASTEROID_MAX_OUTLINE_RADIUS * asteroid.scale(), offsets + 1) : 0);
+                for (int image = 0; image < imageCount; ++image) {
+                    glm::vec2 position = asteroid.position + offsets[image];
+                    if (!asteroidOnScreen(position, asteroid.scale())) {
+                        if (image == 0) ++culled;
+                        continue;
+                    }
+                    if (image > 0) ++ghosts;
 
-                if (bullets[i].lifetime <= 0.0f ||
-                    abs(bullets[i].position.x) > 1.5f || abs(bullets[i].position.y) > 1.5f) {
-                    bullets.erase(bullets.begin() + i);
-                }
-                else {
-                    ++i;
+                    // 1. The FILL (Darker Shade of the base color)
+                    renderQueue.submit(RENDER_LAYER_BODIES, { shaderProgram, meshVAO, GL_TRIANGLE_FAN, mesh.baseVertex, vertexCount,
+                        position, asteroid.rotation, asteroid.scale(), fillColor, 1.0f });
+
+                    // 2. The OUTLINE (Brighter Shade), a line loop starting at index 1 to skip the center point
+                    renderQueue.submit(RENDER_LAYER_BODIES, { shaderProgram, meshVAO, GL_LINE_LOOP, mesh.baseVertex + 1, vertexCount - 1,
+                        position, asteroid.rotation, asteroid.scale(), outlineColor, 2.0f });
                 }
             }
+            profilerCount(COUNTER_ASTEROIDS_DRAWN, static_cast<long long>(view.asteroids.count()) - culled);
+            profilerCount(COUNTER_ASTEROIDS_CULLED, culled);
+            profilerCount(COUNTER_ASTEROID_GHOSTS, ghosts);
+        }
 
-            // Ship-Asteroid Collision Check (Robust Reverse Index Loop)
-            bool ship_hit = false;
-            for (size_t i = asteroids.size(); i > 0; --i) {
-                size_t index = i - 1;
-                const auto& asteroid = asteroids[index];
+        // --- Bullets (Points) ---
+        // BULLET COLOR: Red. Every bullet is one vertex in clip space: a single upload and a single draw call
+        {
+            ProfileScope scope(PHASE_BULLET_DRAW);
+            bulletVertexBuffer.clear();
+            for (size_t i = 0; i < view.bullets.capacity(); ++i) {
+                if (!view.bullets.live(i)) continue;
+                bulletVertexBuffer.push_back(view.bullets.px[i] + (view.bullets.x[i] - view.bullets.px[i]) * alpha);
+                bulletVertexBuffer.push_back(view.bullets.py[i] + (view.bullets.y[i] - view.bullets.py[i]) * alpha);
+            }
+            GLsizei bulletPoints = streamPoints(bulletVertexBuffer);
+            renderQueue.submit(RENDER_LAYER_PROJECTILES, { shaderProgram, streamPointVAO, GL_POINTS, 0, bulletPoints,
+                glm::vec2(0.0f), 0.0f, 1.0f, glm::vec3(1.0f, 0.0f, 0.0f), 5.0f });
+        }
 
-                if (checkCollision(player.position, player.radius, asteroid.position, asteroid.radius)) {
+        {
+            ProfileScope scope(PHASE_ASTEROID_DRAW);
+            beginGpuTimer(GPU_PASS_ASTEROIDS);
+            drawCallCount += renderQueue.execute();
+            endGpuTimer();
+        }
 
-                    if (shieldActive) {
-                        // 1. Destroy the asteroid (split if large, destroy if small)
-                        std::cout << "Shield absorbed collision and destroyed asteroid!" << std::endl;
+        beginGpuTimer(GPU_PASS_SHIP);
+        if (!view.isGameOver) {
+            ProfileScope scope(PHASE_SHIP_DRAW);
+            if (useLateLatch) drawLatchedShip(view, renderShip);
+            else drawShipOutline(renderShip);
+        }
+        endGpuTimer();
 
-                        if (asteroid.size == SMALL) {
-                            glDeleteVertexArrays(1, &asteroid.VAO_Fill);
-                            glDeleteBuffers(1, &asteroid.VBO_Fill);
-                            asteroids.erase(asteroids.begin() + index);
-                        }
-                        else {
-                            splitAsteroid(asteroid, index);
-                        }
+        // Bullets were part of the queue; still timed so the query set completes
+        beginGpuTimer(GPU_PASS_BULLETS);
+        endGpuTimer();
+    }
 
-                        // 2. Put the shield into cooldown mode
-                        shieldActive = false;
-                        shieldCooldownTimer = SHIELD_COOLDOWN;
-                        std::cout << "Shield deactivated. Cooldown started." << std::endl;
+    // 2b. Trails: a row of the history ring per new tick, every trail in one strip draw
+    if (useTrails && view.wrapsAtEdges) {
+        syncTrails(view);
+        renderQueue.forEachViewport([&] { drawCallCount += drawTrails(alpha, PAINT_BULLET, PAINT_SHIP_GLOW); });
+    }
 
-                        // We continue to the next iteration as the current asteroid is gone, but the ship is safe.
+    // 2c. Debris and sparks: the effects since the last frame's snapshot become bursts, then one
+    // transform feedback pass moves every particle and one draw shows them
+    emitEffectParticles(view);
+    if (useParticles) {
+        updateParticles(frameInput.time);
+        const float pointScale = static_cast<float>(renderQueue.viewports[0].height) / SCR_HEIGHT;
+        renderQueue.forEachViewport([&] { drawCallCount += drawParticles(pointScale); });
+    }
+}
 
-                    }
-                    else {
-                        // Regular collision - Game Over
-                        std::cout << "COLLISION! GAME OVER." << std::endl;
-                        isGameOver = true;
-                        ship_hit = true;
-                        break; // Stop checking collisions
-                    }
-                }
+// The broadphase heatmap (F3) over the finished scene, then the score, GAME OVER, the perf overlay
+// and the heatmap's hot cells: one instanced draw over everything
+static void drawHudPass(const RenderPass& pass)
+{
+    const RenderSnapshot& view = *static_cast<const SceneFrame*>(pass.context)->view;
+    if (stageBroadphaseView(view.heatmap)) {
+        renderQueue.forEachViewport([] { drawCallCount += drawBroadphaseView(); });
+        queueBroadphaseHud(view.heatmap, pass.width);
+    }
+    queueHud(pass.width, pass.height, view.score, view.isGameOver, restartAvailable());
+    drawCallCount += drawHud(pass.width, pass.height);
+}
+
+void recordFrame(GLFWwindow* window)
+{
+    // Requests from the input handler that need the context or the render-side profiler state
+    if (presentModeChanged) {
+        applyPresentMode(window);
+        presentModeChanged = false;
+    }
+    if (profilerReportRequested) {
+        profilerReport();
+        reportInputLatency();
+        renderGraph.log();
+        profilerReportRequested = false;
+    }
+    if (memoryReportRequested) {
+        AllowAllocations report; // On demand, not steady state
+        collectMemory().log();
+        logGpuMemory();
+        memoryReportRequested = false;
+    }
+    const RenderSnapshot& view = *frameInput.view;
+    const float alpha = frameInput.alpha;
+    presentedFrameStart = frameInput.start; // frameInput may be refilled once the frame is recorded
+    presentedAsteroids = view.asteroids.count();
+    presentedInputStamp = view.inputStamp;
+    profilerCount(COUNTER_BULLETS_LIVE, static_cast<long long>(view.bullets.liveCount()));
+    telemetrySet(TELEMETRY_ASTEROIDS, static_cast<int64_t>(view.asteroids.count()));
+    telemetrySet(TELEMETRY_BULLETS, static_cast<int64_t>(view.bullets.liveCount()));
+    telemetrySet(TELEMETRY_SHIELD_ACTIVE, view.shieldActive ? 1 : 0);
+
+    Ship renderShip = view.player;
+    renderShip.position.x = interpolateWrapped(view.player.prevPosition.x, view.player.position.x, alpha);
+    renderShip.position.y = interpolateWrapped(view.player.prevPosition.y, view.player.position.y, alpha);
+    renderShip.rotation = interpolateAngle(view.player.prevRotation, view.player.rotation, alpha);
+
+    // --- Rendering Commands ---
+    beginFrameTemporaries();
+    beginGpuTimerFrame();
+    if (framebufferResized) {
+        AllowAllocations resize; // Raster scratch is re-reserved for the new size
+        resizeRasterTargets();
+    }
+    streamBuffer.beginFrame();
+    uploadStreamedShapes(meshVBO);
+    if (assetLoadsPending() && pumpAssetUploads()) {
+        AllowAllocations save; // Once: the loads were the asset cache's last readers
+        saveAssetCache();
+    }
+    frameConstants.time = shaderTime(frameInput.time);
+    useInstanceFormat(useCompactInstances);
+    // Settled like the record format: the instances' shape field and the shaders must agree on it
+    frameSilhouettes = asteroidSilhouettes == SILHOUETTES_POLAR && !polarShapeTexture ? SILHOUETTES_ATLAS : asteroidSilhouettes;
+    frameConstants.polarShapes = frameSilhouettes == SILHOUETTES_POLAR ? 1 : 0;
+    if (useBatchedObjects && useResidentRocks && view.wrapsAtEdges) {
+        syncResidentRocks(view.asteroids, view.lazyAsteroidMotion);
+        const AsteroidStore& rocks = view.asteroids;
+        frameConstants.gameTime = residentRockTime(rocks.previousClock + (rocks.clock - rocks.previousClock) * alpha);
+    }
+    updateFrameConstants();
+
+    // The frame as a render graph (see rendergraph.h): the background clears the window, the scene
+    // draws over it, the bloom's chain adds its glow and the HUD goes on top
+    SceneFrame scene = { &view, renderShip, alpha };
+    renderGraph.beginFrame(framebufferWidth, framebufferHeight);
+    addBackgroundPasses();
+    renderGraph.addPass("scene", PHASE_COUNT, {}, RENDER_GRAPH_BACKBUFFER, RENDER_LOAD_KEEP, drawScene, &scene);
+    if (useBloom) addBloomPasses(useBatchedObjects && renderQueue.viewportCount == 1);
+    renderGraph.addPass("hud", PHASE_HUD, {}, RENDER_GRAPH_BACKBUFFER, RENDER_LOAD_KEEP, drawHudPass, &scene);
+    renderGraph.compile();
+    renderGraph.execute();
+
+    // Screenshot or video frame: the readback is only queued here (see FRAME CAPTURE)
+    captureFrame(framebufferWidth, framebufferHeight);
+
+    glState.bindVertexArray(0);
+    streamBuffer.endFrame();
+    deletionQueue.endFrame();
+    deletionQueue.collect();
+    endGpuTimerFrame();
+    ++frameIndex;
+}
+
+// Swaps and closes the frame in the profiler (the frame time runs from the main loop's frame start)
+void presentFrame(GLFWwindow* window)
+{
+    const std::chrono::steady_clock::time_point submitted = std::chrono::steady_clock::now();
+    {
+        ProfileScope scope(PHASE_SWAP_BUFFERS);
+        beforeSwap();
+        glfwSwapBuffers(window);
+        afterSwap();
+    }
+    const std::chrono::steady_clock::time_point frameEnd = std::chrono::steady_clock::now();
+    noteFramePresented(presentedInputStamp, submitted, frameEnd);
+    profilerAdd(PHASE_FRAME, std::chrono::duration<double, std::milli>(frameEnd - presentedFrameStart).count());
+    traceSpan("frame", "frame", presentedFrameStart, frameEnd);
+    static long long drawCallsReported = 0;
+    static unsigned long long bytesReported = 0;
+    profilerCount(COUNTER_DRAW_CALLS, drawCallCount - drawCallsReported);
+    const unsigned long long bytesWritten = streamBuffer.bytesWritten + residentBulletBytesWritten() + residentRockBytesWritten() + trailBytesWritten();
+    profilerCount(COUNTER_UPLOAD_KB, (bytesWritten - bytesReported) / 1024);
+    sampleGpuMemory();
+    profilerEndFrame();
+    updateLoadShedding(static_cast<size_t>(simulationLimits.maxAsteroids), presentedAsteroids);
+
+    const int64_t frameMicroseconds = std::chrono::duration_cast<std::chrono::microseconds>(frameEnd - presentedFrameStart).count();
+    telemetryAdd(TELEMETRY_FRAMES, 1);
+    telemetryAdd(TELEMETRY_FRAME_MICROSECONDS, frameMicroseconds);
+    telemetryMax(TELEMETRY_LONGEST_FRAME_US, frameMicroseconds);
+    telemetryAdd(TELEMETRY_DRAW_CALLS, drawCallCount - drawCallsReported);
+    telemetryAdd(TELEMETRY_UPLOAD_BYTES, static_cast<int64_t>(bytesWritten - bytesReported));
+    drawCallsReported = drawCallCount;
+    bytesReported = bytesWritten;
+}
+
+// ============================ MAIN FUNCTION ============================
+// ============================ HEADLESS MODE ============================
+// Runs the spawn/physics/collision loop at full speed with no window or GL context (soak tests,
+// bot farms) and reports ticks per second. The ship spins and fires continuously and raises the
+// shield whenever it is ready, so every collision path is exercised. A replay starts at startTick.
+// With --bot-channel the agent on the channel flies it instead, through episode after episode.
+int runHeadless(long long tickLimit, long long startTick)
+{
+    std::vector<float> atlasVertices; // Shapes are still needed for the asteroid shape indices
+    generateAsteroidShapes(atlasVertices);
+    world.init(simulationLimits);
+    if (startTick > 0 && !seekReplay(startTick)) return 1;
+    if (scenarioActive) {
+        writeScenarioResult(scenarioOutputPath, runScenarioHeadless(tickLimit));
+        return 0;
+    }
+
+    InputState input;
+    input.left = true;
+    input.fire = true;
+    input.shield = true;
+
+    BotChannel channel;
+    long long episodes = 0;
+    if (botChannelName) {
+        if (!channel.create(botChannelName)) return 1;
+        channel.publish(world, 0, 0.0f, false);
+        LOG_INFO("[headless] Waiting for an agent on bot channel %s", channel.name.c_str());
+    }
+
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point start = Clock::now();
+    Clock::time_point lastReport = start;
+    long long ticks = 0;
+    long long ticksAtLastReport = 0;
+
+    while (ticks < tickLimit && !world.isGameOver && !replayFinished()) {
+        const int scoreBefore = world.score;
+        if (botChannelName) {
+            uint8_t bits;
+            if (!channel.waitInput(static_cast<uint64_t>(ticks), bits)) break; // The agent left
+            input = unpackInput(bits);
+        }
+        applyLoadShedding(world);
+        if (botCount > 0 || botPilot) stepWithBots(world, bots, input);
+        else world.step(SIM_DT, tickInput(input));
+        profilerEndFrame(); // One profiler "frame" per tick; the render phases stay at zero
+        updateLoadShedding(static_cast<size_t>(world.limits.maxAsteroids), world.liveAsteroidCount());
+        ++ticks;
+        if (botChannelName) {
+            // Scored as in the batch environment, and a lost ship starts the next episode
+            float reward = static_cast<float>(world.score - scoreBefore);
+            const bool done = world.isGameOver;
+            if (done) {
+                reward += BATCH_GAME_OVER_REWARD;
+                world.reset();
+                ++episodes;
             }
-            if (ship_hit) break; // Exit the game physics update if game over
-
-            // Bullet-Asteroid Collision Check (Handle splitting/destruction)
-            for (size_t i = asteroids.size(); i > 0; --i) {
-                size_t index = i - 1;
-                bool bulletHit = false;
-
-                for (size_t j = 0; j < bullets.size(); /* no increment here */) {
-                    if (checkCollision(asteroids[index].position, asteroids[index].radius, bullets[j].position, bullets[j].radius)) {
-                        bullets.erase(bullets.begin() + j);
-                        bulletHit = true;
-                        break;
-                    }
-                    else {
-                        ++j;
-                    }
-                }
+            channel.publish(world, static_cast<uint64_t>(ticks), reward, done);
+        }
 
-                if (bulletHit) {
-                    if (asteroids[index].size == SMALL) {
-                        // Destroy small asteroid
-                        glDeleteVertexArrays(1, &asteroids[index].VAO_Fill);
-                        glDeleteBuffers(1, &asteroids[index].VBO_Fill);
-                        asteroids.erase(asteroids.begin() + index);
-                    }
-                    else {
-                        // Split and shrink the larger asteroid
-                        splitAsteroid(asteroids[index], index);
-                    }
-                }
+        // Only look at the clock every 1024 ticks to keep timing out of the measurement
+        if ((ticks & 1023) == 0) {
+            Clock::time_point now = Clock::now();
+            double elapsed = std::chrono::duration<double>(now - lastReport).count();
+            if (elapsed >= 1.0) {
+                LOG_INFO("[headless] %lld ticks/s | tick %lld | asteroids %zu | bullets %zu",
+                         static_cast<long long>((ticks - ticksAtLastReport) / elapsed), ticks, world.asteroids.count(), world.bullets.liveCount());
+                lastReport = now;
+                ticksAtLastReport = ticks;
             }
         }
+    }
 
-        // --- Rendering Commands ---
-        glClear(GL_COLOR_BUFFER_BIT);
+    double total = std::chrono::duration<double>(Clock::now() - start).count();
+    LOG_INFO("[headless] %lld ticks (%g s game time) in %g s = %lld ticks/s%s", ticks, ticks * SIM_DT, total,
+             static_cast<long long>(total > 0.0 ? ticks / total : 0.0), world.isGameOver ? " (ended by game over)" : "");
+    if (botChannelName) LOG_INFO("[headless] %lld episodes finished on bot channel %s", episodes, channel.name.c_str());
+    channel.close();
+    reportLoadShedding(world);
+    profilerReport();
+    stopRecording();
+    return replayDesyncTick() >= 0 ? 1 : 0;
+}
 
-        // 1. Draw the Dynamic Nebula Background
-        glUseProgram(backgroundProgram);
-        glUniform1f(timeLoc, t);
-        glBindVertexArray(gradientVAO);
-        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+int main(int argc, char** argv)
+{
+    startLogger(); // Console output goes through the async queue from here on; drained at exit
+
+    // --- 0. Command Line ---
+    // --headless [--ticks N]: run the simulation only, without GLFW/GL
+    // --bot-channel NAME: --headless with the ship flown by an agent in another process through
+    //   shared memory (botchannel.h); a lost ship starts a new episode; --ticks caps the steps
+    // --bot-agent NAME: be that agent (the headless policy) for up to --ticks steps, and exit
+    // --profile: print the frame profile every few seconds (P prints it on demand; M prints the memory report)
+    // --latency: measure every game key press to the tick that applied it, the frame that showed it and
+    //   the GPU finishing that frame; reported with the frame profile and at exit (inputlatency.h)
+    // --validate-raster: check the GPU rasterizers against the CPU ones and exit
+    // --bg-scale N (1, 2, 4): nebula resolution divisor; --bg-interval N: refresh the scaled nebula every N frames
+    // --bg-baked: sample the baked noise texture instead of analytic fbm
+    // --bg-vrs N (2, 4): shade the full-resolution nebula once per NxN pixels outside the sun core
+    //   (GL_NV_shading_rate_image; ignored without it)
+    // --frame-budget MS: scale the nebula resolution to keep the GPU frame time under MS (D toggles it)
+    // --shed-budget MS: turn new rocks away while frames (headless: ticks) cost over MS (loadshed.h;
+    //   not with recording, replays, --batch or --arena)
+    // --bench-background: time every background mode and exit
+    // --bench-upload [pixels|float|compact]: time every way of streaming a buffer (subdata, orphaning,
+    //   mapping, persistent mapping) at several payload sizes on this driver and exit; the payload is
+    //   shield pixels, or rock instance records in either format (uploadbench.h)
+    // --seed N: seed for every simulation random stream (default: the current time; printed at startup)
+    // --shape-seed N: seed for the asteroid outlines alone (default: --seed's), as a restart logs to
+    //   repeat the game it started; not with --record or --replay, which only store the one seed
+    // --record FILE: save the seed and every tick's input; --replay FILE: play one back (headless or rendered),
+    //   then print the frame profile and exit; --record-checksums: also store every tick's world
+    //   checksum, so replaying the file reports the first tick that plays out differently (a replay
+    //   with a desync exits with status 1); --replay-from TICK: start the replay at TICK (from the
+    //   nearest keyframe before it)
+    // --simd scalar|sse2|avx2: cap the collision kernel's instruction set (default: the best the CPU supports)
+    // --single-thread: run the simulation on the main thread between frames instead of on its own thread
+    // --render-thread: make every GL call and the swap on a render thread, so input and the simulation
+    //   do not wait for vsync (not with --low-latency, whose pacing needs the swap on the main thread)
+    // --scenario NAME: stress scenario (1k, 10k, 100k asteroids, each also -shield and -bullets), headless
+    //   for --ticks or rendered for --scenario-frames N (default 600), then print one JSON result line;
+    //   --bench-out FILE: append that line to FILE instead
+    // --present vsync|adaptive|uncapped|limit: presentation mode (default vsync, V cycles it);
+    //   --fps N: frame cap for "limit" (implies it); --low-latency: no queued frames, late input sampling
+    // --batch N: step N headless worlds in lock-step for --ticks steps, as the bot training API does,
+    //   and print the throughput; --batch-render SIZE: also draw every world into a SIZE x SIZE
+    //   observation image each step (hidden GL 3.3 window) and read them back; --soft-render: draw them
+    //   on the CPU instead, with no window (softrender.h); --soft-image FILE: and write world 0's last
+    //   one there as a PPM
+    // --rock-collisions: asteroids bounce off each other (recorded in replays)
+    // --broadphase grid|sap|brute: what the ship and rock-rock checks find asteroids with (default grid;
+    //   sap is the sweep-and-prune alternative, brute tests every pair and every bullet, for
+    //   comparisons; recorded in replays)
+    // --kinetic: find bullet hits from predicted impact times instead of searching every tick
+    //   (recorded in replays)
+    // --lazy-rocks: rocks keep a start point and velocity and are positioned from them, instead of
+    //   being moved a step every tick; they keep their overshoot across the edges (recorded in replays)
+    // --fixed-point: move the ship, rocks and bullets in Q16.16 fixed point, so builds from different
+    //   compilers and CPUs stay in lockstep (recorded in replays; overrides --lazy-rocks)
+    // --gravity off|wells|rocks|both: the rocks are pulled by two fixed gravity wells, by the large
+    //   rocks (summed through a Barnes-Hut tree), or both (not with --lazy-rocks, --fixed-point or
+    //   --kinetic; recorded in replays); --gravity-theta T: the tree's opening angle (default 0.5;
+    //   0 sums every large rock on its own)
+    // --circle-hits: ships and bullets hit the rocks' circles instead of their drawn outlines
+    //   (recorded in replays)
+    // --pair-batch: search the bullet hits in two stages, every candidate pair of a chunk of rocks
+    //   gathered into one flat buffer, then tested in one SIMD pass (the same hits; P shows the pairs
+    //   per frame and the share that hit)
+    // --sort-rocks: re-sort the rocks in memory by where they are on the field every
+    //   ASTEROID_SORT_TICKS, for the collision passes' cache locality (recorded in replays)
+    // --waves: rocks come in scripted waves (waves.h) instead of on the spawn timer (recorded in replays)
+    // --waves-file FILE: --waves with the script of a compiled wave file (give it again to play a
+    //   replay back); --compile-waves SOURCE FILE: compile a text wave source into one and exit
+    // --weapon blaster|spread|burst|missiles: what the ships fire (default blaster; spread fans 12
+    //   bullets out per shot, burst strings 32 along the line of fire, missiles launches 24 that home
+    //   on the rocks; recorded in replays; not in the arena; missiles not with --fixed-point or --kinetic)
+    // --arena N: play in an arena N x N screens wide (at least 4), the camera following the ship; the
+    //   rocks live in per-screen chunks and only the chunks in view are drawn (arena.h; window only)
+    // --jobs N: worker threads for the simulation's parallel loops (default: one per core but one;
+    //   0 runs every job inline, the single-thread reference)
+    // --threads auto|pinned|off: thread priorities and cores (threadconfig.h; default auto: the game's
+    //   threads high and on the performance cores of a hybrid CPU, the logger and writers low and on
+    //   the efficiency cores; pinned also gives the simulation and render threads a core each and
+    //   the workers one per remaining core; the layout is logged at startup)
+    // --large-pages: map entity arrays of 2 MiB and up (a pool of half a million rocks) on large
+    //   pages (entitymemory.h; Windows needs the "Lock pages in memory" right)
+    // --line-width N: pixel width of the batched asteroid outlines (default 2)
+    // --compact-instances: stream the batched objects' instance records at 12 bytes instead of 24
+    //   (16-bit positions, half-float rotation and scale; Z toggles it)
+    // --resident-bullets: keep each bullet's spawn record on the GPU and place it in the vertex
+    //   shader, uploading only when a bullet is fired or lost (X toggles it)
+    // --resident-rocks: the same for the rocks, drawn as SDF quads and uploaded only on a spawn, a
+    //   loss or a bounce (J toggles it; the arena keeps streaming them)
+    // --no-particles: no debris or sparks where rocks and ships are lost (C toggles them)
+    // --no-trails: no fading trails behind the bullets and the ship (R toggles them)
+    // --shield-quad: every ship's shield as one quad with the ring worked out per pixel, all in one
+    //   instanced draw, instead of the player's alone rasterized as points (G then has no effect on it)
+    // --instanced-ships: every ship's outline drawn in the batched pass as one instanced loop of the
+    //   hull mesh, next to one draw for all the hulls and one for all the plumes, instead of the
+    //   player's alone as a Bresenham outline (the per-object path, I, keeps the Bresenham one)
+    // --ship-atlas [N]: the player's Bresenham outline drawn from a table of N rotations (default 512)
+    //   rasterized once per window size, instead of rasterized and uploaded every frame
+    // --late-latch: the player's hull and outline drawn last, at a pose extrapolated from the newest
+    //   tick by the keys held at that moment (latelatch.h); not with replays, --autopilot,
+    //   --bot-channel, --spectate or --arena, where the keys do not fly the ship
+    // --no-audio: no sound (the window only; headless runs are always silent)
+    // --no-shape-stream: no rock shapes generated in the background past the atlas's own
+    // --bots N: N AI ships fly and shoot alongside the player (attract mode, load tests; not with
+    //   recordings, replays, --batch or --arena, which hold one ship)
+    // --autopilot: the player's ship flies itself like a bot (same limits as --bots)
+    // --fast-forward [N]: start in fast-forward, N ticks per rendered frame (default 60; simthread.h;
+    //   A toggles it); --fast-forward-ms MS: a time budget per frame for the batch instead (with N
+    //   too: whichever runs out first); --fast-forward-until T: back to real time at T seconds of game
+    //   time (with --autopilot, say, to reach a late game without playing it)
+    // --spectate HOST:PORT MATCH: watch that match of a match server or relay instead of playing
+    //   (spectator.h; nothing simulated here: single-threaded, no recordings, replays or bots)
+    // --swarm N: N extra rocks simulated and drawn entirely on the GPU behind the game (GL 4.3,
+    //   scenery only; W toggles them)
+    // --alloc-guard N: after N frames (headless: ticks), abort on any heap allocation in the loop,
+    //   naming the phase it happened in (debug builds break into the debugger first)
+    // --no-dsa: keep the GL 3.3 bind-to-edit buffer and vertex array code on a GL 4.5 context
+    // --gl-context development|production|plain: a debug context with GL messages in the log, a
+    //   no-error context without driver validation, or neither (default: development in debug
+    //   builds, production in release builds)
+    // --quality low|medium|high|ultra|auto: background and asteroid detail preset (default: the one
+    //   saved in the asset cache for this GPU, else benchmarked and saved; auto benchmarks again; Q cycles)
+    // --bloom 2|4: glow on outlines and bullets, blurred at 1/2 or 1/4 resolution (U cycles)
+    // --split 2|4: draw the world in two side-by-side or four 2x2 viewports for local co-op; the
+    //   frame is prepared once and each pass draws it in every viewport (no bloom while split)
+    // --capture PATH: record every frame to PATH as a .y4m video (--capture-fps N for its header,
+    //   default 60); F12 saves a screenshot either way
+    // --trace FILE: record a timeline of every phase, job, tick and GPU pass from startup and write it
+    //   to FILE as Chrome trace JSON at exit (chrome://tracing, ui.perfetto.dev); F11 records one on demand
+    // --hitch-ms N: write the last PROFILE_HISTORY frames' profile to hitch-NNNN.csv whenever a frame
+    //   takes over N ms (default 50; 0 turns it off; off for scenario runs unless given)
+    // --telemetry HOST:PORT: send frame time, tick rate, entity counts, draw calls, upload bytes and
+    //   the shield state as StatsD UDP packets once a second; --telemetry-name NAME: metric prefix
+    //   (default "asteroids")
+    // --perf-hud: start with the perf overlay (frame-time graph, GPU time, counts, busiest phases) shown;
+    //   H toggles it
+    // --heatmap: start with the broadphase heatmap of the finest grid level shown (broadphaseview.h);
+    //   F3 steps through the levels and off
+    bool headless = false;
+    bool allowDirectStateAccess = true;
+    bool validateRaster = false;
+    bool benchBackground = false;
+    bool benchUpload = false;
+    UploadPayload uploadPayload = UPLOAD_PAYLOAD_PIXELS;
+    const char* scenarioName = NULL;
+    bool qualityGiven = false; // --quality named a preset
+    bool qualityBenchmark = false; // --quality auto
+    int requestedBackgroundScale = 0; // --bg-scale, which overrides the preset's
+    const char* capturePath = NULL;
+    int captureFps = 60;
+    const char* tracePath = NULL;
+    bool hitchThresholdGiven = false;
+    const char* telemetryTarget = NULL;
+    const char* telemetryName = "asteroids";
+    long long scenarioFrames = 600;
+    int batchWorlds = 0;
+    int batchRenderSize = 0; // --batch-render tile size in pixels
+    bool softRender = false;
+    const char* softImagePath = NULL;
+    int jobWorkers = -1;
+    ThreadPlacement threadPlacement = THREADS_AUTO;
+    bool largePages = false;
+    bool startFastForward = false;
+    int fastForwardTicks = -1; // Given with --fast-forward
+    bool rockCollisions = false;
+    long long swarmRocks = 0;
+    ArenaConfig arenaConfig;
+    uint64_t seed = static_cast<uint64_t>(std::time(0));
+    uint64_t outlineSeed = 0; // --shape-seed
+    bool outlineSeedGiven = false;
+    const char* recordPath = NULL;
+    bool recordChecksums = false;
+    const char* replayPath = NULL;
+    long long replayFrom = 0;
+    const char* wavesPath = NULL;
+    const char* waveSourcePath = NULL; // --compile-waves
+    long long headlessTicks = static_cast<long long>(SIM_TICK_RATE) * 60 * 10; // 10 minutes of game time
+    const char* botAgentChannel = NULL;
+    const char* spectateTarget = NULL;
+    uint32_t spectateMatch = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--headless") == 0) headless = true;
+        else if (std::strcmp(argv[i], "--bot-channel") == 0 && i + 1 < argc) {
+            botChannelName = argv[++i];
+            headless = true;
+        }
+        else if (std::strcmp(argv[i], "--bot-agent") == 0 && i + 1 < argc) botAgentChannel = argv[++i];
+        else if (std::strcmp(argv[i], "--profile") == 0) profilerPeriodicReport = true;
+        else if (std::strcmp(argv[i], "--latency") == 0) inputLatencyEnabled = true;
+        else if (std::strcmp(argv[i], "--validate-raster") == 0) validateRaster = true;
+        else if (std::strcmp(argv[i], "--bg-scale") == 0 && i + 1 < argc) requestedBackgroundScale = std::max(1, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--bg-baked") == 0) useBakedNebula = true;
+        else if (std::strcmp(argv[i], "--shed-budget") == 0 && i + 1 < argc) shedBudgetMs = std::max(0.0f, static_cast<float>(std::atof(argv[++i])));
+        else if (std::strcmp(argv[i], "--frame-budget") == 0 && i + 1 < argc) {
+            frameBudgetMs = std::max(1.0f, static_cast<float>(std::atof(argv[++i])));
+            useDynamicResolution = true;
+        }
+        else if (std::strcmp(argv[i], "--bench-background") == 0) benchBackground = true;
+        else if (std::strcmp(argv[i], "--bench-upload") == 0) {
+            benchUpload = true;
+            const char* const payloadNames[] = { "pixels", "float", "compact" }; // UploadPayload order; optional
+            for (int p = 0; p < 3 && i + 1 < argc; ++p) {
+                if (std::strcmp(argv[i + 1], payloadNames[p]) != 0) continue;
+                uploadPayload = static_cast<UploadPayload>(p);
+                ++i;
+                break;
+            }
+        }
+        else if (std::strcmp(argv[i], "--single-thread") == 0) useSimThread = false;
+        else if (std::strcmp(argv[i], "--render-thread") == 0) useRenderThread = true;
+        else if (std::strcmp(argv[i], "--present") == 0 && i + 1 < argc) {
+            if (!parsePresentMode(argv[++i], presentMode)) LOG_WARN("Unknown present mode %s, using %s", argv[i], presentModeName(presentMode));
+        }
+        else if (std::strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+            frameLimitHz = std::max(1.0, std::atof(argv[++i]));
+            presentMode = PRESENT_LIMITED;
+        }
+        else if (std::strcmp(argv[i], "--low-latency") == 0) lowLatencyMode = true;
+        else if (std::strcmp(argv[i], "--scenario") == 0 && i + 1 < argc) scenarioName = argv[++i];
+        else if (std::strcmp(argv[i], "--scenario-frames") == 0 && i + 1 < argc) scenarioFrames = std::max(1LL, std::atoll(argv[++i]));
+        else if (std::strcmp(argv[i], "--bench-out") == 0 && i + 1 < argc) scenarioOutputPath = argv[++i];
+        else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = std::strtoull(argv[++i], NULL, 10);
+        else if (std::strcmp(argv[i], "--shape-seed") == 0 && i + 1 < argc) {
+            outlineSeed = std::strtoull(argv[++i], NULL, 10);
+            outlineSeedGiven = true;
+        }
+        else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) recordPath = argv[++i];
+        else if (std::strcmp(argv[i], "--record-checksums") == 0) recordChecksums = true;
+        else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc) replayPath = argv[++i];
+        else if (std::strcmp(argv[i], "--replay-from") == 0 && i + 1 < argc) replayFrom = std::max(0LL, std::atoll(argv[++i]));
+        else if (std::strcmp(argv[i], "--simd") == 0 && i + 1 < argc) {
+            const char* name = argv[++i];
+            setCollisionKernel(std::strcmp(name, "scalar") == 0 ? COLLISION_KERNEL_SCALAR :
+                               std::strcmp(name, "sse2") == 0 ? COLLISION_KERNEL_SSE2 : COLLISION_KERNEL_AVX2);
+        }
+        else if (std::strcmp(argv[i], "--bg-interval") == 0 && i + 1 < argc) backgroundUpdateInterval = std::max(1, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--bg-vrs") == 0 && i + 1 < argc) nebulaShadingRate = std::atoi(argv[++i]) >= 4 ? 4 : 2;
+        else if (std::strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) headlessTicks = std::atoll(argv[++i]);
+        else if (std::strcmp(argv[i], "--batch") == 0 && i + 1 < argc) batchWorlds = std::max(1, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--batch-render") == 0 && i + 1 < argc) batchRenderSize = std::max(8, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--soft-render") == 0) softRender = true;
+        else if (std::strcmp(argv[i], "--soft-image") == 0 && i + 1 < argc) softImagePath = argv[++i];
+        else if (std::strcmp(argv[i], "--rock-collisions") == 0) rockCollisions = true;
+        else if (std::strcmp(argv[i], "--broadphase") == 0 && i + 1 < argc) {
+            world.asteroidBroadphase = BROADPHASE_GRID;
+            if (!parseBroadphase(argv[++i], world.asteroidBroadphase)) LOG_WARN("Unknown broadphase %s, using the grid", argv[i]);
+        }
+        else if (std::strcmp(argv[i], "--kinetic") == 0) world.kineticBulletHits = true;
+        else if (std::strcmp(argv[i], "--lazy-rocks") == 0) world.lazyAsteroidMotion = true;
+        else if (std::strcmp(argv[i], "--circle-hits") == 0) world.silhouetteHits = false;
+        else if (std::strcmp(argv[i], "--pair-batch") == 0) world.pairBatchedHits = true;
+        else if (std::strcmp(argv[i], "--sort-rocks") == 0) world.spatialSortAsteroids = true;
+        else if (std::strcmp(argv[i], "--waves") == 0) world.scriptedWaves = true;
+        else if (std::strcmp(argv[i], "--waves-file") == 0 && i + 1 < argc) {
+            wavesPath = argv[++i];
+            world.scriptedWaves = true;
+        }
+        else if (std::strcmp(argv[i], "--compile-waves") == 0 && i + 2 < argc) {
+            waveSourcePath = argv[++i];
+            wavesPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--weapon") == 0 && i + 1 < argc) {
+            if (!parseWeapon(argv[++i], world.weapon)) LOG_WARN("Unknown weapon %s, using the blaster", argv[i]);
+        }
+        else if (std::strcmp(argv[i], "--fixed-point") == 0) world.fixedPointKinematics = true;
+        else if (std::strcmp(argv[i], "--gravity") == 0 && i + 1 < argc) {
+            world.gravityWells = world.rockGravity = false;
+            if (!parseGravity(argv[++i], world.gravityWells, world.rockGravity)) LOG_WARN("Unknown gravity %s, playing without", argv[i]);
+        }
+        else if (std::strcmp(argv[i], "--gravity-theta") == 0 && i + 1 < argc) world.gravityTheta = gravityThetaFrom(static_cast<float>(std::atof(argv[++i])));
+        else if (std::strcmp(argv[i], "--arena") == 0 && i + 1 < argc) {
+            arenaConfig.chunksX = arenaConfig.chunksY = std::max(ARENA_MIN_CHUNKS, std::atoi(argv[++i]));
+            arenaMode = true;
+        }
+        else if (std::strcmp(argv[i], "--spectate") == 0 && i + 2 < argc) {
+            spectateTarget = argv[++i];
+            spectateMatch = static_cast<uint32_t>(std::strtoul(argv[++i], NULL, 10));
+        }
+        else if (std::strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) jobWorkers = std::max(0, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            if (!parseThreadPlacement(argv[++i], threadPlacement)) LOG_WARN("Unknown thread placement %s, using auto", argv[i]);
+        }
+        else if (std::strcmp(argv[i], "--large-pages") == 0) largePages = true;
+        else if (std::strcmp(argv[i], "--line-width") == 0 && i + 1 < argc) outlineWidthPixels = std::max(1.0f, static_cast<float>(std::atof(argv[++i])));
+        else if (std::strcmp(argv[i], "--compact-instances") == 0) useCompactInstances = true;
+        else if (std::strcmp(argv[i], "--resident-bullets") == 0) useResidentBullets = true;
+        else if (std::strcmp(argv[i], "--resident-rocks") == 0) useResidentRocks = true;
+        else if (std::strcmp(argv[i], "--no-particles") == 0) useParticles = false;
+        else if (std::strcmp(argv[i], "--no-trails") == 0) useTrails = false;
+        else if (std::strcmp(argv[i], "--shield-quad") == 0) useShieldRing = true;
+        else if (std::strcmp(argv[i], "--instanced-ships") == 0) useInstancedShips = true;
+        else if (std::strcmp(argv[i], "--late-latch") == 0) useLateLatch = true;
+        else if (std::strcmp(argv[i], "--ship-atlas") == 0) {
+            useShipAtlas = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') shipAtlasRotations = std::clamp(std::atoi(argv[++i]), 8, SHIP_ATLAS_MAX_ROTATIONS);
+        }
+        else if (std::strcmp(argv[i], "--no-audio") == 0) useAudio = false;
+        else if (std::strcmp(argv[i], "--no-shape-stream") == 0) useShapeStream = false;
+        else if (std::strcmp(argv[i], "--bots") == 0 && i + 1 < argc) botCount = static_cast<size_t>(std::max(0, std::atoi(argv[++i])));
+        else if (std::strcmp(argv[i], "--autopilot") == 0) botPilot = true;
+        else if (std::strcmp(argv[i], "--fast-forward") == 0) {
+            startFastForward = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') fastForwardTicks = std::max(0, std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--fast-forward-ms") == 0 && i + 1 < argc) fastForward.budgetMs = std::max(0.0f, static_cast<float>(std::atof(argv[++i])));
+        else if (std::strcmp(argv[i], "--fast-forward-until") == 0 && i + 1 < argc) {
+            fastForward.untilTick = static_cast<long long>(ticksFor(static_cast<float>(std::max(0.0, std::atof(argv[++i])))));
+        }
+        else if (std::strcmp(argv[i], "--swarm") == 0 && i + 1 < argc) swarmRocks = std::max(0LL, std::atoll(argv[++i]));
+        else if (std::strcmp(argv[i], "--alloc-guard") == 0 && i + 1 < argc) allocationGuardFrames = std::max(0, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--no-dsa") == 0) allowDirectStateAccess = false;
+        else if (std::strcmp(argv[i], "--gl-context") == 0 && i + 1 < argc) {
+            if (!parseGlContextMode(argv[++i], glContextMode)) LOG_WARN("Unknown GL context mode %s, using %s", argv[i], glContextModeName(glContextMode));
+        }
+        else if (std::strcmp(argv[i], "--capture") == 0 && i + 1 < argc) capturePath = argv[++i];
+        else if (std::strcmp(argv[i], "--capture-fps") == 0 && i + 1 < argc) captureFps = std::max(1, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) tracePath = argv[++i];
+        else if (std::strcmp(argv[i], "--telemetry") == 0 && i + 1 < argc) telemetryTarget = argv[++i];
+        else if (std::strcmp(argv[i], "--telemetry-name") == 0 && i + 1 < argc) telemetryName = argv[++i];
+        else if (std::strcmp(argv[i], "--perf-hud") == 0) showPerfOverlay = true;
+        else if (std::strcmp(argv[i], "--heatmap") == 0) heatmapLevel.store(0);
+        else if (std::strcmp(argv[i], "--hitch-ms") == 0 && i + 1 < argc) {
+            hitchThresholdMs = std::max(0.0f, static_cast<float>(std::atof(argv[++i])));
+            hitchThresholdGiven = true;
+        }
+        else if (std::strcmp(argv[i], "--bloom") == 0 && i + 1 < argc) {
+            bloomScale = std::atoi(argv[++i]) >= 4 ? 4 : 2;
+            useBloom = true;
+        }
+        else if (std::strcmp(argv[i], "--split") == 0 && i + 1 < argc) splitScreenViewports = std::atoi(argv[++i]) >= 4 ? 4 : 2;
+        else if (std::strcmp(argv[i], "--quality") == 0 && i + 1 < argc) {
+            const char* name = argv[++i];
+            if (std::strcmp(name, "auto") == 0) qualityBenchmark = true;
+            else if (parseQualityLevel(name, qualityLevel)) qualityGiven = true;
+            else LOG_WARN("Unknown quality preset %s, using auto", name);
+        }
+    }
+    if (waveSourcePath) return compileWaveFile(waveSourcePath, wavesPath) ? 0 : 1;
+    if (botAgentChannel) return runBotAgent(botAgentChannel, headlessTicks); // Another process runs the game
+    if (wavesPath && !loadWaveFile(wavesPath)) return 1; // Before the world is initialized: that starts its script
+    nameTraceThread("main");
+    registerThread(THREAD_MAIN);
+    // Before the workers start; the simulation and render threads only run with a window
+    configureThreads(threadPlacement, !headless && useSimThread, !headless && useRenderThread && !lowLatencyMode);
+    setEntityLargePages(largePages); // Before any world reserves its stores
+    if (tracePath) startTrace(); // Before the workers start, so their first jobs are in it
+    startJobSystem(jobWorkers);
+    uint32_t replayOptions = 0;
+    if (replayPath) {
+        if (!loadReplay(replayPath, seed, replayOptions)) return 1; // The recording's seed and options replace the flags
+        rockCollisions = (replayOptions & REPLAY_OPTION_ROCK_COLLISIONS) != 0;
+        world.asteroidBroadphase = replayBroadphase(replayOptions);
+        world.kineticBulletHits = (replayOptions & REPLAY_OPTION_KINETIC) != 0;
+        world.lazyAsteroidMotion = (replayOptions & REPLAY_OPTION_LAZY_MOTION) != 0;
+        world.fixedPointKinematics = (replayOptions & REPLAY_OPTION_FIXED_POINT) != 0;
+        world.silhouetteHits = (replayOptions & REPLAY_OPTION_SILHOUETTE) != 0;
+        world.spatialSortAsteroids = (replayOptions & REPLAY_OPTION_SPATIAL_SORT) != 0;
+        world.scriptedWaves = (replayOptions & REPLAY_OPTION_WAVES) != 0;
+        applyGravityReplayOptions(replayOptions, world);
+        const uint32_t weapon = (replayOptions & REPLAY_OPTION_WEAPON_MASK) >> REPLAY_OPTION_WEAPON_SHIFT;
+        if (weapon >= WEAPON_COUNT) {
+            LOG_ERROR("%s was recorded with an unknown weapon (%u)", replayPath, weapon);
+            return 1;
+        }
+        world.weapon = static_cast<WeaponKind>(weapon);
+    }
+    if (world.fixedPointKinematics && world.lazyAsteroidMotion) {
+        LOG_WARN("--lazy-rocks keeps its anchors in floating point; ignored with --fixed-point");
+        world.lazyAsteroidMotion = false;
+    }
+    if ((world.gravityWells || world.rockGravity) && (world.lazyAsteroidMotion || world.fixedPointKinematics || world.kineticBulletHits)) {
+        LOG_WARN("--gravity curves the rocks' paths, which --lazy-rocks, --fixed-point and --kinetic take as straight; ignored");
+        world.gravityWells = world.rockGravity = false;
+    }
+    if (WEAPON_TRAITS[world.weapon].homing && (world.fixedPointKinematics || world.kineticBulletHits)) {
+        LOG_WARN("Missiles steer in floating point along curves, which --fixed-point and --kinetic do not follow; using the blaster");
+        world.weapon = WEAPON_BLASTER;
+    }
+    if (arenaMode && (replayPath || recordPath || scenarioName || batchWorlds > 0 || headless)) {
+        LOG_WARN("--arena plays in the window only, without recording, replays or scenarios; ignored");
+        arenaMode = false;
+    }
+    if (shedBudgetMs > 0.0f && (replayPath || recordPath || batchWorlds > 0 || arenaMode)) {
+        LOG_WARN("--shed-budget caps the rocks from outside the world, so not with recording, replays, --batch or --arena; ignored");
+        shedBudgetMs = 0.0f;
+    }
+    if (botCount > 0 && (replayPath || recordPath || batchWorlds > 0 || arenaMode)) {
+        LOG_WARN("--bots flies extra ships in the world's own game, without recording, replays, --batch or --arena; ignored");
+        botCount = 0;
+    }
+    if (botChannelName && (replayPath || recordPath || batchWorlds > 0 || scenarioName || botPilot)) {
+        LOG_WARN("--bot-channel hands the ship to an agent, without recording, replays, --batch, scenarios or --autopilot; ignored");
+        botChannelName = NULL;
+    }
+    if (botPilot && (replayPath || recordPath || batchWorlds > 0 || arenaMode)) {
+        LOG_WARN("--autopilot flies the world's own ship, without recording, replays, --batch or --arena; ignored");
+        botPilot = false;
+    }
+    if (spectateTarget && (replayPath || recordPath || batchWorlds > 0 || scenarioName || headless || arenaMode || botCount > 0 || botPilot)) {
+        LOG_WARN("--spectate only draws what the server sends, without recording, replays, --batch, scenarios, --headless, --arena or bots; ignored");
+        spectateTarget = NULL;
+    }
+    if (useLateLatch && (replayPath || botPilot || botChannelName || spectateTarget || arenaMode)) {
+        LOG_WARN("--late-latch extrapolates the ship by the keys held, which do not fly it in replays, --autopilot, --bot-channel, --spectate or --arena; ignored");
+        useLateLatch = false;
+    }
+    if (spectateTarget) {
+        // Nothing to tick: the frame fills the snapshot itself. The resident stores key their
+        // records by handle, and a spectator's handles are new every frame.
+        useSimThread = false;
+        startFastForward = false;
+        if (useResidentBullets || useResidentRocks) LOG_WARN("--resident-bullets and --resident-rocks are off while spectating");
+        useResidentBullets = useResidentRocks = false;
+        if (!startSpectator(spectateTarget, spectateMatch)) return 1;
+    }
+    // A time budget alone leaves the batch unbounded in ticks; a tick count given with it caps it
+    if (fastForwardTicks >= 0) fastForward.ticksPerFrame = fastForwardTicks;
+    else if (fastForward.budgetMs > 0.0f) fastForward.ticksPerFrame = 0;
+    if (fastForward.ticksPerFrame == 0 && fastForward.budgetMs <= 0.0f) fastForward.ticksPerFrame = 60;
+    if (replayFrom > 0 && !replayPath) {
+        LOG_WARN("--replay-from needs --replay; starting from the beginning");
+        replayFrom = 0;
+    }
+    seedRandomStreams(seed);
+    world.seed(seed);
+    LOG_INFO("Seed: %llu", static_cast<unsigned long long>(seed));
+    if (outlineSeedGiven && (recordPath || replayPath)) LOG_WARN("--shape-seed is ignored with --record or --replay; the outlines follow the seed");
+    else if (outlineSeedGiven) {
+        seedShapeStream(outlineSeed);
+        LOG_INFO("Shape seed: %llu", static_cast<unsigned long long>(outlineSeed));
+    }
+    if (scenarioName) {
+        Scenario scenario;
+        if (!findScenario(scenarioName, scenario)) {
+            LOG_ERROR("Unknown scenario %s", scenarioName);
+            return 1;
+        }
+        applyScenario(scenario); // Before world.init: it raises the pool sizes
+        if (!hitchThresholdGiven) hitchThresholdMs = 0.0f; // Stress frames are long on purpose
+    }
+    if (arenaMode && world.weapon != WEAPON_BLASTER) {
+        LOG_WARN("The arena's ship only carries the blaster; --weapon ignored");
+        world.weapon = WEAPON_BLASTER;
+    }
+    // Room in the bullet ring for every ship's volleys (after the scenario, which may have raised it)
+    simulationLimits.maxBullets += maxBulletsFor(world.weapon) - MAX_BULLETS;
+    if (world.weapon != WEAPON_BLASTER) LOG_INFO("Weapon: %s", WEAPON_TRAITS[world.weapon].name);
+    if (botCount > 0 || botPilot) {
+        simulationLimits.ships = 1 + static_cast<int>(botCount);
+        simulationLimits.maxBullets += static_cast<int>(botCount) * maxBulletsFor(world.weapon);
+        bots.init(simulationLimits);
+        LOG_INFO("Bots: %zu%s", botCount, botPilot ? ", and the player's ship on autopilot" : "");
+    }
+    if (rockCollisions) world.asteroidCollisions = true;
+    if (recordPath && !replayPath) {
+        uint32_t options = (world.asteroidCollisions ? REPLAY_OPTION_ROCK_COLLISIONS : 0) |
+                           (world.asteroidBroadphase == BROADPHASE_SWEEP_AND_PRUNE ? REPLAY_OPTION_SWEEP_AND_PRUNE : 0) |
+                           (world.asteroidBroadphase == BROADPHASE_BRUTE_FORCE ? REPLAY_OPTION_BRUTE_FORCE : 0) |
+                           (world.kineticBulletHits ? REPLAY_OPTION_KINETIC : 0) |
+                           (world.lazyAsteroidMotion ? REPLAY_OPTION_LAZY_MOTION : 0) |
+                           (world.fixedPointKinematics ? REPLAY_OPTION_FIXED_POINT : 0) |
+                           (world.silhouetteHits ? REPLAY_OPTION_SILHOUETTE : 0) |
+                           (world.spatialSortAsteroids ? REPLAY_OPTION_SPATIAL_SORT : 0) |
+                           (world.scriptedWaves ? REPLAY_OPTION_WAVES : 0) |
+                           gravityReplayOptions(world) |
+                           (static_cast<uint32_t>(world.weapon) << REPLAY_OPTION_WEAPON_SHIFT);
+        if (!startRecording(recordPath, seed, options, recordChecksums)) return 1;
+    }
+    if (batchWorlds > 0) {
+        std::vector<float> atlasVertices; // Shapes are still needed for the asteroid shape indices
+        generateAsteroidShapes(atlasVertices);
+        if (batchRenderSize == 0) {
+            runBatchHeadless(batchWorlds, headlessTicks, seed);
+            if (tracePath) stopTrace(tracePath);
+            return 0;
+        }
+        if (softRender) {
+            runBatchSoftRendered(batchWorlds, headlessTicks, seed, batchRenderSize, atlasVertices, softImagePath);
+            if (tracePath) stopTrace(tracePath);
+            return 0;
+        }
+        // Rendered observations: a hidden window only for its context, nothing is ever shown
+        glfwInit();
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        applyGlContextHints();
+        GLFWwindow* batchWindow = glfwCreateWindow(1, 1, "Asteroids batch", NULL, NULL);
+        if (batchWindow == NULL) {
+            LOG_ERROR("Failed to create GLFW window");
+            glfwTerminate();
+            return -1;
+        }
+        glfwMakeContextCurrent(batchWindow);
+        if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+            LOG_ERROR("Failed to initialize GLAD");
+            glfwTerminate();
+            return -1;
+        }
+        installGlDebugOutput();
+        runBatchRendered(batchWorlds, headlessTicks, seed, batchRenderSize, atlasVertices);
+        if (tracePath) stopTrace(tracePath);
+        glfwTerminate();
+        return 0;
+    }
+    if (headless) {
+        const int result = runHeadless(headlessTicks, replayFrom);
+        if (tracePath) stopTrace(tracePath);
+        return result;
+    }
 
-        // 2. Switch to the Main Game Object Shader
-        glUseProgram(shaderProgram);
+    // --- CPU BAKES (on a worker while GLFW, the window and GLAD come up; uploaded in section 3) ---
+    // The shapes use shapeRng, seeded above, and nothing else touches them before the mesh atlas.
+    // Each bake is skipped when the asset cache holds its result under the same inputs: the shapes
+    // (and their SDF) under shapeRng's state and the atlas layout, the noise under its size and period.
+    // The SDF and the noise load after the window shows (see ASSET LOADS).
+    openAssetCache();
+    uint64_t shapeKey = assetHash(ASSET_HASH_START, shapeRng.s);
+    shapeKey = assetHash(shapeKey, ASTEROID_LOD_SEGMENTS);
+    shapeKey = assetHash(shapeKey, ASTEROID_SHAPE_COUNT);
+    shapeKey = assetHash(shapeKey, ASTEROID_OUTLINE_SAMPLES);
+    shapeKey = assetHash(shapeKey, ASTEROID_SDF_SIZE);
+    shapeKey = assetHash(shapeKey, ASTEROID_SDF_EXTENT);
+    const uint64_t noiseKey = assetHash(assetHash(ASSET_HASH_START, NOISE_TEXTURE_SIZE), NOISE_PERIOD);
+    const size_t atlasBytes = static_cast<size_t>(2 * ASTEROID_SHAPE_VERTICES * ASTEROID_SHAPE_COUNT) * sizeof(float);
+    const size_t shapeTableBytes = ASTEROID_SHAPE_COUNT * sizeof(AsteroidShape) + sizeof(shapeRng.s);
+
+    std::vector<float> atlasVertices;
+    bool shapesBaked = false;
+    JobCounter bakeJobs;
+    auto bake = [&](size_t, size_t) {
+        size_t bytes[2] = {};
+        const void* atlas = findAsset(ASSET_SHAPE_ATLAS, shapeKey, bytes[0]);
+        const void* table = findAsset(ASSET_SHAPE_TABLE, shapeKey, bytes[1]);
+        if (atlas && table && bytes[0] == atlasBytes && bytes[1] == shapeTableBytes) {
+            // The atlas is copied: setupMeshAtlas appends the ship's meshes to it
+            StartupScope scope("cached asteroid shapes");
+            const float* vertices = static_cast<const float*>(atlas);
+            atlasVertices.assign(vertices, vertices + atlasBytes / sizeof(float));
+            const AsteroidShape* shapes = static_cast<const AsteroidShape*>(table);
+            asteroidShapes.assign(shapes, shapes + ASTEROID_SHAPE_COUNT);
+            std::memcpy(shapeRng.s, shapes + ASTEROID_SHAPE_COUNT, sizeof(shapeRng.s)); // Where generating them would have left it
+            return;
+        }
+        StartupScope scope("bake asteroid shapes");
+        generateAsteroidShapes(atlasVertices);
+        shapesBaked = true;
+    };
+    parallelForAsync(0, 1, 1, bake, bakeJobs);
 
-        // --- Draw Shield (Midpoint Circle) ---
-        if (shieldActive && !isGameOver) {
-            // Calculate screen pixel coordinates for the center and radius
-            int cx = static_cast<int>((player.position.x + 1.0f) * (SCR_WIDTH / 2.0f));
-            int cy = static_cast<int>((player.position.y + 1.0f) * (SCR_HEIGHT / 2.0f));
-            int pixelRadius = static_cast<int>(SHIELD_RADIUS_FACTOR * (SCR_WIDTH / 2.0f));
+    // --- 1. GLFW/GLAD Initialization ---
+    std::chrono::steady_clock::time_point spanStart = std::chrono::steady_clock::now();
+    glfwInit();
+    startSessionClock();
+    startupSpan("glfw init", spanStart, std::chrono::steady_clock::now());
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE); // Shown once every program is built and warmed up
+    applyGlContextHints();
 
-            // Draw the circle points and update the VBO
-            drawMidpointCircle(cx, cy, pixelRadius, shieldVBO, shieldOutputBuffer);
+    spanStart = std::chrono::steady_clock::now();
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Asteroids", NULL, NULL);
+    if (window == NULL) {
+        LOG_ERROR("Failed to create GLFW window");
+        waitForJobs(bakeJobs); // The bakes reference locals of main
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetKeyCallback(window, key_callback);
+    glfwSetWindowIconifyCallback(window, window_iconify_callback);
+    glfwSetWindowFocusCallback(window, window_focus_callback);
+    applyPresentMode(window);
+    // On high-DPI displays the framebuffer is larger than the window size asked for
+    glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+    framebufferWidth = std::max(framebufferWidth, 1);
+    framebufferHeight = std::max(framebufferHeight, 1);
+    startupSpan("window + context", spanStart, std::chrono::steady_clock::now());
+
+    spanStart = std::chrono::steady_clock::now();
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+        LOG_ERROR("Failed to initialize GLAD");
+        waitForJobs(bakeJobs);
+        return -1;
+    }
+    const std::chrono::steady_clock::time_point startupStart = std::chrono::steady_clock::now();
+    startupSpan("glad load", spanStart, startupStart);
+    installGlDebugOutput();
+    logGlContextMode();
+    installGpuMemoryTracking(); // Before the first buffer, and before the shader compiler's context starts
+    // Before any buffer or vertex array below is created
+    useDirectStateAccess = allowDirectStateAccess && directStateAccessSupported();
+    LOG_INFO("Buffer updates: %s", useDirectStateAccess ? "direct state access (GL 4.5)" : "bind to edit (GL 3.3)");
+    initShadingRate();
+    if (nebulaShadingRate > 1) {
+        if (shadingRateSupported) LOG_INFO("Nebula shading: %dx%d outside the sun core (%dx%d pixel tiles)", nebulaShadingRate, nebulaShadingRate,
+                                           shadingRateTexelWidth, shadingRateTexelHeight);
+        else LOG_WARN("--bg-vrs: GL_NV_shading_rate_image is not available; the nebula is shaded per pixel");
+    }
 
-            // Render the circle
-            glm::mat4 identityModel = glm::mat4(1.0f);
-            glUniformMatrix4fv(transformLoc, 1, GL_FALSE, glm::value_ptr(identityModel));
+    // --- 2. Shader Compilation ---
+    // Built on a background context while the buffers, meshes and textures below are set up; the
+    // uniforms are set once finishShaderCompiler has returned them (after the mesh atlas)
+    // A. Game Object Shader
+    queueProgram(&shaderProgram, "game object", vertexShaderSource, fragmentShaderSource);
+    // B. Background Shader (Modified)
+    // One variant per quality preset; names and sources must outlive the compile thread
+    static std::string backgroundNames[QUALITY_LEVEL_COUNT], backgroundSources[QUALITY_LEVEL_COUNT];
+    for (int level = 0; level < QUALITY_LEVEL_COUNT; ++level) {
+        char defines[96];
+        std::snprintf(defines, sizeof(defines), "#version 330 core\n#define OCTAVES %d\n#define STAR_THRESHOLD %.4f\n",
+                      qualityPresets[level].nebulaOctaves, qualityPresets[level].starThreshold);
+        backgroundSources[level] = std::string(defines) + bgFragmentShaderBody;
+        backgroundNames[level] = std::string("background (") + qualityPresets[level].name + ")";
+        queueProgram(&backgroundVariants[level].program, backgroundNames[level].c_str(), bgVertexShader, backgroundSources[level].c_str());
+    }
+    // B1. Star sprites
+    queueProgram(&starProgram, "star sprites", starVertexShaderSource, starFragmentShaderSource);
+    // B2. Bloom blur and composite (draws the background quad)
+    queueProgram(&bloomProgram, "bloom", bgVertexShader, bloomFragmentShaderSource);
+    // C. Instanced Object Shader
+    queueProgram(&instancedProgram, "instanced object", instancedVertexShaderSource, instancedFragmentShaderSource);
+    // D. Pixel point shader (CPU-rasterized outline and shield)
+    queueProgram(&pixelPointProgram, "pixel points", pixelVertexShaderSource, fragmentShaderSource);
+    if (useLateLatch) queueProgram(&latchedShipProgram, "latched ship", latchedShipVertexShaderSource, fragmentShaderSource);
+    // D1. Primitive-restart batch shader (buffer textures set up with the mesh atlas)
+    queueProgram(&restartProgram, "restart batch", restartVertexShaderSource, instancedFragmentShaderSource);
+    // D1b. Thick outline shader (reads the same atlas buffer texture)
+    queueProgram(&thickLineProgram, "thick outline", thickLineVertexShaderSource, instancedFragmentShaderSource);
+    // D2. SDF asteroid shader (its texture is baked with the mesh atlas below)
+    queueProgram(&sdfProgram, "sdf asteroid", sdfVertexShaderSource, sdfFragmentShaderSource);
+    startShaderCompiler(window);
+
+    // E. Frame constants, shared by every program above (bound to them once they are built)
+    frameConstants.viewportSize = glm::vec2(framebufferWidth, framebufferHeight);
+    frameConstants.aspect = static_cast<float>(framebufferWidth) / framebufferHeight;
+    renderQueue.setViewports(splitScreenViewports, framebufferWidth, framebufferHeight);
+    setupFrameConstants();
+    if (useLateLatch) setupLateLatch();
+    {
+        glm::vec3 paints[PALETTE_ENTRIES];
+        std::copy(asteroidPalette, asteroidPalette + ASTEROID_PALETTE_SIZE, paints);
+        paints[PAINT_SHIP] = glm::vec3(0.2f, 0.7f, 0.7f);
+        paints[PAINT_FIRE] = glm::vec3(1.0f, 1.0f, 0.0f);
+        paints[PAINT_SHIP_GLOW] = glm::vec3(0.5f, 1.0f, 1.0f);
+        paints[PAINT_BULLET] = glm::vec3(1.0f, 0.0f, 0.0f);
+        uploadPalette(paints, PAINT_BULLET + 1);
+    }
 
-            // Use a color that fades out as the timer runs down
-            float fade = shieldTimer / SHIELD_DURATION;
-            glUniform3f(colorLoc, 0.0f, 0.8f * fade + 0.2f, 1.0f * fade + 0.2f); // Blue/Cyan
-            glPointSize(1.5f);
-            glBindVertexArray(shieldVAO);
-            glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(shieldOutputBuffer.size() / 2));
-        }
+    // --- 3. Graphics Setup (VAOs/VBOs) ---
 
-        // --- Drawing the Ship (Filled + Bresenham Outline) ---
-        if (!isGameOver)
-        {
-            glm::mat4 shipModel = glm::mat4(1.0f);
-            shipModel = glm::translate(shipModel, glm::vec3(player.position, 0.0f));
-            shipModel = glm::rotate(shipModel, player.rotation, glm::vec3(0.0f, 0.0f, 1.0f));
-            shipModel = glm::scale(shipModel, glm::vec3(player.scale, player.scale, 1.0f));
-            glUniformMatrix4fv(transformLoc, 1, GL_FALSE, glm::value_ptr(shipModel));
-
-            // Draw FILL (GL_TRIANGLE_FAN) - Darker cyan
-            glUniform3f(colorLoc, 0.2f, 0.7f, 0.7f);
-            glBindVertexArray(shipFillVAO);
-            glDrawArrays(GL_TRIANGLE_FAN, 0, 5);
-
-            // Draw OUTLINE (Bresenham) - Bright Cyan
-            drawBresenhamShip(player, bresenhamShipVBO, bresenhamOutputBuffer);
-            glm::mat4 identityModel = glm::mat4(1.0f);
-            glUniformMatrix4fv(transformLoc, 1, GL_FALSE, glm::value_ptr(identityModel));
-            glUniform3f(colorLoc, 0.5f, 1.0f, 1.0f); // Bright Outline Color
-            glPointSize(2.0f);
-            glBindVertexArray(bresenhamShipVAO);
-            glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(bresenhamOutputBuffer.size() / 2));
-        }
-
-        // --- Drawing the Thrust Fire (Filled) ---
-        if (isThrusting && !isGameOver) {
-            glm::mat4 fireModel = glm::mat4(1.0f);
-            fireModel = glm::translate(fireModel, glm::vec3(player.position, 0.0f));
-            fireModel = glm::rotate(fireModel, player.rotation, glm::vec3(0.0f, 0.0f, 1.0f));
-            float fireScaleFactor = player.scale * 1.5f;
-            fireModel = glm::scale(fireModel, glm::vec3(fireScaleFactor, fireScaleFactor, 1.0f));
-
-            glUniformMatrix4fv(transformLoc, 1, GL_FALSE, glm::value_ptr(fireModel));
+    // A. Setup Background Quad
+    spanStart = std::chrono::steady_clock::now();
+    float quad[] = { -1,-1, 1,-1, -1,1, 1,1 };
+    if (useDirectStateAccess) {
+        glCreateBuffers(1, &gradientVBO);
+        glNamedBufferData(gradientVBO, sizeof(quad), quad, GL_STATIC_DRAW);
+        glCreateVertexArrays(1, &gradientVAO);
+        glVertexArrayVertexBuffer(gradientVAO, 0, gradientVBO, 0, 2 * sizeof(float));
+        glVertexArrayAttribFormat(gradientVAO, 0, 2, GL_FLOAT, GL_FALSE, 0);
+        glVertexArrayAttribBinding(gradientVAO, 0, 0);
+        glEnableVertexArrayAttrib(gradientVAO, 0);
+    }
+    else {
+        glGenVertexArrays(1, &gradientVAO);
+        glGenBuffers(1, &gradientVBO);
+        glBindVertexArray(gradientVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, gradientVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glBindVertexArray(0);
+    }
+    startupSpan("background quad", spanStart, std::chrono::steady_clock::now());
 
-            // THRUST COLOR: Yellow (Filled)
-            glUniform3f(colorLoc, 1.0f, 1.0f, 0.0f);
-            glBindVertexArray(fireVAO);
-            glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+    // A1. Star sprites, from their own stream so they do not depend on the simulation's draws
+    spanStart = std::chrono::steady_clock::now();
+    {
+        Rng starRng;
+        starRng.seed(seed, RNG_STREAM_STARS);
+        std::vector<float> stars(STAR_SPRITE_COUNT * 4);
+        for (int i = 0; i < STAR_SPRITE_COUNT; ++i) {
+            stars[i * 4 + 0] = starRng.uniform();
+            stars[i * 4 + 1] = starRng.uniform();
+            stars[i * 4 + 2] = starRng.uniform(); // Twinkle phase and rate
+            stars[i * 4 + 3] = starRng.range(0.4f, 1.0f);
+        }
+        const GLsizeiptr bytes = static_cast<GLsizeiptr>(stars.size() * sizeof(float));
+        if (useDirectStateAccess) {
+            glCreateBuffers(1, &starVBO);
+            glNamedBufferData(starVBO, bytes, stars.data(), GL_STATIC_DRAW);
+            glCreateVertexArrays(1, &starVAO);
+            glVertexArrayVertexBuffer(starVAO, 0, starVBO, 0, 4 * sizeof(float));
+            glVertexArrayAttribFormat(starVAO, 0, 4, GL_FLOAT, GL_FALSE, 0);
+            glVertexArrayAttribBinding(starVAO, 0, 0);
+            glEnableVertexArrayAttrib(starVAO, 0);
+        }
+        else {
+            glGenVertexArrays(1, &starVAO);
+            glGenBuffers(1, &starVBO);
+            glBindVertexArray(starVAO);
+            glBindBuffer(GL_ARRAY_BUFFER, starVBO);
+            glBufferData(GL_ARRAY_BUFFER, bytes, stars.data(), GL_STATIC_DRAW);
+            glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+            glEnableVertexAttribArray(0);
+            glBindVertexArray(0);
         }
+        labelGlObject(GL_BUFFER, starVBO, "star sprites");
+    }
+    startupSpan("star sprites", spanStart, std::chrono::steady_clock::now());
+
+    // B. Ship fill and thrust fire live in the static mesh atlas (setupMeshAtlas)
+
+    // C. Streaming Buffer for all per-frame geometry (ship outline, shield, bullets, asteroid instances).
+    // Immutable storage on GL 4.4, sized from the exact outline and shield worst cases at the starting
+    // framebuffer size; resizes reserve the new worst case and any other overflow grows it.
+    {
+        StartupScope scope("stream buffer");
+        streamBuffer.init(streamBytesPerFrame());
+    }
+
+    // D. Point list VAOs: clip-space floats (bullets) and GL_SHORT pixels (Bresenham outline, shield).
+    // The attribute offset (with DSA, the binding 0 offset) is set per draw.
+    spanStart = std::chrono::steady_clock::now();
+    if (useDirectStateAccess) {
+        glCreateVertexArrays(1, &streamPointVAO);
+        glVertexArrayAttribFormat(streamPointVAO, 0, 2, GL_FLOAT, GL_FALSE, 0);
+        glVertexArrayAttribBinding(streamPointVAO, 0, 0);
+        glEnableVertexArrayAttrib(streamPointVAO, 0);
+        glCreateVertexArrays(1, &streamPixelVAO);
+        glVertexArrayAttribIFormat(streamPixelVAO, 0, 2, GL_SHORT, 0);
+        glVertexArrayAttribBinding(streamPixelVAO, 0, 0);
+        glEnableVertexArrayAttrib(streamPixelVAO, 0);
+    }
+    else {
+        glGenVertexArrays(1, &streamPointVAO);
+        glBindVertexArray(streamPointVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, streamBuffer.vbo);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glGenVertexArrays(1, &streamPixelVAO);
+        glBindVertexArray(streamPixelVAO);
+        glVertexAttribIPointer(0, 2, GL_SHORT, sizeof(PixelPoint), (void*)0);
+        glEnableVertexAttribArray(0);
+        glBindVertexArray(0);
+    }
+    startupSpan("point VAOs", spanStart, std::chrono::steady_clock::now());
+
+    // D2. Ship outline atlas (--ship-atlas): static GL_SHORT pixels, rebuilt on a resize
+    if (useShipAtlas) {
+        StartupScope scope("ship outline atlas");
+        glGenVertexArrays(1, &shipAtlasVAO);
+        glGenBuffers(1, &shipAtlasVBO);
+        glBindVertexArray(shipAtlasVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, shipAtlasVBO);
+        glVertexAttribIPointer(0, 2, GL_SHORT, sizeof(PixelPoint), (void*)0);
+        glEnableVertexAttribArray(0);
+        glBindVertexArray(0);
+        buildShipAtlas();
+    }
 
-        // --- Drawing Asteroids (Filled and Scaled) ---
-        // ASTEROID COLOR: Orange/Red (Filled)
-        // ASTEROID COLOR: Classic White/Gray Outline
-        glUniform3f(colorLoc, 0.8f, 0.8f, 0.8f); // Use a bright outline color
+    // A hull and an outline (or the bloom's glow) per ship, the player's and the bots', the exhaust pool, a fill and
+    // an outline per rock, one per bullet; draw lists: hulls, fire, exhaust, two per shape, ship outlines, bullets. The frame arena holds twice these, which leaves room for growth,
+    // restart indices and the render queue.
+    exhaust.init(static_cast<size_t>(EXHAUST_PARTICLES_PER_SHIP) * simulationLimits.ships, seed);
+    frameReservations.objectInstances = 2 * (1 + simulationLimits.ships) + exhaust.capacity() + 2 * simulationLimits.asteroidPoolCapacity() + simulationLimits.maxBullets;
+    frameReservations.asteroidDraws = simulationLimits.asteroidPoolCapacity();
+    frameReservations.fanDraws = 4 + DRAWN_ASTEROID_SHAPES * ASTEROID_LOD_COUNT;
+    frameReservations.loopDraws = 1 + DRAWN_ASTEROID_SHAPES * ASTEROID_LOD_COUNT;
+    frameReservations.pointDraws = 1;
+    frameReservations.bulletFloats = 2 * simulationLimits.maxBullets;
+    frameArena.init(2 * (frameReservations.objectInstances * sizeof(ObjectInstance)
+                         + frameReservations.asteroidDraws * sizeof(AsteroidDraw)
+                         + (frameReservations.fanDraws + 2 * frameReservations.loopDraws + frameReservations.pointDraws) * sizeof(DrawArraysIndirectCommand)
+                         + frameReservations.bulletFloats * sizeof(float)));
+    // Worst-case octant, so rasterizing never reallocates mid-frame
+    shieldRows.reserve(static_cast<size_t>(shieldPixelRadius()) + 1);
+    shieldRings.reserve(static_cast<size_t>(simulationLimits.ships));
+    world.recordEffects = true; // For the particles (the arena's rocks have none)
+    world.init(simulationLimits);
+    if (arenaMode) {
+        initArena(arena, arenaConfig, seed, static_cast<size_t>(simulationLimits.maxBullets));
+        LOG_INFO("Arena: %dx%d chunks, %zu rocks", arena.config.chunksX, arena.config.chunksY, arena.rockCount);
+    }
+    if (replayFrom > 0 && !seekReplay(replayFrom)) return 1;
 
-        // Set point size to draw them like the classic arcade vector graphics
-        glPointSize(2.0f);
-        glLineWidth(2.0f); // Set line thickness for the outline
+    // --- GPU TIMER QUERIES ---
+    {
+        StartupScope scope("gpu timers");
+        setupGpuTimers();
+    }
 
-        for (const auto& asteroid : asteroids) {
-            glm::mat4 asteroidModel = glm::mat4(1.0f);
-            asteroidModel = glm::translate(asteroidModel, glm::vec3(asteroid.position, 0.0f));
-            asteroidModel = glm::rotate(asteroidModel, asteroid.rotation, glm::vec3(0.0f, 0.0f, 1.0f));
-            asteroidModel = glm::scale(asteroidModel, glm::vec3(asteroid.scale, asteroid.scale, 1.0f));
-            glUniformMatrix4fv(transformLoc, 1, GL_FALSE, glm::value_ptr(asteroidModel));
+    // --- GPU RASTER BACKEND ---
+    {
+        StartupScope scope("gpu raster");
+        setupGpuRaster(framebufferWidth, framebufferHeight);
+        setupShieldRing(framebufferWidth, framebufferHeight);
+    }
+    if (validateRaster) {
+        waitForJobs(bakeJobs); // The bakes reference locals of main
+        finishShaderCompiler(); // The compile thread's context goes before the window's
+        int result = validateGpuRaster();
+        glfwTerminate();
+        return result;
+    }
+
+    // --- STATIC MESH ATLAS (needs the stream buffer for its per-instance attributes) ---
+    {
+        StartupScope scope("wait for bakes");
+        waitForJobs(bakeJobs);
+    }
+    if (shapesBaked) {
+        std::vector<unsigned char> table(shapeTableBytes);
+        std::memcpy(table.data(), asteroidShapes.data(), ASTEROID_SHAPE_COUNT * sizeof(AsteroidShape));
+        std::memcpy(table.data() + ASTEROID_SHAPE_COUNT * sizeof(AsteroidShape), shapeRng.s, sizeof(shapeRng.s));
+        storeAsset(ASSET_SHAPE_ATLAS, shapeKey, atlasVertices.data(), atlasBytes);
+        storeAsset(ASSET_SHAPE_TABLE, shapeKey, table.data(), table.size());
+    }
+    // Both bake on workers from here on, while the programs are finished and warmed up
+    startAssetLoad(loadAsteroidSdf(shapeKey, atlasVertices));
+    startAssetLoad(loadNoiseTexture(noiseKey));
+    {
+        StartupScope scope("mesh atlas");
+        setupMeshAtlas(atlasVertices);
+        labelGlObject(GL_BUFFER, meshVBO, "mesh atlas");
+        labelGlObject(GL_VERTEX_ARRAY, meshVAO, "mesh atlas");
+    }
+    {
+        StartupScope scope("polar shapes");
+        setupPolarShapes(seed, atlasVertices);
+    }
 
-            glBindVertexArray(asteroid.VAO_Fill);
+    // --- PROGRAMS (from the compile thread) ---
+    spanStart = std::chrono::steady_clock::now();
+    const double shaderBuildMs = finishShaderCompiler();
+    startupSpan("wait for programs", spanStart, std::chrono::steady_clock::now());
+    const double shaderWaitMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startupStart).count();
+    bindFrameConstants(shaderProgram);
+    for (const BackgroundVariant& background : backgroundVariants) bindFrameConstants(background.program);
+    bindFrameConstants(starProgram);
+    bloomDirectionLoc = glGetUniformLocation(bloomProgram, "direction");
+    glUseProgram(bloomProgram);
+    glUniform1i(glGetUniformLocation(bloomProgram, "source"), 0);
+    glUniform1f(glGetUniformLocation(bloomProgram, "intensity"), BLOOM_INTENSITY);
+    bindFrameConstants(instancedProgram);
+    bindFrameConstants(pixelPointProgram);
+    bindFrameConstants(sdfProgram);
+    bindFrameConstants(restartProgram);
+    bindFrameConstants(thickLineProgram);
+    bindFrameConstants(latchedShipProgram);
+    bindShipLatch(latchedShipProgram);
+    latchedShipColorLoc = glGetUniformLocation(latchedShipProgram, "lineColor");
+    pixelColorLoc = glGetUniformLocation(pixelPointProgram, "lineColor");
+    pixelOffsetLoc = glGetUniformLocation(pixelPointProgram, "pixelOffset");
+    restartInstanceBaseLoc = glGetUniformLocation(restartProgram, "instanceBase");
+    restartCompactLoc = glGetUniformLocation(restartProgram, "compactInstances");
+    glUseProgram(instancedProgram);
+    glUniform1i(glGetUniformLocation(instancedProgram, "polarRadii"), POLAR_SHAPE_UNIT);
+    glUseProgram(restartProgram);
+    glUniform1i(glGetUniformLocation(restartProgram, "atlas"), 3);
+    glUniform1i(glGetUniformLocation(restartProgram, "instances"), 4);
+    glUniform1i(glGetUniformLocation(restartProgram, "polarRadii"), POLAR_SHAPE_UNIT);
+    thickLineWidthLoc = glGetUniformLocation(thickLineProgram, "lineWidth");
+    glUseProgram(thickLineProgram);
+    glUniform1i(glGetUniformLocation(thickLineProgram, "atlas"), 3);
+    glUniform1i(glGetUniformLocation(thickLineProgram, "polarRadii"), POLAR_SHAPE_UNIT);
+    glUseProgram(sdfProgram);
+    glUniform1i(glGetUniformLocation(sdfProgram, "asteroidSdf"), 2);
+    glUniform1f(glGetUniformLocation(sdfProgram, "sdfExtent"), ASTEROID_SDF_EXTENT);
+    glUseProgram(0);
+    {
+        StartupScope scope("restart batching");
+        setupRestartBatching();
+    }
+    useIndirectDraw = GLAD_GL_VERSION_4_3 && glMultiDrawArraysIndirect;
 
-            // 1. Draw the FILL (Darker Shade of the base color)
-            glm::vec3 fillColor = asteroid.color * 0.5f; // Darken for filled look
-            glUniform3f(colorLoc, fillColor.x, fillColor.y, fillColor.z);
-            glDrawArrays(GL_TRIANGLE_FAN, 0, asteroid.vertexCount); // Draw the filled body
+    // --- GPU SWARM (draws with the atlas, so after it) ---
+    spanStart = std::chrono::steady_clock::now();
+    if (swarmRocks > 0 && !setupGpuSwarm(static_cast<size_t>(swarmRocks), seed, meshVBO)) {
+        LOG_WARN("--swarm needs GL 4.3 compute shaders; running without the swarm");
+    }
+    if (swarmRocks > 0) startupSpan("gpu swarm", spanStart, std::chrono::steady_clock::now());
+    if (!setupResidentBullets()) LOG_WARN("Resident bullet shader failed to build; bullets stay streamed");
+    if (!setupResidentRocks(sdfFragmentShaderSource, 2, ASTEROID_SDF_EXTENT)) LOG_WARN("Resident rock shader failed to build; rocks stay streamed");
+    if (!setupParticles()) LOG_WARN("Particle shaders failed to build; running without debris and sparks");
+    if (!setupTrails(5)) LOG_WARN("Trail shader failed to build; running without motion trails");
+    {
+        StartupScope scope("hud");
+        if (!setupHud()) LOG_WARN("HUD shader failed to build; running without score or perf overlay");
+    }
+    if (!setupBroadphaseView()) LOG_WARN("Heatmap shader failed to build; running without the broadphase heatmap");
 
-            // 2. Draw the OUTLINE (Brighter Shade of the base color)
-            glm::vec3 outlineColor = asteroid.color * 1.5f; // Brighten for outline
-            outlineColor = glm::clamp(outlineColor, 0.0f, 1.0f); // Ensure color doesn't exceed 1.0
+    // Get uniform locations once
+    for (BackgroundVariant& background : backgroundVariants) {
+        background.passLoc = glGetUniformLocation(background.program, "pass");
+        background.sourceLoc = glGetUniformLocation(background.program, "nebulaSource");
+        background.hashStarsLoc = glGetUniformLocation(background.program, "hashStars");
+        glUseProgram(background.program);
+        glUniform1i(glGetUniformLocation(background.program, "nebulaTexture"), 0);
+        glUniform1i(glGetUniformLocation(background.program, "noiseTexture"), 1);
+        glUniform1f(glGetUniformLocation(background.program, "noisePeriod"), static_cast<float>(NOISE_PERIOD));
+    }
 
-            glUniform3f(colorLoc, outlineColor.x, outlineColor.y, outlineColor.z);
-            // Draw the line loop starting at index 1 to skip the center point
-            glDrawArrays(GL_LINE_LOOP, 1, asteroid.vertexCount - 1);
+    bindStaticTextureUnits(); // Again by each asset load once its texture is in
+
+    // --- WARM-UP, THEN THE FIRST FRAME ---
+    spanStart = std::chrono::steady_clock::now();
+    const double warmUpMs = warmUpPrograms();
+    startupSpan("program warm-up", spanStart, std::chrono::steady_clock::now());
+
+    // --- QUALITY PRESET (before the window shows; the benchmark draws into its back buffer) ---
+    // Scenarios and the background benchmark stay on high so their numbers compare across machines
+    if (!qualityGiven && !qualityBenchmark && (scenarioName || benchBackground || benchUpload)) qualityLevel = QUALITY_HIGH;
+    else if (!qualityGiven) {
+        const char* renderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+        if (qualityBenchmark || !loadSavedQualityLevel(renderer, qualityLevel)) {
+            spanStart = std::chrono::steady_clock::now();
+            LOG_INFO("Quality benchmark on %s (budget %.1f ms):", renderer, QUALITY_NEBULA_BUDGET_MS);
+            qualityLevel = benchmarkQualityLevel();
+            startupSpan("quality benchmark", spanStart, std::chrono::steady_clock::now());
+            saveQualityLevel(renderer, qualityLevel);
         }
+    }
+    applyQualityLevel(qualityLevel);
+    if (requestedBackgroundScale > 0) backgroundScale = requestedBackgroundScale;
+    if (scenarioName || benchBackground || benchUpload) {
+        // Measured runs start with every asset in place; the cache is saved once they are (in a frame otherwise)
+        StartupScope scope("asset loads + cache save");
+        finishAssetLoads();
+        saveAssetCache();
+    }
+    glfwShowWindow(window);
+    LOG_INFO("Startup: %.1f ms (programs built in %.1f ms on the compile thread, ready %.1f ms into setup; warm-up draws %.1f ms)",
+             std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startupStart).count(),
+             shaderBuildMs, shaderWaitMs, warmUpMs);
+    startupReport();
+    glState.invalidate(); // Setup bound programs and vertex arrays behind the cache's back
+    if (benchBackground) {
+        int result = runBackgroundBenchmark(window);
+        glfwTerminate();
+        return result;
+    }
+    if (benchUpload) {
+        int result = runUploadBenchmark(window, pixelPointProgram, framebufferWidth, framebufferHeight, uploadPayload);
+        glfwTerminate();
+        return result;
+    }
 
-        // --- Drawing Bullets (Points) ---
-        // BULLET COLOR: Red
-        glUniform3f(colorLoc, 1.0f, 0.0f, 0.0f);
-        glBindVertexArray(bulletVAO);
-
-        for (const auto& bullet : bullets) {
-            glm::mat4 bulletModel = glm::mat4(1.0f);
-            bulletModel = glm::translate(bulletModel, glm::vec3(bullet.position, 0.0f));
-            glUniformMatrix4fv(transformLoc, 1, GL_FALSE, glm::value_ptr(bulletModel));
 
-            glPointSize(5.0f);
-            glDrawArrays(GL_POINTS, 0, 1);
+    // --- 4. Render/Game Loop ---
+    // From here on the simulation globals belong to the simulation thread (when enabled);
+    // the loop below only reads them through snapshots.
+    initSnapshot(mainThreadSnapshot);
+    // Scenario statistics cover the loop only
+    std::vector<double> scenarioFrameMs;
+    scenarioFrameMs.reserve(static_cast<size_t>(scenarioFrames));
+    const long long drawCallsAtStart = drawCallCount;
+    const unsigned long long bytesAtStart = streamBuffer.bytesWritten;
+    const std::chrono::steady_clock::time_point loopStart = std::chrono::steady_clock::now();
+    if (capturePath) startVideoCapture(capturePath, captureFps);
+    if (telemetryTarget) startTelemetry(telemetryTarget, telemetryName);
+    if (useAudio && !startAudio(seed)) LOG_WARN("Audio failed to start; running without sound");
+    if (useShapeStream) startShapeStream(seed, streamedShapeBase);
+    if (startFastForward) setFastForward(true);
+    if (useSimThread) startSimThread();
+    if (useRenderThread && lowLatencyMode) {
+        LOG_WARN("--render-thread does not work with --low-latency; rendering on the main thread");
+        useRenderThread = false;
+    }
+    if (useRenderThread) startRenderThread(window, recordFrame, presentFrame);
+    while (!glfwWindowShouldClose(window))
+    {
+        // The previous frame must be recorded before events and input change what it reads; its
+        // swap may still be running
+        if (useRenderThread) waitForRenderFrameRecorded();
+        // Frame pacing first, then events, so the input this frame uses is as fresh as possible.
+        // Idle, the loop waits on events at a low rate instead.
+        if (idleFrameInterval() > 0.0) {
+            if (!waitForIdleFrame(window)) continue;
         }
+        else {
+            beginPacedFrame();
+            glfwPollEvents();
+        }
+        std::chrono::steady_clock::time_point frameStart = std::chrono::steady_clock::now();
+        const int64_t frameTicks = clockTicks();
+        deltaTime = lastFrameTicks == 0 ? 0.0f : static_cast<float>(ticksToSeconds(frameTicks - lastFrameTicks));
+        lastFrameTicks = frameTicks;
+        // Clamp long hitches (window drag, breakpoint) so the sim does not try to catch up forever
+        simAccumulator += std::min(deltaTime, MAX_SIM_TICKS_PER_FRAME * SIM_DT);
 
-        glBindVertexArray(0);
+        // --- Input Handling ---
+        {
+            ProfileScope scope(PHASE_INPUT);
+            processInput(window);
+        }
+        if (replayFinished()) glfwSetWindowShouldClose(window, true);
+
+        // --- Fixed-Timestep Simulation ---
+        // Threaded: the simulation thread ticks on its own clock and this frame draws its newest
+        // snapshot, interpolated by how far the display is past that tick's due time.
+        // Single-threaded: tick here from the accumulator and snapshot the result.
+        float alpha;
+        const RenderSnapshot* snapshot;
+        if (spectatorActive()) {
+            // Drawn as it stands: the spectator interpolates between the server's snapshots itself
+            updateSpectatorView(mainThreadSnapshot, frameStart);
+            snapshot = &mainThreadSnapshot;
+            alpha = 1.0f;
+        }
+        else if (useSimThread) {
+            snapshot = &acquireSnapshot();
+            alpha = std::chrono::duration<float>(frameStart - snapshot->tickTime).count() / SIM_DT;
+            alpha = std::min(std::max(alpha, 0.0f), 1.0f);
+        }
+        else if (fastForwardActive() && !simulationPaused()) {
+            // The whole batch, then its last tick drawn as it stands
+            telemetryAdd(TELEMETRY_TICKS, runFastForwardBatch());
+            simAccumulator = 0.0f; // Real time resumes from here
+            captureSnapshot(mainThreadSnapshot);
+            snapshot = &mainThreadSnapshot;
+            alpha = 1.0f;
+        }
+        else {
+            if (simulationPaused()) simAccumulator = 0.0f;
+            int ticksThisFrame = 0;
+            while (simAccumulator >= SIM_DT && ticksThisFrame < MAX_SIM_TICKS_PER_FRAME) {
+                // Simulated time trails the frame by the accumulator; this tick is due one step later
+                std::chrono::steady_clock::time_point tickTime = frameStart -
+                    std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(simAccumulator - SIM_DT));
+                stepGame(inputForTick(tickTime));
+                simAccumulator -= SIM_DT;
+                ++ticksThisFrame;
+            }
+            if (ticksThisFrame == MAX_SIM_TICKS_PER_FRAME) simAccumulator = std::min(simAccumulator, SIM_DT);
+            telemetryAdd(TELEMETRY_TICKS, ticksThisFrame);
+            captureSnapshot(mainThreadSnapshot);
+            snapshot = &mainThreadSnapshot;
+            // Interpolation factor between the previous and the current tick
+            alpha = simAccumulator / SIM_DT;
+        }
+        gameOverShown = snapshot->isGameOver && snapshot->others.empty(); // Bots flying on are still worth the frame rate
+        // --- Frame handoff ---
+        frameInput.view = snapshot;
+        frameInput.alpha = alpha;
+        frameInput.time = sessionSecondsAt(frameTicks);
+        frameInput.start = frameStart;
+        if (useRenderThread) submitRenderFrame();
+        else {
+            recordFrame(window);
+            presentFrame(window);
+        }
 
-        // --- Check events and swap buffers ---
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        double frameMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+        if (scenarioActive) {
+            scenarioFrameMs.push_back(frameMs);
+            if (static_cast<long long>(scenarioFrameMs.size()) >= scenarioFrames) glfwSetWindowShouldClose(window, true);
+        }
     }
 
     // --- 5. Clean up and terminate ---
-    glDeleteVertexArrays(1, &bulletVAO);
-    glDeleteBuffers(1, &bulletVBO);
-    glDeleteVertexArrays(1, &fireVAO);
-    glDeleteBuffers(1, &fireVBO);
+    stopRenderThread(); // The context is current here again for the cleanup below
+    stopSimThread();
+    stopAudio(); // After the thread that feeds it
+    stopShapeStream();
+    stopTelemetry();
+    stopSpectator();
+    if (!arenaMode) reportLoadShedding(world);
+    logGpuMemory(); // Over a long session, created versus live shows any churn
+    reportInputLatency();
+    if (scenarioActive && !scenarioFrameMs.empty()) {
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - loopStart).count();
+        double frames = static_cast<double>(scenarioFrameMs.size());
+        writeScenarioResult(scenarioOutputPath, scenarioResultJson("rendered", scenarioTicks / seconds,
+            percentile(scenarioFrameMs, 0.5), percentile(scenarioFrameMs, 0.99),
+            (drawCallCount - drawCallsAtStart) / frames, (streamBuffer.bytesWritten - bytesAtStart) / frames, collectMemory()));
+    }
+    stopRecording();
+    if (replayActive()) profilerReport();
+    stopCapture();
+    if (traceActive()) stopTrace(tracePath); // Also an F11 recording still running (numbered then)
     glDeleteVertexArrays(1, &gradientVAO);
+    glDeleteVertexArrays(1, &starVAO);
+    glDeleteBuffers(1, &starVBO);
     glDeleteBuffers(1, &gradientVBO);
-    glDeleteVertexArrays(1, &bresenhamShipVAO);
-    glDeleteBuffers(1, &bresenhamShipVBO);
-    glDeleteVertexArrays(1, &shipFillVAO);
-    glDeleteBuffers(1, &shipFillVBO);
-    // --- SHIELD CLEANUP ---
-    glDeleteVertexArrays(1, &shieldVAO);
-    glDeleteBuffers(1, &shieldVBO);
-
-    for (const auto& asteroid : asteroids) {
-        glDeleteVertexArrays(1, &asteroid.VAO_Fill);
-        glDeleteBuffers(1, &asteroid.VBO_Fill);
+    // --- STREAMING BUFFER CLEANUP ---
+    glDeleteVertexArrays(1, &streamPointVAO);
+    glDeleteVertexArrays(1, &streamPixelVAO);
+    glDeleteVertexArrays(1, &shipAtlasVAO);
+    glDeleteBuffers(1, &shipAtlasVBO);
+    streamBuffer.destroy();
+    deletionQueue.flush();
+    destroyGpuSwarm();
+    destroyResidentBullets();
+    destroyResidentRocks();
+    destroyParticles();
+    destroyTrails();
+    destroyGpuRaster();
+    destroyShieldRing();
+    destroyHud();
+    destroyBroadphaseView();
+    if (useLateLatch) destroyLateLatch();
+    destroyFrameConstants();
+    if (nebulaFBO != 0) {
+        glDeleteFramebuffers(1, &nebulaFBO);
+        glDeleteTextures(1, &nebulaTexture);
     }
+    renderGraph.destroy();
+    if (assetLoadsPending()) {
+        // Closed before they finished: what was stored so far is still written
+        cancelAssetLoads();
+        saveAssetCache();
+    }
+    glDeleteTextures(1, &noiseTexture);
+    glDeleteTextures(1, &asteroidSdfTexture);
+
+    glDeleteVertexArrays(1, &meshVAO);
+    glDeleteBuffers(1, &meshVBO);
+    glDeleteQueries(GPU_TIMER_FRAMES * GPU_PASS_COUNT, &gpuTimerQueries[0][0]);
+    glDeleteQueries(GPU_TIMER_FRAMES * GPU_PASS_COUNT, &gpuTimestampQueries[0][0]);
 
     glDeleteProgram(shaderProgram);
-    glDeleteProgram(backgroundProgram);
+    for (const BackgroundVariant& background : backgroundVariants) glDeleteProgram(background.program);
+    glDeleteProgram(starProgram);
+    glDeleteProgram(bloomProgram);
+    glDeleteProgram(instancedProgram);
+    glDeleteProgram(pixelPointProgram);
+    glDeleteProgram(sdfProgram);
+    glDeleteProgram(restartProgram);
+    glDeleteProgram(thickLineProgram);
+    glDeleteVertexArrays(1, &restartVAO);
+    glDeleteTextures(1, &atlasTexture);
+    glDeleteTextures(1, &instanceTexture);
+    destroyPolarShapes();
     glfwTerminate();
-    return 0;
+    return replayDesyncTick() >= 0 ? 1 : 0;
 }
\ No newline at end of file
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+
+// A whole file mapped read-only into memory, for formats read in place (replays, wave files): the
+// OS pages it in as it is touched, and nothing is copied or parsed to open it.
+struct MappedFile {
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+#if defined(_WIN32)
+    void* file = nullptr; // HANDLEs (nullptr: none)
+    void* mapping = nullptr;
+#endif
+
+    bool open(const char* path); // Closes what it held first; false if the file is missing or empty
+    void close();
+    ~MappedFile() { close(); }
+};
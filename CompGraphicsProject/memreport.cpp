@@ -0,0 +1,64 @@
+#include "memreport.h"
+#include "log.h"
+
+#include <cstdio>
+#include <cstring>
+
+void MemoryReport::add(const char* subsystem, const char* name, MemoryKind kind, size_t bytes) {
+    entries.push_back({ subsystem, name, kind, bytes });
+}
+
+size_t MemoryReport::total(MemoryKind kind) const {
+    size_t bytes = 0;
+    for (const MemoryEntry& entry : entries) {
+        if (entry.kind == kind) bytes += entry.bytes;
+    }
+    return bytes;
+}
+
+// Subsystems in order of first appearance, with their CPU and GPU totals
+struct SubsystemTotals {
+    const char* name;
+    size_t cpu, gpu;
+};
+
+static std::vector<SubsystemTotals> subsystemTotals(const std::vector<MemoryEntry>& entries) {
+    std::vector<SubsystemTotals> totals;
+    for (const MemoryEntry& entry : entries) {
+        SubsystemTotals* found = nullptr;
+        for (SubsystemTotals& t : totals) {
+            if (std::strcmp(t.name, entry.subsystem) == 0) found = &t;
+        }
+        if (!found) {
+            totals.push_back({ entry.subsystem, 0, 0 });
+            found = &totals.back();
+        }
+        (entry.kind == MEMORY_CPU ? found->cpu : found->gpu) += entry.bytes;
+    }
+    return totals;
+}
+
+void MemoryReport::log() const {
+    LOG_INFO("---- Memory (KB) ----");
+    LOG_INFO("%-14s%-28s%5s%12s", "subsystem", "item", "", "KB");
+    for (const MemoryEntry& entry : entries) {
+        LOG_INFO("%-14s%-28s%5s%12.1f", entry.subsystem, entry.name, entry.kind == MEMORY_CPU ? "cpu" : "gpu", entry.bytes / 1024.0);
+    }
+    for (const SubsystemTotals& t : subsystemTotals(entries)) {
+        LOG_INFO("%-14s cpu %10.1f KB  gpu %10.1f KB", t.name, t.cpu / 1024.0, t.gpu / 1024.0);
+    }
+    LOG_INFO("%-14s cpu %10.1f KB  gpu %10.1f KB", "total", total(MEMORY_CPU) / 1024.0, total(MEMORY_GPU) / 1024.0);
+}
+
+std::string MemoryReport::json() const {
+    char buffer[128];
+    std::snprintf(buffer, sizeof(buffer), "{\"cpu\":%zu,\"gpu\":%zu,\"subsystems\":{", total(MEMORY_CPU), total(MEMORY_GPU));
+    std::string result = buffer;
+    bool first = true;
+    for (const SubsystemTotals& t : subsystemTotals(entries)) {
+        std::snprintf(buffer, sizeof(buffer), "%s\"%s\":{\"cpu\":%zu,\"gpu\":%zu}", first ? "" : ",", t.name, t.cpu, t.gpu);
+        result += buffer;
+        first = false;
+    }
+    return result + "}}";
+}
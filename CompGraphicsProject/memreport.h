@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// ============================ MEMORY REPORT ============================
+// What the game holds, in bytes, per subsystem: CPU containers at their capacity and GL buffers and
+// textures at their allocated size. Built on demand: each subsystem adds its own entries through a
+// collect*Memory function, so nothing is tracked while the game runs. Does not depend on GL; the GL
+// sizes are measured by the subsystems that own them. Printed with M, and added to scenario results.
+enum MemoryKind { MEMORY_CPU, MEMORY_GPU };
+
+struct MemoryEntry {
+    const char* subsystem;
+    const char* name;
+    MemoryKind kind;
+    size_t bytes;
+};
+
+struct MemoryReport {
+    std::vector<MemoryEntry> entries;
+
+    void add(const char* subsystem, const char* name, MemoryKind kind, size_t bytes);
+    template <typename T, typename A>
+    void addVector(const char* subsystem, const char* name, const std::vector<T, A>& vector) {
+        add(subsystem, name, MEMORY_CPU, vector.capacity() * sizeof(T));
+    }
+    size_t total(MemoryKind kind) const;
+    void log() const; // Every entry, then a CPU/GPU total per subsystem
+    std::string json() const; // {"cpu":N,"gpu":N,"subsystems":{"name":{"cpu":N,"gpu":N},...}}
+};
@@ -0,0 +1,270 @@
+#include "particles.h"
+#include "frameconstants.h"
+#include "glstate.h"
+#include "shaders.h"
+#include "memreport.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include <glad/glad.h>
+
+bool useParticles = true;
+
+// ============================ PARTICLE DATA ============================
+// One per ring slot, as attributes 0 and 1 and as the update pass's two feedback varyings
+struct Particle {
+    glm::vec2 position;
+    glm::vec2 velocity;
+    float age; // Seconds; dead once it reaches lifetime
+    float lifetime;
+    float size; // Pixels at birth
+    float paint; // Palette entry and shade bits (exact as a float)
+};
+static_assert(sizeof(Particle) == 32, "The shaders read a Particle as two vec4s");
+static_assert(PARTICLE_CAPACITY == 16384 && PARTICLES_PER_BURST == 32 && PARTICLE_MAX_BURSTS == 64,
+              "The update shader's CAPACITY, PER_BURST and MAX_BURSTS must match");
+
+struct ParticleBurst {
+    glm::vec4 motion; // position, velocity
+    glm::vec4 look; // scale, energy, debris paint, spark paint
+};
+
+static unsigned int updateProgram, drawProgram;
+static unsigned int particleBuffers[2], particleVAOs[2];
+static int current = 0; // The buffer holding the particles as last updated
+static int cursor = 0; // The slot the next burst starts at
+static int dtLoc, spawnStartLoc, spawnSlotsLoc, seedLoc, burstMotionLoc, burstLookLoc, pointScaleLoc;
+static std::vector<ParticleBurst> pendingBursts;
+static glm::vec4 burstMotion[PARTICLE_MAX_BURSTS], burstLook[PARTICLE_MAX_BURSTS];
+static double lastUpdate = -1.0;
+static double liveUntil = -1.0; // The last particle emitted so far dies by then
+static uint32_t updateCount = 0;
+
+// ============================ SHADERS ============================
+// Rasterizer discard: the varyings go to the other buffer, nothing is drawn
+static const char* updateVertexShaderSource = R"(
+    #version 330 core
+    layout (location = 0) in vec4 aMotion; // position, velocity
+    layout (location = 1) in vec4 aLife; // age, lifetime, size, paint
+    uniform float dt;
+    uniform int spawnStart; // The slots [spawnStart, spawnStart + spawnSlots) in the ring are reborn
+    uniform int spawnSlots;
+    uniform uint seed; // Differs every pass
+    uniform vec4 burstMotion[64]; // position, velocity
+    uniform vec4 burstLook[64]; // scale, energy, debris paint, spark paint
+
+    out vec4 motion;
+    out vec4 life;
+
+    const int CAPACITY = 16384;
+    const int PER_BURST = 32;
+    const float DRAG = 0.3; // Of the velocity, what is left after a second
+
+    // PCG hash step: a uniform float in [0, 1)
+    float random(inout uint state)
+    {
+        state = state * 747796405u + 2891336453u;
+        uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+        return float((word >> 22u) ^ word) * (1.0 / 4294967296.0);
+    }
+
+    void main()
+    {
+        int offset = (gl_VertexID - spawnStart + CAPACITY) % CAPACITY;
+        if (offset < spawnSlots) {
+            int burst = offset / PER_BURST;
+            vec4 origin = burstMotion[burst];
+            vec4 look = burstLook[burst];
+            uint state = uint(gl_VertexID) ^ seed;
+            float angle = 6.28318530718 * random(state);
+            vec2 direction = vec2(cos(angle), sin(angle));
+            bool spark = (offset - burst * PER_BURST) % 3 == 0;
+            // Sparks fly fast and die young; debris drifts off with the rock's own motion
+            float speed = look.y * (spark ? mix(0.6, 1.4, random(state)) : mix(0.1, 0.5, random(state)));
+            float lifetime = sqrt(look.y) * (spark ? mix(0.2, 0.5, random(state)) : mix(0.5, 1.2, random(state)));
+            vec2 start = origin.xy + direction * look.x * 0.5 * random(state); // Scattered over the rock
+            motion = vec4(start, (spark ? vec2(0.0) : origin.zw) + direction * speed);
+            life = vec4(0.0, lifetime, spark ? 2.0 : 3.0, spark ? look.w : look.z);
+            return;
+        }
+        if (aLife.x >= aLife.y) { // Dead: left as it is
+            motion = aMotion;
+            life = aLife;
+            return;
+        }
+        vec2 velocity = aMotion.zw * pow(DRAG, dt);
+        vec2 position = mod(aMotion.xy + velocity * dt + 1.0, 2.0) - 1.0; // Wrapped into the field
+        motion = vec4(position, velocity);
+        life = vec4(aLife.x + dt, aLife.yzw);
+    }
+)";
+
+static const char* updateFragmentShaderSource = R"(
+    #version 330 core
+    void main()
+    {
+    }
+)";
+
+static const char* drawVertexShaderSource = R"(
+    #version 330 core
+    layout (location = 0) in vec4 aMotion;
+    layout (location = 1) in vec4 aLife;
+    uniform float pointScale;
+
+    out vec3 particleColor;
+)" PALETTE_GLSL R"(
+    void main()
+    {
+        if (aLife.x >= aLife.y) {
+            gl_Position = vec4(2.0, 2.0, 2.0, 1.0); // Outside the clip volume: the point is dropped
+            gl_PointSize = 1.0;
+            particleColor = vec3(0.0);
+            return;
+        }
+        float left = 1.0 - aLife.x / aLife.y; // Fades and shrinks as it ages
+        particleColor = paintColor(uint(aLife.w)) * left;
+        gl_PointSize = max(1.0, aLife.z * pointScale * (0.5 + 0.5 * left));
+        gl_Position = vec4(aMotion.xy, 0.0, 1.0);
+    }
+)";
+
+static const char* drawFragmentShaderSource = R"(
+    #version 330 core
+)" FRAME_CONSTANTS_GLSL R"(
+    in vec3 particleColor;
+    out vec4 FragColor;
+
+    void main()
+    {
+        vec2 d = gl_PointCoord * 2.0 - 1.0;
+        float falloff = max(0.0, 1.0 - dot(d, d));
+        FragColor = vec4(particleColor * falloff, 1.0) * tint;
+    }
+)";
+
+// ============================ SETUP ============================
+bool setupParticles()
+{
+    static const char* const feedbackVaryings[] = { "motion", "life" };
+    updateProgram = buildProgram("particle update", updateVertexShaderSource, updateFragmentShaderSource, feedbackVaryings, 2);
+    drawProgram = buildProgram("particles", drawVertexShaderSource, drawFragmentShaderSource);
+    if (!updateProgram || !drawProgram) {
+        destroyParticles();
+        useParticles = false;
+        return false;
+    }
+    bindFrameConstants(drawProgram);
+    dtLoc = glGetUniformLocation(updateProgram, "dt");
+    spawnStartLoc = glGetUniformLocation(updateProgram, "spawnStart");
+    spawnSlotsLoc = glGetUniformLocation(updateProgram, "spawnSlots");
+    seedLoc = glGetUniformLocation(updateProgram, "seed");
+    burstMotionLoc = glGetUniformLocation(updateProgram, "burstMotion");
+    burstLookLoc = glGetUniformLocation(updateProgram, "burstLook");
+    pointScaleLoc = glGetUniformLocation(drawProgram, "pointScale");
+
+    const std::vector<Particle> dead(PARTICLE_CAPACITY, { glm::vec2(0.0f), glm::vec2(0.0f), 1.0f, 0.0f, 0.0f, 0.0f });
+    glGenVertexArrays(2, particleVAOs);
+    glGenBuffers(2, particleBuffers);
+    for (int i = 0; i < 2; ++i) {
+        glState.bindVertexArray(particleVAOs[i]);
+        glBindBuffer(GL_ARRAY_BUFFER, particleBuffers[i]);
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(dead.size() * sizeof(Particle)), dead.data(), GL_DYNAMIC_COPY);
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Particle), (void*)offsetof(Particle, position));
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Particle), (void*)offsetof(Particle, age));
+        glEnableVertexAttribArray(0);
+        glEnableVertexAttribArray(1);
+    }
+    glState.bindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    pendingBursts.reserve(PARTICLE_MAX_PENDING);
+    return true;
+}
+
+void destroyParticles()
+{
+    if (particleBuffers[0]) glDeleteBuffers(2, particleBuffers);
+    if (particleVAOs[0]) glDeleteVertexArrays(2, particleVAOs);
+    if (updateProgram) glDeleteProgram(updateProgram);
+    if (drawProgram) glDeleteProgram(drawProgram);
+    particleBuffers[0] = particleBuffers[1] = particleVAOs[0] = particleVAOs[1] = 0;
+    updateProgram = drawProgram = 0;
+    pendingBursts.clear();
+}
+
+void collectParticleMemory(MemoryReport& report)
+{
+    if (!updateProgram) return;
+    report.add("particles", "particle buffers", MEMORY_GPU, glBufferBytes(particleBuffers[0]) + glBufferBytes(particleBuffers[1]));
+    report.add("particles", "pending bursts", MEMORY_CPU, pendingBursts.capacity() * sizeof(ParticleBurst));
+}
+
+bool particlesReady()
+{
+    return updateProgram != 0;
+}
+
+// ============================ EMIT AND UPDATE ============================
+void emitParticleBurst(glm::vec2 position, glm::vec2 velocity, float scale, float energy, uint32_t debrisPaint, uint32_t sparkPaint)
+{
+    if (!updateProgram || pendingBursts.size() == PARTICLE_MAX_PENDING) return;
+    pendingBursts.push_back({ glm::vec4(position, velocity),
+                              glm::vec4(scale, energy, static_cast<float>(debrisPaint), static_cast<float>(sparkPaint)) });
+}
+
+void updateParticles(double time)
+{
+    if (!updateProgram) return;
+    // A hitch (window drag, breakpoint) moves them at most a tenth of a second
+    const float dt = lastUpdate < 0.0 ? 0.0f : static_cast<float>(std::min(std::max(time - lastUpdate, 0.0), 0.1));
+    lastUpdate = time;
+    const int bursts = static_cast<int>(std::min(pendingBursts.size(), static_cast<size_t>(PARTICLE_MAX_BURSTS)));
+    if (bursts == 0 && time > liveUntil) return;
+
+    glState.useProgram(updateProgram);
+    if (bursts > 0) {
+        for (int b = 0; b < bursts; ++b) {
+            burstMotion[b] = pendingBursts[b].motion;
+            burstLook[b] = pendingBursts[b].look;
+        }
+        pendingBursts.erase(pendingBursts.begin(), pendingBursts.begin() + bursts);
+        glUniform4fv(burstMotionLoc, bursts, &burstMotion[0].x);
+        glUniform4fv(burstLookLoc, bursts, &burstLook[0].x);
+        liveUntil = time + PARTICLE_MAX_LIFETIME;
+    }
+    glUniform1f(dtLoc, dt);
+    glUniform1i(spawnStartLoc, cursor);
+    glUniform1i(spawnSlotsLoc, bursts * PARTICLES_PER_BURST);
+    glUniform1ui(seedLoc, ++updateCount * 2654435761u);
+
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, particleBuffers[1 - current]);
+    glState.setEnabled(GL_RASTERIZER_DISCARD, true);
+    glState.bindVertexArray(particleVAOs[current]);
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArrays(GL_POINTS, 0, PARTICLE_CAPACITY);
+    glEndTransformFeedback();
+    glState.setEnabled(GL_RASTERIZER_DISCARD, false);
+    glState.bindVertexArray(0);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    current = 1 - current;
+    cursor = (cursor + bursts * PARTICLES_PER_BURST) % PARTICLE_CAPACITY;
+}
+
+// ============================ DRAW ============================
+int drawParticles(float pointScale)
+{
+    if (!drawProgram || lastUpdate > liveUntil) return 0;
+    glState.useProgram(drawProgram);
+    glUniform1f(pointScaleLoc, pointScale);
+    glState.bindVertexArray(particleVAOs[current]);
+    glState.setEnabled(GL_PROGRAM_POINT_SIZE, true);
+    glState.setEnabled(GL_BLEND, true);
+    glBlendFunc(GL_ONE, GL_ONE);
+    glDrawArrays(GL_POINTS, 0, PARTICLE_CAPACITY);
+    glState.setEnabled(GL_BLEND, false);
+    glState.setEnabled(GL_PROGRAM_POINT_SIZE, false);
+    glState.bindVertexArray(0);
+    return 1;
+}
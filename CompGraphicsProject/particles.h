@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+struct MemoryReport;
+
+// Debris and sparks (on by default, --no-particles turns them off, toggle with C). The particles live
+// only on the GPU: a fixed ring of them in two vertex buffers, and every frame one transform
+// feedback pass (GL 3.3, no compute) reads one buffer, ages and moves every particle, and writes the
+// other, which the point sprite draw then reads in a single call. The CPU never sees a particle:
+// each burst is a few uniforms (where, how fast, how big, which paints), and the update pass turns
+// the ring slots after the cursor into that burst's PARTICLES_PER_BURST particles, spread by a hash
+// of the slot. New particles overwrite the oldest, which are long dead by then.
+//
+// The bursts come from the simulation's effect events (simulation.h: a rock shot, split or absorbed
+// by a shield, a ship lost), which the renderer takes from its snapshots (simthread.h).
+
+// ============================ PARTICLE STATE ============================
+extern bool useParticles; // Emit, move and draw the particles (toggle with C)
+const int PARTICLE_CAPACITY = 16384; // Ring slots
+const int PARTICLES_PER_BURST = 32; // A third of them sparks, the rest debris
+const int PARTICLE_MAX_BURSTS = 64; // Per update pass (uniform arrays); the rest wait for the next frame
+const size_t PARTICLE_MAX_PENDING = 1024; // Bursts waiting; any more are dropped
+const float PARTICLE_MAX_LIFETIME = 2.4f; // Seconds, the longest a particle lives (a ship's debris)
+
+// ============================ PARTICLE API ============================
+// Builds the programs and the two buffers, every slot dead; false (and useParticles off) if it fails
+bool setupParticles();
+void destroyParticles();
+bool particlesReady(); // Set up, so useParticles may be turned on
+void collectParticleMemory(MemoryReport& report); // Nothing unless set up
+
+// Queues a burst for the next update. `energy` scales its speed and lifetime (1: a SMALL rock's; at
+// most 4, whose debris lives PARTICLE_MAX_LIFETIME). The debris takes `debrisPaint`, the sparks
+// `sparkPaint` (palette entries with their shade bits).
+void emitParticleBurst(glm::vec2 position, glm::vec2 velocity, float scale, float energy, uint32_t debrisPaint, uint32_t sparkPaint);
+// Emits the queued bursts and moves every particle to `time` (seconds, the frame's clock). Skipped,
+// as is the draw, once every particle has died.
+void updateParticles(double time);
+// Draws the live particles as additive point sprites `pointScale` times their size in pixels.
+// Returns the draw calls issued.
+int drawParticles(float pointScale);
@@ -0,0 +1,91 @@
+#include "polarshapes.h"
+#include "gldebug.h"
+#include "glstate.h"
+#include "log.h"
+#include "memreport.h"
+#include "random.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <glad/glad.h>
+
+unsigned int polarShapeTexture = 0;
+int polarShapeCount = 0;
+static unsigned int polarShapeBuffer = 0;
+
+uint8_t encodePolarRadius(float radius) {
+    const float step = std::round((radius - POLAR_RADIUS_MIN) / POLAR_RADIUS_RANGE * 255.0f);
+    return static_cast<uint8_t>(std::clamp(step, 0.0f, 255.0f));
+}
+
+// ============================ TABLE ============================
+// One entry's radii from a finest-level boundary (POLAR_SHAPE_POINTS points, x and y interleaved)
+static void encodePolarShape(const float* boundary, uint8_t* radii) {
+    for (int i = 0; i < POLAR_SHAPE_POINTS; ++i) radii[i] = encodePolarRadius(std::hypot(boundary[2 * i], boundary[2 * i + 1]));
+}
+
+void setupPolarShapes(uint64_t seed, const std::vector<float>& atlasVertices) {
+    GLint maxTexels = 65536; // The least GL 3.3 allows
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+    polarShapeCount = std::min(POLAR_SHAPE_COUNT, static_cast<int>(maxTexels / POLAR_SHAPE_POINTS));
+
+    std::vector<uint8_t> radii(static_cast<size_t>(polarShapeCount) * POLAR_SHAPE_POINTS);
+    const int finest = ASTEROID_LOD_COUNT - 1;
+    for (int k = 0; k < ASTEROID_SHAPE_COUNT; ++k) {
+        const AsteroidMesh& mesh = asteroidShapes[static_cast<size_t>(k)].lods[finest];
+        encodePolarShape(&atlasVertices[static_cast<size_t>(mesh.baseVertex + 1) * 2], &radii[static_cast<size_t>(k) * POLAR_SHAPE_POINTS]);
+    }
+    Rng rng;
+    rng.seed(seed, RNG_STREAM_POLAR_SHAPES);
+    float fillVertices[2 * (POLAR_SHAPE_POINTS + 2)];
+    for (int k = ASTEROID_SHAPE_COUNT; k < polarShapeCount; ++k) {
+        generateFilledAsteroidVertices(POLAR_SHAPE_POINTS, 1.0f, rng, fillVertices);
+        encodePolarShape(fillVertices + 2, &radii[static_cast<size_t>(k) * POLAR_SHAPE_POINTS]);
+    }
+
+    if (useDirectStateAccess) {
+        glCreateBuffers(1, &polarShapeBuffer);
+        glNamedBufferStorage(polarShapeBuffer, static_cast<GLsizeiptr>(radii.size()), radii.data(), 0);
+        glCreateTextures(GL_TEXTURE_BUFFER, 1, &polarShapeTexture);
+        glTextureBuffer(polarShapeTexture, GL_R8, polarShapeBuffer);
+    }
+    else {
+        glGenBuffers(1, &polarShapeBuffer);
+        glBindBuffer(GL_TEXTURE_BUFFER, polarShapeBuffer);
+        glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(radii.size()), radii.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        glGenTextures(1, &polarShapeTexture);
+        glBindTexture(GL_TEXTURE_BUFFER, polarShapeTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_R8, polarShapeBuffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    }
+    labelGlObject(GL_BUFFER, polarShapeBuffer, "polar shapes");
+    LOG_INFO("Polar shapes: %d silhouettes in %zu bytes (the atlas's %d take %zu)", polarShapeCount, radii.size(),
+             ASTEROID_SHAPE_COUNT, static_cast<size_t>(2 * ASTEROID_SHAPE_VERTICES * ASTEROID_SHAPE_COUNT) * sizeof(float));
+}
+
+void destroyPolarShapes() {
+    glDeleteTextures(1, &polarShapeTexture);
+    glDeleteBuffers(1, &polarShapeBuffer);
+    polarShapeTexture = 0;
+    polarShapeBuffer = 0;
+    polarShapeCount = 0;
+}
+
+// ============================ PER-ROCK CHOICE ============================
+// A pure function of the handle (stable for the rock's life, new for the next one in its slot), so
+// unlike the shape stream's choice nothing needs remembering
+int polarAsteroidShape(const AsteroidStore& rocks, size_t i) {
+    const EntityHandle handle = rocks.handles.handle(i);
+    uint32_t x = (handle.slot + 1) * 0x9E3779B1u + handle.generation;
+    x ^= x >> 16; x *= 0x7feb352du; // lowbias32, as the procedural silhouettes' shader hashes
+    x ^= x >> 15; x *= 0x846ca68bu;
+    x ^= x >> 16;
+    const int pick = static_cast<int>(x % static_cast<uint32_t>(std::max(polarShapeCount, 1)));
+    return pick < ASTEROID_SHAPE_COUNT ? rocks.shapeIndex[i] : pick;
+}
+
+void collectPolarShapeMemory(MemoryReport& report) {
+    report.add("render", "polar shapes", MEMORY_GPU, static_cast<size_t>(polarShapeCount) * POLAR_SHAPE_POINTS);
+}
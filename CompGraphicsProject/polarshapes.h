@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "simulation.h"
+
+struct MemoryReport;
+
+// Polar asteroid silhouettes (the third state of the S toggle). Every boundary point of a shape sits
+// at a known angle, 2*pi*i/64 for point i of the finest level, and only its radius varies (0.8-1.2,
+// generateFilledAsteroidVertices), so a shape is its POLAR_SHAPE_POINTS radii quantized to a byte
+// each: 64 bytes, where the atlas spends ASTEROID_SHAPE_VERTICES float pairs (1 KB) on every level's
+// fan. POLAR_SHAPE_COUNT of them go up once as a GL_R8 buffer texture, 256 KB in all, and the vertex
+// shaders rebuild each vertex from its index in the shared unit-circle fans (gl_VertexID gives the
+// level and the boundary point, the frame constants' circleFanBase where the fans start) and the
+// shape's radius there. The quantization step is 0.4/255 of a rock's radius, a twentieth of a pixel
+// for a large rock in a 800-pixel window.
+// The first ASTEROID_SHAPE_COUNT entries are the atlas's shapes, quantized from its finest level; the
+// rest come from a stream of their own. A rock picks one by its handle: a picked atlas shape is the
+// rock's own, the others are scenery, like the shape stream's, and hits still test the rock's own
+// outline. Only the batched pass's fans and outlines draw them; SDF quads, resident rocks, the swarm
+// and the legacy path keep the rock's own shape.
+
+// ============================ POLAR SHAPE CONSTANTS ============================
+const int POLAR_SHAPE_POINTS = ASTEROID_LOD_SEGMENTS[ASTEROID_LOD_COUNT - 1]; // Radii per shape, one per finest boundary point
+const int POLAR_SHAPE_COUNT = 4096; // Atlas shapes, then scenery (fewer if GL_MAX_TEXTURE_BUFFER_SIZE is short of the table)
+const float POLAR_RADIUS_MIN = 0.8f; // Byte 0; byte 255 is POLAR_RADIUS_MIN + POLAR_RADIUS_RANGE
+const float POLAR_RADIUS_RANGE = 0.4f; // Up to ASTEROID_MAX_OUTLINE_RADIUS, which the culling assumes
+const int POLAR_SHAPE_UNIT = 6; // Texture unit of the radius table (bindStaticTextureUnits)
+static_assert(POLAR_SHAPE_COUNT < 65536, "A compact instance's 16-bit shape holds the entry plus one");
+
+// Paste into a vertex shader source after FRAME_CONSTANTS_GLSL. polarShape(vertex, entry) is the
+// shape-space position of atlas vertex `vertex` of a circle fan, drawn with table entry `entry`.
+static_assert(ASTEROID_LOD_SEGMENTS[0] == 8 && POLAR_SHAPE_POINTS == 64 && ASTEROID_LOD_COUNT == 4,
+              "polarShape walks the fans' levels from 8 segments, doubling up to 64");
+#define POLAR_SHAPE_GLSL \
+    "uniform samplerBuffer polarRadii; // R8, POLAR_SHAPE_POINTS texels per entry\n" \
+    "vec2 polarShape(int vertex, uint entry) {\n" \
+    "    int point = vertex - circleFanBase;\n" \
+    "    int segments = 8;\n" \
+    "    for (int lod = 0; lod < 3 && point >= segments + 2; ++lod) {\n" \
+    "        point -= segments + 2;\n" \
+    "        segments *= 2;\n" \
+    "    }\n" \
+    "    if (point == 0) return vec2(0.0);\n" \
+    "    int finest = (point - 1) * (64 / segments) % 64;\n" \
+    "    float radius = 0.8 + 0.4 * texelFetch(polarRadii, int(entry) * 64 + finest).r;\n" \
+    "    float angle = float(finest) * (6.28318530718 / 64.0);\n" \
+    "    return radius * vec2(cos(angle), sin(angle));\n" \
+    "}\n"
+
+extern unsigned int polarShapeTexture; // 0 until setupPolarShapes
+extern int polarShapeCount; // Entries in the table
+
+// ============================ POLAR SHAPE API ============================
+uint8_t encodePolarRadius(float radius); // Rounded to the nearest step, clamped to the byte
+// Quantizes the atlas's shapes out of `atlasVertices` (generateAsteroidShapes' layout) and generates
+// the scenery from `seed`, then uploads the table (bindStaticTextureUnits puts it on POLAR_SHAPE_UNIT)
+void setupPolarShapes(uint64_t seed, const std::vector<float>& atlasVertices);
+void destroyPolarShapes();
+// The table entry rock i is drawn with, in [0, polarShapeCount)
+int polarAsteroidShape(const AsteroidStore& rocks, size_t i);
+void collectPolarShapeMemory(MemoryReport& report);
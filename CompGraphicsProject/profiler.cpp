@@ -0,0 +1,358 @@
+#include "profiler.h"
+#include "log.h"
+
+#include <cstdio>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ============================ PROFILER STATE ============================
+bool profilerPeriodicReport = false;
+float hitchThresholdMs = HITCH_DEFAULT_MS;
+
+static const char* phaseNames[PHASE_COUNT] = {
+    "input",
+    "spawn",
+    "player physics",
+    "asteroid physics",
+    "bullet physics",
+    "broadphase",
+    "asteroid collision",
+    "ship collision",
+    "bullet collision",
+    "background draw",
+    "shield draw",
+    "ship draw",
+    "asteroid draw",
+    "bullet draw",
+    "swarm",
+    "bloom",
+    "hud",
+    "swap buffers",
+    "frame",
+};
+
+static const char* counterNames[COUNTER_COUNT] = {
+    "asteroids drawn",
+    "asteroids culled",
+    "asteroid ghosts",
+    "swarm hits",
+    "gl state issued",
+    "gl state filtered",
+    "frame arena KB",
+    "allocations",
+    "allocated KB",
+    "bullets live",
+    "asteroid splits",
+    "draw calls",
+    "upload KB",
+    "arena active",
+    "arena distant",
+    "arena rocks moved",
+    "rocks shed",
+    "gpu buffers",
+    "gpu buffer KB",
+    "gpu vertex arrays",
+    "gpu available MB",
+    "gpu evictions",
+    "bullet pairs",
+    "bullet pair hits",
+};
+
+// Running totals for the frame in progress. Atomic because the simulation thread adds its phases
+// while the render thread closes frames; a tick is counted in whichever frame it finished during.
+static std::atomic<double> currentFrame[PHASE_COUNT];
+static float history[PHASE_COUNT][PROFILE_HISTORY]; // Ring buffer of per-frame totals (ms)
+static int historyHead = 0; // Next slot to write
+static int historyCount = 0; // Valid frames in the ring
+static std::atomic<unsigned long long> currentAllocations[PHASE_COUNT];
+static float allocationHistory[PHASE_COUNT][PROFILE_HISTORY];
+static AllocationTotals lastFrameTotals = { 0, 0 }; // Process totals when the last frame closed
+static long long framesClosed = 0; // For arming the allocation guard
+
+// --- Counters (closed with the CPU frame, so they share historyHead/historyCount) ---
+static std::atomic<long long> currentCounters[COUNTER_COUNT];
+static float counterHistory[COUNTER_COUNT][PROFILE_HISTORY];
+
+// --- GPU samples (own ring, since query results lag the CPU frame) ---
+static double currentGpuFrame[PHASE_COUNT] = { 0.0 };
+static bool currentGpuFrameValid = false;
+static bool gpuTimed[PHASE_COUNT] = { false }; // Phases that have ever received a GPU sample
+static float gpuHistory[PHASE_COUNT][PROFILE_HISTORY];
+static int gpuHistoryHead = 0;
+static int gpuHistoryCount = 0;
+
+static std::chrono::steady_clock::time_point lastReport = std::chrono::steady_clock::now();
+
+// ============================ HITCH RECORDER ============================
+const int HITCH_COUNTER_COLUMN = PHASE_COUNT; // Columns: phase ms, then counters, then phase allocations
+const int HITCH_ALLOCATION_COLUMN = HITCH_COUNTER_COLUMN + COUNTER_COUNT;
+const int HITCH_COLUMNS = HITCH_ALLOCATION_COLUMN + PHASE_COUNT;
+
+static float hitchRows[PROFILE_HISTORY][HITCH_COLUMNS]; // The window, oldest first, as of the last hitch
+static int hitchRowCount = 0;
+static long long hitchFirstFrame = 0; // framesClosed of hitchRows[0]
+static float hitchFrameMs = 0.0f;
+static int hitchIndex = 0; // Next hitch-NNNN.csv
+static long long lastHitchFrame = -PROFILE_HISTORY;
+static std::atomic<bool> hitchWriting(false); // hitchRows belong to the writer thread while set
+static long long hitchesSkipped = 0; // Over the threshold while a dump was being written or cooling down
+
+static void writeHitch(int index) {
+    AllowAllocations writer; // Its own thread, outside every frame
+    char path[32];
+    std::snprintf(path, sizeof(path), "hitch-%04d.csv", index);
+    std::FILE* file = std::fopen(path, "w");
+    if (file) {
+        std::fputs("frame", file);
+        for (int p = 0; p < PHASE_COUNT; ++p) std::fprintf(file, ",%s ms", phaseNames[p]);
+        for (int c = 0; c < COUNTER_COUNT; ++c) std::fprintf(file, ",%s", counterNames[c]);
+        for (int p = 0; p < PHASE_COUNT; ++p) std::fprintf(file, ",%s allocations", phaseNames[p]);
+        std::fputc('\n', file);
+        for (int row = 0; row < hitchRowCount; ++row) {
+            std::fprintf(file, "%lld", hitchFirstFrame + row);
+            for (int column = 0; column < HITCH_COLUMNS; ++column) std::fprintf(file, column < PHASE_COUNT ? ",%.3f" : ",%.0f", hitchRows[row][column]);
+            std::fputc('\n', file);
+        }
+        std::fclose(file);
+        LOG_WARN("Hitch: a %.1f ms frame (over %.1f ms); the last %d frames are in %s", hitchFrameMs, hitchThresholdMs, hitchRowCount, path);
+    }
+    else LOG_WARN("Hitch: a %.1f ms frame, but %s could not be written", hitchFrameMs, path);
+    hitchWriting.store(false, std::memory_order_release);
+}
+
+// Render thread, from profilerEndFrame: the hitch frame is the newest in the window
+static void recordHitch(float frameMs) {
+    if (framesClosed < HITCH_ARM_FRAMES) return;
+    if (framesClosed - lastHitchFrame < PROFILE_HISTORY || hitchWriting.load(std::memory_order_acquire)) {
+        ++hitchesSkipped;
+        return;
+    }
+    const int oldest = (historyHead - historyCount + PROFILE_HISTORY) % PROFILE_HISTORY;
+    for (int row = 0; row < historyCount; ++row) {
+        const int slot = (oldest + row) % PROFILE_HISTORY;
+        float* columns = hitchRows[row];
+        for (int p = 0; p < PHASE_COUNT; ++p) columns[p] = history[p][slot];
+        for (int c = 0; c < COUNTER_COUNT; ++c) columns[HITCH_COUNTER_COLUMN + c] = counterHistory[c][slot];
+        for (int p = 0; p < PHASE_COUNT; ++p) columns[HITCH_ALLOCATION_COLUMN + p] = allocationHistory[p][slot];
+    }
+    hitchRowCount = historyCount;
+    hitchFirstFrame = framesClosed - historyCount + 1;
+    hitchFrameMs = frameMs;
+    lastHitchFrame = framesClosed;
+    hitchWriting.store(true, std::memory_order_release);
+    AllowAllocations start; // One thread per dump
+    std::thread(writeHitch, hitchIndex++).detach(); // Touches nothing but hitchRows and its file
+}
+
+// ============================ PROFILER API ============================
+void profilerAdd(ProfilePhase phase, double milliseconds) {
+    currentFrame[phase].fetch_add(milliseconds, std::memory_order_relaxed);
+}
+
+void profilerAddGpu(ProfilePhase phase, double milliseconds) {
+    currentGpuFrame[phase] += milliseconds;
+    currentGpuFrameValid = true;
+    gpuTimed[phase] = true;
+}
+
+void profilerAddAllocations(ProfilePhase phase, unsigned long long count) {
+    currentAllocations[phase].fetch_add(count, std::memory_order_relaxed);
+}
+
+void profilerCount(ProfileCounter counter, long long amount) {
+    currentCounters[counter].fetch_add(amount, std::memory_order_relaxed);
+}
+
+void profilerEndFrame() {
+    for (int p = 0; p < PHASE_COUNT; ++p) {
+        history[p][historyHead] = static_cast<float>(currentFrame[p].exchange(0.0, std::memory_order_relaxed));
+        allocationHistory[p][historyHead] = static_cast<float>(currentAllocations[p].exchange(0, std::memory_order_relaxed));
+    }
+    const AllocationTotals totals = allocationTotals();
+    currentCounters[COUNTER_ALLOCATIONS].store(static_cast<long long>(totals.count - lastFrameTotals.count), std::memory_order_relaxed);
+    currentCounters[COUNTER_ALLOCATED_KB].store(static_cast<long long>((totals.bytes - lastFrameTotals.bytes) / 1024), std::memory_order_relaxed);
+    lastFrameTotals = totals;
+    if (++framesClosed == allocationGuardFrames) armAllocationGuard();
+    for (int c = 0; c < COUNTER_COUNT; ++c) {
+        counterHistory[c][historyHead] = static_cast<float>(currentCounters[c].exchange(0, std::memory_order_relaxed));
+    }
+    const float frameMs = history[PHASE_FRAME][historyHead];
+    historyHead = (historyHead + 1) % PROFILE_HISTORY;
+    historyCount = std::min(historyCount + 1, PROFILE_HISTORY);
+    if (hitchThresholdMs > 0.0f && frameMs > hitchThresholdMs) recordHitch(frameMs);
+
+    if (currentGpuFrameValid) {
+        for (int p = 0; p < PHASE_COUNT; ++p) {
+            gpuHistory[p][gpuHistoryHead] = static_cast<float>(currentGpuFrame[p]);
+            currentGpuFrame[p] = 0.0;
+        }
+        gpuHistoryHead = (gpuHistoryHead + 1) % PROFILE_HISTORY;
+        gpuHistoryCount = std::min(gpuHistoryCount + 1, PROFILE_HISTORY);
+        currentGpuFrameValid = false;
+    }
+
+    if (profilerPeriodicReport) {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (std::chrono::duration<float>(now - lastReport).count() >= PROFILE_REPORT_INTERVAL) {
+            profilerReport();
+            lastReport = now;
+        }
+    }
+}
+
+const char* profilerPhaseName(ProfilePhase phase) {
+    return phaseNames[phase];
+}
+
+const char* profilerCounterName(ProfileCounter counter) {
+    return counterNames[counter];
+}
+
+// Sorts a copy of the first `count` samples and returns min/avg/p99
+static void summarize(const float* samples, int count, float& minimum, double& average, float& p99) {
+    float sorted[PROFILE_HISTORY] = {}; // Zeroed for -Wmaybe-uninitialized (stats never passes an empty run)
+    std::copy(samples, samples + count, sorted);
+    std::sort(sorted, sorted + count);
+
+    double sum = 0.0;
+    for (int i = 0; i < count; ++i) sum += sorted[i];
+    int p99Index = std::max(0, (count * 99 + 99) / 100 - 1); // ceil(0.99 * n) - 1
+
+    minimum = sorted[0];
+    average = sum / count;
+    p99 = sorted[p99Index];
+}
+
+static ProfileStats stats(const float* samples, int count) {
+    ProfileStats result = { 0.0f, 0.0f, 0.0f };
+    if (count == 0) return result;
+    double average;
+    summarize(samples, count, result.minimum, average, result.p99);
+    result.average = static_cast<float>(average);
+    return result;
+}
+
+ProfileStats profilerPhaseStats(ProfilePhase phase) {
+    return stats(history[phase], historyCount);
+}
+
+ProfileStats profilerGpuStats(ProfilePhase phase) {
+    return stats(gpuHistory[phase], gpuTimed[phase] ? gpuHistoryCount : 0);
+}
+
+ProfileStats profilerCounterStats(ProfileCounter counter) {
+    return stats(counterHistory[counter], historyCount);
+}
+
+int profilerPhaseHistory(ProfilePhase phase, float* out, int capacity) {
+    const int count = std::min(capacity, historyCount);
+    for (int i = 0; i < count; ++i) out[i] = history[phase][(historyHead - count + i + PROFILE_HISTORY) % PROFILE_HISTORY];
+    return count;
+}
+
+void profilerReport() {
+    if (historyCount == 0) return;
+
+    // One queued log line per table row
+    LOG_INFO("---- Frame profile (last %d frames, ms) ----", historyCount);
+    LOG_INFO("%-18s%9s%9s%9s%10s%10s", "phase", "min", "avg", "p99", "gpu avg", "gpu p99");
+
+    double gpuTotal = 0.0;
+    double cpuFrame = 0.0;
+    for (int p = 0; p < PHASE_COUNT; ++p) {
+        float minimum, p99;
+        double average;
+        summarize(history[p], historyCount, minimum, average, p99);
+        if (p == PHASE_FRAME) cpuFrame = average;
+
+        char line[128];
+        int length = std::snprintf(line, sizeof(line), "%-18s%9.3f%9.3f%9.3f", phaseNames[p], minimum, average, p99);
+        if (gpuTimed[p] && gpuHistoryCount > 0) {
+            summarize(gpuHistory[p], gpuHistoryCount, minimum, average, p99);
+            gpuTotal += average;
+            std::snprintf(line + length, sizeof(line) - length, "%10.3f%10.3f", average, p99);
+        }
+        LOG_INFO("%s", line);
+    }
+
+    LOG_INFO("%-18s%9s%9s%9s", "counter", "min", "avg", "p99");
+    for (int c = 0; c < COUNTER_COUNT; ++c) {
+        float minimum, p99;
+        double average;
+        summarize(counterHistory[c], historyCount, minimum, average, p99);
+        LOG_INFO("%-18s%9.0f%9.1f%9.0f", counterNames[c], minimum, average, p99);
+    }
+    // The pair-batched search's yield over the window: how much of the gathered buffer was worth testing
+    double pairs = 0.0, pairHits = 0.0;
+    for (int i = 0; i < historyCount; ++i) {
+        pairs += counterHistory[COUNTER_BULLET_PAIRS][i];
+        pairHits += counterHistory[COUNTER_BULLET_PAIR_HITS][i];
+    }
+    if (pairs > 0.0) LOG_INFO("bullet pair hit ratio %.2f%% (%.0f hits in %.0f pairs)", 100.0 * pairHits / pairs, pairHits, pairs);
+
+    // Only phases that allocated in the window
+    for (int p = 0; p < PHASE_COUNT; ++p) {
+        float maximum = *std::max_element(allocationHistory[p], allocationHistory[p] + historyCount);
+        if (maximum == 0.0f) continue;
+        double sum = 0.0;
+        for (int i = 0; i < historyCount; ++i) sum += allocationHistory[p][i];
+        LOG_INFO("%-18s allocations avg %.1f max %.0f per frame", phaseNames[p], sum / historyCount, maximum);
+    }
+
+    if (hitchIndex > 0 || hitchesSkipped > 0) {
+        LOG_INFO("hitches over %.1f ms: %d written to hitch-NNNN.csv, %lld more inside an earlier dump's window",
+                 hitchThresholdMs, hitchIndex, hitchesSkipped);
+    }
+
+    if (gpuHistoryCount > 0) {
+        // The GPU passes run in parallel with the CPU, so whichever side takes longer sets the frame rate
+        LOG_INFO("gpu passes %.3f ms vs cpu frame %.3f ms -> %s", gpuTotal, cpuFrame,
+                 gpuTotal > cpuFrame ? "GPU-bound" : "CPU-bound");
+    }
+}
+
+// ============================ STARTUP TIMELINE ============================
+struct StartupSpanRecord {
+    std::string label;
+    std::thread::id thread;
+    std::chrono::steady_clock::time_point start, end;
+};
+
+static const std::chrono::steady_clock::time_point processStart = std::chrono::steady_clock::now();
+static std::mutex startupMutex;
+static std::vector<StartupSpanRecord> startupSpans;
+
+void startupSpan(const std::string& label, std::chrono::steady_clock::time_point start,
+                 std::chrono::steady_clock::time_point end) {
+    std::lock_guard<std::mutex> lock(startupMutex);
+    startupSpans.push_back({ label, std::this_thread::get_id(), start, end });
+}
+
+void startupReport() {
+    std::lock_guard<std::mutex> lock(startupMutex);
+    if (startupSpans.empty()) return;
+
+    std::vector<StartupSpanRecord> spans = startupSpans;
+    std::sort(spans.begin(), spans.end(),
+              [](const StartupSpanRecord& a, const StartupSpanRecord& b) { return a.start < b.start; });
+
+    // The reporting thread is the main thread; the rest are numbered in order of first appearance
+    std::vector<std::thread::id> threads{ std::this_thread::get_id() };
+    auto ms = [](std::chrono::steady_clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); };
+
+    LOG_INFO("---- Startup timeline (ms from process start) ----");
+    LOG_INFO("%-28s%-10s%10s%10s%10s", "span", "thread", "start", "end", "length");
+    for (const StartupSpanRecord& span : spans) {
+        size_t index = std::find(threads.begin(), threads.end(), span.thread) - threads.begin();
+        if (index == threads.size()) threads.push_back(span.thread);
+
+        char thread[32];
+        if (index == 0) std::snprintf(thread, sizeof(thread), "main");
+        else std::snprintf(thread, sizeof(thread), "worker %zu", index);
+        LOG_INFO("%-28s%-10s%10.2f%10.2f%10.2f", span.label.c_str(), thread,
+                 ms(span.start - processStart), ms(span.end - processStart), ms(span.end - span.start));
+    }
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+
+#include "alloctrack.h"
+#include "trace.h"
+
+// Frame profiler: scoped CPU timers around the main-loop phases, kept as a rolling window of
+// per-frame totals and reported as min/avg/p99. Does not depend on GL, so the simulation can use it;
+// GPU pass times are measured by the renderer (timer queries) and handed in with profilerAddGpu.
+
+// ============================ PROFILE PHASES ============================
+enum ProfilePhase {
+    PHASE_INPUT,
+    PHASE_SPAWN,
+    PHASE_PLAYER_PHYSICS,
+    PHASE_ASTEROID_PHYSICS,
+    PHASE_BULLET_PHYSICS,
+    PHASE_BROADPHASE,
+    PHASE_ASTEROID_COLLISION,
+    PHASE_SHIP_COLLISION,
+    PHASE_BULLET_COLLISION,
+    PHASE_BACKGROUND_DRAW,
+    PHASE_SHIELD_DRAW,
+    PHASE_SHIP_DRAW,
+    PHASE_ASTEROID_DRAW,
+    PHASE_BULLET_DRAW,
+    PHASE_SWARM, // GPU swarm step and draw (--swarm)
+    PHASE_BLOOM, // Outline glow: emissive pass, blur and composite (--bloom)
+    PHASE_HUD, // Score and perf overlay text
+    PHASE_SWAP_BUFFERS,
+    PHASE_FRAME, // Whole frame, including anything not covered by another phase
+    PHASE_COUNT
+};
+
+// ============================ PROFILE COUNTERS ============================
+// Per-frame counts (what was drawn, what was skipped), kept in the same rolling window as the phases
+enum ProfileCounter {
+    COUNTER_ASTEROIDS_DRAWN,
+    COUNTER_ASTEROIDS_CULLED,
+    COUNTER_ASTEROID_GHOSTS, // Extra images of rocks straddling a screen edge
+    COUNTER_SWARM_HITS, // GPU swarm rocks shot down (read back a frame or two late)
+    COUNTER_GL_STATE_ISSUED, // State calls that reached GL through the state cache
+    COUNTER_GL_STATE_FILTERED, // Redundant state calls the cache dropped
+    COUNTER_FRAME_ARENA_KB, // Frame arena high-water mark, heap fallbacks included
+    COUNTER_ALLOCATIONS, // operator new calls on every thread (see alloctrack.h)
+    COUNTER_ALLOCATED_KB,
+    COUNTER_BULLETS_LIVE,
+    COUNTER_ASTEROID_SPLITS, // Rocks split by the ticks that finished during the frame
+    COUNTER_DRAW_CALLS,
+    COUNTER_UPLOAD_KB, // Stream buffer bytes written
+    COUNTER_ARENA_ACTIVE_CHUNKS, // Arena chunks ticked at full rate, summed over the ticks that finished during the frame
+    COUNTER_ARENA_DISTANT_CHUNKS, // ... and at the reduced rate
+    COUNTER_ARENA_ROCKS_MOVED, // Arena rocks integrated (a distant chunk's only on its turn)
+    COUNTER_ROCKS_SHED, // Spawns and split children turned away by load shedding (loadshed.h)
+    COUNTER_GPU_BUFFERS, // Live GL buffers the game created (gpumemory.h)
+    COUNTER_GPU_BUFFER_KB, // ... and their allocated stores
+    COUNTER_GPU_VERTEX_ARRAYS,
+    COUNTER_GPU_AVAILABLE_MB, // Video memory the driver says is free (0 when it does not say)
+    COUNTER_GPU_EVICTIONS, // Driver evictions during the frame
+    COUNTER_BULLET_PAIRS, // Rock-bullet candidate pairs the pair-batched search tested (--pair-batch)
+    COUNTER_BULLET_PAIR_HITS, // ... and the hits among them
+    COUNTER_COUNT
+};
+
+const int PROFILE_HISTORY = 300; // Frames kept for the rolling statistics (~5 s at 60 FPS)
+const float PROFILE_REPORT_INTERVAL = 5.0f; // Seconds between periodic reports (when enabled)
+
+extern bool profilerPeriodicReport; // Dump a report every PROFILE_REPORT_INTERVAL seconds
+
+// ============================ HITCH RECORDER ============================
+// The rolling window doubles as a flight recorder. When a closed frame's PHASE_FRAME time is over
+// hitchThresholdMs, the whole window (every phase, counter and per-phase allocation count, oldest frame
+// first, the hitch last) is copied out and written to hitch-NNNN.csv by a thread of its own, so spikes
+// in the field reach the disk without a profiler attached and without a second hitch for the write.
+// Startup frames never count, and a dump waits until the window holds none of the last one's frames.
+const float HITCH_DEFAULT_MS = 50.0f; // Three missed refreshes at 60 Hz
+const int HITCH_ARM_FRAMES = 120; // Frames closed before the recorder arms (shader builds, first uploads)
+extern float hitchThresholdMs; // 0: off
+
+// ============================ PROFILER API ============================
+// Adds time to a phase for the current frame (a phase may run several times per frame, e.g. once per tick).
+// Safe to call from the simulation thread; everything else is for the render thread only.
+void profilerAdd(ProfilePhase phase, double milliseconds);
+// Adds GPU time to a phase. Timer query results arrive a few frames late, so they are kept in their
+// own rolling window; a frame's GPU sample is only recorded if at least one pass reported.
+void profilerAddGpu(ProfilePhase phase, double milliseconds);
+// Adds to a counter for the current frame (any thread)
+void profilerCount(ProfileCounter counter, long long amount);
+// Closes the current frame: its per-phase totals and counters go into the rolling window
+void profilerEndFrame();
+// Adds heap allocations made inside a timed phase (any thread)
+void profilerAddAllocations(ProfilePhase phase, unsigned long long count);
+// Prints min/avg/p99 per phase and per counter over the rolling window
+void profilerReport();
+const char* profilerPhaseName(ProfilePhase phase);
+const char* profilerCounterName(ProfileCounter counter);
+
+// Rolling-window statistics for on-screen display (render thread; all zero before the first frame)
+struct ProfileStats {
+    float minimum;
+    float average;
+    float p99;
+};
+ProfileStats profilerPhaseStats(ProfilePhase phase);
+ProfileStats profilerGpuStats(ProfilePhase phase); // Zero for phases without GPU samples
+ProfileStats profilerCounterStats(ProfileCounter counter);
+// Copies up to `capacity` of the latest per-frame totals of `phase`, oldest first; returns how many
+int profilerPhaseHistory(ProfilePhase phase, float* out, int capacity);
+
+// Times the enclosing scope into a phase and counts the heap allocations this thread makes in it
+// (a disabled scope reads no clock and adds nothing); also a trace span while one is recording
+struct ProfileScope {
+    ProfilePhase phase;
+    bool enabled;
+    int outerPhase; // Restored on exit, so nested scopes report the innermost phase
+    unsigned long long allocationsAtStart;
+    std::chrono::steady_clock::time_point start;
+
+    explicit ProfileScope(ProfilePhase p, bool on = true) : phase(p), enabled(on) {
+        if (!enabled) return;
+        outerPhase = threadAllocationPhase;
+        threadAllocationPhase = phase;
+        allocationsAtStart = threadAllocationCount;
+        start = std::chrono::steady_clock::now();
+    }
+    ~ProfileScope() {
+        if (!enabled) return;
+        const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        profilerAdd(phase, std::chrono::duration<double, std::milli>(end - start).count());
+        if (traceActive()) traceSpan(profilerPhaseName(phase), "phase", start, end);
+        if (threadAllocationCount != allocationsAtStart) profilerAddAllocations(phase, threadAllocationCount - allocationsAtStart);
+        threadAllocationPhase = outerPhase;
+    }
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+};
+
+// ============================ STARTUP TIMELINE ============================
+// One-shot spans recorded while the game starts (GLFW, window, GLAD, each program and buffer setup,
+// the worker bakes), kept with the thread that ran them. Safe to record from any thread.
+void startupSpan(const std::string& label, std::chrono::steady_clock::time_point start,
+                 std::chrono::steady_clock::time_point end);
+// Prints every recorded span, ordered by start, as offsets from process start
+void startupReport();
+
+// Records the enclosing scope as a startup span
+struct StartupScope {
+    std::string label;
+    std::chrono::steady_clock::time_point start;
+
+    explicit StartupScope(std::string l) : label(std::move(l)), start(std::chrono::steady_clock::now()) {}
+    ~StartupScope() { startupSpan(label, start, std::chrono::steady_clock::now()); }
+    StartupScope(const StartupScope&) = delete;
+    StartupScope& operator=(const StartupScope&) = delete;
+};
@@ -0,0 +1,46 @@
+#include "quality.h"
+#include "assetcache.h"
+
+#include <cstdint>
+#include <cstring>
+
+// High is the look the game always had: 5 octaves, 0.1% stars, full-resolution nebula
+const QualityPreset qualityPresets[QUALITY_LEVEL_COUNT] = {
+    { "low", 2, 0.9995f, 4, 0.5f },
+    { "medium", 3, 0.999f, 2, 0.75f },
+    { "high", 5, 0.999f, 1, 1.0f },
+    { "ultra", 7, 0.998f, 1, 2.0f },
+};
+
+QualityLevel qualityLevel = QUALITY_HIGH;
+
+bool parseQualityLevel(const char* name, QualityLevel& level) {
+    for (int i = 0; i < QUALITY_LEVEL_COUNT; ++i) {
+        if (std::strcmp(name, qualityPresets[i].name) == 0) {
+            level = static_cast<QualityLevel>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+// The asset cache section is keyed by the renderer string: a new GPU or driver benchmarks again
+static uint64_t rendererKey(const char* renderer) {
+    return assetHash(ASSET_HASH_START, renderer, std::strlen(renderer));
+}
+
+bool loadSavedQualityLevel(const char* renderer, QualityLevel& level) {
+    size_t bytes = 0;
+    const void* saved = findAsset(ASSET_QUALITY, rendererKey(renderer), bytes);
+    int32_t value = -1;
+    if (!saved || bytes != sizeof(value)) return false;
+    std::memcpy(&value, saved, sizeof(value));
+    if (value < 0 || value >= QUALITY_LEVEL_COUNT) return false;
+    level = static_cast<QualityLevel>(value);
+    return true;
+}
+
+void saveQualityLevel(const char* renderer, QualityLevel level) {
+    const int32_t value = level;
+    storeAsset(ASSET_QUALITY, rendererKey(renderer), &value, sizeof(value));
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+// ============================ QUALITY PRESETS ============================
+// Each preset picks a background shader variant (fbm octaves and star threshold compiled in with
+// #defines, so the octave loop has a constant bound the compiler unrolls), the nebula resolution and
+// how fine the asteroid levels of detail are. Every variant is built at startup, so switching (Q, or
+// --quality) only swaps programs. Without --quality the preset saved for this renderer is used; the
+// first run on a renderer times the nebula of each preset on the GPU and saves the finest that fits.
+// Scenario runs default to high, so their results do not depend on the machine's benchmark.
+enum QualityLevel {
+    QUALITY_LOW,
+    QUALITY_MEDIUM,
+    QUALITY_HIGH,
+    QUALITY_ULTRA,
+    QUALITY_LEVEL_COUNT
+};
+
+struct QualityPreset {
+    const char* name;
+    int nebulaOctaves; // fbm octaves of the analytic nebula
+    float starThreshold; // A pixel is a star when its hash exceeds this (higher: fewer stars)
+    int backgroundScale; // Nebula drawn at 1/N resolution and upscaled
+    float lodPixelScale; // Scales the on-screen radius asteroid levels of detail are chosen from
+};
+
+extern const QualityPreset qualityPresets[QUALITY_LEVEL_COUNT];
+extern QualityLevel qualityLevel; // Preset in use
+
+const double QUALITY_NEBULA_BUDGET_MS = 2.0; // The benchmark keeps the finest preset whose nebula fits
+
+bool parseQualityLevel(const char* name, QualityLevel& level);
+// Preset saved by an earlier run's benchmark (in the asset cache); false if there is none or it was
+// for another renderer
+bool loadSavedQualityLevel(const char* renderer, QualityLevel& level);
+// Stored for the asset cache's save at the end of startup
+void saveQualityLevel(const char* renderer, QualityLevel level);
@@ -0,0 +1,15 @@
+#include "random.h"
+
+Rng shapeRng;
+uint64_t simulationSeed = 0;
+uint64_t shapeSeed = 0;
+
+void seedRandomStreams(uint64_t seed) {
+    simulationSeed = seed;
+    seedShapeStream(seed);
+}
+
+void seedShapeStream(uint64_t seed) {
+    shapeSeed = seed;
+    shapeRng.seed(seed, RNG_STREAM_SHAPE);
+}
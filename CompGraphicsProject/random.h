@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstdint>
+
+// Deterministic random numbers for the simulation. Each subsystem draws from its own
+// xoshiro128** stream, all derived from one seed, so a run can be reproduced bit-for-bit and
+// adding a draw in one subsystem does not shift the sequence seen by the others.
+
+// ============================ GENERATOR ============================
+struct Rng {
+    uint32_t s[4] = { 1, 2, 3, 4 };
+
+    // splitmix64 expands (seed, stream) into the 128-bit state, which is never all zero
+    void seed(uint64_t seedValue, uint64_t stream) {
+        uint64_t z = seedValue ^ (stream * 0xD1B54A32D192ED03ull);
+        for (int i = 0; i < 4; i += 2) {
+            z += 0x9E3779B97F4A7C15ull;
+            uint64_t x = z;
+            x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+            x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+            x ^= x >> 31;
+            s[i] = static_cast<uint32_t>(x);
+            s[i + 1] = static_cast<uint32_t>(x >> 32);
+        }
+    }
+
+    uint32_t next() {
+        uint32_t result = rotl(s[1] * 5, 7) * 9;
+        uint32_t t = s[1] << 9;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 11);
+        return result;
+    }
+
+    // Uniform in [0, 1) from the top 24 bits (exactly representable as float)
+    float uniform() { return static_cast<float>(next() >> 8) * (1.0f / 16777216.0f); }
+    float range(float lo, float hi) { return lo + (hi - lo) * uniform(); }
+    // Uniform in [0, n) (multiply-shift, no modulo bias worth caring about for small n)
+    int below(int n) { return static_cast<int>((static_cast<uint64_t>(next()) * static_cast<uint32_t>(n)) >> 32); }
+
+    static uint32_t rotl(uint32_t x, int k) { return (x << k) | (x >> (32 - k)); }
+};
+
+// ============================ EVENT GENERATOR ============================
+// Counter-based (Philox4x32-10): the numbers for one event are a pure function of (seed, purpose,
+// tick, id), with no state carried from one event to the next, so events can be resolved on any
+// thread, in any order, and draw exactly what a single thread resolving them in turn would. The seed
+// and purpose make the key; the tick, the id and a block number make the counter, each block giving
+// four numbers (the tick is taken modulo 2^32, over two years of ticks).
+enum RngPurpose { RNG_PURPOSE_SPAWN, RNG_PURPOSE_SPLIT };
+
+struct EventRng {
+    uint32_t key[2];
+    uint32_t counter[4];
+    uint32_t block[4] = {};
+    int used = 4; // Of `block`: all of it, so the first draw makes one
+
+    EventRng(uint64_t seedValue, RngPurpose purpose, uint64_t tick, uint64_t id) {
+        uint64_t x = seedValue ^ ((static_cast<uint64_t>(purpose) + 1) * 0xD1B54A32D192ED03ull);
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        x ^= x >> 31;
+        key[0] = static_cast<uint32_t>(x);
+        key[1] = static_cast<uint32_t>(x >> 32);
+        counter[0] = 0; // The block
+        counter[1] = static_cast<uint32_t>(tick);
+        counter[2] = static_cast<uint32_t>(id);
+        counter[3] = static_cast<uint32_t>(id >> 32);
+    }
+
+    uint32_t next() {
+        if (used == 4) {
+            philox(counter, key, block);
+            ++counter[0];
+            used = 0;
+        }
+        return block[used++];
+    }
+
+    // As Rng's
+    float uniform() { return static_cast<float>(next() >> 8) * (1.0f / 16777216.0f); }
+    float range(float lo, float hi) { return lo + (hi - lo) * uniform(); }
+    int below(int n) { return static_cast<int>((static_cast<uint64_t>(next()) * static_cast<uint32_t>(n)) >> 32); }
+
+    static void philox(const uint32_t in[4], const uint32_t k[2], uint32_t out[4]) {
+        uint32_t c0 = in[0], c1 = in[1], c2 = in[2], c3 = in[3], k0 = k[0], k1 = k[1];
+        for (int round = 0; round < 10; ++round) {
+            const uint64_t p0 = static_cast<uint64_t>(0xD2511F53u) * c0, p1 = static_cast<uint64_t>(0xCD9E8D57u) * c2;
+            c0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+            c1 = static_cast<uint32_t>(p1);
+            c2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+            c3 = static_cast<uint32_t>(p0);
+            k0 += 0x9E3779B9u;
+            k1 += 0xBB67AE85u;
+        }
+        out[0] = c0; out[1] = c1; out[2] = c2; out[3] = c3;
+    }
+};
+
+// ============================ SIMULATION STREAMS ============================
+enum RngStream { RNG_STREAM_SPAWN, RNG_STREAM_SHAPE, RNG_STREAM_SPLIT, RNG_STREAM_VALIDATION, RNG_STREAM_SCENARIO, RNG_STREAM_SWARM, RNG_STREAM_STARS, RNG_STREAM_EXHAUST, RNG_STREAM_AUDIO, RNG_STREAM_SHAPE_VARIANTS, RNG_STREAM_POLAR_SHAPES };
+
+// The spawn, shape-choice and split streams belong to each GameWorld (simulation.h); only the
+// outline generation, done once for every world, draws from a shared stream.
+extern Rng shapeRng; // Outline generation
+
+extern uint64_t simulationSeed; // Seed the streams were last reset with (printed so a run can be repeated)
+// Seed the outlines were generated from: simulationSeed's unless --shape-seed gave another, and kept
+// when a restart moves simulationSeed on (the atlas is already on the GPU)
+extern uint64_t shapeSeed;
+
+// Resets the shared streams; call before generateAsteroidShapes so the outlines are reproducible too
+void seedRandomStreams(uint64_t seed);
+void seedShapeStream(uint64_t seed); // Only the outline stream (--shape-seed)
@@ -0,0 +1,201 @@
+#include "raster.h"
+#include "transform2d.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include <glm/glm.hpp>
+
+// ============================ RASTER TARGET ============================
+int framebufferWidth = 800; // The window's initial size until the first framebuffer query
+int framebufferHeight = 600;
+
+int shieldPixelRadius() { return static_cast<int>(SHIELD_RADIUS_FACTOR * (framebufferWidth / 2.0f)); }
+
+// An edge of local length L spans at most L * scale * max(W, H) / 2 pixels on either axis after any
+// rotation; truncating both ends adds at most one more step, and the line includes both endpoints.
+// The local triangle (0, 1), (-1, -1), (1, -1) has two sqrt(5) sides and a base of 2.
+size_t maxBresenhamPoints(float shipScale) {
+    const float pixelsPerUnit = 0.5f * static_cast<float>(std::max(framebufferWidth, framebufferHeight));
+    const float edgeLengths[3] = { std::sqrt(5.0f), std::sqrt(5.0f), 2.0f };
+    size_t points = 0;
+    for (float length : edgeLengths) points += static_cast<size_t>(length * shipScale * pixelsPerUnit) + 2;
+    return points;
+}
+
+// The octant walk stops at the diagonal, so it takes at most r / sqrt(2) + 2 steps (checked against
+// walkMidpointCircle for every radius up to 20000), and the circle mirrors it eight ways
+size_t maxShieldPoints() {
+    const int radius = std::max(shieldPixelRadius(), 0);
+    return 8 * (static_cast<size_t>(radius * 0.70710678f) + 2);
+}
+
+// ============================ BRESENHAM (FOR SHIP OUTLINE) ============================
+size_t bresenhamLinePointCount(int x0, int y0, int x1, int y1) {
+    return static_cast<size_t>(std::max(std::abs(x1 - x0), std::abs(y1 - y0))) + 1;
+}
+
+size_t drawBresenhamLine(int x0, int y0, int x1, int y1, PixelPoint* out) {
+    int dx = abs(x1 - x0);
+    int dy = abs(y1 - y0);
+    int sx = x0 < x1 ? 1 : -1;
+    int sy = y0 < y1 ? 1 : -1;
+    int err = dx - dy;
+
+    int x = x0;
+    int y = y0;
+
+    // Every step moves one pixel along the major axis, so the walk is exactly max(dx, dy) + 1 points
+    // and needs no end-point test
+    const size_t count = bresenhamLinePointCount(x0, y0, x1, y1);
+    for (size_t i = 0; i < count; ++i) {
+        out[i].x = static_cast<std::int16_t>(x);
+        out[i].y = static_cast<std::int16_t>(y);
+
+        int e2 = 2 * err;
+        if (e2 > -dy) {
+            err -= dy;
+            x += sx;
+        }
+        if (e2 < dx) {
+            err += dx;
+            y += sy;
+        }
+    }
+    return count;
+}
+
+void drawBresenhamLine(int x0, int y0, int x1, int y1, std::vector<PixelPoint>& points) {
+    const size_t start = points.size();
+    points.resize(start + bresenhamLinePointCount(x0, y0, x1, y1));
+    drawBresenhamLine(x0, y0, x1, y1, points.data() + start);
+}
+
+void computeShipPixelVertices(const Ship& player, int pixelVertices[6]) {
+    glm::vec2 localVertices[] = {
+        glm::vec2(0.0f,  1.0f),
+        glm::vec2(-1.0f, -1.0f),
+        glm::vec2(1.0f, -1.0f)
+    };
+
+    // Same rotate-scale-translate as the game object shader, then on to pixels, as one transform
+    const Affine2 toPixels = Affine2::fieldToPixels(framebufferWidth, framebufferHeight) * Affine2::object(player.position, player.rotation, player.scale);
+    for (int i = 0; i < 3; ++i) {
+        const glm::vec2 pixel = toPixels.apply(localVertices[i]);
+        pixelVertices[i * 2] = static_cast<int>(pixel.x);
+        pixelVertices[i * 2 + 1] = static_cast<int>(pixel.y);
+    }
+}
+
+size_t shipOutlinePointCount(const int pixelVertices[6]) {
+    const int* v = pixelVertices;
+    return bresenhamLinePointCount(v[0], v[1], v[2], v[3]) + bresenhamLinePointCount(v[2], v[3], v[4], v[5])
+         + bresenhamLinePointCount(v[4], v[5], v[0], v[1]);
+}
+
+size_t drawBresenhamShip(const int pixelVertices[6], PixelPoint* out) {
+    const int* v = pixelVertices;
+    size_t points = drawBresenhamLine(v[0], v[1], v[2], v[3], out);
+    points += drawBresenhamLine(v[2], v[3], v[4], v[5], out + points);
+    points += drawBresenhamLine(v[4], v[5], v[0], v[1], out + points);
+    return points;
+}
+
+// ============================ MIDPOINT CIRCLE ALGORITHM ============================
+size_t walkMidpointCircle(int radius, std::vector<int>& rows) {
+    rows.resize(static_cast<size_t>(std::max(radius, 0)) + 1); // x <= y <= radius, so at most radius + 1 steps
+
+    int x = 0;
+    int y = radius;
+    // The decision parameter P_k for midpoint circle algorithm
+    int p = 1 - radius; // P0 = 1 - r
+
+    size_t steps = 0;
+    rows[steps++] = y;
+
+    while (x < y) {
+        x++;
+        if (p < 0) {
+            // Select E: P_k+1 = P_k + 2x_k+1 + 1
+            p = p + 2 * x + 1;
+        }
+        else {
+            // Select SE: P_k+1 = P_k + 2x_k+1 + 1 - 2y_k+1
+            y--;
+            p = p + 2 * (x - y) + 1;
+        }
+        if (x > y) break; // Crossed the diagonal: the other octants cover the rest
+        rows[steps++] = y;
+    }
+    rows.resize(steps); // Shrinking keeps the capacity
+    return steps;
+}
+
+// One mirrored octant: point i is (cx + sx * i, cy + sy * rows[i]), or with x and y swapped. No
+// iteration depends on another, so this loop vectorizes.
+template <bool Swap>
+static void emitOctant(PixelPoint* out, const int* rows, size_t steps, int cx, int cy, int sx, int sy) {
+    for (size_t i = 0; i < steps; ++i) {
+        const int a = static_cast<int>(i);
+        const int b = rows[i];
+        out[i].x = static_cast<std::int16_t>(cx + sx * (Swap ? b : a));
+        out[i].y = static_cast<std::int16_t>(cy + sy * (Swap ? a : b));
+    }
+}
+
+size_t drawMidpointCircle(int cx, int cy, const std::vector<int>& rows, PixelPoint* out) {
+    const size_t steps = rows.size();
+    const int* r = rows.data();
+
+    emitOctant<false>(out + 0 * steps, r, steps, cx, cy,  1,  1);
+    emitOctant<false>(out + 1 * steps, r, steps, cx, cy, -1,  1);
+    emitOctant<false>(out + 2 * steps, r, steps, cx, cy,  1, -1);
+    emitOctant<false>(out + 3 * steps, r, steps, cx, cy, -1, -1);
+    emitOctant<true>(out + 4 * steps, r, steps, cx, cy,  1,  1);
+    emitOctant<true>(out + 5 * steps, r, steps, cx, cy, -1,  1);
+    emitOctant<true>(out + 6 * steps, r, steps, cx, cy,  1, -1);
+    emitOctant<true>(out + 7 * steps, r, steps, cx, cy, -1, -1);
+    return 8 * steps;
+}
+
+void drawMidpointCircle(int cx, int cy, int radius, std::vector<PixelPoint>& points) {
+    static std::vector<int> rows;
+    const size_t steps = walkMidpointCircle(radius, rows);
+    const size_t start = points.size();
+    points.resize(start + 8 * steps);
+    drawMidpointCircle(cx, cy, rows, points.data() + start);
+}
+
+// ============================ SHIP OUTLINE ATLAS ============================
+glm::ivec2 fieldPixel(glm::vec2 position) {
+    const glm::vec2 pixel = Affine2::fieldToPixels(framebufferWidth, framebufferHeight).apply(position);
+    return glm::ivec2(static_cast<int>(pixel.x), static_cast<int>(pixel.y));
+}
+
+void buildShipOutlineAtlas(float shipScale, int rotations, std::vector<PixelPoint>& points, std::vector<uint32_t>& firsts) {
+    const glm::ivec2 centre = fieldPixel(glm::vec2(0.0f));
+    points.clear();
+    firsts.clear();
+    for (int run = 0; run < rotations; ++run) {
+        Ship ship;
+        ship.position = glm::vec2(0.0f);
+        ship.rotation = run * (6.28318531f / rotations);
+        ship.scale = shipScale;
+        int v[6];
+        computeShipPixelVertices(ship, v);
+        for (int i = 0; i < 3; ++i) {
+            v[i * 2] -= centre.x;
+            v[i * 2 + 1] -= centre.y;
+        }
+        firsts.push_back(static_cast<uint32_t>(points.size()));
+        points.resize(points.size() + shipOutlinePointCount(v));
+        drawBresenhamShip(v, points.data() + firsts.back());
+    }
+    firsts.push_back(static_cast<uint32_t>(points.size()));
+}
+
+int shipAtlasRun(float rotation, int rotations) {
+    const long run = std::lround(rotation * (rotations / 6.28318531f)) % rotations;
+    return static_cast<int>(run < 0 ? run + rotations : run);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "simulation.h"
+
+// CPU pixel rasterizers for the ship outline and the shield. Each writes integer pixel coordinates
+// (two 16-bit ints per point), which the renderer streams as GL_SHORT points and the pixel point
+// shader maps to clip space. The writers take a span the caller has sized from the exact point count,
+// typically the mapped stream buffer.
+// Nothing here touches GL, which lets the benchmark target link and time them on their own.
+
+// One rasterized pixel, as uploaded (4 bytes; half the size of the float clip-space points it replaces)
+struct PixelPoint {
+    std::int16_t x;
+    std::int16_t y;
+};
+static_assert(sizeof(PixelPoint) == 4, "PixelPoint is uploaded as two GL_SHORTs");
+
+// ============================ RASTER TARGET ============================
+// Current window framebuffer in pixels, kept up to date by the resize callback (never 0, a minimized
+// window keeps its last size). The ship's pixel corners and the buffer capacities follow it.
+extern int framebufferWidth;
+extern int framebufferHeight;
+
+// Shield radius in pixels: SHIELD_RADIUS_FACTOR of the half width, as the frame draws it
+int shieldPixelRadius();
+// Exact worst-case point counts at the current framebuffer size: the outline of a ship of `shipScale`
+// at any rotation and position, and the shield circle. The stream buffer is sized from these.
+size_t maxBresenhamPoints(float shipScale = Ship().scale);
+size_t maxShieldPoints();
+
+// ============================ RASTERIZERS ============================
+// Points on the line, both endpoints included: max(|dx|, |dy|) + 1
+size_t bresenhamLinePointCount(int x0, int y0, int x1, int y1);
+// Writes exactly bresenhamLinePointCount points to `out` and returns the count
+size_t drawBresenhamLine(int x0, int y0, int x1, int y1, PixelPoint* out);
+// Appends the line to `points` (validation helpers; the frame uses the span writer)
+void drawBresenhamLine(int x0, int y0, int x1, int y1, std::vector<PixelPoint>& points);
+// Ship triangle corners in integer pixels (x0, y0, x1, y1, x2, y2)
+void computeShipPixelVertices(const Ship& player, int pixelVertices[6]);
+// The three edges of the pixel triangle, each with both corners (shared corners appear twice)
+size_t shipOutlinePointCount(const int pixelVertices[6]);
+size_t drawBresenhamShip(const int pixelVertices[6], PixelPoint* out);
+// Runs the midpoint decision loop over one octant (x = 0, 1, ... while x <= y), storing rows[x] = y,
+// and returns the step count. `rows` is reused; it only reallocates when the radius grows.
+size_t walkMidpointCircle(int radius, std::vector<int>& rows);
+// Mirrors the walked octant eight ways around (cx, cy) into `out`, one contiguous run per octant, and
+// returns the point count: 8 * rows.size() (points on the axes and diagonals appear twice)
+size_t drawMidpointCircle(int cx, int cy, const std::vector<int>& rows, PixelPoint* out);
+// Appends a whole circle to `points` (validation helpers; the frame uses the span writer)
+void drawMidpointCircle(int cx, int cy, int radius, std::vector<PixelPoint>& points);
+
+// ============================ SHIP OUTLINE ATLAS ============================
+// The pixel a point of the field lands on, truncated as computeShipPixelVertices does
+glm::ivec2 fieldPixel(glm::vec2 position);
+// The outline of a ship of `shipScale` at `rotations` evenly spaced rotations, each as
+// drawBresenhamShip writes it with the ship's centre on pixel (0, 0), for the current framebuffer.
+// The runs go one after another into `points`; run r is [firsts[r], firsts[r + 1]).
+void buildShipOutlineAtlas(float shipScale, int rotations, std::vector<PixelPoint>& points, std::vector<uint32_t>& firsts);
+// The run whose rotation is nearest `rotation` (radians, any number of turns)
+int shipAtlasRun(float rotation, int rotations);
@@ -0,0 +1,414 @@
+#include "rasterbench.h"
+#include "raster.h"
+#include "batchenv.h"
+#include "softrender.h"
+#include "simulation.h"
+#include "spatialquery.h"
+#include "log.h"
+#include "alloctrack.h"
+#include "fixedpoint.h"
+#include "random.h"
+#include "transform2d.h"
+
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+// ============================ CASES ============================
+struct RasterCase {
+    std::string name;
+    std::function<size_t()> run; // One iteration; returns the items produced (pixels or vertices)
+};
+
+static volatile float benchmarkSink; // Keeps the outputs observable so nothing is optimized away
+
+// Reused like the game's own point buffers, so steady-state runs should not allocate at all
+static std::vector<PixelPoint> lineBuffer; // Sized once to the worst case; the writers fill it as a span
+static std::vector<PixelPoint> circleBuffer;
+static std::vector<int> circleRows; // Octant walk, reused like the frame's shieldRows
+
+static std::vector<RasterCase> buildCases() {
+    std::vector<RasterCase> cases;
+
+    // --- Bresenham: every octant class at short, ship-sized and screen-sized lengths ---
+    struct Slope { const char* name; int dxNum, dyNum; }; // Direction as a fraction of the length, in thirds
+    const Slope slopes[] = { { "horizontal", 3, 0 }, { "shallow", 3, 1 }, { "diagonal", 3, 3 }, { "steep", 1, 3 }, { "vertical", 0, 3 } };
+    const int lengths[] = { 16, 128, 1024 };
+    for (const Slope& slope : slopes) {
+        for (int length : lengths) {
+            const int x0 = 16, y0 = 16;
+            const int x1 = x0 + length * slope.dxNum / 3, y1 = y0 + length * slope.dyNum / 3;
+            cases.push_back({ std::string("bresenham/") + slope.name + "/" + std::to_string(length), [=]() {
+                const size_t points = drawBresenhamLine(x0, y0, x1, y1, lineBuffer.data());
+                benchmarkSink = lineBuffer[points - 1].x;
+                return points;
+            } });
+        }
+    }
+
+    // --- Ship outline: the three edges as the frame draws them ---
+    struct ShipSize { const char* name; float scale; };
+    const ShipSize shipSizes[] = { { "game", Ship().scale }, { "large", 0.5f } };
+    for (const ShipSize& size : shipSizes) {
+        Ship ship;
+        ship.scale = size.scale;
+        ship.rotation = 0.3f; // Off-axis, so no edge is a straight run
+        cases.push_back({ std::string("ship_outline/") + size.name, [=]() {
+            int pixelVertices[6];
+            computeShipPixelVertices(ship, pixelVertices);
+            const size_t points = drawBresenhamShip(pixelVertices, lineBuffer.data());
+            benchmarkSink = lineBuffer[points - 1].x;
+            return points;
+        } });
+    }
+
+    // --- Midpoint circle: shield-sized up to screen-sized, octant walk plus the eight-way mirror ---
+    const int radii[] = { 8, 32, 128, 512 };
+    for (int radius : radii) {
+        cases.push_back({ "midpoint_circle/" + std::to_string(radius), [=]() {
+            walkMidpointCircle(radius, circleRows);
+            const size_t points = drawMidpointCircle(framebufferWidth / 2, framebufferHeight / 2, circleRows, circleBuffer.data());
+            benchmarkSink = circleBuffer[points - 1].x;
+            return points;
+        } });
+    }
+
+    // --- Filled asteroid fan: returns a fresh vector, so it allocates every call ---
+    const int segmentCounts[] = { 20, 64, 256, 1024 };
+    for (int segments : segmentCounts) {
+        cases.push_back({ "asteroid_fill/" + std::to_string(segments), [=]() {
+            std::vector<float> vertices = generateFilledAsteroidVertices(segments, 0.1f);
+            benchmarkSink = vertices.back();
+            return vertices.size() / 2;
+        } });
+    }
+
+    // --- Integration: a rock field's x, y and rotation pass, float against Q16.16 (--fixed-point) ---
+    const size_t rockCounts[] = { 1024, 65536 };
+    for (size_t rocks : rockCounts) {
+        struct Field { std::vector<float> x, y, rot, vx, vy, spin; };
+        auto field = std::make_shared<Field>();
+        Rng rng;
+        rng.seed(1, RNG_STREAM_VALIDATION);
+        for (size_t i = 0; i < rocks; ++i) {
+            field->x.push_back(fromFixed(toFixed(rng.range(-1.0f, 1.0f)))); // On the Q16.16 grid, as the fixed mode keeps them
+            field->y.push_back(fromFixed(toFixed(rng.range(-1.0f, 1.0f))));
+            field->rot.push_back(0.0f);
+            field->vx.push_back(fromFixed(toFixed(rng.range(-MAX_ASTEROID_SPEED, MAX_ASTEROID_SPEED))));
+            field->vy.push_back(fromFixed(toFixed(rng.range(-MAX_ASTEROID_SPEED, MAX_ASTEROID_SPEED))));
+            field->spin.push_back(fromFixed(toFixed(rng.range(0.3f, 0.8f))));
+        }
+        cases.push_back({ "integrate/float/" + std::to_string(rocks), [=]() {
+            integrateWrap(field->x.data(), field->vx.data(), rocks, SIM_DT);
+            integrateWrap(field->y.data(), field->vy.data(), rocks, SIM_DT);
+            integrateLinear(field->rot.data(), field->spin.data(), rocks, SIM_DT);
+            benchmarkSink = field->x[rocks - 1];
+            return rocks;
+        } });
+        cases.push_back({ "integrate/fixed/" + std::to_string(rocks), [=]() {
+            const int32_t step = toFixed(SIM_DT);
+            integrateWrapFixed(field->x.data(), field->vx.data(), rocks, step);
+            integrateWrapFixed(field->y.data(), field->vy.data(), rocks, step);
+            integrateAngleFixed(field->rot.data(), field->spin.data(), rocks, step);
+            benchmarkSink = field->x[rocks - 1];
+            return rocks;
+        } });
+    }
+
+    // --- Heading: libm's sin and cos against the fixed-point table, over a sweep of angles ---
+    const size_t headingAngles = 4096;
+    cases.push_back({ "heading/libm", [=]() {
+        float sum = 0.0f;
+        for (size_t k = 0; k < headingAngles; ++k) {
+            const float angle = static_cast<float>(k) * (6.2831853f / headingAngles);
+            sum += std::cos(angle) + std::sin(angle);
+        }
+        benchmarkSink = sum;
+        return headingAngles;
+    } });
+    cases.push_back({ "heading/table", [=]() {
+        int32_t sum = 0;
+        for (size_t k = 0; k < headingAngles; ++k) {
+            const int32_t angle = static_cast<int32_t>(k * FIXED_TWO_PI / headingAngles);
+            sum += fixedCos(angle) + fixedSin(angle);
+        }
+        benchmarkSink = static_cast<float>(sum);
+        return headingAngles;
+    } });
+
+    // --- Outline transform: 64 rocks' finest outlines to pixels, a glm::mat4 per rock (translate,
+    // rotate, scale) against a 2x3 Affine2, point by point and batched ---
+    {
+        const size_t outlineRocks = 64, outlinePoints = ASTEROID_LOD_SEGMENTS[ASTEROID_LOD_COUNT - 1];
+        struct Outlines { std::vector<float> x, y, outX, outY; std::vector<Asteroid> rocks; };
+        auto outlines = std::make_shared<Outlines>();
+        Rng rng;
+        rng.seed(3, RNG_STREAM_VALIDATION);
+        const std::vector<float> fill = generateFilledAsteroidVertices(static_cast<int>(outlinePoints), 1.0f);
+        for (size_t k = 0; k < outlinePoints; ++k) {
+            outlines->x.push_back(fill[2 + 2 * k]);
+            outlines->y.push_back(fill[3 + 2 * k]);
+        }
+        outlines->outX.resize(outlinePoints);
+        outlines->outY.resize(outlinePoints);
+        for (size_t r = 0; r < outlineRocks; ++r) {
+            Asteroid rock;
+            rock.position = glm::vec2(rng.range(-1.0f, 1.0f), rng.range(-1.0f, 1.0f));
+            rock.rotation = rng.range(0.0f, 6.2831853f);
+            rock.size = static_cast<AsteroidSize>(rng.below(ASTEROID_SIZE_COUNT));
+            outlines->rocks.push_back(rock);
+        }
+        const size_t transformed = outlineRocks * outlinePoints;
+        cases.push_back({ "transform/mat4", [=]() {
+            const glm::mat4 toPixels = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(framebufferWidth / 2.0f, framebufferHeight / 2.0f, 0.0f)),
+                                                  glm::vec3(framebufferWidth / 2.0f, framebufferHeight / 2.0f, 1.0f));
+            float sum = 0.0f;
+            for (const Asteroid& rock : outlines->rocks) {
+                glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(rock.position, 0.0f));
+                model = glm::rotate(model, rock.rotation, glm::vec3(0.0f, 0.0f, 1.0f));
+                model = glm::scale(model, glm::vec3(rock.scale(), rock.scale(), 1.0f));
+                const glm::mat4 transform = toPixels * model;
+                for (size_t k = 0; k < outlinePoints; ++k) sum += (transform * glm::vec4(outlines->x[k], outlines->y[k], 0.0f, 1.0f)).x;
+            }
+            benchmarkSink = sum;
+            return transformed;
+        } });
+        cases.push_back({ "transform/affine", [=]() {
+            const Affine2 toPixels = Affine2::fieldToPixels(framebufferWidth, framebufferHeight);
+            float sum = 0.0f;
+            for (const Asteroid& rock : outlines->rocks) {
+                const Affine2 transform = toPixels * Affine2::object(rock.position, rock.rotation, rock.scale());
+                for (size_t k = 0; k < outlinePoints; ++k) sum += transform.apply(glm::vec2(outlines->x[k], outlines->y[k])).x;
+            }
+            benchmarkSink = sum;
+            return transformed;
+        } });
+        cases.push_back({ "transform/affine_batch", [=]() {
+            const Affine2 toPixels = Affine2::fieldToPixels(framebufferWidth, framebufferHeight);
+            float sum = 0.0f;
+            for (const Asteroid& rock : outlines->rocks) {
+                const Affine2 transform = toPixels * Affine2::object(rock.position, rock.rotation, rock.scale());
+                transformPoints(transform, outlines->x.data(), outlines->y.data(), outlinePoints, outlines->outX.data(), outlines->outY.data());
+                sum += outlines->outX[outlinePoints - 1];
+            }
+            benchmarkSink = sum;
+            return transformed;
+        } });
+    }
+
+    // --- Queries: the 8 nearest rocks, the rocks within 0.1 and the first rock along a ray (a hitscan
+    // laser's, LASER_RANGE long) from 256 points, grid index against a scan; and the index's build ---
+    const size_t queryPoints = 256, queryK = 8;
+    const float queryRadiusReach = 0.1f;
+    const size_t queryRockCounts[] = { 10000, 100000 };
+    for (size_t rocks : queryRockCounts) {
+        struct Field {
+            std::vector<float> x, y, radius;
+            std::vector<glm::vec2> centers, directions;
+            SpatialQueryIndex index;
+            std::vector<QueryHit> hits;
+            std::vector<uint32_t> counts;
+            std::vector<RayHit> rayHits;
+        };
+        auto field = std::make_shared<Field>();
+        Rng rng;
+        rng.seed(2, RNG_STREAM_VALIDATION);
+        for (size_t i = 0; i < rocks; ++i) {
+            field->x.push_back(rng.range(-1.0f, 1.0f));
+            field->y.push_back(rng.range(-1.0f, 1.0f));
+            field->radius.push_back(getRadiusFactor(static_cast<AsteroidSize>(rng.below(ASTEROID_SIZE_COUNT))));
+        }
+        for (size_t q = 0; q < queryPoints; ++q) {
+            field->centers.push_back(glm::vec2(rng.range(-1.0f, 1.0f), rng.range(-1.0f, 1.0f)));
+            const float angle = rng.range(0.0f, 6.2831853f);
+            field->directions.push_back(glm::vec2(std::cos(angle), std::sin(angle)));
+        }
+        field->index.init(rocks);
+        field->index.build(field->x.data(), field->y.data(), rocks, field->radius.data());
+        field->hits.resize(queryPoints * 64);
+        field->counts.resize(queryPoints);
+        field->rayHits.resize(queryPoints);
+        const std::string suffix = "/" + std::to_string(rocks);
+        cases.push_back({ "query/knn/grid" + suffix, [=]() {
+            queryKNearestBatch(field->index, field->centers.data(), queryPoints, queryK, field->hits.data(), field->counts.data());
+            benchmarkSink = field->hits[queryK - 1].distanceSq;
+            return queryPoints;
+        } });
+        cases.push_back({ "query/knn/scan" + suffix, [=]() {
+            float sum = 0.0f;
+            for (const glm::vec2& center : field->centers) {
+                float best[queryK];
+                std::fill(best, best + queryK, 1e9f);
+                for (size_t i = 0; i < rocks; ++i) {
+                    const float dx = nearestImage(field->x[i], center.x) - center.x, dy = nearestImage(field->y[i], center.y) - center.y;
+                    float d = dx * dx + dy * dy;
+                    for (size_t slot = 0; slot < queryK && d < best[queryK - 1]; ++slot) {
+                        if (d < best[slot]) std::swap(d, best[slot]);
+                    }
+                }
+                sum += best[queryK - 1];
+            }
+            benchmarkSink = sum;
+            return queryPoints;
+        } });
+        cases.push_back({ "query/radius/grid" + suffix, [=]() {
+            queryRadiusBatch(field->index, field->centers.data(), queryPoints, queryRadiusReach, field->hits.data(), 64, field->counts.data());
+            benchmarkSink = static_cast<float>(field->counts[0]);
+            return queryPoints;
+        } });
+        cases.push_back({ "query/radius/scan" + suffix, [=]() {
+            size_t total = 0;
+            for (const glm::vec2& center : field->centers) {
+                for (size_t i = 0; i < rocks; ++i) {
+                    const float dx = nearestImage(field->x[i], center.x) - center.x, dy = nearestImage(field->y[i], center.y) - center.y;
+                    total += dx * dx + dy * dy <= queryRadiusReach * queryRadiusReach;
+                }
+            }
+            benchmarkSink = static_cast<float>(total);
+            return queryPoints;
+        } });
+        cases.push_back({ "query/ray/grid" + suffix, [=]() {
+            std::vector<RayHit>& hits = field->rayHits;
+            queryRayBatch(field->index, field->centers.data(), field->directions.data(), queryPoints, LASER_RANGE, hits.data());
+            benchmarkSink = hits[0].distance;
+            return queryPoints;
+        } });
+        cases.push_back({ "query/ray/scan" + suffix, [=]() { // Every rock at each of its 9 images a ray that long can reach
+            float sum = 0.0f;
+            for (size_t q = 0; q < queryPoints; ++q) {
+                const glm::vec2 origin = field->centers[q], direction = field->directions[q];
+                float nearest = LASER_RANGE;
+                for (size_t i = 0; i < rocks; ++i) {
+                    for (int sy = -1; sy <= 1; ++sy) {
+                        for (int sx = -1; sx <= 1; ++sx) {
+                            const glm::vec2 toCentre = glm::vec2(field->x[i] + sx * FIELD_WIDTH, field->y[i] + sy * FIELD_WIDTH) - origin;
+                            const float along = glm::dot(toCentre, direction);
+                            const float missSq = glm::dot(toCentre, toCentre) - along * along, radiusSq = field->radius[i] * field->radius[i];
+                            if (missSq > radiusSq || along < 0.0f) continue;
+                            nearest = std::min(nearest, along - std::sqrt(radiusSq - missSq));
+                        }
+                    }
+                }
+                sum += nearest;
+            }
+            benchmarkSink = sum;
+            return queryPoints;
+        } });
+        cases.push_back({ "query/build" + suffix, [=]() {
+            field->index.build(field->x.data(), field->y.data(), rocks, field->radius.data());
+            benchmarkSink = static_cast<float>(field->index.grid.entries[0]);
+            return rocks;
+        } });
+    }
+
+    // --- Software observations: 16 batch worlds a few seconds into their games, drawn whole into
+    // small and large tiles (one renderer, so each case sets it up in its warm-up) ---
+    {
+        const int softWorlds = 16;
+        auto env = std::make_shared<BatchEnvironment>();
+        auto atlas = std::make_shared<std::vector<float>>();
+        if (asteroidShapes.empty()) generateAsteroidShapes(*atlas);
+        env->init(softWorlds, 1);
+        std::vector<float> observations(softWorlds * BATCH_OBSERVATION_SIZE), rewards(softWorlds);
+        std::vector<uint8_t> dones(softWorlds);
+        InputState policy;
+        policy.left = true;
+        policy.fire = true;
+        policy.shield = true;
+        const std::vector<uint8_t> inputs(softWorlds, packInput(policy));
+        env->reset(observations.data());
+        for (int step = 0; step < 180; ++step) env->step(inputs.data(), observations.data(), rewards.data(), dones.data());
+        const int tileSizes[] = { 64, 256 };
+        for (int size : tileSizes) {
+            cases.push_back({ "soft_frame/" + std::to_string(size), [=]() {
+                if (softObservationBytes() != static_cast<size_t>(size) * size * 4) setupSoftRenderer(softWorlds, size, *atlas);
+                benchmarkSink = renderSoftObservations(*env)[0];
+                return static_cast<size_t>(softWorlds);
+            } });
+        }
+    }
+    return cases;
+}
+
+// ============================ MEASUREMENT ============================
+struct RasterResult {
+    long long iterations = 0;
+    double nsPerIteration = 0.0;
+    double itemsPerIteration = 0.0;
+    double allocationsPerIteration = 0.0;
+};
+
+static RasterResult measure(const RasterCase& benchmark, double minSeconds) {
+    typedef std::chrono::steady_clock Clock;
+    benchmark.run(); // Warm-up: sizes the reused buffers and touches the code
+
+    long long iterations = 1;
+    while (true) {
+        // Counted process-wide, but nothing else runs while a case is timed
+        const unsigned long long allocationsBefore = allocationTotals().count;
+        size_t items = 0;
+        const Clock::time_point start = Clock::now();
+        for (long long i = 0; i < iterations; ++i) items += benchmark.run();
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        const long long allocations = static_cast<long long>(allocationTotals().count - allocationsBefore);
+
+        if (seconds >= minSeconds || iterations >= (1LL << 30)) {
+            RasterResult result;
+            result.iterations = iterations;
+            result.nsPerIteration = seconds * 1e9 / iterations;
+            result.itemsPerIteration = static_cast<double>(items) / iterations;
+            result.allocationsPerIteration = static_cast<double>(allocations) / iterations;
+            return result;
+        }
+        // Aim a little past the minimum, growing by at most 10x per round (as Google Benchmark does)
+        const double scale = seconds > 0.0 ? minSeconds * 1.4 / seconds : 10.0;
+        iterations = std::max(iterations + 1, static_cast<long long>(iterations * std::min(scale, 10.0)));
+    }
+}
+
+// ============================ RUNNER ============================
+int runRasterBenchmarks(const char* filter, double minSeconds, const char* outPath) {
+    // A fixed 1080p target, so results do not depend on where the game's window was last sized
+    framebufferWidth = 1920;
+    framebufferHeight = 1080;
+    // Sized for the largest case of each kind rather than the game's ship and shield: the 1024-pixel
+    // lines, the large ship and the 512-pixel circle (radius + 1 rows per octant at most)
+    lineBuffer.resize(std::max<size_t>(1024 + 1, maxBresenhamPoints(0.5f)));
+    circleBuffer.resize(8 * (512 + 1));
+
+    FILE* out = NULL;
+    if (outPath) {
+        out = std::fopen(outPath, "a");
+        if (!out) LOG_ERROR("Could not open %s for the benchmark results", outPath);
+    }
+
+    const std::vector<RasterCase> cases = buildCases();
+    LOG_INFO("%-28s %12s %12s %10s %10s %12s", "benchmark", "iterations", "ns/iter", "items", "ns/item", "allocs/iter");
+    int run = 0;
+    for (const RasterCase& benchmark : cases) {
+        if (filter && *filter && benchmark.name.find(filter) == std::string::npos) continue;
+        const RasterResult result = measure(benchmark, minSeconds);
+        const double nsPerItem = result.itemsPerIteration > 0.0 ? result.nsPerIteration / result.itemsPerIteration : 0.0;
+        LOG_INFO("%-28s %12lld %12.1f %10.0f %10.3f %12.2f", benchmark.name.c_str(), result.iterations,
+                 result.nsPerIteration, result.itemsPerIteration, nsPerItem, result.allocationsPerIteration);
+        if (out) {
+            std::fprintf(out, "{\"benchmark\":\"%s\",\"iterations\":%lld,\"ns_per_iter\":%.2f,\"items_per_iter\":%.0f,"
+                              "\"ns_per_item\":%.4f,\"allocs_per_iter\":%.3f}\n",
+                         benchmark.name.c_str(), result.iterations, result.nsPerIteration, result.itemsPerIteration,
+                         nsPerItem, result.allocationsPerIteration);
+        }
+        ++run;
+    }
+    if (out) std::fclose(out);
+    if (run == 0) LOG_WARN("No raster benchmark matches \"%s\"", filter ? filter : "");
+    return run;
+}
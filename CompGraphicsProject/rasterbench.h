@@ -0,0 +1,15 @@
+#pragma once
+
+// Microbenchmarks for the CPU kernels: Bresenham lines over several lengths and slopes, the ship
+// outline, midpoint circles over several radii, the filled asteroid generator over several segment
+// counts, the simulation's float and Q16.16 integration kernels and headings (libm against the
+// fixed-point sine table), and the software observation renderer over a batch of worlds. Built into
+// the benchmark target only (it replaces the global operator new to count allocations). In the style
+// of Google Benchmark: each case doubles its iteration count until a run lasts at least the minimum
+// time, then reports ns per iteration, ns per item (pixel, vertex for the asteroid generator, rock or
+// angle for the kinematics, frame for the software renderer) and heap allocations per iteration.
+
+// ============================ RASTER MICROBENCHMARKS ============================
+// Runs every case whose name contains `filter` (NULL or "" runs them all) and returns the number run.
+// One JSON line per case goes to `outPath` (appended), or to the log when it is NULL.
+int runRasterBenchmarks(const char* filter, double minSeconds, const char* outPath);
@@ -0,0 +1,226 @@
+#include "relay.h"
+#include "alloctrack.h"
+#include "log.h"
+#include "replication.h"
+#include "server.h"
+#include "trace.h"
+#include "udpsocket.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+const int RELAY_RECEIVE_TIMEOUT_MS = 100; // How long the thread waits before checking for a stop and timeouts
+
+struct RelayViewer {
+    uint32_t acked = 0; // Newest relay sequence it has decoded
+    Clock::time_point lastHeard;
+};
+
+// A snapshot's datagram for the viewers that acknowledged `baseline`
+struct RelayEncoding {
+    uint32_t baseline = 0;
+    std::vector<unsigned char> datagram;
+};
+
+static RelayConfig relayConfig;
+static UdpSocket relaySocket;
+static UdpAddress upstream;
+static std::atomic<bool> relayRunning{ false };
+static std::thread relayThread;
+
+// Since the last report
+static std::atomic<int64_t> snapshotsIn{ 0 }, snapshotsOut{ 0 }, encodings{ 0 }, bytesIn{ 0 }, bytesOut{ 0 };
+static std::atomic<int> viewerCount{ 0 };
+static std::atomic<bool> joined{ false };
+static Clock::time_point lastReport;
+
+static void sendClientPacket(ClientPacketType type, uint32_t sequence, uint32_t ack) {
+    ClientPacket packet = {};
+    packet.magic = SERVER_PROTOCOL_MAGIC;
+    packet.version = SERVER_PROTOCOL_VERSION;
+    packet.type = type;
+    packet.match = relayConfig.match;
+    packet.sequence = sequence;
+    packet.ack = ack;
+    relaySocket.send(&packet, sizeof(packet), upstream);
+}
+
+static void sendViewerHeader(const UdpAddress& to, ServerPacketType type) {
+    ServerPacketHeader header = {};
+    header.magic = SERVER_PROTOCOL_MAGIC;
+    header.version = SERVER_PROTOCOL_VERSION;
+    header.type = type;
+    header.match = relayConfig.match;
+    relaySocket.send(&header, sizeof(header), to);
+}
+
+// ============================ RELAY THREAD ============================
+static void relayLoop() {
+    AllowAllocations relay; // Its own thread: viewers come and go
+    nameTraceThread("relay");
+    ReplicationReceiver receiver;
+    ReplicationBroadcast broadcast;
+    std::unordered_map<UdpAddress, RelayViewer, UdpAddressHash> viewers;
+    std::vector<RelayEncoding> encoded(RELAY_MAX_ENCODINGS + 1);
+    std::vector<unsigned char> datagram(SERVER_MAX_DATAGRAM);
+    uint32_t upstreamSequence = 0;
+    Clock::time_point lastUpstream; // Last packet sent to the server
+    Clock::time_point lastSweep = Clock::now();
+
+    while (relayRunning.load(std::memory_order_acquire)) {
+        const Clock::time_point now = Clock::now();
+        if (now - lastUpstream > std::chrono::milliseconds(RELAY_REJOIN_MS)) {
+            // Not yet in the match, or quiet for a while: join (again), or say we are still here
+            if (joined.load(std::memory_order_relaxed)) sendClientPacket(CLIENT_INPUT, ++upstreamSequence, receiver.latest);
+            else sendClientPacket(CLIENT_JOIN, 0, 0);
+            lastUpstream = now;
+        }
+        if (now - lastSweep > std::chrono::seconds(1)) {
+            for (std::unordered_map<UdpAddress, RelayViewer, UdpAddressHash>::iterator it = viewers.begin(); it != viewers.end();) {
+                if (now - it->second.lastHeard > std::chrono::milliseconds(SERVER_CLIENT_TIMEOUT_MS)) it = viewers.erase(it);
+                else ++it;
+            }
+            viewerCount.store(static_cast<int>(viewers.size()), std::memory_order_relaxed);
+            lastSweep = now;
+        }
+
+        UdpAddress from;
+        const int received = relaySocket.receive(datagram.data(), datagram.size(), from);
+        if (received < 0) continue; // The timeout: a chance to stop, rejoin and sweep
+
+        if (from == upstream) {
+            ServerPacketHeader header;
+            if (received < static_cast<int>(sizeof(header))) continue;
+            std::memcpy(&header, datagram.data(), sizeof(header));
+            if (header.magic != SERVER_PROTOCOL_MAGIC || header.version != SERVER_PROTOCOL_VERSION) continue;
+            if (header.type == SERVER_WELCOME) {
+                if (!joined.exchange(true)) LOG_INFO("Relay: watching match %u", header.match);
+                continue;
+            }
+            if (header.type == SERVER_NO_MATCH || header.type == SERVER_FULL) {
+                LOG_WARN("Relay: the server %s match %u; retrying", header.type == SERVER_NO_MATCH ? "has no" : "is full for", relayConfig.match);
+                joined.store(false, std::memory_order_relaxed);
+                continue;
+            }
+            if (header.type != SERVER_SNAPSHOT) continue;
+            bytesIn.fetch_add(received, std::memory_order_relaxed);
+            if (!decodeReplication(receiver, datagram.data() + sizeof(header), static_cast<size_t>(received) - sizeof(header))) continue;
+            joined.store(true, std::memory_order_relaxed); // A snapshot says so even if the welcome was lost
+            sendClientPacket(CLIENT_INPUT, ++upstreamSequence, receiver.latest);
+            lastUpstream = now;
+            snapshotsIn.fetch_add(1, std::memory_order_relaxed);
+
+            // Fan out: one encoding per distinct acknowledgement, the rest whole
+            pushReplicationBroadcast(broadcast, receiver.entities());
+            header.player = 0;
+            size_t used = 0; // Encodings made for this snapshot
+            bool spareMade = false; // The spare slot past them: the whole snapshot, for viewers past RELAY_MAX_ENCODINGS acks
+            for (std::unordered_map<UdpAddress, RelayViewer, UdpAddressHash>::iterator it = viewers.begin(); it != viewers.end(); ++it) {
+                uint32_t baseline = replicationBroadcastKeeps(broadcast, it->second.acked) ? it->second.acked : 0;
+                size_t k = 0;
+                while (k < used && encoded[k].baseline != baseline) ++k;
+                if (k == used && used == RELAY_MAX_ENCODINGS) {
+                    // Too many distinct acks this time: the rest get the snapshot whole
+                    baseline = 0;
+                    k = 0;
+                    while (k < used && encoded[k].baseline != 0) ++k;
+                    if (k == used) k = RELAY_MAX_ENCODINGS;
+                }
+                if (k == RELAY_MAX_ENCODINGS ? !spareMade : k == used) {
+                    RelayEncoding& encoding = encoded[k];
+                    encoding.datagram.resize(SERVER_MAX_DATAGRAM);
+                    std::memcpy(encoding.datagram.data(), &header, sizeof(header));
+                    const size_t bytes = encodeReplicationBroadcast(broadcast, baseline, encoding.datagram.data() + sizeof(header),
+                                                                    encoding.datagram.size() - sizeof(header));
+                    encoding.datagram.resize(bytes == 0 ? 0 : sizeof(header) + bytes);
+                    encoding.baseline = baseline;
+                    encodings.fetch_add(1, std::memory_order_relaxed);
+                    if (k == RELAY_MAX_ENCODINGS) spareMade = true;
+                    else ++used;
+                }
+                const std::vector<unsigned char>& out = encoded[k].datagram;
+                if (out.empty() || !relaySocket.send(out.data(), out.size(), it->first)) continue; // Too large for a datagram
+                snapshotsOut.fetch_add(1, std::memory_order_relaxed);
+                bytesOut.fetch_add(static_cast<int64_t>(out.size()), std::memory_order_relaxed);
+            }
+            continue;
+        }
+
+        ClientPacket packet;
+        if (received != static_cast<int>(sizeof(packet))) continue;
+        std::memcpy(&packet, datagram.data(), sizeof(packet));
+        if (packet.magic != SERVER_PROTOCOL_MAGIC || packet.version != SERVER_PROTOCOL_VERSION) continue;
+        std::unordered_map<UdpAddress, RelayViewer, UdpAddressHash>::iterator viewer = viewers.find(from);
+        if (packet.type == CLIENT_JOIN) {
+            if (packet.match != 0 && packet.match != relayConfig.match) {
+                sendViewerHeader(from, SERVER_NO_MATCH);
+                continue;
+            }
+            if (viewer == viewers.end()) {
+                if (viewers.size() >= static_cast<size_t>(relayConfig.maxViewers)) {
+                    sendViewerHeader(from, SERVER_FULL);
+                    continue;
+                }
+                viewer = viewers.emplace(from, RelayViewer()).first;
+                viewerCount.store(static_cast<int>(viewers.size()), std::memory_order_relaxed);
+            }
+            viewer->second.lastHeard = now;
+            sendViewerHeader(from, SERVER_WELCOME);
+        }
+        else if (viewer != viewers.end() && packet.type == CLIENT_INPUT) {
+            viewer->second.lastHeard = now;
+            // Only a newer one that was actually sent (an old, duplicated or forged ack is ignored)
+            if (packet.ack > viewer->second.acked && replicationBroadcastKeeps(broadcast, packet.ack)) viewer->second.acked = packet.ack;
+        }
+        else if (viewer != viewers.end() && packet.type == CLIENT_LEAVE) {
+            viewers.erase(viewer);
+            viewerCount.store(static_cast<int>(viewers.size()), std::memory_order_relaxed);
+        }
+    }
+    if (joined.load(std::memory_order_relaxed)) sendClientPacket(CLIENT_LEAVE, ++upstreamSequence, receiver.latest);
+}
+
+// ============================ RELAY API ============================
+bool startRelay(const RelayConfig& config) {
+    stopRelay();
+    relayConfig = config;
+    if (!config.server || !resolveUdpAddress(config.server, 27960, upstream)) {
+        LOG_ERROR("Relay: cannot resolve the server %s", config.server ? config.server : "(none)");
+        return false;
+    }
+    if (!relaySocket.open(config.port)) {
+        LOG_ERROR("Relay: cannot bind UDP port %d", config.port);
+        return false;
+    }
+    relaySocket.setReceiveTimeout(RELAY_RECEIVE_TIMEOUT_MS);
+    joined.store(false, std::memory_order_relaxed);
+    relayRunning.store(true, std::memory_order_release);
+    relayThread = std::thread(relayLoop);
+    lastReport = Clock::now();
+    LOG_INFO("Relay: match %u of %s to up to %d viewers on UDP port %d", config.match, config.server, config.maxViewers, config.port);
+    return true;
+}
+
+void stopRelay() {
+    if (!relayRunning.exchange(false)) return;
+    relayThread.join();
+    relaySocket.close();
+}
+
+void logRelayReport() {
+    const Clock::time_point now = Clock::now();
+    const double seconds = std::chrono::duration<double>(now - lastReport).count();
+    lastReport = now;
+    if (seconds <= 0.0) return;
+    const int64_t in = snapshotsIn.exchange(0), out = snapshotsOut.exchange(0), encoded = encodings.exchange(0);
+    LOG_INFO("[relay] %s, %d viewers; %.1f snapshots/s in, %.0f out, %.2f encodings a snapshot; %.1f KB/s in, %.1f KB/s out",
+             joined.load(std::memory_order_relaxed) ? "watching" : "joining", viewerCount.load(std::memory_order_relaxed), in / seconds,
+             out / seconds, in > 0 ? static_cast<double>(encoded) / in : 0.0, bytesIn.exchange(0) / seconds / 1024.0,
+             bytesOut.exchange(0) / seconds / 1024.0);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+
+// Spectator relay: fans one match of a match server (server.h) out to any number of viewers, so a
+// tournament match costs the server one watching client however many people watch it. The relay
+// joins the match as a watcher, decodes its snapshot stream (replication.h) and acknowledges it like
+// any client, then re-sends every snapshot to its own viewers, who speak the same protocol to it as
+// to a server (so a relay can feed another relay). The decoded states are kept once, in a
+// ReplicationBroadcast, and each viewer is only the sequence it last acknowledged: the viewers that
+// acknowledged the same snapshot get the same datagram, so a snapshot is encoded once per distinct
+// acknowledgement (almost always one or two) rather than once per viewer. A viewer silent for
+// SERVER_CLIENT_TIMEOUT_MS is dropped. Like simulation.h, nothing here depends on GL.
+
+// ============================ CONFIGURATION ============================
+const int RELAY_REJOIN_MS = 1000; // Between joins until the server welcomes the relay, and heartbeats without snapshots
+const int RELAY_MAX_ENCODINGS = 8; // Distinct acknowledgements encoded per snapshot; viewers further behind get it whole
+
+struct RelayConfig {
+    int port = 27961; // Where viewers join
+    const char* server = nullptr; // "HOST:PORT" of the match server (or of another relay)
+    uint32_t match = 0; // The match relayed
+    int maxViewers = 4096;
+};
+
+// ============================ RELAY API ============================
+// Opens the port and starts the relay's thread; false if the port cannot be bound or the server
+// does not resolve
+bool startRelay(const RelayConfig& config);
+void stopRelay(); // Safe to call twice
+// Logs the viewers, the snapshots relayed, the encodings they took and the traffic since the last report
+void logRelayReport();
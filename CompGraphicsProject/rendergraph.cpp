@@ -0,0 +1,297 @@
+#include "rendergraph.h"
+#include "alloctrack.h"
+#include "deletionqueue.h"
+#include "log.h"
+#include "trace.h"
+
+#include <chrono>
+
+#include <glad/glad.h>
+
+RenderGraph renderGraph;
+
+// ============================ TARGET FORMATS ============================
+struct TargetFormatInfo {
+    GLenum internalFormat, format, type;
+    size_t bytesPerPixel; // As the driver pads it (RGB8 goes in 4)
+};
+
+static const TargetFormatInfo targetFormats[] = {
+    { GL_RGB8, GL_RGB, GL_UNSIGNED_BYTE, 4 },
+    { GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4 },
+    { GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, 8 },
+};
+
+static size_t targetBytes(const RenderTargetDesc& desc)
+{
+    return static_cast<size_t>(desc.width) * desc.height * targetFormats[desc.format].bytesPerPixel;
+}
+
+// ============================ SETUP ============================
+void RenderGraph::setup()
+{
+    glGenQueries(RENDER_GRAPH_TIMER_FRAMES * (RENDER_GRAPH_MAX_PASSES + 1), &timestampQueries[0][0]);
+}
+
+void RenderGraph::destroy()
+{
+    for (int i = 0; i < poolCount; ++i) {
+        glDeleteFramebuffers(1, &pool[i].framebuffer);
+        glDeleteTextures(1, &pool[i].texture);
+    }
+    poolCount = 0;
+    if (timestampQueries[0][0] != 0) glDeleteQueries(RENDER_GRAPH_TIMER_FRAMES * (RENDER_GRAPH_MAX_PASSES + 1), &timestampQueries[0][0]);
+}
+
+// ============================ DECLARATION ============================
+void RenderGraph::beginFrame(int width, int height)
+{
+    ++frame;
+    passCount = 0;
+    targetCount = 0;
+    importTarget("backbuffer", 0, 0, width, height);
+}
+
+RenderTarget RenderGraph::createTarget(const char* name, RenderTargetDesc desc)
+{
+    if (targetCount == RENDER_GRAPH_MAX_TARGETS) {
+        LOG_ERROR("Render graph: no room for target %s", name);
+        return RENDER_GRAPH_BACKBUFFER;
+    }
+    targets[targetCount] = { name, desc, false, 0, 0, -1, -1, -1 };
+    return targetCount++;
+}
+
+RenderTarget RenderGraph::importTarget(const char* name, unsigned int framebuffer, unsigned int texture, int width, int height)
+{
+    if (targetCount == RENDER_GRAPH_MAX_TARGETS) {
+        LOG_ERROR("Render graph: no room for target %s", name);
+        return RENDER_GRAPH_BACKBUFFER;
+    }
+    targets[targetCount] = { name, { width, height, RENDER_TARGET_RGBA8 }, true, framebuffer, texture, -1, -1, -1 };
+    return targetCount++;
+}
+
+void RenderGraph::addPass(const char* name, ProfilePhase phase, std::initializer_list<RenderTarget> inputs, RenderTarget output,
+                          RenderLoad load, void (*execute)(const RenderPass&), void* context)
+{
+    if (passCount == RENDER_GRAPH_MAX_PASSES || inputs.size() > RENDER_PASS_MAX_INPUTS) {
+        LOG_ERROR("Render graph: no room for pass %s", name);
+        return;
+    }
+    RenderPass& pass = passes[passCount++];
+    pass = {};
+    pass.name = name;
+    pass.phase = phase;
+    for (RenderTarget input : inputs) pass.inputs[pass.inputCount++] = input;
+    pass.output = output;
+    pass.load = load;
+    pass.execute = execute;
+    pass.context = context;
+}
+
+// ============================ COMPILE ============================
+// A new pooled texture for `desc`, or -1 when the pool is full or the framebuffer is incomplete
+static int addPooledTexture(RenderGraph& graph, const RenderTargetDesc& desc)
+{
+    if (graph.poolCount == RENDER_GRAPH_MAX_TEXTURES) return -1;
+    RenderGraph::PooledTexture& pooled = graph.pool[graph.poolCount];
+    const TargetFormatInfo& format = targetFormats[desc.format];
+    glGenTextures(1, &pooled.texture);
+    glBindTexture(GL_TEXTURE_2D, pooled.texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, format.internalFormat, desc.width, desc.height, 0, format.format, format.type, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR); // Upscales and blur taps fetch bilinearly
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glGenFramebuffers(1, &pooled.framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, pooled.framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, pooled.texture, 0);
+    const bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (!complete) {
+        glDeleteFramebuffers(1, &pooled.framebuffer);
+        glDeleteTextures(1, &pooled.texture);
+        return -1;
+    }
+    pooled.desc = desc;
+    pooled.busyUntil = -1;
+    pooled.lastUsed = graph.frame;
+    LOG_DEBUG("Render graph: pooled a %dx%d texture (%d in the pool)", desc.width, desc.height, graph.poolCount + 1);
+    return graph.poolCount++;
+}
+
+void RenderGraph::compile()
+{
+    // Cull from the back: a pass runs if it draws into the window or an imported target, or into one a
+    // later pass that runs reads (or draws over, keeping what is there)
+    bool needed[RENDER_GRAPH_MAX_TARGETS] = {};
+    for (int p = passCount - 1; p >= 0; --p) {
+        RenderPass& pass = passes[p];
+        pass.culled = !targets[pass.output].imported && !needed[pass.output];
+        if (pass.culled) continue;
+        needed[pass.output] = pass.load == RENDER_LOAD_KEEP;
+        for (int i = 0; i < pass.inputCount; ++i) needed[pass.inputs[i]] = true;
+    }
+
+    // Lifetimes over the passes that run
+    for (int t = 0; t < targetCount; ++t) targets[t].first = targets[t].last = -1;
+    for (int p = 0; p < passCount; ++p) {
+        if (passes[p].culled) continue;
+        auto touch = [&](RenderTarget t) {
+            if (targets[t].first < 0) targets[t].first = p;
+            targets[t].last = p;
+        };
+        for (int i = 0; i < passes[p].inputCount; ++i) touch(passes[p].inputs[i]);
+        touch(passes[p].output);
+    }
+
+    // Back each transient target, in the order they come to life, with a pooled texture of its size and
+    // format that is free by then
+    for (int i = 0; i < poolCount; ++i) pool[i].busyUntil = -1;
+    transientTargets = 0;
+    transientBytes = 0;
+    for (int p = 0; p < passCount; ++p) {
+        for (int t = 0; t < targetCount; ++t) {
+            Target& target = targets[t];
+            if (target.imported || target.first != p) continue;
+            int slot = -1;
+            for (int i = 0; i < poolCount && slot < 0; ++i) {
+                if (pool[i].desc == target.desc && pool[i].busyUntil < p) slot = i;
+            }
+            if (slot < 0) {
+                AllowAllocations grow; // On the first frames and after a resize only
+                slot = addPooledTexture(*this, target.desc);
+                if (slot < 0) LOG_WARN("Render graph: no texture for %s, its passes are skipped", target.name);
+            }
+            target.slot = slot;
+            ++transientTargets;
+            transientBytes += targetBytes(target.desc);
+            if (slot < 0) continue;
+            pool[slot].busyUntil = target.last;
+            pool[slot].lastUsed = frame;
+            target.framebuffer = pool[slot].framebuffer;
+            target.texture = pool[slot].texture;
+        }
+    }
+
+    // Passes touching a target that got no texture go too
+    passesRun = 0;
+    for (int p = 0; p < passCount; ++p) {
+        RenderPass& pass = passes[p];
+        if (pass.culled) continue;
+        auto missing = [&](RenderTarget t) { return !targets[t].imported && targets[t].slot < 0; };
+        pass.culled = missing(pass.output);
+        for (int i = 0; i < pass.inputCount; ++i) pass.culled = pass.culled || missing(pass.inputs[i]);
+        if (!pass.culled) ++passesRun;
+    }
+    passesCulled = passCount - passesRun;
+
+    // Retire what no frame has wanted for a while
+    for (int i = 0; i < poolCount;) {
+        if (frame - pool[i].lastUsed <= RENDER_GRAPH_IDLE_FRAMES) {
+            ++i;
+            continue;
+        }
+        AllowAllocations retire;
+        deletionQueue.retire(RETIRED_FRAMEBUFFER, pool[i].framebuffer);
+        deletionQueue.retire(RETIRED_TEXTURE, pool[i].texture);
+        pool[i] = pool[--poolCount];
+    }
+}
+
+// ============================ EXECUTE ============================
+void RenderGraph::execute()
+{
+    const int set = timerSet;
+    int timed = 0;
+    for (int p = 0; p < passCount; ++p) {
+        RenderPass& pass = passes[p];
+        if (pass.culled) continue;
+        for (int i = 0; i < pass.inputCount; ++i) pass.inputTextures[i] = targets[pass.inputs[i]].texture;
+        const Target& output = targets[pass.output];
+        pass.width = output.desc.width;
+        pass.height = output.desc.height;
+
+        glQueryCounter(timestampQueries[set][timed], GL_TIMESTAMP);
+        timedPasses[set][timed++] = { pass.name, pass.phase };
+        glBindFramebuffer(GL_FRAMEBUFFER, output.framebuffer);
+        glViewport(0, 0, pass.width, pass.height);
+        if (pass.load == RENDER_LOAD_CLEAR) {
+            glClear(GL_COLOR_BUFFER_BIT);
+        }
+        else if (pass.load == RENDER_LOAD_DONT_CARE && output.framebuffer != 0 && glInvalidateFramebuffer) {
+            const GLenum attachment = GL_COLOR_ATTACHMENT0;
+            glInvalidateFramebuffer(GL_FRAMEBUFFER, 1, &attachment);
+        }
+        ProfileScope scope(pass.phase, pass.phase != PHASE_COUNT);
+        pass.execute(pass);
+    }
+    glQueryCounter(timestampQueries[set][timed], GL_TIMESTAMP);
+    timedCount[set] = timed;
+    timerSet = (set + 1) % RENDER_GRAPH_TIMER_FRAMES;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, targets[RENDER_GRAPH_BACKBUFFER].desc.width, targets[RENDER_GRAPH_BACKBUFFER].desc.height);
+}
+
+// ============================ TIMINGS ============================
+double RenderGraph::collectTimings()
+{
+    const int set = timerSet;
+    const int count = timedCount[set];
+    if (count == 0) return 0.0;
+    GLint available = 0;
+    glGetQueryObjectiv(timestampQueries[set][count], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) return 0.0; // Dropped rather than waited for; the next execute overwrites it
+    timedCount[set] = 0;
+
+    // GPU timestamps run on their own clock: pair it with the steady clock for the trace
+    GLint64 gpuNow = 0;
+    std::chrono::steady_clock::time_point cpuNow;
+    const bool traced = traceActive();
+    if (traced) {
+        glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+        cpuNow = std::chrono::steady_clock::now();
+    }
+    GLuint64 stamps[RENDER_GRAPH_MAX_PASSES + 1];
+    for (int i = 0; i <= count; ++i) glGetQueryObjectui64v(timestampQueries[set][i], GL_QUERY_RESULT, &stamps[i]);
+
+    double phased = 0.0;
+    for (int i = 0; i < count; ++i) {
+        const PassTiming& pass = timedPasses[set][i];
+        const double milliseconds = (stamps[i + 1] - stamps[i]) / 1.0e6;
+        if (pass.phase != PHASE_COUNT) {
+            profilerAddGpu(pass.phase, milliseconds);
+            phased += milliseconds;
+        }
+        if (traced) traceGpuSpan(pass.name, cpuNow - std::chrono::nanoseconds(gpuNow - static_cast<GLint64>(stamps[i])), milliseconds);
+
+        int s = 0;
+        while (s < statsCount && stats[s].name != pass.name) ++s;
+        if (s == statsCount) {
+            if (statsCount == RENDER_GRAPH_MAX_PASSES) continue;
+            stats[statsCount++] = { pass.name, 0.0, 0 };
+        }
+        stats[s].milliseconds += milliseconds;
+        ++stats[s].samples;
+    }
+    return phased;
+}
+
+void RenderGraph::log()
+{
+    LOG_INFO("Render graph: %d passes run, %d culled; %d transient targets in %d pooled textures (%zu KB, %zu KB unaliased)",
+             passesRun, passesCulled, transientTargets, poolCount, textureBytes() / 1024, transientBytes / 1024);
+    for (int s = 0; s < statsCount; ++s) {
+        if (stats[s].samples > 0) LOG_INFO("  %-16s %.3f ms GPU (%d frames)", stats[s].name, stats[s].milliseconds / stats[s].samples, stats[s].samples);
+    }
+    statsCount = 0;
+}
+
+size_t RenderGraph::textureBytes() const
+{
+    size_t bytes = 0;
+    for (int i = 0; i < poolCount; ++i) bytes += targetBytes(pool[i].desc);
+    return bytes;
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+
+#include "profiler.h"
+
+// ============================ RENDER GRAPH ============================
+// The frame's passes declared up front, each with the targets it reads and the one it draws into,
+// then compiled and run in declaration order:
+//     renderGraph.beginFrame(width, height);
+//     RenderTarget glow = renderGraph.createTarget("bloom glow", { w, h, RENDER_TARGET_RGB8 });
+//     renderGraph.addPass("bloom emissive", PHASE_BLOOM, {}, glow, RENDER_LOAD_CLEAR, drawGlow);
+//     renderGraph.addPass("bloom composite", PHASE_BLOOM, { glow }, RENDER_GRAPH_BACKBUFFER, RENDER_LOAD_KEEP, addGlow);
+//     renderGraph.compile();
+//     renderGraph.execute();
+// Culling: a pass runs only if what it draws reaches the window or an imported target (one that lives
+// across frames, like the low-res nebula), directly or through the passes reading it, so a feature
+// can declare its chain every frame and it costs nothing on the frames whose last pass is left out.
+// Aliasing: created targets are transient. Each lives from the first pass that touches it to the
+// last, and one pooled texture (with its framebuffer) backs every target of the same size and format
+// whose lives do not overlap, so the bloom's three targets take two textures. A pass says what it
+// needs in its target at the start (RenderLoad), so one that covers every pixel is not cleared first.
+// A pooled texture no frame has used for RENDER_GRAPH_IDLE_FRAMES is retired (after a resize, the
+// old size's).
+// Timing: a GL_TIMESTAMP query goes in ahead of every pass that runs and one after the last, in
+// RENDER_GRAPH_TIMER_FRAMES sets read back when they come round again (as the GPU timer queries
+// are), so a pass's time runs to the start of the next one's. It goes to the pass's profiler phase
+// (which also times the pass on the CPU), to the trace while one records, and to the per-pass
+// averages logged with the profiler report.
+const int RENDER_GRAPH_MAX_PASSES = 16;
+const int RENDER_GRAPH_MAX_TARGETS = 16; // Per frame, the backbuffer and the imported ones included
+const int RENDER_GRAPH_MAX_TEXTURES = 8; // Pooled behind the transient targets
+const int RENDER_PASS_MAX_INPUTS = 4;
+const int RENDER_GRAPH_TIMER_FRAMES = 3;
+const int RENDER_GRAPH_IDLE_FRAMES = 120;
+
+enum RenderTargetFormat { RENDER_TARGET_RGB8, RENDER_TARGET_RGBA8, RENDER_TARGET_RGBA16F };
+
+// What a pass finds in its target when it starts
+enum RenderLoad {
+    RENDER_LOAD_KEEP, // What the earlier passes drew (they are kept alive for it)
+    RENDER_LOAD_CLEAR, // Cleared to the clear color by the graph
+    RENDER_LOAD_DONT_CARE // Anything: the pass covers every pixel (invalidated where GL can)
+};
+
+struct RenderTargetDesc {
+    int width, height;
+    RenderTargetFormat format;
+    bool operator==(const RenderTargetDesc&) const = default;
+};
+
+typedef int RenderTarget; // A frame's declaration, valid until the next beginFrame
+const RenderTarget RENDER_GRAPH_BACKBUFFER = 0;
+
+struct RenderPass {
+    const char* name; // A literal: the timings are kept under it
+    ProfilePhase phase; // Whose GPU time the pass is (PHASE_COUNT: none, the pass times its own parts)
+    RenderTarget inputs[RENDER_PASS_MAX_INPUTS];
+    int inputCount;
+    RenderTarget output;
+    RenderLoad load;
+    void (*execute)(const RenderPass& pass);
+    void* context; // Handed back to execute untouched
+
+    // Filled in by compile and execute: execute finds its target bound and the viewport covering it
+    bool culled;
+    unsigned int inputTextures[RENDER_PASS_MAX_INPUTS];
+    int width, height; // The target's
+};
+
+struct RenderGraph {
+    struct Target {
+        const char* name;
+        RenderTargetDesc desc;
+        bool imported; // The backbuffer or a target kept outside the graph
+        unsigned int framebuffer, texture; // Imported: given; transient: the pooled texture's, once compiled
+        int slot; // Into pool (-1: imported, or no texture could be made)
+        int first, last; // Passes touching it, among those that run
+    };
+    struct PooledTexture {
+        RenderTargetDesc desc;
+        unsigned int framebuffer, texture;
+        int busyUntil; // Last pass of the target it backs this frame (-1: free)
+        uint64_t lastUsed; // Graph frame
+    };
+    struct PassTiming {
+        const char* name;
+        ProfilePhase phase;
+    };
+    struct PassStats {
+        const char* name;
+        double milliseconds; // Summed since the last report
+        int samples;
+    };
+
+    Target targets[RENDER_GRAPH_MAX_TARGETS];
+    int targetCount = 0;
+    RenderPass passes[RENDER_GRAPH_MAX_PASSES];
+    int passCount = 0;
+    PooledTexture pool[RENDER_GRAPH_MAX_TEXTURES];
+    int poolCount = 0;
+    uint64_t frame = 0;
+
+    unsigned int timestampQueries[RENDER_GRAPH_TIMER_FRAMES][RENDER_GRAPH_MAX_PASSES + 1] = {};
+    PassTiming timedPasses[RENDER_GRAPH_TIMER_FRAMES][RENDER_GRAPH_MAX_PASSES];
+    int timedCount[RENDER_GRAPH_TIMER_FRAMES] = {}; // Passes timed in the set (0: nothing to read)
+    int timerSet = 0; // Set the next execute writes
+    PassStats stats[RENDER_GRAPH_MAX_PASSES];
+    int statsCount = 0;
+
+    // Last compile's figures, for the report
+    int passesRun = 0, passesCulled = 0;
+    int transientTargets = 0;
+    size_t transientBytes = 0; // What the transient targets would take without aliasing
+
+    void setup(); // After GLAD has loaded
+    void destroy(); // While the context is still current
+
+    // Drops the last frame's declarations; the backbuffer is `width` x `height`
+    void beginFrame(int width, int height);
+    RenderTarget createTarget(const char* name, RenderTargetDesc desc);
+    RenderTarget importTarget(const char* name, unsigned int framebuffer, unsigned int texture, int width, int height);
+    void addPass(const char* name, ProfilePhase phase, std::initializer_list<RenderTarget> inputs, RenderTarget output,
+                 RenderLoad load, void (*execute)(const RenderPass&), void* context = nullptr);
+    // Culls, works out the lifetimes and backs the transient targets with pooled textures
+    void compile();
+    // Runs the passes that survived, in order; leaves the backbuffer bound with the viewport over it
+    void execute();
+
+    // Reads back the timer set the next execute reuses, if the GPU is done with it, and hands the
+    // times out (see above). Returns the GPU milliseconds of the passes with a phase (0: not ready).
+    double collectTimings();
+    // One line for the graph, one per pass with its average GPU time since the last report
+    void log();
+    size_t textureBytes() const; // The pool's
+};
+
+extern RenderGraph renderGraph;
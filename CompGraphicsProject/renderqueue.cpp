@@ -0,0 +1,116 @@
+#include "renderqueue.h"
+
+#include "glstate.h"
+
+#include <utility>
+
+RenderQueue renderQueue;
+
+const int KEY_INDEX_BITS = 28;
+const uint64_t KEY_INDEX_MASK = (uint64_t(1) << KEY_INDEX_BITS) - 1;
+
+// Small code per primitive, in drawing order: fills (GL_TRIANGLES..GL_TRIANGLE_FAN) first, then lines
+// (GL_LINES..GL_LINE_STRIP), then points, so within a program and vertex array no fill covers an outline
+static uint64_t primitiveCode(GLenum mode)
+{
+    if (mode >= GL_TRIANGLES && mode <= GL_TRIANGLE_FAN) return mode - GL_TRIANGLES; // 0..2
+    if (mode >= GL_LINES && mode <= GL_LINE_STRIP) return 3 + (mode - GL_LINES); // 3..5
+    return mode == GL_POINTS ? 6 : 0xF;
+}
+
+void RenderQueue::submit(RenderLayer layer, const DrawItem& item)
+{
+    const uint64_t index = items.size();
+    if (index > KEY_INDEX_MASK || item.count <= 0) return;
+    items.push_back(item);
+    keys.push_back((uint64_t(layer) << 56) | (uint64_t(item.program & 0xFFF) << 44) | (uint64_t(item.vertexArray & 0xFFF) << 32)
+                   | (primitiveCode(item.mode) << KEY_INDEX_BITS) | index);
+}
+
+// LSD radix sort, one byte per pass. Passes where every key has the same byte are skipped, which
+// drops most of them: the index bytes vary, the state bytes only take a handful of values.
+static void radixSort(FrameVector<uint64_t>& keys, FrameVector<uint64_t>& scratch)
+{
+    scratch.resize(keys.size());
+    for (int shift = 0; shift < 64; shift += 8) {
+        size_t offsets[256] = { 0 };
+        for (uint64_t key : keys) ++offsets[(key >> shift) & 0xFF];
+        if (offsets[(keys[0] >> shift) & 0xFF] == keys.size()) continue;
+        size_t total = 0;
+        for (size_t& offset : offsets) {
+            size_t count = offset;
+            offset = total;
+            total += count;
+        }
+        for (uint64_t key : keys) scratch[offsets[(key >> shift) & 0xFF]++] = key;
+        std::swap(keys, scratch);
+    }
+}
+
+void RenderQueue::setViewports(int count, GLsizei width, GLsizei height)
+{
+    framebufferWidth = width;
+    framebufferHeight = height;
+    if (count == 2) {
+        const GLsizei left = width / 2;
+        viewports[0] = { 0, 0, left, height };
+        viewports[1] = { left, 0, width - left, height };
+    }
+    else if (count == 4) {
+        // Player 1 top left, then reading order
+        const GLsizei left = width / 2, bottom = height / 2;
+        viewports[0] = { 0, bottom, left, height - bottom };
+        viewports[1] = { left, bottom, width - left, height - bottom };
+        viewports[2] = { 0, 0, left, bottom };
+        viewports[3] = { left, 0, width - left, bottom };
+    }
+    else {
+        count = 1;
+        viewports[0] = { 0, 0, width, height };
+    }
+    viewportCount = count;
+}
+
+int RenderQueue::execute()
+{
+    if (keys.empty()) return 0;
+    radixSort(keys, scratch);
+
+    int drawCalls = 0;
+    forEachViewport([&] {
+        const ProgramUniforms* bound = nullptr;
+        for (uint64_t key : keys) {
+            const DrawItem& item = items[key & KEY_INDEX_MASK];
+            if (!bound || bound->program != item.program) {
+                bound = nullptr;
+                for (const ProgramUniforms& u : uniforms) {
+                    if (u.program == item.program) bound = &u;
+                }
+                if (!bound) {
+                    uniforms.push_back({ item.program, glGetUniformLocation(item.program, "position"),
+                                         glGetUniformLocation(item.program, "rotationScale"), glGetUniformLocation(item.program, "lineColor") });
+                    bound = &uniforms.back();
+                }
+            }
+            glState.useProgram(item.program);
+            glState.bindVertexArray(item.vertexArray);
+            if (item.mode == GL_POINTS) glState.setPointSize(item.size);
+            else if (item.mode == GL_LINES || item.mode == GL_LINE_LOOP || item.mode == GL_LINE_STRIP) glState.setLineWidth(item.size);
+            glUniform2f(bound->position, item.position.x, item.position.y);
+            glUniform2f(bound->rotationScale, item.rotation, item.scale);
+            glState.uniform3f(bound->color, item.color.x, item.color.y, item.color.z);
+            glDrawArrays(item.mode, item.first, item.count);
+            ++drawCalls;
+        }
+    });
+    items.clear();
+    keys.clear();
+    return drawCalls;
+}
+
+void RenderQueue::releaseFrameStorage()
+{
+    releaseFrameVector(items);
+    releaseFrameVector(keys);
+    releaseFrameVector(scratch);
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "framearena.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// ============================ RENDER QUEUE ============================
+// Draws are submitted as items tagged with a 64-bit sort key and executed together, so items that
+// share a program, vertex array and primitive run back to back whatever order they were submitted in.
+// Key layout, most significant first:
+//   layer (8) | program (12) | vertex array (12) | primitive (4) | submission index (28)
+// Layers keep painter's order where it matters; below the layer the key groups state, and the
+// primitive code puts fills before lines and points, so outlines land on top of the fills they border.
+// The submission index makes every key unique (so the sort needs no payload and ties keep their
+// submission order) and is how execute() finds the item back.
+// Programs drawn through the queue follow the game object shader's interface: `position`,
+// `rotationScale` and `lineColor` uniforms (any of them may be missing).
+// Split screen: the queue holds up to MAX_RENDER_VIEWPORTS viewports over the same world (two side by
+// side, or a 2x2 grid). The CPU side of the frame runs once; execute() sorts once and replays the
+// sorted draws in each viewport, and the other passes do the same through forEachViewport, re-issuing
+// draws of the instance data they already uploaded. The shaders stop at GLSL 3.30 with no geometry
+// stage to route a primitive with gl_ViewportIndex, so each viewport gets its own glViewport rather
+// than a glViewportIndexed array.
+enum RenderLayer {
+    RENDER_LAYER_BODIES, // Ship, thrust fire, asteroids
+    RENDER_LAYER_PROJECTILES // Bullets, on top of everything they can hit
+};
+
+const int MAX_RENDER_VIEWPORTS = 4;
+
+struct RenderViewport {
+    GLint x, y;
+    GLsizei width, height;
+};
+
+struct DrawItem {
+    unsigned int program;
+    unsigned int vertexArray;
+    GLenum mode;
+    GLint first;
+    GLsizei count;
+    glm::vec2 position;
+    float rotation;
+    float scale;
+    glm::vec3 color;
+    float size; // Point size for GL_POINTS, line width for line primitives
+};
+
+struct RenderQueue {
+    struct ProgramUniforms {
+        unsigned int program;
+        int position, rotationScale, color;
+    };
+
+    // Per-frame storage, from the frame arena
+    FrameVector<DrawItem> items; // In submission order
+    FrameVector<uint64_t> keys;
+    FrameVector<uint64_t> scratch; // Radix sort ping-pong buffer
+    std::vector<ProgramUniforms> uniforms; // Looked up the first time a program is drawn
+
+    RenderViewport viewports[MAX_RENDER_VIEWPORTS] = {};
+    int viewportCount = 1;
+    GLsizei framebufferWidth = 1, framebufferHeight = 1;
+
+    // Splits a width x height framebuffer into `count` viewports (1, 2 or 4; anything else is 1)
+    void setViewports(int count, GLsizei width, GLsizei height);
+    // Calls draw() with each viewport set in turn, then sets the whole framebuffer back. With one
+    // viewport it is just draw(), with the viewport untouched.
+    template <typename Draw>
+    void forEachViewport(Draw&& draw) const
+    {
+        if (viewportCount == 1) {
+            draw();
+            return;
+        }
+        for (int i = 0; i < viewportCount; ++i) {
+            glViewport(viewports[i].x, viewports[i].y, viewports[i].width, viewports[i].height);
+            draw();
+        }
+        glViewport(0, 0, framebufferWidth, framebufferHeight);
+    }
+
+    void submit(RenderLayer layer, const DrawItem& item);
+    // Sorts the keys and draws every item through the GL state cache, once per viewport, then
+    // empties the queue. Returns the number of draw calls issued.
+    int execute();
+    // Drops the per-frame storage ahead of a frame arena reset
+    void releaseFrameStorage();
+};
+
+extern RenderQueue renderQueue;
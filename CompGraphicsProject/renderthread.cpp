@@ -0,0 +1,73 @@
+#include "renderthread.h"
+#include "threadconfig.h"
+#include "trace.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+// ============================ RENDER THREAD ============================
+bool useRenderThread = false;
+
+static std::thread renderThread;
+static GLFWwindow* renderWindow = nullptr;
+static std::mutex renderMutex;
+static std::condition_variable renderSignal;
+static bool frameSubmitted = false; // Set by the main thread, cleared once the frame is recorded
+static bool renderStopping = false;
+
+static void renderThreadLoop(GLFWwindow* window, RenderFrameFunction record, RenderFrameFunction present) {
+    glfwMakeContextCurrent(window);
+    nameTraceThread("render");
+    registerThread(THREAD_RENDER);
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(renderMutex);
+            renderSignal.wait(lock, [] { return frameSubmitted || renderStopping; });
+            if (!frameSubmitted) break; // Stopping with nothing left to draw
+        }
+        record(window);
+        {
+            std::lock_guard<std::mutex> lock(renderMutex);
+            frameSubmitted = false;
+        }
+        renderSignal.notify_all();
+        present(window);
+    }
+    glfwMakeContextCurrent(nullptr);
+}
+
+void startRenderThread(GLFWwindow* window, RenderFrameFunction record, RenderFrameFunction present) {
+    glfwMakeContextCurrent(nullptr);
+    renderWindow = window;
+    frameSubmitted = false;
+    renderStopping = false;
+    renderThread = std::thread(renderThreadLoop, window, record, present);
+}
+
+void submitRenderFrame() {
+    {
+        std::lock_guard<std::mutex> lock(renderMutex);
+        frameSubmitted = true;
+    }
+    renderSignal.notify_all();
+}
+
+void waitForRenderFrameRecorded() {
+    std::unique_lock<std::mutex> lock(renderMutex);
+    renderSignal.wait(lock, [] { return !frameSubmitted; });
+}
+
+void stopRenderThread() {
+    if (!renderThread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(renderMutex);
+        renderStopping = true;
+    }
+    renderSignal.notify_all();
+    renderThread.join();
+    glfwMakeContextCurrent(renderWindow);
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+struct GLFWwindow;
+
+// Render thread (--render-thread): owns the GL context and runs every frame's GL work and swap, so
+// the main thread can poll events, handle input and tick the simulation while the driver blocks in
+// glfwSwapBuffers (vsync, a full GPU queue).
+// Per frame the main thread fills in what the frame draws and submits it. The render thread runs
+// `record` (every GL call of the frame), reports the frame recorded, then runs `present` (the swap).
+// The main thread waits for that report before it touches anything `record` reads (the frame's
+// inputs, the render toggles, the window callbacks' globals), so only the swap overlaps it.
+
+// ============================ RENDER THREAD ============================
+extern bool useRenderThread;
+
+typedef void (*RenderFrameFunction)(GLFWwindow* window);
+
+// Releases the context from the calling thread and makes it current on the render thread
+void startRenderThread(GLFWwindow* window, RenderFrameFunction record, RenderFrameFunction present);
+// Hands the frame over; returns at once
+void submitRenderFrame();
+// Blocks until the render thread is done recording the last submitted frame (returns at once if
+// nothing is in flight)
+void waitForRenderFrameRecorded();
+// Lets the frame in flight finish, joins the thread and makes the context current on the caller again
+void stopRenderThread();
@@ -0,0 +1,416 @@
+#include "replay.h"
+#include "snapshot.h"
+#include "log.h"
+#include "alloctrack.h"
+#include "memreport.h"
+#include "mappedfile.h"
+#include "threadconfig.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Key state and how many consecutive ticks it was held
+struct InputRun {
+    uint8_t bits;
+    uint32_t length;
+};
+
+static std::vector<InputRun> runs; // Recording: the runs since the last hand-off to the writer; replay: all of them
+static long long totalTicks = 0;
+
+static bool recording = false;
+static std::string recordPath;
+static bool recordChecksums = false;
+
+// Recording: the checksums since the last hand-off, from checksumFirstTick; replay: all of them
+static std::vector<uint64_t> checksums;
+static long long checksumFirstTick = 0;
+static long long replayTick = 0; // Ticks consumed while replaying
+static long long desyncTick = -1, desyncTicks = 0, checkedTicks = 0;
+
+static bool replaying = false;
+static size_t replayRun = 0;       // Current run while replaying
+static uint32_t replayRunTick = 0; // Ticks already consumed from it
+static std::atomic<bool> replayDone(false);
+
+// Where the tick count sits in the header (after the magic, version, seed and options)
+const size_t REPLAY_TICK_COUNT_OFFSET = 4 + 4 + 8 + 4;
+
+// ============================ WRITER THREAD ============================
+// The simulating thread hands over the runs and keyframe of every interval; this thread encodes them
+// and appends them to the file, so the tick never waits on the disk.
+struct WriterItem {
+    std::vector<InputRun> runs; // Written first: the input up to the keyframe
+    std::vector<uint64_t> checksums; // Then the same ticks' checksums
+    uint64_t checksumFirstTick = 0;
+    int keyframe = -1; // keyframeBuffers index, or -1
+    uint64_t tick = 0;
+    size_t keyframeBytes = 0;
+};
+
+static std::thread writerThread;
+static std::mutex writerMutex;
+static std::condition_variable writerSignal;
+static std::deque<WriterItem> writerQueue;
+static bool writerStopping = false;
+static std::vector<unsigned char> keyframeBuffers[REPLAY_KEYFRAME_BUFFERS];
+static bool keyframeBusy[REPLAY_KEYFRAME_BUFFERS] = {}; // Saved and queued, not yet written
+static std::ofstream recordFile; // Writer thread only once recording
+static long long keyframesWritten = 0, keyframesSkipped = 0, runsWritten = 0;
+
+static void writeRecord(uint8_t type, const void* payload, uint64_t bytes) {
+    recordFile.write(reinterpret_cast<const char*>(&type), sizeof(type));
+    recordFile.write(reinterpret_cast<const char*>(&bytes), sizeof(bytes));
+    recordFile.write(static_cast<const char*>(payload), static_cast<std::streamsize>(bytes));
+}
+
+static void appendVarint(std::vector<unsigned char>& out, uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<unsigned char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<unsigned char>(value));
+}
+
+static void writerLoop() {
+    registerThread(THREAD_BACKGROUND);
+    AllowAllocations writer; // Its own thread: encoding buffers grow with the session
+    std::vector<unsigned char> encoded;
+    std::vector<unsigned char> keyframeRecord;
+    for (;;) {
+        WriterItem item;
+        {
+            std::unique_lock<std::mutex> lock(writerMutex);
+            writerSignal.wait(lock, [] { return writerStopping || !writerQueue.empty(); });
+            if (writerQueue.empty()) break;
+            item = std::move(writerQueue.front());
+            writerQueue.pop_front();
+        }
+        if (!item.runs.empty()) {
+            encoded.clear();
+            for (const InputRun& run : item.runs) {
+                encoded.push_back(run.bits);
+                appendVarint(encoded, run.length);
+            }
+            writeRecord(REPLAY_RECORD_INPUT, encoded.data(), encoded.size());
+            runsWritten += static_cast<long long>(item.runs.size());
+        }
+        if (!item.checksums.empty()) {
+            encoded.resize(sizeof(item.checksumFirstTick) + item.checksums.size() * sizeof(uint64_t));
+            std::memcpy(encoded.data(), &item.checksumFirstTick, sizeof(item.checksumFirstTick));
+            std::memcpy(encoded.data() + sizeof(item.checksumFirstTick), item.checksums.data(), item.checksums.size() * sizeof(uint64_t));
+            writeRecord(REPLAY_RECORD_CHECKSUMS, encoded.data(), encoded.size());
+        }
+        if (item.keyframe >= 0) {
+            keyframeRecord.resize(sizeof(item.tick) + item.keyframeBytes);
+            std::memcpy(keyframeRecord.data(), &item.tick, sizeof(item.tick));
+            std::memcpy(keyframeRecord.data() + sizeof(item.tick), keyframeBuffers[item.keyframe].data(), item.keyframeBytes);
+            writeRecord(REPLAY_RECORD_KEYFRAME, keyframeRecord.data(), keyframeRecord.size());
+            ++keyframesWritten;
+            std::lock_guard<std::mutex> lock(writerMutex);
+            keyframeBusy[item.keyframe] = false;
+        }
+        recordFile.flush(); // A crash loses at most the interval in flight
+    }
+}
+
+// Hands the runs so far, and a keyframe of the world as this tick starts if a buffer is free, to the writer
+static void handOff(bool keyframe) {
+    AllowAllocations handoff; // Once per keyframe interval
+    WriterItem item;
+    item.runs.swap(runs);
+    runs.reserve(item.runs.capacity());
+    if (recordChecksums) {
+        item.checksums.swap(checksums);
+        item.checksumFirstTick = static_cast<uint64_t>(checksumFirstTick);
+        checksums.reserve(REPLAY_KEYFRAME_TICKS);
+        checksumFirstTick = totalTicks;
+    }
+    if (keyframe) {
+        {
+            std::lock_guard<std::mutex> lock(writerMutex);
+            for (int b = 0; b < REPLAY_KEYFRAME_BUFFERS && item.keyframe < 0; ++b) {
+                if (!keyframeBusy[b]) item.keyframe = b;
+            }
+            if (item.keyframe >= 0) keyframeBusy[item.keyframe] = true;
+        }
+        if (item.keyframe >= 0) {
+            std::vector<unsigned char>& buffer = keyframeBuffers[item.keyframe];
+            if (buffer.empty()) buffer.resize(worldSnapshotBytes(world.limits)); // First use: the world is init'ed by now
+            item.tick = static_cast<uint64_t>(totalTicks);
+            item.keyframeBytes = saveWorldSnapshot(world, buffer.data(), buffer.size());
+        }
+        else {
+            ++keyframesSkipped;
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(writerMutex);
+        writerQueue.push_back(std::move(item));
+    }
+    writerSignal.notify_one();
+}
+
+// ============================ RECORDING ============================
+bool startRecording(const char* path, uint64_t seed, uint32_t options, bool withChecksums) {
+    recordFile.open(path, std::ios::binary | std::ios::trunc); // Fail now rather than after the session
+    if (!recordFile) {
+        LOG_ERROR("Cannot write recording %s", path);
+        return false;
+    }
+    const uint64_t ticks = 0; // Unfinished until stopRecording writes the count
+    const uint32_t interval = REPLAY_KEYFRAME_TICKS;
+    recordFile.write(reinterpret_cast<const char*>(&REPLAY_MAGIC), sizeof(REPLAY_MAGIC));
+    recordFile.write(reinterpret_cast<const char*>(&REPLAY_VERSION), sizeof(REPLAY_VERSION));
+    recordFile.write(reinterpret_cast<const char*>(&seed), sizeof(seed));
+    recordFile.write(reinterpret_cast<const char*>(&options), sizeof(options));
+    recordFile.write(reinterpret_cast<const char*>(&ticks), sizeof(ticks));
+    recordFile.write(reinterpret_cast<const char*>(&interval), sizeof(interval));
+    recording = true;
+    recordPath = path;
+    runs.clear();
+    runs.reserve(4096); // A keyframe interval of the busiest play
+    totalTicks = 0;
+    recordChecksums = withChecksums;
+    checksums.clear();
+    if (withChecksums) checksums.reserve(REPLAY_KEYFRAME_TICKS);
+    checksumFirstTick = 0;
+    keyframesWritten = keyframesSkipped = runsWritten = 0;
+    writerStopping = false;
+    writerThread = std::thread(writerLoop);
+    return true;
+}
+
+void stopRecording() {
+    if (!recording) return;
+    recording = false;
+    handOff(false);
+    {
+        std::lock_guard<std::mutex> lock(writerMutex);
+        writerStopping = true;
+    }
+    writerSignal.notify_all();
+    writerThread.join();
+
+    const uint64_t ticks = static_cast<uint64_t>(totalTicks);
+    recordFile.seekp(static_cast<std::streamoff>(REPLAY_TICK_COUNT_OFFSET));
+    recordFile.write(reinterpret_cast<const char*>(&ticks), sizeof(ticks));
+    const bool ok = static_cast<bool>(recordFile);
+    const long long bytes = static_cast<long long>(recordFile.seekp(0, std::ios::end).tellp());
+    recordFile.close();
+    for (std::vector<unsigned char>& buffer : keyframeBuffers) std::vector<unsigned char>().swap(buffer);
+    if (!ok) LOG_ERROR("Failed writing recording %s", recordPath.c_str());
+    else LOG_INFO("Recorded %lld ticks (%lld input runs, %lld keyframes, %lld skipped) to %s: %lld bytes",
+                  totalTicks, runsWritten, keyframesWritten, keyframesSkipped, recordPath.c_str(), bytes);
+}
+
+// ============================ MAPPED FILE ============================
+// The replay file stays mapped while it plays: keyframes are restored straight from the mapping
+struct Keyframe {
+    long long tick;
+    const unsigned char* snapshot; // Inside the mapping
+    size_t bytes;
+};
+
+static MappedFile replayFile;
+static std::vector<Keyframe> keyframes; // In tick order
+
+// Reads a T at `offset` and moves past it; false if the file ends first
+template <typename T>
+static bool readValue(size_t& offset, T& value) {
+    if (replayFile.size - offset < sizeof(T)) return false;
+    std::memcpy(&value, replayFile.data + offset, sizeof(T));
+    offset += sizeof(T);
+    return true;
+}
+
+// Decodes one input record's runs onto `runs`; false if a run is cut short
+static bool decodeInput(const unsigned char* payload, size_t bytes) {
+    size_t at = 0;
+    while (at < bytes) {
+        InputRun run = { payload[at++], 0 };
+        for (int shift = 0;; shift += 7) {
+            if (at == bytes || shift > 28) return false;
+            const unsigned char byte = payload[at++];
+            run.length |= static_cast<uint32_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) break;
+        }
+        runs.push_back(run);
+    }
+    return true;
+}
+
+// ============================ REPLAY ============================
+bool loadReplay(const char* path, uint64_t& seed, uint32_t& options) {
+    AllowAllocations loading; // Once, before the session starts
+    uint32_t magic = 0, version = 0;
+    uint64_t ticks = 0;
+    size_t offset = 0;
+    if (!replayFile.open(path) || !readValue(offset, magic) || !readValue(offset, version) || !readValue(offset, seed) ||
+        !readValue(offset, options) || !readValue(offset, ticks) || magic != REPLAY_MAGIC || (version < 3 || version > REPLAY_VERSION)) {
+        LOG_ERROR("%s is not a replay file (or from another version)", path);
+        replayFile.close();
+        return false;
+    }
+
+    if (version < REPLAY_VERSION) LOG_WARN("%s is a version %u recording: its input plays, but the game may play out differently", path, version);
+
+    runs.clear();
+    keyframes.clear();
+    checksums.clear();
+    checksumFirstTick = 0;
+    bool complete = true;
+    if (version == 3) {
+        uint8_t bits;
+        uint16_t length;
+        while (readValue(offset, bits) && readValue(offset, length)) runs.push_back({ bits, length });
+    }
+    else {
+        uint32_t interval = 0;
+        readValue(offset, interval);
+        // Only the record headers and the input are read: the keyframes' pages are not touched
+        uint8_t type;
+        uint64_t bytes;
+        while (readValue(offset, type) && readValue(offset, bytes)) {
+            if (replayFile.size - offset < bytes) {
+                complete = false; // Cut off mid-record (a crash while writing it)
+                break;
+            }
+            const unsigned char* payload = replayFile.data + offset;
+            const bool currentSnapshots = version == REPLAY_VERSION; // Older versions' keyframes do not restore or compare
+            if (type == REPLAY_RECORD_INPUT && !decodeInput(payload, static_cast<size_t>(bytes))) complete = false;
+            else if (type == REPLAY_RECORD_KEYFRAME && currentSnapshots && bytes > sizeof(uint64_t)) {
+                uint64_t tick;
+                std::memcpy(&tick, payload, sizeof(tick));
+                keyframes.push_back({ static_cast<long long>(tick), payload + sizeof(tick), static_cast<size_t>(bytes - sizeof(tick)) });
+            }
+            else if (type == REPLAY_RECORD_CHECKSUMS && currentSnapshots && bytes >= sizeof(uint64_t)) {
+                uint64_t first;
+                std::memcpy(&first, payload, sizeof(first));
+                if (checksums.empty()) checksumFirstTick = static_cast<long long>(first);
+                // Records follow on from each other; one that does not is left out with everything after it
+                const size_t count = static_cast<size_t>(bytes - sizeof(first)) / sizeof(uint64_t);
+                if (static_cast<long long>(first) == checksumFirstTick + static_cast<long long>(checksums.size())) {
+                    checksums.resize(checksums.size() + count);
+                    std::memcpy(checksums.data() + checksums.size() - count, payload + sizeof(first), count * sizeof(uint64_t));
+                }
+            }
+            offset += static_cast<size_t>(bytes);
+        }
+    }
+    long long counted = 0;
+    for (const InputRun& run : runs) counted += run.length;
+    if (ticks == 0 && version != 3) {
+        LOG_WARN("Replay %s was not finished; playing its %lld recorded ticks", path, counted);
+    }
+    else if (!complete || counted != static_cast<long long>(ticks)) {
+        LOG_ERROR("Replay %s is truncated (%lld of %llu ticks)", path, counted, static_cast<unsigned long long>(ticks));
+        return false;
+    }
+
+    replaying = true;
+    replayRun = 0;
+    replayRunTick = 0;
+    replayTick = 0;
+    desyncTick = -1;
+    desyncTicks = checkedTicks = 0;
+    totalTicks = counted;
+    replayDone.store(runs.empty());
+    LOG_INFO("Replaying %lld ticks from %s (%zu keyframes, %zu tick checksums)", totalTicks, path, keyframes.size(), checksums.size());
+    return true;
+}
+
+bool seekReplay(long long tick) {
+    if (!replaying) return false;
+    tick = std::min(std::max(tick, 0LL), totalTicks);
+    // The last keyframe at or before the tick; without one, the world as seeded is tick 0
+    long long from = 0;
+    auto after = std::upper_bound(keyframes.begin(), keyframes.end(), tick, [](long long t, const Keyframe& k) { return t < k.tick; });
+    if (after != keyframes.begin()) {
+        const Keyframe& keyframe = *(after - 1);
+        if (!restoreWorldSnapshot(world, keyframe.snapshot, keyframe.bytes)) {
+            LOG_ERROR("Keyframe at tick %lld does not fit this world (other limits?)", keyframe.tick);
+            return false;
+        }
+        from = keyframe.tick;
+    }
+
+    // The input cursor to `from`, then the ticks up to the target played as usual
+    long long before = 0;
+    replayRun = 0;
+    while (replayRun < runs.size() && before + runs[replayRun].length <= from) before += runs[replayRun++].length;
+    replayRunTick = static_cast<uint32_t>(from - before);
+    replayTick = from;
+    replayDone.store(replayRun == runs.size());
+    for (long long t = from; t < tick; ++t) world.step(SIM_DT, tickInput(InputState()));
+    LOG_INFO("Replay: at tick %lld (keyframe %lld, %lld ticks played)", tick, from, tick - from);
+    return true;
+}
+
+bool replayActive() { return replaying; }
+bool recordingActive() { return recording; }
+bool replayFinished() { return replayDone.load(); }
+long long replayDesyncTick() { return desyncTick; }
+long long replayTickCount() { return totalTicks; }
+
+void collectReplayMemory(MemoryReport& report) {
+    if (!runs.empty()) report.addVector("replay", "input runs", runs);
+    if (!checksums.empty()) report.addVector("replay", "tick checksums", checksums);
+    for (const std::vector<unsigned char>& buffer : keyframeBuffers) {
+        if (!buffer.empty()) report.addVector("replay", "keyframe buffers", buffer);
+    }
+}
+
+// ============================ PER TICK ============================
+// Compares the world as this replayed tick starts with the recorded checksum, if there is one
+static void checkTick() {
+    const long long index = replayTick - checksumFirstTick;
+    if (index < 0 || index >= static_cast<long long>(checksums.size())) return;
+    ++checkedTicks;
+    const uint64_t actual = worldChecksum(world);
+    if (actual == checksums[static_cast<size_t>(index)]) return;
+    if (desyncTicks++ == 0) {
+        desyncTick = replayTick;
+        LOG_ERROR("Replay desync at tick %lld: world checksum %016llx, recorded %016llx", replayTick,
+                  static_cast<unsigned long long>(actual), static_cast<unsigned long long>(checksums[static_cast<size_t>(index)]));
+    }
+}
+
+InputState tickInput(const InputState& live) {
+    if (replaying) {
+        checkTick();
+        ++replayTick;
+        if (replayRun >= runs.size()) return InputState(); // Past the end: no keys held
+        InputState input = unpackInput(runs[replayRun].bits);
+        if (++replayRunTick == runs[replayRun].length) {
+            ++replayRun;
+            replayRunTick = 0;
+            if (replayRun == runs.size()) {
+                replayDone.store(true);
+                if (desyncTicks > 0) LOG_ERROR("Replay: %lld of %lld checked ticks differ, the first at tick %lld", desyncTicks, checkedTicks, desyncTick);
+                else if (checkedTicks > 0) LOG_INFO("Replay: all %lld checked ticks match the recording", checkedTicks);
+            }
+        }
+        return input;
+    }
+    if (recording) {
+        if (totalTicks % REPLAY_KEYFRAME_TICKS == 0) handOff(true);
+        if (recordChecksums) checksums.push_back(worldChecksum(world)); // Within the reserve handOff just made
+        uint8_t bits = packInput(live);
+        if (!runs.empty() && runs.back().bits == bits && runs.back().length < UINT32_MAX) ++runs.back().length;
+        else {
+            AllowAllocations growth; // The runs grow with the session, past the reserve now and then
+            runs.push_back({ bits, 1 });
+        }
+        ++totalTicks;
+    }
+    return live;
+}
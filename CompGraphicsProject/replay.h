@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+
+#include "simulation.h"
+
+// Input recording and deterministic replay. A recording is the random seed plus the key state
+// consumed by every simulation tick, run-length encoded. Since a tick depends only on its input
+// and the seeded random streams, replaying a file reproduces the session exactly, headless or
+// rendered, on any build, which makes frame-time regressions bisectable.
+// Every REPLAY_KEYFRAME_TICKS the recording also stores a keyframe, a snapshot of the game's world
+// (snapshot.h), so a replay can start anywhere: seeking restores the nearest keyframe at or before
+// the tick and plays the recorded input from there. The per-tick deltas are the input bits alone;
+// the simulation is deterministic, so storing entity state between keyframes (quantized or not)
+// would only repeat what replaying the input reproduces exactly. Files are written by a background
+// thread as the session goes, and read through a memory mapping: loading touches the record headers
+// and the input, and a seek reads the one keyframe it restores.
+// A recording can also carry every tick's world checksum (snapshot.h). Replaying it then checks each
+// tick against the recorded one and reports the first that differs: a desync between builds, between
+// --jobs counts or the thread modes, or after a change that was meant to keep the simulation as it was.
+
+// ============================ FILE FORMAT ============================
+// u32 magic "AREC", u32 version, u64 seed, u32 options, u64 tick count, u32 keyframe interval, then
+// records: u8 type, u64 payload bytes, payload
+//   input: (u8 key bits, varint run length) pairs, continuing the runs before it
+//   keyframe: u64 tick (the world as that tick starts), then a snapshot block
+//   checksums: u64 first tick, then a u64 worldChecksum per tick (the world as each tick starts)
+// The tick count is written when the recording stops; 0 means it did not (a crash), and a replay
+// then runs to the end of the last complete record.
+// Version 3 files (u8 key bits, u16 run length pairs after the tick count, no keyframes) still play,
+// and so does the input of version 4 files (their keyframes and checksums are of the old snapshot format).
+const uint32_t REPLAY_MAGIC = 0x43455241; // "AREC"
+const uint32_t REPLAY_VERSION = 10; // 2: collisions across the wrap edges (older recordings diverge); 3: options; 4: records and keyframes; 5: ship store; 6: rock palette entries; 7: rock scale and radius from the size class (keyframes and checksums); 8: polynomial sine and cosine (fastmath.h) instead of libm's; 9: rock, pair-batch and ship searches no longer stop at 64 candidates, and wrapped rock pairs are measured with wrappedDelta (dense scenarios play out differently); 10: rock gravity adds cells' quadrupole terms, opens cells reaching past its range and sums directly below GRAVITY_DIRECT_BODIES
+const uint8_t REPLAY_RECORD_INPUT = 1;
+const uint8_t REPLAY_RECORD_KEYFRAME = 2;
+const uint8_t REPLAY_RECORD_CHECKSUMS = 3;
+const int REPLAY_KEYFRAME_TICKS = 1200; // 10 s of game time
+const int REPLAY_KEYFRAME_BUFFERS = 4; // Keyframes saved but not yet written; one more is skipped (a seek then starts further back)
+
+// Gameplay options a session was recorded with (they change what the same input does)
+const uint32_t REPLAY_OPTION_ROCK_COLLISIONS = 1;
+const uint32_t REPLAY_OPTION_SWEEP_AND_PRUNE = 2; // Finds the rock pairs in another order
+const uint32_t REPLAY_OPTION_KINETIC = 4; // Bullet hits from predicted impacts (see KineticSchedule)
+const uint32_t REPLAY_OPTION_LAZY_MOTION = 8; // Rocks positioned from their anchors (they wrap differently)
+const uint32_t REPLAY_OPTION_FIXED_POINT = 16; // Kinematics in Q16.16 (fixedpoint.h)
+const uint32_t REPLAY_OPTION_SILHOUETTE = 32; // Hits against the rocks' outlines (older recordings used circles)
+const uint32_t REPLAY_OPTION_SPATIAL_SORT = 64; // Rocks re-sorted in Z-order (their indices, so the hit order, change)
+const uint32_t REPLAY_OPTION_WAVES = 128; // Rocks from the wave script, not the spawn timer (waves.h)
+// The ships' WeaponKind in bits 8-9 (older recordings: 0, the blaster)
+const uint32_t REPLAY_OPTION_WEAPON_SHIFT = 8;
+const uint32_t REPLAY_OPTION_WEAPON_MASK = 3u << REPLAY_OPTION_WEAPON_SHIFT;
+const uint32_t REPLAY_OPTION_BRUTE_FORCE = 1024; // Every rock pair tested, found in store order (never with SWEEP_AND_PRUNE)
+
+const uint32_t REPLAY_OPTION_GRAVITY_WELLS = 2048; // The rocks pulled by GRAVITY_WELLS
+const uint32_t REPLAY_OPTION_ROCK_GRAVITY = 4096; // And by the large rocks, through a tree opened at the angle below
+// With ROCK_GRAVITY: the tree's opening angle (GameWorld::gravityTheta) in hundredths, in bits 16-23
+const uint32_t REPLAY_OPTION_THETA_SHIFT = 16;
+const uint32_t REPLAY_OPTION_THETA_MASK = 255u << REPLAY_OPTION_THETA_SHIFT;
+
+inline uint32_t gravityReplayOptions(const GameWorld& source) {
+    const uint32_t theta = static_cast<uint32_t>(std::lround(source.gravityTheta * 100.0f)) << REPLAY_OPTION_THETA_SHIFT;
+    return (source.gravityWells ? REPLAY_OPTION_GRAVITY_WELLS : 0) | (source.rockGravity ? REPLAY_OPTION_ROCK_GRAVITY | theta : 0);
+}
+
+inline void applyGravityReplayOptions(uint32_t options, GameWorld& target) {
+    target.gravityWells = (options & REPLAY_OPTION_GRAVITY_WELLS) != 0;
+    target.rockGravity = (options & REPLAY_OPTION_ROCK_GRAVITY) != 0;
+    target.gravityTheta = target.rockGravity ? static_cast<float>((options & REPLAY_OPTION_THETA_MASK) >> REPLAY_OPTION_THETA_SHIFT) / 100.0f : GRAVITY_DEFAULT_THETA;
+}
+
+inline AsteroidBroadphase replayBroadphase(uint32_t options) {
+    if (options & REPLAY_OPTION_SWEEP_AND_PRUNE) return BROADPHASE_SWEEP_AND_PRUNE;
+    return (options & REPLAY_OPTION_BRUTE_FORCE) ? BROADPHASE_BRUTE_FORCE : BROADPHASE_GRID;
+}
+
+// ============================ RECORD / REPLAY API ============================
+// Written as it goes; finished by stopRecording. With `withChecksums`, every tick's world checksum goes in too.
+bool startRecording(const char* path, uint64_t seed, uint32_t options, bool withChecksums);
+void stopRecording();
+// Seed the streams with the returned seed, and apply the returned options, before anything spawns
+bool loadReplay(const char* path, uint64_t& seed, uint32_t& options);
+// Brings the game's world (init'ed, seeded) to the start of `tick`: restores the nearest keyframe
+// at or before it and replays the ticks in between. Call before the first tick runs.
+bool seekReplay(long long tick);
+bool replayActive();
+bool recordingActive();
+bool replayFinished(); // Every recorded tick has been consumed (safe to poll from the render thread)
+// First tick whose checksum differed from the recording's (-1: none so far, or nothing recorded to check)
+long long replayDesyncTick();
+long long replayTickCount();
+void collectReplayMemory(MemoryReport& report); // The recording or replay's input runs (simulating thread)
+
+// Call once per tick with the live input, just before the game's world steps with what it returns:
+// returns the recorded input while a replay is loaded (the live keys are ignored, the world's checksum
+// is compared with the recorded one), and records the live input (and, every REPLAY_KEYFRAME_TICKS, a
+// keyframe of the world) while recording
+InputState tickInput(const InputState& live);
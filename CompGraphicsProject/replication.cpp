@@ -0,0 +1,330 @@
+#include "replication.h"
+
+#include <algorithm>
+#include <cmath>
+
+// ============================ QUANTIZING ============================
+static int16_t quantize(float v, float scale) {
+    const float steps = std::nearbyint(v * scale);
+    return static_cast<int16_t>(std::clamp(steps, -32767.0f, 32767.0f));
+}
+
+// Radians to a fraction of a turn, wrapped (an angle of any size keeps its low 16 bits)
+static uint16_t quantizeAngle(float radians) {
+    const double turns = radians * (65536.0 / (2.0 * 3.14159265358979323846));
+    return static_cast<uint16_t>(static_cast<int64_t>(std::nearbyint(turns)) & 0xFFFF);
+}
+
+uint8_t changedReplicationFields(const ReplicatedEntity& a, const ReplicatedEntity& b) {
+    uint8_t fields = 0;
+    if (a.x != b.x || a.y != b.y) fields |= REPLICATION_FIELD_POSITION;
+    if (a.vx != b.vx || a.vy != b.vy) fields |= REPLICATION_FIELD_VELOCITY;
+    if (a.rotation != b.rotation) fields |= REPLICATION_FIELD_ROTATION;
+    if (a.look != b.look) fields |= REPLICATION_FIELD_LOOK;
+    if (a.extra != b.extra) fields |= REPLICATION_FIELD_EXTRA;
+    return fields;
+}
+
+// ============================ INTEREST ============================
+// Cells half the radius across, so the rings a query visits hug its circle; a whole-field query
+// never touches the grid
+void initInterestGrid(SpatialGrid& grid, float radius, size_t capacity) {
+    grid.init(radius > 0.0f ? radius * 0.5f : FIELD_WIDTH, capacity);
+}
+
+// Within `radius` of the ship, measured to the nearest image through the wrap edges
+static bool withinInterest(glm::vec2 ship, glm::vec2 position, float reach) {
+    const float dx = nearestImage(position.x, ship.x) - ship.x;
+    const float dy = nearestImage(position.y, ship.y) - ship.y;
+    return dx * dx + dy * dy <= reach * reach;
+}
+
+void gatherReplicatedEntities(const GameWorld& source, float radius, SpatialGrid& grid, std::vector<ReplicatedEntity>& out) {
+    out.clear();
+    const ShipStore& ships = source.ships;
+    const glm::vec2 viewer = ships.position(0); // Interest is centred on the match's player
+    for (size_t s = 0; s < ships.count(); ++s) {
+        ReplicatedEntity craft;
+        craft.id = replicatedId(REPLICATED_SHIP, { static_cast<uint32_t>(s), 0 });
+        craft.x = quantize(ships.x[s], REPLICATION_POSITION_SCALE);
+        craft.y = quantize(ships.y[s], REPLICATION_POSITION_SCALE);
+        craft.vx = quantize(ships.vx[s], REPLICATION_VELOCITY_SCALE);
+        craft.vy = quantize(ships.vy[s], REPLICATION_VELOCITY_SCALE);
+        craft.rotation = quantizeAngle(ships.rot[s]);
+        craft.look = (ships.thrusting[s] ? 1u : 0u) | (ships.shieldActive[s] ? 2u : 0u) | (ships.alive[s] ? 0u : 4u);
+        craft.extra = static_cast<uint32_t>(ships.score[s]);
+        out.push_back(craft);
+    }
+
+    const AsteroidStore& rocks = source.asteroids;
+    const bool everything = radius <= 0.0f;
+    auto addRock = [&](size_t i) {
+        if (rocks.destroyed[i]) return;
+        if (!everything && !withinInterest(viewer, rocks.position(i), radius + rocks.radius(i))) return;
+        ReplicatedEntity rock;
+        rock.id = replicatedId(REPLICATED_ROCK, rocks.handles.handle(i));
+        rock.x = quantize(rocks.x[i], REPLICATION_POSITION_SCALE);
+        rock.y = quantize(rocks.y[i], REPLICATION_POSITION_SCALE);
+        rock.vx = quantize(rocks.vx[i], REPLICATION_VELOCITY_SCALE);
+        rock.vy = quantize(rocks.vy[i], REPLICATION_VELOCITY_SCALE);
+        rock.rotation = quantizeAngle(rocks.rot[i]);
+        rock.look = static_cast<uint32_t>(rocks.sizeClass[i]) | (static_cast<uint32_t>(rocks.shapeIndex[i] & 0x3F) << 2) |
+                    (static_cast<uint32_t>(rocks.paletteIndex[i]) << 8);
+        out.push_back(rock);
+    };
+    if (everything) {
+        for (size_t i = 0; i < rocks.count(); ++i) addRock(i);
+    }
+    else {
+        grid.build(rocks.x.data(), rocks.y.data(), rocks.count());
+        grid.forEachWithin(viewer, radius + getRadiusFactor(LARGE), [&](int i) { addRock(static_cast<size_t>(i)); });
+    }
+
+    const BulletStore& bullets = source.bullets;
+    for (size_t j = 0; j < bullets.capacity(); ++j) {
+        if (!bullets.live(j)) continue;
+        if (!everything && !withinInterest(viewer, bullets.position(j), radius + bullets.radius[j])) continue;
+        ReplicatedEntity bullet;
+        bullet.id = replicatedId(REPLICATED_BULLET, bullets.handle(j));
+        bullet.x = quantize(bullets.x[j], REPLICATION_POSITION_SCALE);
+        bullet.y = quantize(bullets.y[j], REPLICATION_POSITION_SCALE);
+        bullet.vx = quantize(bullets.vx[j], REPLICATION_VELOCITY_SCALE);
+        bullet.vy = quantize(bullets.vy[j], REPLICATION_VELOCITY_SCALE);
+        out.push_back(bullet);
+    }
+    std::sort(out.begin(), out.end(), [](const ReplicatedEntity& a, const ReplicatedEntity& b) { return a.id < b.id; });
+}
+
+// ============================ VARINTS ============================
+struct ReplicationWriter {
+    unsigned char* data;
+    size_t capacity;
+    size_t used = 0;
+    bool overflow = false;
+
+    void byte(uint8_t b) {
+        if (used < capacity) data[used++] = b;
+        else overflow = true;
+    }
+    void u32(uint32_t v) {
+        for (int k = 0; k < 4; ++k) byte(static_cast<uint8_t>(v >> (8 * k)));
+    }
+    void varint(uint32_t v) {
+        while (v >= 0x80) {
+            byte(static_cast<uint8_t>(v | 0x80));
+            v >>= 7;
+        }
+        byte(static_cast<uint8_t>(v));
+    }
+    void signedVarint(int32_t v) { varint((static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31)); } // Zigzag: small either way
+};
+
+struct ReplicationReader {
+    const unsigned char* data;
+    size_t size;
+    size_t used = 0;
+    bool overflow = false;
+
+    uint8_t byte() {
+        if (used < size) return data[used++];
+        overflow = true;
+        return 0;
+    }
+    uint32_t u32() {
+        uint32_t v = 0;
+        for (int k = 0; k < 4; ++k) v |= static_cast<uint32_t>(byte()) << (8 * k);
+        return v;
+    }
+    uint32_t varint() {
+        uint32_t v = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            const uint8_t b = byte();
+            v |= static_cast<uint32_t>(b & 0x7F) << shift;
+            if (!(b & 0x80)) return v;
+        }
+        overflow = true; // Longer than a u32 can need
+        return 0;
+    }
+    int32_t signedVarint() {
+        const uint32_t v = varint();
+        return static_cast<int32_t>((v >> 1) ^ (0u - (v & 1)));
+    }
+};
+
+// ============================ RECORDS ============================
+static void writeFields(ReplicationWriter& writer, uint8_t fields, const ReplicatedEntity& from, const ReplicatedEntity& to) {
+    if (fields & REPLICATION_FIELD_POSITION) {
+        writer.signedVarint(to.x - from.x);
+        writer.signedVarint(to.y - from.y);
+    }
+    if (fields & REPLICATION_FIELD_VELOCITY) {
+        writer.signedVarint(to.vx - from.vx);
+        writer.signedVarint(to.vy - from.vy);
+    }
+    if (fields & REPLICATION_FIELD_ROTATION) writer.signedVarint(static_cast<int16_t>(static_cast<uint16_t>(to.rotation - from.rotation)));
+    if (fields & REPLICATION_FIELD_LOOK) writer.varint(to.look);
+    if (fields & REPLICATION_FIELD_EXTRA) writer.varint(to.extra);
+}
+
+static void readFields(ReplicationReader& reader, uint8_t fields, ReplicatedEntity& entity) {
+    if (fields & REPLICATION_FIELD_POSITION) {
+        entity.x = static_cast<int16_t>(entity.x + reader.signedVarint());
+        entity.y = static_cast<int16_t>(entity.y + reader.signedVarint());
+    }
+    if (fields & REPLICATION_FIELD_VELOCITY) {
+        entity.vx = static_cast<int16_t>(entity.vx + reader.signedVarint());
+        entity.vy = static_cast<int16_t>(entity.vy + reader.signedVarint());
+    }
+    if (fields & REPLICATION_FIELD_ROTATION) entity.rotation = static_cast<uint16_t>(entity.rotation + reader.signedVarint());
+    if (fields & REPLICATION_FIELD_LOOK) entity.look = reader.varint();
+    if (fields & REPLICATION_FIELD_EXTRA) entity.extra = reader.varint();
+}
+
+static void writeRecord(ReplicationWriter& writer, ReplicationOp op, uint8_t fields, uint32_t id, uint32_t& previousId) {
+    writer.byte(static_cast<uint8_t>(op | (fields << 2)));
+    writer.varint(id - previousId);
+    previousId = id;
+}
+
+// ============================ SENDER ============================
+// `current` as snapshot `sequence`, relative to `baseline` (snapshot `baselineSequence`; 0 and an
+// empty list for a whole one). Returns the bytes written, or 0 on overflow.
+static size_t encodeSnapshot(uint32_t sequence, uint32_t baselineSequence, const std::vector<ReplicatedEntity>& baseline,
+                             const std::vector<ReplicatedEntity>& current, unsigned char* out, size_t capacity) {
+    ReplicationWriter writer{ out, capacity };
+    writer.u32(sequence);
+    writer.u32(baselineSequence);
+    const size_t countAt = writer.used;
+    writer.u32(0); // Record count, filled in below
+
+    // Both lists are sorted by id: one merge finds the created, removed and changed
+    uint32_t records = 0, previousId = 0;
+    const ReplicatedEntity zero;
+    size_t a = 0, b = 0;
+    while (a < baseline.size() || b < current.size()) {
+        if (b == current.size() || (a < baseline.size() && baseline[a].id < current[b].id)) {
+            writeRecord(writer, REPLICATION_REMOVE, 0, baseline[a++].id, previousId);
+            ++records;
+        }
+        else if (a == baseline.size() || current[b].id < baseline[a].id) {
+            const uint8_t fields = changedReplicationFields(zero, current[b]);
+            writeRecord(writer, REPLICATION_CREATE, fields, current[b].id, previousId);
+            writeFields(writer, fields, zero, current[b]);
+            ++records;
+            ++b;
+        }
+        else {
+            const uint8_t fields = changedReplicationFields(baseline[a], current[b]);
+            if (fields) {
+                writeRecord(writer, REPLICATION_UPDATE, fields, current[b].id, previousId);
+                writeFields(writer, fields, baseline[a], current[b]);
+                ++records;
+            }
+            ++a;
+            ++b;
+        }
+    }
+    if (writer.overflow) return 0;
+    for (int k = 0; k < 4; ++k) out[countAt + k] = static_cast<unsigned char>(records >> (8 * k));
+    return writer.used;
+}
+
+size_t encodeReplication(ReplicationSender& sender, const std::vector<ReplicatedEntity>& current, unsigned char* out, size_t capacity) {
+    static const std::vector<ReplicatedEntity> nothing;
+    const ReplicationBaseline& acked = sender.sent[sender.acked % REPLICATION_BASELINES];
+    const bool delta = sender.acked != 0 && acked.sequence == sender.acked;
+    const uint32_t sequence = sender.nextSequence;
+    const size_t bytes = encodeSnapshot(sequence, delta ? sender.acked : 0, delta ? acked.entities : nothing, current, out, capacity);
+    if (bytes == 0) return 0;
+
+    ReplicationBaseline& slot = sender.sent[sequence % REPLICATION_BASELINES];
+    slot.sequence = sequence;
+    slot.entities.assign(current.begin(), current.end());
+    sender.nextSequence = sequence + 1 == 0 ? 1 : sequence + 1;
+    sender.bytes += bytes;
+    ++sender.snapshots;
+    if (delta) ++sender.deltas;
+    sender.meanBytes += (static_cast<double>(bytes) - sender.meanBytes) / (sender.snapshots < 32 ? sender.snapshots : 32);
+    return bytes;
+}
+
+void acknowledgeReplication(ReplicationSender& sender, uint32_t sequence) {
+    // Only a newer one that was actually sent (an old, duplicated or forged ack is ignored)
+    if (sequence == 0 || sequence >= sender.nextSequence || sequence <= sender.acked) return;
+    sender.acked = sequence;
+}
+
+// ============================ BROADCAST ============================
+uint32_t pushReplicationBroadcast(ReplicationBroadcast& broadcast, const std::vector<ReplicatedEntity>& current) {
+    const uint32_t sequence = broadcast.nextSequence;
+    ReplicationBaseline& slot = broadcast.sent[sequence % REPLICATION_BASELINES];
+    slot.sequence = sequence;
+    slot.entities.assign(current.begin(), current.end());
+    broadcast.nextSequence = sequence + 1 == 0 ? 1 : sequence + 1;
+    return sequence;
+}
+
+bool replicationBroadcastKeeps(const ReplicationBroadcast& broadcast, uint32_t acked) {
+    return acked != 0 && broadcast.sent[acked % REPLICATION_BASELINES].sequence == acked;
+}
+
+size_t encodeReplicationBroadcast(const ReplicationBroadcast& broadcast, uint32_t acked, unsigned char* out, size_t capacity) {
+    static const std::vector<ReplicatedEntity> nothing;
+    const uint32_t newest = broadcast.nextSequence == 1 ? 0xFFFFFFFFu : broadcast.nextSequence - 1;
+    const ReplicationBaseline& current = broadcast.sent[newest % REPLICATION_BASELINES];
+    if (current.sequence != newest) return 0; // Nothing pushed yet
+    const bool delta = replicationBroadcastKeeps(broadcast, acked);
+    return encodeSnapshot(newest, delta ? acked : 0, delta ? broadcast.sent[acked % REPLICATION_BASELINES].entities : nothing,
+                          current.entities, out, capacity);
+}
+
+// ============================ RECEIVER ============================
+bool decodeReplication(ReplicationReceiver& receiver, const unsigned char* data, size_t bytes) {
+    ReplicationReader reader{ data, bytes };
+    const uint32_t sequence = reader.u32();
+    const uint32_t baselineSequence = reader.u32();
+    const uint32_t records = reader.u32();
+    if (reader.overflow || sequence == 0 || sequence <= receiver.latest) return false;
+    static const std::vector<ReplicatedEntity> nothing;
+    const ReplicationBaseline& kept = receiver.received[baselineSequence % REPLICATION_BASELINES];
+    if (baselineSequence != 0 && kept.sequence != baselineSequence) return false;
+    const std::vector<ReplicatedEntity>& baseline = baselineSequence != 0 ? kept.entities : nothing;
+
+    std::vector<ReplicatedEntity> decoded;
+    decoded.reserve(baseline.size() + records);
+    size_t a = 0;
+    uint32_t id = 0;
+    for (uint32_t r = 0; r < records; ++r) {
+        const uint8_t head = reader.byte();
+        const ReplicationOp op = static_cast<ReplicationOp>(head & 3);
+        const uint8_t fields = head >> 2;
+        const uint32_t gap = reader.varint();
+        if (reader.overflow || op > REPLICATION_REMOVE || (r > 0 && gap == 0) || id + gap < id) return false; // Ids strictly rising
+        id += gap;
+        // The baseline's entities before this id are unchanged
+        while (a < baseline.size() && baseline[a].id < id) decoded.push_back(baseline[a++]);
+        const bool inBaseline = a < baseline.size() && baseline[a].id == id;
+        if (op == REPLICATION_CREATE) {
+            if (inBaseline) return false;
+            ReplicatedEntity entity;
+            entity.id = id;
+            readFields(reader, fields, entity);
+            decoded.push_back(entity);
+        }
+        else {
+            if (!inBaseline) return false;
+            ReplicatedEntity entity = baseline[a++];
+            if (op == REPLICATION_REMOVE) continue;
+            readFields(reader, fields, entity);
+            decoded.push_back(entity);
+        }
+    }
+    while (a < baseline.size()) decoded.push_back(baseline[a++]);
+    if (reader.overflow || reader.used != bytes) return false;
+
+    ReplicationBaseline& slot = receiver.received[sequence % REPLICATION_BASELINES];
+    slot.sequence = sequence;
+    slot.entities = std::move(decoded);
+    receiver.latest = sequence;
+    return true;
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "simulation.h"
+
+#include <glm/gtc/constants.hpp>
+
+// Snapshot replication for the match server (server.h): what a client is sent of its match's world.
+// The world is reduced to a list of entities (the ships, the rocks and bullets within the client's
+// interest radius of ship 0, the match's player), each quantized to a few integers and keyed by a stable id made from
+// its handle, so the same rock has the same id snapshot after snapshot. A snapshot is encoded as the
+// difference from the newest one the client has acknowledged: entities that appeared are sent whole,
+// the ones that changed send only their changed fields as small varint deltas, the ones gone from
+// the list (destroyed, or out of interest) send just their id, and unchanged ones send nothing.
+// Without an acknowledged baseline still kept, the snapshot goes whole (against an empty list).
+// Positions are kept to 1/16384 of the field's unit (well under a pixel at 4K), velocities to 1/4096
+// of a unit a second (for extrapolating between snapshots), rotations to 1/65536 of a turn.
+// The receiving side is here too: a client decodes into the same list and acknowledges it.
+// Like simulation.h, nothing here depends on GL.
+
+// ============================ ENTITIES ============================
+enum ReplicatedKind : uint32_t { REPLICATED_SHIP = 0, REPLICATED_ROCK = 1, REPLICATED_BULLET = 2 };
+
+// Id: kind in the top 2 bits, then the handle's slot (20 bits) and the low 10 bits of its generation.
+// Ship s is the handle { s, 0 }, so ship 0 is id 0; a list is kept in ascending id order.
+inline uint32_t replicatedId(ReplicatedKind kind, EntityHandle handle) {
+    return (static_cast<uint32_t>(kind) << 30) | ((handle.slot & 0xFFFFFu) << 10) | (handle.generation & 0x3FFu);
+}
+inline ReplicatedKind replicatedKind(uint32_t id) { return static_cast<ReplicatedKind>(id >> 30); }
+
+const float REPLICATION_POSITION_SCALE = 16384.0f; // Steps per field unit (the field spans +-1, bullets reach 1.5)
+const float REPLICATION_VELOCITY_SCALE = 4096.0f;  // Steps per unit a second
+const int REPLICATION_FIELD_COUNT = 5;
+
+// Field bits: what an update carries
+const uint8_t REPLICATION_FIELD_POSITION = 1;
+const uint8_t REPLICATION_FIELD_VELOCITY = 2;
+const uint8_t REPLICATION_FIELD_ROTATION = 4;
+const uint8_t REPLICATION_FIELD_LOOK = 8;   // Rock: size class, shape and color; ship: thrust, shield and lost bits
+const uint8_t REPLICATION_FIELD_EXTRA = 16; // Ship: its score
+
+struct ReplicatedEntity {
+    uint32_t id = 0;
+    int16_t x = 0, y = 0;
+    int16_t vx = 0, vy = 0;
+    uint16_t rotation = 0; // Of a turn
+    uint32_t look = 0; // Rock: size | shape << 2 | palette entry << 8; ship: 1 thrusting, 2 shield up, 4 lost
+    uint32_t extra = 0;
+};
+
+// Fields that differ between two states of the same entity
+uint8_t changedReplicationFields(const ReplicatedEntity& a, const ReplicatedEntity& b);
+
+// Back to field units, units a second and radians, for a receiver that draws what it is sent
+inline glm::vec2 replicatedPosition(const ReplicatedEntity& e) { return glm::vec2(e.x, e.y) / REPLICATION_POSITION_SCALE; }
+inline glm::vec2 replicatedVelocity(const ReplicatedEntity& e) { return glm::vec2(e.vx, e.vy) / REPLICATION_VELOCITY_SCALE; }
+inline float replicatedRotation(const ReplicatedEntity& e) { return e.rotation * (2.0f * glm::pi<float>() / 65536.0f); }
+
+// Every ship, and the rocks and bullets that may be seen from ship 0: within `radius` of it (with
+// their own radius, through the wrap edges), or everything with a radius of 0. Rocks are found
+// through `grid` (sized by initInterestGrid, rebuilt here), bullets by a scan (a few dozen at most).
+// `out` is cleared and left sorted by id.
+void initInterestGrid(SpatialGrid& grid, float radius, size_t capacity);
+void gatherReplicatedEntities(const GameWorld& source, float radius, SpatialGrid& grid, std::vector<ReplicatedEntity>& out);
+
+// ============================ WIRE FORMAT ============================
+// u32 sequence, u32 baseline sequence (0: none, the snapshot is whole), u32 record count, then the
+// records in ascending id order, each: u8 (op in bits 0-1, field bits from bit 2), varint id gap from
+// the previous record (the first from 0), then its fields in bit order, each a zigzag varint of the
+// difference from the baseline's value (position and velocity x then y; rotation as a signed 16-bit
+// turn difference; look and extra as plain varints). A create's baseline is an all-zero entity.
+enum ReplicationOp : uint8_t { REPLICATION_UPDATE = 0, REPLICATION_CREATE = 1, REPLICATION_REMOVE = 2 };
+
+// Worst cases per record, for sizing: a create with every field, and a remove
+const size_t REPLICATION_MAX_RECORD_BYTES = 1 + 5 + 2 * 3 + 2 * 3 + 3 + 5 + 5;
+const size_t REPLICATION_REMOVE_BYTES = 1 + 5;
+const size_t REPLICATION_HEADER_BYTES = 12;
+// Largest snapshot for lists of up to `entities` (each one created, and as many removed)
+inline size_t replicationBytesBound(size_t entities) {
+    return REPLICATION_HEADER_BYTES + entities * (REPLICATION_MAX_RECORD_BYTES + REPLICATION_REMOVE_BYTES);
+}
+
+const int REPLICATION_BASELINES = 32; // States remembered per client, by sequence (at 20 snapshots a second, 1.6 s of acks)
+
+struct ReplicationBaseline {
+    uint32_t sequence = 0; // 0: empty
+    std::vector<ReplicatedEntity> entities;
+};
+
+// ============================ SENDER ============================
+// One per client, on the thread that steps its match
+struct ReplicationSender {
+    uint32_t nextSequence = 1;
+    uint32_t acked = 0; // Newest sequence the client has confirmed
+    ReplicationBaseline sent[REPLICATION_BASELINES];
+    // Traffic, for the bandwidth report
+    uint64_t bytes = 0;
+    uint64_t snapshots = 0;
+    uint64_t deltas = 0; // Of the snapshots, those encoded against a baseline
+    double meanBytes = 0.0; // Per snapshot, a running mean
+};
+
+// Encodes `current` (sorted by id) for the client and remembers it as sent. Returns the bytes
+// written, or 0 if they would not fit in `capacity` (then nothing is remembered).
+size_t encodeReplication(ReplicationSender& sender, const std::vector<ReplicatedEntity>& current, unsigned char* out, size_t capacity);
+// The client has decoded `sequence`: later snapshots may use it as their baseline
+void acknowledgeReplication(ReplicationSender& sender, uint32_t sequence);
+
+// ============================ BROADCAST ============================
+// One stream re-sent to any number of receivers (the relay, relay.h): the states are kept once
+// rather than per receiver, and a receiver is only the sequence it last acknowledged. Receivers that
+// acknowledged the same snapshot get the same bytes, so the sender encodes once per distinct ack.
+struct ReplicationBroadcast {
+    uint32_t nextSequence = 1;
+    ReplicationBaseline sent[REPLICATION_BASELINES];
+};
+
+// Remembers `current` (sorted by id) as the next snapshot and returns its sequence
+uint32_t pushReplicationBroadcast(ReplicationBroadcast& broadcast, const std::vector<ReplicatedEntity>& current);
+// The newest snapshot for a receiver that acknowledged `acked` (0: none; against an empty list when
+// that state is no longer kept). Returns the bytes written, or 0 if they would not fit in `capacity`.
+size_t encodeReplicationBroadcast(const ReplicationBroadcast& broadcast, uint32_t acked, unsigned char* out, size_t capacity);
+// `acked` names a snapshot the broadcast still keeps, so it may be a receiver's baseline
+bool replicationBroadcastKeeps(const ReplicationBroadcast& broadcast, uint32_t acked);
+
+// ============================ RECEIVER ============================
+struct ReplicationReceiver {
+    ReplicationBaseline received[REPLICATION_BASELINES];
+    uint32_t latest = 0; // Newest sequence decoded (what to acknowledge)
+    const std::vector<ReplicatedEntity>& entities() const { return received[latest % REPLICATION_BASELINES].entities; }
+};
+
+// Decodes a snapshot into the receiver. False if it is malformed, older than the latest one, or
+// relative to a baseline no longer kept (a later snapshot will be relative to an older ack).
+bool decodeReplication(ReplicationReceiver& receiver, const unsigned char* data, size_t bytes);
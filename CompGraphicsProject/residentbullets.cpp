@@ -0,0 +1,228 @@
+#include "residentbullets.h"
+#include "frameconstants.h"
+#include "glstate.h"
+#include "shaders.h"
+#include "simulation.h"
+#include "memreport.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+bool useResidentBullets = false;
+
+// ============================ RESIDENT BULLET DATA ============================
+// One per ring slot, as attributes 0 and 1 of bulletVAO
+struct BulletRecord {
+    glm::vec2 origin; // Where the bullet was at originTime
+    glm::vec2 velocity;
+    float originTime;
+    float firstTime; // Drawn as at no earlier time than this (a new bullet's first tick); RECORD_NEVER: no limit
+    float expiresAt; // RECORD_NEVER: the slot holds no bullet
+    float unused;
+};
+static_assert(sizeof(BulletRecord) == 32, "The vertex shader reads a BulletRecord as two vec4 attributes");
+const float RECORD_NEVER = -1e30f;
+const size_t MAX_UPLOAD_RUNS = 16; // Dirty runs per sync before one upload spanning them all is cheaper
+
+// The slot's bullet its record was written from
+struct RecordSource {
+    uint32_t generation;
+    bool live;
+};
+
+static unsigned int bulletProgram, bulletVAO, recordBuffer;
+static int timeLoc, paintLoc;
+static std::vector<BulletRecord> records; // As the buffer holds them
+static std::vector<RecordSource> sources;
+static std::vector<unsigned char> dirty;
+static double epoch = 0.0;
+static uint64_t bytesWritten = 0;
+
+// ============================ SHADERS ============================
+static const char* bulletVertexShaderSource = R"(
+    #version 330 core
+    layout (location = 0) in vec4 aMotion; // origin, velocity
+    layout (location = 1) in vec4 aTimes; // originTime, firstTime, expiresAt
+    uniform float time; // Since the epoch
+    uniform uint paint;
+
+    out vec3 vertexColor;
+)" PALETTE_GLSL R"(
+    void main()
+    {
+        vertexColor = paintColor(paint);
+        if (time >= aTimes.z) {
+            gl_Position = vec4(2.0, 2.0, 2.0, 1.0); // Outside the clip volume: the point is dropped
+            return;
+        }
+        vec2 position = aMotion.xy + aMotion.zw * (max(time, aTimes.y) - aTimes.x);
+        gl_Position = vec4(position, 0.0, 1.0);
+    }
+)";
+
+static const char* bulletFragmentShaderSource = R"(
+    #version 330 core
+)" FRAME_CONSTANTS_GLSL R"(
+    in vec3 vertexColor;
+    out vec4 FragColor;
+
+    void main()
+    {
+        FragColor = vec4(vertexColor, 1.0f) * tint;
+    }
+)";
+
+// ============================ SETUP ============================
+bool setupResidentBullets()
+{
+    bulletProgram = buildProgram("resident bullets", bulletVertexShaderSource, bulletFragmentShaderSource);
+    if (!bulletProgram) {
+        useResidentBullets = false;
+        return false;
+    }
+    bindFrameConstants(bulletProgram);
+    timeLoc = glGetUniformLocation(bulletProgram, "time");
+    paintLoc = glGetUniformLocation(bulletProgram, "paint");
+    glGenVertexArrays(1, &bulletVAO);
+    glGenBuffers(1, &recordBuffer);
+    return true;
+}
+
+void destroyResidentBullets()
+{
+    if (recordBuffer) glDeleteBuffers(1, &recordBuffer);
+    if (bulletVAO) glDeleteVertexArrays(1, &bulletVAO);
+    if (bulletProgram) glDeleteProgram(bulletProgram);
+    recordBuffer = bulletVAO = bulletProgram = 0;
+    records.clear();
+    sources.clear();
+    dirty.clear();
+}
+
+void collectResidentBulletMemory(MemoryReport& report)
+{
+    if (!bulletProgram) return;
+    report.add("resident bullets", "records", MEMORY_GPU, glBufferBytes(recordBuffer));
+    report.add("resident bullets", "record mirror", MEMORY_CPU,
+               records.capacity() * sizeof(BulletRecord) + sources.capacity() * sizeof(RecordSource) + dirty.capacity());
+}
+
+bool residentBulletsReady()
+{
+    return bulletProgram != 0;
+}
+
+uint64_t residentBulletBytesWritten()
+{
+    return bytesWritten;
+}
+
+// (Re)allocates the buffer for `capacity` slots, every one empty
+static void resizeRecords(size_t capacity)
+{
+    records.assign(capacity, { glm::vec2(0.0f), glm::vec2(0.0f), 0.0f, RECORD_NEVER, RECORD_NEVER, 0.0f });
+    sources.assign(capacity, { 0, false });
+    dirty.assign(capacity, 1);
+    glState.bindVertexArray(bulletVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, recordBuffer);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(capacity * sizeof(BulletRecord)), NULL, GL_DYNAMIC_DRAW);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(BulletRecord), (void*)offsetof(BulletRecord, origin));
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(BulletRecord), (void*)offsetof(BulletRecord, originTime));
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glState.bindVertexArray(0);
+}
+
+// ============================ SYNC ============================
+void syncResidentBullets(const BulletStore& bullets)
+{
+    if (!bulletProgram) return;
+    const size_t capacity = bullets.capacity();
+    if (records.size() != capacity) resizeRecords(capacity);
+    const double newEpoch = std::floor(bullets.clock / RESIDENT_BULLET_EPOCH_SECONDS) * RESIDENT_BULLET_EPOCH_SECONDS;
+    const float epochShift = static_cast<float>(newEpoch - epoch);
+    epoch = newEpoch;
+    const float now = static_cast<float>(bullets.clock - epoch);
+
+    for (size_t j = 0; j < capacity; ++j) {
+        BulletRecord& record = records[j];
+        RecordSource& source = sources[j];
+        if (!bullets.live(j)) {
+            if (!source.live) continue;
+            source.live = false;
+            record.expiresAt = RECORD_NEVER;
+            dirty[j] = 1;
+            continue;
+        }
+        const glm::vec2 position(bullets.x[j], bullets.y[j]);
+        const glm::vec2 velocity(bullets.vx[j], bullets.vy[j]);
+        const float expiresAt = static_cast<float>(bullets.expiresAt[j] - epoch);
+        const bool fresh = !source.live || source.generation != bullets.generation[j];
+        if (!fresh && epochShift == 0.0f && record.velocity == velocity && record.expiresAt == expiresAt) {
+            const glm::vec2 predicted = record.origin + record.velocity * (now - record.originTime);
+            if (glm::distance(predicted, position) <= RESIDENT_BULLET_RESYNC_DISTANCE) continue;
+        }
+        float firstTime = RECORD_NEVER;
+        if (!fresh) {
+            if (record.firstTime != RECORD_NEVER) firstTime = record.firstTime - epochShift;
+        }
+        else if (bullets.px[j] == bullets.x[j] && bullets.py[j] == bullets.y[j]) {
+            // Fired this tick and not moved yet: held at the muzzle until the frame reaches this tick,
+            // as the interpolated instances are
+            firstTime = now;
+        }
+        record = { position, velocity, now, firstTime, expiresAt, 0.0f };
+        source = { bullets.generation[j], true };
+        dirty[j] = 1;
+    }
+
+    // Each dirty run is one upload, or one span covers them all when there are many
+    size_t runs = 0, firstDirty = capacity, endDirty = 0;
+    for (size_t j = 0; j < capacity; ++j) {
+        if (!dirty[j]) continue;
+        if (j == 0 || !dirty[j - 1]) ++runs;
+        firstDirty = std::min(firstDirty, j);
+        endDirty = j + 1;
+    }
+    if (runs == 0) return;
+    glBindBuffer(GL_ARRAY_BUFFER, recordBuffer);
+    const auto upload = [](size_t begin, size_t end) {
+        glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(begin * sizeof(BulletRecord)),
+                        static_cast<GLsizeiptr>((end - begin) * sizeof(BulletRecord)), records.data() + begin);
+        bytesWritten += (end - begin) * sizeof(BulletRecord);
+    };
+    if (runs > MAX_UPLOAD_RUNS) upload(firstDirty, endDirty);
+    else {
+        for (size_t j = firstDirty; j < endDirty;) {
+            if (!dirty[j]) {
+                ++j;
+                continue;
+            }
+            size_t end = j;
+            while (end < endDirty && dirty[end]) ++end;
+            upload(j, end);
+            j = end;
+        }
+    }
+    std::fill(dirty.begin() + firstDirty, dirty.begin() + endDirty, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// ============================ DRAW ============================
+int drawResidentBullets(double time, uint32_t paint, float pointSize)
+{
+    if (!bulletProgram || records.empty()) return 0;
+    glState.useProgram(bulletProgram);
+    glUniform1f(timeLoc, static_cast<float>(time - epoch));
+    glUniform1ui(paintLoc, paint);
+    glState.bindVertexArray(bulletVAO);
+    glState.setPointSize(pointSize);
+    glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(records.size()));
+    glState.bindVertexArray(0);
+    return 1;
+}
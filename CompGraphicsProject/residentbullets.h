@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+struct BulletStore;
+struct MemoryReport;
+
+// GPU-resident bullets (--resident-bullets, toggle with X). A bullet flies in a straight line at a
+// constant velocity until its lifetime runs out, so where it is at any time follows from one record:
+// a point it passed, when, its velocity and when it expires. The records live in a vertex buffer
+// with one slot per BulletStore ring slot, written only when that slot's bullet changes (fired, hit,
+// or moved by a ring compaction or a rollback), and the vertex shader places every slot's point at
+// the frame's time, throwing the expired ones out of the clip volume. A frame in which no bullet is
+// fired or lost uploads nothing for them; the batched pass otherwise streams every live bullet's
+// instance every frame.
+//
+// Times are seconds since an epoch that moves forward every RESIDENT_BULLET_EPOCH_SECONDS of game
+// time, so they keep their precision as floats in a long game; each move rewrites every live record.
+
+// ============================ RESIDENT BULLET STATE ============================
+extern bool useResidentBullets; // Draw the batched pass's bullets from the records (toggle with X)
+const double RESIDENT_BULLET_EPOCH_SECONDS = 64.0;
+// A live record is rewritten once its predicted position is this far off the simulated one
+// (fixed-point motion, or a rolled-back bullet reusing its slot and generation)
+const float RESIDENT_BULLET_RESYNC_DISTANCE = 1e-4f;
+
+// ============================ RESIDENT BULLET API ============================
+// Builds the program; false (and useResidentBullets off) if it fails. The buffer is sized by the
+// first sync.
+bool setupResidentBullets();
+void destroyResidentBullets();
+bool residentBulletsReady(); // Set up, so useResidentBullets may be turned on
+void collectResidentBulletMemory(MemoryReport& report); // Nothing unless set up
+uint64_t residentBulletBytesWritten(); // Record bytes uploaded so far
+
+// Rewrites the records of the slots whose bullet changed since the last sync (all of them when the
+// ring's capacity or the epoch changed)
+void syncResidentBullets(const BulletStore& bullets);
+// Draws every live record at game time `time` as points in palette entry `paint`. Returns the draw
+// calls issued.
+int drawResidentBullets(double time, uint32_t paint, float pointSize);
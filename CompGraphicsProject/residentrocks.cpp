@@ -0,0 +1,268 @@
+#include "residentrocks.h"
+#include "frameconstants.h"
+#include "glstate.h"
+#include "shaders.h"
+#include "simulation.h"
+#include "memreport.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+bool useResidentRocks = false;
+
+// ============================ RESIDENT ROCK DATA ============================
+// One per handle slot, as attributes 1-3 of rockVAO (each record drawn as RESIDENT_ROCK_IMAGES instances)
+struct RockRecord {
+    glm::vec2 origin; // Where the rock was at originTime
+    glm::vec2 velocity;
+    float originTime;
+    float rotation; // At originTime
+    float rotationSpeed;
+    float scale; // 0: the slot holds no rock
+    uint32_t paletteIndex;
+    uint32_t shapeIndex; // Its layer in the SDF array
+};
+static_assert(sizeof(RockRecord) == 40, "The vertex shader reads a RockRecord as two vec4 and a uvec2 attribute");
+const int RESIDENT_ROCK_IMAGES = 4; // The rock, its ghosts across the nearest vertical and horizontal edges, and the corner one
+const size_t MAX_UPLOAD_RUNS = 16; // Dirty runs per sync before one upload spanning them all is cheaper
+
+// The slot's rock its record was written from
+struct RecordSource {
+    uint32_t generation;
+    bool live;
+};
+
+static unsigned int rockProgram, rockVAO, quadBuffer, recordBuffer;
+static std::vector<RockRecord> records; // As the buffer holds them
+static std::vector<RecordSource> sources;
+static std::vector<unsigned char> dirty;
+static std::vector<unsigned char> seen; // Per slot: held a rock at this sync
+static double epoch = 0.0;
+static uint64_t bytesWritten = 0;
+
+// ============================ SHADERS ============================
+// Outputs what the SDF asteroid fragment shader reads. Images that are off screen (and every image
+// of an empty slot) collapse onto one point outside the clip volume.
+static const char* rockVertexShaderSource = R"(
+    #version 330 core
+)" FRAME_CONSTANTS_GLSL R"(
+    layout (location = 0) in vec2 aPos; // Quad corner in shape units
+    layout (location = 1) in vec4 iMotion; // origin, velocity
+    layout (location = 2) in vec4 iSpin; // originTime, rotation then, rotation speed, scale
+    layout (location = 3) in uvec2 iLook; // palette entry, SDF layer
+    uniform float outlineReach; // ASTEROID_MAX_OUTLINE_RADIUS: the bounding circle per unit of scale
+
+    out vec2 shapePosition;
+    flat out uint rockPaint;
+    flat out uint shapeLayer;
+
+    void main()
+    {
+        shapePosition = aPos;
+        rockPaint = iLook.x;
+        shapeLayer = iLook.y;
+        float t = gameTime - iSpin.x;
+        vec2 p = iMotion.xy + iMotion.zw * t;
+        p -= 2.0 * floor((p + 1.0) * 0.5); // Into [-1, 1), as the store wraps
+        // Image 1 is across the nearer vertical edge, 2 the nearer horizontal one, 3 both
+        int image = gl_InstanceID & 3;
+        vec2 across = vec2(p.x < 0.0 ? 2.0 : -2.0, p.y < 0.0 ? 2.0 : -2.0);
+        p += vec2(float(image & 1), float(image >> 1)) * across;
+        float reach = 1.0 + outlineReach * iSpin.w;
+        if (iSpin.w == 0.0 || abs(p.x) > reach || abs(p.y) > reach) {
+            gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+            return;
+        }
+        float angle = iSpin.y + iSpin.z * t;
+        float c = cos(angle);
+        float s = sin(angle);
+        gl_Position = vec4(mat2(c, s, -s, c) * (aPos * iSpin.w) + p, 0.0, 1.0);
+    }
+)";
+
+// ============================ SETUP ============================
+bool setupResidentRocks(const char* sdfFragmentSource, int sdfUnit, float sdfExtent)
+{
+    rockProgram = buildProgram("resident rocks", rockVertexShaderSource, sdfFragmentSource);
+    if (!rockProgram) {
+        useResidentRocks = false;
+        return false;
+    }
+    bindFrameConstants(rockProgram);
+    glState.useProgram(rockProgram);
+    glUniform1i(glGetUniformLocation(rockProgram, "asteroidSdf"), sdfUnit);
+    glUniform1f(glGetUniformLocation(rockProgram, "sdfExtent"), sdfExtent);
+    glUniform1f(glGetUniformLocation(rockProgram, "outlineReach"), ASTEROID_MAX_OUTLINE_RADIUS);
+
+    // The quad as the SDF pass draws it: a triangle strip covering sdfExtent around the center
+    const float quad[] = { -sdfExtent, -sdfExtent, sdfExtent, -sdfExtent, -sdfExtent, sdfExtent, sdfExtent, sdfExtent };
+    glGenVertexArrays(1, &rockVAO);
+    glGenBuffers(1, &quadBuffer);
+    glGenBuffers(1, &recordBuffer);
+    glState.bindVertexArray(rockVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, quadBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, recordBuffer);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(RockRecord), (void*)offsetof(RockRecord, origin));
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(RockRecord), (void*)offsetof(RockRecord, originTime));
+    glVertexAttribIPointer(3, 2, GL_UNSIGNED_INT, sizeof(RockRecord), (void*)offsetof(RockRecord, paletteIndex));
+    for (GLuint attribute = 1; attribute <= 3; ++attribute) {
+        glVertexAttribDivisor(attribute, RESIDENT_ROCK_IMAGES);
+        glEnableVertexAttribArray(attribute);
+    }
+    glState.bindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return true;
+}
+
+void destroyResidentRocks()
+{
+    for (unsigned int* buffer : { &quadBuffer, &recordBuffer }) {
+        if (*buffer) glDeleteBuffers(1, buffer);
+        *buffer = 0;
+    }
+    if (rockVAO) glDeleteVertexArrays(1, &rockVAO);
+    if (rockProgram) glDeleteProgram(rockProgram);
+    rockVAO = rockProgram = 0;
+    records.clear();
+    sources.clear();
+    dirty.clear();
+    seen.clear();
+}
+
+bool residentRocksReady()
+{
+    return rockProgram != 0;
+}
+
+void collectResidentRockMemory(MemoryReport& report)
+{
+    if (!rockProgram) return;
+    report.add("resident rocks", "records", MEMORY_GPU, glBufferBytes(recordBuffer));
+    report.add("resident rocks", "record mirror", MEMORY_CPU,
+               records.capacity() * sizeof(RockRecord) + sources.capacity() * sizeof(RecordSource) + dirty.capacity() + seen.capacity());
+}
+
+uint64_t residentRockBytesWritten()
+{
+    return bytesWritten;
+}
+
+// (Re)allocates the buffer for `capacity` slots, every one empty
+static void resizeRecords(size_t capacity)
+{
+    records.assign(capacity, { glm::vec2(0.0f), glm::vec2(0.0f), 0.0f, 0.0f, 0.0f, 0.0f, 0, 0 });
+    sources.assign(capacity, { 0, false });
+    dirty.assign(capacity, 1);
+    seen.assign(capacity, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, recordBuffer);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(capacity * sizeof(RockRecord)), NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// ============================ SYNC ============================
+void syncResidentRocks(const AsteroidStore& rocks, bool lazy)
+{
+    if (!rockProgram) return;
+    const size_t capacity = rocks.handles.generation.size();
+    if (records.size() != capacity) resizeRecords(capacity);
+    const double newEpoch = std::floor(rocks.clock / RESIDENT_ROCK_EPOCH_SECONDS) * RESIDENT_ROCK_EPOCH_SECONDS;
+    const bool rebase = newEpoch != epoch;
+    epoch = newEpoch;
+    const float now = static_cast<float>(rocks.clock - epoch);
+    const float turn = glm::two_pi<float>();
+
+    for (size_t i = 0; i < rocks.count(); ++i) {
+        const uint32_t slot = rocks.handles.slotOf[i];
+        RockRecord& record = records[slot];
+        RecordSource& source = sources[slot];
+        seen[slot] = 1;
+        const glm::vec2 position(rocks.x[i], rocks.y[i]);
+        const glm::vec2 velocity(rocks.vx[i], rocks.vy[i]);
+        const float rotation = lazy ? rocks.rotationAt(i, rocks.clock) : rocks.rot[i];
+        const bool fresh = !source.live || source.generation != rocks.handles.generation[slot];
+        const uint32_t shape = static_cast<uint32_t>(rocks.shapeIndex[i]);
+        if (!fresh && !rebase && record.velocity == velocity && record.rotationSpeed == rocks.rotSpeed[i] && record.scale == rocks.scale(i)
+            && record.paletteIndex == rocks.paletteIndex[i] && record.shapeIndex == shape) {
+            const float t = now - record.originTime;
+            glm::vec2 offset = record.origin + record.velocity * t - position;
+            offset -= 2.0f * glm::round(offset * 0.5f); // Through the wrap
+            float spin = record.rotation + record.rotationSpeed * t - rotation;
+            spin -= turn * std::round(spin / turn);
+            if (glm::length(offset) <= RESIDENT_ROCK_RESYNC_DISTANCE && std::abs(spin) <= RESIDENT_ROCK_RESYNC_ANGLE) continue;
+        }
+        record = { position, velocity, now, std::fmod(rotation, turn), rocks.rotSpeed[i], rocks.scale(i),
+                   rocks.paletteIndex[i], shape };
+        source = { rocks.handles.generation[slot], true };
+        dirty[slot] = 1;
+    }
+    // Slots whose rock left play
+    for (size_t slot = 0; slot < capacity; ++slot) {
+        if (seen[slot]) {
+            seen[slot] = 0;
+            continue;
+        }
+        if (!sources[slot].live) continue;
+        sources[slot].live = false;
+        records[slot].scale = 0.0f;
+        dirty[slot] = 1;
+    }
+
+    // Each dirty run is one upload, or one span covers them all when there are many
+    size_t runs = 0, firstDirty = capacity, endDirty = 0;
+    for (size_t j = 0; j < capacity; ++j) {
+        if (!dirty[j]) continue;
+        if (j == 0 || !dirty[j - 1]) ++runs;
+        firstDirty = std::min(firstDirty, j);
+        endDirty = j + 1;
+    }
+    if (runs == 0) return;
+    glBindBuffer(GL_ARRAY_BUFFER, recordBuffer);
+    const auto upload = [](size_t begin, size_t end) {
+        glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(begin * sizeof(RockRecord)),
+                        static_cast<GLsizeiptr>((end - begin) * sizeof(RockRecord)), records.data() + begin);
+        bytesWritten += (end - begin) * sizeof(RockRecord);
+    };
+    if (runs > MAX_UPLOAD_RUNS) upload(firstDirty, endDirty);
+    else {
+        for (size_t j = firstDirty; j < endDirty;) {
+            if (!dirty[j]) {
+                ++j;
+                continue;
+            }
+            size_t end = j;
+            while (end < endDirty && dirty[end]) ++end;
+            upload(j, end);
+            j = end;
+        }
+    }
+    std::fill(dirty.begin() + firstDirty, dirty.begin() + endDirty, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+float residentRockTime(double time)
+{
+    return static_cast<float>(time - epoch);
+}
+
+// ============================ DRAW ============================
+int drawResidentRocks()
+{
+    if (!rockProgram || records.empty()) return 0;
+    glState.useProgram(rockProgram);
+    glState.setEnabled(GL_BLEND, true);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glState.bindVertexArray(rockVAO);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(records.size() * RESIDENT_ROCK_IMAGES));
+    glState.bindVertexArray(0);
+    glState.setEnabled(GL_BLEND, false);
+    return 1;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+struct AsteroidStore;
+struct MemoryReport;
+
+// GPU-resident rocks (--resident-rocks, toggle with J): the batched pass's asteroids drawn from
+// records that stay on the GPU. A rock flies straight at a constant spin between bounces, so one
+// record (a point on its path and when it was there, its velocity, its rotation then and its spin,
+// its scale, palette entry and shape) places it at any time. The records sit in a vertex buffer
+// indexed by the rocks' handle slots, which survive removals and re-sorts, and are rewritten only
+// when a slot's rock changes: it is spawned (a split is two spawns), destroyed, or its motion no
+// longer matches the record (a bounce, a rollback, integration drift). The vertex shader places each
+// rock at FrameConstants::gameTime, wrapped into the field, adds its ghosts across the nearest edges
+// and drops the images that are off screen. Rocks are drawn as SDF quads (one instanced draw for
+// every shape), whatever useSdfAsteroids says. Only for the one-screen field: the arena's view is
+// not a torus, and its rocks keep the streamed instances.
+//
+// Times are seconds since an epoch that moves every RESIDENT_ROCK_EPOCH_SECONDS of game time, so
+// they keep their precision as floats; each move rewrites every record.
+
+// ============================ RESIDENT ROCK STATE ============================
+extern bool useResidentRocks; // Draw the batched pass's rocks from the records (toggle with J)
+const double RESIDENT_ROCK_EPOCH_SECONDS = 256.0;
+// A record is rewritten once its predicted position (field units) or rotation (radians) is this
+// far off the simulated one
+const float RESIDENT_ROCK_RESYNC_DISTANCE = 1e-4f;
+const float RESIDENT_ROCK_RESYNC_ANGLE = 1e-3f;
+
+// ============================ RESIDENT ROCK API ============================
+// Builds the program from its vertex shader and the SDF asteroid fragment shader, reading the SDF
+// array from texture unit `sdfUnit`; false if it fails. The buffer is sized by the first sync.
+bool setupResidentRocks(const char* sdfFragmentSource, int sdfUnit, float sdfExtent);
+void destroyResidentRocks();
+bool residentRocksReady(); // Set up, so useResidentRocks may be turned on
+void collectResidentRockMemory(MemoryReport& report); // Nothing unless set up
+uint64_t residentRockBytesWritten(); // Record bytes uploaded so far
+
+// Rewrites the records of the slots whose rock changed since the last sync (all of them when the
+// store's capacity or the epoch changed). `lazy`: the store's rotations live in its anchors
+// (GameWorld::lazyAsteroidMotion).
+void syncResidentRocks(const AsteroidStore& rocks, bool lazy);
+// FrameConstants::gameTime for drawing the rocks at game time `time`
+float residentRockTime(double time);
+// Draws every record and its wrap ghosts as blended SDF quads. Returns the draw calls issued.
+int drawResidentRocks();
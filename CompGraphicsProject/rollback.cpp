@@ -0,0 +1,93 @@
+#include "rollback.h"
+#include "snapshot.h"
+
+#include <algorithm>
+#include <chrono>
+
+const int SNAPSHOT_RING = ROLLBACK_MAX_TICKS + 1;
+
+void startRollbackSession(RollbackSession& session, GameWorld& world, int localPlayer) {
+    session.world = &world;
+    session.localPlayer = localPlayer;
+    session.tick = 0;
+    std::fill(std::begin(session.confirmed), std::end(session.confirmed), 0);
+    for (uint8_t* row : session.inputs) std::fill(row, row + ROLLBACK_PLAYERS, 0);
+    session.correctFrom = UINT64_MAX;
+    const size_t capacity = worldSnapshotBytes(world.limits);
+    for (int k = 0; k < SNAPSHOT_RING; ++k) {
+        session.snapshots[k].resize(capacity);
+        session.snapshotBytes[k] = 0;
+    }
+    session.stats = RollbackStats();
+}
+
+// Known, or else the player's last known input held (nothing pressed before any is known)
+static uint8_t inputFor(const RollbackSession& session, int player, uint64_t tick) {
+    if (tick < session.confirmed[player]) return session.inputs[tick % ROLLBACK_INPUT_RING][player];
+    if (session.confirmed[player] == 0) return 0;
+    return session.inputs[(session.confirmed[player] - 1) % ROLLBACK_INPUT_RING][player];
+}
+
+// Saves the start of the current tick, then steps it with every player's input (predicting the unknown)
+static void stepTick(RollbackSession& session) {
+    const uint64_t tick = session.tick;
+    const int slot = static_cast<int>(tick % SNAPSHOT_RING);
+    session.snapshotBytes[slot] = saveWorldSnapshot(*session.world, session.snapshots[slot].data(), session.snapshots[slot].size());
+    uint8_t* inputs = session.inputs[tick % ROLLBACK_INPUT_RING];
+    InputState keys[ROLLBACK_PLAYERS];
+    for (int p = 0; p < ROLLBACK_PLAYERS; ++p) {
+        inputs[p] = inputFor(session, p, tick);
+        keys[p] = unpackInput(inputs[p]);
+    }
+    session.world->step(SIM_DT, keys, ROLLBACK_PLAYERS);
+    ++session.tick;
+}
+
+bool addRollbackInput(RollbackSession& session, int player, uint64_t tick, uint8_t input) {
+    if (player < 0 || player >= ROLLBACK_PLAYERS || player == session.localPlayer) return false;
+    if (tick != session.confirmed[player]) return false; // Seen already, or a gap (the sender repeats it)
+    if (tick >= session.tick + ROLLBACK_INPUT_RING - ROLLBACK_MAX_TICKS) return false; // Further ahead than the ring keeps
+    uint8_t& stored = session.inputs[tick % ROLLBACK_INPUT_RING][player];
+    // A tick already stepped ran on a prediction: if it was wrong, it and everything after it runs again
+    if (tick < session.tick && stored != input) session.correctFrom = std::min(session.correctFrom, tick);
+    stored = input;
+    session.confirmed[player] = tick + 1;
+    return true;
+}
+
+void resimulateRollback(RollbackSession& session, uint64_t from) {
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const int slot = static_cast<int>(from % SNAPSHOT_RING);
+    restoreWorldSnapshot(*session.world, session.snapshots[slot].data(), session.snapshotBytes[slot]);
+    const uint64_t target = session.tick;
+    session.tick = from;
+    while (session.tick < target) stepTick(session);
+    const int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+    RollbackStats& stats = session.stats;
+    ++stats.rollbacks;
+    stats.resimulatedTicks += target - from;
+    stats.deepestRollback = std::max(stats.deepestRollback, static_cast<int>(target - from));
+    stats.worstRollbackNs = std::max(stats.worstRollbackNs, ns);
+}
+
+bool advanceRollback(RollbackSession& session, uint8_t localInput) {
+    if (session.correctFrom != UINT64_MAX) {
+        resimulateRollback(session, session.correctFrom);
+        session.correctFrom = UINT64_MAX;
+    }
+    bool predicted = false;
+    for (int p = 0; p < ROLLBACK_PLAYERS; ++p) {
+        if (p == session.localPlayer) continue;
+        if (session.confirmed[p] + ROLLBACK_MAX_TICKS <= session.tick) {
+            ++session.stats.stalls;
+            return false;
+        }
+        predicted = predicted || session.confirmed[p] <= session.tick;
+    }
+    session.inputs[session.tick % ROLLBACK_INPUT_RING][session.localPlayer] = localInput;
+    session.confirmed[session.localPlayer] = session.tick + 1;
+    if (predicted) ++session.stats.predictedTicks;
+    stepTick(session);
+    return true;
+}
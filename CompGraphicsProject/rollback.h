@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "simulation.h"
+
+// Rollback session for peer-to-peer play, in the manner of GGPO. Every peer runs the whole game and
+// only inputs travel. A peer never waits for its partner's input: a tick whose remote input has not
+// arrived is stepped with a prediction (the partner keeps holding the keys it last sent), and the
+// world is saved (snapshot.h) before every tick. When the real input arrives and differs from the
+// prediction, the world is restored to the start of that tick and every tick since is stepped again
+// with what is now known, within the same frame. A peer more than ROLLBACK_MAX_TICKS ahead of the
+// input it has confirmed stalls instead (advanceRollback returns false) until its partner catches up.
+// Worst case, then, a frame restores once and resimulates ROLLBACK_MAX_TICKS ticks; benchmark
+// --rollback measures that against the frame.
+// Player p flies ship p, so the world should be init'ed with ROLLBACK_PLAYERS ships
+// (SimulationLimits::ships; with fewer, the extra players' input goes nowhere). The transport is the
+// caller's: it sends each local input to the partner (repeating the unacknowledged ones, as inputs
+// must arrive in order) and hands what arrives to addRollbackInput.
+// Resimulated ticks raise their events again, so the world should not be instrumented, and the
+// stress scenarios' top-ups (drawn outside the world) make a world unsuitable for rollback.
+// Like simulation.h, nothing here depends on GL.
+
+// ============================ SESSION ============================
+const int ROLLBACK_MAX_TICKS = 8; // Furthest a correction reaches back (66 ms at 120 ticks)
+const int ROLLBACK_PLAYERS = 2;
+const int ROLLBACK_INPUT_RING = 32; // Ticks of input kept; more than the window either peer can be ahead
+
+struct RollbackStats {
+    uint64_t predictedTicks = 0; // Ticks stepped with a remote input not yet known
+    uint64_t rollbacks = 0; // Predictions that turned out wrong (each one restore and resimulation)
+    uint64_t resimulatedTicks = 0;
+    uint64_t stalls = 0; // advanceRollback calls that waited for the partner
+    int deepestRollback = 0; // Ticks
+    int64_t worstRollbackNs = 0; // Restore and resimulation
+};
+
+struct RollbackSession {
+    GameWorld* world = nullptr;
+    int localPlayer = 0;
+    uint64_t tick = 0; // Ticks the world has run: it stands at the start of this one
+    uint64_t confirmed[ROLLBACK_PLAYERS] = {}; // Each player's input is known for the ticks before this
+    uint8_t inputs[ROLLBACK_INPUT_RING][ROLLBACK_PLAYERS] = {}; // By tick: known, or what was predicted
+    uint64_t correctFrom = UINT64_MAX; // Earliest tick stepped with a wrong prediction (UINT64_MAX: none)
+    std::vector<unsigned char> snapshots[ROLLBACK_MAX_TICKS + 1]; // The world at the start of tick t, in slot t % size
+    size_t snapshotBytes[ROLLBACK_MAX_TICKS + 1] = {};
+    RollbackStats stats;
+};
+
+// ============================ SESSION API ============================
+// Starts at the world's current state (tick 0), with the snapshot buffers sized once for its limits
+void startRollbackSession(RollbackSession& session, GameWorld& world, int localPlayer);
+
+// A remote player's input for `tick`, in order: a duplicate or one out of order is ignored (false)
+bool addRollbackInput(RollbackSession& session, int player, uint64_t tick, uint8_t input);
+
+// One tick with the local player's input: first corrects any wrong prediction, then steps. False,
+// with nothing stepped or recorded, while the partner's input lags ROLLBACK_MAX_TICKS behind.
+bool advanceRollback(RollbackSession& session, uint8_t localInput);
+
+// Restores the start of `from` (within the last ROLLBACK_MAX_TICKS) and steps back up to the
+// current tick with the inputs known now; advanceRollback calls it, the benchmark times it
+void resimulateRollback(RollbackSession& session, uint64_t from);
@@ -0,0 +1,195 @@
+#include "scenario.h"
+#include "random.h"
+#include "log.h"
+#include "replay.h"
+#include "profiler.h"
+#include "bots.h"
+#include "loadshed.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+#include <glm/gtc/constants.hpp>
+
+bool scenarioActive = false;
+Scenario activeScenario;
+long long scenarioTicks = 0;
+
+static Rng scenarioRng;
+
+// ============================ SCENARIOS ============================
+static const char* const SCENARIO_PRESETS[] = {
+    "1k", "1k-shield", "1k-bullets", "1k-bounce",
+    "10k", "10k-shield", "10k-bullets", "10k-bounce",
+    "100k", "100k-shield", "100k-bullets", "100k-bounce",
+};
+static const int SCENARIO_PRESET_COUNT = static_cast<int>(sizeof(SCENARIO_PRESETS) / sizeof(SCENARIO_PRESETS[0]));
+
+const char* const* scenarioPresetNames(int& count) {
+    count = SCENARIO_PRESET_COUNT;
+    return SCENARIO_PRESETS;
+}
+
+bool findScenario(const std::string& name, Scenario& scenario) {
+    size_t dash = name.find('-');
+    std::string count = name.substr(0, dash);
+    std::string variant = dash == std::string::npos ? "" : name.substr(dash + 1);
+
+    Scenario result;
+    result.name = name;
+    if (count == "1k") result.asteroids = 1000;
+    else if (count == "10k") result.asteroids = 10000;
+    else if (count == "100k") result.asteroids = 100000;
+    else return false;
+
+    if (variant == "shield") result.shield = true;
+    else if (variant == "bullets") result.bullets = 1000;
+    else if (variant == "bounce") result.bounce = true;
+    else if (!variant.empty()) return false;
+
+    scenario = result;
+    return true;
+}
+
+void applyScenario(const Scenario& scenario) {
+    activeScenario = scenario;
+    scenarioActive = true;
+    scenarioTicks = 0;
+    world.scenarioDriven = true;
+    world.asteroidCollisions = scenario.bounce;
+    simulationLimits.maxAsteroids = std::max(scenario.asteroids, MAX_ASTEROIDS);
+    simulationLimits.maxBullets = MAX_BULLETS + scenario.bullets;
+    scenarioRng.seed(simulationSeed, RNG_STREAM_SCENARIO);
+    LOG_INFO("Scenario %s: %d asteroids, %d bullets, shield %s, auto-fire %s, rock collisions %s", scenario.name.c_str(),
+             scenario.asteroids, scenario.bullets, scenario.shield ? "on" : "off", scenario.autoFire ? "on" : "off",
+             scenario.bounce ? "on" : "off");
+}
+
+void reseedScenario(uint64_t seed) {
+    scenarioRng.seed(seed, RNG_STREAM_SCENARIO);
+}
+
+// ============================ TICK HOOKS ============================
+void maintainScenario(GameWorld& target) {
+    ++scenarioTicks;
+    target.isGameOver = false;
+
+    // Anywhere in the field, not just the edges, so the whole grid is loaded from the first tick. Under
+    // load shedding (loadshed.h) the field fills only as far as the cap admits.
+    while (target.liveAsteroidCount() < std::min(static_cast<size_t>(activeScenario.asteroids), target.asteroidAdmission())) {
+        glm::vec2 position(scenarioRng.range(-1.0f, 1.0f), scenarioRng.range(-1.0f, 1.0f));
+        if (position == glm::vec2(0.0f)) continue; // (0, 0) means "spawn at the edge" to spawnNewAsteroid
+        target.spawnNewAsteroid(position, LARGE);
+    }
+
+    // Scenario bullets fly in random directions at bullet speed; the ship's own come on top. The
+    // first fill is staggered, so they do not all expire at once, in rising lifetimes (the bullet
+    // ring expires in firing order); replacements live the full lifetime, behind all of them.
+    const size_t firstFill = target.bullets.liveCount() == 0 ? static_cast<size_t>(activeScenario.bullets) : 0;
+    for (size_t k = 0; target.bullets.liveCount() < static_cast<size_t>(activeScenario.bullets); ++k) {
+        Bullet bullet;
+        bullet.position = glm::vec2(scenarioRng.range(-1.0f, 1.0f), scenarioRng.range(-1.0f, 1.0f));
+        float angle = scenarioRng.uniform() * 2.0f * glm::pi<float>();
+        bullet.velocity = target.heading(angle) * BULLET_SPEED;
+        if (k < firstFill) bullet.lifetime = 0.1f + (BULLET_LIFETIME - 0.1f) * static_cast<float>(k + 1) / static_cast<float>(firstFill);
+        if (target.bullets.push(bullet).slot == INVALID_ENTITY_HANDLE.slot) break; // Pool full
+    }
+
+    if (activeScenario.shield) {
+        ShipStore& ships = target.ships;
+        std::fill(ships.shieldActive.begin(), ships.shieldActive.end(), 1);
+        // Its end keeps moving, so no timer (scheduled or left from a raise by hand) ever matches it
+        std::fill(ships.shieldEndTick.begin(), ships.shieldEndTick.end(), target.tick + ticksFor(SHIELD_DURATION));
+        std::fill(ships.shieldReadyTick.begin(), ships.shieldReadyTick.end(), 0);
+    }
+}
+
+InputState scenarioInput(const InputState& input) {
+    InputState result = input;
+    if (activeScenario.autoFire) result.fire = true;
+    return result;
+}
+
+// ============================ HEADLESS RUN ============================
+std::string runScenarioHeadless(long long ticks) {
+    typedef std::chrono::steady_clock Clock;
+    std::vector<double> tickMs;
+    tickMs.reserve(static_cast<size_t>(ticks));
+    InputState input;
+    input.left = true; // Spin, so auto-fire sprays the whole field
+    std::vector<InputState> inputs(world.ships.count(), input); // Every ship alike, unless bots fly the rest
+    const bool botShips = botCount > 0 && inputs.size() > 1;
+    double thinkSeconds = 0.0;
+
+    Clock::time_point start = Clock::now();
+    for (long long tick = 0; tick < ticks; ++tick) {
+        Clock::time_point tickStart = Clock::now();
+        if (botShips) {
+            bots.think(world, 1, inputs.data());
+            thinkSeconds += std::chrono::duration<double>(Clock::now() - tickStart).count();
+        }
+        applyLoadShedding(world);
+        world.step(SIM_DT, inputs.data(), inputs.size());
+        tickMs.push_back(std::chrono::duration<double, std::milli>(Clock::now() - tickStart).count());
+        profilerEndFrame();
+        updateLoadShedding(static_cast<size_t>(world.limits.maxAsteroids), world.liveAsteroidCount());
+    }
+    reportLoadShedding(world);
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    if (botShips) {
+        LOG_INFO("[bots] %zu bots: %.3f ms per tick thinking, %zu still flying", inputs.size() - 1, ticks > 0 ? 1000.0 * thinkSeconds / ticks : 0.0,
+                 world.ships.aliveCount() - world.ships.alive[0]);
+    }
+    MemoryReport memory;
+    world.collectMemory(memory);
+    if (botShips) memory.add("bots", "controller", MEMORY_CPU, bots.memoryBytes());
+    collectReplayMemory(memory);
+    return scenarioResultJson("headless", seconds > 0.0 ? ticks / seconds : 0.0, percentile(tickMs, 0.5), percentile(tickMs, 0.99), 0.0, 0.0, memory);
+}
+
+// ============================ RESULTS ============================
+double percentile(std::vector<double> samples, double fraction) {
+    if (samples.empty()) return 0.0;
+    size_t rank = static_cast<size_t>(fraction * (samples.size() - 1) + 0.5);
+    std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+    return samples[rank];
+}
+
+std::string scenarioResultJson(const char* mode, double ticksPerSecond, double frameP50Ms, double frameP99Ms,
+                               double drawCallsPerFrame, double bytesUploadedPerFrame, const MemoryReport& memory) {
+    double collisionMs = 0.0;
+    for (ProfilePhase phase : { PHASE_BROADPHASE, PHASE_ASTEROID_COLLISION, PHASE_SHIP_COLLISION, PHASE_BULLET_COLLISION }) {
+        collisionMs += profilerPhaseStats(phase).average;
+    }
+    const double pairs = profilerCounterStats(COUNTER_BULLET_PAIRS).average;
+    const double pairHitRatio = pairs > 0.0 ? profilerCounterStats(COUNTER_BULLET_PAIR_HITS).average / pairs : 0.0;
+    char line[768];
+    std::snprintf(line, sizeof(line),
+                  "{\"scenario\":\"%s\",\"mode\":\"%s\",\"broadphase\":\"%s\",\"bullet_hits\":\"%s\",\"rock_motion\":\"%s\",\"kinematics\":\"%s\",\"hit_shape\":\"%s\",\"rock_order\":\"%s\",\"asteroids\":%d,\"bullets\":%d,\"shield\":%s,\"auto_fire\":%s,"
+                  "\"ticks_per_s\":%.1f,\"frame_p50_ms\":%.3f,\"frame_p99_ms\":%.3f,\"collision_ms\":%.3f,\"draw_calls\":%.1f,\"bytes_uploaded\":%.0f,\"rocks_shed\":%llu,\"bullet_pairs\":%.1f,\"pair_hit_ratio\":%.4f}",
+                  activeScenario.name.c_str(), mode, broadphaseName(world.asteroidBroadphase),
+                  world.kineticBulletHits ? "kinetic" : world.pairBatchedHits ? "pairs" : "search", world.lazyAsteroidMotion ? "lazy" : "integrated", world.fixedPointKinematics ? "fixed" : "float",
+                  world.silhouetteHits ? "outline" : "circle", world.spatialSortAsteroids ? "morton" : "store", activeScenario.asteroids, activeScenario.bullets,
+                  activeScenario.shield ? "true" : "false", activeScenario.autoFire ? "true" : "false",
+                  ticksPerSecond, frameP50Ms, frameP99Ms, collisionMs, drawCallsPerFrame, bytesUploadedPerFrame,
+                  static_cast<unsigned long long>(world.shedSpawns + world.shedChildren), pairs, pairHitRatio);
+    std::string json = line;
+    json.pop_back(); // The closing brace, reopened for the memory field
+    return json + ",\"memory\":" + memory.json() + "}";
+}
+
+void writeScenarioResult(const char* path, const std::string& json) {
+    if (!path) {
+        LOG_INFO("%s", json.c_str());
+        return;
+    }
+    FILE* file = std::fopen(path, "a");
+    if (!file) {
+        LOG_ERROR("Could not open %s for the scenario results", path);
+        return;
+    }
+    std::fprintf(file, "%s\n", json.c_str());
+    std::fclose(file);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "simulation.h"
+#include "memreport.h"
+
+// Scripted stress scenarios for measuring how the engine scales far past the game's own limits.
+// A scenario raises the simulation limits and then, before every tick, tops the asteroid and
+// bullet counts back up to its targets, so the load stays constant for the whole run.
+// Like simulation.h, nothing here depends on GL.
+
+// ============================ SCENARIOS ============================
+struct Scenario {
+    std::string name;
+    int asteroids = 1000; // Live rocks kept in the field (large ones; splits fill in the rest)
+    int bullets = 0; // Live bullets kept in flight, on top of the ship's own
+    bool shield = false; // Shield held up permanently (re-raised every tick)
+    bool autoFire = true; // Fire held every tick
+    bool bounce = false; // Rocks collide with each other (GameWorld::asteroidCollisions)
+};
+
+extern bool scenarioActive; // Set by applyScenario, which also marks the game's world as scenarioDriven
+extern Scenario activeScenario;
+extern long long scenarioTicks; // Ticks run since applyScenario (read it once the simulating thread has stopped)
+
+// Presets: "1k", "10k", "100k" asteroids, each also as "-shield", "-bullets" (1000 bullets) and "-bounce"
+bool findScenario(const std::string& name, Scenario& scenario);
+const char* const* scenarioPresetNames(int& count);
+
+// Raises simulationLimits for the scenario; call before world.init
+void applyScenario(const Scenario& scenario);
+// Restarts the top-ups' random stream (applyScenario seeds it from simulationSeed), so ticks run again
+// from a restored snapshot top up alike
+void reseedScenario(uint64_t seed);
+
+// ============================ TICK HOOKS (called by GameWorld::step) ============================
+// Tops the counts up, re-raises the shields and clears the game over (a scenario never ends)
+void maintainScenario(GameWorld& target);
+InputState scenarioInput(const InputState& input);
+
+// ============================ HEADLESS RUN ============================
+// Runs the active scenario on the game's world for `ticks` ticks with no window (it must be initialized) and
+// returns its result line; frame percentiles are per tick, and each tick closes a profiler frame. With
+// botCount set, ship 0 alone spins and fires and `bots` flies the rest (bots.h; it must be initialized).
+std::string runScenarioHeadless(long long ticks);
+
+// ============================ RESULTS ============================
+// One JSON object per line, so runs can be appended to a file and diffed over time
+double percentile(std::vector<double> samples, double fraction); // fraction in [0, 1]
+// `memory` goes in as the "memory" field: CPU and GPU bytes per subsystem at the end of the run.
+// "collision_ms" is the broadphase and collision phases' mean per profiler frame over its rolling window.
+// "bullet_pairs" is the same mean of the pair-batched search's candidate pairs (--pair-batch; 0 without),
+// "pair_hit_ratio" the share of them that hit.
+std::string scenarioResultJson(const char* mode, double ticksPerSecond, double frameP50Ms, double frameP99Ms,
+                               double drawCallsPerFrame, double bytesUploadedPerFrame, const MemoryReport& memory);
+void writeScenarioResult(const char* path, const std::string& json); // NULL path: the log
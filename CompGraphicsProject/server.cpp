@@ -0,0 +1,929 @@
+#include "server.h"
+#include "alloctrack.h"
+#include "checkpoint.h"
+#include "entitymemory.h"
+#include "log.h"
+#include "replication.h"
+#include "snapshot.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <windows.h>
+#pragma comment(lib, "ws2_32.lib")
+typedef SOCKET ServerSocket;
+typedef int SocketLength;
+static const ServerSocket NO_SOCKET = INVALID_SOCKET;
+static void closeSocket(ServerSocket s) { closesocket(s); }
+static void setReceiveTimeout(ServerSocket s, int ms) {
+    DWORD timeout = static_cast<DWORD>(ms);
+    setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+}
+static void pinToCore(std::thread& thread, int core) {
+    if (core < 64) SetThreadAffinityMask(thread.native_handle(), DWORD_PTR(1) << core);
+}
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+typedef int ServerSocket;
+typedef socklen_t SocketLength;
+static const ServerSocket NO_SOCKET = -1;
+static void closeSocket(ServerSocket s) { close(s); }
+static void setReceiveTimeout(ServerSocket s, int ms) {
+    timeval timeout = { ms / 1000, (ms % 1000) * 1000 };
+    setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+}
+static void pinToCore(std::thread& thread, int core) {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core, &set);
+    pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#else
+    (void)thread; (void)core; // No affinity API: the scheduler places the threads
+#endif
+}
+#endif
+
+typedef std::chrono::steady_clock Clock;
+
+const int RECEIVE_TIMEOUT_MS = 100; // How long the network thread waits before checking for a stop
+const int TIMEOUT_SWEEP_TICKS = 60; // Ticks between a thread's checks for silent clients
+const int64_t TICK_NS = static_cast<int64_t>(1e9 / SIM_TICK_RATE);
+
+// ============================ TICK LATENCY ============================
+// Counts by bucket, 4 buckets per doubling of (1 + microseconds); the last is open-ended. Added to by
+// the stepping thread, taken (and zeroed) by a report, so neither side ever waits.
+struct LatencyHistogram {
+    std::atomic<uint32_t> counts[SERVER_LATENCY_BUCKETS] = {};
+
+    void add(int64_t ns) {
+        const uint64_t v = static_cast<uint64_t>(std::max<int64_t>(ns / 1000, 0)) + 1;
+        const int octave = static_cast<int>(std::bit_width(v)) - 1;
+        const int quarter = static_cast<int>((octave >= 2 ? v >> (octave - 2) : v << (2 - octave)) & 3u);
+        counts[std::min(4 * octave + quarter, SERVER_LATENCY_BUCKETS - 1)].fetch_add(1, std::memory_order_relaxed);
+    }
+    void take(uint32_t* into) {
+        for (int b = 0; b < SERVER_LATENCY_BUCKETS; ++b) into[b] = counts[b].exchange(0, std::memory_order_relaxed);
+    }
+};
+
+// The upper edge of the bucket holding the `fraction` quantile, in microseconds (0 with no samples)
+static double latencyPercentileUs(const uint32_t* counts, double fraction) {
+    uint64_t total = 0;
+    for (int b = 0; b < SERVER_LATENCY_BUCKETS; ++b) total += counts[b];
+    if (total == 0) return 0.0;
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(total))));
+    uint64_t seen = 0;
+    int b = 0;
+    while (b < SERVER_LATENCY_BUCKETS - 1 && (seen += counts[b]) < rank) ++b;
+    return std::ldexp(5.0 + b % 4, b / 4) / 4.0 - 1.0;
+}
+
+// ============================ MATCHES ============================
+struct ServerClient {
+    sockaddr_storage address;
+    SocketLength addressLength = 0;
+    uint32_t sequence = 0;
+    Clock::time_point lastHeard;
+    ReplicationSender replication; // Written by the match's thread, acknowledged by the network thread
+};
+
+struct Match {
+    uint32_t id = 0;
+    GameWorld world; // Built by the first thread to adopt it, so its memory is on that thread's node
+    bool built = false;
+    uint64_t ticks = 0; // The match's thread only
+    // Shared with the network thread
+    std::mutex clientMutex;
+    std::vector<ServerClient> clients; // [0] flies the ship
+    std::atomic<uint8_t> input{ 0 }; // The player's latest packed input
+    // Tick cost (the step and the snapshot sends), written by the match's thread
+    std::atomic<int64_t> meanNs{ 0 }; // Running mean over the last few dozen ticks
+    // Scheduling, written by the thread stepping it (the one it is handed to, after a migration)
+    std::atomic<int> core{ 0 }; // That thread's index
+    std::atomic<float> speed{ 1.0f }; // Share of the thread's ticks it steps on (below 1: dilated)
+    float credit = 0.0f; // Ticks it is owed at its speed
+    LatencyHistogram latency; // Since the last match report
+    // Checkpoints: saved by the thread stepping it, written by the checkpoint thread
+    std::vector<unsigned char> checkpointBuffers[2]; // Sized when the world is built
+    std::atomic<bool> checkpointBusy[2] = {}; // Saved and queued, not yet written
+    int untilCheckpoint = 0; // Ticks to its next checkpoint, the thread stepping it only
+    std::atomic<bool> ended{ false }; // Closed: its checkpoints are dropped and its file removed
+    std::vector<unsigned char> resume; // A checkpoint's snapshot, restored when the world is built (empty: a new game)
+    Clock::time_point waitUntil; // Resumed: kept open without clients until then
+};
+
+struct ServerCore {
+    int index = 0;
+    int node = 0; // NUMA node of the core it is pinned to
+    std::thread thread;
+    std::mutex incomingMutex;
+    std::vector<std::shared_ptr<Match>> incoming; // Placed here, not adopted yet
+    std::vector<std::shared_ptr<Match>> matches; // Its own thread only
+    std::atomic<int64_t> loadNs{ 0 }; // Summed mean tick costs of its matches, the incoming included
+    std::atomic<int> matchCount{ 0 };
+    // Replication scratch, its own thread only (sized once)
+    SpatialGrid interestGrid;
+    std::vector<ReplicatedEntity> entities;
+    std::vector<unsigned char> packet; // Header and replication snapshot
+    // Since the last report (exchanged to zero by it)
+    std::atomic<int64_t> busyNs{ 0 };
+    std::atomic<int64_t> ticks{ 0 };
+    std::atomic<int64_t> overruns{ 0 };
+    std::atomic<int64_t> worstStepNs{ 0 };
+    std::atomic<uint32_t> heaviestMatch{ 0 };
+    std::atomic<int64_t> heaviestNs{ 0 };
+    std::atomic<int64_t> replicatedBytes{ 0 }, snapshots{ 0 }, deltaSnapshots{ 0 };
+    std::atomic<int64_t> entitiesSent{ 0 }, entitiesInWorld{ 0 }; // Per snapshot sent: in the client's interest, and in the whole world
+    std::atomic<int64_t> peakClientBytes{ 0 }; // The largest client's mean snapshot
+    LatencyHistogram latency; // Every tick of its matches
+    // Its own thread's view, stored every tick
+    std::atomic<int> slowedMatches{ 0 };
+    std::atomic<float> slowestSpeed{ 1.0f };
+    int untilRebalance = SERVER_REBALANCE_TICKS; // Its own thread only
+};
+
+static ServerConfig serverConfig;
+static ServerSocket serverSocket = NO_SOCKET;
+static std::atomic<bool> serverRunning{ false };
+static std::thread networkThread;
+static std::vector<std::unique_ptr<ServerCore>> cores;
+static int numaNodes = 1; // Nodes the threads are spread over (1: placement ignores them)
+
+static std::mutex matchMutex; // Guards the index and the match id counter
+static std::unordered_map<uint32_t, std::shared_ptr<Match>> matchIndex;
+static uint32_t nextMatchId = 1;
+
+// Since the last report
+static std::atomic<int64_t> packetsIn{ 0 }, packetsOut{ 0 }, bytesOut{ 0 };
+static std::atomic<int64_t> matchesOpened{ 0 }, matchesClosed{ 0 }, joinsRefused{ 0 };
+static std::atomic<int64_t> migrations{ 0 }, slowdowns{ 0 }, speedups{ 0 };
+static std::atomic<int64_t> checkpointsSaved{ 0 }, checkpointsSkipped{ 0 }, checkpointSaveNs{ 0 };
+static std::atomic<int64_t> checkpointsWritten{ 0 }, checkpointBytes{ 0 }, checkpointPackedBytes{ 0 }, checkpointWriteNs{ 0 };
+static Clock::time_point lastReport;
+
+static void sendHeader(const sockaddr_storage& address, SocketLength length, ServerPacketType type, uint32_t match, bool player) {
+    ServerPacketHeader header = {};
+    header.magic = SERVER_PROTOCOL_MAGIC;
+    header.version = SERVER_PROTOCOL_VERSION;
+    header.type = type;
+    header.player = player ? 1 : 0;
+    header.match = match;
+    if (sendto(serverSocket, reinterpret_cast<const char*>(&header), sizeof(header), 0, reinterpret_cast<const sockaddr*>(&address), length) >= 0) {
+        packetsOut.fetch_add(1, std::memory_order_relaxed);
+        bytesOut.fetch_add(sizeof(header), std::memory_order_relaxed);
+    }
+}
+
+static bool sameAddress(const ServerClient& client, const sockaddr_storage& address, SocketLength length) {
+    return client.addressLength == length && std::memcmp(&client.address, &address, static_cast<size_t>(length)) == 0;
+}
+
+// ============================ CHECKPOINTS ============================
+struct CheckpointJob {
+    std::shared_ptr<Match> match;
+    int buffer = -1; // -1: the match ended, remove its file
+    size_t bytes = 0;
+    uint64_t ticks = 0;
+};
+
+static std::thread checkpointThread;
+static std::mutex checkpointMutex;
+static std::condition_variable checkpointSignal;
+static std::deque<CheckpointJob> checkpointQueue;
+static bool checkpointStopping = false;
+
+static void queueCheckpointJob(CheckpointJob&& job) {
+    {
+        std::lock_guard<std::mutex> lock(checkpointMutex);
+        checkpointQueue.push_back(std::move(job));
+    }
+    checkpointSignal.notify_one();
+}
+
+// Between two of the match's ticks, on the thread stepping it: the world into a free buffer, handed
+// to the checkpoint thread. The snapshot's copy is the whole pause.
+static void saveCheckpoint(const std::shared_ptr<Match>& match) {
+    int buffer = 0;
+    while (buffer < 2 && match->checkpointBusy[buffer].load(std::memory_order_acquire)) ++buffer;
+    if (buffer == 2) { // Both still queued: the disk is behind, so this one is left out
+        checkpointsSkipped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    std::vector<unsigned char>& snapshot = match->checkpointBuffers[buffer];
+    const Clock::time_point start = Clock::now();
+    const size_t bytes = saveWorldSnapshot(match->world, snapshot.data(), snapshot.size());
+    checkpointSaveNs.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count(), std::memory_order_relaxed);
+    if (bytes == 0) return;
+    match->checkpointBusy[buffer].store(true, std::memory_order_relaxed);
+    CheckpointJob job;
+    job.match = match;
+    job.buffer = buffer;
+    job.bytes = bytes;
+    job.ticks = match->ticks;
+    queueCheckpointJob(std::move(job));
+    checkpointsSaved.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Packs and writes the queued checkpoints in order, so an ended match's removal comes after any
+// of its checkpoints still queued
+static void checkpointLoop() {
+    AllowAllocations writer; // Its own thread: the packing scratch grows with the snapshots
+    nameTraceThread("checkpoint");
+    std::vector<unsigned char> scratch;
+    for (;;) {
+        CheckpointJob job;
+        {
+            std::unique_lock<std::mutex> lock(checkpointMutex);
+            checkpointSignal.wait(lock, [] { return checkpointStopping || !checkpointQueue.empty(); });
+            if (checkpointQueue.empty()) break;
+            job = std::move(checkpointQueue.front());
+            checkpointQueue.pop_front();
+        }
+        if (job.buffer < 0) {
+            removeCheckpointFile(serverConfig.checkpointDir, job.match->id);
+            continue;
+        }
+        if (!job.match->ended.load(std::memory_order_acquire)) {
+            const Clock::time_point start = Clock::now();
+            if (writeCheckpointFile(serverConfig.checkpointDir, job.match->id, job.ticks, job.match->checkpointBuffers[job.buffer].data(),
+                                    job.bytes, scratch)) {
+                checkpointsWritten.fetch_add(1, std::memory_order_relaxed);
+                checkpointBytes.fetch_add(static_cast<int64_t>(job.bytes), std::memory_order_relaxed);
+                checkpointPackedBytes.fetch_add(static_cast<int64_t>(scratch.size() - sizeof(CheckpointHeader)), std::memory_order_relaxed);
+                checkpointWriteNs.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count(), std::memory_order_relaxed);
+            }
+        }
+        job.match->checkpointBusy[job.buffer].store(false, std::memory_order_release);
+    }
+}
+
+// ============================ PLACEMENT ============================
+// Into the index and onto `core`'s incoming list, costed at `estimateNs` (matchMutex held)
+static void placeMatch(const std::shared_ptr<Match>& match, ServerCore& core, int64_t estimateNs) {
+    match->world.instrumented = false; // No logger or profiler traffic from the match threads
+    match->world.fixedPointKinematics = serverConfig.fixedPoint;
+    match->meanNs.store(estimateNs, std::memory_order_relaxed);
+    match->core.store(core.index, std::memory_order_relaxed);
+    matchIndex[match->id] = match;
+    core.matchCount.fetch_add(1, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> incomingLock(core.incomingMutex); // Taken by the thread's load update too
+    core.incoming.push_back(match);
+    core.loadNs.fetch_add(estimateNs, std::memory_order_relaxed);
+}
+
+// A new match on the least loaded thread, costed at the mean of the running ones; null when the
+// server is at its match limit or no thread has room under the budget
+static std::shared_ptr<Match> openMatch() {
+    std::lock_guard<std::mutex> lock(matchMutex);
+    if (matchIndex.size() >= static_cast<size_t>(serverConfig.maxMatches)) return nullptr;
+    int64_t totalNs = 0, placed = 0;
+    ServerCore* best = nullptr;
+    for (const std::unique_ptr<ServerCore>& core : cores) {
+        totalNs += core->loadNs.load(std::memory_order_relaxed);
+        placed += core->matchCount.load(std::memory_order_relaxed);
+        if (!best || core->loadNs.load(std::memory_order_relaxed) < best->loadNs.load(std::memory_order_relaxed)) best = core.get();
+    }
+    const int64_t estimateNs = placed > 0 ? totalNs / placed : static_cast<int64_t>(SERVER_NEW_MATCH_COST_US * 1000.0);
+    if (best->loadNs.load(std::memory_order_relaxed) + estimateNs > static_cast<int64_t>(SERVER_CORE_BUDGET * TICK_NS)) return nullptr;
+
+    std::shared_ptr<Match> match = std::make_shared<Match>();
+    match->id = nextMatchId++;
+    placeMatch(match, *best, estimateNs);
+    matchesOpened.fetch_add(1, std::memory_order_relaxed);
+    return match;
+}
+
+// Every match checkpointed in the directory, back under its id with the ticks it had played, each
+// on the least loaded thread (over the budget if it comes to that: they were all running before)
+static void resumeMatches() {
+    std::vector<LoadedCheckpoint> checkpoints = loadCheckpoints(serverConfig.checkpointDir);
+    std::lock_guard<std::mutex> lock(matchMutex);
+    const int64_t estimateNs = static_cast<int64_t>(SERVER_NEW_MATCH_COST_US * 1000.0);
+    const Clock::time_point waitUntil = Clock::now() + std::chrono::milliseconds(SERVER_RESUME_WAIT_MS);
+    int resumed = 0;
+    for (LoadedCheckpoint& checkpoint : checkpoints) {
+        if (matchIndex.size() >= static_cast<size_t>(serverConfig.maxMatches)) {
+            LOG_WARN("Server: at the match limit; %zu checkpointed matches not resumed", checkpoints.size() - static_cast<size_t>(resumed));
+            break;
+        }
+        if (checkpoint.match == 0 || matchIndex.count(checkpoint.match) != 0) continue;
+        ServerCore* best = nullptr;
+        for (const std::unique_ptr<ServerCore>& core : cores) {
+            if (!best || core->loadNs.load(std::memory_order_relaxed) < best->loadNs.load(std::memory_order_relaxed)) best = core.get();
+        }
+        std::shared_ptr<Match> match = std::make_shared<Match>();
+        match->id = checkpoint.match;
+        match->ticks = checkpoint.ticks;
+        match->resume = std::move(checkpoint.snapshot);
+        match->waitUntil = waitUntil;
+        nextMatchId = std::max(nextMatchId, match->id + 1);
+        placeMatch(match, *best, estimateNs);
+        ++resumed;
+    }
+    if (resumed > 0) LOG_INFO("Server: resumed %d matches from %s", resumed, serverConfig.checkpointDir);
+}
+
+static std::shared_ptr<Match> findMatch(uint32_t id) {
+    std::lock_guard<std::mutex> lock(matchMutex);
+    std::unordered_map<uint32_t, std::shared_ptr<Match>>::iterator found = matchIndex.find(id);
+    return found == matchIndex.end() ? nullptr : found->second;
+}
+
+// ============================ MATCH THREADS ============================
+// The world after its tick, to every client of the match (each told whether it is the player).
+// Every client watches the same ship, so the entities in interest are gathered once; each client
+// then gets them relative to its own last acknowledged snapshot.
+static void broadcastSnapshot(ServerCore& core, Match& match) {
+    gatherReplicatedEntities(match.world, serverConfig.interestRadius, core.interestGrid, core.entities);
+    const int64_t inWorld = 1 + static_cast<int64_t>(match.world.liveAsteroidCount() + match.world.bullets.liveCount());
+    unsigned char* block = core.packet.data() + sizeof(ServerPacketHeader);
+    const size_t capacity = std::min(core.packet.size(), SERVER_MAX_DATAGRAM) - sizeof(ServerPacketHeader);
+    ServerPacketHeader header = {};
+    header.magic = SERVER_PROTOCOL_MAGIC;
+    header.version = SERVER_PROTOCOL_VERSION;
+    header.type = SERVER_SNAPSHOT;
+    header.match = match.id;
+    header.tick = match.ticks;
+    int64_t peakBytes = core.peakClientBytes.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(match.clientMutex);
+    for (size_t k = 0; k < match.clients.size(); ++k) {
+        ServerClient& client = match.clients[k];
+        const uint64_t deltasBefore = client.replication.deltas;
+        const size_t bytes = encodeReplication(client.replication, core.entities, block, capacity);
+        if (bytes == 0) continue; // Too large for a datagram; the next one may fit
+        header.player = k == 0 ? 1 : 0;
+        std::memcpy(core.packet.data(), &header, sizeof(header));
+        const size_t total = sizeof(ServerPacketHeader) + bytes;
+        if (sendto(serverSocket, reinterpret_cast<const char*>(core.packet.data()), static_cast<int>(total), 0,
+                   reinterpret_cast<const sockaddr*>(&client.address), client.addressLength) >= 0) {
+            packetsOut.fetch_add(1, std::memory_order_relaxed);
+            bytesOut.fetch_add(static_cast<int64_t>(total), std::memory_order_relaxed);
+        }
+        core.replicatedBytes.fetch_add(static_cast<int64_t>(total), std::memory_order_relaxed);
+        core.snapshots.fetch_add(1, std::memory_order_relaxed);
+        if (client.replication.deltas != deltasBefore) core.deltaSnapshots.fetch_add(1, std::memory_order_relaxed);
+        core.entitiesSent.fetch_add(static_cast<int64_t>(core.entities.size()), std::memory_order_relaxed);
+        core.entitiesInWorld.fetch_add(inWorld, std::memory_order_relaxed);
+        peakBytes = std::max(peakBytes, static_cast<int64_t>(client.replication.meanBytes) + static_cast<int64_t>(sizeof(ServerPacketHeader)));
+    }
+    core.peakClientBytes.store(peakBytes, std::memory_order_relaxed);
+}
+
+// Drops the clients silent for too long; true once the match has none left
+static bool sweepClients(Match& match, Clock::time_point now) {
+    std::lock_guard<std::mutex> lock(match.clientMutex);
+    const size_t before = match.clients.size();
+    match.clients.erase(std::remove_if(match.clients.begin(), match.clients.end(), [now](const ServerClient& client) {
+        return now - client.lastHeard > std::chrono::milliseconds(SERVER_CLIENT_TIMEOUT_MS);
+    }), match.clients.end());
+    if (match.clients.size() != before) match.input.store(0, std::memory_order_relaxed); // The player may be gone; the next one starts from rest
+    return match.clients.empty() && now >= match.waitUntil;
+}
+
+static void closeMatch(ServerCore& core, size_t k) {
+    const std::shared_ptr<Match> match = core.matches[k];
+    {
+        std::lock_guard<std::mutex> lock(matchMutex);
+        matchIndex.erase(match->id);
+    }
+    core.matches[k] = core.matches.back();
+    core.matches.pop_back();
+    core.matchCount.fetch_sub(1, std::memory_order_relaxed);
+    matchesClosed.fetch_add(1, std::memory_order_relaxed);
+    if (serverConfig.checkpointDir) {
+        match->ended.store(true, std::memory_order_release);
+        CheckpointJob job;
+        job.match = match;
+        queueCheckpointJob(std::move(job));
+    }
+}
+
+// One tick of every match on the thread: step, every SERVER_SNAPSHOT_TICKS a broadcast and every
+// ServerConfig::checkpointTicks a checkpoint, each timed.
+// A slowed match steps on its share of the thread's ticks, and costs the thread that share.
+static void tickMatches(ServerCore& core, Clock::time_point now, Clock::time_point deadline) {
+    const bool sweep = core.ticks.load(std::memory_order_relaxed) % TIMEOUT_SWEEP_TICKS == 0;
+    int64_t loadNs = 0, worstNs = 0, heaviestNs = -1;
+    uint32_t heaviest = 0;
+    int slowed = 0;
+    float slowest = 1.0f;
+    for (size_t k = 0; k < core.matches.size();) {
+        Match& match = *core.matches[k];
+        if (sweep && sweepClients(match, now)) {
+            closeMatch(core, k);
+            continue;
+        }
+        const float speed = match.speed.load(std::memory_order_relaxed);
+        if (speed < 1.0f) {
+            ++slowed;
+            slowest = std::min(slowest, speed);
+        }
+        match.credit += speed;
+        if (match.credit < 1.0f) { // Not its turn
+            loadNs += static_cast<int64_t>(static_cast<float>(match.meanNs.load(std::memory_order_relaxed)) * speed);
+            ++k;
+            continue;
+        }
+        match.credit -= 1.0f;
+        const Clock::time_point start = Clock::now();
+        match.world.step(SIM_DT, unpackInput(match.input.load(std::memory_order_relaxed)));
+        if (match.world.isGameOver) match.world.reset(); // The random streams carry on, so the next game differs
+        ++match.ticks;
+        if (match.ticks % SERVER_SNAPSHOT_TICKS == 0) broadcastSnapshot(core, match);
+        if (serverConfig.checkpointDir && --match.untilCheckpoint <= 0) {
+            saveCheckpoint(core.matches[k]);
+            match.untilCheckpoint = serverConfig.checkpointTicks;
+        }
+        const Clock::time_point end = Clock::now();
+        const int64_t costNs = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+        const int64_t latencyNs = std::chrono::duration_cast<std::chrono::nanoseconds>(end - deadline).count();
+        match.latency.add(latencyNs);
+        core.latency.add(latencyNs);
+
+        int64_t meanNs = match.meanNs.load(std::memory_order_relaxed);
+        meanNs += (costNs - meanNs) / 32;
+        match.meanNs.store(meanNs, std::memory_order_relaxed);
+        loadNs += static_cast<int64_t>(static_cast<float>(meanNs) * speed);
+        worstNs = std::max(worstNs, costNs);
+        if (meanNs > heaviestNs) {
+            heaviestNs = meanNs;
+            heaviest = match.id;
+        }
+        ++k;
+    }
+    {
+        std::lock_guard<std::mutex> lock(core.incomingMutex); // Placed since the tick began: already in the load
+        for (const std::shared_ptr<Match>& placed : core.incoming) loadNs += placed->meanNs.load(std::memory_order_relaxed);
+        core.loadNs.store(loadNs, std::memory_order_relaxed);
+    }
+    core.slowedMatches.store(slowed, std::memory_order_relaxed);
+    core.slowestSpeed.store(slowest, std::memory_order_relaxed);
+    core.heaviestMatch.store(heaviest, std::memory_order_relaxed);
+    core.heaviestNs.store(std::max<int64_t>(heaviestNs, 0), std::memory_order_relaxed);
+    if (worstNs > core.worstStepNs.load(std::memory_order_relaxed)) core.worstStepNs.store(worstNs, std::memory_order_relaxed);
+}
+
+// ============================ REBALANCING ============================
+static std::mutex rebalanceMutex; // One thread rebalances at a time, so two never count on the same room
+
+// Hands match k to `target` at full speed (the target has room for its whole cost)
+static void migrateMatch(ServerCore& core, size_t k, ServerCore& target) {
+    const std::shared_ptr<Match> match = core.matches[k];
+    core.matches[k] = core.matches.back();
+    core.matches.pop_back();
+    const int64_t meanNs = match->meanNs.load(std::memory_order_relaxed);
+    core.loadNs.fetch_sub(static_cast<int64_t>(static_cast<float>(meanNs) * match->speed.load(std::memory_order_relaxed)), std::memory_order_relaxed);
+    core.matchCount.fetch_sub(1, std::memory_order_relaxed);
+    match->speed.store(1.0f, std::memory_order_relaxed);
+    match->credit = 0.0f;
+    match->core.store(target.index, std::memory_order_relaxed);
+    target.matchCount.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(target.incomingMutex); // The hand-over: the target adopts it on its next tick
+        target.incoming.push_back(match);
+        target.loadNs.fetch_add(meanNs, std::memory_order_relaxed);
+    }
+    migrations.fetch_add(1, std::memory_order_relaxed);
+}
+
+// The least loaded thread other than `core` (null with migration off or a single thread): on the
+// same NUMA node while one there is under the restore line, so a match's memory stays local
+static ServerCore* leastLoadedOther(const ServerCore& core) {
+    ServerCore* local = nullptr;
+    ServerCore* target = nullptr;
+    if (!serverConfig.migrate) return nullptr;
+    for (const std::unique_ptr<ServerCore>& other : cores) {
+        if (other.get() == &core) continue;
+        const int64_t loadNs = other->loadNs.load(std::memory_order_relaxed);
+        if (!target || loadNs < target->loadNs.load(std::memory_order_relaxed)) target = other.get();
+        if (other->node == core.node && (!local || loadNs < local->loadNs.load(std::memory_order_relaxed))) local = other.get();
+    }
+    const int64_t restoreNs = static_cast<int64_t>(SERVER_RESTORE_SHARE * SERVER_CORE_BUDGET * TICK_NS);
+    return local && local->loadNs.load(std::memory_order_relaxed) < restoreNs ? local : target;
+}
+
+// The thread's load check (its own thread, every SERVER_REBALANCE_TICKS). Over the budget, it hands
+// matches over, then slows the heaviest ones, until its load is back under; under the budget, it
+// speeds one slowed match back up, here or on a thread with room.
+static void rebalance(ServerCore& core) {
+    std::unique_lock<std::mutex> lock(rebalanceMutex, std::try_to_lock);
+    if (!lock.owns_lock()) return; // Another thread is at it; this one looks again next time
+    const int64_t budgetNs = static_cast<int64_t>(SERVER_CORE_BUDGET * TICK_NS);
+    const int64_t restoreNs = static_cast<int64_t>(SERVER_RESTORE_SHARE * budgetNs);
+    int64_t loadNs = core.loadNs.load(std::memory_order_relaxed);
+
+    while (loadNs > budgetNs) {
+        // The match whose share takes this thread under the budget with the least moved (or else the
+        // largest share), among those the target takes whole, staying under the restore line and
+        // less loaded than this thread is left
+        ServerCore* target = leastLoadedOther(core);
+        const int64_t targetNs = target ? target->loadNs.load(std::memory_order_relaxed) : 0;
+        const int64_t excessNs = loadNs - budgetNs;
+        size_t best = core.matches.size();
+        int64_t bestShareNs = 0;
+        for (size_t k = 0; target && k < core.matches.size(); ++k) {
+            const Match& match = *core.matches[k];
+            const int64_t meanNs = match.meanNs.load(std::memory_order_relaxed);
+            const int64_t shareNs = static_cast<int64_t>(static_cast<float>(meanNs) * match.speed.load(std::memory_order_relaxed));
+            if (targetNs + meanNs > restoreNs || targetNs + meanNs >= loadNs - shareNs) continue;
+            const bool enough = shareNs >= excessNs, bestEnough = bestShareNs >= excessNs;
+            if (best == core.matches.size() || (enough && (!bestEnough || shareNs < bestShareNs)) || (!enough && !bestEnough && shareNs > bestShareNs)) {
+                best = k;
+                bestShareNs = shareNs;
+            }
+        }
+        if (best < core.matches.size()) {
+            migrateMatch(core, best, *target);
+            loadNs -= bestShareNs;
+            continue;
+        }
+        // Nowhere to go: the heaviest match not yet at the floor slows by just enough
+        Match* heaviest = nullptr;
+        for (const std::shared_ptr<Match>& match : core.matches) {
+            if (match->speed.load(std::memory_order_relaxed) <= serverConfig.minSpeed) continue;
+            if (!heaviest || match->meanNs.load(std::memory_order_relaxed) > heaviest->meanNs.load(std::memory_order_relaxed)) heaviest = match.get();
+        }
+        if (!heaviest) return; // Every match at the floor: the thread overruns
+        const float speed = heaviest->speed.load(std::memory_order_relaxed);
+        const float meanNs = static_cast<float>(std::max<int64_t>(heaviest->meanNs.load(std::memory_order_relaxed), 1));
+        const float slowed = std::max(serverConfig.minSpeed, speed - static_cast<float>(excessNs) / meanNs);
+        heaviest->speed.store(slowed, std::memory_order_relaxed);
+        loadNs -= static_cast<int64_t>((speed - slowed) * meanNs);
+        slowdowns.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // The slowest match, sped up by the room left under the restore line, or moved where it runs whole
+    size_t slowest = core.matches.size();
+    for (size_t k = 0; k < core.matches.size(); ++k) {
+        const float speed = core.matches[k]->speed.load(std::memory_order_relaxed);
+        if (speed < 1.0f && (slowest == core.matches.size() || speed < core.matches[slowest]->speed.load(std::memory_order_relaxed))) slowest = k;
+    }
+    if (slowest == core.matches.size()) return;
+    Match& match = *core.matches[slowest];
+    const float speed = match.speed.load(std::memory_order_relaxed);
+    const int64_t meanNs = std::max<int64_t>(match.meanNs.load(std::memory_order_relaxed), 1);
+    ServerCore* target = leastLoadedOther(core);
+    if (loadNs < restoreNs) {
+        match.speed.store(std::min(1.0f, speed + static_cast<float>(restoreNs - loadNs) / static_cast<float>(meanNs)), std::memory_order_relaxed);
+        speedups.fetch_add(1, std::memory_order_relaxed);
+    }
+    else if (target && target->loadNs.load(std::memory_order_relaxed) + meanNs <= restoreNs) {
+        migrateMatch(core, slowest, *target);
+        speedups.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+static void coreLoop(ServerCore* core) {
+    AllowAllocations matchThread; // Its own thread: matches arrive and leave here
+    nameTraceThread(("match-" + std::to_string(core->index)).c_str());
+    if (numaNodes > 1) setEntityMemoryNode(core->node);
+    const size_t entities = 1 + static_cast<size_t>(serverConfig.limits.asteroidPoolCapacity() + serverConfig.limits.maxBullets);
+    initInterestGrid(core->interestGrid, serverConfig.interestRadius, static_cast<size_t>(serverConfig.limits.asteroidPoolCapacity()));
+    core->entities.reserve(entities);
+    core->packet.resize(sizeof(ServerPacketHeader) + replicationBytesBound(entities));
+    const Clock::duration period = std::chrono::nanoseconds(TICK_NS);
+    Clock::time_point next = Clock::now();
+    while (serverRunning.load(std::memory_order_acquire)) {
+        {
+            std::lock_guard<std::mutex> lock(core->incomingMutex);
+            for (std::shared_ptr<Match>& match : core->incoming) {
+                if (!match->built) {
+                    // First touch here, on this thread's node (the network thread only placed it)
+                    match->world.init(serverConfig.limits);
+                    match->world.seed(serverConfig.seed + match->id);
+                    if (!match->resume.empty()) {
+                        if (!restoreWorldSnapshot(match->world, match->resume.data(), match->resume.size())) {
+                            LOG_WARN("Server: the checkpoint of match %u does not fit these limits; it starts a new game", match->id);
+                            match->ticks = 0;
+                        }
+                        std::vector<unsigned char>().swap(match->resume);
+                    }
+                    if (serverConfig.checkpointDir) {
+                        for (std::vector<unsigned char>& buffer : match->checkpointBuffers) buffer.resize(worldSnapshotBytes(serverConfig.limits));
+                        match->untilCheckpoint = 1 + static_cast<int>(match->id % static_cast<uint32_t>(serverConfig.checkpointTicks)); // Staggered
+                    }
+                    match->built = true;
+                }
+                core->matches.push_back(std::move(match));
+            }
+            core->incoming.clear();
+        }
+        Clock::time_point now = Clock::now();
+        if (now < next) {
+            std::this_thread::sleep_until(next);
+            continue;
+        }
+        if (now - next > period * SERVER_MAX_CATCHUP_TICKS) {
+            core->overruns.fetch_add(1, std::memory_order_relaxed);
+            next = now;
+        }
+        const Clock::time_point deadline = next;
+        next += period;
+        tickMatches(*core, now, deadline);
+        core->ticks.fetch_add(1, std::memory_order_relaxed);
+        if (--core->untilRebalance <= 0) {
+            rebalance(*core);
+            core->untilRebalance = SERVER_REBALANCE_TICKS;
+        }
+        core->busyNs.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - now).count(), std::memory_order_relaxed);
+    }
+}
+
+// ============================ NETWORK THREAD ============================
+static void handleJoin(const ClientPacket& packet, const sockaddr_storage& from, SocketLength length) {
+    std::shared_ptr<Match> match = packet.match == 0 ? openMatch() : findMatch(packet.match);
+    if (!match) {
+        joinsRefused.fetch_add(1, std::memory_order_relaxed);
+        sendHeader(from, length, packet.match == 0 ? SERVER_FULL : SERVER_NO_MATCH, packet.match, false);
+        return;
+    }
+    bool player = false;
+    {
+        std::lock_guard<std::mutex> lock(match->clientMutex);
+        std::vector<ServerClient>::iterator found = std::find_if(match->clients.begin(), match->clients.end(),
+                                                                 [&](const ServerClient& client) { return sameAddress(client, from, length); });
+        if (found == match->clients.end()) {
+            if (match->clients.size() >= static_cast<size_t>(SERVER_MAX_CLIENTS)) {
+                joinsRefused.fetch_add(1, std::memory_order_relaxed);
+                sendHeader(from, length, SERVER_FULL, match->id, false);
+                return;
+            }
+            ServerClient client;
+            client.address = from;
+            client.addressLength = length;
+            match->clients.push_back(client);
+            found = match->clients.end() - 1;
+        }
+        found->lastHeard = Clock::now();
+        player = found == match->clients.begin();
+    }
+    sendHeader(from, length, SERVER_WELCOME, match->id, player);
+}
+
+static void handleInput(const ClientPacket& packet, const sockaddr_storage& from, SocketLength length) {
+    std::shared_ptr<Match> match = findMatch(packet.match);
+    if (!match) return;
+    std::lock_guard<std::mutex> lock(match->clientMutex);
+    for (size_t k = 0; k < match->clients.size(); ++k) {
+        ServerClient& client = match->clients[k];
+        if (!sameAddress(client, from, length)) continue;
+        client.lastHeard = Clock::now();
+        if (packet.type == CLIENT_INPUT) acknowledgeReplication(client.replication, packet.ack);
+        if (packet.type == CLIENT_LEAVE) {
+            match->clients.erase(match->clients.begin() + static_cast<std::ptrdiff_t>(k));
+            if (k == 0) match->input.store(0, std::memory_order_relaxed); // The next one takes over from rest
+        }
+        else if (k == 0 && packet.sequence > client.sequence) {
+            client.sequence = packet.sequence;
+            match->input.store(packet.input, std::memory_order_relaxed);
+        }
+        return;
+    }
+}
+
+static void networkLoop() {
+    AllowAllocations network; // Its own thread: joins create matches and client entries
+    nameTraceThread("network");
+    while (serverRunning.load(std::memory_order_acquire)) {
+        ClientPacket packet;
+        sockaddr_storage from = {};
+        SocketLength length = sizeof(from);
+        const int received = static_cast<int>(recvfrom(serverSocket, reinterpret_cast<char*>(&packet), sizeof(packet), 0,
+                                                       reinterpret_cast<sockaddr*>(&from), &length));
+        if (received != static_cast<int>(sizeof(packet))) continue; // The timeout (a chance to stop), or not ours
+        if (packet.magic != SERVER_PROTOCOL_MAGIC || packet.version != SERVER_PROTOCOL_VERSION) continue;
+        packetsIn.fetch_add(1, std::memory_order_relaxed);
+        if (packet.type == CLIENT_JOIN) handleJoin(packet, from, length);
+        else if (packet.type == CLIENT_INPUT || packet.type == CLIENT_LEAVE) handleInput(packet, from, length);
+    }
+}
+
+// ============================ SERVER API ============================
+bool startServer(const ServerConfig& config) {
+    stopServer();
+    serverConfig = config;
+    const size_t entities = 1 + static_cast<size_t>(config.limits.asteroidPoolCapacity() + config.limits.maxBullets);
+    const size_t datagram = sizeof(ServerPacketHeader) + replicationBytesBound(entities);
+    if (datagram > SERVER_MAX_DATAGRAM) {
+        LOG_WARN("Server: a snapshot of up to %zu bytes may not fit a datagram; those are not sent", datagram);
+    }
+#if defined(_WIN32)
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+        LOG_ERROR("Server: Winsock unavailable");
+        return false;
+    }
+#endif
+    serverSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(static_cast<uint16_t>(config.port));
+    if (serverSocket == NO_SOCKET || bind(serverSocket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        LOG_ERROR("Server: cannot bind UDP port %d", config.port);
+        if (serverSocket != NO_SOCKET) closeSocket(serverSocket);
+        serverSocket = NO_SOCKET;
+#if defined(_WIN32)
+        WSACleanup();
+#endif
+        return false;
+    }
+    setReceiveTimeout(serverSocket, RECEIVE_TIMEOUT_MS);
+
+    const int hardware = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    const int threads = config.threads > 0 ? config.threads : hardware;
+    numaNodes = 1;
+    for (int c = 0; config.numa && c < threads; ++c) numaNodes = std::max(numaNodes, numaNodeOfCpu(c % hardware) + 1);
+    serverRunning.store(true, std::memory_order_release);
+    for (int c = 0; c < threads; ++c) {
+        cores.push_back(std::make_unique<ServerCore>());
+        ServerCore* core = cores.back().get();
+        core->index = c;
+        core->node = numaNodes > 1 ? numaNodeOfCpu(c % hardware) : 0;
+        core->untilRebalance = SERVER_REBALANCE_TICKS + c * SERVER_REBALANCE_TICKS / threads; // Staggered
+        core->thread = std::thread(coreLoop, core);
+        pinToCore(core->thread, c % hardware);
+    }
+    if (config.checkpointDir) {
+        checkpointStopping = false;
+        checkpointThread = std::thread(checkpointLoop);
+        resumeMatches();
+    }
+    networkThread = std::thread(networkLoop);
+    lastReport = Clock::now();
+    LOG_INFO("Server: UDP port %d, %d match thread%s, up to %d matches, %.0f%% of each %.2f ms tick per thread%s; interest radius %.2f%s",
+             config.port, threads, threads == 1 ? "" : "s", config.maxMatches, SERVER_CORE_BUDGET * 100.0, TICK_NS / 1e6,
+             config.fixedPoint ? ", fixed-point kinematics" : "",
+             config.interestRadius, config.interestRadius > 0.0f ? "" : " (the whole field)");
+    LOG_INFO("Server: overloaded threads %s; matches slow down to %.0f%% speed at the least",
+             config.migrate ? "hand matches to threads with room" : "keep their matches", config.minSpeed * 100.0f);
+    if (numaNodes > 1) LOG_INFO("Server: threads spread over %d NUMA nodes; entity memory on each thread's node", numaNodes);
+    else if (config.numa && numaNodeCount() > 1) LOG_INFO("Server: the match threads all sit on NUMA node 0 of %d", numaNodeCount());
+    if (config.checkpointDir) LOG_INFO("Server: matches checkpointed to %s every %.1f s", config.checkpointDir, config.checkpointTicks / SIM_TICK_RATE);
+    return true;
+}
+
+void stopServer() {
+    if (!serverRunning.exchange(false)) return;
+    networkThread.join();
+    for (std::unique_ptr<ServerCore>& core : cores) core->thread.join();
+    if (serverConfig.checkpointDir) {
+        {
+            std::lock_guard<std::mutex> lock(checkpointMutex);
+            checkpointStopping = true;
+        }
+        checkpointSignal.notify_one();
+        checkpointThread.join(); // Drains the queue first
+        // Every match as it stands, so a restart loses nothing (the buffers are all free now)
+        std::vector<unsigned char> scratch;
+        int written = 0;
+        for (std::unique_ptr<ServerCore>& core : cores) {
+            std::vector<std::shared_ptr<Match>> matches = core->matches;
+            matches.insert(matches.end(), core->incoming.begin(), core->incoming.end()); // Handed over, not adopted yet
+            for (const std::shared_ptr<Match>& match : matches) {
+                if (!match->built) continue; // Never stepped here: a resumed one's file is still the one it came from
+                std::vector<unsigned char>& snapshot = match->checkpointBuffers[0];
+                const size_t bytes = saveWorldSnapshot(match->world, snapshot.data(), snapshot.size());
+                if (bytes > 0 && writeCheckpointFile(serverConfig.checkpointDir, match->id, match->ticks, snapshot.data(), bytes, scratch)) ++written;
+            }
+        }
+        LOG_INFO("Server: checkpointed %d matches to %s", written, serverConfig.checkpointDir);
+    }
+    cores.clear();
+    {
+        std::lock_guard<std::mutex> lock(matchMutex);
+        matchIndex.clear();
+    }
+    closeSocket(serverSocket);
+    serverSocket = NO_SOCKET;
+#if defined(_WIN32)
+    WSACleanup();
+#endif
+}
+
+void logServerReport() {
+    const Clock::time_point now = Clock::now();
+    const double seconds = std::chrono::duration<double>(now - lastReport).count();
+    lastReport = now;
+    if (seconds <= 0.0) return;
+    int matches = 0;
+    int nodeThreads[ENTITY_MAX_NUMA_NODES] = {}, nodeMatches[ENTITY_MAX_NUMA_NODES] = {};
+    double nodeLoad[ENTITY_MAX_NUMA_NODES] = {}, nodeBusy[ENTITY_MAX_NUMA_NODES] = {};
+    int64_t replicated = 0, snapshots = 0, deltas = 0, sent = 0, inWorld = 0, peakBytes = 0;
+    for (const std::unique_ptr<ServerCore>& core : cores) {
+        replicated += core->replicatedBytes.exchange(0, std::memory_order_relaxed);
+        snapshots += core->snapshots.exchange(0, std::memory_order_relaxed);
+        deltas += core->deltaSnapshots.exchange(0, std::memory_order_relaxed);
+        sent += core->entitiesSent.exchange(0, std::memory_order_relaxed);
+        inWorld += core->entitiesInWorld.exchange(0, std::memory_order_relaxed);
+        peakBytes = std::max(peakBytes, core->peakClientBytes.exchange(0, std::memory_order_relaxed));
+        const int count = core->matchCount.load(std::memory_order_relaxed);
+        const double busy = core->busyNs.exchange(0, std::memory_order_relaxed) / (seconds * 1e9);
+        const long long ticks = core->ticks.exchange(0, std::memory_order_relaxed);
+        const long long overruns = core->overruns.exchange(0, std::memory_order_relaxed);
+        const double worstUs = core->worstStepNs.exchange(0, std::memory_order_relaxed) / 1000.0;
+        uint32_t latency[SERVER_LATENCY_BUCKETS];
+        core->latency.take(latency);
+        matches += count;
+        ++nodeThreads[core->node];
+        nodeMatches[core->node] += count;
+        nodeLoad[core->node] += static_cast<double>(core->loadNs.load(std::memory_order_relaxed)) / TICK_NS;
+        nodeBusy[core->node] += busy;
+        LOG_INFO("[server] thread %d: %d matches, load %.1f%% of a tick, busy %.1f%%, %.0f ticks/s, %lld overruns; "
+                 "tick latency p50 %.0f us, p99 %.0f us; %d slowed (slowest at %.0f%%); "
+                 "heaviest match %u at %.1f us/tick, worst match tick %.1f us",
+                 core->index, count, 100.0 * core->loadNs.load(std::memory_order_relaxed) / TICK_NS, 100.0 * busy,
+                 ticks / seconds, overruns, latencyPercentileUs(latency, 0.5), latencyPercentileUs(latency, 0.99),
+                 core->slowedMatches.load(std::memory_order_relaxed), 100.0f * core->slowestSpeed.load(std::memory_order_relaxed),
+                 core->heaviestMatch.load(std::memory_order_relaxed), core->heaviestNs.load(std::memory_order_relaxed) / 1000.0, worstUs);
+    }
+    for (int node = 0; numaNodes > 1 && node < numaNodes; ++node) {
+        if (nodeThreads[node] == 0) continue;
+        LOG_INFO("[server] NUMA node %d: %d threads, %d matches, mean load %.1f%%, busy %.1f%%; %.1f MB of entity arrays bound here",
+                 node, nodeThreads[node], nodeMatches[node], 100.0 * nodeLoad[node] / nodeThreads[node],
+                 100.0 * nodeBusy[node] / nodeThreads[node], entityNodeBytes(node) / (1024.0 * 1024.0));
+    }
+    LOG_INFO("[server] %d matches (%lld opened, %lld closed, %lld joins refused; %lld migrated, %lld slowed, %lld sped up); "
+             "%.0f packets/s in, %.0f out, %.1f KB/s out",
+             matches, static_cast<long long>(matchesOpened.exchange(0)), static_cast<long long>(matchesClosed.exchange(0)),
+             static_cast<long long>(joinsRefused.exchange(0)), static_cast<long long>(migrations.exchange(0)),
+             static_cast<long long>(slowdowns.exchange(0)), static_cast<long long>(speedups.exchange(0)),
+             packetsIn.exchange(0) / seconds, packetsOut.exchange(0) / seconds, bytesOut.exchange(0) / seconds / 1024.0);
+    if (serverConfig.checkpointDir) {
+        const long long saved = checkpointsSaved.exchange(0), written = checkpointsWritten.exchange(0);
+        const double saveUs = checkpointSaveNs.exchange(0) / 1000.0, writeMs = checkpointWriteNs.exchange(0) / 1e6;
+        const double raw = static_cast<double>(checkpointBytes.exchange(0)), packed = static_cast<double>(checkpointPackedBytes.exchange(0));
+        LOG_INFO("[server] checkpoints: %lld saved (%.1f us pause each), %lld skipped with both buffers queued; %lld written "
+                 "(%.1f KB each, packed to %.0f%%, %.2f ms to write)",
+                 saved, saved > 0 ? saveUs / saved : 0.0, static_cast<long long>(checkpointsSkipped.exchange(0)), written,
+                 written > 0 ? raw / written / 1024.0 : 0.0, raw > 0.0 ? 100.0 * packed / raw : 0.0, written > 0 ? writeMs / written : 0.0);
+    }
+    if (snapshots == 0) return;
+    // A client is sent one snapshot every SERVER_SNAPSHOT_TICKS, so its rate follows from the mean snapshot
+    const double perSecond = static_cast<double>(SIM_TICK_RATE) / SERVER_SNAPSHOT_TICKS;
+    const double meanBytes = static_cast<double>(replicated) / snapshots;
+    LOG_INFO("[server] replication: %.2f KB/s per client (%.0f B a snapshot), busiest client %.2f KB/s; %.0f%% deltas; "
+             "%.1f of %.1f entities in interest",
+             meanBytes * perSecond / 1024.0, meanBytes, peakBytes * perSecond / 1024.0, 100.0 * deltas / snapshots,
+             static_cast<double>(sent) / snapshots, static_cast<double>(inWorld) / snapshots);
+}
+
+void logServerMatchReport(int count) {
+    struct MatchLatency {
+        uint32_t id;
+        int core;
+        double meanUs, speed, p50, p99, p999, max;
+        uint64_t ticks;
+    };
+    std::vector<std::shared_ptr<Match>> matches;
+    {
+        std::lock_guard<std::mutex> lock(matchMutex);
+        matches.reserve(matchIndex.size());
+        for (const std::pair<const uint32_t, std::shared_ptr<Match>>& entry : matchIndex) matches.push_back(entry.second);
+    }
+    std::vector<MatchLatency> rows;
+    rows.reserve(matches.size());
+    for (const std::shared_ptr<Match>& match : matches) {
+        uint32_t latency[SERVER_LATENCY_BUCKETS];
+        match->latency.take(latency);
+        uint64_t ticks = 0;
+        for (int b = 0; b < SERVER_LATENCY_BUCKETS; ++b) ticks += latency[b];
+        if (ticks == 0) continue;
+        rows.push_back({ match->id, match->core.load(std::memory_order_relaxed), match->meanNs.load(std::memory_order_relaxed) / 1000.0,
+                         match->speed.load(std::memory_order_relaxed), latencyPercentileUs(latency, 0.5), latencyPercentileUs(latency, 0.99),
+                         latencyPercentileUs(latency, 0.999), latencyPercentileUs(latency, 1.0), ticks });
+    }
+    std::sort(rows.begin(), rows.end(), [](const MatchLatency& a, const MatchLatency& b) { return a.p99 > b.p99 || (a.p99 == b.p99 && a.id < b.id); });
+    if (count > 0 && rows.size() > static_cast<size_t>(count)) rows.resize(static_cast<size_t>(count));
+    for (const MatchLatency& row : rows) {
+        LOG_INFO("[server] match %u on thread %d: %.1f us/tick at %.0f%% speed, %llu ticks; latency p50 %.0f us, p99 %.0f us, p99.9 %.0f us, max %.0f us",
+                 row.id, row.core, row.meanUs, 100.0 * row.speed, static_cast<unsigned long long>(row.ticks), row.p50, row.p99, row.p999, row.max);
+    }
+}
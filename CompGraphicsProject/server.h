@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "simulation.h"
+
+// Authoritative headless server: many concurrent matches per process, each an independent
+// GameWorld stepped at SIM_TICK_RATE. The matches are spread over one thread per core (pinned to
+// it), and every thread steps all of its matches each tick, back to back, then sleeps to the next
+// deadline. Each match's step is timed, and a thread's load is the sum of its matches' mean tick
+// costs. A new match goes to the least loaded thread if that stays under SERVER_CORE_BUDGET of the
+// tick; otherwise the server reports itself full. The per-match and per-thread figures are what
+// decide how densely matches can be packed onto a host.
+// Costs drift as matches fill up with rocks, so every SERVER_REBALANCE_TICKS each thread checks its
+// load again. Over the budget, it hands one match (the one that best fits) to the least loaded
+// thread that can take it; with no thread to take one, it slows its heaviest match down instead
+// (time dilation: the match steps on only some of the thread's ticks, so its game runs slower but
+// stays deterministic and its neighbours stay on schedule), down to ServerConfig::minSpeed. Back
+// under SERVER_RESTORE_SHARE of the budget, or with another thread free to run it at full speed, a
+// slowed match is sped up again. Each match keeps a histogram of its tick latency (from the tick's
+// deadline to the end of its step and sends, so waiting behind the thread's other matches counts),
+// reported as percentiles per thread and for the worst matches.
+// On a multi-socket host (more than one NUMA node, ServerConfig::numa), each thread knows the node
+// of the core it is pinned to and asks for its entity arrays there (entitymemory.h). A match's world
+// is built by the thread that first adopts it, so its memory starts out local to its thread; an
+// overloaded thread hands matches to a thread on its own node while one has room, and crosses
+// nodes (leaving the memory remote) only rather than slow a match down.
+// Clients speak UDP on one port. They send input, and the match's thread sends each client a
+// replication snapshot (replication.h) every SERVER_SNAPSHOT_TICKS: what lies within
+// ServerConfig::interestRadius of the ship, as the change from the last snapshot that client
+// acknowledged. The first client of a match flies its ship; the others watch (a world has one
+// ship). A world that loses its ship starts a new game in the same match. A match ends when its
+// last client has been silent for SERVER_CLIENT_TIMEOUT_MS.
+// With ServerConfig::checkpointDir set, every match is checkpointed there every checkpointTicks
+// (checkpoint.h), staggered by match id so the threads do not all save on one tick. The match's
+// thread copies its world into the free one of the match's two snapshot buffers between ticks, and
+// that copy is all the tick pays: the server's checkpoint thread packs and writes the buffer while
+// the match plays on. With both buffers still queued (a slow disk), the match skips that checkpoint.
+// A match that ends has its file removed, and a server stopped cleanly checkpoints every match as
+// it stops. On start, the server resumes every match in the directory under its old id, with the
+// ticks it had played; a resumed match waits SERVER_RESUME_WAIT_MS for its clients to join it again.
+// Like simulation.h, nothing here depends on GL.
+
+// ============================ PROTOCOL ============================
+// Little-endian structs, one per datagram. A client joins a match (0: a new one) and learns its id
+// from the welcome. From then on it sends its key bits every frame or tick; the latest sequence
+// number wins, so a late datagram never rolls the input back. Any packet counts as a heartbeat.
+// Every input packet also carries the newest snapshot the client has decoded, so watching clients
+// send them too (their key bits are ignored).
+const uint32_t SERVER_PROTOCOL_MAGIC = 0x56525341; // "ASRV"
+const uint32_t SERVER_PROTOCOL_VERSION = 2;
+
+enum ClientPacketType : uint8_t { CLIENT_JOIN = 1, CLIENT_INPUT = 2, CLIENT_LEAVE = 3 };
+enum ServerPacketType : uint8_t { SERVER_WELCOME = 1, SERVER_SNAPSHOT = 2, SERVER_FULL = 3, SERVER_NO_MATCH = 4 };
+
+struct ClientPacket {
+    uint32_t magic;
+    uint32_t version;
+    uint8_t type; // ClientPacketType
+    uint8_t input; // packInput bits (CLIENT_INPUT)
+    uint8_t reserved[2];
+    uint32_t match; // 0 with CLIENT_JOIN: start a new match
+    uint32_t sequence; // Rising per client (CLIENT_INPUT)
+    uint32_t ack; // Sequence of the newest replication snapshot decoded; 0: none (CLIENT_INPUT)
+};
+
+// Followed, for SERVER_SNAPSHOT, by a replication snapshot (the rest of the datagram)
+struct ServerPacketHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint8_t type; // ServerPacketType
+    uint8_t player; // 1: this client flies the ship
+    uint8_t reserved[2];
+    uint32_t match;
+    uint64_t tick; // The match's ticks so far (SERVER_SNAPSHOT: the world as it stands after them)
+};
+
+const size_t SERVER_MAX_DATAGRAM = 65507; // UDP over IPv4; a snapshot that does not fit is not sent
+
+// ============================ SCHEDULING ============================
+const int SERVER_SNAPSHOT_TICKS = 6; // 20 snapshots a second at 120 ticks
+const int SERVER_CLIENT_TIMEOUT_MS = 5000;
+const int SERVER_MAX_CLIENTS = 8; // Per match: the player and up to seven watching
+const double SERVER_CORE_BUDGET = 0.75; // Share of a tick a thread's matches may take (the rest absorbs spikes)
+const int SERVER_MAX_CATCHUP_TICKS = 8; // A thread further behind drops the backlog (an overrun) instead of catching up
+const double SERVER_NEW_MATCH_COST_US = 50.0; // Cost assumed for a new match before any has been measured
+const int SERVER_REBALANCE_TICKS = 120; // Between a thread's load checks (a second at 120 ticks)
+const double SERVER_RESTORE_SHARE = 0.85; // Share of the budget a thread stays under when speeding matches up or taking one
+const int SERVER_RESUME_WAIT_MS = 30000; // A resumed match with no client by then ends
+const int SERVER_LATENCY_BUCKETS = 64; // Tick latency histogram: 4 buckets per doubling, from 1 us to about 65 ms
+
+struct ServerConfig {
+    int port = 27960;
+    int threads = -1; // -1: one per hardware thread
+    int maxMatches = 4096;
+    uint64_t seed = 1; // Match n is seeded with seed + n
+    SimulationLimits limits;
+    bool fixedPoint = false; // GameWorld::fixedPointKinematics for every match
+    float interestRadius = 0.75f; // Clients are sent what lies this far from the ship; 0: the whole field
+    bool migrate = true; // Overloaded threads hand matches to threads with room
+    float minSpeed = 0.5f; // Slowest a match may be dilated to (1: never)
+    bool numa = true; // Entity memory on each thread's own NUMA node, and migration within it first
+    const char* checkpointDir = nullptr; // Matches checkpointed to and resumed from here (null: none)
+    int checkpointTicks = static_cast<int>(10 * SIM_TICK_RATE); // Between a match's checkpoints
+};
+
+// ============================ SERVER API ============================
+// Opens the port and starts the network and match threads; false if the port cannot be bound
+bool startServer(const ServerConfig& config);
+void stopServer(); // Closes every match and joins the threads (safe to call twice)
+// Logs per thread: matches, load against the tick, measured busy time, overruns, tick latency
+// percentiles, slowed matches and the heaviest match; then, on more than one NUMA node, the threads,
+// matches, load and entity memory of each node; then the server's totals since the last report
+// (migrations among them), the replication bandwidth per client, and the checkpoints saved, written
+// and skipped with their pause, size and write time
+void logServerReport();
+// Logs the `count` matches with the worst 99th percentile tick latency since the last call: their
+// thread, cost, speed and latency percentiles (0: every match)
+void logServerMatchReport(int count);
@@ -0,0 +1,108 @@
+#include "server.h"
+#include "jobs.h"
+#include "log.h"
+#include "relay.h"
+#include "random.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+// ============================ DEDICATED SERVER ============================
+// The authoritative match server (server.h) as an executable of its own: no window, no GL.
+//
+// --port N: UDP port (default 27960); --threads N: match threads, one per core (default: one per
+// hardware thread); --max-matches N (default 4096); --seed N: match n plays seed + n (default 1)
+// --fixed-point: Q16.16 kinematics in every match (fixedpoint.h); --interest R: clients are sent
+// what lies within R of the ship (default 0.75; 0: the whole field, replication.h)
+// --report-seconds N: per-thread load report interval (default 10); --seconds N: stop after N
+// seconds (default: run until killed)
+// --no-migrate: overloaded threads keep their matches (only slowing them); --min-speed F: slowest
+// a match may run, as a share of real time (default 0.5; 1: never slowed); --match-report N: each
+// report also lists the N matches with the worst tick latency (default 5; 0: none)
+// --no-numa: ignore the NUMA nodes (entity memory wherever the system puts it, migration to any thread)
+// --checkpoint DIR: checkpoint every match into DIR and resume the ones found there at start
+// (server.h); --checkpoint-seconds N: between a match's checkpoints (default 10)
+// --relay HOST:PORT MATCH: run a spectator relay (relay.h) for that match of that server instead,
+// viewers joining on --port (default 27961 here); --max-viewers N (default 4096)
+int main(int argc, char** argv)
+{
+    startLogger();
+    ServerConfig config;
+    double reportSeconds = 10.0;
+    double runSeconds = 0.0;
+    int matchReport = 5;
+    RelayConfig relay;
+    bool portGiven = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            config.port = std::atoi(argv[++i]);
+            portGiven = true;
+        }
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) config.threads = std::max(1, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--max-matches") == 0 && i + 1 < argc) config.maxMatches = std::max(1, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) config.seed = std::strtoull(argv[++i], NULL, 10);
+        else if (std::strcmp(argv[i], "--fixed-point") == 0) config.fixedPoint = true;
+        else if (std::strcmp(argv[i], "--interest") == 0 && i + 1 < argc) config.interestRadius = std::max(0.0f, static_cast<float>(std::atof(argv[++i])));
+        else if (std::strcmp(argv[i], "--report-seconds") == 0 && i + 1 < argc) reportSeconds = std::max(0.1, std::atof(argv[++i]));
+        else if (std::strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) runSeconds = std::max(0.0, std::atof(argv[++i]));
+        else if (std::strcmp(argv[i], "--no-migrate") == 0) config.migrate = false;
+        else if (std::strcmp(argv[i], "--no-numa") == 0) config.numa = false;
+        else if (std::strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc) config.checkpointDir = argv[++i];
+        else if (std::strcmp(argv[i], "--checkpoint-seconds") == 0 && i + 1 < argc) {
+            config.checkpointTicks = std::max(1, static_cast<int>(std::atof(argv[++i]) * SIM_TICK_RATE));
+        }
+        else if (std::strcmp(argv[i], "--min-speed") == 0 && i + 1 < argc) {
+            config.minSpeed = std::min(1.0f, std::max(0.1f, static_cast<float>(std::atof(argv[++i]))));
+        }
+        else if (std::strcmp(argv[i], "--match-report") == 0 && i + 1 < argc) matchReport = std::max(0, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--relay") == 0 && i + 2 < argc) {
+            relay.server = argv[++i];
+            relay.match = static_cast<uint32_t>(std::strtoul(argv[++i], NULL, 10));
+        }
+        else if (std::strcmp(argv[i], "--max-viewers") == 0 && i + 1 < argc) relay.maxViewers = std::max(1, std::atoi(argv[++i]));
+    }
+    if (relay.server) {
+        // Nothing simulated here: the relay only decodes and re-encodes
+        if (portGiven) relay.port = config.port;
+        if (!startRelay(relay)) return 1;
+    }
+    else {
+        seedRandomStreams(config.seed);
+        std::vector<float> atlasVertices; // Shapes are still needed for the asteroid shape indices
+        generateAsteroidShapes(atlasVertices);
+        startJobSystem(0); // A match is stepped whole on its thread: its jobs run inline
+        if (!startServer(config)) return 1;
+    }
+
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point start = Clock::now();
+    Clock::time_point nextReport = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(reportSeconds));
+    for (;;) {
+        const Clock::time_point wake = runSeconds > 0.0
+            ? std::min(nextReport, start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(runSeconds)))
+            : nextReport;
+        std::this_thread::sleep_until(wake);
+        if (Clock::now() >= nextReport) {
+            if (relay.server) logRelayReport();
+            else {
+                logServerReport();
+                if (matchReport > 0) logServerMatchReport(matchReport);
+            }
+            nextReport += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(reportSeconds));
+        }
+        if (runSeconds > 0.0 && Clock::now() - start >= std::chrono::duration<double>(runSeconds)) break;
+    }
+    if (relay.server) {
+        logRelayReport();
+        stopRelay();
+        return 0;
+    }
+    logServerReport();
+    if (matchReport > 0) logServerMatchReport(matchReport);
+    stopServer();
+    return 0;
+}
@@ -0,0 +1,249 @@
+#include "shaders.h"
+#include "gldebug.h"
+#include "log.h"
+#include "profiler.h"
+
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <chrono>
+#include <thread>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+const char* SHADER_CACHE_DIR = "shader_cache";
+
+// Blob file layout: magic, binary format, then the driver's program binary
+static const std::uint32_t SHADER_CACHE_MAGIC = 0x31484353; // "SCH1"
+
+// ============================ HELPERS ============================
+// FNV-1a, 64-bit
+static std::uint64_t hashBytes(std::uint64_t hash, const char* data) {
+    for (; data && *data; ++data) {
+        hash ^= static_cast<unsigned char>(*data);
+        hash *= 1099511628211ull;
+    }
+    return hash ^ 0xFF; // Separator, so "ab" + "c" and "a" + "bc" differ
+}
+
+static bool programBinariesSupported() {
+    if (!GLAD_GL_VERSION_4_1 || !glGetProgramBinary || !glProgramBinary) return false;
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+}
+
+// A compute program hashes its source as the vertex stage and no fragment stage
+static std::string cachePath(const char* vertexSource, const char* fragmentSource,
+                             const char* const* feedbackVaryings, int feedbackCount) {
+    std::uint64_t hash = 14695981039346656037ull;
+    hash = hashBytes(hash, reinterpret_cast<const char*>(glGetString(GL_VENDOR)));
+    hash = hashBytes(hash, reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+    hash = hashBytes(hash, reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+    hash = hashBytes(hash, vertexSource);
+    hash = hashBytes(hash, fragmentSource);
+    for (int i = 0; i < feedbackCount; ++i) hash = hashBytes(hash, feedbackVaryings[i]);
+
+    char fileName[32];
+    std::snprintf(fileName, sizeof(fileName), "%016llx.bin", static_cast<unsigned long long>(hash));
+    return std::string(SHADER_CACHE_DIR) + "/" + fileName;
+}
+
+static bool linkSucceeded(unsigned int program) {
+    GLint linked = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    return linked != 0;
+}
+
+static unsigned int compileShader(const char* name, GLenum type, const char* source) {
+    unsigned int shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+
+    GLint compiled = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+    if (!compiled) {
+        char infoLog[1024];
+        glGetShaderInfoLog(shader, sizeof(infoLog), NULL, infoLog);
+        const char* stage = type == GL_VERTEX_SHADER ? "vertex" : type == GL_FRAGMENT_SHADER ? "fragment" : "compute";
+        LOG_ERROR("Shader compile error (%s, %s):\n%s", name, stage, infoLog);
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+// ============================ CACHE ============================
+static bool loadCachedProgram(unsigned int program, const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+
+    std::uint32_t magic = 0;
+    GLenum format = 0;
+    file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    file.read(reinterpret_cast<char*>(&format), sizeof(format));
+    if (!file || magic != SHADER_CACHE_MAGIC) return false;
+    std::vector<char> binary((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (binary.empty()) return false;
+
+    glProgramBinary(program, format, binary.data(), static_cast<GLsizei>(binary.size()));
+    return linkSucceeded(program); // Drivers reject blobs from other versions here
+}
+
+static void saveProgramBinary(unsigned int program, const std::string& path) {
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, NULL, &format, binary.data());
+
+    std::error_code error;
+    std::filesystem::create_directories(SHADER_CACHE_DIR, error);
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) return;
+    file.write(reinterpret_cast<const char*>(&SHADER_CACHE_MAGIC), sizeof(SHADER_CACHE_MAGIC));
+    file.write(reinterpret_cast<const char*>(&format), sizeof(format));
+    file.write(binary.data(), binary.size());
+}
+
+// ============================ BUILD ============================
+unsigned int buildProgram(const char* name, const char* vertexSource, const char* fragmentSource,
+                          const char* const* feedbackVaryings, int feedbackCount) {
+    const bool useCache = programBinariesSupported();
+    std::string path;
+    unsigned int program = glCreateProgram();
+
+    if (useCache) {
+        path = cachePath(vertexSource, fragmentSource, feedbackVaryings, feedbackCount);
+        if (loadCachedProgram(program, path)) {
+            labelGlObject(GL_PROGRAM, program, name);
+            return program;
+        }
+    }
+
+    unsigned int vShader = compileShader(name, GL_VERTEX_SHADER, vertexSource);
+    unsigned int fShader = compileShader(name, GL_FRAGMENT_SHADER, fragmentSource);
+    if (!vShader || !fShader) {
+        if (vShader) glDeleteShader(vShader);
+        if (fShader) glDeleteShader(fShader);
+        glDeleteProgram(program);
+        return 0;
+    }
+
+    glAttachShader(program, vShader);
+    glAttachShader(program, fShader);
+    if (feedbackCount > 0) glTransformFeedbackVaryings(program, feedbackCount, feedbackVaryings, GL_INTERLEAVED_ATTRIBS);
+    if (useCache) glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(program);
+    glDetachShader(program, vShader);
+    glDetachShader(program, fShader);
+    glDeleteShader(vShader);
+    glDeleteShader(fShader);
+
+    if (!linkSucceeded(program)) {
+        char infoLog[1024];
+        glGetProgramInfoLog(program, sizeof(infoLog), NULL, infoLog);
+        LOG_ERROR("Shader link error (%s):\n%s", name, infoLog);
+        glDeleteProgram(program);
+        return 0;
+    }
+
+    if (useCache) saveProgramBinary(program, path);
+    labelGlObject(GL_PROGRAM, program, name);
+    return program;
+}
+
+unsigned int buildComputeProgram(const char* name, const char* computeSource) {
+    const bool useCache = programBinariesSupported();
+    std::string path;
+    unsigned int program = glCreateProgram();
+
+    if (useCache) {
+        path = cachePath(computeSource, nullptr, nullptr, 0);
+        if (loadCachedProgram(program, path)) return program;
+    }
+
+    unsigned int cShader = compileShader(name, GL_COMPUTE_SHADER, computeSource);
+    if (!cShader) {
+        glDeleteProgram(program);
+        return 0;
+    }
+
+    glAttachShader(program, cShader);
+    if (useCache) glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(program);
+    glDetachShader(program, cShader);
+    glDeleteShader(cShader);
+
+    if (!linkSucceeded(program)) {
+        char infoLog[1024];
+        glGetProgramInfoLog(program, sizeof(infoLog), NULL, infoLog);
+        LOG_ERROR("Shader link error (%s):\n%s", name, infoLog);
+        glDeleteProgram(program);
+        return 0;
+    }
+
+    if (useCache) saveProgramBinary(program, path);
+    return program;
+}
+
+// ============================ BACKGROUND COMPILATION ============================
+struct QueuedProgram {
+    unsigned int* target;
+    const char* name;
+    const char* vertexSource;
+    const char* fragmentSource;
+};
+
+static std::vector<QueuedProgram> queuedPrograms;
+static GLFWwindow* compilerWindow = nullptr;
+static std::thread compilerThread;
+static double compilerMilliseconds = 0.0;
+
+static void buildQueuedPrograms() {
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (const QueuedProgram& queued : queuedPrograms) {
+        StartupScope scope(std::string("program ") + queued.name);
+        *queued.target = buildProgram(queued.name, queued.vertexSource, queued.fragmentSource);
+    }
+    compilerMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void queueProgram(unsigned int* target, const char* name, const char* vertexSource, const char* fragmentSource) {
+    queuedPrograms.push_back({ target, name, vertexSource, fragmentSource });
+}
+
+void startShaderCompiler(GLFWwindow* window) {
+    // Same context hints as the game window, which are still set; only this window stays hidden
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    StartupScope scope("shader compiler context");
+    compilerWindow = glfwCreateWindow(1, 1, "shader compiler", nullptr, window);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+    if (!compilerWindow) {
+        LOG_WARN("No shared context for background shader compilation; building the programs on the main thread");
+        return;
+    }
+    compilerThread = std::thread([] {
+        glfwMakeContextCurrent(compilerWindow);
+        installGlDebugOutput(); // Compile and link messages come from this context
+        buildQueuedPrograms();
+        glFinish(); // The programs are complete before the game window's context uses them
+        glfwMakeContextCurrent(nullptr);
+    });
+}
+
+double finishShaderCompiler() {
+    if (compilerThread.joinable()) compilerThread.join();
+    else buildQueuedPrograms();
+    if (compilerWindow) glfwDestroyWindow(compilerWindow);
+    compilerWindow = nullptr;
+    queuedPrograms.clear();
+    return compilerMilliseconds;
+}
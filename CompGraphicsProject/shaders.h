@@ -0,0 +1,28 @@
+#pragma once
+
+// ============================ SHADER MANAGER ============================
+// Compiles and links programs with info-log reporting. When the driver supports program binaries
+// (GL 4.1 and at least one binary format), each linked program is saved to SHADER_CACHE_DIR under a
+// hash of the vendor, renderer, GL version and shader sources, and the next launch loads it with
+// glProgramBinary instead of compiling. A rejected or stale blob simply falls back to a compile.
+extern const char* SHADER_CACHE_DIR;
+
+// Returns the linked program, or 0 if compiling or linking failed (the info log is printed).
+// Transform feedback varyings, if any, are set before linking and are part of the cache key.
+unsigned int buildProgram(const char* name, const char* vertexSource, const char* fragmentSource,
+                          const char* const* feedbackVaryings = nullptr, int feedbackCount = 0);
+// Same for a compute-only program (GL 4.3)
+unsigned int buildComputeProgram(const char* name, const char* computeSource);
+
+// ============================ BACKGROUND COMPILATION ============================
+// Programs queued with queueProgram are built (compiled, or loaded from the cache) by
+// startShaderCompiler on a thread of their own, current on a hidden 1x1 window whose context shares
+// objects with the game window, while the main thread carries on with the rest of the setup.
+// finishShaderCompiler waits for them; every queued target is set once it returns (0 on failure,
+// as with buildProgram). Without a shared context the programs are built in finishShaderCompiler.
+struct GLFWwindow;
+
+void queueProgram(unsigned int* target, const char* name, const char* vertexSource, const char* fragmentSource);
+void startShaderCompiler(GLFWwindow* window);
+// Returns the milliseconds spent building the queue (on whichever thread built it)
+double finishShaderCompiler();
@@ -0,0 +1,150 @@
+#include "shapestream.h"
+#include "alloctrack.h"
+#include "components.h"
+#include "glstate.h"
+#include "log.h"
+#include "memreport.h"
+#include "random.h"
+#include "threadconfig.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <glad/glad.h>
+
+bool useShapeStream = true;
+
+// ============================ STAGING ============================
+// The worker writes slot k, then publishes it by raising shapesGenerated past k; the render thread
+// reads only the slots below it, and nothing writes a slot twice, so no lock guards them
+static float stagedVertices[SHAPE_STREAM_SLOTS][2 * ASTEROID_SHAPE_VERTICES];
+static AsteroidMesh streamedMeshes[SHAPE_STREAM_SLOTS][ASTEROID_LOD_COUNT];
+static std::atomic<int> shapesGenerated(0);
+static int shapesUploaded = 0; // Render thread only
+static unsigned long long bytesUploaded = 0;
+static int streamFirstVertex = 0;
+static bool started = false;
+
+static_assert(SHAPE_STREAM_FRAME_BYTES >= sizeof(stagedVertices[0]), "The frame budget must fit a whole shape");
+
+// ============================ WORKER ============================
+static std::thread streamThread;
+static std::mutex streamMutex;
+static std::condition_variable streamSignal;
+static bool streamStopping = false;
+
+// Time-sliced: one shape per interval, then the thread sleeps until the next (or until it is
+// stopped); it exits once every slot is full
+static void streamLoop(uint64_t seed) {
+    nameTraceThread("shape stream");
+    registerThread(THREAD_BACKGROUND);
+    Rng rng;
+    rng.seed(seed, RNG_STREAM_SHAPE_VARIANTS);
+    const int finestSegments = ASTEROID_LOD_SEGMENTS[ASTEROID_LOD_COUNT - 1];
+    float fillVertices[2 * (finestSegments + 2)];
+    AsteroidShape shape;
+    for (int k = 0; k < SHAPE_STREAM_SLOTS; ++k) {
+        {
+            std::unique_lock<std::mutex> lock(streamMutex);
+            if (streamSignal.wait_for(lock, std::chrono::duration<double>(SHAPE_STREAM_INTERVAL_SECONDS), [] { return streamStopping; })) return;
+        }
+        TraceScope scope("generate shape", "shapes");
+        generateFilledAsteroidVertices(finestSegments, 1.0f, rng, fillVertices);
+        packAsteroidShape(fillVertices, streamFirstVertex + k * ASTEROID_SHAPE_VERTICES, stagedVertices[k], shape);
+        std::copy(shape.lods, shape.lods + ASTEROID_LOD_COUNT, streamedMeshes[k]);
+        shapesGenerated.store(k + 1, std::memory_order_release);
+    }
+}
+
+// ============================ API ============================
+void startShapeStream(uint64_t seed, int firstVertex) {
+    if (started) return;
+    streamFirstVertex = firstVertex;
+    shapesGenerated.store(0, std::memory_order_relaxed);
+    shapesUploaded = 0;
+    streamStopping = false;
+    started = true;
+    streamThread = std::thread(streamLoop, seed);
+    LOG_INFO("Shape stream: %d spare shapes, one every %.0f s", SHAPE_STREAM_SLOTS, SHAPE_STREAM_INTERVAL_SECONDS);
+}
+
+void stopShapeStream() {
+    if (!started) return;
+    {
+        std::lock_guard<std::mutex> lock(streamMutex);
+        streamStopping = true;
+    }
+    streamSignal.notify_all();
+    streamThread.join();
+    started = false;
+    LOG_INFO("Shape stream: %d of %d shapes uploaded (%llu bytes)", shapesUploaded, SHAPE_STREAM_SLOTS, bytesUploaded);
+}
+
+void uploadStreamedShapes(unsigned int meshVBO) {
+    if (!started) return;
+    const int generated = shapesGenerated.load(std::memory_order_acquire);
+    const size_t shapeBytes = sizeof(stagedVertices[0]);
+    int end = shapesUploaded;
+    for (size_t budget = SHAPE_STREAM_FRAME_BYTES; end < generated && budget >= shapeBytes; budget -= shapeBytes) ++end;
+    if (end == shapesUploaded) return;
+
+    // The staged slots are contiguous, so the new shapes are one upload
+    const GLintptr offset = static_cast<GLintptr>((static_cast<size_t>(streamFirstVertex) + static_cast<size_t>(shapesUploaded) * ASTEROID_SHAPE_VERTICES) * 2 * sizeof(float));
+    const GLsizeiptr bytes = static_cast<GLsizeiptr>(static_cast<size_t>(end - shapesUploaded) * shapeBytes);
+    if (useDirectStateAccess) glNamedBufferSubData(meshVBO, offset, bytes, stagedVertices[shapesUploaded]);
+    else {
+        glBindBuffer(GL_ARRAY_BUFFER, meshVBO);
+        glBufferSubData(GL_ARRAY_BUFFER, offset, bytes, stagedVertices[shapesUploaded]);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    bytesUploaded += static_cast<unsigned long long>(bytes);
+    shapesUploaded = end;
+}
+
+// ============================ PER-ROCK CHOICE ============================
+// A component of the rocks seen since the stream started (components.h): the drawn shape, -1 for
+// the rock's own. Its handle check drops the choice of a rock that is gone when the next one takes
+// its slot, and that one's choice reuses the dense entry, so the pool never outgrows the rock slots.
+static ComponentPool<int> rockLooks;
+
+// lowbias32, as the procedural silhouettes' shader hashes
+static uint32_t hashLook(uint32_t x) {
+    x ^= x >> 16; x *= 0x7feb352du;
+    x ^= x >> 15; x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+int drawnAsteroidShape(const AsteroidStore& rocks, size_t i) {
+    const int own = rocks.shapeIndex[i];
+    if (!started) return own;
+    const EntityHandle handle = rocks.handles.handle(i);
+    if (handle.slot >= rockLooks.sparse.size()) {
+        if (handle.slot >= rocks.handles.generation.size()) return own;
+        AllowAllocations grow; // Once per pool size
+        rockLooks.reserve(rocks.handles.generation.size(), rocks.handles.generation.size());
+    }
+    const int* look = rockLooks.get(handle);
+    if (!look) {
+        const uint32_t pick = hashLook((handle.slot + 1) * 0x9E3779B1u + handle.generation) % static_cast<uint32_t>(ASTEROID_SHAPE_COUNT + shapesUploaded);
+        look = &rockLooks.set(handle, pick < static_cast<uint32_t>(ASTEROID_SHAPE_COUNT) ? -1 : static_cast<int>(pick));
+    }
+    return *look < 0 ? own : *look;
+}
+
+const AsteroidMesh& drawnAsteroidMesh(int shape, int lod) {
+    if (shape < ASTEROID_SHAPE_COUNT) return asteroidShapes[static_cast<size_t>(shape)].lods[lod];
+    return streamedMeshes[shape - ASTEROID_SHAPE_COUNT][lod];
+}
+
+void collectShapeStreamMemory(MemoryReport& report) {
+    if (!started) return;
+    report.add("render", "shape stream staging", MEMORY_CPU, sizeof(stagedVertices) + sizeof(streamedMeshes));
+    report.add("render", "shape stream choices", MEMORY_CPU, rockLooks.memoryBytes());
+}
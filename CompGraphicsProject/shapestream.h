@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "simulation.h"
+
+struct MemoryReport;
+
+// Streamed asteroid shapes (on by default in the window, --no-shape-stream turns them off). The mesh
+// atlas keeps SHAPE_STREAM_SLOTS spare shapes after its own. A worker thread fills them in over the
+// session, one every SHAPE_STREAM_INTERVAL_SECONDS, with the same outline and level-of-detail layout
+// as the atlas's shapes (packAsteroidShape) from a stream of its own, into CPU staging; the render
+// thread uploads finished shapes into the spare slots at most SHAPE_STREAM_FRAME_BYTES a frame. A rock
+// picks what it is drawn with the first time the renderer sees it, among the atlas's shapes and the
+// streamed ones uploaded by then, and keeps it for life: spawning never waits on a shape, and a shape
+// never changes under a rock. A picked atlas shape is the rock's own. A streamed shape is scenery,
+// like the procedural silhouettes: hits still test the rock's own outline. Only the batched pass's
+// fans and outlines draw them; SDF quads, resident rocks, the swarm and the legacy path keep the
+// rock's own shape.
+
+// ============================ SHAPE STREAM CONSTANTS ============================
+extern bool useShapeStream; // Reserve the slots and start the worker with the window (--no-shape-stream)
+// Spare slots; with them the atlas still fits the vertex bits of a primitive-restart index
+const int SHAPE_STREAM_SLOTS = 28;
+const double SHAPE_STREAM_INTERVAL_SECONDS = 10.0; // Between new shapes: every slot is full after under five minutes
+const size_t SHAPE_STREAM_FRAME_BYTES = 2048; // Uploaded per frame at most (two shapes)
+const int DRAWN_ASTEROID_SHAPES = ASTEROID_SHAPE_COUNT + SHAPE_STREAM_SLOTS; // Atlas shapes, then streamed ones
+
+// ============================ SHAPE STREAM API ============================
+// Starts the worker; the slots start at atlas vertex `firstVertex` (setupMeshAtlas reserved them)
+void startShapeStream(uint64_t seed, int firstVertex);
+void stopShapeStream(); // Joins the worker (safe to call twice)
+// Uploads the shapes finished since the last call into the atlas buffer, within the frame budget.
+// Render thread only, like the two below.
+void uploadStreamedShapes(unsigned int meshVBO);
+// What rock i is drawn with: its own shape or one of the streamed ones, in [0, DRAWN_ASTEROID_SHAPES)
+int drawnAsteroidShape(const AsteroidStore& rocks, size_t i);
+const AsteroidMesh& drawnAsteroidMesh(int shape, int lod);
+void collectShapeStreamMemory(MemoryReport& report); // Nothing unless started
@@ -0,0 +1,215 @@
+#include "shieldring.h"
+#include "frameconstants.h"
+#include "gldebug.h"
+#include "gpuraster.h"
+#include "glstate.h"
+#include "log.h"
+#include "shaders.h"
+#include "streambuffer.h"
+
+#include <cstddef>
+#include <vector>
+
+#include <glad/glad.h>
+
+// ============================ SHIELD RING STATE ============================
+bool useShieldRing = false;
+
+static unsigned int ringProgram;
+static unsigned int ringVAO; // Instance attributes only: the quad's corners come from gl_VertexID
+static int screenSizeLoc;
+static unsigned int pixelWidth = 0, pixelHeight = 0; // The pixel space (the framebuffer's)
+
+static_assert(sizeof(ShieldRing) == 6 * sizeof(int), "The ring attributes assume a packed ShieldRing");
+
+// ============================ SHADERS ============================
+// The quad reaches two pixels past the radius, so the corner pixels of the outermost points are in
+// it. Its pixel coordinate is interpolated without perspective: at a fragment centre it is the
+// pixel's own plus a half (the same pixel space the point paths map, see gpuraster.cpp).
+static const char* ringVertexShaderSource = R"(
+    #version 330 core
+    layout (location = 0) in ivec3 ring; // cx, cy, radius
+    layout (location = 1) in vec3 ringColor;
+    uniform vec2 screenSize;
+
+    noperspective out vec2 pixel;
+    flat out ivec3 circle;
+    flat out vec3 color;
+
+    void main()
+    {
+        vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0 - 1.0;
+        pixel = vec2(ring.xy) + corner * float(ring.z + 2);
+        circle = ring;
+        color = ringColor;
+        gl_Position = vec4(pixel / (screenSize * 0.5) - 1.0, 0.0, 1.0);
+    }
+)";
+
+static const char* ringFragmentShaderSource = R"(
+    #version 330 core
+)" FRAME_CONSTANTS_GLSL R"(
+    noperspective in vec2 pixel;
+    flat in ivec3 circle;
+    flat in vec3 color;
+
+    out vec4 FragColor;
+
+    // Whether the midpoint walk visits offset p from the centre (see shieldring.h)
+    bool onRing(ivec2 p)
+    {
+        int a = abs(p.x), b = abs(p.y);
+        int x = min(a, b), y = max(a, b);
+        int f = x * x + y * y, r2 = circle.z * circle.z;
+        return (f - y < r2 && r2 <= f + y) || (circle.z == 0 && y == 0);
+    }
+
+    void main()
+    {
+        // A ring point at a pixel corner, drawn 1.5 pixels wide, covers the pixels down and left of it
+        ivec2 p = ivec2(floor(pixel)) - circle.xy;
+        if (!onRing(p) && !onRing(p + ivec2(1, 0)) && !onRing(p + ivec2(0, 1)) && !onRing(p + ivec2(1, 1))) discard;
+        FragColor = vec4(color, 1.0f) * tint;
+    }
+)";
+
+// ============================ SETUP ============================
+void setupShieldRing(unsigned int screenWidth, unsigned int screenHeight)
+{
+    ringProgram = buildProgram("shield ring", ringVertexShaderSource, ringFragmentShaderSource);
+    if (!ringProgram) {
+        LOG_WARN("Shield ring shader failed to build; shields stay on the point rasterizers");
+        useShieldRing = false;
+        return;
+    }
+    bindFrameConstants(ringProgram);
+    screenSizeLoc = glGetUniformLocation(ringProgram, "screenSize");
+    setShieldRingScreenSize(screenWidth, screenHeight);
+
+    // The records are pointed at the stream buffer per draw (bind-to-edit) or through binding 0 (DSA)
+    if (useDirectStateAccess) {
+        glCreateVertexArrays(1, &ringVAO);
+        glVertexArrayAttribIFormat(ringVAO, 0, 3, GL_INT, offsetof(ShieldRing, cx));
+        glVertexArrayAttribFormat(ringVAO, 1, 3, GL_FLOAT, GL_FALSE, offsetof(ShieldRing, color));
+        for (unsigned int attrib = 0; attrib <= 1; ++attrib) {
+            glVertexArrayAttribBinding(ringVAO, attrib, 0);
+            glEnableVertexArrayAttrib(ringVAO, attrib);
+        }
+        glVertexArrayBindingDivisor(ringVAO, 0, 1);
+    }
+    else {
+        glGenVertexArrays(1, &ringVAO);
+        glBindVertexArray(ringVAO);
+        for (unsigned int attrib = 0; attrib <= 1; ++attrib) {
+            glEnableVertexAttribArray(attrib);
+            glVertexAttribDivisor(attrib, 1);
+        }
+        glBindVertexArray(0);
+    }
+    labelGlObject(GL_VERTEX_ARRAY, ringVAO, "shield rings");
+    glState.invalidate();
+}
+
+void setShieldRingScreenSize(unsigned int screenWidth, unsigned int screenHeight)
+{
+    if (!ringProgram) return;
+    pixelWidth = screenWidth;
+    pixelHeight = screenHeight;
+    glState.useProgram(ringProgram);
+    glUniform2f(screenSizeLoc, static_cast<float>(screenWidth), static_cast<float>(screenHeight));
+    glState.useProgram(0);
+}
+
+void destroyShieldRing()
+{
+    glDeleteVertexArrays(1, &ringVAO);
+    glDeleteProgram(ringProgram);
+    ringVAO = ringProgram = 0;
+}
+
+bool shieldRingReady()
+{
+    return ringProgram != 0;
+}
+
+// ============================ DRAWING ============================
+static size_t stagedRings = 0;
+
+bool stageShieldRings(const ShieldRing* rings, size_t count)
+{
+    stagedRings = 0;
+    if (count == 0 || !ringProgram) return false;
+    const size_t offset = streamBuffer.write(rings, count * sizeof(ShieldRing), sizeof(int));
+    if (offset == STREAM_WRITE_FAILED) return false;
+    glState.bindVertexArray(ringVAO);
+    if (useDirectStateAccess) glVertexArrayVertexBuffer(ringVAO, 0, streamBuffer.vbo, static_cast<GLintptr>(offset), sizeof(ShieldRing));
+    else {
+        // write() left the stream buffer bound to GL_ARRAY_BUFFER
+        glVertexAttribIPointer(0, 3, GL_INT, sizeof(ShieldRing), (void*)(offset + offsetof(ShieldRing, cx)));
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(ShieldRing), (void*)(offset + offsetof(ShieldRing, color)));
+    }
+    stagedRings = count;
+    return true;
+}
+
+void drawShieldRings()
+{
+    if (stagedRings == 0) return;
+    glState.useProgram(ringProgram);
+    glState.bindVertexArray(ringVAO);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(stagedRings));
+}
+
+// ============================ VALIDATION CAPTURE ============================
+std::vector<glm::ivec2> captureShieldRing(int cx, int cy, int radius, bool asPoints)
+{
+    std::vector<glm::ivec2> pixels;
+    if (!ringProgram || pixelWidth == 0 || pixelHeight == 0) return pixels;
+    const GLsizei width = static_cast<GLsizei>(pixelWidth), height = static_cast<GLsizei>(pixelHeight);
+
+    // A target the size of the pixel space, cleared, the one shape drawn into it in white
+    GLuint texture = 0, framebuffer = 0, records = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+    glViewport(0, 0, width, height);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glState.setEnabled(GL_BLEND, false);
+
+    if (asPoints) drawGpuMidpointCircle(cx, cy, radius, glm::vec3(1.0f), 1.5f);
+    else {
+        const ShieldRing ring = { cx, cy, radius, glm::vec3(1.0f) };
+        glGenBuffers(1, &records);
+        glBindBuffer(GL_ARRAY_BUFFER, records);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(ring), &ring, GL_STATIC_DRAW);
+        glState.bindVertexArray(ringVAO);
+        if (useDirectStateAccess) glVertexArrayVertexBuffer(ringVAO, 0, records, 0, sizeof(ShieldRing));
+        else {
+            glVertexAttribIPointer(0, 3, GL_INT, sizeof(ShieldRing), (void*)offsetof(ShieldRing, cx));
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(ShieldRing), (void*)offsetof(ShieldRing, color));
+        }
+        glState.useProgram(ringProgram);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, 1);
+    }
+
+    std::vector<unsigned char> texels(static_cast<size_t>(width) * static_cast<size_t>(height));
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RED, GL_UNSIGNED_BYTE, texels.data());
+    for (GLsizei y = 0; y < height; ++y) {
+        for (GLsizei x = 0; x < width; ++x) {
+            if (texels[static_cast<size_t>(y) * static_cast<size_t>(width) + static_cast<size_t>(x)] != 0) pixels.push_back(glm::ivec2(x, y));
+        }
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteTextures(1, &texture);
+    glDeleteBuffers(1, &records);
+    glState.invalidate();
+    return pixels;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Analytic shield rings (--shield-quad): each shield is one quad, and the fragment shader decides
+// whether its pixel is on the ring, so nothing is walked or uploaded per pixel and any number of
+// shields go in one instanced draw (every ship's, with bots). The test is the midpoint walk in
+// closed form: folded into the first octant (x <= y), the walk's y at column x is the largest with
+// x^2 + y^2 - y < r^2, so (x, y) is on it when x^2 + y^2 - y < r^2 <= x^2 + y^2 + y. A pixel is lit
+// when a ring pixel's 1.5-pixel point would cover it (it and the pixels right of and above it are the
+// points' corners), so the ring is the CPU and GPU point paths' pixel for pixel (--validate-raster).
+// Only the instance records (centre, radius, color) are uploaded, into the stream buffer.
+
+// ============================ SHIELD RING STATE ============================
+extern bool useShieldRing; // Draw the shields as quads (off: the point rasterizers, the player's only)
+
+struct ShieldRing {
+    int cx, cy, radius; // Pixels
+    glm::vec3 color;
+};
+
+// ============================ SHIELD RING API ============================
+void setupShieldRing(unsigned int screenWidth, unsigned int screenHeight);
+void destroyShieldRing();
+// Pixel space the quads map to clip space; call when the framebuffer is resized
+void setShieldRingScreenSize(unsigned int screenWidth, unsigned int screenHeight);
+bool shieldRingReady(); // Built, so useShieldRing may be on
+
+// Writes this frame's rings into the stream buffer once (false: none, or no room this frame)...
+bool stageShieldRings(const ShieldRing* rings, size_t count);
+// ... then draws them all in one instanced draw, once per viewport (leaves the ring program bound)
+void drawShieldRings();
+
+// Validation helper: draws one ring alone into an offscreen target the size of the pixel space, as a
+// quad or (asPoints) with the GPU point rasterizer at the shield's point size, and returns the pixels lit
+std::vector<glm::ivec2> captureShieldRing(int cx, int cy, int radius, bool asPoints);
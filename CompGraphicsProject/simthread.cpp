@@ -0,0 +1,380 @@
+#include "simthread.h"
+#include "arena.h"
+#include "replay.h"
+#include "memreport.h"
+#include "trace.h"
+#include "telemetry.h"
+#include "bots.h"
+#include "audio.h"
+#include "loadshed.h"
+#include "threadconfig.h"
+#include "inputlatency.h"
+#include "log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+// ============================ SNAPSHOTS ============================
+bool useSimThread = true;
+std::atomic<int> heatmapLevel(-1);
+
+// The world's effects of the last SNAPSHOT_EFFECT_TICKS captures, each with the capture that took it
+// (whichever thread captures)
+static std::vector<EffectEvent> recentEffects;
+static std::vector<uint64_t> recentEffectCaptures;
+static uint64_t captures = 0, effectCount = 0;
+
+void initSnapshot(RenderSnapshot& snapshot) {
+    snapshot.asteroids.reserve(simulationLimits.asteroidPoolCapacity());
+    snapshot.bullets.reserve(simulationLimits.maxBullets);
+    snapshot.thrusters.reserve(static_cast<size_t>(simulationLimits.ships));
+    snapshot.others.reserve(static_cast<size_t>(simulationLimits.ships));
+    snapshot.otherShieldTimers.reserve(static_cast<size_t>(simulationLimits.ships));
+    const size_t effects = SNAPSHOT_EFFECT_TICKS * world.effectEvents.capacity() / EFFECT_RESERVE_TICKS;
+    snapshot.effects.reserve(effects);
+    recentEffects.reserve(effects);
+    recentEffectCaptures.reserve(effects);
+    snapshot.heatmap.init(world.asteroidGrid);
+}
+
+// Moves the world's new effects into the recent ones (and to the mixer) and drops those too old to be wanted
+static void captureEffects(RenderSnapshot& snapshot) {
+    ++captures;
+    for (const EffectEvent& effect : world.effectEvents) playEffectSound(effect);
+    size_t expired = 0;
+    while (expired < recentEffectCaptures.size() && recentEffectCaptures[expired] + SNAPSHOT_EFFECT_TICKS <= captures) ++expired;
+    recentEffects.erase(recentEffects.begin(), recentEffects.begin() + static_cast<std::ptrdiff_t>(expired));
+    recentEffectCaptures.erase(recentEffectCaptures.begin(), recentEffectCaptures.begin() + static_cast<std::ptrdiff_t>(expired));
+    const size_t room = recentEffects.capacity() - recentEffects.size();
+    const size_t taken = std::min(world.effectEvents.size(), room); // Past the reserve they are dropped, as in the world
+    recentEffects.insert(recentEffects.end(), world.effectEvents.begin(), world.effectEvents.begin() + static_cast<std::ptrdiff_t>(taken));
+    recentEffectCaptures.insert(recentEffectCaptures.end(), taken, captures);
+    effectCount += taken;
+    world.effectEvents.clear();
+    snapshot.effects = recentEffects;
+    snapshot.effectsEnd = effectCount;
+}
+
+void captureSnapshot(RenderSnapshot& snapshot) {
+    captureEffects(snapshot);
+    snapshot.inputStamp = appliedKeyPress();
+    if (arenaMode) {
+        captureArenaView(arena, snapshot.asteroids, snapshot.bullets, snapshot.player);
+        snapshot.shieldActive = arena.shieldActive;
+        snapshot.shieldTimer = arena.shieldTimer;
+        snapshot.isThrusting = arena.isThrusting;
+        snapshot.thrusters.clear();
+        snapshot.others.clear();
+        snapshot.otherShieldTimers.clear();
+        if (arena.isThrusting && !arena.isGameOver) snapshot.thrusters.push_back(snapshot.player);
+        snapshot.isGameOver = arena.isGameOver;
+        setThrustSound(arena.isThrusting && !arena.isGameOver);
+        snapshot.score = arena.score;
+        snapshot.lazyAsteroidMotion = false;
+        snapshot.wrapsAtEdges = false;
+        snapshot.heatmap.level = -1;
+        return;
+    }
+    snapshot.player = world.ships.ship(0);
+    snapshot.shieldActive = world.ships.shieldActive[0] != 0;
+    snapshot.shieldTimer = snapshot.shieldActive ? static_cast<float>(world.ships.shieldEndTick[0] - world.tick) * SIM_DT : 0.0f;
+    snapshot.isThrusting = world.ships.thrusting[0] != 0;
+    snapshot.thrusters.clear();
+    for (size_t s = 0; s < world.ships.count(); ++s) {
+        if (world.ships.alive[s] && world.ships.thrusting[s]) snapshot.thrusters.push_back(world.ships.ship(s));
+    }
+    snapshot.others.clear();
+    snapshot.otherShieldTimers.clear();
+    for (size_t s = 1; s < world.ships.count(); ++s) {
+        if (!world.ships.alive[s]) continue;
+        snapshot.others.push_back(world.ships.ship(s));
+        snapshot.otherShieldTimers.push_back(world.ships.shieldActive[s] ? static_cast<float>(world.ships.shieldEndTick[s] - world.tick) * SIM_DT : 0.0f);
+    }
+    snapshot.isGameOver = world.isGameOver || !world.ships.alive[0];
+    setThrustSound(snapshot.isThrusting && !snapshot.isGameOver);
+    snapshot.score = world.score;
+    snapshot.lazyAsteroidMotion = world.lazyAsteroidMotion;
+    snapshot.asteroids = world.asteroids;
+    snapshot.bullets = world.bullets;
+    // The heatmap the last tick counted (reserved alike, so the copy does not allocate); the level
+    // asked for now takes effect on the next tick
+    if (world.heatmap.level >= 0) snapshot.heatmap = world.heatmap;
+    else snapshot.heatmap.level = -1;
+    world.heatmapLevel = heatmapLevel.load(std::memory_order_relaxed);
+}
+
+// ============================ RESTART ============================
+static std::atomic<bool> restartRequested(false);
+
+bool restartAvailable() {
+    return !arenaMode && !replayActive() && !recordingActive();
+}
+
+void requestRestart() {
+    if (restartAvailable()) restartRequested.store(true, std::memory_order_release);
+}
+
+// The world back to a fresh game on the next seed, if one was asked for since the last tick. The
+// outlines stay the launch's (the atlas and its SDF are on the GPU, and hits test them), so the seed
+// alone does not repeat the game: the log gives the shape seed with it.
+static void serveRestartRequest() {
+    if (!restartRequested.exchange(false, std::memory_order_acq_rel)) return;
+    if (!world.isGameOver && world.ships.alive[0]) return; // Pressed while still playing
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    ++simulationSeed;
+    world.reset();
+    world.seed(simulationSeed);
+    LOG_INFO("Restart: seed %llu (%.3f ms); repeat it with --seed %llu --shape-seed %llu", static_cast<unsigned long long>(simulationSeed),
+             std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(),
+             static_cast<unsigned long long>(simulationSeed), static_cast<unsigned long long>(shapeSeed));
+}
+
+void stepGame(const InputState& input) {
+    if (arenaMode) {
+        stepArena(arena, SIM_DT, input);
+        return;
+    }
+    serveRestartRequest();
+    applyLoadShedding(world);
+    if (botCount > 0 || botPilot) stepWithBots(world, bots, input); // No recording or replay with bots
+    else world.step(SIM_DT, tickInput(input));
+}
+
+// ============================ FAST-FORWARD ============================
+FastForwardConfig fastForward;
+static std::atomic<bool> fastForwarding(false);
+
+void setFastForward(bool on) {
+    if (fastForwarding.exchange(on, std::memory_order_acq_rel) == on) return;
+    if (!on) {
+        LOG_INFO("Fast-forward: off");
+        return;
+    }
+    if (fastForward.ticksPerFrame > 0 && fastForward.budgetMs > 0.0f) {
+        LOG_INFO("Fast-forward: up to %d ticks or %.1f ms per frame", fastForward.ticksPerFrame, fastForward.budgetMs);
+    }
+    else if (fastForward.ticksPerFrame > 0) LOG_INFO("Fast-forward: %d ticks per frame", fastForward.ticksPerFrame);
+    else LOG_INFO("Fast-forward: %.1f ms of ticks per frame", fastForward.budgetMs);
+}
+
+bool fastForwardActive() {
+    return fastForwarding.load(std::memory_order_acquire);
+}
+
+static uint64_t gameTick() {
+    return arenaMode ? arena.tick : world.tick;
+}
+
+int runFastForwardBatch() {
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point start = Clock::now();
+    const Clock::duration budget = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float, std::milli>(fastForward.budgetMs));
+    int ticks = 0;
+    while (fastForwardActive()) {
+        if (fastForward.ticksPerFrame > 0 && ticks >= fastForward.ticksPerFrame) break;
+        if (fastForward.budgetMs > 0.0f && ticks > 0 && Clock::now() - start >= budget) break;
+        stepGame(inputForTick(Clock::now()));
+        ++ticks;
+        const bool gameOver = arenaMode ? arena.isGameOver : world.isGameOver;
+        const bool reached = fastForward.untilTick >= 0 && gameTick() >= static_cast<uint64_t>(fastForward.untilTick);
+        if (gameOver || reached || replayFinished()) {
+            LOG_INFO("Fast-forward stopped at tick %llu (%s)", static_cast<unsigned long long>(gameTick()),
+                     gameOver ? "game over" : (reached ? "target tick" : "end of replay"));
+            setFastForward(false);
+        }
+    }
+    return ticks;
+}
+
+// --- Triple buffer ---
+// The simulation writes one slot, the renderer reads another, and the third holds the newest
+// finished tick. Publishing and acquiring are a single atomic exchange each, so neither side
+// ever waits for the other; the renderer simply skips ticks it was too slow to see.
+static RenderSnapshot snapshots[3];
+static const int SNAPSHOT_FRESH = 4; // Set on the shared index when it holds an unread tick
+static std::atomic<int> sharedSlot(1);
+static int writeSlot = 0;
+static int readSlot = 2;
+
+static void publishSnapshot() {
+    writeSlot = sharedSlot.exchange(writeSlot | SNAPSHOT_FRESH, std::memory_order_acq_rel) & ~SNAPSHOT_FRESH;
+}
+
+const RenderSnapshot& acquireSnapshot() {
+    if (sharedSlot.load(std::memory_order_relaxed) & SNAPSHOT_FRESH) {
+        readSlot = sharedSlot.exchange(readSlot, std::memory_order_acq_rel) & ~SNAPSHOT_FRESH;
+    }
+    return snapshots[readSlot];
+}
+
+// ============================ INPUT EVENTS ============================
+struct InputEvent {
+    uint8_t bit;
+    bool pressed;
+    uint32_t stamp; // A press's latency stamp (0: none)
+    std::chrono::steady_clock::time_point time;
+};
+
+static InputEvent inputEvents[INPUT_EVENT_CAPACITY];
+static std::atomic<unsigned int> inputHead(0); // Next slot the producer writes
+static std::atomic<unsigned int> inputTail(0); // Next slot the consumer reads
+// Producer's view of the held keys; the consumer resyncs to it if events were dropped on overflow
+static std::atomic<unsigned int> liveInputBits(0);
+static std::atomic<bool> inputOverflowed(false);
+static uint8_t heldInputBits = 0; // Consumer only
+
+void pushInputEvent(uint8_t bit, bool pressed, std::chrono::steady_clock::time_point time) {
+    if (pressed) liveInputBits.fetch_or(bit, std::memory_order_relaxed);
+    else liveInputBits.fetch_and(~static_cast<unsigned int>(bit), std::memory_order_relaxed);
+
+    unsigned int head = inputHead.load(std::memory_order_relaxed);
+    if (head - inputTail.load(std::memory_order_acquire) >= static_cast<unsigned int>(INPUT_EVENT_CAPACITY)) {
+        inputOverflowed.store(true, std::memory_order_release);
+        return;
+    }
+    inputEvents[head % INPUT_EVENT_CAPACITY] = { bit, pressed, pressed ? stampKeyPress(time) : 0u, time };
+    inputHead.store(head + 1, std::memory_order_release);
+}
+
+InputState inputForTick(std::chrono::steady_clock::time_point tickTime) {
+    uint8_t tapped = 0; // Pressed during this tick, even if already released again
+    unsigned int tail = inputTail.load(std::memory_order_relaxed);
+    const unsigned int head = inputHead.load(std::memory_order_acquire);
+    for (; tail != head; ++tail) {
+        const InputEvent& event = inputEvents[tail % INPUT_EVENT_CAPACITY];
+        if (event.time > tickTime) break; // Belongs to a later tick
+        if (event.pressed) {
+            heldInputBits |= event.bit;
+            tapped |= event.bit;
+            noteKeyPressApplied(event.stamp);
+        }
+        else {
+            heldInputBits &= ~event.bit;
+        }
+    }
+    inputTail.store(tail, std::memory_order_release);
+    if (inputOverflowed.exchange(false, std::memory_order_acquire)) {
+        heldInputBits = static_cast<uint8_t>(liveInputBits.load(std::memory_order_relaxed));
+    }
+    return unpackInput(heldInputBits | tapped);
+}
+
+InputState heldInputNow() {
+    return unpackInput(static_cast<uint8_t>(liveInputBits.load(std::memory_order_relaxed)));
+}
+
+// ============================ THREAD ============================
+static std::thread simThread;
+static std::atomic<bool> simRunning(false);
+static std::atomic<MemoryReport*> memoryRequest(nullptr); // Set by collectSimulationMemory while it waits
+static std::atomic<bool> simPaused(false);
+const std::chrono::milliseconds SIM_PAUSED_POLL(50); // How often a paused thread looks for work
+const std::chrono::microseconds FAST_FORWARD_POLL(200); // How often a fast-forwarding thread looks for the renderer's next frame
+
+void setSimulationPaused(bool paused) {
+    simPaused.store(paused, std::memory_order_release);
+}
+
+bool simulationPaused() {
+    return simPaused.load(std::memory_order_acquire);
+}
+
+static void collectSimulationMemoryNow(MemoryReport& report) {
+    world.collectMemory(report);
+    collectReplayMemory(report);
+    if (arenaMode) report.add("simulation", "arena", MEMORY_CPU, arena.memoryBytes());
+    if (botCount > 0) report.add("bots", "controller", MEMORY_CPU, bots.memoryBytes());
+    size_t snapshotBytes = 0;
+    for (const RenderSnapshot& snapshot : snapshots) {
+        snapshotBytes += snapshot.asteroids.memoryBytes() + snapshot.bullets.memoryBytes() + snapshot.effects.capacity() * sizeof(EffectEvent);
+    }
+    snapshotBytes += recentEffects.capacity() * sizeof(EffectEvent) + recentEffectCaptures.capacity() * sizeof(uint64_t);
+    report.add("simulation", "render snapshots", MEMORY_CPU, snapshotBytes);
+}
+
+static void serveMemoryRequest() {
+    MemoryReport* report = memoryRequest.load(std::memory_order_acquire);
+    if (!report) return;
+    collectSimulationMemoryNow(*report);
+    memoryRequest.store(nullptr, std::memory_order_release);
+    memoryRequest.notify_all();
+}
+
+void collectSimulationMemory(MemoryReport& report) {
+    if (!simRunning.load(std::memory_order_acquire)) {
+        collectSimulationMemoryNow(report);
+        return;
+    }
+    memoryRequest.store(&report, std::memory_order_release);
+    memoryRequest.wait(&report, std::memory_order_acquire);
+}
+
+static void simThreadLoop() {
+    nameTraceThread("simulation");
+    registerThread(THREAD_SIMULATION);
+    typedef std::chrono::steady_clock Clock;
+    const Clock::duration tickDuration = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(SIM_DT));
+    Clock::time_point nextTick = Clock::now() + tickDuration;
+
+    while (simRunning.load(std::memory_order_acquire)) {
+        serveMemoryRequest();
+        if (replayFinished()) { // Hold the last tick until the render loop closes the window
+            std::this_thread::sleep_for(tickDuration);
+            continue;
+        }
+        if (simulationPaused()) { // Still serves memory requests, at a lower rate
+            std::this_thread::sleep_for(SIM_PAUSED_POLL);
+            nextTick = Clock::now() + tickDuration;
+            continue;
+        }
+        if (fastForwardActive()) {
+            // One batch per rendered frame: wait for the renderer to take the last one, then run the
+            // next while it draws. The clock restarts from here once fast-forward ends.
+            if (sharedSlot.load(std::memory_order_acquire) & SNAPSHOT_FRESH) {
+                std::this_thread::sleep_for(FAST_FORWARD_POLL);
+                continue;
+            }
+            const int ticks = runFastForwardBatch();
+            captureSnapshot(snapshots[writeSlot]);
+            snapshots[writeSlot].tickTime = Clock::now() - tickDuration; // Drawn as it stands, not interpolated
+            publishSnapshot();
+            telemetryAdd(TELEMETRY_TICKS, ticks);
+            nextTick = Clock::now() + tickDuration;
+            continue;
+        }
+        Clock::time_point now = Clock::now();
+        if (now < nextTick) {
+            std::this_thread::sleep_until(nextTick);
+            continue;
+        }
+
+        int ticks = 0;
+        while (now >= nextTick && ticks < SIM_THREAD_MAX_CATCHUP_TICKS) {
+            stepGame(inputForTick(nextTick));
+            captureSnapshot(snapshots[writeSlot]);
+            snapshots[writeSlot].tickTime = nextTick;
+            publishSnapshot();
+            nextTick += tickDuration;
+            ++ticks;
+        }
+        telemetryAdd(TELEMETRY_TICKS, ticks);
+        // Long stall (window drag, breakpoint): drop the backlog instead of fast-forwarding
+        if (ticks == SIM_THREAD_MAX_CATCHUP_TICKS && now >= nextTick) nextTick = now + tickDuration;
+    }
+}
+
+void startSimThread() {
+    for (RenderSnapshot& snapshot : snapshots) {
+        initSnapshot(snapshot);
+        captureSnapshot(snapshot);
+        snapshot.tickTime = std::chrono::steady_clock::now();
+    }
+    simRunning.store(true, std::memory_order_release);
+    simThread = std::thread(simThreadLoop);
+}
+
+void stopSimThread() {
+    if (!simRunning.exchange(false)) return;
+    simThread.join();
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+
+#include "simulation.h"
+
+// Simulation/render pipeline: a worker thread runs the fixed-step simulation on its own clock and
+// publishes a copy of the render-visible state after every tick. The render thread draws the most
+// recent copy, so simulation and GL submission overlap instead of running back to back.
+// Like simulation.h, nothing here depends on GL.
+
+// ============================ RENDER SNAPSHOT ============================
+// The renderer skips the ticks it is too slow to see, but not their effects (EffectEvent): every
+// snapshot carries those of its last SNAPSHOT_EFFECT_TICKS ticks, numbered in the order they
+// happened, and the renderer takes the ones numbered past the last it took.
+const uint64_t SNAPSHOT_EFFECT_TICKS = 16;
+
+// Everything the renderer reads from the simulation, copied once per tick.
+// The stores are reserved to pool capacity, so copying into them never allocates.
+struct RenderSnapshot {
+    Ship player; // Ship 0, the local player's
+    std::vector<Ship> others; // The ships in play after it (bots.h), drawn only by the batched pass
+    std::vector<float> otherShieldTimers; // Per ship in others: its shield's time left (0: down)
+    bool shieldActive = false;
+    float shieldTimer = 0.0f;
+    bool isThrusting = false;
+    std::vector<Ship> thrusters; // Every ship in play with its engine on (ship 0 among them), for the exhaust
+    bool isGameOver = false; // The player's ship is lost (bots may fly on)
+    int score = 0;
+    bool lazyAsteroidMotion = false; // The rocks have no previous tick: they are drawn from their anchors
+    bool wrapsAtEdges = true; // The field is one screen, so rocks across an edge are drawn there too (not in the arena's view)
+    AsteroidStore asteroids; // Current and previous tick (px/py/prot) for interpolation
+    BulletStore bullets;
+    std::vector<EffectEvent> effects; // Numbered [effectsEnd - effects.size(), effectsEnd)
+    uint64_t effectsEnd = 0; // Effects so far
+    std::chrono::steady_clock::time_point tickTime; // When the tick was due on the simulation clock
+    uint32_t inputStamp = 0; // Newest key press the ticks so far have applied (inputlatency.h)
+    BroadphaseHeatmap heatmap; // The last tick's, of grid level heatmapLevel, while it is shown (broadphaseview.h)
+};
+
+// Grid level the snapshots carry a heatmap of (-1: none), set by the thread polling keys
+extern std::atomic<int> heatmapLevel;
+
+void initSnapshot(RenderSnapshot& snapshot);
+void captureSnapshot(RenderSnapshot& snapshot); // Copies the game's world, or the arena's view (simulating thread only)
+// One tick of whichever the game is playing: the world (through the replay's tickInput) or the arena
+void stepGame(const InputState& input);
+
+// ============================ RESTART ============================
+// Plays again after game over without leaving the window (Enter). Before its next tick the simulating
+// thread resets the world in place (the pools emptied by their counts, every capacity kept) and seeds
+// it with the next seed, which it logs so the game can be played again with --seed. Nothing on the
+// GPU is rebuilt: the resident stores and the trails see the new entities by their handles' generations.
+// Not for the arena, a replay or a recording (each is one game).
+bool restartAvailable();
+void requestRestart(); // From the thread polling keys; dropped unless the game is over by the next tick
+
+// ============================ SIMULATION THREAD ============================
+extern bool useSimThread; // Off with --single-thread: tick on the main thread as before
+
+const int SIM_THREAD_MAX_CATCHUP_TICKS = 8; // Ticks run back to back after a stall before dropping the backlog
+
+void startSimThread();
+void stopSimThread();
+// While paused (window minimized or unfocused) no ticks run in either thread mode, and the simulation
+// clock restarts on resume instead of catching up on the time away
+void setSimulationPaused(bool paused);
+bool simulationPaused();
+const RenderSnapshot& acquireSnapshot();     // Newest published tick; stays valid until the next call
+// Adds the world, the replay and the snapshots to the report. With the simulation thread running it
+// collects them between two ticks, so the caller waits up to a tick.
+void collectSimulationMemory(MemoryReport& report);
+
+// ============================ FAST-FORWARD ============================
+// For QA and late-game profiling: instead of ticking with the clock, each rendered frame runs a batch
+// of ticks back to back (ticksPerFrame of them, or as many as fit in budgetMs, whichever limit comes
+// first) and the renderer is handed only the batch's last tick. The keys still reach the ship, but
+// at that speed it is better flown by --autopilot or driven by a --replay. Stops by itself at
+// untilTick, at game over and at the end of a replay; A toggles it. Works in either thread mode.
+struct FastForwardConfig {
+    int ticksPerFrame = 60; // 0: no tick limit (budgetMs must be set)
+    float budgetMs = 0.0f; // 0: no time limit
+    long long untilTick = -1; // Back to real time on reaching this game tick (-1: never)
+};
+extern FastForwardConfig fastForward;
+
+void setFastForward(bool on);
+bool fastForwardActive();
+// One batch of ticks, not yet captured (the simulating thread only); returns how many ran
+int runFastForwardBatch();
+
+// ============================ INPUT EVENTS ============================
+// Game keys arrive as timestamped press/release events (from the GLFW key callback) in a
+// single-producer, single-consumer queue. Each tick applies the events that happened before it was
+// due, so a key acts on the first tick after it was pressed rather than on the next rendered frame,
+// and a tap shorter than a tick still counts for one tick. The simulation never touches GLFW.
+const int INPUT_EVENT_CAPACITY = 256;
+
+// Producer side (the thread that polls GLFW events); `bit` is one of INPUT_LEFT ... INPUT_SHIELD
+void pushInputEvent(uint8_t bit, bool pressed, std::chrono::steady_clock::time_point time);
+// Consumer side (the simulation thread, or the main thread with --single-thread): the keys for the
+// tick due at `tickTime`
+InputState inputForTick(std::chrono::steady_clock::time_point tickTime);
+// Any thread: the keys held as the producer last saw them, ahead of every tick (the late latch's input)
+InputState heldInputNow();
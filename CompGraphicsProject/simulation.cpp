@@ -0,0 +1,2784 @@
+#include "simulation.h"
+#include "profiler.h"
+#include "log.h"
+#include "random.h"
+#include "collision.h"
+#include "scenario.h"
+#include "jobs.h"
+#include "memreport.h"
+#include "fixedpoint.h"
+#include "fastmath.h"
+#include "waves.h"
+#include "spatialquery.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <bit>
+
+#include <glm/gtc/constants.hpp>
+
+// SIMD: AVX when the compiler targets it (/arch:AVX2), otherwise SSE2 (always present on x64)
+#if defined(__AVX__)
+#include <immintrin.h>
+#define SIM_SIMD_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SIM_SIMD_SSE2 1
+#endif
+
+const float FRICTION_PER_TICK = std::pow(FRICTION, 60.0f * SIM_DT);
+// Rounded once from the float value (65371.96 steps): far enough from a rounding boundary that
+// whatever last bit libm's pow gets wrong, every build gets the same constant
+const int32_t FIXED_FRICTION_PER_TICK = toFixed(FRICTION_PER_TICK);
+
+// ============================ SHARED STATE ============================
+// Read-only once the game starts, so every world can use it
+std::vector<AsteroidShape> asteroidShapes;
+const glm::vec3 asteroidPalette[ASTEROID_PALETTE_SIZE] = {
+    glm::vec3(1.0f, 0.4f, 0.0f),  // Orange
+    glm::vec3(0.0f, 0.8f, 0.8f),  // Cyan
+    glm::vec3(0.8f, 0.0f, 0.8f),  // Magenta
+    glm::vec3(1.0f, 1.0f, 0.0f),  // Yellow
+    glm::vec3(0.1f, 1.0f, 0.1f)   // Green
+};
+SimulationLimits simulationLimits;
+
+GameWorld world;
+
+// ============================ JOB GRAIN SIZES ============================
+// Entities per job: large enough that the game's own counts (a few dozen) never leave the calling
+// thread. Integration chunks are a multiple of 8, so the SIMD/scalar split is that of one whole pass.
+const size_t INTEGRATION_GRAIN = 4096;
+const size_t BULLET_COLLISION_GRAIN = 256; // Rocks per hit-search job
+const size_t GRID_BUILD_GRAIN = 4096; // Entities per counting-sort chunk
+const size_t SWEEP_PAIR_GRAIN = 512; // Sorted rocks per sweep-and-prune pair-search job
+const size_t KINETIC_PREDICTION_GRAIN = 64; // Bullets per prediction job (a new one is tested against every rock)
+
+// ============================ SIMD INTEGRATION KERNELS ============================
+// p[i] += v[i] * dt
+void integrateLinear(float* p, const float* v, size_t n, float dt) {
+    size_t i = 0;
+#if defined(SIM_SIMD_AVX)
+    __m256 dt8 = _mm256_set1_ps(dt);
+    for (; i + 8 <= n; i += 8) {
+        __m256 pv = _mm256_add_ps(_mm256_loadu_ps(p + i), _mm256_mul_ps(_mm256_loadu_ps(v + i), dt8));
+        _mm256_storeu_ps(p + i, pv);
+    }
+#elif defined(SIM_SIMD_SSE2)
+    __m128 dt4 = _mm_set1_ps(dt);
+    for (; i + 4 <= n; i += 4) {
+        __m128 pv = _mm_add_ps(_mm_loadu_ps(p + i), _mm_mul_ps(_mm_loadu_ps(v + i), dt4));
+        _mm_storeu_ps(p + i, pv);
+    }
+#endif
+    for (; i < n; ++i) p[i] += v[i] * dt;
+}
+
+// p[i] += v[i] * dt, then wrap the result across the [-1,1] playfield edges
+void integrateWrap(float* p, const float* v, size_t n, float dt) {
+    size_t i = 0;
+#if defined(SIM_SIMD_AVX)
+    __m256 dt8 = _mm256_set1_ps(dt);
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 minusOne = _mm256_set1_ps(-1.0f);
+    for (; i + 8 <= n; i += 8) {
+        __m256 pv = _mm256_add_ps(_mm256_loadu_ps(p + i), _mm256_mul_ps(_mm256_loadu_ps(v + i), dt8));
+        __m256 over = _mm256_cmp_ps(pv, one, _CMP_GT_OQ);
+        __m256 under = _mm256_cmp_ps(pv, minusOne, _CMP_LT_OQ);
+        pv = _mm256_blendv_ps(pv, one, under);
+        pv = _mm256_blendv_ps(pv, minusOne, over);
+        _mm256_storeu_ps(p + i, pv);
+    }
+#elif defined(SIM_SIMD_SSE2)
+    __m128 dt4 = _mm_set1_ps(dt);
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 minusOne = _mm_set1_ps(-1.0f);
+    for (; i + 4 <= n; i += 4) {
+        __m128 pv = _mm_add_ps(_mm_loadu_ps(p + i), _mm_mul_ps(_mm_loadu_ps(v + i), dt4));
+        __m128 over = _mm_cmpgt_ps(pv, one);
+        __m128 under = _mm_cmplt_ps(pv, minusOne);
+        pv = _mm_or_ps(_mm_andnot_ps(under, pv), _mm_and_ps(under, one));
+        pv = _mm_or_ps(_mm_andnot_ps(over, pv), _mm_and_ps(over, minusOne));
+        _mm_storeu_ps(p + i, pv);
+    }
+#endif
+    for (; i < n; ++i) {
+        float pv = p[i] + v[i] * dt;
+        if (pv > 1.0f) pv = -1.0f;
+        else if (pv < -1.0f) pv = 1.0f;
+        p[i] = pv;
+    }
+}
+
+// v[i] *= factor
+void dampVelocity(float* v, size_t n, float factor) {
+    size_t i = 0;
+#if defined(SIM_SIMD_AVX)
+    __m256 factor8 = _mm256_set1_ps(factor);
+    for (; i + 8 <= n; i += 8) _mm256_storeu_ps(v + i, _mm256_mul_ps(_mm256_loadu_ps(v + i), factor8));
+#elif defined(SIM_SIMD_SSE2)
+    __m128 factor4 = _mm_set1_ps(factor);
+    for (; i + 4 <= n; i += 4) _mm_storeu_ps(v + i, _mm_mul_ps(_mm_loadu_ps(v + i), factor4));
+#endif
+    for (; i < n; ++i) v[i] *= factor;
+}
+
+// Homing: d = the target's offset wrapped like wrappedDelta, v += d * (pull * accel / |d|), then v
+// scaled down to maxSpeed if faster. The lanes do the scalar tail's operations in its order, the
+// wrap's zero adds included, so a missile steers to the same bits whichever loop it falls in.
+const float MISSILE_MIN_DISTANCE = 1e-4f; // Below this the target counts as reached (no division by zero)
+
+void steerMissiles(float* vx, float* vy, const float* x, const float* y, const float* tx, const float* ty, const float* pull,
+                   size_t n, float accel, float maxSpeed) {
+    size_t i = 0;
+#if defined(SIM_SIMD_AVX)
+    const __m256 one = _mm256_set1_ps(1.0f), minusOne = _mm256_set1_ps(-1.0f), width = _mm256_set1_ps(FIELD_WIDTH);
+    const __m256 accel8 = _mm256_set1_ps(accel), maxSpeed8 = _mm256_set1_ps(maxSpeed), minDistance = _mm256_set1_ps(MISSILE_MIN_DISTANCE);
+    for (; i + 8 <= n; i += 8) {
+        __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(tx + i), _mm256_loadu_ps(x + i));
+        __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(ty + i), _mm256_loadu_ps(y + i));
+        dx = _mm256_add_ps(_mm256_sub_ps(dx, _mm256_and_ps(_mm256_cmp_ps(dx, one, _CMP_GT_OQ), width)), _mm256_and_ps(_mm256_cmp_ps(dx, minusOne, _CMP_LT_OQ), width));
+        dy = _mm256_add_ps(_mm256_sub_ps(dy, _mm256_and_ps(_mm256_cmp_ps(dy, one, _CMP_GT_OQ), width)), _mm256_and_ps(_mm256_cmp_ps(dy, minusOne, _CMP_LT_OQ), width));
+        const __m256 distance = _mm256_max_ps(_mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy))), minDistance);
+        const __m256 k = _mm256_div_ps(_mm256_mul_ps(_mm256_loadu_ps(pull + i), accel8), distance);
+        __m256 ux = _mm256_add_ps(_mm256_loadu_ps(vx + i), _mm256_mul_ps(dx, k));
+        __m256 uy = _mm256_add_ps(_mm256_loadu_ps(vy + i), _mm256_mul_ps(dy, k));
+        const __m256 speed = _mm256_max_ps(_mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(ux, ux), _mm256_mul_ps(uy, uy))), minDistance);
+        const __m256 scale = _mm256_min_ps(_mm256_div_ps(maxSpeed8, speed), one);
+        _mm256_storeu_ps(vx + i, _mm256_mul_ps(ux, scale));
+        _mm256_storeu_ps(vy + i, _mm256_mul_ps(uy, scale));
+    }
+#elif defined(SIM_SIMD_SSE2)
+    const __m128 one = _mm_set1_ps(1.0f), minusOne = _mm_set1_ps(-1.0f), width = _mm_set1_ps(FIELD_WIDTH);
+    const __m128 accel4 = _mm_set1_ps(accel), maxSpeed4 = _mm_set1_ps(maxSpeed), minDistance = _mm_set1_ps(MISSILE_MIN_DISTANCE);
+    for (; i + 4 <= n; i += 4) {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(tx + i), _mm_loadu_ps(x + i));
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(ty + i), _mm_loadu_ps(y + i));
+        dx = _mm_add_ps(_mm_sub_ps(dx, _mm_and_ps(_mm_cmpgt_ps(dx, one), width)), _mm_and_ps(_mm_cmplt_ps(dx, minusOne), width));
+        dy = _mm_add_ps(_mm_sub_ps(dy, _mm_and_ps(_mm_cmpgt_ps(dy, one), width)), _mm_and_ps(_mm_cmplt_ps(dy, minusOne), width));
+        const __m128 distance = _mm_max_ps(_mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy))), minDistance);
+        const __m128 k = _mm_div_ps(_mm_mul_ps(_mm_loadu_ps(pull + i), accel4), distance);
+        __m128 ux = _mm_add_ps(_mm_loadu_ps(vx + i), _mm_mul_ps(dx, k));
+        __m128 uy = _mm_add_ps(_mm_loadu_ps(vy + i), _mm_mul_ps(dy, k));
+        const __m128 speed = _mm_max_ps(_mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(ux, ux), _mm_mul_ps(uy, uy))), minDistance);
+        const __m128 scale = _mm_min_ps(_mm_div_ps(maxSpeed4, speed), one);
+        _mm_storeu_ps(vx + i, _mm_mul_ps(ux, scale));
+        _mm_storeu_ps(vy + i, _mm_mul_ps(uy, scale));
+    }
+#endif
+    for (; i < n; ++i) {
+        float dx = tx[i] - x[i], dy = ty[i] - y[i];
+        dx = (dx - (dx > 1.0f ? FIELD_WIDTH : 0.0f)) + (dx < -1.0f ? FIELD_WIDTH : 0.0f);
+        dy = (dy - (dy > 1.0f ? FIELD_WIDTH : 0.0f)) + (dy < -1.0f ? FIELD_WIDTH : 0.0f);
+        const float k = pull[i] * accel / std::max(std::sqrt(dx * dx + dy * dy), MISSILE_MIN_DISTANCE);
+        const float ux = vx[i] + dx * k, uy = vy[i] + dy * k;
+        const float scale = std::min(maxSpeed / std::max(std::sqrt(ux * ux + uy * uy), MISSILE_MIN_DISTANCE), 1.0f);
+        vx[i] = ux * scale;
+        vy[i] = uy * scale;
+    }
+}
+
+// Q16.16 integration: p[i] += v[i] * dt in integer lanes, then the wrap (WRAP_NONE, WRAP_FIELD as
+// integrateWrap, WRAP_ANGLE into [0, 2 pi)). The product fits 32 bits for any speed under 60.
+enum FixedWrap { WRAP_NONE, WRAP_FIELD, WRAP_ANGLE };
+
+template <FixedWrap Wrap>
+static void integrateFixed(float* p, float* v, size_t n, int32_t dt) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256 toQ = _mm256_set1_ps(static_cast<float>(FIXED_ONE));
+    const __m256 fromQ = _mm256_set1_ps(1.0f / static_cast<float>(FIXED_ONE));
+    const __m256i dt8 = _mm256_set1_epi32(dt);
+    const __m256i half = _mm256_set1_epi32(FIXED_ONE >> 1);
+    const __m256i one = _mm256_set1_epi32(FIXED_ONE);
+    const __m256i minusOne = _mm256_set1_epi32(-FIXED_ONE);
+    const __m256i turn = _mm256_set1_epi32(FIXED_TWO_PI);
+    const __m256i zero = _mm256_setzero_si256();
+    for (; i + 8 <= n; i += 8) {
+        __m256i vq = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(v + i), toQ));
+        __m256i pq = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(p + i), toQ));
+        pq = _mm256_add_epi32(pq, _mm256_srai_epi32(_mm256_add_epi32(_mm256_mullo_epi32(vq, dt8), half), FIXED_FRACTION_BITS));
+        if constexpr (Wrap == WRAP_FIELD) {
+            __m256i over = _mm256_cmpgt_epi32(pq, one);
+            __m256i under = _mm256_cmpgt_epi32(minusOne, pq);
+            pq = _mm256_blendv_epi8(pq, one, under);
+            pq = _mm256_blendv_epi8(pq, minusOne, over);
+        }
+        else if constexpr (Wrap == WRAP_ANGLE) {
+            pq = _mm256_sub_epi32(pq, _mm256_andnot_si256(_mm256_cmpgt_epi32(turn, pq), turn)); // >= 2 pi
+            pq = _mm256_add_epi32(pq, _mm256_and_si256(_mm256_cmpgt_epi32(zero, pq), turn));    // < 0
+        }
+        _mm256_storeu_ps(p + i, _mm256_mul_ps(_mm256_cvtepi32_ps(pq), fromQ));
+        _mm256_storeu_ps(v + i, _mm256_mul_ps(_mm256_cvtepi32_ps(vq), fromQ));
+    }
+#endif
+    for (; i < n; ++i) {
+        const int32_t vq = toFixed(v[i]);
+        int32_t pq = toFixed(p[i]) + fixedMul(vq, dt);
+        if constexpr (Wrap == WRAP_FIELD) {
+            if (pq > FIXED_ONE) pq = -FIXED_ONE;
+            else if (pq < -FIXED_ONE) pq = FIXED_ONE;
+        }
+        else if constexpr (Wrap == WRAP_ANGLE) {
+            if (pq >= FIXED_TWO_PI) pq -= FIXED_TWO_PI;
+            else if (pq < 0) pq += FIXED_TWO_PI;
+        }
+        p[i] = fromFixed(pq);
+        v[i] = fromFixed(vq);
+    }
+}
+
+void integrateLinearFixed(float* p, float* v, size_t n, int32_t dt) { integrateFixed<WRAP_NONE>(p, v, n, dt); }
+void integrateWrapFixed(float* p, float* v, size_t n, int32_t dt) { integrateFixed<WRAP_FIELD>(p, v, n, dt); }
+void integrateAngleFixed(float* p, float* v, size_t n, int32_t dt) { integrateFixed<WRAP_ANGLE>(p, v, n, dt); }
+
+// The product needs 64 bits (the factor is close to one), which the 32-bit lanes above do not have
+void dampVelocityFixed(float* v, size_t n, int32_t factor) {
+    for (size_t i = 0; i < n; ++i) v[i] = fromFixed(fixedMul(toFixed(v[i]), factor));
+}
+
+// ============================ SPATIAL HASH BROADPHASE ============================
+float maxBulletTravelPerTick() {
+    float terminalShipSpeed = THRUST_SPEED * SIM_DT * FRICTION_PER_TICK / (1.0f - FRICTION_PER_TICK);
+    return (BULLET_SPEED + terminalShipSpeed + MAX_ASTEROID_SPEED) * SIM_DT;
+}
+
+float getAsteroidCellSize(AsteroidSize size) {
+    // A rock meets rocks of its own class or smaller here; the larger ones find it from their own
+    // level. The ship's wider reach is covered by visiting more rings (forEachWithin).
+    return 2.0f * getRadiusFactor(size);
+}
+
+float getBulletCellSize(AsteroidSize size) {
+    // Bullets are tested along the segment they covered this tick, so a bullet can hit a rock up
+    // to one tick of travel away from where it ends up. Fastest bullet: BULLET_SPEED on top of the
+    // ship's terminal speed (thrust balanced by friction), plus the rock's own drift. The reach is to
+    // the rock's widest outline point, so either hit test finds its bullets.
+    return getRadiusFactor(size) * ASTEROID_MAX_OUTLINE_RADIUS + Bullet().radius + maxBulletTravelPerTick();
+}
+
+float getGridCellSize() {
+    return std::max({ getAsteroidCellSize(LARGE), getRadiusFactor(LARGE) * ASTEROID_MAX_OUTLINE_RADIUS + SHIELD_RADIUS_FACTOR, getBulletCellSize(LARGE) });
+}
+
+void SpatialGrid::init(float minCellSize, size_t capacity) {
+    dim = std::max(3, static_cast<int>(2.0f / minCellSize));
+    cellSize = 2.0f / dim;
+    const size_t cellCount = static_cast<size_t>(dim * dim);
+    cellStart.assign(cellCount + 1, 0);
+    occupied.assign((cellCount + 63) / 64, 0);
+    occupiedCells = 0;
+    entries.assign(capacity, 0);
+    entityCell.assign(capacity, 0);
+    chunkOffsets.assign((capacity / GRID_BUILD_GRAIN + 1) * cellCount, 0);
+}
+
+void SpatialGrid::build(const float* x, const float* y, size_t n, JobCounter* dependency) {
+    const size_t cellCount = static_cast<size_t>(dim * dim);
+    const size_t chunkCount = (n + GRID_BUILD_GRAIN - 1) / GRID_BUILD_GRAIN;
+    if (entries.size() < n) { // Only if the pool outgrew init's capacity
+        entries.resize(n);
+        entityCell.resize(n);
+    }
+    if (chunkOffsets.size() < chunkCount * cellCount) chunkOffsets.resize(chunkCount * cellCount);
+
+    // Pass 1: each chunk counts its entities per cell (and remembers each one's cell)
+    JobCounter counted;
+    auto countChunks = [&](size_t first, size_t last) {
+        for (size_t c = first; c < last; ++c) {
+            int* counts = chunkOffsets.data() + c * cellCount;
+            std::fill(counts, counts + cellCount, 0);
+            const size_t end = std::min(n, (c + 1) * GRID_BUILD_GRAIN);
+            for (size_t i = c * GRID_BUILD_GRAIN; i < end; ++i) {
+                int cell = cellCoord(y[i]) * dim + cellCoord(x[i]);
+                entityCell[i] = cell;
+                ++counts[cell];
+            }
+        }
+    };
+    parallelForAsync(0, chunkCount, 1, countChunks, counted, dependency);
+    waitForJobs(counted);
+
+    // Prefix sum, cell-major then chunk: chunk c's run of a cell follows the runs of chunks before
+    // it, so every cell lists its entities in ascending index order, as serial insertion would
+    int running = 0;
+    std::fill(occupied.begin(), occupied.end(), 0);
+    occupiedCells = 0;
+    for (size_t cell = 0; cell < cellCount; ++cell) {
+        cellStart[cell] = running;
+        for (size_t c = 0; c < chunkCount; ++c) {
+            int count = chunkOffsets[c * cellCount + cell];
+            chunkOffsets[c * cellCount + cell] = running;
+            running += count;
+        }
+        if (running != cellStart[cell]) {
+            occupied[cell >> 6] |= uint64_t(1) << (cell & 63);
+            ++occupiedCells;
+        }
+    }
+    cellStart[cellCount] = running;
+
+    // Pass 2: each chunk scatters its indices into its own runs
+    parallelFor(0, chunkCount, 1, [&](size_t first, size_t last) {
+        for (size_t c = first; c < last; ++c) {
+            int* offsets = chunkOffsets.data() + c * cellCount;
+            const size_t end = std::min(n, (c + 1) * GRID_BUILD_GRAIN);
+            for (size_t i = c * GRID_BUILD_GRAIN; i < end; ++i) entries[offsets[entityCell[i]]++] = static_cast<int>(i);
+        }
+    });
+}
+
+void HierarchicalGrid::init(size_t capacity) {
+    for (int k = 0; k < ASTEROID_SIZE_COUNT; ++k) {
+        levels[k].init(getAsteroidCellSize(static_cast<AsteroidSize>(k)), capacity);
+        levels[k].entityCell.clear(); // The shared arrays below serve every level
+        levels[k].chunkOffsets.clear();
+        cellBase[k + 1] = cellBase[k] + levels[k].dim * levels[k].dim;
+    }
+    entityCell.assign(capacity, 0);
+    chunkOffsets.assign((capacity / GRID_BUILD_GRAIN + 1) * static_cast<size_t>(cellBase[ASTEROID_SIZE_COUNT]), 0);
+}
+
+// SpatialGrid::build's counting sort, with each rock's cell taken in the level of its class
+void HierarchicalGrid::build(const float* x, const float* y, const AsteroidSize* sizeClass, size_t n, JobCounter* dependency) {
+    const size_t cellCount = static_cast<size_t>(cellBase[ASTEROID_SIZE_COUNT]);
+    const size_t chunkCount = (n + GRID_BUILD_GRAIN - 1) / GRID_BUILD_GRAIN;
+    if (entityCell.size() < n) {
+        entityCell.resize(n);
+        for (SpatialGrid& level : levels) level.entries.resize(n);
+    }
+    if (chunkOffsets.size() < chunkCount * cellCount) chunkOffsets.resize(chunkCount * cellCount);
+
+    JobCounter counted;
+    auto countChunks = [&](size_t first, size_t last) {
+        for (size_t c = first; c < last; ++c) {
+            int* counts = chunkOffsets.data() + c * cellCount;
+            std::fill(counts, counts + cellCount, 0);
+            const size_t end = std::min(n, (c + 1) * GRID_BUILD_GRAIN);
+            for (size_t i = c * GRID_BUILD_GRAIN; i < end; ++i) {
+                const SpatialGrid& level = levels[sizeClass[i]];
+                int cell = cellBase[sizeClass[i]] + level.cellCoord(y[i]) * level.dim + level.cellCoord(x[i]);
+                entityCell[i] = cell;
+                ++counts[cell];
+            }
+        }
+    };
+    parallelForAsync(0, chunkCount, 1, countChunks, counted, dependency);
+    waitForJobs(counted);
+
+    // Each level's runs are numbered from zero in its own entries
+    for (int k = 0; k < ASTEROID_SIZE_COUNT; ++k) {
+        SpatialGrid& level = levels[k];
+        int running = 0;
+        std::fill(level.occupied.begin(), level.occupied.end(), 0);
+        level.occupiedCells = 0;
+        for (int cell = cellBase[k]; cell < cellBase[k + 1]; ++cell) {
+            const int local = cell - cellBase[k];
+            level.cellStart[local] = running;
+            for (size_t c = 0; c < chunkCount; ++c) {
+                int count = chunkOffsets[c * cellCount + cell];
+                chunkOffsets[c * cellCount + cell] = running;
+                running += count;
+            }
+            if (running != level.cellStart[local]) {
+                level.occupied[local >> 6] |= uint64_t(1) << (local & 63);
+                ++level.occupiedCells;
+            }
+        }
+        level.cellStart[cellBase[k + 1] - cellBase[k]] = running;
+        levelStart[k + 1] = levelStart[k] + running;
+    }
+
+    parallelFor(0, chunkCount, 1, [&](size_t first, size_t last) {
+        for (size_t c = first; c < last; ++c) {
+            int* offsets = chunkOffsets.data() + c * cellCount;
+            const size_t end = std::min(n, (c + 1) * GRID_BUILD_GRAIN);
+            for (size_t i = c * GRID_BUILD_GRAIN; i < end; ++i) levels[sizeClass[i]].entries[offsets[entityCell[i]]++] = static_cast<int>(i);
+        }
+    });
+}
+
+// ============================ SWEEP AND PRUNE ============================
+static const char* const BROADPHASE_NAMES[] = { "grid", "sap", "brute" };
+
+const char* broadphaseName(AsteroidBroadphase broadphase) {
+    return BROADPHASE_NAMES[broadphase];
+}
+
+bool parseBroadphase(const char* name, AsteroidBroadphase& broadphase) {
+    for (int i = 0; i <= BROADPHASE_BRUTE_FORCE; ++i) {
+        if (std::strcmp(name, BROADPHASE_NAMES[i]) == 0) {
+            broadphase = static_cast<AsteroidBroadphase>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+void SweepAndPrune::init(float reach, size_t capacity) {
+    queryReach = reach;
+    maxRadius = 0.0f;
+    entries.clear();
+    entries.reserve(capacity);
+    trackedGeneration.assign(capacity, 0);
+}
+
+void SweepAndPrune::update(const float* x, const float* y, const AsteroidSize* sizeClass, const HandleTable& handles, size_t n) {
+    // Survivors keep their place in the order; their index and extent are refreshed
+    maxRadius = 0.0f;
+    size_t kept = 0;
+    for (const SweepEntry& entry : entries) {
+        long long i = handles.resolve(entry.handle);
+        if (i < 0) continue; // Removed since the last update
+        entries[kept] = entry;
+        entries[kept].index = static_cast<int>(i);
+        const float radius = getRadiusFactor(sizeClass[i]);
+        entries[kept].min = x[i] - radius;
+        entries[kept].x = x[i];
+        entries[kept].y = y[i];
+        maxRadius = std::max(maxRadius, radius);
+        ++kept;
+    }
+    entries.resize(kept);
+
+    // Entities spawned since then go on the end
+    for (size_t i = 0; i < n; ++i) {
+        EntityHandle handle = handles.handle(i);
+        if (trackedGeneration[handle.slot] == handle.generation + 1) continue;
+        trackedGeneration[handle.slot] = handle.generation + 1;
+        const float radius = getRadiusFactor(sizeClass[i]);
+        entries.push_back({ x[i] - radius, x[i], y[i], static_cast<int>(i), handle });
+        maxRadius = std::max(maxRadius, radius);
+    }
+
+    // Insertion sort: each entry moves back past the few it overtook. Only when most entries are new
+    // (the first update, a scenario filling its field) is a full sort cheaper.
+    if (entries.size() - kept > kept) {
+        std::sort(entries.begin(), entries.end(), [](const SweepEntry& a, const SweepEntry& b) {
+            return a.min < b.min || (a.min == b.min && a.index < b.index);
+        });
+        return;
+    }
+    for (size_t k = 1; k < entries.size(); ++k) {
+        SweepEntry entry = entries[k];
+        size_t slot = k;
+        while (slot > 0 && entries[slot - 1].min > entry.min) {
+            entries[slot] = entries[slot - 1];
+            --slot;
+        }
+        entries[slot] = entry;
+    }
+}
+
+// ============================ ASTEROID VERTEX GENERATION ============================
+std::vector<float> generateFilledAsteroidVertices(int segments, float radius) {
+    std::vector<float> vertices(static_cast<size_t>(2 * (segments + 2)));
+    generateFilledAsteroidVertices(segments, radius, shapeRng, vertices.data());
+    return vertices;
+}
+
+void generateFilledAsteroidVertices(int segments, float radius, Rng& rng, float* vertices) {
+    vertices[0] = 0.0f; // Center point (Index 0 for TRIANGLE_FAN)
+    vertices[1] = 0.0f;
+
+    // The boundary's directions a block at a time (fastSinCosBatch), then its radii in order
+    const int BLOCK = 64;
+    float angles[BLOCK], sines[BLOCK], cosines[BLOCK];
+    for (int first = 0; first < segments; first += BLOCK) {
+        const int count = std::min(BLOCK, segments - first);
+        for (int k = 0; k < count; ++k) angles[k] = (float)(first + k) / (float)segments * 2.0f * glm::pi<float>();
+        fastSinCosBatch(angles, static_cast<size_t>(count), sines, cosines);
+
+        for (int k = 0; k < count; ++k) {
+            const int i = first + k;
+            // Add irregularity (radius factor between 0.8 and 1.2)
+            float currentRadius = radius * (1.0f + (rng.uniform() - 0.5f) * 0.4f);
+
+            vertices[2 + 2 * i] = currentRadius * cosines[k];
+            vertices[3 + 2 * i] = currentRadius * sines[k];
+        }
+    }
+    // Close the fan on the first boundary point, so the outline has no seam
+    vertices[2 + 2 * segments] = vertices[2];
+    vertices[3 + 2 * segments] = vertices[3];
+}
+
+void packAsteroidShape(const float* fillVertices, int baseVertex, float* vertices, AsteroidShape& shape) {
+    const int finestSegments = ASTEROID_LOD_SEGMENTS[ASTEROID_LOD_COUNT - 1];
+    for (int lod = 0; lod < ASTEROID_LOD_COUNT; ++lod) {
+        const int segments = ASTEROID_LOD_SEGMENTS[lod];
+        const int stride = finestSegments / segments;
+
+        // The vertex count is for GL_TRIANGLE_FAN (includes center + boundary)
+        AsteroidMesh& mesh = shape.lods[lod];
+        mesh.baseVertex = baseVertex;
+        mesh.vertexCount = segments + 2;
+        baseVertex += mesh.vertexCount;
+
+        *vertices++ = 0.0f;
+        *vertices++ = 0.0f;
+        for (int i = 0; i <= segments; ++i) {
+            const size_t source = static_cast<size_t>(1 + i * stride) * 2;
+            *vertices++ = fillVertices[source];
+            *vertices++ = fillVertices[source + 1];
+        }
+    }
+
+    // Where the ray at each sample angle crosses the finest outline's edge: boundary point i sits
+    // at angle 2*pi*i/finestSegments, so the edge is the one from the point at or before it
+    float angles[ASTEROID_OUTLINE_SAMPLES + 1], sines[ASTEROID_OUTLINE_SAMPLES + 1], cosines[ASTEROID_OUTLINE_SAMPLES + 1];
+    for (int i = 0; i <= ASTEROID_OUTLINE_SAMPLES; ++i) angles[i] = static_cast<float>(i) / ASTEROID_OUTLINE_SAMPLES * 2.0f * glm::pi<float>();
+    fastSinCosBatch(angles, ASTEROID_OUTLINE_SAMPLES + 1, sines, cosines);
+    for (int i = 0; i <= ASTEROID_OUTLINE_SAMPLES; ++i) {
+        const glm::vec2 ray(cosines[i], sines[i]);
+        const int edge = std::min(i * finestSegments / ASTEROID_OUTLINE_SAMPLES, finestSegments - 1);
+        const glm::vec2 from(fillVertices[2 + 2 * edge], fillVertices[3 + 2 * edge]);
+        const glm::vec2 to(fillVertices[4 + 2 * edge], fillVertices[5 + 2 * edge]);
+        const glm::vec2 along = to - from;
+        shape.outlineRadius[i] = (from.x * along.y - from.y * along.x) / (ray.x * along.y - ray.y * along.x);
+    }
+}
+
+// Generates the ASTEROID_SHAPE_COUNT outlines on the CPU, each at every level of detail; the
+// renderer uploads atlasVertices as-is
+void generateAsteroidShapes(std::vector<float>& atlasVertices) {
+    float baseRadius = 1.0f; // Internal normalized radius
+    const int finestSegments = ASTEROID_LOD_SEGMENTS[ASTEROID_LOD_COUNT - 1];
+
+    atlasVertices.assign(static_cast<size_t>(2 * ASTEROID_SHAPE_VERTICES * ASTEROID_SHAPE_COUNT), 0.0f);
+    asteroidShapes.clear();
+    for (int k = 0; k < ASTEROID_SHAPE_COUNT; ++k) {
+        std::vector<float> fillVertices = generateFilledAsteroidVertices(finestSegments, baseRadius);
+
+        AsteroidShape shape;
+        const int baseVertex = k * ASTEROID_SHAPE_VERTICES;
+        packAsteroidShape(fillVertices.data(), baseVertex, &atlasVertices[static_cast<size_t>(2 * baseVertex)], shape);
+        asteroidShapes.push_back(shape);
+    }
+}
+
+float asteroidOutlineRadius(int shapeIndex, float angle) {
+    if (asteroidShapes.empty()) return 1.0f;
+    const float* radius = asteroidShapes[static_cast<size_t>(shapeIndex)].outlineRadius;
+    float sample = angle * (ASTEROID_OUTLINE_SAMPLES / (2.0f * glm::pi<float>()));
+    sample -= std::floor(sample / ASTEROID_OUTLINE_SAMPLES) * ASTEROID_OUTLINE_SAMPLES;
+    const int i = std::min(static_cast<int>(sample), ASTEROID_OUTLINE_SAMPLES - 1);
+    const float t = sample - static_cast<float>(i);
+    return radius[i] + (radius[i + 1] - radius[i]) * t;
+}
+
+// atan2 as a polynomial (within 1e-5 radians): plain arithmetic, so hits come out the same on every
+// build (the fixed-point mode's promise), where the library's may round differently
+static float polynomialAtan2(float y, float x) {
+    const float ax = std::fabs(x), ay = std::fabs(y);
+    const float largest = std::max(ax, ay);
+    if (largest == 0.0f) return 0.0f;
+    const float z = std::min(ax, ay) / largest, z2 = z * z;
+    float angle = z * (0.99997726f + z2 * (-0.33262347f + z2 * (0.19354346f + z2 * (-0.11643287f + z2 * (0.05265332f + z2 * -0.01172120f)))));
+    if (ay > ax) angle = glm::half_pi<float>() - angle;
+    if (x < 0.0f) angle = glm::pi<float>() - angle;
+    return y < 0.0f ? -angle : angle;
+}
+
+bool touchesAsteroidOutline(glm::vec2 offset, float radius, float rockScale, float rockRotation, int shapeIndex) {
+    const float distanceSq = glm::dot(offset, offset);
+    // The renderer turns the shape counterclockwise by the rock's rotation
+    const float reach = rockScale * asteroidOutlineRadius(shapeIndex, polynomialAtan2(offset.y, offset.x) - rockRotation) + radius;
+    return distanceSq <= reach * reach;
+}
+
+// O(1): picks one of the pre-generated outlines, no GL calls
+void assignAsteroidShape(Asteroid& rock, Rng& rng) {
+    rock.shapeIndex = rng.below(ASTEROID_SHAPE_COUNT);
+}
+
+int asteroidLodForPixelRadius(float pixelRadius) {
+    // A level is fine enough once its edges are short enough along the outermost boundary points
+    const float circumference = 2.0f * glm::pi<float>() * ASTEROID_MAX_OUTLINE_RADIUS * pixelRadius;
+    for (int lod = 0; lod < ASTEROID_LOD_COUNT; ++lod) {
+        if (circumference / ASTEROID_LOD_SEGMENTS[lod] <= ASTEROID_LOD_EDGE_PIXELS) return lod;
+    }
+    return ASTEROID_LOD_COUNT - 1;
+}
+
+// ============================ ASTEROID LOGIC ============================
+
+size_t GameWorld::liveAsteroidCount() const {
+    return asteroids.count() - pendingAsteroidRemovals;
+}
+
+size_t GameWorld::asteroidAdmission() const {
+    const size_t limit = static_cast<size_t>(limits.maxAsteroids);
+    return spawnCap > 0 ? std::min(spawnCap, limit) : limit;
+}
+
+// A spawn the limit allows but the load-shedding cap does not is counted as shed; the spawn timer
+// and the wave script carry on as if it had happened, so the difficulty curve does not move.
+void GameWorld::spawnNewAsteroid(glm::vec2 pos, AsteroidSize size, SpawnSide side)
+{
+    if (liveAsteroidCount() >= static_cast<size_t>(limits.maxAsteroids)) return;
+    if (liveAsteroidCount() >= asteroidAdmission()) {
+        ++shedSpawns;
+        profilerCount(COUNTER_ROCKS_SHED, 1);
+        return;
+    }
+    asteroids.push(makeAsteroid(pos, size, side));
+}
+
+Asteroid GameWorld::makeAsteroid(glm::vec2 pos, AsteroidSize size, SpawnSide side)
+{
+    Asteroid newRock;
+    newRock.size = size;
+    newRock.rotation = 0.0f;
+    newRock.rotationSpeed = 0.3f + spawnRng.uniform() * 0.5f;
+
+    newRock.paletteIndex = static_cast<uint8_t>(spawnRng.below(ASTEROID_PALETTE_SIZE));
+
+    // If splitting (internal spawn)
+    if (pos != glm::vec2(0.0f, 0.0f)) {
+        newRock.position = pos;
+
+        // Give new asteroids a random velocity
+        float angle = spawnRng.uniform() * 2.0f * glm::pi<float>();
+        glm::vec2 direction = heading(angle);
+        float speed = 0.3f + spawnRng.uniform() * 0.4f;
+        newRock.velocity = direction * speed;
+    }
+    // If external spawn (off screen)
+    else {
+        if (side == SPAWN_ANY_SIDE) side = static_cast<SpawnSide>(SPAWN_TOP + static_cast<int>(spawnRng.uniform() * 4.0f));
+        if (side == SPAWN_TOP) { newRock.position = glm::vec2(spawnRng.range(-1.0f, 1.0f), 1.1f); }
+        else if (side == SPAWN_BOTTOM) { newRock.position = glm::vec2(spawnRng.range(-1.0f, 1.0f), -1.1f); }
+        else if (side == SPAWN_LEFT) { newRock.position = glm::vec2(-1.1f, spawnRng.range(-1.0f, 1.0f)); }
+        else { newRock.position = glm::vec2(1.1f, spawnRng.range(-1.0f, 1.0f)); }
+
+        glm::vec2 target = glm::vec2(0.0f, 0.0f);
+        glm::vec2 direction = glm::normalize(target - newRock.position);
+        float scatter = 0.2f;
+        direction.x += (spawnRng.uniform() - 0.5f) * scatter;
+        direction.y += (spawnRng.uniform() - 0.5f) * scatter;
+        direction = glm::normalize(direction);
+        float speed = 0.1f + spawnRng.uniform() * 0.2f;
+        newRock.velocity = direction * speed;
+    }
+
+    assignAsteroidShape(newRock, shapeRng);
+    return newRock;
+}
+
+// Flags the rock for removal; the vector is compacted once by sweepAsteroids()
+void GameWorld::destroyAsteroid(size_t index) {
+    if (asteroids.destroyed[index]) return;
+    asteroids.destroyed[index] = 1;
+    ++pendingAsteroidRemovals;
+}
+
+void GameWorld::sweepAsteroids() {
+    asteroids.sweep([this](size_t i) { return asteroids.destroyed[i] != 0; });
+    pendingAsteroidRemovals = 0;
+}
+
+// ============================ SPATIAL ORDER ============================
+template <typename Array>
+static void gatherField(Array& field, const uint32_t* order, std::vector<unsigned char>& scratch) {
+    using T = typename Array::value_type;
+    const size_t n = field.size();
+    scratch.resize(n * sizeof(T));
+    T* gathered = reinterpret_cast<T*>(scratch.data());
+    for (size_t i = 0; i < n; ++i) gathered[i] = field[order[i]];
+    std::copy(gathered, gathered + n, field.begin());
+}
+
+void AsteroidStore::permute(const uint32_t* order, std::vector<unsigned char>& scratch) {
+    for (EntityArray<float>* field : { &x, &y, &vx, &vy, &rot, &rotSpeed, &px, &py, &prot, &ax, &ay, &arot }) gatherField(*field, order, scratch);
+    gatherField(anchorTime, order, scratch);
+    gatherField(sizeClass, order, scratch);
+    gatherField(paletteIndex, order, scratch);
+    gatherField(shapeIndex, order, scratch);
+    gatherField(destroyed, order, scratch);
+    gatherField(handles.slotOf, order, scratch);
+    for (size_t i = 0; i < handles.slotOf.size(); ++i) handles.denseIndex[handles.slotOf[i]] = static_cast<uint32_t>(i);
+}
+
+// Interleaves the bits of two cell coordinates (x in the even bits), so cells close on the field
+// mostly get close keys
+static uint32_t mortonKey(uint32_t cellX, uint32_t cellY) {
+    const auto spread = [](uint32_t v) {
+        v &= 0xFFFF;
+        v = (v | (v << 8)) & 0x00FF00FF;
+        v = (v | (v << 4)) & 0x0F0F0F0F;
+        v = (v | (v << 2)) & 0x33333333;
+        return (v | (v << 1)) & 0x55555555;
+    };
+    return spread(cellX) | (spread(cellY) << 1);
+}
+
+// Deterministic (ties keep their store order), so a recording or a rollback peer re-sorts the same way
+void GameWorld::sortAsteroidsSpatially() {
+    const size_t n = asteroids.count();
+    const SpatialGrid& cells = asteroidGrid.levels[SMALL];
+    for (size_t i = 0; i < n; ++i) {
+        const uint32_t key = mortonKey(static_cast<uint32_t>(cells.cellCoord(asteroids.x[i])), static_cast<uint32_t>(cells.cellCoord(asteroids.y[i])));
+        spatialKeys[i] = (static_cast<uint64_t>(key) << 32) | i;
+    }
+    std::sort(spatialKeys.begin(), spatialKeys.begin() + static_cast<std::ptrdiff_t>(n));
+    for (size_t i = 0; i < n; ++i) spatialOrder[i] = static_cast<uint32_t>(spatialKeys[i]);
+    asteroids.permute(spatialOrder.data(), spatialScratch);
+}
+
+// Flags the rock and queues its two children, as many of them as fit under the asteroid limit
+// (the children already queued count against it); spawnSplitChildren spawns them after the resolve
+void GameWorld::splitAsteroid(size_t index) {
+    const AsteroidSizeTraits& traits = asteroidTraits(asteroids.sizeClass[index]);
+    if (traits.childCount == 0) return; // Small asteroids are destroyed, not split
+
+    // Remove the original rock (flagged, swept at the end of the tick)
+    destroyAsteroid(index);
+
+    // Up to its class's children while the limit allows; those the load-shedding cap turns away are counted
+    int children = 0;
+    const size_t admission = asteroidAdmission();
+    for (int i = 0; i < traits.childCount && liveAsteroidCount() + static_cast<size_t>(queuedChildren) < static_cast<size_t>(limits.maxAsteroids); ++i) {
+        if (liveAsteroidCount() + static_cast<size_t>(queuedChildren) >= admission) {
+            ++shedChildren;
+            profilerCount(COUNTER_ROCKS_SHED, 1);
+            continue;
+        }
+        ++children;
+        ++queuedChildren;
+    }
+    splitEvents.push_back({ EVENT_ASTEROID_SPLIT, static_cast<int>(index), children });
+    profilerCount(COUNTER_ASTEROID_SPLITS, 1);
+}
+
+// ============================ GRAVITY ============================
+bool parseGravity(const char* name, bool& wells, bool& rocks) {
+    static const char* const names[] = { "off", "wells", "rocks", "both" }; // Bit 0: wells, bit 1: rocks
+    for (int i = 0; i < 4; ++i) {
+        if (std::strcmp(name, names[i]) == 0) {
+            wells = (i & 1) != 0;
+            rocks = (i & 2) != 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+void GravityTree::init(size_t capacity) {
+    keys.assign(capacity, 0);
+    sortedKeys.assign(capacity, 0);
+    for (std::vector<float>* field : { &bodyX, &bodyY, &bodyMass }) field->assign(capacity, 0.0f);
+    bodyIndex.assign(capacity, 0);
+    subtrees.resize(GRAVITY_BUCKETS);
+    cells.reserve(2 * capacity / GRAVITY_LEAF_BODIES + GRAVITY_BUCKETS);
+}
+
+// A parent's centre of mass, summed from its children
+struct GravityMoment {
+    double mass = 0.0, x = 0.0, y = 0.0; // The sums of m, m x and m y
+    double xx = 0.0, xy = 0.0, yy = 0.0; // The second moments about the origin (double: they are differences of large sums)
+
+    void add(float bodyX, float bodyY, float bodyMass) { // A point body: no spread of its own
+        const double m = bodyMass, cx = bodyX, cy = bodyY;
+        mass += m;
+        x += m * cx;
+        y += m * cy;
+        xx += m * cx * cx;
+        xy += m * cx * cy;
+        yy += m * cy * cy;
+    }
+    void add(const GravityCell& cell) {
+        const double m = cell.mass, cx = cell.x, cy = cell.y;
+        mass += m;
+        x += m * cx;
+        y += m * cy;
+        xx += cell.qxx + m * cx * cx;
+        xy += cell.qxy + m * cx * cy;
+        yy += cell.qyy + m * cy * cy;
+    }
+    void store(GravityCell& cell) const {
+        cell.mass = static_cast<float>(mass);
+        if (mass <= 0.0) {
+            cell.x = cell.x0 + 0.5f * cell.size;
+            cell.y = cell.y0 + 0.5f * cell.size;
+            cell.qxx = cell.qxy = cell.qyy = 0.0f;
+            return;
+        }
+        const double cx = x / mass, cy = y / mass;
+        cell.x = static_cast<float>(cx);
+        cell.y = static_cast<float>(cy);
+        cell.qxx = static_cast<float>(xx - mass * cx * cx);
+        cell.qxy = static_cast<float>(xy - mass * cx * cy);
+        cell.qyy = static_cast<float>(yy - mass * cy * cy);
+    }
+};
+
+// Appends the cell over the sorted bodies [first, last), which share the top 2 * depth bits of their
+// keys, then its subtree, depth first
+static void buildGravityCell(const GravityTree& tree, std::vector<GravityCell>& out, uint32_t first, uint32_t last,
+                             int depth, float x0, float y0, float size) {
+    const size_t at = out.size();
+    out.emplace_back();
+    GravityCell cell = {};
+    cell.x0 = x0;
+    cell.y0 = y0;
+    cell.size = size;
+    cell.first = first;
+    cell.count = last - first;
+    GravityMoment moment;
+    if (cell.count > GRAVITY_LEAF_BODIES && depth < 16) {
+        // The children in key order: the next two bits say which quarter (x in the low one)
+        const int shift = 62 - 2 * depth;
+        const float half = 0.5f * size;
+        uint32_t begin = first;
+        for (uint32_t quarter = 0; quarter < 4 && begin < last; ++quarter) {
+            uint32_t end = begin;
+            while (end < last && ((tree.sortedKeys[end] >> shift) & 3) == quarter) ++end;
+            if (end == begin) continue;
+            const size_t child = out.size();
+            buildGravityCell(tree, out, begin, end, depth + 1, x0 + (quarter & 1) * half, y0 + (quarter >> 1) * half, half);
+            moment.add(out[child]);
+            begin = end;
+        }
+    }
+    else {
+        for (uint32_t k = first; k < last; ++k) moment.add(tree.bodyX[k], tree.bodyY[k], tree.bodyMass[k]);
+    }
+    moment.store(cell);
+    cell.skip = static_cast<uint32_t>(out.size() - at);
+    out[at] = cell;
+}
+
+// Appends the cell over buckets [firstBucket, firstBucket + buckets) at `depth` and everything under
+// it: the levels above GRAVITY_SPLIT_DEPTH from their children's totals, the subtrees below as built
+static void assembleGravityCells(GravityTree& tree, int depth, uint32_t firstBucket, uint32_t buckets, float x0, float y0, float size) {
+    if (depth == GRAVITY_SPLIT_DEPTH) {
+        const std::vector<GravityCell>& subtree = tree.subtrees[firstBucket];
+        tree.cells.insert(tree.cells.end(), subtree.begin(), subtree.end());
+        return;
+    }
+    const size_t at = tree.cells.size();
+    tree.cells.emplace_back();
+    GravityCell cell = {};
+    cell.x0 = x0;
+    cell.y0 = y0;
+    cell.size = size;
+    cell.first = tree.bucketStart[firstBucket];
+    cell.count = tree.bucketStart[firstBucket + buckets] - cell.first;
+    GravityMoment moment;
+    const uint32_t quarterBuckets = buckets / 4;
+    const float half = 0.5f * size;
+    for (uint32_t quarter = 0; quarter < 4; ++quarter) {
+        const uint32_t first = firstBucket + quarter * quarterBuckets;
+        if (tree.bucketStart[first + quarterBuckets] == tree.bucketStart[first]) continue;
+        const size_t child = tree.cells.size();
+        assembleGravityCells(tree, depth + 1, first, quarterBuckets, x0 + (quarter & 1) * half, y0 + (quarter >> 1) * half, half);
+        moment.add(tree.cells[child]);
+    }
+    moment.store(cell);
+    cell.skip = static_cast<uint32_t>(tree.cells.size() - at);
+    tree.cells[at] = cell;
+}
+
+void GravityTree::build(const float* x, const float* y, const float* mass, size_t n) {
+    if (keys.size() < n) init(n);
+    // Keys on a 65536 x 65536 lattice over the field
+    parallelFor(0, n, INTEGRATION_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            if (mass[i] <= 0.0f) {
+                keys[i] = UINT64_MAX;
+                continue;
+            }
+            const auto lattice = [](float v) { return static_cast<uint32_t>(std::clamp((v + 1.0f) * 32768.0f, 0.0f, 65535.0f)); };
+            keys[i] = (static_cast<uint64_t>(mortonKey(lattice(x[i]), lattice(y[i]))) << 32) | i;
+        }
+    });
+
+    // Dealt into the buckets by their top bits, in body order
+    const int bucketShift = 64 - 2 * GRAVITY_SPLIT_DEPTH;
+    uint32_t next[GRAVITY_BUCKETS] = {};
+    for (size_t i = 0; i < n; ++i) {
+        if (keys[i] != UINT64_MAX) ++next[keys[i] >> bucketShift];
+    }
+    bucketStart[0] = 0;
+    for (int b = 0; b < GRAVITY_BUCKETS; ++b) {
+        bucketStart[b + 1] = bucketStart[b] + next[b];
+        next[b] = bucketStart[b];
+    }
+    for (size_t i = 0; i < n; ++i) {
+        if (keys[i] != UINT64_MAX) sortedKeys[next[keys[i] >> bucketShift]++] = keys[i];
+    }
+
+    // Each bucket sorted, its bodies gathered and its subtree built, as a job of its own
+    parallelFor(0, GRAVITY_BUCKETS, 1, [&](size_t begin, size_t end) {
+        for (size_t b = begin; b < end; ++b) {
+            subtrees[b].clear();
+            const uint32_t first = bucketStart[b], last = bucketStart[b + 1];
+            if (first == last) continue;
+            std::sort(sortedKeys.begin() + first, sortedKeys.begin() + last);
+            for (uint32_t k = first; k < last; ++k) {
+                const uint32_t i = static_cast<uint32_t>(sortedKeys[k]);
+                bodyX[k] = x[i];
+                bodyY[k] = y[i];
+                bodyMass[k] = mass[i];
+                bodyIndex[k] = i;
+            }
+            // The bucket's cell, from the bits of its number (x in the even ones)
+            uint32_t cellX = 0, cellY = 0;
+            for (int bit = 0; bit < GRAVITY_SPLIT_DEPTH; ++bit) {
+                cellX |= ((b >> (2 * bit)) & 1) << bit;
+                cellY |= ((b >> (2 * bit + 1)) & 1) << bit;
+            }
+            const float size = FIELD_WIDTH / (1 << GRAVITY_SPLIT_DEPTH);
+            buildGravityCell(*this, subtrees[b], first, last, GRAVITY_SPLIT_DEPTH, -1.0f + cellX * size, -1.0f + cellY * size, size);
+        }
+    });
+
+    cells.clear();
+    if (bucketStart[GRAVITY_BUCKETS] > 0) assembleGravityCells(*this, 0, 0, GRAVITY_BUCKETS, -1.0f, -1.0f, FIELD_WIDTH);
+}
+
+// The pull of `mass` on a point `dx, dy` away from it: softened, and faded out to nothing at GRAVITY_RANGE
+static inline void addGravityPull(float dx, float dy, float mass, float softening, glm::vec2& pull) {
+    const float d2 = dx * dx + dy * dy;
+    if (d2 >= GRAVITY_RANGE * GRAVITY_RANGE) return;
+    const float fade = 1.0f - d2 * (1.0f / (GRAVITY_RANGE * GRAVITY_RANGE));
+    const float r2 = d2 + softening * softening;
+    const float f = mass * fade * fade / (r2 * std::sqrt(r2));
+    pull.x += f * dx;
+    pull.y += f * dy;
+}
+
+// The pull of a cell whose bodies lie `dx, dy` away around their centre of mass, as a body there plus
+// the second-order term from their spread (the first-order one is zero about the centre of mass).
+// With u = d^2 and g(u) = fade^2 / (u + softening^2)^1.5, a body of mass m at r pulls m g r, and the
+// spread Q adds g'(u) (2 Q r + tr(Q) r) + 2 g''(u) (r.Q r) r. The whole cell must be within range.
+static inline void addGravityCellPull(float dx, float dy, const GravityCell& cell, glm::vec2& pull) {
+    const float u = dx * dx + dy * dy;
+    const float inverseRange2 = 1.0f / (GRAVITY_RANGE * GRAVITY_RANGE);
+    const float fade = 1.0f - u * inverseRange2;
+    const float r2 = u + GRAVITY_SOFTENING * GRAVITY_SOFTENING;
+    const float b = 1.0f / (r2 * std::sqrt(r2)); // (u + s^2)^-1.5 and its derivatives in u
+    const float bu = -1.5f * b / r2, buu = -2.5f * bu / r2;
+    const float a = fade * fade, au = -2.0f * fade * inverseRange2, auu = 2.0f * inverseRange2 * inverseRange2;
+    const float g = a * b, gu = au * b + a * bu, guu = auu * b + 2.0f * au * bu + a * buu;
+    const float qx = cell.qxx * dx + cell.qxy * dy, qy = cell.qxy * dx + cell.qyy * dy; // Q r
+    const float trace = cell.qxx + cell.qyy, rqr = dx * qx + dy * qy;
+    const float radial = cell.mass * g + gu * trace + 2.0f * guu * rqr;
+    pull.x += radial * dx + 2.0f * gu * qx;
+    pull.y += radial * dy + 2.0f * gu * qy;
+}
+
+glm::vec2 GravityTree::field(float x, float y, int self, float theta, size_t* interactions) const {
+    glm::vec2 pull(0.0f);
+    size_t summed = 0;
+    const float theta2 = theta * theta;
+    const uint32_t selfIndex = static_cast<uint32_t>(self);
+    for (size_t c = 0; c < cells.size();) {
+        const GravityCell& cell = cells[c];
+        // How far the point is from the cell's square on each axis, through the wrap
+        const float halfSize = 0.5f * cell.size;
+        const float spanX = std::abs(wrappedDelta(cell.x0 + halfSize, x)), spanY = std::abs(wrappedDelta(cell.y0 + halfSize, y));
+        const float gapX = std::max(spanX - halfSize, 0.0f), gapY = std::max(spanY - halfSize, 0.0f);
+        if (gapX * gapX + gapY * gapY >= GRAVITY_RANGE * GRAVITY_RANGE) {
+            c += cell.skip; // Out of range, every body in it
+            continue;
+        }
+        if (cell.skip == 1) {
+            for (uint32_t k = cell.first; k < cell.first + cell.count; ++k) {
+                if (bodyIndex[k] == selfIndex) continue;
+                addGravityPull(wrappedDelta(bodyX[k], x), wrappedDelta(bodyY[k], y), bodyMass[k], GRAVITY_SOFTENING, pull);
+                ++summed;
+            }
+            ++c;
+            continue;
+        }
+        // Seen from outside, not reaching half a field away, where its bodies' nearest images part ways,
+        // and wholly in range: across the range's edge the pull is cut off, which no expansion about
+        // the centre of mass follows
+        const float reachX = spanX + halfSize, reachY = spanY + halfSize;
+        if ((gapX > 0.0f || gapY > 0.0f) && reachX <= 1.0f && reachY <= 1.0f && reachX * reachX + reachY * reachY < GRAVITY_RANGE * GRAVITY_RANGE) {
+            const float dx = wrappedDelta(cell.x, x), dy = wrappedDelta(cell.y, y);
+            if (cell.size * cell.size < theta2 * (dx * dx + dy * dy)) {
+                addGravityCellPull(dx, dy, cell, pull);
+                ++summed;
+                c += cell.skip;
+                continue;
+            }
+        }
+        ++c; // Opened: its first child is next
+    }
+    if (interactions) *interactions += summed;
+    return pull;
+}
+
+glm::vec2 GravityTree::fieldDirect(float x, float y, int self) const {
+    glm::vec2 pull(0.0f);
+    const uint32_t selfIndex = static_cast<uint32_t>(self);
+    for (uint32_t k = 0; k < bucketStart[GRAVITY_BUCKETS]; ++k) {
+        if (bodyIndex[k] != selfIndex) addGravityPull(wrappedDelta(bodyX[k], x), wrappedDelta(bodyY[k], y), bodyMass[k], GRAVITY_SOFTENING, pull);
+    }
+    return pull;
+}
+
+// Semi-implicit: the velocities take this tick's pull before the move. Only the large rocks pull
+// (the smaller ones are too light to matter), but every rock is pulled.
+void GameWorld::applyGravity(float dt) {
+    const size_t n = asteroids.count();
+    if (n == 0) return;
+    if (rockGravity) {
+        if (gravityMass.size() < n) gravityMass.resize(static_cast<size_t>(limits.asteroidPoolCapacity()));
+        for (size_t i = 0; i < n; ++i) gravityMass[i] = asteroids.sizeClass[i] == LARGE ? 1.0f : 0.0f;
+        gravityTree.build(asteroids.x.data(), asteroids.y.data(), gravityMass.data(), n);
+    }
+    const float step = GRAVITY_CONSTANT * dt;
+    const bool direct = gravityTree.bucketStart[GRAVITY_BUCKETS] < GRAVITY_DIRECT_BODIES;
+    parallelFor(0, n, GRAVITY_GRAIN, [this, step, direct](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const float x = asteroids.x[i], y = asteroids.y[i];
+            glm::vec2 pull(0.0f);
+            if (rockGravity) pull = direct ? gravityTree.fieldDirect(x, y, static_cast<int>(i)) : gravityTree.field(x, y, static_cast<int>(i), gravityTheta);
+            if (gravityWells) {
+                for (const GravityWell& well : GRAVITY_WELLS) addGravityPull(wrappedDelta(well.x, x), wrappedDelta(well.y, y), well.mass, well.softening, pull);
+            }
+            asteroids.vx[i] += step * pull.x;
+            asteroids.vy[i] += step * pull.y;
+        }
+    });
+}
+
+// ============================ INPUT ============================
+
+bool parseWeapon(const char* name, WeaponKind& weapon) {
+    for (int i = 0; i < WEAPON_COUNT; ++i) {
+        if (std::strcmp(name, WEAPON_TRAITS[i].name) == 0) {
+            weapon = static_cast<WeaponKind>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Applies one tick of a ship's controls (rotation, thrust, fire, shield)
+void GameWorld::applyInput(size_t s, const InputState& input, float dt)
+{
+    if (fixedPointKinematics) steerShipFixed(s, input, dt);
+    else steerShip(s, input, dt);
+
+    // --- SHIELD ACTIVATION ---
+    if (input.shield && !ships.shieldActive[s] && tick >= ships.shieldReadyTick[s]) {
+        ships.shieldActive[s] = 1;
+        ships.shieldEndTick[s] = tick + ticksFor(SHIELD_DURATION);
+        timers.schedule({ ships.shieldEndTick[s], static_cast<uint32_t>(s), TIMER_SHIELD_END });
+        if (instrumented) LOG_INFO("Shield Activated!");
+    }
+}
+
+void GameWorld::steerShip(size_t s, const InputState& input, float dt)
+{
+    float& rotation = ships.rot[s];
+    if (input.left)
+        rotation += ROTATION_SPEED * dt;
+    if (input.right)
+        rotation -= ROTATION_SPEED * dt;
+    rotation = fmod(rotation, 2.0f * glm::pi<float>());
+
+    ships.thrusting[s] = 0;
+
+    // --- Calculate the Ship's Facing Direction (Unit Vector) ---
+    // The ship's model (rotation=0) points UP (+Y).
+    // To use standard trigonometry (angle from +X axis), we must offset the angle by 90 degrees (pi/2).
+    float angleFromXAxis = rotation + glm::half_pi<float>();
+
+    // Now use standard math for direction: X=cos, Y=sin
+    float dirX, dirY;
+    fastSinCos(angleFromXAxis, dirY, dirX);
+
+    // Note: The previous logic (dirX=sin, dirY=cos) was effectively doing this offset,
+    // but the `glm::rotate` in rendering likely expects the standard angle,
+    // creating the mismatch you observed when rotating left/right.
+    // By using the standard X=cos, Y=sin, we align the physics direction.
+
+    // --- Thrust Movement ---
+    if (input.thrust)
+    {
+        ships.thrusting[s] = 1;
+
+        // Ship movement: Apply acceleration (thrust) in the direction the ship is facing.
+        ships.vx[s] += dirX * THRUST_SPEED * dt;
+        ships.vy[s] += dirY * THRUST_SPEED * dt;
+    }
+
+    // --- Firing Bullet ---
+    if (input.fire && tick >= ships.fireReadyTick[s])
+    {
+        const WeaponTraits& traits = WEAPON_TRAITS[weapon];
+
+        // Spawn the bullet slightly ahead of the ship's center.
+        const glm::vec2 origin(ships.x[s], ships.y[s]);
+        const float spawnDistance = ships.radius[s] * 1.5f;
+        const glm::vec2 momentum(ships.vx[s], ships.vy[s]);
+
+        // A volley fans out from -spread / 2 to +spread / 2 about the facing: one sine and cosine for
+        // its first bullet and one for the step, then each direction is the last one turned by the step
+        glm::vec2 direction(dirX, dirY);
+        glm::vec2 turn(1.0f, 0.0f);
+        const float staggerStep = traits.bullets > 1 ? traits.speedStagger / (traits.bullets - 1) : 0.0f;
+        if (traits.bullets > 1) {
+            float startSin, startCos;
+            fastSinCos(angleFromXAxis - 0.5f * traits.spread, startSin, startCos);
+            direction = glm::vec2(startCos, startSin);
+            fastSinCos(traits.spread / (traits.bullets - 1), turn.y, turn.x);
+        }
+
+        // The bullet velocity is its own speed in the direction of fire,
+        // PLUS the ship's current velocity (momentum).
+        const size_t fired = bullets.pushVolley(traits.bullets, traits.lifetime, static_cast<int32_t>(s),
+            [&](size_t k, glm::vec2& position, glm::vec2& velocity) {
+                position = origin + direction * spawnDistance;
+                velocity = direction * (traits.speed * (1.0f - staggerStep * k)) + momentum;
+                direction = glm::vec2(direction.x * turn.x - direction.y * turn.y, direction.x * turn.y + direction.y * turn.x);
+            });
+        if (fired > 0) recordShotEffect(s); // Dropped if every pool slot is in flight
+        ships.fireReadyTick[s] = tick + ticksFor(traits.cooldown);
+    }
+}
+
+// steerShip with the facing from the sine table and every product rounded in Q16.16. The rotation
+// wraps into [0, 2 pi) rather than fmod's (-2 pi, 2 pi).
+void GameWorld::steerShipFixed(size_t s, const InputState& input, float dt)
+{
+    const int32_t step = toFixed(dt);
+    int32_t rotation = toFixed(ships.rot[s]);
+    if (input.left) rotation += fixedMul(fixedConstant(ROTATION_SPEED), step);
+    if (input.right) rotation -= fixedMul(fixedConstant(ROTATION_SPEED), step);
+    rotation = wrapFixedAngle(rotation);
+    ships.rot[s] = fromFixed(rotation);
+
+    ships.thrusting[s] = 0;
+
+    // Facing: (cos, sin) of rotation + pi / 2, as in steerShip
+    int32_t sine, dirY;
+    fixedSinCos(rotation, sine, dirY);
+    const int32_t dirX = -sine;
+    int32_t velocityX = toFixed(ships.vx[s]);
+    int32_t velocityY = toFixed(ships.vy[s]);
+    if (input.thrust) {
+        ships.thrusting[s] = 1;
+        const int32_t thrust = fixedMul(fixedConstant(THRUST_SPEED), step);
+        velocityX += fixedMul(dirX, thrust);
+        velocityY += fixedMul(dirY, thrust);
+    }
+    ships.vx[s] = fromFixed(velocityX);
+    ships.vy[s] = fromFixed(velocityY);
+
+    if (input.fire && tick >= ships.fireReadyTick[s]) {
+        const WeaponTraits& traits = WEAPON_TRAITS[weapon];
+        const int32_t spawnDistance = toFixed(ships.radius[s] * 1.5f);
+        const int32_t originX = toFixed(ships.x[s]), originY = toFixed(ships.y[s]);
+        // Each bullet's direction from the table at its own angle, so no rounding builds up across a volley
+        int32_t angle = rotation, angleStep = 0, speedStep = 0;
+        if (traits.bullets > 1) {
+            angle = wrapFixedAngle(rotation - fixedConstant(0.5f * traits.spread));
+            angleStep = fixedConstant(traits.spread / (traits.bullets - 1));
+            speedStep = fixedConstant(traits.speed * traits.speedStagger / (traits.bullets - 1));
+        }
+        const size_t fired = bullets.pushVolley(traits.bullets, traits.lifetime, static_cast<int32_t>(s),
+            [&](size_t k, glm::vec2& position, glm::vec2& velocity) {
+                int32_t shotX = dirX, shotY = dirY;
+                if (traits.bullets > 1) {
+                    int32_t shotSine;
+                    fixedSinCos(angle, shotSine, shotY);
+                    shotX = -shotSine;
+                    angle = wrapFixedAngle(angle + angleStep);
+                }
+                const int32_t speed = fixedConstant(traits.speed) - speedStep * static_cast<int32_t>(k);
+                position.x = fromFixed(originX + fixedMul(shotX, spawnDistance));
+                position.y = fromFixed(originY + fixedMul(shotY, spawnDistance));
+                velocity.x = fromFixed(fixedMul(shotX, speed) + velocityX);
+                velocity.y = fromFixed(fixedMul(shotY, speed) + velocityY);
+            });
+        if (fired > 0) recordShotEffect(s);
+        ships.fireReadyTick[s] = tick + ticksFor(traits.cooldown);
+    }
+}
+
+// The ships' physics step: friction, then the move with the rocks' kernels, wrapping at the edges.
+// A lost ship was stopped, so it stays where it was.
+void GameWorld::moveShips(float dt)
+{
+    const size_t n = ships.count();
+    if (fixedPointKinematics) {
+        const int32_t step = toFixed(dt);
+        dampVelocityFixed(ships.vx.data(), n, FIXED_FRICTION_PER_TICK);
+        dampVelocityFixed(ships.vy.data(), n, FIXED_FRICTION_PER_TICK);
+        integrateWrapFixed(ships.x.data(), ships.vx.data(), n, step);
+        integrateWrapFixed(ships.y.data(), ships.vy.data(), n, step);
+        return;
+    }
+    dampVelocity(ships.vx.data(), n, FRICTION_PER_TICK);
+    dampVelocity(ships.vy.data(), n, FRICTION_PER_TICK);
+    integrateWrap(ships.x.data(), ships.vx.data(), n, dt);
+    integrateWrap(ships.y.data(), ships.vy.data(), n, dt);
+}
+
+// ============================ HOMING MISSILES ============================
+// See HOMING MISSILES (simulation.h). Runs once the rocks have moved and before anything is resolved,
+// so every rock in the store is live and where this tick's checks see it. The targets are handles,
+// good across the sweep's swap-removes; the claims are recounted from them each tick.
+void GameWorld::guideMissiles(float dt)
+{
+    const size_t slots = bullets.capacity();
+    const size_t rockCount = asteroids.count();
+    const bool retarget = tick % MISSILE_RETARGET_TICKS == 0;
+
+    // 1. The claims of the targets that stand, and the missiles to target, oldest first
+    std::fill(missileClaims.begin(), missileClaims.begin() + rockCount, 0);
+    size_t queries = 0;
+    for (uint64_t k = bullets.tail; k < bullets.head; ++k) {
+        const size_t j = static_cast<size_t>(k % slots);
+        if (!bullets.live(j)) continue;
+        const long long rock = retarget ? -1 : asteroids.handles.resolve(bullets.target[j]);
+        if (rock >= 0) {
+            ++missileClaims[static_cast<size_t>(rock)];
+            continue;
+        }
+        missileQueries[queries] = static_cast<uint32_t>(j);
+        missileCenters[queries] = bullets.position(j);
+        ++queries;
+    }
+    missileBatch = queries;
+
+    // 2. One kNN batch over the rocks, then the targets handed out in firing order
+    if (queries > 0 && rockCount > 0) {
+        missileRocks.build(asteroids.x.data(), asteroids.y.data(), rockCount);
+        queryKNearestBatch(missileRocks, missileCenters.data(), queries, MISSILE_CANDIDATES, missileHits.data(), missileHitCounts.data());
+    }
+    for (size_t q = 0; q < queries; ++q) {
+        const size_t j = missileQueries[q];
+        bullets.target[j] = INVALID_ENTITY_HANDLE;
+        if (rockCount == 0) continue;
+        const QueryHit* hits = &missileHits[q * MISSILE_CANDIDATES];
+        int chosen = hits[0].index; // The nearest, unless a less claimed candidate is left
+        for (uint32_t h = 0; h < missileHitCounts[q]; ++h) {
+            if (missileClaims[static_cast<size_t>(hits[h].index)] < MISSILE_CLAIMS_PER_ROCK) {
+                chosen = hits[h].index;
+                break;
+            }
+        }
+        ++missileClaims[static_cast<size_t>(chosen)];
+        bullets.target[j] = asteroids.handles.handle(static_cast<size_t>(chosen));
+    }
+
+    // 3. Every slot's target (pull 0: none, or not a live missile), then the SIMD pass over the ring
+    for (size_t j = 0; j < slots; ++j) {
+        const long long rock = bullets.live(j) ? asteroids.handles.resolve(bullets.target[j]) : -1;
+        missilePull[j] = rock >= 0 ? 1.0f : 0.0f;
+        missileTargetX[j] = rock >= 0 ? asteroids.x[static_cast<size_t>(rock)] : bullets.x[j];
+        missileTargetY[j] = rock >= 0 ? asteroids.y[static_cast<size_t>(rock)] : bullets.y[j];
+    }
+    parallelFor(0, slots, INTEGRATION_GRAIN, [this, dt](size_t begin, size_t end) {
+        steerMissiles(bullets.vx.data() + begin, bullets.vy.data() + begin, bullets.x.data() + begin, bullets.y.data() + begin,
+                      missileTargetX.data() + begin, missileTargetY.data() + begin, missilePull.data() + begin, end - begin,
+                      MISSILE_TURN_ACCEL * dt, MISSILE_MAX_SPEED);
+    });
+}
+
+glm::vec2 GameWorld::heading(float angle) const
+{
+    if (!fixedPointKinematics) {
+        float sine, cosine;
+        fastSinCos(angle, sine, cosine);
+        return glm::vec2(cosine, sine);
+    }
+    int32_t sine, cosine;
+    fixedSinCos(toFixed(angle), sine, cosine);
+    return glm::vec2(fromFixed(cosine), fromFixed(sine));
+}
+
+// Plain circle-vs-circle test (a ship passes ShipStore::collisionRadius itself)
+bool checkCollision(glm::vec2 pos1, float rad1, glm::vec2 pos2, float rad2)
+{
+    glm::vec2 distanceVec = pos1 - pos2;
+    float distanceSq = distanceVec.x * distanceVec.x + distanceVec.y * distanceVec.y;
+    float radiiSumSq = (rad1 + rad2) * (rad1 + rad2);
+
+    return distanceSq < radiiSumSq;
+}
+
+
+// ============================ SHIP STORE ============================
+glm::vec2 shipStartPosition(size_t s) {
+    if (s == 0) return glm::vec2(0.0f, 0.0f);
+    // Exact directions rather than cos/sin, so fixed-point worlds start alike on every build
+    static const glm::vec2 directions[8] = { { 1.0f, 0.0f }, { -1.0f, 0.0f }, { 0.0f, 1.0f }, { 0.0f, -1.0f },
+                                             { 0.75f, 0.75f }, { -0.75f, -0.75f }, { -0.75f, 0.75f }, { 0.75f, -0.75f } };
+    const size_t ring = (s - 1) / 8 + 1;
+    glm::vec2 position = directions[(s - 1) % 8] * (0.4f * static_cast<float>(ring));
+    position.x = nearestImage(position.x, 0.0f); // Far rings wrap around the field
+    position.y = nearestImage(position.y, 0.0f);
+    return position;
+}
+
+Ship ShipStore::ship(size_t s) const {
+    Ship view;
+    view.position = glm::vec2(x[s], y[s]);
+    view.velocity = glm::vec2(vx[s], vy[s]);
+    view.rotation = rot[s];
+    view.scale = scale[s];
+    view.radius = radius[s];
+    view.prevPosition = glm::vec2(px[s], py[s]);
+    view.prevRotation = prot[s];
+    return view;
+}
+
+void ShipStore::reset(size_t n) {
+    for (EntityArray<float>* field : { &vx, &vy, &rot, &prot }) field->assign(n, 0.0f);
+    for (EntityArray<uint64_t>* field : { &fireReadyTick, &shieldEndTick, &shieldReadyTick }) field->assign(n, 0);
+    x.resize(n); y.resize(n);
+    for (size_t s = 0; s < n; ++s) {
+        const glm::vec2 start = shipStartPosition(s);
+        x[s] = start.x;
+        y[s] = start.y;
+    }
+    px = x; py = y;
+    const Ship defaults;
+    scale.assign(n, defaults.scale);
+    radius.assign(n, defaults.radius);
+    shieldActive.assign(n, 0);
+    thrusting.assign(n, 0);
+    alive.assign(n, 1);
+    score.assign(n, 0);
+}
+
+// ============================ INITIALIZATION ============================
+// CPU-side setup shared by the windowed and headless modes
+void GameWorld::init(const SimulationLimits& worldLimits) {
+    limits = worldLimits;
+    ships.reset(static_cast<size_t>(limits.ships));
+    const int asteroidCapacity = limits.asteroidPoolCapacity();
+    asteroids.reserve(asteroidCapacity);
+    bullets.reserve(limits.maxBullets);
+    asteroidGrid.init(asteroidCapacity);
+    heatmap.init(asteroidGrid);
+    asteroidSweep.init(getGridCellSize(), asteroidCapacity);
+    for (int k = 0; k < ASTEROID_SIZE_COUNT; ++k) bulletGrids[k].init(getBulletCellSize(static_cast<AsteroidSize>(k)), limits.maxBullets);
+    kinetic.init(static_cast<size_t>(asteroidCapacity), static_cast<size_t>(limits.maxBullets));
+    // A ship has at most its shield's end and its cooldown's, plus an end an absorb left behind; and
+    // the wave script its resume
+    timers.reserve(4 * ships.count() + 1);
+    firedTimers.reserve(4 * ships.count() + 1);
+    timers.reset(tick);
+    waveSteps = 0;
+    waveResumeTick = tick + 1; // The script starts on the next tick
+    restartWaves();
+    collisionCandidates.reserve(asteroidCapacity);
+    if (instrumented) LOG_INFO("Collision kernel: %s", collisionKernelName(activeCollisionKernel()));
+    for (EntityArray<float>* scratch : { &scratchX, &scratchY, &scratchR }) scratch->assign(COLLISION_MASK_BITS, 0.0f);
+    // Every tick's event lists up front, so a busier tick than any before does not allocate: a ship
+    // sees at most one mask of candidates, each bullet splits at most one rock, and a hit list
+    // rarely holds more than one entry per bullet
+    bulletHits.resize(static_cast<size_t>(asteroidCapacity) / BULLET_COLLISION_GRAIN + 1);
+    for (std::vector<BulletHit>& hits : bulletHits) hits.reserve(static_cast<size_t>(limits.maxBullets));
+    if (pairBatchedHits) {
+        // Room for a few pairs per rock; a busier chunk grows its buffer and keeps it
+        bulletPairs.resize(bulletHits.size());
+        for (BulletPairs& pairs : bulletPairs) pairs.grow(BULLET_COLLISION_GRAIN * 4);
+    }
+    if (rockGravity) {
+        gravityTree.init(static_cast<size_t>(asteroidCapacity));
+        gravityMass.assign(static_cast<size_t>(asteroidCapacity), 0.0f);
+    }
+    if (WEAPON_TRAITS[weapon].homing) {
+        const size_t missiles = static_cast<size_t>(limits.maxBullets);
+        missileRocks.init(static_cast<size_t>(asteroidCapacity));
+        missileQueries.assign(missiles, 0);
+        missileCenters.assign(missiles, glm::vec2(0.0f));
+        missileHits.assign(missiles * MISSILE_CANDIDATES, { 0, 0.0f });
+        missileHitCounts.assign(missiles, 0);
+        missileClaims.assign(static_cast<size_t>(asteroidCapacity), 0);
+        for (EntityArray<float>* lane : { &missileTargetX, &missileTargetY, &missilePull }) lane->assign(missiles, 0.0f);
+    }
+    shipEvents.reserve(COLLISION_MASK_BITS * static_cast<size_t>(limits.ships));
+    splitEvents.reserve(static_cast<size_t>(limits.maxBullets));
+    // Each hit, absorb, loss or shot is one effect; room for EFFECT_RESERVE_TICKS ticks of them all at once
+    if (recordEffects) effectEvents.reserve(EFFECT_RESERVE_TICKS * static_cast<size_t>(limits.maxBullets + 3 * limits.ships));
+    for (EntityArray<float>* gathered : { &sortedX, &sortedY, &sortedVX, &sortedVY, &sortedR }) gathered->assign(static_cast<size_t>(asteroidCapacity), 0.0f);
+    sortedIndex.assign(static_cast<size_t>(asteroidCapacity), 0);
+    spatialKeys.assign(static_cast<size_t>(asteroidCapacity), 0);
+    spatialOrder.assign(static_cast<size_t>(asteroidCapacity), 0);
+    spatialScratch.reserve(static_cast<size_t>(asteroidCapacity) * sizeof(glm::vec3)); // The widest field
+    size_t gridRows = 0;
+    for (const SpatialGrid& level : asteroidGrid.levels) gridRows += static_cast<size_t>(level.dim);
+    asteroidPairs.resize(gridRows); // Each grows to its row's busiest tick, then stays
+    asteroidPairCounts.assign(gridRows, 0);
+    asteroidPairTests.assign(gridRows, 0);
+    bulletCandidateCounts.assign(bulletHits.size(), 0);
+}
+
+// ============================ MEMORY ============================
+template <typename... Vectors>
+static size_t capacityBytes(const Vectors&... vectors) {
+    return ((vectors.capacity() * sizeof(typename Vectors::value_type)) + ... + 0);
+}
+
+static size_t handleBytes(const HandleTable& handles) {
+    return capacityBytes(handles.denseIndex, handles.generation, handles.slotOf, handles.freeSlots);
+}
+
+static size_t gridBytes(const SpatialGrid& grid) {
+    return capacityBytes(grid.cellStart, grid.entries, grid.entityCell, grid.chunkOffsets, grid.occupied);
+}
+
+size_t AsteroidStore::memoryBytes() const {
+    return capacityBytes(x, y, vx, vy, rot, rotSpeed, px, py, prot, ax, ay, arot, anchorTime, sizeClass, paletteIndex,
+                         shapeIndex, destroyed) + handleBytes(handles);
+}
+
+size_t BulletStore::memoryBytes() const {
+    return capacityBytes(x, y, vx, vy, radius, px, py, expiresAt, owner, spent, target, generation);
+}
+
+size_t ShipStore::memoryBytes() const {
+    return capacityBytes(x, y, vx, vy, rot, radius, px, py, prot, scale, fireReadyTick, shieldEndTick, shieldReadyTick,
+                         shieldActive, thrusting, alive, score);
+}
+
+void GameWorld::collectMemory(MemoryReport& report) const {
+    report.add("simulation", "asteroid store", MEMORY_CPU, asteroids.memoryBytes());
+    report.add("simulation", "bullet store", MEMORY_CPU, bullets.memoryBytes());
+    report.add("simulation", "ship store", MEMORY_CPU, ships.memoryBytes());
+
+    size_t grids = capacityBytes(asteroidGrid.entityCell, asteroidGrid.chunkOffsets);
+    for (const SpatialGrid& level : asteroidGrid.levels) grids += gridBytes(level);
+    report.add("simulation", "asteroid grid", MEMORY_CPU, grids);
+    report.add("simulation", "asteroid sweep", MEMORY_CPU, capacityBytes(asteroidSweep.entries, asteroidSweep.trackedGeneration));
+    grids = 0;
+    for (const SpatialGrid& grid : bulletGrids) grids += gridBytes(grid);
+    report.add("simulation", "bullet grids", MEMORY_CPU, grids);
+    report.add("simulation", "kinetic schedule", MEMORY_CPU,
+               capacityBytes(kinetic.events, kinetic.rockGeneration, kinetic.rockVX, kinetic.rockVY, kinetic.bulletGeneration,
+                             kinetic.bulletSerial, kinetic.bulletNext, kinetic.changedRocks, kinetic.predictions, kinetic.due));
+    report.add("simulation", "timer wheel", MEMORY_CPU, timers.memoryBytes() + firedTimers.capacity() * sizeof(Timer));
+
+    size_t events = capacityBytes(bulletHits, bulletCandidateCounts, shipEvents, splitEvents, effectEvents);
+    for (const std::vector<BulletHit>& hits : bulletHits) events += capacityBytes(hits);
+    report.add("simulation", "collision events", MEMORY_CPU, events);
+    size_t candidates = capacityBytes(bulletPairs);
+    for (const BulletPairs& chunk : bulletPairs) {
+        candidates += capacityBytes(chunk.rock, chunk.bullet, chunk.sx, chunk.sy, chunk.ex, chunk.ey, chunk.rockRadius, chunk.bulletRadius, chunk.hit);
+    }
+    report.add("simulation", "bullet pair buffers", MEMORY_CPU, candidates);
+    size_t pairs = capacityBytes(sortedX, sortedY, sortedVX, sortedVY, sortedR, sortedIndex, asteroidPairs, asteroidPairCounts, asteroidPairTests);
+    for (const std::vector<AsteroidPair>& row : asteroidPairs) pairs += capacityBytes(row);
+    report.add("simulation", "rock pair search", MEMORY_CPU, pairs);
+    size_t gravity = capacityBytes(gravityTree.keys, gravityTree.sortedKeys, gravityTree.bodyX, gravityTree.bodyY, gravityTree.bodyMass,
+                                   gravityTree.bodyIndex, gravityTree.subtrees, gravityTree.cells, gravityMass);
+    for (const std::vector<GravityCell>& subtree : gravityTree.subtrees) gravity += capacityBytes(subtree);
+    report.add("simulation", "gravity tree", MEMORY_CPU, gravity);
+    report.add("simulation", "missile guidance", MEMORY_CPU,
+               gridBytes(missileRocks.grid) + capacityBytes(missileQueries, missileCenters, missileHits, missileHitCounts, missileClaims,
+                                                            missileTargetX, missileTargetY, missilePull));
+    report.add("simulation", "ship candidates", MEMORY_CPU, capacityBytes(collisionCandidates, scratchX, scratchY, scratchR));
+    report.add("simulation", "spatial sort", MEMORY_CPU, capacityBytes(spatialKeys, spatialOrder, spatialScratch));
+    report.add("simulation", "asteroid shapes", MEMORY_CPU, capacityBytes(asteroidShapes));
+}
+
+void GameWorld::seed(uint64_t seedValue) {
+    spawnRng.seed(seedValue, RNG_STREAM_SPAWN);
+    shapeRng.seed(seedValue, RNG_STREAM_SHAPE);
+    splitRng.seed(seedValue, RNG_STREAM_SPLIT);
+}
+
+void GameWorld::reset() {
+    asteroids.sweep([](size_t) { return true; });
+    bullets.clear();
+    pendingAsteroidRemovals = 0;
+    ships.reset(static_cast<size_t>(limits.ships));
+    isGameOver = false;
+    asteroidSpawnTimer = 0.0f;
+    currentSpawnRate = INITIAL_SPAWN_RATE;
+    score = 0;
+    asteroids.clock = asteroids.previousClock = 0.0;
+    bullets.clock = 0.0;
+    kinetic.clear();
+    tick = 0;
+    timers.reset(tick);
+    waveSteps = 0;
+    waveResumeTick = tick + 1;
+    restartWaves();
+    shedSpawns = shedChildren = 0;
+}
+
+// ============================ SIMULATION TICK ============================
+void GameWorld::step(float dt, const InputState* inputs, size_t inputCount)
+{
+    TraceScope tick("tick", "simulation"); // Holds the tick's phase spans in the trace
+    if (scenarioDriven) maintainScenario(*this);
+
+    // Snapshot for render interpolation
+    ships.savePrevious();
+    if (!lazyAsteroidMotion) asteroids.savePrevious(); // Lazy rocks are drawn from their anchors
+    bullets.savePrevious();
+
+    advanceTimers();
+
+    // --- Input Handling (a lost ship takes none) ---
+    for (size_t s = 0; s < ships.count(); ++s) {
+        if (!ships.alive[s]) continue;
+        const InputState liveInput = s < inputCount ? inputs[s] : InputState();
+        applyInput(s, scenarioDriven ? scenarioInput(liveInput) : liveInput, dt);
+    }
+
+    // --- Physics and Collision Update ---
+    if (!isGameOver)
+    {
+        asteroidSpawnTimer -= dt;
+
+        // Spawn initial LARGE asteroids (on the timer, or as the wave script says)
+        {
+            ProfileScope scope(PHASE_SPAWN, instrumented);
+            if (scriptedWaves) {
+                if (waveDue) runWaves();
+            }
+            else if (asteroidSpawnTimer <= 0.0f && liveAsteroidCount() < static_cast<size_t>(limits.maxAsteroids)) {
+                spawnNewAsteroid(glm::vec2(0.0f, 0.0f), LARGE);
+                currentSpawnRate = glm::max(MIN_SPAWN_RATE, currentSpawnRate - 0.1f);
+                asteroidSpawnTimer = currentSpawnRate;
+            }
+        }
+
+        // Player Physics Update
+        {
+            ProfileScope scope(PHASE_PLAYER_PHYSICS, instrumented);
+            moveShips(dt);
+        }
+
+        // Gravity first, so the move below follows this tick's pull (the tree is built over the rocks as they stand)
+        if (gravityWells || rockGravity) {
+            ProfileScope scope(PHASE_ASTEROID_PHYSICS, instrumented);
+            applyGravity(dt);
+        }
+
+        // Asteroid Physics Update. Submitted as jobs that run alongside the bullet physics; only the
+        // asteroid grid's counting pass depends on them. (With workers, whatever is left of them when the
+        // bullets are done is counted under the next phases.) Lazy rocks only have their positions
+        // written from the anchors: nothing in the tick reads their rotation.
+        JobCounter asteroidsMoved;
+        asteroids.previousClock = asteroids.clock;
+        asteroids.clock += dt;
+        auto moveAsteroids = [this, dt](size_t begin, size_t end) {
+            if (lazyAsteroidMotion) {
+                asteroids.materialize(begin, end);
+                return;
+            }
+            if (fixedPointKinematics) {
+                const int32_t step = toFixed(dt);
+                integrateWrapFixed(asteroids.x.data() + begin, asteroids.vx.data() + begin, end - begin, step);
+                integrateWrapFixed(asteroids.y.data() + begin, asteroids.vy.data() + begin, end - begin, step);
+                integrateAngleFixed(asteroids.rot.data() + begin, asteroids.rotSpeed.data() + begin, end - begin, step);
+                return;
+            }
+            integrateWrap(asteroids.x.data() + begin, asteroids.vx.data() + begin, end - begin, dt);
+            integrateWrap(asteroids.y.data() + begin, asteroids.vy.data() + begin, end - begin, dt);
+            integrateLinear(asteroids.rot.data() + begin, asteroids.rotSpeed.data() + begin, end - begin, dt);
+        };
+        {
+            ProfileScope scope(PHASE_ASTEROID_PHYSICS, instrumented);
+            parallelForAsync(0, asteroids.count(), INTEGRATION_GRAIN, moveAsteroids, asteroidsMoved);
+        }
+
+        // Bullet Physics Update (vectorized integration over every ring slot; bullets past the field
+        // become tombstones, and the ones whose lifetime is over leave from the tail)
+        {
+            ProfileScope scope(PHASE_BULLET_PHYSICS, instrumented);
+            bullets.clock += dt;
+            parallelFor(0, bullets.capacity(), INTEGRATION_GRAIN, [this, dt](size_t begin, size_t end) {
+                if (fixedPointKinematics) {
+                    integrateLinearFixed(bullets.x.data() + begin, bullets.vx.data() + begin, end - begin, toFixed(dt));
+                    integrateLinearFixed(bullets.y.data() + begin, bullets.vy.data() + begin, end - begin, toFixed(dt));
+                    return;
+                }
+                integrateLinear(bullets.x.data() + begin, bullets.vx.data() + begin, end - begin, dt);
+                integrateLinear(bullets.y.data() + begin, bullets.vy.data() + begin, end - begin, dt);
+            });
+            for (size_t j = 0; j < bullets.capacity(); ++j) {
+                if (bullets.live(j) && (abs(bullets.x[j]) > 1.5f || abs(bullets.y[j]) > 1.5f)) bullets.tombstone(j);
+            }
+            bullets.popExpired();
+        }
+
+        // --- Broadphase rebuild: the bullet grid first, while the asteroid jobs may still be running ---
+        {
+            ProfileScope scope(PHASE_BROADPHASE, instrumented);
+            if (!kineticBulletHits && asteroidBroadphase != BROADPHASE_BRUTE_FORCE) {
+                for (SpatialGrid& grid : bulletGrids) grid.build(bullets.x.data(), bullets.y.data(), bullets.capacity());
+            }
+            if (asteroidBroadphase == BROADPHASE_SWEEP_AND_PRUNE) {
+                waitForJobs(asteroidsMoved);
+                asteroidSweep.update(asteroids.x.data(), asteroids.y.data(), asteroids.sizeClass.data(), asteroids.handles, asteroids.count());
+            }
+            else if (asteroidBroadphase == BROADPHASE_GRID) {
+                asteroidGrid.build(asteroids.x.data(), asteroids.y.data(), asteroids.sizeClass.data(), asteroids.count(), &asteroidsMoved);
+            }
+            else waitForJobs(asteroidsMoved); // Brute force: nothing to build
+            if (kineticBulletHits) observeKinetic(dt); // Before any bounce: this tick's paths are the ones just flown
+        }
+
+        // Homing missiles: targets from where the rocks now stand, then the turn the next move follows
+        if (WEAPON_TRAITS[weapon].homing) {
+            ProfileScope scope(PHASE_BULLET_PHYSICS, instrumented);
+            guideMissiles(dt);
+        }
+
+        // The collision kernels built for this tick's configuration
+        const TickKernels kernels = tickKernels();
+        bulletHitLists = asteroidPairLists = 0;
+        bulletCandidates = asteroidCandidates = shipCandidates = 0;
+
+        // Asteroid-Asteroid Collision Response (velocities only, so the grid stays valid for the checks below)
+        if (asteroidCollisions) (this->*kernels.collideAsteroids)();
+
+        // Ship-Asteroid Collision Check (grid candidates, visited in descending index order
+        // to keep the original reverse-loop priority). Only detects: see GAMEPLAY EVENTS.
+        size_t hullsHit = 0;
+        {
+            ProfileScope scope(PHASE_SHIP_COLLISION, instrumented);
+            hullsHit = (this->*kernels.findShipContacts)();
+        }
+
+        // Bullet-Asteroid Collision Check. The search lists, per rock, every bullet whose path this
+        // tick touched it (chunks of rocks in parallel, each into its own list); the kinetic schedule
+        // hands over its due impacts as one list in the same order instead. Skipped when every ship
+        // still in play was hit (one may yet be spared, if another's shield takes its rock first).
+        size_t hitLists = 0;
+        if (hullsHit < ships.aliveCount()) {
+            ProfileScope scope(PHASE_BULLET_COLLISION, instrumented);
+            const size_t rockCount = asteroids.count();
+            hitLists = kineticBulletHits ? 1 : (rockCount + BULLET_COLLISION_GRAIN - 1) / BULLET_COLLISION_GRAIN;
+            if (bulletHits.size() < hitLists) bulletHits.resize(hitLists);
+            bulletHitLists = hitLists;
+            if (kineticBulletHits) {
+                collectKineticHits(dt, bulletHits[0]);
+            }
+            else if (pairBatchedHits && asteroidBroadphase != BROADPHASE_BRUTE_FORCE) { // Its gather reads the bullet grids
+                if (bulletPairs.size() < hitLists) bulletPairs.resize(hitLists);
+                parallelFor(0, hitLists, 1, [this, rockCount, &kernels](size_t first, size_t last) {
+                    for (size_t c = first; c < last; ++c) {
+                        (this->*kernels.gatherBulletPairs)(c * BULLET_COLLISION_GRAIN, std::min(rockCount, (c + 1) * BULLET_COLLISION_GRAIN), bulletPairs[c]);
+                        (this->*kernels.testBulletPairs)(bulletPairs[c], bulletHits[c]);
+                    }
+                });
+                bulletPairCount = bulletPairHits = 0;
+                for (size_t c = 0; c < hitLists; ++c) {
+                    bulletPairCount += bulletPairs[c].size();
+                    bulletPairHits += bulletHits[c].size();
+                }
+                bulletCandidates = bulletPairCount;
+                if (instrumented) {
+                    profilerCount(COUNTER_BULLET_PAIRS, static_cast<long long>(bulletPairCount));
+                    profilerCount(COUNTER_BULLET_PAIR_HITS, static_cast<long long>(bulletPairHits));
+                }
+            }
+            else {
+                if (bulletCandidateCounts.size() < hitLists) bulletCandidateCounts.resize(hitLists);
+                parallelFor(0, hitLists, 1, [this, rockCount, &kernels](size_t first, size_t last) {
+                    for (size_t c = first; c < last; ++c) {
+                        bulletCandidateCounts[c] = (this->*kernels.findBulletHits)(c * BULLET_COLLISION_GRAIN, std::min(rockCount, (c + 1) * BULLET_COLLISION_GRAIN), bulletHits[c]);
+                    }
+                });
+                for (size_t c = 0; c < hitLists; ++c) bulletCandidates += bulletCandidateCounts[c];
+            }
+        }
+
+        // The heatmap of the searches just run, before the resolve moves anything the grid points at
+        if (heatmapLevel >= 0) fillBroadphaseHeatmap(heatmapLevel, heatmap);
+        else heatmap.level = -1;
+
+        // --- Resolve, then spawn the split children and sweep up ---
+        {
+            ProfileScope scope(PHASE_BULLET_COLLISION, instrumented); // Includes the ship's events and the sweep
+            const bool shipsLeft = resolveEvents(hitLists);
+            spawnSplitChildren(); // A rock a shield split before the last hull was hit still splits
+            if (!shipsLeft) return; // Game over: the rest of the tick is skipped, as before
+            if (kineticBulletHits) rescheduleKineticMisses();
+
+            // --- Sweep: compact the rocks flagged this tick in one O(n) pass; spent bullets at the tail leave ---
+            sweepAsteroids();
+            bullets.popExpired();
+            if (scriptedWaves && waveResumeTick == 0 && liveAsteroidCount() == 0 && waves.running()) {
+                waveResumeTick = this->tick + 1; // The field is clear: the script goes on next tick
+                timers.schedule({ waveResumeTick, 0, TIMER_WAVE_RESUME });
+            }
+            const double sortPeriod = ASTEROID_SORT_TICKS * static_cast<double>(SIM_DT);
+            if (spatialSortAsteroids && std::floor(asteroids.clock / sortPeriod) != std::floor(asteroids.previousClock / sortPeriod)) {
+                sortAsteroidsSpatially(); // On the clock, so a restored snapshot re-sorts on the same ticks
+            }
+        }
+    }
+}
+
+// Cooldowns need nothing: they are compared against the tick. A shield's end drops it and starts its
+// cooldown; the cooldown's end is only logged, so uninstrumented worlds never schedule it. The wave
+// script's resume is only noted here: the spawn phase runs it.
+void GameWorld::advanceTimers()
+{
+    ++tick;
+    firedTimers.clear();
+    waveDue = false;
+    timers.advance(tick, firedTimers);
+    for (const Timer& timer : firedTimers) {
+        const size_t s = timer.target;
+        if (timer.event != TIMER_WAVE_RESUME && s >= ships.count()) continue;
+        switch (timer.event) {
+        case TIMER_SHIELD_END:
+            if (!ships.shieldActive[s] || ships.shieldEndTick[s] != timer.due) break; // Absorbed first
+            ships.shieldActive[s] = 0;
+            // A tick sooner than an absorb's: the shield ran out during this tick, whose time counts
+            // towards the cooldown as it did when the timers were countdowns
+            ships.shieldReadyTick[s] = tick + ticksFor(SHIELD_COOLDOWN) - 1;
+            if (instrumented) {
+                timers.schedule({ ships.shieldReadyTick[s], timer.target, TIMER_SHIELD_READY });
+                LOG_INFO("Shield Deactivated. Cooldown started.");
+            }
+            break;
+        case TIMER_SHIELD_READY:
+            if (ships.shieldReadyTick[s] == timer.due && instrumented) LOG_INFO("Shield ready.");
+            break;
+        case TIMER_WAVE_RESUME:
+            waveDue = scriptedWaves && timer.due == waveResumeTick; // Run in the spawn phase
+            break;
+        }
+    }
+}
+
+void GameWorld::rebuildTimers()
+{
+    timers.reset(tick);
+    for (size_t s = 0; s < ships.count(); ++s) {
+        const uint32_t target = static_cast<uint32_t>(s);
+        if (ships.shieldActive[s]) timers.schedule({ ships.shieldEndTick[s], target, TIMER_SHIELD_END });
+        else if (instrumented && ships.shieldReadyTick[s] > tick) timers.schedule({ ships.shieldReadyTick[s], target, TIMER_SHIELD_READY });
+    }
+}
+
+// The script takes no input and touches nothing, so running it again and skipping the commands it
+// already handed over puts it back exactly where it was
+void GameWorld::restartWaves()
+{
+    waves = scriptedWaves ? startWaveScript() : WaveScript();
+    for (uint32_t step = 0; step < waveSteps; ++step) {
+        if (!waves.next()) return;
+    }
+    if (waves.running() && waveResumeTick > tick) timers.schedule({ waveResumeTick, 0, TIMER_WAVE_RESUME });
+}
+
+void GameWorld::runWaves()
+{
+    while (waves.next()) {
+        ++waveSteps;
+        const WaveCommand& command = waves.command();
+        switch (command.type) {
+        case WAVE_SPAWN:
+            for (uint32_t i = 0; i < command.count; ++i) spawnNewAsteroid(glm::vec2(0.0f, 0.0f), command.size, command.side);
+            break;
+        case WAVE_WAIT_TICKS:
+            waveResumeTick = tick + std::max<uint64_t>(command.count, 1);
+            timers.schedule({ waveResumeTick, 0, TIMER_WAVE_RESUME });
+            return;
+        case WAVE_WAIT_FIELD_CLEAR:
+            waveResumeTick = 0; // Until the sweep finds the field clear (already clear: the next sweep)
+            return;
+        }
+    }
+    waveResumeTick = 0;
+    if (instrumented) LOG_INFO("Wave script finished");
+}
+
+// ============================ TIMER WHEEL ============================
+void TimerWheel::reserve(size_t capacity)
+{
+    timers.reserve(capacity);
+    next.reserve(capacity);
+    freeTimers.reserve(capacity);
+}
+
+void TimerWheel::reset(uint64_t tick)
+{
+    timers.clear();
+    next.clear();
+    freeTimers.clear();
+    std::fill(std::begin(nearSlots), std::end(nearSlots), -1);
+    std::fill(std::begin(farSlots), std::end(farSlots), -1);
+    overflow = -1;
+    now = tick;
+    pending = 0;
+}
+
+void TimerWheel::schedule(const Timer& timer)
+{
+    int32_t index = static_cast<int32_t>(timers.size());
+    if (!freeTimers.empty()) {
+        index = freeTimers.back();
+        freeTimers.pop_back();
+    } else {
+        timers.emplace_back();
+        next.push_back(-1);
+    }
+    timers[index] = timer;
+    timers[index].due = std::max(timer.due, now + 1);
+    place(index);
+    ++pending;
+}
+
+void TimerWheel::place(int32_t index)
+{
+    const uint64_t slots = TIMER_WHEEL_SLOTS;
+    const uint64_t due = timers[index].due;
+    if (due - now < slots) push(nearSlots[due % slots], index);
+    else if (due / slots - now / slots < slots) push(farSlots[(due / slots) % slots], index);
+    else push(overflow, index);
+}
+
+void TimerWheel::advance(uint64_t tick, std::vector<Timer>& fired)
+{
+    const uint64_t slots = TIMER_WHEEL_SLOTS;
+    while (now < tick) {
+        ++now;
+        if (now % slots == 0) {
+            // A new block: at a turn of the far wheel the overflow comes closer first, then the
+            // block's far slot moves down into the near wheel
+            const uint64_t block = now / slots;
+            if (block % slots == 0) {
+                int32_t list = overflow;
+                overflow = -1;
+                while (list >= 0) {
+                    const int32_t index = list;
+                    list = next[index];
+                    place(index);
+                }
+            }
+            int32_t list = farSlots[block % slots];
+            farSlots[block % slots] = -1;
+            while (list >= 0) {
+                const int32_t index = list;
+                list = next[index];
+                place(index);
+            }
+        }
+        int32_t& slot = nearSlots[now % slots];
+        for (int32_t index = slot; index >= 0; index = next[index]) {
+            fired.push_back(timers[index]);
+            freeTimers.push_back(index);
+            --pending;
+        }
+        slot = -1;
+    }
+}
+
+size_t TimerWheel::memoryBytes() const
+{
+    return capacityBytes(timers, next, freeTimers) + sizeof(nearSlots) + sizeof(farSlots);
+}
+
+// ============================ GAMEPLAY EVENTS ============================
+// Tests each ship in play (its shield while the shield is up) against the rocks near it in one batch
+// and records what happens, without applying it: the first rock the shield meets is absorbed, which
+// drops the shield, and the candidates after it are tested again against the hull; the first rock
+// the hull meets destroys the ship (a stress scenario ignores those). Ships are tested in order, each
+// with the broadphase query and batch kernel the rocks' checks use.
+template <AsteroidBroadphase Broadphase, bool OutlineTest>
+size_t GameWorld::findShipContacts()
+{
+    shipEvents.clear();
+    size_t hullsHit = 0;
+    for (size_t s = 0; s < ships.count(); ++s) {
+        if (!ships.alive[s]) continue;
+        const glm::vec2 position = ships.position(s);
+        const int ship = static_cast<int>(s);
+        collisionCandidates.clear();
+        forEachAsteroidNear<Broadphase>(position, [this](int index) { collisionCandidates.push_back(index); });
+        std::sort(collisionCandidates.begin(), collisionCandidates.end(), std::greater<int>());
+        shipCandidates += collisionCandidates.size();
+
+        // Gather the candidates and test them in batches of one mask each; bit k of the mask is
+        // candidate first + k
+        bool shield = ships.shieldActive[s] != 0;
+        float shipRadius = ships.collisionRadius(s); // Only changes when the shield breaks below
+        // Near an edge the ship meets rocks across it: test each one at its image nearest the ship.
+        // Against outlines the circle test is the broad one, at the widest any outline reaches.
+        const float outlineReach = OutlineTest ? ASTEROID_MAX_OUTLINE_RADIUS : 1.0f;
+        const bool shipOnBorder = nearWrapEdge(position, shipRadius + getRadiusFactor(LARGE) * outlineReach);
+        bool hullHit = false;
+        for (size_t first = 0; first < collisionCandidates.size() && !hullHit; first += COLLISION_MASK_BITS) {
+            const size_t candidateCount = std::min(COLLISION_MASK_BITS, collisionCandidates.size() - first);
+            for (size_t k = 0; k < candidateCount; ++k) {
+                size_t index = static_cast<size_t>(collisionCandidates[first + k]);
+                scratchX[k] = asteroids.x[index];
+                scratchY[k] = asteroids.y[index];
+                scratchR[k] = asteroids.radius(index) * outlineReach;
+                if (shipOnBorder) {
+                    scratchX[k] = nearestImage(scratchX[k], position.x);
+                    scratchY[k] = nearestImage(scratchY[k], position.y);
+                }
+            }
+            uint64_t hits = circleOverlapMask(position, shipRadius, scratchX.data(), scratchY.data(), scratchR.data(), candidateCount);
+            while (hits != 0) {
+                size_t k = static_cast<size_t>(std::countr_zero(hits));
+                hits &= hits - 1;
+                const int index = collisionCandidates[first + k];
+                if constexpr (OutlineTest) {
+                    if (!touchesAsteroidOutline(position - glm::vec2(scratchX[k], scratchY[k]), shipRadius, asteroids.scale(index),
+                                                asteroidRotation(static_cast<size_t>(index)), asteroids.shapeIndex[index])) {
+                        continue;
+                    }
+                }
+                if (shield) {
+                    shipEvents.push_back({ EVENT_SHIELD_ABSORB, index, 0, ship });
+                    shield = false;
+                    shipRadius = ships.radius[s];
+                    // The hull is smaller than the shield: re-test the candidates not visited yet
+                    uint64_t remaining = k + 1 < COLLISION_MASK_BITS ? ~((uint64_t(1) << (k + 1)) - 1) : 0;
+                    hits = circleOverlapMask(position, shipRadius, scratchX.data(), scratchY.data(), scratchR.data(), candidateCount) & remaining;
+                }
+                else if (!scenarioDriven) { // Stress scenarios never end; the hit is ignored
+                    shipEvents.push_back({ EVENT_SHIP_DESTROYED, index, 0, ship });
+                    ++hullsHit;
+                    hullHit = true;
+                    break;
+                }
+            }
+        }
+    }
+    return hullsHit;
+}
+
+// Applies the tick's events in a fixed order: the ships' contacts in ship order, then the bullet
+// hits rock by rock in descending index order (as one loop over the rocks would), each rock
+// consuming the oldest bullet on its list that no earlier rock took. A rock taken out earlier in the
+// order (by a shield, say) is passed over: the ship that met it after is spared, and its bullets stay
+// free for the rocks after it. Splits only queue their children; points go to the bullet's ship.
+// Returns false once the last ship is lost, with the bullet hits left unapplied.
+bool GameWorld::resolveEvents(size_t hitLists)
+{
+    for (const GameEvent& event : shipEvents) {
+        const size_t index = static_cast<size_t>(event.rock);
+        const size_t s = static_cast<size_t>(event.ship);
+        if (asteroids.destroyed[index]) continue;
+        if (event.type == EVENT_SHIP_DESTROYED) {
+            if (recordEffects && effectEvents.size() < effectEvents.capacity()) {
+                effectEvents.push_back({ ships.position(s), glm::vec2(ships.vx[s], ships.vy[s]), ships.scale[s], EFFECT_SHIP_DESTROYED, 0 });
+            }
+            ships.alive[s] = 0;
+            ships.vx[s] = ships.vy[s] = 0.0f;
+            ships.shieldActive[s] = 0;
+            ships.thrusting[s] = 0;
+            if (ships.aliveCount() > 0) {
+                if (instrumented) LOG_INFO("COLLISION! Ship %zu lost.", s);
+                continue;
+            }
+            if (instrumented) LOG_INFO("COLLISION! GAME OVER.");
+            isGameOver = true;
+            return false;
+        }
+        // EVENT_SHIELD_ABSORB: the rock is destroyed (split if large) and the shield goes into cooldown
+        if (instrumented) LOG_INFO("Shield absorbed collision and destroyed asteroid!");
+        recordRockEffect(index);
+        if (splitsOnHit(asteroids.sizeClass[index])) splitAsteroid(index);
+        else destroyAsteroid(index);
+        ships.shieldActive[s] = 0;
+        ships.shieldReadyTick[s] = tick + ticksFor(SHIELD_COOLDOWN);
+        if (instrumented) {
+            timers.schedule({ ships.shieldReadyTick[s], static_cast<uint32_t>(s), TIMER_SHIELD_READY });
+            LOG_INFO("Shield deactivated. Cooldown started.");
+        }
+    }
+
+    for (size_t c = hitLists; c > 0; --c) {
+        const std::vector<BulletHit>& hits = bulletHits[c - 1];
+        for (size_t h = 0; h < hits.size(); /* advanced per rock */) {
+            const size_t index = static_cast<size_t>(hits[h].rock);
+            int hitBullet = -1;
+            for (; h < hits.size() && hits[h].rock == static_cast<int>(index); ++h) {
+                int j = hits[h].bullet;
+                if (bullets.live(j) && (hitBullet < 0 || bullets.order(j) < bullets.order(hitBullet))) hitBullet = j;
+            }
+            if (hitBullet < 0 || asteroids.destroyed[index]) continue; // No bullet left for it, or no rock left
+
+            bullets.tombstone(hitBullet); // Consumed; its slot is freed once it reaches the tail
+            const int points = getAsteroidPoints(asteroids.sizeClass[index]);
+            score += points;
+            if (bullets.owner[hitBullet] >= 0) ships.score[static_cast<size_t>(bullets.owner[hitBullet])] += points;
+            recordRockEffect(index);
+            if (splitsOnHit(asteroids.sizeClass[index])) splitAsteroid(index); // Split and shrink the larger asteroid
+            else destroyAsteroid(index);
+        }
+    }
+    return true;
+}
+
+void GameWorld::recordRockEffect(size_t index)
+{
+    if (!recordEffects || effectEvents.size() == effectEvents.capacity()) return;
+    const EffectType type = splitsOnHit(asteroids.sizeClass[index]) ? EFFECT_ROCK_SPLIT : EFFECT_ROCK_DESTROYED;
+    effectEvents.push_back({ asteroids.position(index), glm::vec2(asteroids.vx[index], asteroids.vy[index]), asteroids.scale(index),
+                             static_cast<uint8_t>(type), asteroids.paletteIndex[index] });
+}
+
+void GameWorld::recordShotEffect(size_t s)
+{
+    if (!recordEffects || effectEvents.size() == effectEvents.capacity()) return;
+    effectEvents.push_back({ ships.position(s), glm::vec2(ships.vx[s], ships.vy[s]), ships.scale[s], EFFECT_SHOT_FIRED, 0 });
+}
+
+// Spawns the children queued by this tick's splits, in the order the splits happened, each slightly
+// offset from where its parent was (the parent is still in the store until the sweep). They are
+// allocated from the pool all at once and then filled in, so a volley that splits many rocks grows
+// the store once rather than once per child.
+void GameWorld::spawnSplitChildren()
+{
+    const size_t total = std::min(static_cast<size_t>(queuedChildren), asteroids.handles.freeSlots.size());
+    size_t child = asteroids.extend(total);
+    const size_t end = child + total;
+    for (const GameEvent& event : splitEvents) {
+        const size_t parent = static_cast<size_t>(event.rock);
+        const AsteroidSize childSize = asteroidTraits(asteroids.sizeClass[parent]).child;
+        const glm::vec2 position = asteroids.position(parent);
+        const float scale = asteroids.scale(parent);
+        for (int i = 0; i < event.children && child < end; ++i) {
+            float offsetX = (splitRng.uniform() - 0.5f) * scale * 0.5f;
+            float offsetY = (splitRng.uniform() - 0.5f) * scale * 0.5f;
+            asteroids.set(child++, makeAsteroid(position + glm::vec2(offsetX, offsetY), childSize));
+        }
+    }
+    splitEvents.clear();
+    queuedChildren = 0;
+}
+
+// ============================ ASTEROID COLLISIONS ============================
+// Unique pairs from the broadphase (see findGridPairs, findSweepPairs and findAllPairs), found in
+// parallel into per-row or per-chunk lists, then resolved serially in list order, so the result does
+// not depend on the number of workers (it does on the broadphase: each finds the pairs in its own order).
+template <AsteroidBroadphase Broadphase, bool LazyMotion>
+void GameWorld::collideAsteroids()
+{
+    ProfileScope scope(PHASE_ASTEROID_COLLISION, instrumented);
+    constexpr bool Sweep = Broadphase == BROADPHASE_SWEEP_AND_PRUNE;
+    constexpr bool Grid = Broadphase == BROADPHASE_GRID;
+
+    // Gather the rocks in broadphase order: the pair loops then read a grid cell, or a stretch of
+    // the sweep, as one contiguous run (brute force: store order)
+    const size_t sortedCount = Sweep ? asteroidSweep.entries.size() : Grid ? asteroidGrid.count() : asteroids.count();
+    if (sortedX.size() < sortedCount) {
+        for (EntityArray<float>* gathered : { &sortedX, &sortedY, &sortedVX, &sortedVY, &sortedR }) gathered->resize(sortedCount);
+        sortedIndex.resize(sortedCount);
+    }
+    auto gather = [this](size_t k, int index) {
+        size_t i = static_cast<size_t>(index);
+        sortedIndex[k] = index;
+        sortedX[k] = asteroids.x[i];
+        sortedY[k] = asteroids.y[i];
+        sortedVX[k] = asteroids.vx[i];
+        sortedVY[k] = asteroids.vy[i];
+        sortedR[k] = asteroids.radius(i);
+    };
+    if constexpr (Sweep) {
+        parallelFor(0, sortedCount, INTEGRATION_GRAIN, [&](size_t begin, size_t end) {
+            for (size_t k = begin; k < end; ++k) gather(k, asteroidSweep.entries[k].index);
+        });
+    }
+    else if constexpr (!Grid) {
+        parallelFor(0, sortedCount, INTEGRATION_GRAIN, [&](size_t begin, size_t end) {
+            for (size_t k = begin; k < end; ++k) gather(k, static_cast<int>(k));
+        });
+    }
+    else {
+        for (int level = 0; level < ASTEROID_SIZE_COUNT; ++level) {
+            const SpatialGrid& grid = asteroidGrid.levels[level];
+            const size_t base = static_cast<size_t>(asteroidGrid.levelStart[level]);
+            parallelFor(0, static_cast<size_t>(grid.cellStart.back()), INTEGRATION_GRAIN, [&](size_t begin, size_t end) {
+                for (size_t k = begin; k < end; ++k) gather(base + k, grid.entries[k]);
+            });
+        }
+    }
+
+    // One pair list per row of each grid level, or per fixed-size chunk of the sweep (or of the store)
+    size_t lists = 0;
+    if constexpr (!Grid) lists = (sortedCount + SWEEP_PAIR_GRAIN - 1) / SWEEP_PAIR_GRAIN;
+    else for (const SpatialGrid& level : asteroidGrid.levels) lists += static_cast<size_t>(level.dim);
+    if (asteroidPairs.size() < lists) {
+        asteroidPairs.resize(lists);
+        asteroidPairCounts.resize(lists);
+    }
+    if (asteroidPairTests.size() < lists) asteroidPairTests.resize(lists);
+    parallelFor(0, lists, 1, [this, sortedCount](size_t first, size_t last) {
+        for (size_t k = first; k < last; ++k) {
+            const size_t begin = k * SWEEP_PAIR_GRAIN, end = std::min(sortedCount, (k + 1) * SWEEP_PAIR_GRAIN);
+            asteroidPairTests[k] = 0;
+            if constexpr (Sweep) asteroidPairCounts[k] = findSweepPairs(begin, end, asteroidPairs[k], asteroidPairTests[k]);
+            else if constexpr (!Grid) asteroidPairCounts[k] = findAllPairs(begin, end, asteroidPairs[k], asteroidPairTests[k]);
+            else {
+                int level = 0, row = static_cast<int>(k);
+                while (row >= asteroidGrid.levels[level].dim) row -= asteroidGrid.levels[level++].dim;
+                asteroidPairCounts[k] = findGridPairs(level, row, asteroidPairs[k], asteroidPairTests[k]);
+            }
+        }
+    });
+    asteroidPairLists = lists;
+    for (size_t k = 0; k < lists; ++k) asteroidCandidates += asteroidPairTests[k];
+
+    // Equal-density discs: mass goes with the area. Only approaching pairs get an impulse, so an
+    // overlapping pair (two halves of a split, say) drifts apart instead of sticking together.
+    for (size_t list = 0; list < lists; ++list) {
+        const AsteroidPair* listPairs = asteroidPairs[list].data();
+        for (size_t k = 0; k < asteroidPairCounts[list]; ++k) {
+            const AsteroidPair& pair = listPairs[k];
+            const size_t a = static_cast<size_t>(pair.a), b = static_cast<size_t>(pair.b);
+            float dx = nearestImage(asteroids.x[b], asteroids.x[a]) - asteroids.x[a];
+            float dy = nearestImage(asteroids.y[b], asteroids.y[a]) - asteroids.y[a];
+            float distance = std::sqrt(dx * dx + dy * dy);
+            if (distance <= 0.0f) continue; // Concentric: no normal to push along
+            float nx = dx / distance, ny = dy / distance;
+            float approach = (asteroids.vx[b] - asteroids.vx[a]) * nx + (asteroids.vy[b] - asteroids.vy[a]) * ny;
+            if (approach >= 0.0f) continue; // Already separating (an earlier pair this tick may have done it)
+
+            float massA = asteroids.radius(a) * asteroids.radius(a);
+            float massB = asteroids.radius(b) * asteroids.radius(b);
+            float impulse = -2.0f * approach / (massA + massB); // Per unit of the other's mass
+            if constexpr (LazyMotion) {
+                asteroids.reanchor(a);
+                asteroids.reanchor(b);
+            }
+            asteroids.vx[a] -= impulse * massB * nx;
+            asteroids.vy[a] -= impulse * massB * ny;
+            asteroids.vx[b] += impulse * massA * nx;
+            asteroids.vy[b] += impulse * massA * ny;
+        }
+    }
+}
+
+// Within a level, each cell is tested against itself (q after p within its run) and against half
+// of its neighbours (right, and the three below), so every pair of adjacent cells is visited once,
+// from one side. Each rock then meets the larger classes in their own, coarser levels: the full
+// 3x3 there around it (a coarser level's cells cover the larger rock's reach on its own).
+size_t GameWorld::findGridPairs(int level, int row, std::vector<AsteroidPair>& pairs, size_t& tested) const
+{
+    const SpatialGrid& grid = asteroidGrid.levels[level];
+    const int base = asteroidGrid.levelStart[level];
+    const int dim = grid.dim;
+    // (dx, dy) of the neighbours tested from each cell; with dim >= 3 none is another's opposite
+    const int halfShell[4][2] = { { 1, 0 }, { -1, 1 }, { 0, 1 }, { 1, 1 } };
+    size_t count = 0;
+
+    // Tests one gathered rock against the gathered run [first, last), shifted by (shiftX, shiftY)
+    // when the run's cell lies across an edge: centres closer than the sum of the radii, moving
+    // towards each other (a dense field has about as many separating contacts, which the resolve
+    // would skip). Branch-free: every candidate is written, and kept by advancing the count.
+    auto testRun = [&](int p, int first, int last, float shiftX, float shiftY) {
+        if (pairs.size() < count + static_cast<size_t>(last - first)) pairs.resize(std::max(2 * pairs.size(), count + last - first));
+        AsteroidPair* out = pairs.data() + count;
+        tested += static_cast<size_t>(last - first);
+        const float px = sortedX[p], py = sortedY[p], pvx = sortedVX[p], pvy = sortedVY[p], pr = sortedR[p];
+        const int rock = sortedIndex[p];
+        for (int q = first; q < last; ++q) {
+            float dx = (sortedX[q] - px) + shiftX; // Shifted after the subtraction, as wrappedDelta is
+            float dy = (sortedY[q] - py) + shiftY;
+            float reach = pr + sortedR[q];
+            bool closing = (sortedVX[q] - pvx) * dx + (sortedVY[q] - pvy) * dy < 0.0f;
+            out->a = rock;
+            out->b = sortedIndex[q];
+            out += (dx * dx + dy * dy < reach * reach) & closing;
+        }
+        count = static_cast<size_t>(out - pairs.data());
+    };
+    // Across an edge, a neighbour's rocks are met at their image one field width over
+    auto wrapShift = [](int c, int cells) { return c < 0 ? -FIELD_WIDTH : (c >= cells ? FIELD_WIDTH : 0.0f); };
+
+    // Only the row's occupied cells, by bit scan: the empty ones have nothing to pair from
+    grid.forEachOccupied(row * dim, row * dim + dim, [&](int cell) {
+        const int cx = cell - row * dim;
+        const int begin = base + grid.cellStart[cell], end = base + grid.cellStart[cell + 1];
+        for (int p = begin; p < end; ++p) testRun(p, p + 1, end, 0.0f, 0.0f);
+        for (const int* offset : halfShell) {
+            const int nx = cx + offset[0], ny = row + offset[1];
+            const int neighbour = ((ny + dim) % dim) * dim + (nx + dim) % dim;
+            if (!grid.cellOccupied(neighbour)) continue;
+            const int first = base + grid.cellStart[neighbour], last = base + grid.cellStart[neighbour + 1];
+            for (int p = begin; p < end; ++p) testRun(p, first, last, wrapShift(nx, dim), wrapShift(ny, dim));
+        }
+
+        for (int coarser = level + 1; coarser < ASTEROID_SIZE_COUNT; ++coarser) {
+            const SpatialGrid& other = asteroidGrid.levels[coarser];
+            const int otherBase = asteroidGrid.levelStart[coarser];
+            if (other.occupiedCells == 0) continue;
+            for (int p = begin; p < end; ++p) {
+                const int ox = other.cellCoord(sortedX[p]), oy = other.cellCoord(sortedY[p]);
+                for (int dy = -1; dy <= 1; ++dy) {
+                    for (int dx = -1; dx <= 1; ++dx) {
+                        const int nx = ox + dx, ny = oy + dy;
+                        const int neighbour = ((ny + other.dim) % other.dim) * other.dim + (nx + other.dim) % other.dim;
+                        if (!other.cellOccupied(neighbour)) continue;
+                        const int first = otherBase + other.cellStart[neighbour], last = otherBase + other.cellStart[neighbour + 1];
+                        testRun(p, first, last, wrapShift(nx, other.dim), wrapShift(ny, other.dim));
+                    }
+                }
+            }
+        }
+    });
+    return count;
+}
+
+// Each rock is tested against the rocks after it in the order whose extent starts before its own
+// ends, then against those at the far left that its extent reaches across the right edge (a rock
+// across the left edge is found from the right-hand one, so no pair is seen twice)
+size_t GameWorld::findSweepPairs(size_t begin, size_t end, std::vector<AsteroidPair>& pairs, size_t& tested) const
+{
+    const std::vector<SweepEntry>& order = asteroidSweep.entries;
+    const size_t n = order.size();
+    size_t count = 0;
+    auto test = [&](size_t p, size_t q, float shiftX) {
+        if (count == pairs.size()) pairs.resize(std::max<size_t>(2 * pairs.size(), 256));
+        ++tested;
+        float dx = (sortedX[q] - sortedX[p]) + shiftX; // As wrappedDelta has it
+        float dy = wrappedDelta(sortedY[q], sortedY[p]);
+        float reach = sortedR[p] + sortedR[q];
+        bool closing = (sortedVX[q] - sortedVX[p]) * dx + (sortedVY[q] - sortedVY[p]) * dy < 0.0f;
+        pairs[count] = { sortedIndex[p], sortedIndex[q] };
+        count += (dx * dx + dy * dy < reach * reach) & closing;
+    };
+
+    for (size_t p = begin; p < end; ++p) {
+        const float max = sortedX[p] + sortedR[p];
+        for (size_t q = p + 1; q < n && order[q].min < max; ++q) test(p, q, 0.0f);
+        for (size_t q = 0; q < n && order[q].min < max - FIELD_WIDTH; ++q) test(p, q, FIELD_WIDTH);
+    }
+    return count;
+}
+
+// Each rock against every rock after it in store order, at its image nearest the first
+size_t GameWorld::findAllPairs(size_t begin, size_t end, std::vector<AsteroidPair>& pairs, size_t& tested) const
+{
+    const size_t n = asteroids.count();
+    size_t count = 0;
+    for (size_t p = begin; p < end; ++p) {
+        if (pairs.size() < count + n - p) pairs.resize(std::max(2 * pairs.size(), count + n - p));
+        AsteroidPair* out = pairs.data() + count;
+        tested += n - p - 1;
+        for (size_t q = p + 1; q < n; ++q) {
+            float dx = wrappedDelta(sortedX[q], sortedX[p]);
+            float dy = wrappedDelta(sortedY[q], sortedY[p]);
+            float reach = sortedR[p] + sortedR[q];
+            bool closing = (sortedVX[q] - sortedVX[p]) * dx + (sortedVY[q] - sortedVY[p]) * dy < 0.0f;
+            out->a = static_cast<int>(p);
+            out->b = static_cast<int>(q);
+            out += (dx * dx + dy * dy < reach * reach) & closing;
+        }
+        count = static_cast<size_t>(out - pairs.data());
+    }
+    return count;
+}
+
+// ============================ BROADPHASE HEATMAP ============================
+void BroadphaseHeatmap::init(const HierarchicalGrid& grid) {
+    size_t cells = 0;
+    for (const SpatialGrid& level : grid.levels) cells = std::max(cells, static_cast<size_t>(level.dim * level.dim));
+    rocks.reserve(cells);
+    candidates.reserve(cells);
+}
+
+// Read straight off the grid's tables: the rocks have not moved since the build, nor has the store
+// been swept, so every run and entry is the one the searches used
+void GameWorld::fillBroadphaseHeatmap(int level, BroadphaseHeatmap& map) const
+{
+    map.level = -1;
+    if (asteroidBroadphase != BROADPHASE_GRID || level < 0 || level >= ASTEROID_SIZE_COUNT) return;
+    const SpatialGrid& grid = asteroidGrid.levels[level];
+    const int dim = grid.dim;
+    auto rocksIn = [](const SpatialGrid& g, int x, int y) {
+        const int cell = ((y + g.dim) % g.dim) * g.dim + (x + g.dim) % g.dim;
+        return static_cast<uint32_t>(g.cellStart[cell + 1] - g.cellStart[cell]);
+    };
+    map.level = level;
+    map.dim = dim;
+    map.cellSize = grid.cellSize;
+    map.rocks.resize(static_cast<size_t>(dim * dim));
+    map.candidates.assign(static_cast<size_t>(dim * dim), 0);
+    for (int cell = 0; cell < dim * dim; ++cell) map.rocks[static_cast<size_t>(cell)] = static_cast<uint32_t>(grid.cellStart[cell + 1] - grid.cellStart[cell]);
+    const bool bulletSearch = !kineticBulletHits; // The kinetic schedule tests its due bullets instead
+
+    const int halfShell[4][2] = { { 1, 0 }, { -1, 1 }, { 0, 1 }, { 1, 1 } }; // As findGridPairs
+    grid.forEachOccupied(0, dim * dim, [&](int cell) {
+        const int cx = cell % dim, cy = cell / dim;
+        const uint32_t count = map.rocks[static_cast<size_t>(cell)];
+        uint32_t found = 0;
+        if (asteroidCollisions) {
+            found += count * (count - 1) / 2;
+            for (const int* offset : halfShell) found += count * rocksIn(grid, cx + offset[0], cy + offset[1]);
+        }
+        for (int k = grid.cellStart[cell]; k < grid.cellStart[cell + 1]; ++k) {
+            const size_t i = static_cast<size_t>(grid.entries[k]);
+            const glm::vec2 position = asteroids.position(i);
+            for (int coarser = level + 1; asteroidCollisions && coarser < ASTEROID_SIZE_COUNT; ++coarser) {
+                const SpatialGrid& other = asteroidGrid.levels[coarser];
+                if (other.occupiedCells == 0) continue;
+                const int ox = other.cellCoord(position.x), oy = other.cellCoord(position.y);
+                for (int dy = -1; dy <= 1; ++dy) {
+                    for (int dx = -1; dx <= 1; ++dx) found += rocksIn(other, ox + dx, oy + dy);
+                }
+            }
+            if (bulletSearch && !asteroids.destroyed[i]) { // Taken out by a shield: the bullet search skips it
+                bulletGrids[level].forEachNeighbour(position, [&](int j) { found += bullets.live(static_cast<size_t>(j)) ? 1u : 0u; });
+            }
+        }
+        map.candidates[static_cast<size_t>(cell)] = found;
+    });
+
+    map.maxRocks = map.maxCandidates = 0;
+    map.totalCandidates = 0;
+    for (size_t cell = 0; cell < map.rocks.size(); ++cell) {
+        map.maxRocks = std::max(map.maxRocks, map.rocks[cell]);
+        map.maxCandidates = std::max(map.maxCandidates, map.candidates[cell]);
+        map.totalCandidates += map.candidates[cell];
+    }
+}
+
+// ============================ BULLET HIT SEARCH ============================
+// Read-only, so chunks of rocks can be searched on several threads at once. Returns the number of
+// candidates tested. They are tested a mask's worth at a time, so a rock in a crowd of bullets meets
+// them all. AllBullets (the brute-force broadphase) takes every bullet slot instead of the grid's neighbours.
+template <bool LazyMotion, bool OutlineTest, bool AllBullets>
+size_t GameWorld::findBulletHits(size_t begin, size_t end, std::vector<BulletHit>& hits) const
+{
+    hits.clear();
+    size_t tested = 0;
+    const float bulletTravel = maxBulletTravelPerTick();
+    int candidates[COLLISION_MASK_BITS];
+    float candidatePX[COLLISION_MASK_BITS], candidatePY[COLLISION_MASK_BITS];
+    float candidateX[COLLISION_MASK_BITS], candidateY[COLLISION_MASK_BITS], candidateR[COLLISION_MASK_BITS];
+    float distanceSq[COLLISION_MASK_BITS];
+
+    for (size_t i = end; i > begin; --i) {
+        size_t index = i - 1;
+        if (asteroids.destroyed[index]) continue; // Already taken out by the shield
+
+        // The test runs in the rock's frame: the bullet's motion relative to the rock, from last
+        // tick to this one, against a circle of the combined radii.
+        glm::vec2 rockPosition = asteroids.position(index);
+        glm::vec2 rockPrevious(asteroids.px[index], asteroids.py[index]);
+        if constexpr (LazyMotion) {
+            // No previous state is kept; a lazy rock keeps its path across the edges, so one step back along it
+            rockPrevious = rockPosition - glm::vec2(asteroids.vx[index], asteroids.vy[index]) * static_cast<float>(asteroids.clock - asteroids.previousClock);
+        }
+        else if (std::fabs(rockPosition.x - rockPrevious.x) > 1.0f || std::fabs(rockPosition.y - rockPrevious.y) > 1.0f) {
+            rockPrevious = rockPosition; // Wrapped this tick: treat it as stationary
+        }
+        float rockRadius = asteroids.radius(index);
+        const float broadRadius = OutlineTest ? rockRadius * ASTEROID_MAX_OUTLINE_RADIUS : rockRadius;
+
+        // Gather the live bullets around the rock. A bullet can only have touched the rock this
+        // tick if it now lies within one tick of travel of it, so an overlap mask against the
+        // rock's radius widened by that margin rejects nearly every pair before the swept test.
+        // A rock on the border is also hit through its ghost: each bullet path is moved to its
+        // image nearest the rock (bullets themselves never wrap).
+        const bool rockOnBorder = nearWrapEdge(rockPosition, broadRadius + Bullet().radius + bulletTravel);
+        size_t candidateCount = 0;
+        auto testCandidates = [&]() {
+            tested += candidateCount;
+            uint64_t nearby = circleOverlapMask(rockPosition, broadRadius + bulletTravel, candidateX, candidateY, candidateR, candidateCount);
+            if (nearby != 0) {
+                sweptDistanceSquaredBatch(rockPrevious, rockPosition, candidatePX, candidatePY, candidateX, candidateY, candidateCount, distanceSq);
+            }
+            while (nearby != 0) {
+                size_t k = static_cast<size_t>(std::countr_zero(nearby));
+                nearby &= nearby - 1;
+                float reach = broadRadius + candidateR[k];
+                if (distanceSq[k] >= reach * reach) continue;
+                if constexpr (OutlineTest) {
+                    // The narrowphase at the path's closest approach to the rock's centre, in its frame
+                    const glm::vec2 from = glm::vec2(candidatePX[k], candidatePY[k]) - rockPrevious;
+                    const glm::vec2 path = glm::vec2(candidateX[k], candidateY[k]) - rockPosition - from;
+                    const float lengthSq = glm::dot(path, path);
+                    const float t = lengthSq > 0.0f ? glm::clamp(-glm::dot(from, path) / lengthSq, 0.0f, 1.0f) : 0.0f;
+                    if (!touchesAsteroidOutline(from + path * t, candidateR[k], asteroids.scale(index), asteroidRotation<LazyMotion>(index), asteroids.shapeIndex[index])) continue;
+                }
+                hits.push_back({ static_cast<int>(index), candidates[k] });
+            }
+            candidateCount = 0;
+        };
+        auto addCandidate = [&](int j) {
+            float shiftX = 0.0f, shiftY = 0.0f;
+            if (rockOnBorder) {
+                shiftX = nearestImage(bullets.x[j], rockPosition.x) - bullets.x[j];
+                shiftY = nearestImage(bullets.y[j], rockPosition.y) - bullets.y[j];
+            }
+            candidates[candidateCount] = j;
+            candidatePX[candidateCount] = bullets.px[j] + shiftX;
+            candidatePY[candidateCount] = bullets.py[j] + shiftY;
+            candidateX[candidateCount] = bullets.x[j] + shiftX;
+            candidateY[candidateCount] = bullets.y[j] + shiftY;
+            candidateR[candidateCount] = bullets.radius[j];
+            ++candidateCount;
+        };
+        if constexpr (AllBullets) {
+            for (int j = 0; j < static_cast<int>(bullets.capacity()); ++j) {
+                if (!bullets.live(j)) continue;
+                addCandidate(j);
+                if (candidateCount == COLLISION_MASK_BITS) testCandidates();
+            }
+        }
+        else {
+            bulletGrids[asteroids.sizeClass[index]].forEachNeighbour(rockPosition, [&](int j) {
+                if (!bullets.live(j)) return;
+                addCandidate(j);
+                if (candidateCount == COLLISION_MASK_BITS) testCandidates();
+            });
+        }
+        testCandidates();
+    }
+    return tested;
+}
+
+// ============================ PAIR-BATCHED HIT SEARCH ============================
+// Stage one: the search's gather, kept for the whole chunk. Each pair gets the bullet's path in its
+// rock's frame, worked out exactly as the search does, so the hits match it bit for bit.
+template <bool LazyMotion, bool OutlineTest>
+void GameWorld::gatherBulletPairs(size_t begin, size_t end, BulletPairs& pairs) const
+{
+    pairs.count = 0;
+    const float bulletTravel = maxBulletTravelPerTick();
+    for (size_t i = end; i > begin; --i) {
+        size_t index = i - 1;
+        if (asteroids.destroyed[index]) continue;
+
+        glm::vec2 rockPosition = asteroids.position(index);
+        glm::vec2 rockPrevious(asteroids.px[index], asteroids.py[index]);
+        if constexpr (LazyMotion) {
+            rockPrevious = rockPosition - glm::vec2(asteroids.vx[index], asteroids.vy[index]) * static_cast<float>(asteroids.clock - asteroids.previousClock);
+        }
+        else if (std::fabs(rockPosition.x - rockPrevious.x) > 1.0f || std::fabs(rockPosition.y - rockPrevious.y) > 1.0f) {
+            rockPrevious = rockPosition;
+        }
+        const float broadRadius = OutlineTest ? asteroids.radius(index) * ASTEROID_MAX_OUTLINE_RADIUS : asteroids.radius(index);
+
+        const bool rockOnBorder = nearWrapEdge(rockPosition, broadRadius + Bullet().radius + bulletTravel);
+        bulletGrids[asteroids.sizeClass[index]].forEachNeighbour(rockPosition, [&](int j) {
+            if (!bullets.live(j)) return;
+            pairs.grow(1);
+            float shiftX = 0.0f, shiftY = 0.0f;
+            if (rockOnBorder) {
+                shiftX = nearestImage(bullets.x[j], rockPosition.x) - bullets.x[j];
+                shiftY = nearestImage(bullets.y[j], rockPosition.y) - bullets.y[j];
+            }
+            const size_t k = pairs.count++;
+            pairs.rock[k] = static_cast<int>(index);
+            pairs.bullet[k] = j;
+            pairs.sx[k] = (bullets.px[j] + shiftX) - rockPrevious.x;
+            pairs.sy[k] = (bullets.py[j] + shiftY) - rockPrevious.y;
+            pairs.ex[k] = (bullets.x[j] + shiftX) - rockPosition.x;
+            pairs.ey[k] = (bullets.y[j] + shiftY) - rockPosition.y;
+            pairs.rockRadius[k] = broadRadius;
+            pairs.bulletRadius[k] = bullets.radius[j];
+        });
+    }
+}
+
+// Stage two: both circle tests over the whole buffer in one pass, then the outline narrowphase for
+// the pairs that pass, in buffer order
+template <bool LazyMotion, bool OutlineTest>
+void GameWorld::testBulletPairs(BulletPairs& pairs, std::vector<BulletHit>& hits) const
+{
+    hits.clear();
+    const size_t n = pairs.size();
+    if (sweptPairHits(pairs.sx.data(), pairs.sy.data(), pairs.ex.data(), pairs.ey.data(), pairs.rockRadius.data(), pairs.bulletRadius.data(),
+                      maxBulletTravelPerTick(), n, pairs.hit.data()) == 0) return;
+    for (size_t k = 0; k < n; ++k) {
+        if (!pairs.hit[k]) continue;
+        const size_t index = static_cast<size_t>(pairs.rock[k]);
+        if constexpr (OutlineTest) {
+            const glm::vec2 from(pairs.sx[k], pairs.sy[k]);
+            const glm::vec2 path = glm::vec2(pairs.ex[k], pairs.ey[k]) - from;
+            const float lengthSq = glm::dot(path, path);
+            const float t = lengthSq > 0.0f ? glm::clamp(-glm::dot(from, path) / lengthSq, 0.0f, 1.0f) : 0.0f;
+            if (!touchesAsteroidOutline(from + path * t, pairs.bulletRadius[k], asteroids.scale(index), asteroidRotation<LazyMotion>(index), asteroids.shapeIndex[index])) continue;
+        }
+        hits.push_back({ pairs.rock[k], pairs.bullet[k] });
+    }
+}
+
+// ============================ KERNEL DISPATCH ============================
+// Each option is tested once, here, instead of in every loop it shapes. Ship contacts fall back to
+// the runtime rotation: it is read only for the few candidates whose circles already touch.
+GameWorld::TickKernels GameWorld::tickKernels() const
+{
+    constexpr AsteroidBroadphase GRID = BROADPHASE_GRID, SWEEP = BROADPHASE_SWEEP_AND_PRUNE, BRUTE = BROADPHASE_BRUTE_FORCE;
+    const AsteroidBroadphase broadphase = asteroidBroadphase;
+    const bool lazy = lazyAsteroidMotion;
+    const bool bulletOutlines = silhouetteHits && !kineticBulletHits; // The kinetic schedule predicts against circles
+    TickKernels kernels;
+    switch (broadphase) {
+    case BROADPHASE_GRID:
+        kernels.collideAsteroids = lazy ? &GameWorld::collideAsteroids<GRID, true> : &GameWorld::collideAsteroids<GRID, false>;
+        kernels.findShipContacts = silhouetteHits ? &GameWorld::findShipContacts<GRID, true> : &GameWorld::findShipContacts<GRID, false>;
+        break;
+    case BROADPHASE_SWEEP_AND_PRUNE:
+        kernels.collideAsteroids = lazy ? &GameWorld::collideAsteroids<SWEEP, true> : &GameWorld::collideAsteroids<SWEEP, false>;
+        kernels.findShipContacts = silhouetteHits ? &GameWorld::findShipContacts<SWEEP, true> : &GameWorld::findShipContacts<SWEEP, false>;
+        break;
+    case BROADPHASE_BRUTE_FORCE:
+        kernels.collideAsteroids = lazy ? &GameWorld::collideAsteroids<BRUTE, true> : &GameWorld::collideAsteroids<BRUTE, false>;
+        kernels.findShipContacts = silhouetteHits ? &GameWorld::findShipContacts<BRUTE, true> : &GameWorld::findShipContacts<BRUTE, false>;
+        break;
+    }
+    if (broadphase == BROADPHASE_BRUTE_FORCE) {
+        kernels.findBulletHits = lazy ? (bulletOutlines ? &GameWorld::findBulletHits<true, true, true> : &GameWorld::findBulletHits<true, false, true>)
+                                      : (bulletOutlines ? &GameWorld::findBulletHits<false, true, true> : &GameWorld::findBulletHits<false, false, true>);
+    }
+    else {
+        kernels.findBulletHits = lazy ? (bulletOutlines ? &GameWorld::findBulletHits<true, true, false> : &GameWorld::findBulletHits<true, false, false>)
+                                      : (bulletOutlines ? &GameWorld::findBulletHits<false, true, false> : &GameWorld::findBulletHits<false, false, false>);
+    }
+    kernels.gatherBulletPairs = lazy ? (bulletOutlines ? &GameWorld::gatherBulletPairs<true, true> : &GameWorld::gatherBulletPairs<true, false>)
+                                     : (bulletOutlines ? &GameWorld::gatherBulletPairs<false, true> : &GameWorld::gatherBulletPairs<false, false>);
+    kernels.testBulletPairs = lazy ? (bulletOutlines ? &GameWorld::testBulletPairs<true, true> : &GameWorld::testBulletPairs<true, false>)
+                                   : (bulletOutlines ? &GameWorld::testBulletPairs<false, true> : &GameWorld::testBulletPairs<false, false>);
+    return kernels;
+}
+
+// ============================ KINETIC HIT SCHEDULING ============================
+const double KINETIC_NEVER = std::numeric_limits<double>::infinity();
+
+void KineticSchedule::init(size_t rockCapacity, size_t bulletCapacity) {
+    rockGeneration.assign(rockCapacity, 0);
+    rockVX.assign(rockCapacity, 0.0f);
+    rockVY.assign(rockCapacity, 0.0f);
+    bulletGeneration.assign(bulletCapacity, 0);
+    bulletSerial.assign(bulletCapacity, 0);
+    bulletNext.assign(bulletCapacity, KINETIC_NEVER);
+    changedRocks.reserve(rockCapacity);
+    predictions.resize(bulletCapacity);
+    due.reserve(bulletCapacity);
+    events.reserve(2 * bulletCapacity);
+    clear();
+}
+
+void KineticSchedule::clear() {
+    clock = 0.0;
+    events.clear();
+    std::fill(rockGeneration.begin(), rockGeneration.end(), 0);
+    std::fill(bulletGeneration.begin(), bulletGeneration.end(), 0);
+}
+
+static bool kineticEventLater(const KineticEvent& a, const KineticEvent& b) {
+    return a.time > b.time;
+}
+
+// Earliest t in [t0, t1] at which the bullet comes within `reach` of the rock or one of its images a
+// field width over (infinity if it never does). Bullets do not wrap, so the rules are the per-tick
+// search's: the rock is met where it is in the field, and at its other images only while it lies
+// near an edge.
+static float timeOfImpact(glm::vec2 bullet, glm::vec2 bulletVelocity, glm::vec2 rock, glm::vec2 rockVelocity, float reach, float t0, float t1) {
+    const glm::vec2 offset = bullet - rock, velocity = bulletVelocity - rockVelocity;
+    // The images (rock + FIELD_WIDTH * k) whose relative path over the window passes within reach, per axis
+    auto imageRange = [&](float o, float v, int& first, int& last) {
+        float lo = std::min(o + v * t0, o + v * t1), hi = std::max(o + v * t0, o + v * t1);
+        first = static_cast<int>(std::ceil((lo - reach) / FIELD_WIDTH));
+        last = static_cast<int>(std::floor((hi + reach) / FIELD_WIDTH));
+    };
+    int firstX, lastX, firstY, lastY;
+    imageRange(offset.x, velocity.x, firstX, lastX);
+    imageRange(offset.y, velocity.y, firstY, lastY);
+    // Decided, like the search does, where the rock is at the end of each tick (the clock sits on a
+    // tick boundary), so a contact can start counting a few ticks in, once its rock nears an edge
+    const float border = reach + maxBulletTravelPerTick();
+    auto counts = [&](glm::vec2 image, int tick) {
+        glm::vec2 at = image + rockVelocity * (static_cast<float>(tick) * SIM_DT);
+        glm::vec2 wrapped(nearestImage(at.x, 0.0f), nearestImage(at.y, 0.0f));
+        return at == wrapped || nearWrapEdge(wrapped, border);
+    };
+    // The first tick ending after t0 that the contact [enter, leave] counts in, as a time within it
+    const int firstTick = static_cast<int>(std::floor(t0 / SIM_DT)) + 1;
+    auto firstCounted = [&](glm::vec2 image, float enter, float leave) {
+        leave = std::min(leave, t1);
+        for (int tick = std::max(firstTick, static_cast<int>(std::ceil(enter / SIM_DT))); (tick - 1) * SIM_DT < leave; ++tick) {
+            if (counts(image, tick)) return std::max(enter, (static_cast<float>(tick) - 0.5f) * SIM_DT);
+        }
+        return std::numeric_limits<float>::infinity();
+    };
+
+    const float a = velocity.x * velocity.x + velocity.y * velocity.y;
+    float earliest = std::numeric_limits<float>::infinity();
+    for (int kx = firstX; kx <= lastX; ++kx) {
+        for (int ky = firstY; ky <= lastY; ++ky) {
+            const glm::vec2 shift(kx * FIELD_WIDTH, ky * FIELD_WIDTH);
+            const glm::vec2 p = offset - shift;
+            const glm::vec2 start = p + velocity * t0;
+            float enter, leave;
+            if (a <= 0.0f) {
+                if (start.x * start.x + start.y * start.y >= reach * reach) continue;
+                enter = t0; // Touching and staying so
+                leave = t1;
+            } else {
+                float b = p.x * velocity.x + p.y * velocity.y;
+                float disc = b * b - a * (p.x * p.x + p.y * p.y - reach * reach);
+                if (disc < 0.0f) continue;
+                enter = std::max(t0, (-b - std::sqrt(disc)) / a);
+                leave = (-b + std::sqrt(disc)) / a;
+                if (leave < t0 || enter > t1 || enter >= earliest) continue;
+            }
+            earliest = std::min(earliest, firstCounted(rock + shift, enter, leave));
+        }
+    }
+    return earliest;
+}
+
+// The window a bullet can still hit something in: until its lifetime runs out or it leaves the 1.5
+// box, whichever comes first (seconds from the clock)
+static float kineticLifeLeft(const BulletStore& bullets, size_t j) {
+    float until = static_cast<float>(bullets.expiresAt[j] - bullets.clock);
+    if (bullets.vx[j] != 0.0f) until = std::min(until, ((bullets.vx[j] > 0.0f ? 1.5f : -1.5f) - bullets.x[j]) / bullets.vx[j]);
+    if (bullets.vy[j] != 0.0f) until = std::min(until, ((bullets.vy[j] > 0.0f ? 1.5f : -1.5f) - bullets.y[j]) / bullets.vy[j]);
+    return until;
+}
+
+KineticEvent GameWorld::predictKineticHit(size_t j, const int* rocks, size_t rockCount, float from) const {
+    KineticEvent next = {};
+    next.time = KINETIC_NEVER;
+    const float until = kineticLifeLeft(bullets, j);
+    if (until < from) return next;
+
+    const size_t count = rocks ? rockCount : asteroids.count();
+    float earliest = std::numeric_limits<float>::infinity();
+    for (size_t k = 0; k < count; ++k) {
+        const size_t i = rocks ? static_cast<size_t>(rocks[k]) : k;
+        if (asteroids.destroyed[i]) continue;
+        earliest = std::min(earliest, timeOfImpact(bullets.position(j), glm::vec2(bullets.vx[j], bullets.vy[j]), asteroids.position(i),
+                                                   glm::vec2(asteroids.vx[i], asteroids.vy[i]), asteroids.radius(i) + bullets.radius[j],
+                                                   from, std::min(until, earliest)));
+    }
+    if (earliest == std::numeric_limits<float>::infinity()) return next;
+
+    const EntityHandle bullet = bullets.handle(j);
+    next.time = kinetic.clock + earliest;
+    next.bullet = bullet.slot;
+    next.bulletGeneration = bullet.generation;
+    return next;
+}
+
+void GameWorld::scheduleKineticHit(size_t j, const int* rocks, size_t rockCount, float from) {
+    KineticEvent next = predictKineticHit(j, rocks, rockCount, from);
+    queueKineticEvent(next);
+}
+
+void GameWorld::queueKineticEvent(KineticEvent& next) {
+    if (next.time >= kinetic.bulletNext[next.bullet]) return;
+    next.serial = ++kinetic.bulletSerial[next.bullet];
+    kinetic.bulletNext[next.bullet] = next.time;
+    kinetic.events.push_back(next);
+    std::push_heap(kinetic.events.begin(), kinetic.events.end(), kineticEventLater);
+}
+
+// Called once the rocks and bullets have moved to the end of the tick. Anything new, and any rock
+// whose velocity changed, moved in a straight line since the tick began, so the predictions cover
+// the whole tick (from -dt) like the per-tick search's swept test does. A rock that wrapped counts
+// as changed too: the wrap puts it on the far edge, not a field width over, so it lost its overshoot
+// (not so a lazy rock, which keeps it).
+void GameWorld::observeKinetic(float dt) {
+    kinetic.clock += dt;
+    if (kinetic.rockGeneration.size() < asteroids.handles.generation.size() ||
+        kinetic.bulletGeneration.size() < bullets.capacity()) {
+        kinetic.init(asteroids.handles.generation.size(), bullets.capacity());
+    }
+
+    kinetic.changedRocks.clear();
+    for (size_t i = 0; i < asteroids.count(); ++i) {
+        const EntityHandle handle = asteroids.handles.handle(i);
+        const bool wrapped = !lazyAsteroidMotion &&
+                             (std::fabs(asteroids.x[i] - asteroids.px[i]) > 1.0f || std::fabs(asteroids.y[i] - asteroids.py[i]) > 1.0f);
+        if (kinetic.rockGeneration[handle.slot] == handle.generation + 1 && !wrapped &&
+            kinetic.rockVX[handle.slot] == asteroids.vx[i] && kinetic.rockVY[handle.slot] == asteroids.vy[i]) continue;
+        kinetic.rockGeneration[handle.slot] = handle.generation + 1;
+        kinetic.rockVX[handle.slot] = asteroids.vx[i];
+        kinetic.rockVY[handle.slot] = asteroids.vy[i];
+        kinetic.changedRocks.push_back(static_cast<int>(i));
+    }
+
+    // New bullets against every rock, the others against the changed rocks only (in parallel), then
+    // the improvements are queued in bullet order
+    if (kinetic.predictions.size() < bullets.capacity()) kinetic.predictions.resize(bullets.capacity());
+    parallelFor(0, bullets.capacity(), KINETIC_PREDICTION_GRAIN, [this, dt](size_t begin, size_t end) {
+        for (size_t j = begin; j < end; ++j) {
+            const EntityHandle handle = bullets.handle(j);
+            const bool seen = kinetic.bulletGeneration[handle.slot] == handle.generation + 1;
+            if (!bullets.live(j) || (seen && kinetic.changedRocks.empty())) {
+                kinetic.predictions[j].time = KINETIC_NEVER;
+                continue;
+            }
+            kinetic.predictions[j] = seen ? predictKineticHit(j, kinetic.changedRocks.data(), kinetic.changedRocks.size(), -dt)
+                                          : predictKineticHit(j, nullptr, 0, -dt);
+        }
+    });
+    for (size_t j = 0; j < bullets.capacity(); ++j) {
+        if (!bullets.live(j)) continue;
+        const EntityHandle handle = bullets.handle(j);
+        if (kinetic.bulletGeneration[handle.slot] != handle.generation + 1) {
+            kinetic.bulletGeneration[handle.slot] = handle.generation + 1;
+            kinetic.bulletNext[handle.slot] = KINETIC_NEVER;
+        }
+        if (kinetic.predictions[j].time != KINETIC_NEVER) queueKineticEvent(kinetic.predictions[j]);
+    }
+
+    // Outdated entries only leave the queue by surfacing; drop them all once they pile up
+    if (kinetic.events.size() > 4 * bullets.capacity() + 256) {
+        auto outdated = [this](const KineticEvent& e) {
+            return bullets.generation[e.bullet] != e.bulletGeneration || kinetic.bulletSerial[e.bullet] != e.serial;
+        };
+        kinetic.events.erase(std::remove_if(kinetic.events.begin(), kinetic.events.end(), outdated), kinetic.events.end());
+        std::make_heap(kinetic.events.begin(), kinetic.events.end(), kineticEventLater);
+    }
+}
+
+// Pops every impact due by the end of this tick. A prediction only says when a bullet's first
+// contact is; the hits are then every live rock its path touched this tick, the lists the
+// per-tick search would have made for it, so the resolve settles shared rocks the same way. A
+// bullet that touches nothing after all (its rock was shot, or turned) is predicted again.
+void GameWorld::collectKineticHits(float dt, std::vector<BulletHit>& hits) {
+    hits.clear();
+    kinetic.due.clear();
+    std::vector<KineticEvent>& events = kinetic.events;
+    while (!events.empty() && events.front().time <= kinetic.clock) {
+        std::pop_heap(events.begin(), events.end(), kineticEventLater);
+        KineticEvent e = events.back();
+        events.pop_back();
+        if (bullets.generation[e.bullet] != e.bulletGeneration || kinetic.bulletSerial[e.bullet] != e.serial) continue;
+        kinetic.bulletNext[e.bullet] = KINETIC_NEVER;
+        const size_t j = e.bullet; // A ring slot (a bullet a compaction moved fails the check above)
+
+        const size_t before = hits.size();
+        bulletCandidates += asteroids.count();
+        const float until = std::min(0.0f, kineticLifeLeft(bullets, j));
+        for (size_t i = 0; i < asteroids.count(); ++i) {
+            if (asteroids.destroyed[i]) continue;
+            float t = timeOfImpact(bullets.position(j), glm::vec2(bullets.vx[j], bullets.vy[j]), asteroids.position(i),
+                                   glm::vec2(asteroids.vx[i], asteroids.vy[i]), asteroids.radius(i) + bullets.radius[j], -dt, until);
+            if (t <= until) hits.push_back({ static_cast<int>(i), static_cast<int>(j) });
+        }
+        if (hits.size() == before) scheduleKineticHit(j, nullptr, 0, 0.0f);
+        else kinetic.due.push_back(e);
+    }
+
+    // The resolve's order: rocks from the highest index down (each rock's bullets by slot)
+    std::sort(hits.begin(), hits.end(), [](const BulletHit& a, const BulletHit& b) {
+        return a.rock != b.rock ? a.rock > b.rock : a.bullet < b.bullet;
+    });
+}
+
+// Bullets that reached rocks this tick but lost them all to other bullets fly on
+void GameWorld::rescheduleKineticMisses() {
+    for (const KineticEvent& e : kinetic.due) {
+        const size_t j = e.bullet;
+        if (bullets.live(j)) scheduleKineticHit(j, nullptr, 0, 0.0f);
+    }
+}
@@ -0,0 +1,1453 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <bit>
+#include <coroutine>
+#include <exception>
+#include <utility>
+
+#include <glm/glm.hpp>
+
+#include "entitymemory.h"
+#include "random.h"
+
+struct MemoryReport;
+
+// Game simulation: entity state, spawning, physics and collision.
+// Nothing declared here depends on GL or GLFW, so it can run without a window (headless mode).
+
+// ============================ SHIELD CONSTANTS ============================
+const float SHIELD_RADIUS_FACTOR = 0.18f; // Radius of the shield in normalized coordinates
+const float SHIELD_DURATION = 3.0f; // Shield active time in seconds
+const float SHIELD_COOLDOWN = 5.0f; // Cooldown after shield deactivates
+
+// ============================ ASTEROID SIZE DEFINITIONS ============================
+enum AsteroidSize { SMALL, MEDIUM, LARGE };
+const int ASTEROID_SIZE_COUNT = 3;
+
+// Everything that depends on a rock's size, per class. Rocks keep only their class; the simulation
+// and the renderers look the rest up here. The class is also the rock's level in the hierarchical
+// grid, and its on-screen level of detail comes from scale (asteroidLodForPixelRadius).
+struct AsteroidSizeTraits {
+    float scale;          // Of the shared unit-radius shape
+    float radius;         // For collision, relative to the same 1.0f base radius
+    int points;           // For shooting one (the arcade values: the smaller, the more)
+    AsteroidSize child;   // What it splits into
+    int childCount;       // How many (0: it is destroyed instead)
+};
+
+inline constexpr AsteroidSizeTraits asteroidSizeTraits[ASTEROID_SIZE_COUNT] = {
+    /* SMALL  */ { 0.04f, 0.04f, 100, SMALL, 0 },
+    /* MEDIUM */ { 0.08f, 0.08f, 50, SMALL, 2 },
+    /* LARGE  */ { 0.15f, 0.15f, 20, MEDIUM, 2 },
+};
+
+constexpr const AsteroidSizeTraits& asteroidTraits(AsteroidSize size) { return asteroidSizeTraits[size]; }
+constexpr float getScaleFactor(AsteroidSize size) { return asteroidTraits(size).scale; }
+constexpr float getRadiusFactor(AsteroidSize size) { return asteroidTraits(size).radius; }
+constexpr int getAsteroidPoints(AsteroidSize size) { return asteroidTraits(size).points; }
+constexpr bool splitsOnHit(AsteroidSize size) { return asteroidTraits(size).childCount > 0; }
+
+// ============================ SHIP/GAME STATE STRUCT ============================
+struct Ship {
+    glm::vec2 position = glm::vec2(0.0f, 0.0f);
+    glm::vec2 velocity = glm::vec2(0.0f, 0.0f);
+    float rotation = 0.0f;
+    float scale = getScaleFactor(SMALL); // Ship size is now based on a small scale
+    float radius = getRadiusFactor(SMALL);
+    glm::vec2 prevPosition = glm::vec2(0.0f, 0.0f); // State at the previous sim tick (for interpolation)
+    float prevRotation = 0.0f;
+};
+// The world keeps its ships in a ShipStore (below); this is one ship's copy, for the renderers
+
+// ============================ PHYSICS CONSTANTS ============================
+const float THRUST_SPEED = 2.5f;
+const float ROTATION_SPEED = 2.0f;
+const float FRICTION = 0.995f;
+
+// ============================ BULLET CONSTANTS ============================
+const float BULLET_SPEED = 2.5f;
+const float FIRE_RATE = 0.2f;
+const float BULLET_LIFETIME = 1.0f; // Seconds before an unspent bullet expires
+
+// ============================ HOMING MISSILES ============================
+// The missiles weapon's rounds live in the bullet ring like any bullet, each with the handle of the
+// rock it steers for (BulletStore::target). Every MISSILE_RETARGET_TICKS ticks all of them are
+// assigned afresh in one batch; in between, only the ones without a live target (just fired, or
+// theirs was shot) are, in a batch of their own. A batch indexes the rocks (spatialquery.h), asks
+// one kNN query per missile for its MISSILE_CANDIDATES nearest over the job system, then hands out
+// the targets in firing order: each missile takes the nearest of its candidates that fewer than
+// MISSILE_CLAIMS_PER_ROCK others already steer for (the nearest of all if none is left), so a volley
+// spreads over the rocks instead of piling onto one. Every tick one SIMD pass over the whole ring
+// (steerMissiles) turns each missile towards its target's nearest image at MISSILE_TURN_ACCEL and
+// caps its speed at MISSILE_MAX_SPEED (GameWorld::guideMissiles).
+const float MISSILE_LAUNCH_SPEED = 1.0f;
+const float MISSILE_MAX_SPEED = 1.6f;
+const float MISSILE_TURN_ACCEL = 5.0f; // Field units / s^2 towards the target
+const float MISSILE_LIFETIME = 2.5f;
+const uint64_t MISSILE_RETARGET_TICKS = 12; // Ten times a second
+const size_t MISSILE_CANDIDATES = 4; // Nearest rocks each missile chooses from
+const uint16_t MISSILE_CLAIMS_PER_ROCK = 2;
+
+// ============================ WEAPONS ============================
+// What one pull of the trigger fires: a volley of `bullets` spread evenly over `spread` radians about
+// the ship's facing, the k-th of them slowed by speedStagger * k / (bullets - 1) of BULLET_SPEED so a
+// burst strings out along its line of fire, then `cooldown` seconds before the next. A volley goes
+// into the bullet ring through one reservation (BulletStore::pushVolley) and makes one shot effect,
+// so a wide weapon costs the input handling and the effects no more than the blaster. Its rounds
+// leave at `speed` and last `lifetime` seconds; `homing` ones are steered (HOMING MISSILES above).
+// Every ship of a game carries the same weapon (GameWorld::weapon, --weapon); the pool is sized for it.
+enum WeaponKind : uint8_t {
+    WEAPON_BLASTER, // The original gun: one bullet every FIRE_RATE
+    WEAPON_SPREAD,
+    WEAPON_BURST,
+    WEAPON_MISSILES,
+    WEAPON_COUNT
+};
+
+struct WeaponTraits {
+    const char* name;
+    int bullets;
+    float spread;
+    float speedStagger;
+    float cooldown;
+    float speed;
+    float lifetime;
+    bool homing;
+};
+
+const WeaponTraits WEAPON_TRAITS[WEAPON_COUNT] = {
+    { "blaster", 1, 0.0f, 0.0f, FIRE_RATE, BULLET_SPEED, BULLET_LIFETIME, false },
+    { "spread", 12, 0.7f, 0.0f, 0.35f, BULLET_SPEED, BULLET_LIFETIME, false },
+    { "burst", 32, 0.08f, 0.4f, 0.6f, BULLET_SPEED, BULLET_LIFETIME, false },
+    { "missiles", 24, 2.0f, 0.0f, 1.0f, MISSILE_LAUNCH_SPEED, MISSILE_LIFETIME, true },
+};
+
+bool parseWeapon(const char* name, WeaponKind& weapon); // "blaster", "spread", "burst", "missiles"; false if unknown
+
+// ============================ SPAWNING CONSTANTS ============================
+const float INITIAL_SPAWN_RATE = 5.0f;
+const float MIN_SPAWN_RATE = 1.0f;
+const int MAX_ASTEROIDS = 20;
+const float MAX_ASTEROID_SPEED = 0.7f; // Fastest spawn speed (split children: 0.3 + up to 0.4)
+
+// The edge a rock spawned from outside the field comes in over
+enum SpawnSide : uint8_t { SPAWN_ANY_SIDE, SPAWN_TOP, SPAWN_BOTTOM, SPAWN_LEFT, SPAWN_RIGHT };
+
+// ============================ ENTITY POOL CAPACITIES ============================
+// Both stores are allocated once at these sizes and never grow.
+// Asteroids: rocks flagged this tick stay in the store until the sweep, and a split only adds
+// children while fewer than MAX_ASTEROIDS are live, so live + pending never exceeds 2 * MAX_ASTEROIDS.
+// Bullets: one per FIRE_RATE, each living BULLET_LIFETIME, plus a slot of slack for tick rounding.
+const int ASTEROID_POOL_CAPACITY = 2 * MAX_ASTEROIDS;
+const int MAX_BULLETS = static_cast<int>(BULLET_LIFETIME / FIRE_RATE + 0.5f) + 2;
+// The same for one ship carrying `weapon`: a volley per cooldown over its rounds' lifetime, with two volleys of slack
+inline int maxBulletsFor(WeaponKind weapon) { // MAX_BULLETS for the blaster
+    return (static_cast<int>(WEAPON_TRAITS[weapon].lifetime / WEAPON_TRAITS[weapon].cooldown + 0.5f) + 2) * WEAPON_TRAITS[weapon].bullets;
+}
+
+// Runtime limits, fixed before GameWorld::init. The game runs at the constants above; the stress
+// scenarios (scenario.h) raise them. Pools are reserved from these, never from the constants.
+struct SimulationLimits {
+    int maxAsteroids = MAX_ASTEROIDS;
+    int maxBullets = MAX_BULLETS; // Shared by every ship (raise it with the ships)
+    int ships = 1; // Ship 0 is the local player's
+    int asteroidPoolCapacity() const { return 2 * maxAsteroids; } // Same reasoning as ASTEROID_POOL_CAPACITY
+};
+extern SimulationLimits simulationLimits; // Limits the game's own world is initialized with
+
+// ============================ SIMULATION TIMESTEP ============================
+// The simulation advances in fixed ticks decoupled from the display rate; the renderer
+// interpolates between the last two ticks. FRICTION was tuned per frame at 60 fps, so it is
+// converted once to the equivalent per-tick factor.
+const float SIM_TICK_RATE = 120.0f; // Simulation ticks per second
+const float SIM_DT = 1.0f / SIM_TICK_RATE;
+// Whole ticks a timer of `seconds` runs for (the ticks a countdown by SIM_DT takes to reach zero)
+inline uint64_t ticksFor(float seconds) { return static_cast<uint64_t>(std::ceil(seconds / SIM_DT - 1e-3f)); }
+extern const float FRICTION_PER_TICK;
+
+// Keys held during one sim tick (built from timestamped key events, see simthread.h)
+struct InputState {
+    bool left = false;
+    bool right = false;
+    bool thrust = false;
+    bool fire = false;
+    bool shield = false;
+};
+
+// One bit per key, for passing input between threads and storing it in recordings
+const uint8_t INPUT_LEFT = 1;
+const uint8_t INPUT_RIGHT = 2;
+const uint8_t INPUT_THRUST = 4;
+const uint8_t INPUT_FIRE = 8;
+const uint8_t INPUT_SHIELD = 16;
+
+inline uint8_t packInput(const InputState& input) {
+    return static_cast<uint8_t>((input.left ? INPUT_LEFT : 0) | (input.right ? INPUT_RIGHT : 0) | (input.thrust ? INPUT_THRUST : 0) |
+                                (input.fire ? INPUT_FIRE : 0) | (input.shield ? INPUT_SHIELD : 0));
+}
+
+inline InputState unpackInput(uint8_t bits) {
+    InputState input;
+    input.left = (bits & INPUT_LEFT) != 0;
+    input.right = (bits & INPUT_RIGHT) != 0;
+    input.thrust = (bits & INPUT_THRUST) != 0;
+    input.fire = (bits & INPUT_FIRE) != 0;
+    input.shield = (bits & INPUT_SHIELD) != 0;
+    return input;
+}
+
+// ============================ STRUCTS ============================
+struct Asteroid {
+    glm::vec2 position, velocity;
+    float rotation, rotationSpeed;
+    AsteroidSize size;
+    uint8_t paletteIndex = 0; // Its color: an entry of asteroidPalette
+    int shapeIndex = 0; // Which outline of the shared shape atlas this rock uses
+    bool destroyed = false; // Flagged during collision, swept at the end of the tick
+
+    float scale() const { return getScaleFactor(size); }
+    float radius() const { return getRadiusFactor(size); }
+};
+
+// ============================ ASTEROID PALETTE ============================
+// Rocks are painted from a fixed palette and keep only the entry. The renderer holds the same colors
+// in a uniform block and works out the darker fill and brighter outline from them in its shaders.
+const int ASTEROID_PALETTE_SIZE = 5;
+extern const glm::vec3 asteroidPalette[ASTEROID_PALETTE_SIZE];
+
+// ============================ ASTEROID SHAPE ATLAS ============================
+// All jagged outlines are generated once at startup and packed into a single static VBO,
+// so spawning and splitting never touch GL objects.
+const int ASTEROID_SHAPE_COUNT = 32; // Number of distinct pre-generated silhouettes
+
+// Every shape is stored at several levels of detail, coarsest first. Each level keeps every Nth
+// boundary point of the finest one, so a rock keeps its silhouette when its level changes.
+const int ASTEROID_LOD_COUNT = 4;
+constexpr int ASTEROID_LOD_SEGMENTS[ASTEROID_LOD_COUNT] = { 8, 16, 32, 64 }; // Each divides the last
+const float ASTEROID_MAX_OUTLINE_RADIUS = 1.2f; // Boundary points sit at 0.8-1.2x the normalized radius
+const float ASTEROID_LOD_EDGE_PIXELS = 24.0f; // Longest boundary edge a level may draw on screen (about the old 20-segment look at 800x600)
+
+struct AsteroidMesh {
+    int baseVertex;  // Center vertex of the fan inside the atlas
+    int vertexCount; // Center + closed boundary (GL_TRIANGLE_FAN count)
+};
+// Collisions test against the drawn outline rather than the rock's circle (GameWorld::silhouetteHits):
+// each shape keeps the finest level's distance from its centre sampled at even angles, so a hit
+// test is one lookup and a lerp, not a walk over the edges.
+const int ASTEROID_OUTLINE_SAMPLES = 256;
+
+struct AsteroidShape {
+    AsteroidMesh lods[ASTEROID_LOD_COUNT];
+    float outlineRadius[ASTEROID_OUTLINE_SAMPLES + 1]; // At angle 2*pi*i/SAMPLES in the shape's frame (normalized); the last repeats the first
+};
+// Atlas vertices one shape takes: every level's fan, one after the other
+constexpr int asteroidShapeVertices() {
+    int vertices = 0;
+    for (int lod = 0; lod < ASTEROID_LOD_COUNT; ++lod) vertices += ASTEROID_LOD_SEGMENTS[lod] + 2;
+    return vertices;
+}
+const int ASTEROID_SHAPE_VERTICES = asteroidShapeVertices();
+extern std::vector<AsteroidShape> asteroidShapes; // Filled by generateAsteroidShapes()
+
+// The outline's distance from the centre at `angle` (radians, the shape's own frame, any range);
+// 1 (the circle) before the shapes are generated
+float asteroidOutlineRadius(int shapeIndex, float angle);
+// Whether a circle at `offset` from a rock's centre touches its outline, measured along the line
+// through the centre: the narrowphase after a circle test against the widest outline has passed
+bool touchesAsteroidOutline(glm::vec2 offset, float radius, float rockScale, float rockRotation, int shapeIndex);
+
+struct Bullet {
+    glm::vec2 position = glm::vec2(0.0f, 0.0f);
+    glm::vec2 velocity = glm::vec2(0.0f, 0.0f);
+    float scale = 0.01f;
+    float radius = 0.01f;
+    float lifetime = BULLET_LIFETIME;
+    int owner = -1; // Ship that fired it (-1: none, a stress scenario's)
+};
+
+// ============================ ENTITY HANDLES ============================
+// Dense indices change whenever the last entity fills a hole, so anything that must refer to an
+// entity across ticks keeps a handle instead. Each slot's generation is bumped when its entity
+// is removed, so a stale handle never resolves to whatever reused the slot.
+struct EntityHandle {
+    uint32_t slot = UINT32_MAX;
+    uint32_t generation = 0;
+};
+const EntityHandle INVALID_ENTITY_HANDLE = {};
+
+struct HandleTable {
+    std::vector<uint32_t> denseIndex;  // Per slot: where its entity currently lives
+    std::vector<uint32_t> generation;  // Per slot
+    std::vector<uint32_t> slotOf;      // Per dense index: the slot that owns it
+    std::vector<uint32_t> freeSlots;
+
+    void init(size_t capacity) {
+        denseIndex.assign(capacity, 0);
+        generation.assign(capacity, 0);
+        slotOf.clear();
+        slotOf.reserve(capacity);
+        freeSlots.clear();
+        freeSlots.reserve(capacity);
+        for (size_t s = capacity; s > 0; --s) freeSlots.push_back(static_cast<uint32_t>(s - 1));
+    }
+
+    bool full() const { return freeSlots.empty(); }
+
+    // Binds a free slot to the entity just appended at dense index slotOf.size()
+    EntityHandle add() {
+        uint32_t slot = freeSlots.back();
+        freeSlots.pop_back();
+        denseIndex[slot] = static_cast<uint32_t>(slotOf.size());
+        slotOf.push_back(slot);
+        return { slot, generation[slot] };
+    }
+
+    // Mirrors the store's swap-remove of dense index i
+    void remove(size_t i) {
+        uint32_t slot = slotOf[i];
+        ++generation[slot];
+        freeSlots.push_back(slot);
+        size_t last = slotOf.size() - 1;
+        if (i != last) {
+            slotOf[i] = slotOf[last];
+            denseIndex[slotOf[i]] = static_cast<uint32_t>(i);
+        }
+        slotOf.pop_back();
+    }
+
+    EntityHandle handle(size_t i) const { return { slotOf[i], generation[slotOf[i]] }; }
+
+    // Dense index of a live entity, or -1 if the handle is stale or invalid
+    long long resolve(EntityHandle h) const {
+        if (h.slot >= generation.size() || generation[h.slot] != h.generation) return -1;
+        return static_cast<long long>(denseIndex[h.slot]);
+    }
+};
+
+// ============================ ENTITY STORAGE (STRUCTURE OF ARRAYS) ============================
+// Each field lives in its own contiguous array so the integration and collision loops only
+// stream the data they touch. Asteroid/Bullet above stay as the value types used to spawn
+// an entity or read one back whole. Removal is unordered: the last entity fills the hole.
+// reserve() sizes a store once (and its handle table); push() refuses to grow past that capacity.
+struct AsteroidStore {
+    // Hot: integration and collision
+    EntityArray<float> x, y, vx, vy, rot, rotSpeed;
+    // Previous-tick state, read only by the renderer for interpolation
+    EntityArray<float> px, py, prot;
+    // Motion anchors (GameWorld::lazyAsteroidMotion): where each rock was at anchorTime. Rocks fly
+    // straight between bounces, so that and the velocity give its position at any time.
+    EntityArray<float> ax, ay, arot;
+    EntityArray<double> anchorTime;
+    double clock = 0.0, previousClock = 0.0; // Game time of this tick's and the last tick's state; new rocks are anchored at clock
+    // Cold: gameplay and rendering (scale and radius come from the size class)
+    EntityArray<AsteroidSize> sizeClass;
+    EntityArray<uint8_t> paletteIndex;
+    EntityArray<int> shapeIndex;
+    EntityArray<unsigned char> destroyed;
+    HandleTable handles;
+
+    size_t count() const { return x.size(); }
+    size_t memoryBytes() const; // Every field and the handle table, at capacity
+    glm::vec2 position(size_t i) const { return glm::vec2(x[i], y[i]); }
+    float scale(size_t i) const { return getScaleFactor(sizeClass[i]); }
+    float radius(size_t i) const { return getRadiusFactor(sizeClass[i]); }
+
+    // From the anchors: where rock i is (was, will be) at `time` if it keeps its current path,
+    // wrapped into the field. The field is a torus here, so a rock keeps its overshoot across an edge.
+    glm::vec2 positionAt(size_t i, double time) const {
+        const double t = time - anchorTime[i];
+        auto wrap = [](double v) { return static_cast<float>(v - 2.0 * std::floor((v + 1.0) / 2.0)); }; // Into [-1, 1)
+        return glm::vec2(wrap(ax[i] + vx[i] * t), wrap(ay[i] + vy[i] * t));
+    }
+    float rotationAt(size_t i, double time) const { return static_cast<float>(arot[i] + rotSpeed[i] * (time - anchorTime[i])); }
+
+    // Moves the anchor to the rock's current state, for when its velocity is about to change
+    void reanchor(size_t i) {
+        arot[i] = rotationAt(i, clock);
+        ax[i] = x[i]; ay[i] = y[i];
+        anchorTime[i] = clock;
+    }
+
+    // Writes the positions at clock for rocks [begin, end) (rotation is left to whoever draws them)
+    void materialize(size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            glm::vec2 p = positionAt(i, clock);
+            x[i] = p.x; y[i] = p.y;
+        }
+    }
+
+    // Called at the start of every tick so px/py/prot hold the last completed tick
+    void savePrevious() {
+        std::copy(x.begin(), x.end(), px.begin());
+        std::copy(y.begin(), y.end(), py.begin());
+        std::copy(rot.begin(), rot.end(), prot.begin());
+    }
+
+    void reserve(size_t n) {
+        x.reserve(n); y.reserve(n); vx.reserve(n); vy.reserve(n); rot.reserve(n); rotSpeed.reserve(n);
+        px.reserve(n); py.reserve(n); prot.reserve(n);
+        ax.reserve(n); ay.reserve(n); arot.reserve(n); anchorTime.reserve(n);
+        sizeClass.reserve(n); paletteIndex.reserve(n); shapeIndex.reserve(n); destroyed.reserve(n);
+        handles.init(n);
+    }
+
+    // Appends n rocks in one go, every field resized once, and returns the first one's index; fill
+    // them in with set(). n must not exceed the free slots.
+    size_t extend(size_t n) {
+        const size_t first = count(), total = first + n;
+        for (EntityArray<float>* field : { &x, &y, &vx, &vy, &rot, &rotSpeed, &px, &py, &prot, &ax, &ay, &arot }) field->resize(total);
+        anchorTime.resize(total); sizeClass.resize(total); paletteIndex.resize(total); shapeIndex.resize(total); destroyed.resize(total);
+        for (size_t k = 0; k < n; ++k) handles.add();
+        return first;
+    }
+
+    void set(size_t i, const Asteroid& a) {
+        x[i] = a.position.x; y[i] = a.position.y;
+        vx[i] = a.velocity.x; vy[i] = a.velocity.y;
+        rot[i] = a.rotation; rotSpeed[i] = a.rotationSpeed;
+        px[i] = a.position.x; py[i] = a.position.y; prot[i] = a.rotation;
+        ax[i] = a.position.x; ay[i] = a.position.y; arot[i] = a.rotation; anchorTime[i] = clock;
+        sizeClass[i] = a.size; paletteIndex[i] = a.paletteIndex;
+        shapeIndex[i] = a.shapeIndex;
+        destroyed[i] = a.destroyed ? 1 : 0;
+    }
+
+    // Returns INVALID_ENTITY_HANDLE (and adds nothing) when the pool is full
+    EntityHandle push(const Asteroid& a) {
+        if (handles.full()) return INVALID_ENTITY_HANDLE;
+        x.push_back(a.position.x); y.push_back(a.position.y);
+        vx.push_back(a.velocity.x); vy.push_back(a.velocity.y);
+        rot.push_back(a.rotation); rotSpeed.push_back(a.rotationSpeed);
+        px.push_back(a.position.x); py.push_back(a.position.y); prot.push_back(a.rotation);
+        ax.push_back(a.position.x); ay.push_back(a.position.y); arot.push_back(a.rotation); anchorTime.push_back(clock);
+        sizeClass.push_back(a.size); paletteIndex.push_back(a.paletteIndex);
+        shapeIndex.push_back(a.shapeIndex);
+        destroyed.push_back(a.destroyed ? 1 : 0);
+        return handles.add();
+    }
+
+    Asteroid get(size_t i) const {
+        Asteroid a;
+        a.position = position(i);
+        a.velocity = glm::vec2(vx[i], vy[i]);
+        a.rotation = rot[i]; a.rotationSpeed = rotSpeed[i];
+        a.size = sizeClass[i]; a.paletteIndex = paletteIndex[i];
+        a.shapeIndex = shapeIndex[i];
+        a.destroyed = destroyed[i] != 0;
+        return a;
+    }
+
+    void moveLastTo(size_t i) {
+        size_t last = count() - 1;
+        x[i] = x[last]; y[i] = y[last]; vx[i] = vx[last]; vy[i] = vy[last];
+        rot[i] = rot[last]; rotSpeed[i] = rotSpeed[last];
+        px[i] = px[last]; py[i] = py[last]; prot[i] = prot[last];
+        ax[i] = ax[last]; ay[i] = ay[last]; arot[i] = arot[last]; anchorTime[i] = anchorTime[last];
+        sizeClass[i] = sizeClass[last]; paletteIndex[i] = paletteIndex[last];
+        shapeIndex[i] = shapeIndex[last]; destroyed[i] = destroyed[last];
+        handles.remove(i);
+        popFields();
+    }
+
+    void popBack() {
+        handles.remove(count() - 1);
+        popFields();
+    }
+
+    void popFields() {
+        x.pop_back(); y.pop_back(); vx.pop_back(); vy.pop_back(); rot.pop_back(); rotSpeed.pop_back();
+        px.pop_back(); py.pop_back(); prot.pop_back();
+        ax.pop_back(); ay.pop_back(); arot.pop_back(); anchorTime.pop_back();
+        sizeClass.pop_back(); paletteIndex.pop_back(); shapeIndex.pop_back(); destroyed.pop_back();
+    }
+
+    // Removes every entity whose index matches isDead(i) in one O(n) pass
+    template <typename Pred>
+    void sweep(Pred isDead) {
+        size_t i = 0;
+        while (i < count()) {
+            if (isDead(i)) {
+                if (i + 1 < count()) moveLastTo(i);
+                else popBack();
+            }
+            else {
+                ++i;
+            }
+        }
+    }
+
+    // Reorders every field: the rock at order[i] moves to index i (order is a permutation of the
+    // indices). Handles follow their rocks; dense indices held elsewhere go stale, as after a sweep.
+    void permute(const uint32_t* order, std::vector<unsigned char>& scratch);
+};
+
+// Bullets live in a fixed ring in firing order: each one is written at the head and leaves from the
+// tail. Every bullet gets the same lifetime, so they also expire in that order, and expiry is popping
+// from the tail; lifetimes are stored as the time they run out and never counted down. A bullet that
+// is spent early (it hit a rock or left the field) becomes a tombstone that keeps its slot until it
+// reaches the tail, unless a push finds the ring full and packs the ring first. Indices are ring
+// slots, so a bullet keeps its index for life; loops run over every slot and skip the ones not live.
+struct BulletStore {
+    EntityArray<float> x, y, vx, vy, radius;
+    EntityArray<float> px, py; // Previous-tick position (interpolation)
+    EntityArray<double> expiresAt; // Game time the bullet's lifetime runs out
+    EntityArray<int32_t> owner; // Ship credited with its hits (-1: none)
+    EntityArray<unsigned char> spent; // Not live: a tombstone between tail and head, or a free slot
+    EntityArray<EntityHandle> target; // The rock a homing missile steers for (INVALID_ENTITY_HANDLE: none)
+    std::vector<uint32_t> generation; // Per slot, bumped when its bullet leaves play (see HandleTable)
+    uint64_t tail = 0, head = 0; // Bullets ever retired and ever fired: the ring holds slots tail..head-1 (mod capacity)
+    size_t tombstones = 0; // Spent bullets still in the ring
+    double clock = 0.0; // Game time of this tick's state; new bullets' lifetimes count from it
+
+    size_t capacity() const { return x.size(); } // Loop bound for per-slot loops
+    size_t liveCount() const { return static_cast<size_t>(head - tail) - tombstones; }
+    size_t memoryBytes() const; // Every field, at capacity
+    bool live(size_t j) const { return spent[j] == 0; }
+    glm::vec2 position(size_t j) const { return glm::vec2(x[j], y[j]); }
+    EntityHandle handle(size_t j) const { return { static_cast<uint32_t>(j), generation[j] }; }
+    // Place in firing order (0: the oldest in the ring), for tie-breaks that should favour the older bullet
+    size_t order(size_t j) const { return (j + capacity() - static_cast<size_t>(tail % capacity())) % capacity(); }
+
+    void savePrevious() {
+        std::copy(x.begin(), x.end(), px.begin());
+        std::copy(y.begin(), y.end(), py.begin());
+    }
+
+    void reserve(size_t n) {
+        for (EntityArray<float>* field : { &x, &y, &vx, &vy, &radius, &px, &py }) field->assign(n, 0.0f);
+        expiresAt.assign(n, 0.0);
+        owner.assign(n, -1);
+        spent.assign(n, 1);
+        target.assign(n, INVALID_ENTITY_HANDLE);
+        generation.assign(n, 0);
+        tail = head = 0;
+        tombstones = 0;
+    }
+
+    // Fires n bullets together through one reservation: the ring is compacted at most once, the
+    // shared expiry worked out once, and fill(k, position, velocity) sets the k-th bullet as it is
+    // written into its slot. The ones that do not fit (the ring full of live bullets) are dropped;
+    // returns how many were fired.
+    template <typename Fill>
+    size_t pushVolley(size_t n, float lifetime, int32_t shooter, Fill&& fill) {
+        const size_t slots = capacity();
+        if (slots - static_cast<size_t>(head - tail) < n && tombstones > 0) compact();
+        n = std::min(n, slots - static_cast<size_t>(head - tail));
+        if (n == 0) return 0;
+        const double expiry = std::max(clock + lifetime, head > tail ? expiresAt[(head - 1) % slots] : clock);
+        size_t j = static_cast<size_t>(head % slots);
+        glm::vec2 position, velocity;
+        for (size_t k = 0; k < n; ++k) {
+            fill(k, position, velocity);
+            x[j] = position.x; y[j] = position.y;
+            vx[j] = velocity.x; vy[j] = velocity.y;
+            radius[j] = Bullet().radius;
+            px[j] = position.x; py[j] = position.y;
+            expiresAt[j] = expiry;
+            owner[j] = shooter;
+            spent[j] = 0;
+            target[j] = INVALID_ENTITY_HANDLE;
+            if (++j == slots) j = 0;
+        }
+        head += n;
+        return n;
+    }
+
+    // Returns INVALID_ENTITY_HANDLE (and adds nothing) when the ring is full of live bullets. Expiry
+    // times never go below the newest's, so the ring stays in expiry order.
+    EntityHandle push(const Bullet& b) {
+        if (head - tail == capacity()) {
+            if (tombstones == 0) return INVALID_ENTITY_HANDLE;
+            compact();
+        }
+        const double newest = head > tail ? expiresAt[(head - 1) % capacity()] : clock;
+        const size_t j = static_cast<size_t>(head++ % capacity());
+        x[j] = b.position.x; y[j] = b.position.y;
+        vx[j] = b.velocity.x; vy[j] = b.velocity.y;
+        radius[j] = b.radius;
+        px[j] = b.position.x; py[j] = b.position.y;
+        expiresAt[j] = std::max(clock + b.lifetime, newest);
+        owner[j] = b.owner;
+        spent[j] = 0;
+        target[j] = INVALID_ENTITY_HANDLE;
+        return handle(j);
+    }
+
+    // Marks a live bullet spent; its slot is freed when it reaches the tail
+    void tombstone(size_t j) {
+        spent[j] = 1;
+        ++generation[j];
+        ++tombstones;
+    }
+
+    // Retires bullets from the tail while they are spent or out of lifetime
+    void popExpired() {
+        while (tail < head) {
+            const size_t j = static_cast<size_t>(tail % capacity());
+            if (spent[j]) --tombstones;
+            else if (expiresAt[j] > clock) break;
+            else ++generation[j];
+            release(j);
+            ++tail;
+        }
+    }
+
+    // Every bullet out of play at once (a new game)
+    void clear() {
+        for (size_t j = 0; j < capacity(); ++j) {
+            if (!spent[j]) ++generation[j];
+            release(j);
+        }
+        tail = head = 0;
+        tombstones = 0;
+    }
+
+    // Moves the live bullets up against the tail, in order, dropping the tombstones. A bullet that
+    // moves gets a new slot, so its old handle goes stale like a removed one's.
+    void compact() {
+        const size_t n = capacity();
+        uint64_t write = tail;
+        for (uint64_t read = tail; read < head; ++read) {
+            const size_t from = static_cast<size_t>(read % n);
+            if (spent[from]) continue;
+            const size_t to = static_cast<size_t>(write++ % n);
+            if (to == from) continue;
+            x[to] = x[from]; y[to] = y[from]; vx[to] = vx[from]; vy[to] = vy[from];
+            radius[to] = radius[from]; px[to] = px[from]; py[to] = py[from];
+            expiresAt[to] = expiresAt[from];
+            owner[to] = owner[from];
+            target[to] = target[from];
+            spent[to] = 0;
+            spent[from] = 1;
+            ++generation[from];
+        }
+        for (uint64_t k = write; k < head; ++k) release(static_cast<size_t>(k % n));
+        head = write;
+        tombstones = 0;
+    }
+
+    void release(size_t j) {
+        spent[j] = 1;
+        vx[j] = vy[j] = 0.0f; // Free slots still go through the integration; they stay put
+    }
+};
+
+// ============================ SHIP STORE ============================
+// Every ship in the game, one per player (or bot), in SoA form so they move through the same kernels
+// as the rocks. The set is fixed for a game: a ship that is lost stays in its slot, out of play
+// (alive = 0), and the game is over once none is left. Each has its own fire cooldown, shield and
+// score; its bullets carry its index (BulletStore::owner). The cooldowns and the shield are ticks
+// they end on (GameWorld::tick), not countdowns: nothing is decremented per tick, and the world's
+// timer wheel acts on the shield's ends when they come.
+struct ShipStore {
+    EntityArray<float> x, y, vx, vy, rot, radius;
+    EntityArray<float> px, py, prot; // Previous-tick state (interpolation)
+    EntityArray<float> scale;
+    EntityArray<uint64_t> fireReadyTick; // First tick it may fire again
+    EntityArray<uint64_t> shieldEndTick, shieldReadyTick; // Its shield drops / may go up again on these ticks
+    EntityArray<unsigned char> shieldActive, thrusting, alive;
+    EntityArray<int> score; // Rocks its bullets shot (getAsteroidPoints)
+
+    size_t count() const { return x.size(); }
+    size_t aliveCount() const { return static_cast<size_t>(std::count(alive.begin(), alive.end(), 1)); }
+    size_t memoryBytes() const;
+    glm::vec2 position(size_t s) const { return glm::vec2(x[s], y[s]); }
+    // Its shield while the shield is up, otherwise its hull
+    float collisionRadius(size_t s) const { return shieldActive[s] ? SHIELD_RADIUS_FACTOR : radius[s]; }
+    Ship ship(size_t s) const;
+
+    void savePrevious() {
+        std::copy(x.begin(), x.end(), px.begin());
+        std::copy(y.begin(), y.end(), py.begin());
+        std::copy(rot.begin(), rot.end(), prot.begin());
+    }
+
+    // n ships at their starting points (shipStartPosition), at rest, every one in play
+    void reset(size_t n);
+};
+
+// Ship 0 starts at the center, the rest on rings around it, 8 to a ring
+glm::vec2 shipStartPosition(size_t s);
+
+// ============================ SIMD INTEGRATION KERNELS ============================
+// Operate directly on the SoA arrays, 8 (AVX) or 4 (SSE2) entities per instruction, with a
+// scalar tail. Wrap-around is branchless: x > 1 -> -1, x < -1 -> 1, matching the scalar rule.
+void integrateLinear(float* p, const float* v, size_t n, float dt);   // p[i] += v[i] * dt
+void integrateWrap(float* p, const float* v, size_t n, float dt);     // ... then wrap across [-1,1]
+void dampVelocity(float* v, size_t n, float factor);                  // v[i] *= factor (friction)
+// Homing (HOMING MISSILES): where pull[i] is 1, turns (vx, vy) towards the nearest image of (tx, ty)
+// seen from (x, y) by `accel` (this tick's share), then caps every lane's speed at maxSpeed
+void steerMissiles(float* vx, float* vy, const float* x, const float* y, const float* tx, const float* ty, const float* pull,
+                   size_t n, float accel, float maxSpeed);
+// Q16.16 counterparts for GameWorld::fixedPointKinematics (fixedpoint.h), 8 entities per instruction
+// with AVX2 (SSE2 has no 32-bit lane multiply) and scalar otherwise, to the same bits either way. Both
+// arrays are read as fixed point, rounded onto the grid if a float wrote them, and written back, so
+// the velocities stay on it too.
+void integrateLinearFixed(float* p, float* v, size_t n, int32_t dt); // p[i] += v[i] * dt
+void integrateWrapFixed(float* p, float* v, size_t n, int32_t dt);   // ... then wrap across [-1,1]
+void integrateAngleFixed(float* p, float* v, size_t n, int32_t dt);  // ... then wrap into [0, 2 pi)
+void dampVelocityFixed(float* v, size_t n, int32_t factor);           // v[i] *= factor (scalar: a handful of ships)
+
+// ============================ SPATIAL HASH BROADPHASE ============================
+// Uniform grids over the toroidal [-1,1] playfield, rebuilt every tick. A grid's cells are as wide
+// as the largest interaction distance it serves, so any interacting pair lies in the 3x3
+// neighbourhood of a cell, with neighbours wrapping around the screen edges. There is one grid
+// per rock size class on each side: a SMALL rock's neighbourhood is then a fraction of a LARGE one's.
+float maxBulletTravelPerTick(); // Furthest a bullet can move relative to a rock in one tick
+float getAsteroidCellSize(AsteroidSize size); // Rock against rock, of its class or smaller
+float getBulletCellSize(AsteroidSize size);   // Rock of that class against a bullet, over one tick of travel
+float getGridCellSize(); // The widest reach of any query, the ship's shield included (the sweep's reach)
+
+struct JobCounter;
+
+// Built by a counting sort: count the entities per cell, prefix-sum the counts into cellStart, then
+// scatter the indices into `entries`, so a cell's entities are one contiguous run in ascending index
+// order. Both passes run over fixed chunks of entities on the job system. The prefix sum also marks
+// the occupied cells in a bitset, so the per-cell loops skip empty cells 64 at a time (a sparse field
+// at the start of a wave is mostly empty cells).
+struct SpatialGrid {
+    int dim = 3;            // Cells per axis
+    float cellSize = 2.0f / 3.0f;
+    std::vector<int> cellStart; // Cell c holds entries[cellStart[c], cellStart[c + 1])
+    std::vector<int> entries;   // Entity indices, grouped by cell
+    std::vector<int> entityCell; // Cell of each entity, from the counting pass
+    std::vector<int> chunkOffsets; // Per chunk and cell: the count, then where the chunk's run starts
+    std::vector<uint64_t> occupied; // Bit c of word c / 64: cell c holds an entity
+    int occupiedCells = 0;
+
+    // Sized for the whole pool, so build() never allocates
+    void init(float minCellSize, size_t capacity);
+
+    // Entities slightly outside the field (bullets fly to 1.5) go into the cell of their wrapped
+    // image, so the 3x3 around a rock reaches them however fine the cells are. The edges themselves
+    // stay in the border cells, where the pair search expects their coordinates.
+    int cellCoord(float v) const {
+        int c = static_cast<int>(std::floor((v + 1.0f) / cellSize));
+        if (c < 0) return v < -1.0f ? std::max(c + dim, 0) : 0;
+        if (c >= dim) return v > 1.0f ? std::min(c - dim, dim - 1) : dim - 1;
+        return c;
+    }
+
+    // Rebuilds the grid from n positions (SoA). With a dependency, the counting pass waits for it.
+    void build(const float* x, const float* y, size_t n, JobCounter* dependency = nullptr);
+
+    bool cellOccupied(int cell) const { return (occupied[cell >> 6] >> (cell & 63)) & 1; }
+
+    // Calls fn(cell) for every occupied cell in [first, last), in ascending order, by bit scan
+    template <typename Fn>
+    void forEachOccupied(int first, int last, Fn&& fn) const {
+        for (int word = first >> 6; word * 64 < last; ++word) {
+            uint64_t bits = occupied[word];
+            if (word * 64 < first) bits &= ~uint64_t(0) << (first & 63);
+            if (last - word * 64 < 64) bits &= (uint64_t(1) << (last - word * 64)) - 1;
+            while (bits != 0) {
+                fn(word * 64 + std::countr_zero(bits));
+                bits &= bits - 1;
+            }
+        }
+    }
+
+    // Calls fn(index) for every entity in the 3x3 cells around pos (wrap-around)
+    template <typename Fn>
+    void forEachNeighbour(glm::vec2 pos, Fn&& fn) const {
+        if (occupiedCells == 0) return;
+        int cx = cellCoord(pos.x);
+        int cy = cellCoord(pos.y);
+        for (int dy = -1; dy <= 1; ++dy) {
+            int y = (cy + dy + dim) % dim;
+            for (int dx = -1; dx <= 1; ++dx) {
+                int cell = y * dim + (cx + dx + dim) % dim;
+                if (!cellOccupied(cell)) continue;
+                for (int k = cellStart[cell]; k < cellStart[cell + 1]; ++k) fn(entries[k]);
+            }
+        }
+    }
+
+    // Same, for a reach wider than a cell: as many rings of cells as it takes (each cell once)
+    template <typename Fn>
+    void forEachWithin(glm::vec2 pos, float reach, Fn&& fn) const {
+        if (occupiedCells == 0) return;
+        const int rings = static_cast<int>(std::ceil(reach / cellSize));
+        const int span = std::min(2 * rings + 1, dim);
+        const int x0 = cellCoord(pos.x) - span / 2 + dim, y0 = cellCoord(pos.y) - span / 2 + dim;
+        for (int dy = 0; dy < span; ++dy) {
+            int y = (y0 + dy) % dim;
+            for (int dx = 0; dx < span; ++dx) {
+                int cell = y * dim + (x0 + dx) % dim;
+                if (!cellOccupied(cell)) continue;
+                for (int k = cellStart[cell]; k < cellStart[cell + 1]; ++k) fn(entries[k]);
+            }
+        }
+    }
+};
+
+// One grid per size class, each with cells sized for that class (getAsteroidCellSize): a rock is
+// inserted into the level of its class, and a query visits, in each level, the cells its reach
+// plus that class's radius covers. The levels' entries laid end to end, SMALL first, are the grid
+// order the rock-rock pair search works in. All levels are filled by one counting sort over their
+// cells numbered end to end, so each rock is read once whatever the number of levels.
+struct HierarchicalGrid {
+    SpatialGrid levels[ASTEROID_SIZE_COUNT]; // Only their cell layout, cellStart and entries are used
+    int levelStart[ASTEROID_SIZE_COUNT + 1] = {}; // Level k's entries start at levelStart[k] in grid order
+    int cellBase[ASTEROID_SIZE_COUNT + 1] = {};   // Level k's cells start at cellBase[k] in the shared numbering
+    std::vector<int> entityCell;   // Shared-numbering cell of each rock, from the counting pass
+    std::vector<int> chunkOffsets; // As SpatialGrid's, over every level's cells
+
+    void init(size_t capacity);
+    void build(const float* x, const float* y, const AsteroidSize* sizeClass, size_t n, JobCounter* dependency = nullptr);
+    size_t count() const { return static_cast<size_t>(levelStart[ASTEROID_SIZE_COUNT]); }
+
+    // Calls fn(index) for every rock that may lie within `reach` of pos, level by level
+    template <typename Fn>
+    void forEachWithin(glm::vec2 pos, float reach, Fn&& fn) const {
+        for (int k = 0; k < ASTEROID_SIZE_COUNT; ++k) levels[k].forEachWithin(pos, reach + getRadiusFactor(static_cast<AsteroidSize>(k)), fn);
+    }
+};
+
+// ============================ QUERY INDEX ============================
+// A SpatialGrid of its own over points the caller names, for the neighbour queries outside the
+// collision checks (spatialquery.h has the queries). Declared here so a world can hold one.
+const float QUERY_ENTITIES_PER_CELL = 4.0f; // Grid density init aims for at full capacity
+
+struct QueryHit {
+    int index; // Into the positions the index was built from
+    float distanceSq; // To the query point, through the wrap
+};
+
+struct SpatialQueryIndex {
+    SpatialGrid grid;
+    const float* x = nullptr;
+    const float* y = nullptr;
+    const float* radius = nullptr; // Only the ray queries read them
+    float maxRadius = 0.0f;
+    size_t count = 0;
+
+    // Sized for `capacity` points, cells about QUERY_ENTITIES_PER_CELL deep at that count
+    void init(size_t capacity);
+    // Indexes n points (SoA), with their radii for ray queries; the arrays must outlive the queries
+    // and stay unchanged while they run
+    void build(const float* px, const float* py, size_t n, const float* radii = nullptr);
+};
+
+// Debug view of one level of the asteroid grid (the heatmap overlay, broadphaseview.h): per cell,
+// the rocks of that level in it and the candidate pairs the searches took from them this tick. A
+// rock's candidates are the live bullets in the 3x3 of its class's bullet grid (what the bullet
+// search gathers) and, with rock collisions, the rocks the grid pair search meets from it: the ones
+// after it in its cell, the ones in its half shell of neighbour cells and the ones in the 3x3 of
+// every coarser level. Counted from the cell tables once the searches have run, before the resolve,
+// and only while GameWorld::heatmapLevel asks for it, so the searches themselves carry no counters.
+struct BroadphaseHeatmap {
+    int level = -1; // Size class shown (-1: none this tick)
+    int dim = 0; // The level's cells per axis
+    float cellSize = 0.0f;
+    std::vector<uint32_t> rocks, candidates; // Per cell, row-major from (-1, -1)
+    uint32_t maxRocks = 0, maxCandidates = 0;
+    uint64_t totalCandidates = 0;
+
+    void init(const HierarchicalGrid& grid); // Sized for the finest level, so filling or copying it never allocates
+};
+
+// ============================ EDGE GHOSTS ============================
+// The field wraps at +-1, so anything within its radius of an edge also lies partly on the far side.
+// Only those border entities get ghost images (offset by the field width): the renderer draws them
+// as extra instances and the collision tests compare their neighbours against the nearest image,
+// so the extra work follows the border population rather than the total.
+const float FIELD_WIDTH = 2.0f;
+
+// Fills `offsets` with the ghost images of a circle and returns how many: 0 away from the edges,
+// 1 along an edge, 3 in a corner
+inline int wrapGhostOffsets(glm::vec2 position, float radius, glm::vec2 offsets[3]) {
+    float gx = position.x > 1.0f - radius ? -FIELD_WIDTH : (position.x < radius - 1.0f ? FIELD_WIDTH : 0.0f);
+    float gy = position.y > 1.0f - radius ? -FIELD_WIDTH : (position.y < radius - 1.0f ? FIELD_WIDTH : 0.0f);
+    int count = 0;
+    if (gx != 0.0f) offsets[count++] = glm::vec2(gx, 0.0f);
+    if (gy != 0.0f) offsets[count++] = glm::vec2(0.0f, gy);
+    if (gx != 0.0f && gy != 0.0f) offsets[count++] = glm::vec2(gx, gy);
+    return count;
+}
+
+// True if something within `reach` of position could lie across an edge
+inline bool nearWrapEdge(glm::vec2 position, float reach) {
+    return std::abs(position.x) > 1.0f - reach || std::abs(position.y) > 1.0f - reach;
+}
+
+// The image of coordinate v nearest to `reference` (v itself unless they are more than half the field apart)
+inline float nearestImage(float v, float reference) {
+    float d = v - reference;
+    return d > 1.0f ? v - FIELD_WIDTH : (d < -1.0f ? v + FIELD_WIDTH : v);
+}
+
+// b - a at b's image nearest a. Wrapped after the subtraction, so it is the exact negation of
+// wrappedDelta(a, b): a pair tests alike to the last bit whichever of the two it is seen from.
+inline float wrappedDelta(float b, float a) {
+    float d = b - a;
+    return d > 1.0f ? d - FIELD_WIDTH : (d < -1.0f ? d + FIELD_WIDTH : d);
+}
+
+// ============================ SWEEP AND PRUNE BROADPHASE ============================
+// Alternative asteroid broadphase (--broadphase sap): the rocks kept sorted along x by the left end
+// of their extent, [x - radius, x + radius]. Rocks drift slowly and in straight lines, so from one
+// tick to the next the order barely changes and an insertion sort restores it in close to O(n).
+// Entries follow the rocks by handle, so the swap-and-pop removals do not disturb the order.
+struct SweepEntry {
+    float min;  // x - radius
+    float x, y;
+    int index;  // Dense index this tick
+    EntityHandle handle;
+};
+
+struct SweepAndPrune {
+    float queryReach = 0.0f; // forEachNeighbour's reach, as wide as the grid's cells
+    float maxRadius = 0.0f;  // Largest radius this tick
+    std::vector<SweepEntry> entries;      // Sorted by min
+    std::vector<uint32_t> trackedGeneration; // Per handle slot: generation + 1 while its entity has an entry
+
+    void init(float reach, size_t capacity);
+
+    // Brings the order up to date with the store: drops removed entities, adds new ones, re-sorts
+    void update(const float* x, const float* y, const AsteroidSize* sizeClass, const HandleTable& handles, size_t n);
+
+    // Calls fn(index) for every entity whose centre lies within queryReach of pos on both axes
+    // (wrap-around): the same guarantee as SpatialGrid::forEachNeighbour, a different superset
+    template <typename Fn>
+    void forEachNeighbour(glm::vec2 pos, Fn&& fn) const {
+        const float lo = pos.x - queryReach - maxRadius, hi = pos.x + queryReach;
+        // Scans the entries whose min lies in [lo, hi] + shift, compared after moving them back by shift
+        auto scan = [&](float shift) {
+            auto first = std::lower_bound(entries.begin(), entries.end(), lo + shift,
+                                          [](const SweepEntry& e, float value) { return e.min < value; });
+            for (auto it = first; it != entries.end() && it->min <= hi + shift; ++it) {
+                float dy = std::abs(pos.y - it->y);
+                if (std::abs(it->x - shift - pos.x) <= queryReach && std::min(dy, FIELD_WIDTH - dy) <= queryReach) fn(it->index);
+            }
+        };
+        scan(0.0f);
+        if (lo < -1.0f) scan(FIELD_WIDTH); // Rocks at the right edge, met across the left one
+        if (hi > 1.0f - maxRadius) scan(-FIELD_WIDTH); // And the reverse
+    }
+};
+
+// No broadphase at all (--broadphase brute): every rock against every other rock, the ships and every
+// bullet slot, through the same narrow tests. Quadratic, so only the reference the others are checked
+// against (benchmark --backends); the bullet search then skips the bullet grids too.
+enum AsteroidBroadphase { BROADPHASE_GRID, BROADPHASE_SWEEP_AND_PRUNE, BROADPHASE_BRUTE_FORCE };
+const char* broadphaseName(AsteroidBroadphase broadphase); // "grid", "sap" or "brute"
+bool parseBroadphase(const char* name, AsteroidBroadphase& broadphase); // The same names; false if unknown
+
+// ============================ GAMEPLAY EVENTS ============================
+// The collision checks only detect: what they find goes into event lists, and one resolve phase then
+// applies it all in a fixed order (GameWorld::resolveEvents). The checks never change the stores, so
+// the searches can run on any number of threads, each into its own list, without changing the outcome.
+// Bullet hits are BulletHit lists, one per chunk of rocks searched; the rest are GameEvents.
+enum GameEventType {
+    EVENT_SHIELD_ABSORB,  // A ship's shield took out a rock (and went down)
+    EVENT_SHIP_DESTROYED, // A ship's hull touched a rock
+    EVENT_ASTEROID_SPLIT  // Queued by the resolve: a rock's children, spawned once it is done
+};
+
+struct GameEvent {
+    GameEventType type;
+    int rock;         // Store index
+    int children = 0; // EVENT_ASTEROID_SPLIT: how many fit under the asteroid limit
+    int ship = 0;     // The ship's events: which one
+};
+
+// One bullet whose path this tick touched a rock (found by the parallel search, resolved in order)
+struct BulletHit {
+    int rock;
+    int bullet;
+};
+
+// The pair-batched search's candidates for one chunk of rocks (GameWorld::pairBatchedHits): every
+// (rock, bullet) pair the bullet grids turn up, gathered rock by rock (so in grid-cell order once the
+// rocks are sorted, --sort-rocks) with what the test needs copied in, then tested in one linear pass
+struct BulletPairs {
+    std::vector<int> rock, bullet;
+    std::vector<float> sx, sy, ex, ey; // The bullet's path relative to the rock's centre: last tick's offset, this tick's
+    std::vector<float> rockRadius, bulletRadius; // The rock's widest (its outline's, with outline hits)
+    std::vector<uint8_t> hit; // Filled by the test
+    size_t count = 0; // Pairs gathered this tick; the arrays only grow, so they are written in place
+
+    size_t size() const { return count; }
+    // Room for n more pairs past count (grown as they are gathered)
+    void grow(size_t n) {
+        if (count + n <= rock.size()) return;
+        const size_t total = std::max(count + n, 2 * rock.size());
+        for (std::vector<int>* ids : { &rock, &bullet }) ids->resize(total);
+        for (std::vector<float>* field : { &sx, &sy, &ex, &ey, &rockRadius, &bulletRadius }) field->resize(total);
+        hit.resize(total);
+    }
+};
+
+// ============================ EFFECT EVENTS ============================
+// What the renderer shows as debris and sparks (particles.h) and the mixer plays (audio.h): one per
+// bullet fired, per rock shot or absorbed and per ship lost, in the order they happened. They are output only: nothing in the simulation reads them back,
+// and they are no part of its state (snapshots, replays and rollbacks leave them out).
+enum EffectType : uint8_t {
+    EFFECT_ROCK_DESTROYED, // A SMALL rock, gone
+    EFFECT_ROCK_SPLIT,     // A larger one, broken into its children
+    EFFECT_SHIP_DESTROYED,
+    EFFECT_SHOT_FIRED      // At the ship that fired (sound only)
+};
+
+struct EffectEvent {
+    glm::vec2 position;
+    glm::vec2 velocity; // The rock's or ship's as it was lost
+    float scale;
+    uint8_t type; // EffectType
+    uint8_t paletteIndex; // The rock's asteroidPalette entry (0 for a ship)
+};
+const size_t EFFECT_RESERVE_TICKS = 4; // Ticks of everything hitting at once that effectEvents has room for
+
+// Two rocks overlapping and closing in after this tick's move (store indices; a comes first in broadphase order)
+struct AsteroidPair {
+    int a;
+    int b;
+};
+
+// ============================ KINETIC HIT SCHEDULING ============================
+// Optional replacement for the per-tick bullet search (--kinetic). Rocks and bullets fly straight at
+// constant speed, so when a bullet will meet a rock can be solved for in advance: each bullet keeps
+// its earliest predicted impact in a priority queue, and a tick only looks at the bullets whose
+// impact falls within it. Predictions are made when something new appears (a bullet is fired, a
+// rock spawns or splits) or a rock's path changes (a bounce, or a wrap), against just what changed.
+// Between those, the rock's images across the edges are part of every prediction.
+// A prediction that went out of date (its rock was shot first) is found out when it comes due.
+struct KineticEvent {
+    double time; // Of the first contact, on the schedule's clock
+    uint32_t bullet, bulletGeneration, serial; // Bullet slot; the serial names the bullet's latest prediction
+};
+
+struct KineticSchedule {
+    double clock = 0.0; // Game time at the end of the tick last observed
+    std::vector<KineticEvent> events; // Min-heap on time
+    // Per rock slot, as last observed: generation + 1 (0: never seen) and velocity
+    std::vector<uint32_t> rockGeneration;
+    std::vector<float> rockVX, rockVY;
+    // Per bullet slot: generation + 1, latest serial and the time of that prediction (infinity: none)
+    std::vector<uint32_t> bulletGeneration, bulletSerial;
+    std::vector<double> bulletNext;
+    // Scratch for one tick
+    std::vector<int> changedRocks;        // Dense indices of the rocks new or on a new path
+    std::vector<KineticEvent> predictions; // Per dense bullet, from the parallel pass
+    std::vector<KineticEvent> due;         // This tick's predictions that found hits
+
+    void init(size_t rockCapacity, size_t bulletCapacity);
+    void clear(); // Back to an empty queue at time zero (the entities are seen afresh)
+};
+
+// ============================ GRAVITY (BARNES-HUT) ============================
+// Optional pull on the rocks (--gravity wells|rocks|both): a few fixed gravity wells, and the large
+// rocks attracting each other and everything smaller. Summing every pair directly is quadratic in the
+// bodies, so the large rocks go into a quadtree rebuilt every tick: a cell seen under less than the
+// opening angle theta (its width over its distance) pulls as one body at its centre of mass, with a
+// quadrupole term for how its mass is spread about that centre; a nearer one is opened, and a leaf's
+// bodies pull one by one. theta 0 opens everything (direct summation). Below GRAVITY_DIRECT_BODIES
+// the walk costs more than it saves and the world sums directly.
+// The tree is built from the bodies' Z-order keys: a counting pass deals them into the
+// GRAVITY_BUCKETS cells GRAVITY_SPLIT_DEPTH levels down, each bucket is sorted and built into its
+// subtree as a job, and the levels above are put together from the subtrees' totals. Cells are
+// stored depth first, each with the size of its subtree, so the walk is a loop without a stack.
+// Distances are to the nearest wrapped image, as everywhere on the field. Past half the field that
+// image flips from one side to the other, so the pull fades out to nothing at GRAVITY_RANGE, short of
+// it: a cell wholly out of range is skipped with everything in it, and one reaching half a field
+// away or past the range is always opened (its bodies' nearest images lie on both sides there, and
+// the fade cuts part of its mass off, which its centre of mass cannot stand in for). Forces are softened
+// over about a large rock's radius, so a close pass bends a path instead of flinging it.
+const float GRAVITY_CONSTANT = 0.01f; // Field units^3 / s^2 per unit of mass (a large rock's)
+const float GRAVITY_SOFTENING = 0.15f; // Field units added in quadrature to the rock-rock distances
+const float GRAVITY_RANGE = 0.8f; // Field units; the pull fades as (1 - (d / range)^2)^2 on the way
+const float GRAVITY_DEFAULT_THETA = 0.5f;
+const float GRAVITY_MAX_THETA = 2.55f; // Recordings keep theta in hundredths, in a byte
+// theta as given on the command line, clamped and rounded to what a recording keeps
+inline float gravityThetaFrom(float value) { return std::round(std::clamp(value, 0.0f, GRAVITY_MAX_THETA) * 100.0f) / 100.0f; }
+const int GRAVITY_SPLIT_DEPTH = 3; // Levels built above the subtrees, from their totals
+const int GRAVITY_BUCKETS = 1 << (2 * GRAVITY_SPLIT_DEPTH); // Subtrees, one job each
+const uint32_t GRAVITY_LEAF_BODIES = 8; // A cell with no more bodies than this is not split
+const uint32_t GRAVITY_DIRECT_BODIES = 2500; // Fewer massive bodies are summed directly (the measured crossover)
+const size_t GRAVITY_GRAIN = 64; // Rocks whose pull is summed per job
+
+struct GravityWell {
+    float x, y;
+    float mass; // In large rocks
+    float softening; // As GRAVITY_SOFTENING, wider: the well has no surface to stop at (its range is the same)
+};
+inline constexpr GravityWell GRAVITY_WELLS[] = {
+    { -0.5f, 0.5f, 6.0f, 0.25f },
+    { 0.5f, -0.5f, 6.0f, 0.25f },
+};
+
+// One cell of the tree. The cells of its subtree follow it, so the next cell not inside it is
+// `skip` further on; a leaf (skip 1) is summed over its bodies.
+struct GravityCell {
+    float x, y, mass; // Centre of mass (on the field, not wrapped) and the mass inside
+    float qxx, qxy, qyy; // Second moments of the mass about its centre (the quadrupole term of its pull)
+    float x0, y0, size; // Its square: the lower corner and the width
+    uint32_t first, count; // Its bodies, in key order
+    uint32_t skip; // Cells in its subtree, itself included
+};
+
+struct GravityTree {
+    std::vector<uint64_t> keys; // Per body: Z-order key above its index (UINT64_MAX: massless, left out)
+    std::vector<uint64_t> sortedKeys; // Dealt into the buckets, then sorted within each
+    uint32_t bucketStart[GRAVITY_BUCKETS + 1] = {};
+    std::vector<float> bodyX, bodyY, bodyMass; // The bodies in key order
+    std::vector<uint32_t> bodyIndex; // Which body each is (what `self` names)
+    std::vector<std::vector<GravityCell>> subtrees; // Per bucket, depth first
+    std::vector<GravityCell> cells; // The whole tree, depth first from the root (empty: no bodies)
+
+    void init(size_t capacity); // For up to `capacity` bodies
+    // Rebuilds the tree over n bodies (SoA); those with no mass are left out
+    void build(const float* x, const float* y, const float* mass, size_t n);
+    // Pull per unit of G at (x, y) from every body but `self` (-1: none), opening each cell seen
+    // under theta or more; `interactions` counts the cells and bodies summed, if given
+    glm::vec2 field(float x, float y, int self, float theta, size_t* interactions = nullptr) const;
+    // The same from every body on its own, for comparison
+    glm::vec2 fieldDirect(float x, float y, int self) const;
+};
+// "off", "wells", "rocks" or "both" into the two switches; false if unknown
+bool parseGravity(const char* name, bool& wells, bool& rocks);
+
+// ============================ TIMER WHEEL ============================
+// The world's timed events, kept by the tick they fall due (a two-level hierarchical timing wheel).
+// Scheduling and firing are constant time and a tick only looks at its own slot, so what the timers
+// cost follows how many expire, not how many are running. Timers due within TIMER_WHEEL_SLOTS ticks
+// sit in the near wheel's slot for their tick; later ones in the far wheel's slot for their block of
+// TIMER_WHEEL_SLOTS ticks, moved down into the near wheel as the block starts; anything further
+// (over nine minutes away) waits in an overflow list looked at once per turn of the far wheel.
+// Nothing is ever taken out early: a timer whose state moved on (a shield absorbed a rock before its
+// time ran out) is told apart when it fires, by its due tick no longer matching its target's.
+enum TimerEvent : uint8_t {
+    TIMER_SHIELD_END,   // The ship's shield runs out (ShipStore::shieldEndTick)
+    TIMER_SHIELD_READY, // The ship's shield has cooled down (ShipStore::shieldReadyTick)
+    TIMER_WAVE_RESUME,  // The wave script's wait is over (GameWorld::waveResumeTick)
+};
+
+struct Timer {
+    uint64_t due; // Tick it fires on
+    uint32_t target; // Ship index (0 for the wave script)
+    TimerEvent event;
+};
+
+const int TIMER_WHEEL_SLOTS = 256;
+
+struct TimerWheel {
+    // Every timer in a pool, chained into its slot's list by index (-1 ends a list)
+    std::vector<Timer> timers;
+    std::vector<int32_t> next;
+    std::vector<int32_t> freeTimers;
+    int32_t nearSlots[TIMER_WHEEL_SLOTS];
+    int32_t farSlots[TIMER_WHEEL_SLOTS];
+    int32_t overflow = -1;
+    uint64_t now = 0; // Last tick advanced to
+    size_t pending = 0;
+
+    void reserve(size_t capacity); // Pool entries, so scheduling does not allocate
+    void reset(uint64_t tick); // Empty, at `tick`
+    void schedule(const Timer& timer); // Due no earlier than the next tick
+    // Advances to `tick`, appending every timer that fell due on the way to `fired`, tick by tick
+    void advance(uint64_t tick, std::vector<Timer>& fired);
+    size_t memoryBytes() const;
+
+private:
+    void place(int32_t index); // Into the list for its due tick, from `now`
+    void push(int32_t& head, int32_t index) { next[index] = head; head = index; }
+};
+
+// ============================ WAVE SCRIPTS ============================
+// Scripted waves (--waves) instead of the spawn timer: a C++20 coroutine (waves.h) that reads like
+// the wave plan it is,
+//     co_await spawnRocks(10, LARGE, SPAWN_LEFT);
+//     co_await waitSeconds(5.0f);
+//     co_await untilFieldClear();
+// Every co_await hands the world one WaveCommand and suspends. The world carries out a spawn and
+// resumes the script at once; a wait parks it on the timer wheel (TIMER_WAVE_RESUME), and waiting
+// for a clear field parks it until the sweep leaves no rocks, which then schedules the resume. A
+// parked script costs nothing per tick: nothing polls it, the wheel hands it back when it is due.
+// The script never touches the world itself, so it has no state of its own worth saving: the world
+// keeps how many commands it has taken (waveSteps) and when the current wait ends, and a restored
+// world starts the script afresh and skips that many commands to stand where it stood.
+enum WaveCommandType : uint8_t {
+    WAVE_SPAWN,           // `count` rocks of `size` in over `side`
+    WAVE_WAIT_TICKS,      // Resume `count` ticks on (at least one)
+    WAVE_WAIT_FIELD_CLEAR // Resume the tick after no rocks are left
+};
+
+struct WaveCommand {
+    WaveCommandType type;
+    AsteroidSize size;
+    SpawnSide side;
+    uint32_t count; // Rocks, or ticks
+};
+
+// Owns a wave script's coroutine (move only). Resumed by the world alone, one command at a time.
+struct WaveScript {
+    struct promise_type {
+        WaveCommand command = {};
+
+        WaveScript get_return_object() { return WaveScript(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; } // Runs from the world's first resume
+        std::suspend_always final_suspend() noexcept { return {}; }
+        std::suspend_always await_transform(const WaveCommand& next) noexcept {
+            command = next;
+            return {};
+        }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    WaveScript() = default;
+    explicit WaveScript(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+    WaveScript(WaveScript&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    WaveScript& operator=(WaveScript&& other) noexcept {
+        if (this != &other) {
+            if (handle) handle.destroy();
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+    ~WaveScript() { if (handle) handle.destroy(); }
+
+    // Runs the script to its next command; false once it has returned (or there is none)
+    bool next() {
+        if (!handle || handle.done()) return false;
+        handle.resume();
+        return !handle.done();
+    }
+    const WaveCommand& command() const { return handle.promise().command; }
+    bool running() const { return handle && !handle.done(); }
+
+private:
+    std::coroutine_handle<promise_type> handle;
+};
+
+// ============================ GAME WORLD ============================
+const int ASTEROID_SORT_TICKS = 120; // A second between the rocks' spatial re-sorts (GameWorld::spatialSortAsteroids)
+
+// One complete, independent game: the ships, rocks and bullets, the timers, its own random streams
+// and its collision scratch. Worlds share nothing mutable (the shape atlas is generated once and
+// only read), so any number of them can be stepped at once on different threads. A world's own
+// step also spreads its larger loops over the job system (jobs.h).
+struct GameWorld {
+    // --- Entities ---
+    ShipStore ships;
+    AsteroidStore asteroids;
+    size_t pendingAsteroidRemovals = 0; // Flagged rocks still in the store (excluded from the asteroid limit)
+    BulletStore bullets;
+
+    // --- Game state ---
+    bool isGameOver = false; // Every ship lost
+    uint64_t tick = 0; // Ticks stepped since reset (the ships' timers are ticks on this count)
+    float asteroidSpawnTimer = 0.0f;
+    float currentSpawnRate = INITIAL_SPAWN_RATE;
+    uint32_t waveSteps = 0; // Commands the wave script has handed over, the current wait's included
+    uint64_t waveResumeTick = 0; // When its current wait ends; 0 while it waits for a clear field
+    int score = 0; // Rocks shot by anything (getAsteroidPoints); shield kills score nothing
+
+    // --- Load shedding (loadshed.h). Set from outside before a tick, like its input, and not game
+    // state: a world run with a cap is not recorded or rolled back. ---
+    size_t spawnCap = 0; // Live rocks that spawns and split children stop at, short of limits.maxAsteroids (0: none)
+    uint64_t shedSpawns = 0, shedChildren = 0; // Turned away by the cap since reset
+
+    // --- Broadphase heatmap (the debug overlay). Set from outside before a tick, like the cap. ---
+    int heatmapLevel = -1; // Grid level step() counts into `heatmap` (-1: none)
+    BroadphaseHeatmap heatmap;
+
+    // --- Configuration (kept across reset) ---
+    SimulationLimits limits;
+    bool instrumented = true; // Logs its events and times its phases; off for batch worlds, which then touch no shared state
+    bool recordEffects = false; // Appends to effectEvents (the window's world, set before init; its snapshots drain them)
+    bool scenarioDriven = false; // Topped up by the active stress scenario before every tick (scenario.h)
+    bool asteroidCollisions = false; // Rocks bounce off each other (--rock-collisions, the "-bounce" scenarios)
+    AsteroidBroadphase asteroidBroadphase = BROADPHASE_GRID; // What the ship and rock-rock checks query (--broadphase)
+    bool kineticBulletHits = false; // Bullet hits from the kinetic schedule instead of the per-tick search (--kinetic)
+    bool lazyAsteroidMotion = false; // Rock positions worked out from their anchors, not integrated (--lazy-rocks)
+    bool fixedPointKinematics = false; // Ship, rocks and bullets moved in Q16.16, the same on every build (--fixed-point)
+    // Ship and bullet hits against the rocks' drawn outlines, not their circles (--circle-hits turns it
+    // off). The kinetic schedule predicts against circles, so with it bullets still hit those.
+    bool silhouetteHits = true;
+    // Every ASTEROID_SORT_TICKS the rocks are re-sorted in Z-order of their grid cells, so rocks near
+    // each other sit near each other in memory (--sort-rocks). Spawns and the sweep's swap-removes
+    // scatter them again in between.
+    bool spatialSortAsteroids = false;
+    // Bullet hits searched in two stages per chunk of rocks: gather every candidate pair into a flat
+    // buffer, then test the whole buffer in one SIMD pass (--pair-batch). The same hits in the same
+    // order as the per-rock search, so not a replay option.
+    bool pairBatchedHits = false;
+    bool scriptedWaves = false; // Rocks come in the waves of a script (waves.h), not on the spawn timer (--waves)
+    WeaponKind weapon = WEAPON_BLASTER; // Every ship's (--weapon), set before init; size limits.maxBullets for it (maxBulletsFor)
+    // Pull on the rocks (see GRAVITY), from the wells and from the large rocks (--gravity). Paths
+    // then curve, so not with lazy rocks, fixed point or the kinetic schedule (the callers turn it off).
+    bool gravityWells = false;
+    bool rockGravity = false;
+    float gravityTheta = GRAVITY_DEFAULT_THETA; // The tree's opening angle (--gravity-theta), in hundredths as recorded
+
+    // --- Random streams (see random.h) ---
+    Rng spawnRng; // Spawn position, side, scatter, speed, spin and color
+    Rng shapeRng; // Per-rock shape choice
+    Rng splitRng; // Child offsets when a rock splits
+
+    // --- Broadphase and collision scratch (sized once by init) ---
+    HierarchicalGrid asteroidGrid;
+    SweepAndPrune asteroidSweep;
+    SpatialGrid bulletGrids[ASTEROID_SIZE_COUNT]; // The same bullets at each rock size class's resolution
+    KineticSchedule kinetic;
+    GravityTree gravityTree; // Over the large rocks, with rockGravity
+    std::vector<float> gravityMass; // Per rock this tick (0: pulls nothing)
+    TimerWheel timers; // The ships' shield ends (derived from their ticks: rebuilt on snapshot restore)
+    std::vector<Timer> firedTimers; // This tick's, from the wheel
+    WaveScript waves; // With scriptedWaves (its frame is allocated when it starts: on reset and restore)
+    bool waveDue = false; // The wheel handed the script back this tick
+    // Homing missiles' guidance, with a homing weapon (guideMissiles)
+    SpatialQueryIndex missileRocks; // Over the rocks, for each targeting batch
+    std::vector<uint32_t> missileQueries; // This batch's missiles (ring slots), in firing order
+    std::vector<glm::vec2> missileCenters; // Their positions, the kNN batch's query points
+    std::vector<QueryHit> missileHits; // MISSILE_CANDIDATES per query
+    std::vector<uint32_t> missileHitCounts;
+    std::vector<uint16_t> missileClaims; // Per rock: missiles steering for it
+    EntityArray<float> missileTargetX, missileTargetY, missilePull; // Per ring slot, for steerMissiles
+    size_t missileBatch = 0; // Missiles the last batch targeted
+    std::vector<int> collisionCandidates;
+    EntityArray<float> scratchX, scratchY, scratchR; // Ship candidates for the batch kernel
+    std::vector<std::vector<BulletHit>> bulletHits; // Per chunk of rocks searched (capacity kept between ticks)
+    std::vector<BulletPairs> bulletPairs; // Per chunk too, with pairBatchedHits
+    size_t bulletPairCount = 0, bulletPairHits = 0; // Last tick's, with pairBatchedHits
+    std::vector<GameEvent> shipEvents;  // This tick's ship contacts, in the order found
+    std::vector<GameEvent> splitEvents; // This tick's splits, in the order resolved
+    int queuedChildren = 0;             // Children in splitEvents (they count against the asteroid limit)
+    // With recordEffects: every tick's effects until the snapshot takes them (captureSnapshot). Reserved
+    // for a few busy ticks; effects past the reserve are dropped rather than allocated for.
+    std::vector<EffectEvent> effectEvents;
+    EntityArray<float> sortedX, sortedY, sortedVX, sortedVY, sortedR; // Asteroid state in broadphase order (pair search)
+    std::vector<int> sortedIndex; // Store index of each
+    std::vector<uint64_t> spatialKeys; // Z-order key above store index, per rock (spatial re-sort)
+    std::vector<uint32_t> spatialOrder;
+    std::vector<unsigned char> spatialScratch; // One store field at a time
+    std::vector<std::vector<AsteroidPair>> asteroidPairs; // Per grid row or sweep chunk; only the first asteroidPairCounts[k] are this tick's
+    std::vector<size_t> asteroidPairCounts;
+    std::vector<size_t> asteroidPairTests, bulletCandidateCounts; // Per pair list / chunk of rocks searched, as the counts below
+    // This tick's collision work, for comparing the broadphases (benchmark --backends): the lists its
+    // hits are in (bulletHits, asteroidPairs; shipEvents are whole), and the candidate pairs the
+    // broadphase handed the narrow tests (the kinetic schedule's: the rocks its due bullets were tested against)
+    size_t bulletHitLists = 0, asteroidPairLists = 0;
+    size_t bulletCandidates = 0, asteroidCandidates = 0, shipCandidates = 0;
+
+    // Sizes the pools, grids and scratch for `worldLimits`; may run again after reset() with new limits
+    void init(const SimulationLimits& worldLimits);
+    // Resets the random streams; worlds seeded alike play out identically under the same input
+    void seed(uint64_t seedValue);
+    // Back to a fresh game (empty field, limits.ships ships at their starting points)
+    void reset();
+    // Adds every pool, grid and scratch array to the report (subsystem "simulation")
+    void collectMemory(MemoryReport& report) const;
+    // Advances the whole game by exactly one fixed step. Nothing in here touches GL.
+    void step(float dt, const InputState& input) { step(dt, &input, 1); } // Drives ship 0 (the others coast)
+    // inputs[s] drives ship s; ships past inputCount have nothing pressed
+    void step(float dt, const InputState* inputs, size_t inputCount);
+
+    // --- Asteroid logic ---
+    size_t liveAsteroidCount() const;
+    size_t asteroidAdmission() const; // Live rocks new ones may join: the limit, or the load-shedding cap below it
+    void spawnNewAsteroid(glm::vec2 pos, AsteroidSize size, SpawnSide side = SPAWN_ANY_SIDE);
+    // Draws its motion, color and shape; (0, 0): at the edge (`side`, or one drawn at random)
+    Asteroid makeAsteroid(glm::vec2 pos, AsteroidSize size, SpawnSide side = SPAWN_ANY_SIDE);
+    void destroyAsteroid(size_t index);
+    void sweepAsteroids();
+    void sortAsteroidsSpatially(); // Z-order of the finest grid level's cells, ties in store order
+    void splitAsteroid(size_t index); // Queues the children (spawnSplitChildren)
+    void spawnSplitChildren();
+    // --- Tick ---
+    void advanceTimers(); // Counts the tick and acts on the timers due on it (shields dropping, cooling down, the wave script)
+    void rebuildTimers(); // Schedules the wheel afresh from the ships' ticks
+    void restartWaves(); // Starts the wave script and skips waveSteps commands, re-arming the wait it was in
+    void runWaves(); // Carries out the script's commands up to its next wait
+    void applyInput(size_t s, const InputState& input, float dt);
+    void steerShip(size_t s, const InputState& input, float dt); // Rotation, thrust and fire
+    void steerShipFixed(size_t s, const InputState& input, float dt); // The same in Q16.16 (fixedPointKinematics)
+    void moveShips(float dt); // Friction, then the move, every ship in one pass
+    void guideMissiles(float dt); // After the rocks' move: targets any missile that needs one, then steers them all
+    void applyGravity(float dt); // Before the rocks move: the wells' and the large rocks' pull on their velocities
+    glm::vec2 heading(float angle) const; // Unit vector at `angle` (from the sine table in fixed-point mode)
+    // The tick's hot loops are templates on the configuration they would otherwise test per rock, per
+    // pair or per candidate (Broadphase: asteroidBroadphase; LazyMotion: lazyAsteroidMotion;
+    // OutlineTest: hits against the rocks' outlines). step() picks their instances once per tick.
+    struct TickKernels {
+        void (GameWorld::*collideAsteroids)();
+        size_t (GameWorld::*findShipContacts)();
+        size_t (GameWorld::*findBulletHits)(size_t begin, size_t end, std::vector<BulletHit>& hits) const;
+        void (GameWorld::*gatherBulletPairs)(size_t begin, size_t end, BulletPairs& pairs) const;
+        void (GameWorld::*testBulletPairs)(BulletPairs& pairs, std::vector<BulletHit>& hits) const;
+    };
+    TickKernels tickKernels() const; // The instances for the configuration as it stands
+    template <AsteroidBroadphase Broadphase, bool LazyMotion> void collideAsteroids(); // Elastic bounces between overlapping rocks
+    // Pair search over one row of one grid level / one chunk of the sweep order / one chunk of every
+    // rock against the rocks after it; each returns the pairs written and adds the pairs it tested to `tested`
+    size_t findGridPairs(int level, int row, std::vector<AsteroidPair>& pairs, size_t& tested) const;
+    size_t findSweepPairs(size_t begin, size_t end, std::vector<AsteroidPair>& pairs, size_t& tested) const;
+    size_t findAllPairs(size_t begin, size_t end, std::vector<AsteroidPair>& pairs, size_t& tested) const;
+    // The heatmap of grid level `level` for this tick (map.level -1 off the grid broadphase)
+    void fillBroadphaseHeatmap(int level, BroadphaseHeatmap& map) const;
+    // Calls fn(index) for the rocks the broadphase finds within a ship's reach (a full shield) of pos
+    template <AsteroidBroadphase Broadphase, typename Fn>
+    void forEachAsteroidNear(glm::vec2 pos, Fn&& fn) const {
+        const float reach = SHIELD_RADIUS_FACTOR + (ASTEROID_MAX_OUTLINE_RADIUS - 1.0f) * getRadiusFactor(LARGE); // Outline tips past the circles
+        if constexpr (Broadphase == BROADPHASE_SWEEP_AND_PRUNE) asteroidSweep.forEachNeighbour(pos, fn);
+        else if constexpr (Broadphase == BROADPHASE_GRID) asteroidGrid.forEachWithin(pos, reach, fn);
+        else {
+            for (size_t i = 0; i < asteroids.count(); ++i) {
+                const float dx = std::abs(asteroids.x[i] - pos.x), dy = std::abs(asteroids.y[i] - pos.y);
+                const float within = reach + asteroids.radius(i); // As far as the grid's query reaches for its class
+                if (std::min(dx, FIELD_WIDTH - dx) <= within && std::min(dy, FIELD_WIDTH - dy) <= within) fn(static_cast<int>(i));
+            }
+        }
+    }
+    // Rock i's rotation this tick (lazy rocks keep theirs only in the anchors)
+    template <bool LazyMotion>
+    float asteroidRotation(size_t i) const {
+        if constexpr (LazyMotion) return asteroids.rotationAt(i, asteroids.clock);
+        else return asteroids.rot[i];
+    }
+    float asteroidRotation(size_t i) const { return lazyAsteroidMotion ? asteroidRotation<true>(i) : asteroidRotation<false>(i); }
+    template <AsteroidBroadphase Broadphase, bool OutlineTest> size_t findShipContacts(); // Every ship in play, in ship order, into shipEvents; returns the hulls hit
+    bool resolveEvents(size_t hitLists); // The ships' contacts, then bulletHits[0, hitLists); false once the last ship is lost
+    void recordRockEffect(size_t index); // Before the rock is destroyed or split (with recordEffects)
+    void recordShotEffect(size_t s); // Ship s fired (with recordEffects)
+    // Lists every (rock, live bullet) pair in rocks [begin, end) that touched this tick, rocks in
+    // descending order; returns the candidate pairs tested (AllBullets: every bullet slot is a candidate,
+    // not just the bullet grid's, for BROADPHASE_BRUTE_FORCE)
+    template <bool LazyMotion, bool OutlineTest, bool AllBullets> size_t findBulletHits(size_t begin, size_t end, std::vector<BulletHit>& hits) const;
+    // The same in two stages (pairBatchedHits): every candidate pair of rocks [begin, end), in the order
+    // the search would visit them, then the buffer's tests in one pass and its hits in that order
+    template <bool LazyMotion, bool OutlineTest> void gatherBulletPairs(size_t begin, size_t end, BulletPairs& pairs) const;
+    template <bool LazyMotion, bool OutlineTest> void testBulletPairs(BulletPairs& pairs, std::vector<BulletHit>& hits) const;
+    // --- Kinetic schedule (kineticBulletHits) ---
+    void observeKinetic(float dt); // After the move: advances the clock and predicts for whatever is new
+    void collectKineticHits(float dt, std::vector<BulletHit>& hits); // This tick's impacts, rocks in descending order
+    void rescheduleKineticMisses(); // After the resolve: bullets whose rock went to another bullet fly on
+    // Earliest impact of live bullet j with one of `rocks` (every live rock if null), from `from` seconds
+    // relative to the clock; infinity if none within its life
+    KineticEvent predictKineticHit(size_t j, const int* rocks, size_t rockCount, float from) const;
+    void scheduleKineticHit(size_t j, const int* rocks, size_t rockCount, float from); // Predicts and queues it if sooner
+    void queueKineticEvent(KineticEvent& next); // Queued if sooner than the bullet's current prediction
+};
+extern GameWorld world; // The game the window shows (and headless mode runs)
+
+// ============================ FUNCTION PROTOTYPES ============================
+// --- Shapes ---
+std::vector<float> generateFilledAsteroidVertices(int segments, float radius);
+// The same from any stream, into 2 * (segments + 2) floats at `vertices`, without allocating
+void generateFilledAsteroidVertices(int segments, float radius, Rng& rng, float* vertices);
+// Lays a finest-level outline out as one shape: its ASTEROID_SHAPE_VERTICES atlas vertices, from
+// atlas vertex `baseVertex` on, go to `vertices`, and its meshes and outline samples to `shape`
+void packAsteroidShape(const float* fillVertices, int baseVertex, float* vertices, AsteroidShape& shape);
+void generateAsteroidShapes(std::vector<float>& atlasVertices);
+void assignAsteroidShape(Asteroid& rock, Rng& rng);
+// Coarsest level whose edges stay under ASTEROID_LOD_EDGE_PIXELS for a rock of this on-screen radius in pixels
+int asteroidLodForPixelRadius(float pixelRadius);
+// --- Collision ---
+bool checkCollision(glm::vec2 pos1, float rad1, glm::vec2 pos2, float rad2);
@@ -0,0 +1,287 @@
+#include "snapshot.h"
+#include "replay.h"
+#include "log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+
+static_assert(std::is_trivially_copyable<WorldSnapshotHeader>::value, "The snapshot header is copied as raw bytes");
+
+// ============================ LAYOUT ============================
+// The arrays follow the header in this order. One walk serves both save and restore, so they can
+// never disagree; a change here is a change of format (bump SNAPSHOT_VERSION, and the sizes below).
+template <typename Store, typename Visit>
+static void visitAsteroidArrays(Store& rocks, Visit&& visit) {
+    visit(rocks.x); visit(rocks.y); visit(rocks.vx); visit(rocks.vy); visit(rocks.rot); visit(rocks.rotSpeed);
+    visit(rocks.px); visit(rocks.py); visit(rocks.prot);
+    visit(rocks.ax); visit(rocks.ay); visit(rocks.arot); visit(rocks.anchorTime);
+    visit(rocks.sizeClass); visit(rocks.paletteIndex); visit(rocks.shapeIndex); visit(rocks.destroyed);
+    visit(rocks.handles.denseIndex); visit(rocks.handles.generation); visit(rocks.handles.slotOf); visit(rocks.handles.freeSlots);
+}
+
+template <typename Store, typename Visit>
+static void visitBulletArrays(Store& shots, Visit&& visit) {
+    visit(shots.x); visit(shots.y); visit(shots.vx); visit(shots.vy); visit(shots.radius);
+    visit(shots.px); visit(shots.py); visit(shots.expiresAt); visit(shots.owner); visit(shots.spent); visit(shots.target); visit(shots.generation);
+}
+
+template <typename Store, typename Visit>
+static void visitShipArrays(Store& ships, Visit&& visit) {
+    visit(ships.x); visit(ships.y); visit(ships.vx); visit(ships.vy); visit(ships.rot); visit(ships.radius);
+    visit(ships.px); visit(ships.py); visit(ships.prot); visit(ships.scale);
+    visit(ships.fireReadyTick); visit(ships.shieldEndTick); visit(ships.shieldReadyTick);
+    visit(ships.shieldActive); visit(ships.thrusting); visit(ships.alive); visit(ships.score);
+}
+
+// Bytes per live rock, per rock pool slot (handle table), per bullet ring slot and per ship
+const size_t SNAPSHOT_ROCK_BYTES = 12 * sizeof(float) + sizeof(double) + sizeof(AsteroidSize) + sizeof(uint8_t) + sizeof(int) + sizeof(unsigned char);
+const size_t SNAPSHOT_ROCK_SLOT_BYTES = 3 * sizeof(uint32_t); // denseIndex, generation, and slotOf or freeSlots
+const size_t SNAPSHOT_BULLET_BYTES = 7 * sizeof(float) + sizeof(double) + sizeof(int32_t) + sizeof(unsigned char) + sizeof(EntityHandle) + sizeof(uint32_t);
+const size_t SNAPSHOT_SHIP_BYTES = 10 * sizeof(float) + 3 * sizeof(uint64_t) + 3 * sizeof(unsigned char) + sizeof(int);
+
+static size_t snapshotBytes(size_t rocks, size_t rockCapacity, size_t bulletCapacity, size_t ships) {
+    return sizeof(WorldSnapshotHeader) + rocks * SNAPSHOT_ROCK_BYTES + rockCapacity * SNAPSHOT_ROCK_SLOT_BYTES + bulletCapacity * SNAPSHOT_BULLET_BYTES +
+           ships * SNAPSHOT_SHIP_BYTES;
+}
+
+static size_t snapshotBytes(const GameWorld& world) {
+    return snapshotBytes(world.asteroids.count(), world.asteroids.handles.denseIndex.size(), world.bullets.capacity(), world.ships.count());
+}
+
+static uint32_t worldOptions(const GameWorld& world) {
+    return (world.asteroidCollisions ? REPLAY_OPTION_ROCK_COLLISIONS : 0) |
+           (world.asteroidBroadphase == BROADPHASE_SWEEP_AND_PRUNE ? REPLAY_OPTION_SWEEP_AND_PRUNE : 0) |
+           (world.asteroidBroadphase == BROADPHASE_BRUTE_FORCE ? REPLAY_OPTION_BRUTE_FORCE : 0) |
+           (world.kineticBulletHits ? REPLAY_OPTION_KINETIC : 0) |
+           (world.lazyAsteroidMotion ? REPLAY_OPTION_LAZY_MOTION : 0) |
+           (world.fixedPointKinematics ? REPLAY_OPTION_FIXED_POINT : 0) |
+           (world.silhouetteHits ? REPLAY_OPTION_SILHOUETTE : 0) |
+           (world.spatialSortAsteroids ? REPLAY_OPTION_SPATIAL_SORT : 0) |
+           (world.scriptedWaves ? REPLAY_OPTION_WAVES : 0) |
+           gravityReplayOptions(world);
+}
+
+// Everything but the arrays. Zeroed first, so the checksum never sees padding.
+static void fillHeader(const GameWorld& source, size_t bytes, WorldSnapshotHeader& header) {
+    const AsteroidStore& rocks = source.asteroids;
+    const BulletStore& shots = source.bullets;
+    std::memset(static_cast<void*>(&header), 0, sizeof(header));
+    header.magic = SNAPSHOT_MAGIC;
+    header.version = SNAPSHOT_VERSION;
+    header.bytes = bytes;
+    header.asteroidCount = static_cast<uint32_t>(rocks.count());
+    header.asteroidCapacity = static_cast<uint32_t>(rocks.handles.denseIndex.size());
+    header.bulletCapacity = static_cast<uint32_t>(shots.capacity());
+    header.shipCount = static_cast<uint32_t>(source.ships.count());
+    header.options = worldOptions(source);
+    header.asteroidSpawnTimer = source.asteroidSpawnTimer;
+    header.currentSpawnRate = source.currentSpawnRate;
+    header.score = source.score;
+    header.isGameOver = source.isGameOver ? 1 : 0;
+    header.waveSteps = source.waveSteps;
+    header.pendingAsteroidRemovals = source.pendingAsteroidRemovals;
+    header.asteroidClock = rocks.clock;
+    header.asteroidPreviousClock = rocks.previousClock;
+    header.bulletClock = shots.clock;
+    header.bulletTail = shots.tail;
+    header.bulletHead = shots.head;
+    header.bulletTombstones = shots.tombstones;
+    header.tick = source.tick;
+    header.waveResumeTick = source.waveResumeTick;
+    header.spawnRng = source.spawnRng;
+    header.shapeRng = source.shapeRng;
+    header.splitRng = source.splitRng;
+}
+
+// ============================ SNAPSHOT API ============================
+size_t worldSnapshotBytes(const SimulationLimits& limits) {
+    const size_t rockCapacity = static_cast<size_t>(limits.asteroidPoolCapacity());
+    return snapshotBytes(rockCapacity, rockCapacity, static_cast<size_t>(limits.maxBullets), static_cast<size_t>(limits.ships));
+}
+
+size_t saveWorldSnapshot(const GameWorld& source, void* buffer, size_t capacity) {
+    const size_t bytes = snapshotBytes(source);
+    if (bytes > capacity) return 0;
+
+    WorldSnapshotHeader header;
+    fillHeader(source, bytes, header);
+    unsigned char* cursor = static_cast<unsigned char*>(buffer);
+    std::memcpy(cursor, &header, sizeof(header));
+    cursor += sizeof(header);
+    auto copyOut = [&cursor](const auto& field) {
+        const size_t fieldBytes = field.size() * sizeof(field[0]);
+        std::memcpy(cursor, field.data(), fieldBytes);
+        cursor += fieldBytes;
+    };
+    visitAsteroidArrays(source.asteroids, copyOut);
+    visitBulletArrays(source.bullets, copyOut);
+    visitShipArrays(source.ships, copyOut);
+    return bytes;
+}
+
+bool restoreWorldSnapshot(GameWorld& target, const void* buffer, size_t bytes) {
+    WorldSnapshotHeader header;
+    if (bytes < sizeof(header)) return false;
+    std::memcpy(&header, buffer, sizeof(header));
+    AsteroidStore& rocks = target.asteroids;
+    BulletStore& shots = target.bullets;
+    if (header.magic != SNAPSHOT_MAGIC || header.version != SNAPSHOT_VERSION) return false;
+    if (header.asteroidCapacity != rocks.handles.denseIndex.size() || header.bulletCapacity != shots.capacity() ||
+        header.shipCount != target.ships.count()) return false;
+    if (header.asteroidCount > header.asteroidCapacity || header.bytes != bytes ||
+        bytes != snapshotBytes(header.asteroidCount, header.asteroidCapacity, header.bulletCapacity, header.shipCount)) return false;
+
+    // Every array to the snapshot's rock count, then the handle table's per-slot arrays back to the pool
+    // size (all within the reserved capacity, so nothing allocates), then filled
+    const size_t count = header.asteroidCount;
+    visitAsteroidArrays(rocks, [count](auto& field) { field.resize(count); });
+    rocks.handles.denseIndex.resize(header.asteroidCapacity);
+    rocks.handles.generation.resize(header.asteroidCapacity);
+    rocks.handles.freeSlots.resize(header.asteroidCapacity - count);
+    const unsigned char* cursor = static_cast<const unsigned char*>(buffer) + sizeof(header);
+    auto copyIn = [&cursor](auto& field) {
+        const size_t fieldBytes = field.size() * sizeof(field[0]);
+        std::memcpy(field.data(), cursor, fieldBytes);
+        cursor += fieldBytes;
+    };
+    visitAsteroidArrays(rocks, copyIn);
+    visitBulletArrays(shots, copyIn);
+    visitShipArrays(target.ships, copyIn);
+
+    target.asteroidSpawnTimer = header.asteroidSpawnTimer;
+    target.currentSpawnRate = header.currentSpawnRate;
+    target.score = header.score;
+    target.isGameOver = header.isGameOver != 0;
+    target.pendingAsteroidRemovals = static_cast<size_t>(header.pendingAsteroidRemovals);
+    rocks.clock = header.asteroidClock;
+    rocks.previousClock = header.asteroidPreviousClock;
+    shots.clock = header.bulletClock;
+    shots.tail = header.bulletTail;
+    shots.head = header.bulletHead;
+    shots.tombstones = static_cast<size_t>(header.bulletTombstones);
+    target.tick = header.tick;
+    target.waveSteps = header.waveSteps;
+    target.waveResumeTick = header.waveResumeTick;
+    target.spawnRng = header.spawnRng;
+    target.shapeRng = header.shapeRng;
+    target.splitRng = header.splitRng;
+    target.asteroidCollisions = (header.options & REPLAY_OPTION_ROCK_COLLISIONS) != 0;
+    target.asteroidBroadphase = replayBroadphase(header.options);
+    target.kineticBulletHits = (header.options & REPLAY_OPTION_KINETIC) != 0;
+    target.lazyAsteroidMotion = (header.options & REPLAY_OPTION_LAZY_MOTION) != 0;
+    target.fixedPointKinematics = (header.options & REPLAY_OPTION_FIXED_POINT) != 0;
+    target.silhouetteHits = (header.options & REPLAY_OPTION_SILHOUETTE) != 0;
+    target.spatialSortAsteroids = (header.options & REPLAY_OPTION_SPATIAL_SORT) != 0;
+    target.scriptedWaves = (header.options & REPLAY_OPTION_WAVES) != 0;
+    applyGravityReplayOptions(header.options, target);
+
+    // Derived state, rebuilt from the restored stores
+    target.asteroidSweep.entries.clear();
+    std::fill(target.asteroidSweep.trackedGeneration.begin(), target.asteroidSweep.trackedGeneration.end(), 0u);
+    target.kinetic.clear();
+    target.rebuildTimers();
+    target.restartWaves();
+    return true;
+}
+
+// ============================ CHECKSUM ============================
+// XXH64 (the reference algorithm, little-endian reads), chained over the header and each array in
+// snapshot order: every array is hashed with the previous result as its seed.
+const uint64_t XXH_PRIME1 = 0x9E3779B185EBCA87ull;
+const uint64_t XXH_PRIME2 = 0xC2B2AE3D27D4EB4Full;
+const uint64_t XXH_PRIME3 = 0x165667B19E3779F9ull;
+const uint64_t XXH_PRIME4 = 0x85EBCA77C2B2AE63ull;
+const uint64_t XXH_PRIME5 = 0x27D4EB2F165667C5ull;
+
+static uint64_t rotateLeft(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+static uint64_t xxhRound(uint64_t accumulator, uint64_t lane) {
+    accumulator += lane * XXH_PRIME2;
+    return rotateLeft(accumulator, 31) * XXH_PRIME1;
+}
+static uint64_t xxhMerge(uint64_t hash, uint64_t accumulator) {
+    hash ^= xxhRound(0, accumulator);
+    return hash * XXH_PRIME1 + XXH_PRIME4;
+}
+template <typename T>
+static T readLane(const unsigned char* p) {
+    T value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static uint64_t xxh64(const void* data, size_t length, uint64_t seed) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    const unsigned char* const end = p + length;
+    uint64_t hash;
+    if (length >= 32) {
+        uint64_t v1 = seed + XXH_PRIME1 + XXH_PRIME2, v2 = seed + XXH_PRIME2, v3 = seed, v4 = seed - XXH_PRIME1;
+        for (; end - p >= 32; p += 32) {
+            v1 = xxhRound(v1, readLane<uint64_t>(p));
+            v2 = xxhRound(v2, readLane<uint64_t>(p + 8));
+            v3 = xxhRound(v3, readLane<uint64_t>(p + 16));
+            v4 = xxhRound(v4, readLane<uint64_t>(p + 24));
+        }
+        hash = rotateLeft(v1, 1) + rotateLeft(v2, 7) + rotateLeft(v3, 12) + rotateLeft(v4, 18);
+        hash = xxhMerge(xxhMerge(xxhMerge(xxhMerge(hash, v1), v2), v3), v4);
+    }
+    else {
+        hash = seed + XXH_PRIME5;
+    }
+    hash += length;
+    for (; end - p >= 8; p += 8) hash = rotateLeft(hash ^ xxhRound(0, readLane<uint64_t>(p)), 27) * XXH_PRIME1 + XXH_PRIME4;
+    if (end - p >= 4) {
+        hash = rotateLeft(hash ^ (readLane<uint32_t>(p) * XXH_PRIME1), 23) * XXH_PRIME2 + XXH_PRIME3;
+        p += 4;
+    }
+    for (; p < end; ++p) hash = rotateLeft(hash ^ (*p * XXH_PRIME5), 11) * XXH_PRIME1;
+    hash ^= hash >> 33;
+    hash *= XXH_PRIME2;
+    hash ^= hash >> 29;
+    hash *= XXH_PRIME3;
+    return hash ^ (hash >> 32);
+}
+
+uint64_t worldChecksum(const GameWorld& source) {
+    WorldSnapshotHeader header;
+    fillHeader(source, snapshotBytes(source), header);
+    uint64_t hash = xxh64(&header, sizeof(header), 0);
+    auto hashField = [&hash](const auto& field) { hash = xxh64(field.data(), field.size() * sizeof(field[0]), hash); };
+    visitAsteroidArrays(source.asteroids, hashField);
+    visitBulletArrays(source.bullets, hashField);
+    visitShipArrays(source.ships, hashField);
+    return hash;
+}
+
+bool writeWorldSnapshotFile(const char* path, const void* buffer, size_t bytes) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(static_cast<const char*>(buffer), static_cast<std::streamsize>(bytes));
+    if (!file) {
+        LOG_ERROR("Cannot write snapshot %s", path);
+        return false;
+    }
+    return true;
+}
+
+bool readWorldSnapshotFile(const char* path, std::vector<unsigned char>& buffer) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        LOG_ERROR("Cannot open snapshot %s", path);
+        return false;
+    }
+    buffer.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+    WorldSnapshotHeader header;
+    if (!file || buffer.size() < sizeof(header)) {
+        LOG_ERROR("Cannot read snapshot %s", path);
+        return false;
+    }
+    std::memcpy(&header, buffer.data(), sizeof(header));
+    if (header.magic != SNAPSHOT_MAGIC || header.version != SNAPSHOT_VERSION) {
+        LOG_ERROR("%s is not a version %u snapshot", path, SNAPSHOT_VERSION);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "simulation.h"
+
+// Whole-world save and restore for rollback, replay scrubbing and crash triage. A snapshot is one
+// flat, versioned block: a POD header (timers, score, clocks, ring cursors, the three random
+// streams) followed by every entity array copied raw, rocks up to their live count and the ships,
+// the bullet ring and handle tables whole. Saving and restoring are a memcpy per array into or out
+// of a buffer the caller allocated once (worldSnapshotBytes), so neither allocates, and copying a
+// snapshot around (a rollback ring, a file) is a single memcpy of the block.
+// The block holds game state only. What the world derives from it again is reset on restore: the
+// sweep-and-prune order is rebuilt by the next tick, the kinetic schedule re-predicts every
+// bullet, the timer wheel is scheduled again from the ships' ticks and the wave script is run again
+// to the step it had reached. A restored world plays the same input to the same state as the one saved (benchmark
+// --snapshot checks it). State outside the world (the active stress scenario's stream) is not included.
+// Like simulation.h, nothing here depends on GL.
+
+// ============================ FORMAT ============================
+const uint32_t SNAPSHOT_MAGIC = 0x50414E53; // "SNAP"
+const uint32_t SNAPSHOT_VERSION = 7; // 2: the ships as arrays (ShipStore), bullet owners; 3: rock palette entries; 4: ship timers as ticks; 5: wave script progress; 6: rock scale and radius from the size class; 7: bullet targets (homing missiles)
+
+struct WorldSnapshotHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t bytes; // The whole block, header included
+    uint32_t asteroidCount;
+    uint32_t asteroidCapacity; // The pools' sizes: a snapshot restores only into a world init'ed with the same limits
+    uint32_t bulletCapacity;
+    uint32_t shipCount;
+    uint32_t options; // REPLAY_OPTION_* bits (replay.h): gameplay options the world ran with
+    float asteroidSpawnTimer;
+    float currentSpawnRate;
+    int32_t score;
+    uint8_t isGameOver, reserved[3];
+    uint32_t waveSteps; // GameWorld::waveSteps and waveResumeTick: where the wave script stands
+    uint64_t pendingAsteroidRemovals;
+    double asteroidClock, asteroidPreviousClock, bulletClock;
+    uint64_t bulletTail, bulletHead, bulletTombstones;
+    uint64_t tick; // GameWorld::tick, what the ships' timer ticks count from
+    uint64_t waveResumeTick;
+    Rng spawnRng, shapeRng, splitRng;
+};
+
+// ============================ SNAPSHOT API ============================
+// Largest block a world with these limits can need (a full asteroid pool)
+size_t worldSnapshotBytes(const SimulationLimits& limits);
+
+// Writes the world into `buffer` and returns the bytes written, or 0 if `capacity` is too small
+size_t saveWorldSnapshot(const GameWorld& source, void* buffer, size_t capacity);
+
+// Replaces the world's state with the snapshot's; false (and the world untouched) if the block is
+// not a snapshot of this version or the world's pools are not the size it was saved from
+bool restoreWorldSnapshot(GameWorld& target, const void* buffer, size_t bytes);
+
+// 64-bit XXH64 over exactly what a snapshot holds, without writing one: equal worlds hash equal,
+// so comparing it tick by tick finds where two runs of the same input part ways (replay.h)
+uint64_t worldChecksum(const GameWorld& source);
+
+// Crash triage: a snapshot to or from a file as is
+bool writeWorldSnapshotFile(const char* path, const void* buffer, size_t bytes);
+bool readWorldSnapshotFile(const char* path, std::vector<unsigned char>& buffer);
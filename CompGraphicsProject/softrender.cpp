@@ -0,0 +1,264 @@
+#include "softrender.h"
+#include "batchenv.h"
+#include "jobs.h"
+#include "log.h"
+#include "raster.h"
+#include "transform2d.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+// ============================ SOFTWARE RENDERER DATA ============================
+// Per strip job: the current outline in pixels and the points the rasterizers write. Every job owns
+// one, so the strips share nothing but the tiles they write to.
+struct SoftScratch {
+    std::vector<float> x, y; // The outline after transformPoints
+    std::vector<int> px, py; // ... truncated to pixels, as computeShipPixelVertices does
+    std::vector<PixelPoint> points;
+};
+
+static int worlds = 0, tile = 0;
+static int strips = 0; // Per tile
+static std::vector<uint32_t> pixels; // RGBA8, one tile after another
+static std::vector<SoftScratch> scratch; // One per job
+static std::vector<float> outlineX, outlineY; // Every atlas vertex, structure of arrays
+static int sizeLods[ASTEROID_SIZE_COUNT]; // The level each size class draws at this tile size
+static std::vector<int> shieldRows; // The shield's octant, walked once: its radius follows the tile
+
+static const uint32_t SOFT_CLEAR = 0xFF000000u; // Opaque black
+
+// RGBA8 as a little-endian word: red in the first byte
+static uint32_t packColor(const glm::vec3& color) {
+    const uint32_t r = static_cast<uint32_t>(std::clamp(color.r, 0.0f, 1.0f) * 255.0f + 0.5f);
+    const uint32_t g = static_cast<uint32_t>(std::clamp(color.g, 0.0f, 1.0f) * 255.0f + 0.5f);
+    const uint32_t b = static_cast<uint32_t>(std::clamp(color.b, 0.0f, 1.0f) * 255.0f + 0.5f);
+    return r | (g << 8) | (b << 16) | 0xFF000000u;
+}
+
+// The field (-1..1, y up) onto a tile with its first row at the top
+static Affine2 fieldToTile() {
+    const float half = static_cast<float>(tile) / 2.0f;
+    return { half, 0.0f, 0.0f, -half, half, half };
+}
+
+// ============================ SETUP ============================
+void setupSoftRenderer(int worldCount, int tileSize, const std::vector<float>& atlasVertices) {
+    worlds = std::max(worldCount, 1);
+    tile = std::max(tileSize, 1);
+    strips = (tile + SOFT_STRIP_ROWS - 1) / SOFT_STRIP_ROWS;
+    pixels.assign(static_cast<size_t>(worlds) * tile * tile, SOFT_CLEAR);
+
+    outlineX.resize(atlasVertices.size() / 2);
+    outlineY.resize(atlasVertices.size() / 2);
+    for (size_t v = 0; v < outlineX.size(); ++v) {
+        outlineX[v] = atlasVertices[2 * v];
+        outlineY[v] = atlasVertices[2 * v + 1];
+    }
+    for (int k = 0; k < ASTEROID_SIZE_COUNT; ++k) {
+        sizeLods[k] = asteroidLodForPixelRadius(getRadiusFactor(static_cast<AsteroidSize>(k)) * tile / 2.0f);
+    }
+    walkMidpointCircle(static_cast<int>(SHIELD_RADIUS_FACTOR * (tile / 2.0f)), shieldRows);
+
+    // A few jobs per thread, so a strip full of rocks does not hold up the rest; each job's scratch
+    // holds the finest outline and the longest line a tile can take (a ghost's edge may run off it)
+    const size_t jobs = std::min<size_t>(static_cast<size_t>(worlds) * strips, 4 * (static_cast<size_t>(jobWorkerCount()) + 1));
+    const size_t outlinePoints = ASTEROID_LOD_SEGMENTS[ASTEROID_LOD_COUNT - 1] + 1;
+    scratch.resize(jobs);
+    for (SoftScratch& job : scratch) {
+        job.x.resize(outlinePoints);
+        job.y.resize(outlinePoints);
+        job.px.resize(outlinePoints);
+        job.py.resize(outlinePoints);
+        job.points.resize(std::max<size_t>(4 * static_cast<size_t>(tile) + 2, 8 * shieldRows.size()));
+    }
+    LOG_INFO("Soft render: %d worlds in %dx%d tiles (%d strips each) on %zu jobs, %zu KB of pixels",
+             worlds, tile, tile, strips, jobs, pixels.size() * sizeof(uint32_t) / 1024);
+}
+
+void destroySoftRenderer() {
+    std::vector<uint32_t>().swap(pixels);
+    std::vector<SoftScratch>().swap(scratch);
+    worlds = tile = strips = 0;
+}
+
+size_t softObservationBytes() {
+    return static_cast<size_t>(tile) * tile * sizeof(uint32_t);
+}
+
+// ============================ STRIPS ============================
+// The rows [rowBegin, rowEnd) of one tile. The stores test both axes with one unsigned compare each,
+// so a point off the strip costs no branch.
+struct SoftStrip {
+    uint32_t* tilePixels;
+    int rowBegin, rowEnd;
+
+    void plot(const PixelPoint* points, size_t count, uint32_t color) const {
+        const unsigned width = static_cast<unsigned>(::tile), rows = static_cast<unsigned>(rowEnd - rowBegin);
+        for (size_t i = 0; i < count; ++i) {
+            const int x = points[i].x, y = points[i].y;
+            if (static_cast<unsigned>(x) < width && static_cast<unsigned>(y - rowBegin) < rows) tilePixels[y * ::tile + x] = color;
+        }
+    }
+    // Whether anything within `reach` pixels of row `y` can land in the strip
+    bool reaches(float y, float reach) const { return y + reach >= rowBegin && y - reach < rowEnd; }
+};
+
+static void drawRock(const SoftStrip& strip, SoftScratch& job, const AsteroidMesh& mesh, const Affine2& transform, uint32_t color) {
+    // The fan's boundary, closed: its last point repeats its first
+    const size_t first = static_cast<size_t>(mesh.baseVertex) + 1, count = static_cast<size_t>(mesh.vertexCount) - 1;
+    transformPoints(transform, outlineX.data() + first, outlineY.data() + first, count, job.x.data(), job.y.data());
+    for (size_t k = 0; k < count; ++k) {
+        job.px[k] = static_cast<int>(job.x[k]);
+        job.py[k] = static_cast<int>(job.y[k]);
+    }
+    for (size_t k = 0; k + 1 < count; ++k) {
+        const size_t points = drawBresenhamLine(job.px[k], job.py[k], job.px[k + 1], job.py[k + 1], job.points.data());
+        strip.plot(job.points.data(), points, color);
+    }
+}
+
+static void drawStrip(const GameWorld& world, const SoftStrip& strip, SoftScratch& job) {
+    std::fill(strip.tilePixels + static_cast<size_t>(strip.rowBegin) * tile, strip.tilePixels + static_cast<size_t>(strip.rowEnd) * tile, SOFT_CLEAR);
+    const Affine2 toTile = fieldToTile();
+    const float pixelsPerUnit = tile / 2.0f;
+
+    const AsteroidStore& rocks = world.asteroids; // Batch worlds integrate, so x/y are current
+    for (size_t i = 0; i < rocks.count(); ++i) {
+        const float reach = ASTEROID_MAX_OUTLINE_RADIUS * rocks.scale(i);
+        glm::vec2 images[4] = { glm::vec2(rocks.x[i], rocks.y[i]) };
+        const int ghosts = wrapGhostOffsets(images[0], reach, images + 1);
+        const AsteroidMesh& mesh = asteroidShapes[rocks.shapeIndex[i]].lods[sizeLods[rocks.sizeClass[i]]];
+        const uint32_t color = packColor(asteroidPalette[rocks.paletteIndex[i]]);
+        for (int g = 0; g <= ghosts; ++g) {
+            const glm::vec2 position = g == 0 ? images[0] : images[0] + images[g];
+            if (!strip.reaches(toTile.apply(position).y, reach * pixelsPerUnit + 1.0f)) continue;
+            drawRock(strip, job, mesh, toTile * Affine2::object(position, rocks.rot[i], rocks.scale(i)), color);
+        }
+    }
+
+    const ShipStore& ships = world.ships;
+    const uint32_t shipColor = packColor(glm::vec3(0.5f, 1.0f, 1.0f));
+    const uint32_t shieldColor = packColor(glm::vec3(0.3f, 0.6f, 1.0f));
+    for (size_t s = 0; s < ships.count(); ++s) {
+        if (!ships.alive[s]) continue;
+        const glm::vec2 position(ships.x[s], ships.y[s]);
+        const glm::vec2 centre = toTile.apply(position);
+        if (ships.shieldActive[s] && strip.reaches(centre.y, static_cast<float>(shieldRows.empty() ? 0 : shieldRows[0]) + 1.0f)) {
+            const size_t points = drawMidpointCircle(static_cast<int>(centre.x), static_cast<int>(centre.y), shieldRows, job.points.data());
+            strip.plot(job.points.data(), points, shieldColor);
+        }
+        if (!strip.reaches(centre.y, ships.scale[s] * 1.5f * pixelsPerUnit + 1.0f)) continue;
+        // The ship shader's triangle, rounded as computeShipPixelVertices does
+        const Affine2 transform = toTile * Affine2::object(position, ships.rot[s], ships.scale[s]);
+        const glm::vec2 corners[3] = { transform.apply(glm::vec2(0.0f, 1.0f)), transform.apply(glm::vec2(-1.0f, -1.0f)), transform.apply(glm::vec2(1.0f, -1.0f)) };
+        int v[6];
+        for (int k = 0; k < 3; ++k) {
+            v[2 * k] = static_cast<int>(corners[k].x);
+            v[2 * k + 1] = static_cast<int>(corners[k].y);
+        }
+        const size_t points = drawBresenhamShip(v, job.points.data());
+        strip.plot(job.points.data(), points, shipColor);
+    }
+
+    // Bullets are single pixels: gathered into the point buffer, then stored like an outline
+    const BulletStore& bullets = world.bullets;
+    const uint32_t bulletColor = packColor(glm::vec3(1.0f, 0.0f, 0.0f));
+    size_t gathered = 0;
+    for (size_t j = 0; j < bullets.capacity(); ++j) {
+        if (!bullets.live(j)) continue;
+        const glm::vec2 pixel = toTile.apply(glm::vec2(bullets.x[j], bullets.y[j]));
+        job.points[gathered++] = PixelPoint{ static_cast<std::int16_t>(pixel.x), static_cast<std::int16_t>(pixel.y) };
+        if (gathered == job.points.size()) {
+            strip.plot(job.points.data(), gathered, bulletColor);
+            gathered = 0;
+        }
+    }
+    strip.plot(job.points.data(), gathered, bulletColor);
+}
+
+// ============================ RENDER ============================
+const uint8_t* renderSoftObservations(const BatchEnvironment& env) {
+    const size_t units = std::min(env.worlds.size(), static_cast<size_t>(worlds)) * static_cast<size_t>(strips);
+    const size_t jobs = std::min(units, scratch.size());
+    // Job c takes strips [c * units / jobs, (c + 1) * units / jobs), a tile's strips one after another
+    parallelFor(0, jobs, 1, [&env, units, jobs](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c) {
+            for (size_t unit = c * units / jobs; unit < (c + 1) * units / jobs; ++unit) {
+                const size_t w = unit / static_cast<size_t>(strips);
+                const int strip = static_cast<int>(unit % static_cast<size_t>(strips));
+                const SoftStrip rows = { pixels.data() + w * static_cast<size_t>(tile) * tile, strip * SOFT_STRIP_ROWS,
+                                         std::min(tile, (strip + 1) * SOFT_STRIP_ROWS) };
+                drawStrip(env.worlds[w], rows, scratch[c]);
+            }
+        }
+    });
+    return reinterpret_cast<const uint8_t*>(pixels.data());
+}
+
+bool writeSoftObservation(const char* path, const uint8_t* tilePixels) {
+    FILE* file = std::fopen(path, "wb");
+    if (!file) {
+        LOG_WARN("Could not write the observation image %s", path);
+        return false;
+    }
+    std::fprintf(file, "P6\n%d %d\n255\n", tile, tile);
+    std::vector<uint8_t> row(static_cast<size_t>(tile) * 3);
+    for (int y = 0; y < tile; ++y) {
+        const uint8_t* source = tilePixels + static_cast<size_t>(y) * tile * 4;
+        for (int x = 0; x < tile; ++x) {
+            row[3 * x] = source[4 * x];
+            row[3 * x + 1] = source[4 * x + 1];
+            row[3 * x + 2] = source[4 * x + 2];
+        }
+        std::fwrite(row.data(), 1, row.size(), file);
+    }
+    const bool written = std::ferror(file) == 0;
+    std::fclose(file);
+    if (!written) LOG_WARN("Could not write the observation image %s", path);
+    return written;
+}
+
+// ============================ HEADLESS RUN ============================
+void runBatchSoftRendered(int worldCount, long long steps, uint64_t seed, int tileSize, const std::vector<float>& atlasVertices,
+                          const char* imagePath) {
+    BatchEnvironment env;
+    env.init(worldCount, seed);
+    setupSoftRenderer(static_cast<int>(env.worlds.size()), tileSize, atlasVertices);
+    const size_t count = env.worlds.size();
+    std::vector<float> observations(count * BATCH_OBSERVATION_SIZE);
+    std::vector<float> rewards(count);
+    std::vector<uint8_t> dones(count);
+
+    InputState policy; // Same as the GL batch run
+    policy.left = true;
+    policy.fire = true;
+    policy.shield = true;
+    std::vector<uint8_t> inputs(count, packInput(policy));
+
+    // A bot would read the pixels here; the run only touches every world's first pixel
+    unsigned long long pixelSum = 0;
+    const uint8_t* observed = nullptr;
+    double drawSeconds = 0.0;
+    env.reset(observations.data());
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+    for (long long s = 0; s < steps; ++s) {
+        env.step(inputs.data(), observations.data(), rewards.data(), dones.data());
+        const Clock::time_point drawStart = Clock::now();
+        observed = renderSoftObservations(env);
+        drawSeconds += std::chrono::duration<double>(Clock::now() - drawStart).count();
+        for (size_t i = 0; i < count; ++i) pixelSum += observed[i * softObservationBytes()];
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    double worldSteps = static_cast<double>(steps) * static_cast<double>(count);
+    LOG_INFO("[soft render] %zu worlds, %dx%d tiles on %d threads: %lld steps in %g s = %.0f observations/s "
+             "(drawing %.0f frames/s, %.1f us per frame per thread, checksum %llu)",
+             count, tileSize, tileSize, jobWorkerCount() + 1, steps, seconds, seconds > 0.0 ? worldSteps / seconds : 0.0,
+             drawSeconds > 0.0 ? worldSteps / drawSeconds : 0.0,
+             worldSteps > 0.0 ? drawSeconds * 1e6 * (jobWorkerCount() + 1) / worldSteps : 0.0, pixelSum);
+    if (imagePath && observed && writeSoftObservation(imagePath, observed)) LOG_INFO("[soft render] World 0's last observation written to %s", imagePath);
+    destroySoftRenderer();
+}
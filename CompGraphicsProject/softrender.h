@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "simulation.h"
+
+struct BatchEnvironment;
+
+// Software observations (--batch-render SIZE --soft-render): the batch renderer's images drawn on
+// the CPU, for machines with no GL context (CI, headless bot training). Same layout as batchrender.h:
+// one SIZE x SIZE RGBA8 tile per world, top row first, world i's tile one contiguous block. Outlines
+// rather than fills: each rock's atlas outline (its size class's level for the tile, ghosts across
+// the edges included) and the ship triangle go through drawBresenhamLine, a raised shield through
+// drawMidpointCircle, and bullets are single pixels, all written straight into the tile.
+// The tiles are split into strips of SOFT_STRIP_ROWS rows and the strips of every world spread over
+// the job system, each strip clearing its rows and drawing what reaches them; the outline transforms
+// go through transformPoints and the clears, roundings and clipped stores are plain loops over
+// arrays that the compiler vectorizes. Like simulation.h, nothing here depends on GL.
+const int SOFT_STRIP_ROWS = 64;
+
+// ============================ SOFTWARE RENDERER API ============================
+// Sizes the pixel buffer and the per-job scratch and copies the atlas outlines out of the atlas
+// vertices; the shapes must already be generated
+void setupSoftRenderer(int worldCount, int tileSize, const std::vector<float>& atlasVertices);
+void destroySoftRenderer();
+size_t softObservationBytes(); // Bytes of one world's tile
+
+// Draws every world's current state into its tile and returns the pixels, valid until the next call.
+// Synchronous: the caller's thread draws strips alongside the workers.
+const uint8_t* renderSoftObservations(const BatchEnvironment& env);
+// Writes one tile as a binary PPM (the alpha dropped); false, with a warning, if the file cannot be written
+bool writeSoftObservation(const char* path, const uint8_t* tile);
+
+// ============================ HEADLESS RUN ============================
+// runBatchRendered on the CPU: each step's observations are drawn once the step is done. Logs the
+// throughput; with `imagePath`, world 0's last observation is written there.
+void runBatchSoftRendered(int worldCount, long long steps, uint64_t seed, int tileSize, const std::vector<float>& atlasVertices,
+                          const char* imagePath);
@@ -0,0 +1,190 @@
+#include "spatialquery.h"
+#include "fastmath.h"
+#include "jobs.h"
+
+#include <algorithm>
+#include <cmath>
+#include <glm/gtc/constants.hpp>
+#include <limits>
+
+// ============================ INDEX ============================
+void SpatialQueryIndex::init(size_t capacity) {
+    const float cellsPerSide = std::sqrt(static_cast<float>(std::max<size_t>(capacity, 1)) / QUERY_ENTITIES_PER_CELL);
+    grid.init(FIELD_WIDTH / std::max(cellsPerSide, 1.0f), capacity);
+    x = y = nullptr;
+    count = 0;
+}
+
+void SpatialQueryIndex::build(const float* px, const float* py, size_t n, const float* radii) {
+    x = px;
+    y = py;
+    radius = radii;
+    count = n;
+    maxRadius = radii && n > 0 ? *std::max_element(radii, radii + n) : 0.0f;
+    grid.build(px, py, n);
+}
+
+// ============================ QUERIES ============================
+static float wrappedDistanceSq(const SpatialQueryIndex& index, int i, glm::vec2 center) {
+    const float dx = nearestImage(index.x[i], center.x) - center.x;
+    const float dy = nearestImage(index.y[i], center.y) - center.y;
+    return dx * dx + dy * dy;
+}
+
+size_t queryRadius(const SpatialQueryIndex& index, glm::vec2 center, float radius, QueryHit* hits, size_t capacity) {
+    size_t found = 0;
+    const float radiusSq = radius * radius;
+    index.grid.forEachWithin(center, radius, [&](int i) {
+        const float distanceSq = wrappedDistanceSq(index, i, center);
+        if (distanceSq > radiusSq) return;
+        if (found < capacity) hits[found] = { i, distanceSq };
+        ++found;
+    });
+    return found;
+}
+
+// Keeps hits[0, found) the nearest so far, sorted (ties by index), at most k of them
+static void insertNearest(QueryHit* hits, size_t& found, size_t k, int i, float distanceSq) {
+    const auto before = [](const QueryHit& a, float distanceSq, int i) { return a.distanceSq > distanceSq || (a.distanceSq == distanceSq && a.index > i); };
+    if (found == k && !before(hits[k - 1], distanceSq, i)) return;
+    size_t slot = std::min(found, k - 1);
+    while (slot > 0 && before(hits[slot - 1], distanceSq, i)) {
+        hits[slot] = hits[slot - 1];
+        --slot;
+    }
+    hits[slot] = { i, distanceSq };
+    found = std::min(found + 1, k);
+}
+
+size_t queryKNearest(const SpatialQueryIndex& index, glm::vec2 center, size_t k, QueryHit* hits) {
+    if (k == 0 || index.count == 0) return 0;
+    const SpatialGrid& grid = index.grid;
+    const int cx = grid.cellCoord(center.x), cy = grid.cellCoord(center.y);
+    size_t found = 0;
+    for (int ring = 0;; ++ring) {
+        if (2 * ring + 1 > grid.dim) { // The ring would wrap onto cells already visited: finish by brute force
+            found = 0;
+            for (size_t i = 0; i < index.count; ++i) insertNearest(hits, found, k, static_cast<int>(i), wrappedDistanceSq(index, static_cast<int>(i), center));
+            return found;
+        }
+        for (int dy = -ring; dy <= ring; ++dy) {
+            const int row = (cy + dy + grid.dim) % grid.dim;
+            const int step = dy == -ring || dy == ring ? 1 : std::max(2 * ring, 1); // Whole edge rows, else the two sides
+            for (int dx = -ring; dx <= ring; dx += step) {
+                const int cell = row * grid.dim + (cx + dx + grid.dim) % grid.dim;
+                for (int e = grid.cellStart[cell]; e < grid.cellStart[cell + 1]; ++e) {
+                    const int i = grid.entries[e];
+                    insertNearest(hits, found, k, i, wrappedDistanceSq(index, i, center));
+                }
+            }
+        }
+        // Anything in the rings further out is at least `ring` whole cells away
+        const float reach = static_cast<float>(ring) * grid.cellSize;
+        if (found == k && hits[k - 1].distanceSq <= reach * reach) return found;
+    }
+}
+
+void queryRadiusBatch(const SpatialQueryIndex& index, const glm::vec2* centers, size_t count, float radius,
+                      QueryHit* hits, size_t capacity, uint32_t* counts) {
+    parallelFor(0, count, QUERY_BATCH_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t q = begin; q < end; ++q) counts[q] = static_cast<uint32_t>(queryRadius(index, centers[q], radius, hits + q * capacity, capacity));
+    });
+}
+
+void queryKNearestBatch(const SpatialQueryIndex& index, const glm::vec2* centers, size_t count, size_t k, QueryHit* hits, uint32_t* counts) {
+    parallelFor(0, count, QUERY_BATCH_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t q = begin; q < end; ++q) counts[q] = static_cast<uint32_t>(queryKNearest(index, centers[q], k, hits + q * k));
+    });
+}
+
+// ============================ RAYS ============================
+// Where the ray enters circle i seen at `image` (its position moved by whole field widths), if within maxDistance
+static bool rayMeetsCircle(glm::vec2 origin, glm::vec2 direction, glm::vec2 image, float radius, float maxDistance, float& distance) {
+    const glm::vec2 toCentre = image - origin;
+    const float along = glm::dot(toCentre, direction);
+    const float missSq = glm::dot(toCentre, toCentre) - along * along;
+    const float radiusSq = radius * radius;
+    if (missSq > radiusSq) return false;
+    const float halfChord = std::sqrt(radiusSq - missSq);
+    if (along + halfChord < 0.0f) return false; // Behind the origin
+    distance = std::max(along - halfChord, 0.0f);
+    return distance <= maxDistance;
+}
+
+bool queryRay(const SpatialQueryIndex& index, glm::vec2 origin, glm::vec2 direction, float maxDistance, RayHit& hit) {
+    if (index.count == 0 || !index.radius) return false;
+    const SpatialGrid& grid = index.grid;
+    const float cellSize = grid.cellSize;
+    const int dim = grid.dim;
+    // Cells in unwrapped coordinates: (cx, cy) is cell (cx mod dim, cy mod dim), its rocks seen
+    // (cx div dim, cy div dim) field widths away
+    const float gx = (origin.x + 1.0f) / cellSize, gy = (origin.y + 1.0f) / cellSize;
+    int cx = static_cast<int>(std::floor(gx)), cy = static_cast<int>(std::floor(gy));
+    const int stepX = direction.x > 0.0f ? 1 : -1, stepY = direction.y > 0.0f ? 1 : -1;
+    const float infinity = std::numeric_limits<float>::infinity();
+    const float deltaX = direction.x != 0.0f ? cellSize / std::abs(direction.x) : infinity;
+    const float deltaY = direction.y != 0.0f ? cellSize / std::abs(direction.y) : infinity;
+    float exitX = direction.x != 0.0f ? (static_cast<float>(cx + (stepX > 0)) - gx) * cellSize / direction.x : infinity;
+    float exitY = direction.y != 0.0f ? (static_cast<float>(cy + (stepY > 0)) - gy) * cellSize / direction.y : infinity;
+    const int reach = static_cast<int>(std::ceil(index.maxRadius / cellSize)); // Rings of cells a circle crossing the ray's cell can be centred in
+
+    bool found = false;
+    RayHit best = { -1, infinity };
+    int previousX = 0, previousY = 0;
+    bool first = true;
+    while (true) {
+        for (int y = cy - reach; y <= cy + reach; ++y) {
+            const int wrappedY = ((y % dim) + dim) % dim;
+            const float shiftY = static_cast<float>((y - wrappedY) / dim) * FIELD_WIDTH;
+            for (int x = cx - reach; x <= cx + reach; ++x) {
+                if (!first && std::abs(x - previousX) <= reach && std::abs(y - previousY) <= reach) continue; // Tested last step
+                const int wrappedX = ((x % dim) + dim) % dim;
+                const float shiftX = static_cast<float>((x - wrappedX) / dim) * FIELD_WIDTH;
+                const int cell = wrappedY * dim + wrappedX;
+                for (int e = grid.cellStart[cell]; e < grid.cellStart[cell + 1]; ++e) {
+                    const int i = grid.entries[e];
+                    float distance;
+                    const glm::vec2 image(index.x[i] + shiftX, index.y[i] + shiftY);
+                    if (!rayMeetsCircle(origin, direction, image, index.radius[i], maxDistance, distance)) continue;
+                    if (distance < best.distance || (distance == best.distance && i < best.index)) {
+                        best = { i, distance };
+                        found = true;
+                    }
+                }
+            }
+        }
+        // Every circle the ray meets before leaving this cell has now been tested
+        const float exit = std::min(exitX, exitY);
+        if ((found && best.distance <= exit) || exit > maxDistance) break;
+        previousX = cx;
+        previousY = cy;
+        first = false;
+        if (exitX < exitY) {
+            cx += stepX;
+            exitX += deltaX;
+        }
+        else {
+            cy += stepY;
+            exitY += deltaY;
+        }
+    }
+    if (found) hit = best;
+    return found;
+}
+
+void queryRayBatch(const SpatialQueryIndex& index, const glm::vec2* origins, const glm::vec2* directions, size_t count,
+                   float maxDistance, RayHit* hits) {
+    parallelFor(0, count, QUERY_BATCH_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t q = begin; q < end; ++q) {
+            if (!queryRay(index, origins[q], directions[q], maxDistance, hits[q])) hits[q] = { -1, 0.0f };
+        }
+    });
+}
+
+// ============================ HITSCAN ============================
+bool findLaserTarget(const GameWorld& world, const SpatialQueryIndex& rocks, size_t s, RayHit& hit) {
+    const float angleFromXAxis = world.ships.rot[s] + glm::half_pi<float>(); // As applyInput's facing
+    glm::vec2 facing;
+    fastSinCos(angleFromXAxis, facing.y, facing.x);
+    return queryRay(rocks, world.ships.position(s), facing, LASER_RANGE, hit);
+}
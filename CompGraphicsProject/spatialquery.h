@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "simulation.h"
+
+// Neighbour queries over a set of points on the toroidal [-1,1] field, for the code outside the
+// collision checks that asks "what is near here": bots, homing weapons, observations. The tick's own
+// grids are built mid-step and go stale as soon as the sweep compacts the rocks, so a query index is
+// a SpatialGrid of its own, built by the caller over the positions it means to ask about (typically
+// the AsteroidStore's after a step) and valid until they change. Distances are between centres, to
+// the nearest wrapped image. Built with radii, the index also answers ray queries (a hitscan weapon:
+// the first circle along a line). Results go into caller-provided buffers; the batch forms spread
+// many query points over the job system, each writing only its own slice.
+// Like simulation.h, nothing here depends on GL.
+
+// ============================ INDEX ============================
+// The index itself (SpatialQueryIndex) and QueryHit are declared in simulation.h, so that a world
+// can keep one for its homing missiles.
+const size_t QUERY_BATCH_GRAIN = 64; // Query points per job
+
+struct RayHit {
+    int index;
+    float distance; // Along the ray to where it enters the circle (0 if it starts inside)
+};
+
+// ============================ QUERIES ============================
+// Points within `radius` of center, in grid order, into hits (at most `capacity`). Returns how many
+// there are, which may be more than were written.
+size_t queryRadius(const SpatialQueryIndex& index, glm::vec2 center, float radius, QueryHit* hits, size_t capacity);
+// The k nearest points, nearest first (ties by index), into hits. Returns how many were written
+// (k, or every point if there are fewer). Rings of cells are visited outwards until the k-th nearest
+// is closer than anything in the next ring could be.
+size_t queryKNearest(const SpatialQueryIndex& index, glm::vec2 center, size_t k, QueryHit* hits);
+
+// The same for `count` query points: query q writes hits[q * capacity ...] (hits[q * k ...]) and its
+// return value to counts[q]
+void queryRadiusBatch(const SpatialQueryIndex& index, const glm::vec2* centers, size_t count, float radius,
+                      QueryHit* hits, size_t capacity, uint32_t* counts);
+void queryKNearestBatch(const SpatialQueryIndex& index, const glm::vec2* centers, size_t count, size_t k, QueryHit* hits, uint32_t* counts);
+
+// The first circle the ray from origin along `direction` (unit length) meets within maxDistance (ties
+// by index), through the wrap: past an edge the ray goes on from the opposite one, for as long as
+// maxDistance lasts. A grid DDA walks the cells the ray crosses; each step tests the cells newly
+// within maxRadius of it, and the walk ends at the first cell the best hit so far lies inside of.
+// Returns false (hit untouched) if nothing is in the way. The index must have been built with radii.
+bool queryRay(const SpatialQueryIndex& index, glm::vec2 origin, glm::vec2 direction, float maxDistance, RayHit& hit);
+// The same for `count` rays: hits[q].index is -1 where ray q meets nothing
+void queryRayBatch(const SpatialQueryIndex& index, const glm::vec2* origins, const glm::vec2* directions, size_t count,
+                   float maxDistance, RayHit* hits);
+
+// ============================ HITSCAN ============================
+const float LASER_RANGE = FIELD_WIDTH; // Once across the field, so a beam never comes back round to its ship
+
+// What a hitscan shot from ship s would hit: the ray from the ship along its facing (the direction
+// applyInput fires and thrusts in), against an index built over the world's rocks with their radii
+bool findLaserTarget(const GameWorld& world, const SpatialQueryIndex& rocks, size_t s, RayHit& hit);
@@ -0,0 +1,272 @@
+#include "spectator.h"
+#include "alloctrack.h"
+#include "log.h"
+#include "replication.h"
+#include "udpsocket.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+// A decoded snapshot: its entities stay in the receiver, by sequence
+struct SpectatorFrame {
+    uint64_t tick = 0;
+    uint32_t sequence = 0;
+};
+
+static UdpSocket spectatorSocket;
+static UdpAddress server;
+static uint32_t watchedMatch = 0;
+static bool spectating = false;
+static bool welcomed = false;
+static bool refused = false; // Warned about the last refusal; cleared by a welcome
+static uint32_t inputSequence = 0;
+static ReplicationReceiver receiver;
+static SpectatorFrame history[SPECTATOR_HISTORY]; // Oldest first
+static int historyCount = 0;
+static double playbackTick = 0.0;
+static Clock::time_point lastJoin, lastSnapshot, lastFrame;
+static std::vector<unsigned char> datagram;
+
+static void sendToServer(ClientPacketType type) {
+    ClientPacket packet = {};
+    packet.magic = SERVER_PROTOCOL_MAGIC;
+    packet.version = SERVER_PROTOCOL_VERSION;
+    packet.type = type;
+    packet.match = watchedMatch;
+    packet.sequence = ++inputSequence;
+    packet.ack = receiver.latest;
+    spectatorSocket.send(&packet, sizeof(packet), server);
+}
+
+// ============================ NETWORK ============================
+static void receiveSnapshots(Clock::time_point now) {
+    AllowAllocations decode; // The decoded lists grow with the match
+    UdpAddress from;
+    for (;;) {
+        const int received = spectatorSocket.receive(datagram.data(), datagram.size(), from);
+        if (received < 0) break;
+        ServerPacketHeader header;
+        if (!(from == server) || received < static_cast<int>(sizeof(header))) continue;
+        std::memcpy(&header, datagram.data(), sizeof(header));
+        if (header.magic != SERVER_PROTOCOL_MAGIC || header.version != SERVER_PROTOCOL_VERSION) continue;
+        if (header.type == SERVER_WELCOME) {
+            if (!welcomed) {
+                LOG_INFO("Spectator: watching match %u%s", header.match, header.player ? " (a new one: nobody flies its ship)" : "");
+                watchedMatch = header.match;
+            }
+            welcomed = true;
+            refused = false;
+            lastSnapshot = now; // The timeout counts from here until the first snapshot
+            continue;
+        }
+        if (header.type == SERVER_NO_MATCH || header.type == SERVER_FULL) {
+            if (!refused) LOG_WARN("Spectator: %s match %u; retrying", header.type == SERVER_NO_MATCH ? "no" : "no room in", watchedMatch);
+            refused = true;
+            welcomed = false;
+            continue;
+        }
+        if (header.type != SERVER_SNAPSHOT) continue;
+        if (!decodeReplication(receiver, datagram.data() + sizeof(header), static_cast<size_t>(received) - sizeof(header))) continue;
+        welcomed = true; // A snapshot says so even if the welcome was lost
+        refused = false;
+        lastSnapshot = now;
+        sendToServer(CLIENT_INPUT); // The acknowledgement (a watcher's key bits are ignored)
+
+        // A tick going back is a new game on the server (or a new server): start over
+        if (historyCount > 0 && header.tick <= history[historyCount - 1].tick) historyCount = 0;
+        if (historyCount == SPECTATOR_HISTORY) {
+            std::move(history + 1, history + SPECTATOR_HISTORY, history);
+            --historyCount;
+        }
+        history[historyCount++] = { header.tick, receiver.latest };
+    }
+}
+
+// ============================ INTERPOLATION ============================
+static float wrapCoordinate(float v) {
+    return v > 1.0f ? v - FIELD_WIDTH : (v < -1.0f ? v + FIELD_WIDTH : v);
+}
+
+// `from` moved `t` of the way to `to` (t > 1 extrapolates, t < 0 goes back); rocks and ships across the
+// wrap edges the short way, bullets (which do not wrap) in a straight line
+static ReplicatedEntity blendEntity(const ReplicatedEntity& from, const ReplicatedEntity& to, float t, glm::vec2& position, float& rotation) {
+    const glm::vec2 a = replicatedPosition(from), b = replicatedPosition(to);
+    if (replicatedKind(to.id) == REPLICATED_BULLET) position = a + (b - a) * t;
+    else {
+        position = a + (glm::vec2(nearestImage(b.x, a.x), nearestImage(b.y, a.y)) - a) * t;
+        position = glm::vec2(wrapCoordinate(position.x), wrapCoordinate(position.y));
+    }
+    const int16_t turn = static_cast<int16_t>(static_cast<uint16_t>(to.rotation - from.rotation)); // The short way round
+    rotation = replicatedRotation(from) + turn * (2.0f * glm::pi<float>() / 65536.0f) * t;
+    return t < 0.5f ? from : to;
+}
+
+// Moves an entity by its velocity for `seconds`
+static void extrapolateEntity(const ReplicatedEntity& e, float seconds, glm::vec2& position, float& rotation) {
+    position = replicatedPosition(e) + replicatedVelocity(e) * seconds;
+    if (replicatedKind(e.id) != REPLICATED_BULLET) position = glm::vec2(wrapCoordinate(position.x), wrapCoordinate(position.y));
+    rotation = replicatedRotation(e);
+}
+
+static void addEntity(RenderSnapshot& view, const ReplicatedEntity& e, glm::vec2 position, float rotation) {
+    const glm::vec2 velocity = replicatedVelocity(e);
+    const ReplicatedKind kind = replicatedKind(e.id);
+    if (kind == REPLICATED_ROCK) {
+        Asteroid rock;
+        rock.position = position;
+        rock.velocity = velocity;
+        rock.rotation = rotation;
+        rock.rotationSpeed = 0.0f;
+        rock.size = static_cast<AsteroidSize>(e.look & 3u);
+        rock.shapeIndex = static_cast<int>((e.look >> 2) & 0x3Fu) % ASTEROID_SHAPE_COUNT;
+        rock.paletteIndex = static_cast<uint8_t>(((e.look >> 8) & 0xFFu) % ASTEROID_PALETTE_SIZE);
+        view.asteroids.push(rock);
+        return;
+    }
+    if (kind == REPLICATED_BULLET) {
+        Bullet bullet;
+        bullet.position = position;
+        bullet.velocity = velocity;
+        view.bullets.push(bullet);
+        return;
+    }
+    const bool lost = (e.look & 4u) != 0, thrusting = (e.look & 1u) != 0;
+    Ship ship;
+    ship.position = ship.prevPosition = position;
+    ship.velocity = velocity;
+    ship.rotation = ship.prevRotation = rotation;
+    if (e.id == replicatedId(REPLICATED_SHIP, { 0, 0 })) {
+        view.player = ship;
+        view.isGameOver = lost;
+        view.shieldActive = (e.look & 2u) != 0;
+        view.shieldTimer = view.shieldActive ? SHIELD_DURATION : 0.0f; // The time left is not sent
+        view.isThrusting = thrusting;
+        view.score = static_cast<int>(e.extra);
+    }
+    else if (!lost && view.others.size() < view.others.capacity()) {
+        view.others.push_back(ship);
+        view.otherShieldTimers.push_back((e.look & 2u) != 0 ? SHIELD_DURATION : 0.0f);
+    }
+    if (!lost && thrusting && view.thrusters.size() < view.thrusters.capacity()) view.thrusters.push_back(ship);
+}
+
+// ============================ SPECTATOR API ============================
+bool startSpectator(const char* hostAndPort, uint32_t match) {
+    stopSpectator();
+    if (!resolveUdpAddress(hostAndPort, 27960, server)) {
+        LOG_ERROR("Spectator: cannot resolve %s", hostAndPort);
+        return false;
+    }
+    if (!spectatorSocket.open(0)) {
+        LOG_ERROR("Spectator: cannot open a UDP socket");
+        return false;
+    }
+    spectatorSocket.setReceiveTimeout(0);
+    datagram.resize(SERVER_MAX_DATAGRAM);
+    watchedMatch = match;
+    receiver = ReplicationReceiver();
+    historyCount = 0;
+    welcomed = refused = false;
+    lastJoin = lastSnapshot = lastFrame = Clock::time_point();
+    spectating = true;
+    LOG_INFO("Spectator: joining match %u at %s", match, hostAndPort);
+    return true;
+}
+
+void stopSpectator() {
+    if (!spectating) return;
+    if (welcomed) sendToServer(CLIENT_LEAVE);
+    spectatorSocket.close();
+    spectating = false;
+}
+
+bool spectatorActive() {
+    return spectating;
+}
+
+void updateSpectatorView(RenderSnapshot& view, Clock::time_point now) {
+    receiveSnapshots(now);
+    // Join until welcomed, and again after the server has gone quiet (it may have dropped us)
+    if (welcomed && now - lastSnapshot > std::chrono::milliseconds(SERVER_CLIENT_TIMEOUT_MS)) welcomed = false;
+    if (!welcomed && now - lastJoin > std::chrono::milliseconds(SPECTATOR_JOIN_RETRY_MS)) {
+        sendToServer(CLIENT_JOIN);
+        lastJoin = now;
+    }
+
+    // The playback clock: frame time in ticks, steered towards the delayed newest tick
+    const float seconds = lastFrame == Clock::time_point() ? 0.0f : std::min(std::chrono::duration<float>(now - lastFrame).count(), 0.25f);
+    lastFrame = now;
+    playbackTick += seconds * SIM_TICK_RATE;
+    if (historyCount > 0) {
+        const double target = static_cast<double>(history[historyCount - 1].tick) - SPECTATOR_DELAY_TICKS;
+        const double error = target - playbackTick;
+        if (std::abs(error) > SPECTATOR_SNAP_TICKS) playbackTick = target;
+        else playbackTick += error * std::min(1.0f, seconds * SPECTATOR_STEER_RATE);
+    }
+
+    view.asteroids.sweep([](size_t) { return true; });
+    view.bullets.clear();
+    view.others.clear();
+    view.otherShieldTimers.clear();
+    view.thrusters.clear();
+    view.lazyAsteroidMotion = false;
+    view.wrapsAtEdges = true;
+    view.tickTime = now;
+    if (historyCount == 0) {
+        view.isGameOver = true; // Nothing to watch yet
+        view.shieldActive = view.isThrusting = false;
+        return;
+    }
+
+    // The snapshots either side of the playback tick (both the oldest or both the newest past the ends)
+    int later = 0;
+    while (later < historyCount && static_cast<double>(history[later].tick) <= playbackTick) ++later;
+    const SpectatorFrame& a = history[std::max(later - 1, 0)];
+    const SpectatorFrame& b = history[std::min(later, historyCount - 1)];
+    const std::vector<ReplicatedEntity>& from = receiver.received[a.sequence % REPLICATION_BASELINES].entities;
+    const std::vector<ReplicatedEntity>& to = receiver.received[b.sequence % REPLICATION_BASELINES].entities;
+    view.isGameOver = true; // Until ship 0 turns up
+    glm::vec2 position;
+    float rotation;
+    if (a.sequence == b.sequence) {
+        // Past the newest (or before the oldest): moved on by velocity, within limits
+        const double ahead = std::min(std::max(playbackTick - static_cast<double>(a.tick), 0.0), static_cast<double>(SPECTATOR_MAX_EXTRAPOLATION_TICKS));
+        for (const ReplicatedEntity& e : from) {
+            extrapolateEntity(e, static_cast<float>(ahead) * SIM_DT, position, rotation);
+            addEntity(view, e, position, rotation);
+        }
+        return;
+    }
+
+    // Both lists are in id order: walk them together. An entity in only one of them is drawn for the
+    // half of the interval nearer that snapshot, moved there by its own velocity.
+    const float t = static_cast<float>((playbackTick - static_cast<double>(a.tick)) / static_cast<double>(b.tick - a.tick));
+    const float span = static_cast<float>(b.tick - a.tick) * SIM_DT;
+    size_t i = 0, j = 0;
+    while (i < from.size() || j < to.size()) {
+        if (j == to.size() || (i < from.size() && from[i].id < to[j].id)) {
+            if (t < 0.5f) {
+                extrapolateEntity(from[i], t * span, position, rotation);
+                addEntity(view, from[i], position, rotation);
+            }
+            ++i;
+        }
+        else if (i == from.size() || to[j].id < from[i].id) {
+            if (t >= 0.5f) {
+                extrapolateEntity(to[j], (t - 1.0f) * span, position, rotation);
+                addEntity(view, to[j], position, rotation);
+            }
+            ++j;
+        }
+        else {
+            const ReplicatedEntity& shown = blendEntity(from[i], to[j], t, position, rotation);
+            addEntity(view, shown, position, rotation);
+            ++i;
+            ++j;
+        }
+    }
+}
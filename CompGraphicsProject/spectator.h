@@ -0,0 +1,36 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include "server.h"
+#include "simthread.h"
+
+// ============================ SPECTATOR ============================
+// --spectate HOST:PORT MATCH: the game as a viewer of a match on a match server (server.h) or on a
+// relay (relay.h), with nothing simulated locally. The snapshots it is sent (replication.h) are
+// decoded and acknowledged as they arrive; the last SPECTATOR_HISTORY of them are kept by tick, and
+// the view is drawn SPECTATOR_DELAY_TICKS behind the newest, interpolated between the two snapshots
+// around the playback tick (through the wrap edges; rotations the short way). With nothing newer in
+// yet, the newest is extrapolated by its velocities for up to SPECTATOR_MAX_EXTRAPOLATION_TICKS.
+// The playback clock runs on the frame clock and is steered towards its target a little every frame,
+// so jitter in the arrivals never shows; it jumps when it is far off (a stall, a new game).
+// Each frame's entities are written straight into the render snapshot's stores, the same ones the
+// simulation fills, so every renderer draws a spectated match unchanged. A spectator has no effects
+// (they are not replicated), and the GPU-resident rocks and bullets are off in this mode: both keep
+// their records by handle, and a spectator's stores are refilled every frame.
+const int SPECTATOR_HISTORY = 8; // Snapshots kept for interpolation (well under REPLICATION_BASELINES)
+const int SPECTATOR_DELAY_TICKS = 2 * SERVER_SNAPSHOT_TICKS; // A lost snapshot still leaves one to interpolate towards
+const int SPECTATOR_MAX_EXTRAPOLATION_TICKS = 30; // Past the newest snapshot, the view stops here and waits
+const float SPECTATOR_SNAP_TICKS = 60.0f; // Further off its target than this, the playback clock jumps
+const float SPECTATOR_STEER_RATE = 2.0f; // Share of the playback clock's error taken out per second
+const int SPECTATOR_JOIN_RETRY_MS = 1000;
+
+// Opens a socket and starts joining `match` (0: a relay's only match) at "HOST:PORT" (default port
+// 27960); false if the address does not resolve or no socket can be opened
+bool startSpectator(const char* hostAndPort, uint32_t match);
+void stopSpectator(); // Leaves the match (safe to call without one)
+bool spectatorActive();
+// Takes in every datagram that arrived, then fills `view` with the match as of the playback tick
+// for the frame starting at `now`, to be drawn as it stands (alpha 1)
+void updateSpectatorView(RenderSnapshot& view, std::chrono::steady_clock::time_point now);
@@ -0,0 +1,140 @@
+#include "streambuffer.h"
+#include "deletionqueue.h"
+#include "gldebug.h"
+#include "glstate.h"
+#include "log.h"
+
+#include <algorithm>
+#include <cstring>
+
+StreamBuffer streamBuffer;
+
+void StreamBuffer::init(size_t bytesPerFrame) {
+    segmentSize = bytesPerFrame;
+    segment = 0;
+    cursor = 0;
+    overflowed = false;
+    ++generation;
+    const size_t totalSize = segmentSize * STREAM_BUFFER_FRAMES;
+
+    if (useDirectStateAccess) {
+        // GL 4.5 includes buffer storage
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glCreateBuffers(1, &vbo);
+        glNamedBufferStorage(vbo, static_cast<GLsizeiptr>(totalSize), NULL, flags);
+        persistentData = static_cast<unsigned char*>(glMapNamedBufferRange(vbo, 0, static_cast<GLsizeiptr>(totalSize), flags));
+        labelGlObject(GL_BUFFER, vbo, "stream buffer");
+        return;
+    }
+
+    glGenBuffers(1, &vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    if (GLAD_GL_VERSION_4_4 && glBufferStorage) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(totalSize), NULL, flags);
+        persistentData = static_cast<unsigned char*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(totalSize), flags));
+    }
+    else {
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(totalSize), NULL, GL_STREAM_DRAW);
+        persistentData = nullptr;
+    }
+    labelGlObject(GL_BUFFER, vbo, "stream buffer");
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void StreamBuffer::destroy() {
+    for (int i = 0; i < STREAM_BUFFER_FRAMES; ++i) {
+        if (fences[i]) glDeleteSync(fences[i]);
+        fences[i] = 0;
+    }
+    if (persistentData && useDirectStateAccess) glUnmapNamedBuffer(vbo);
+    else if (persistentData) {
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    persistentData = nullptr;
+    glDeleteBuffers(1, &vbo);
+    vbo = 0;
+}
+
+void StreamBuffer::reserve(size_t bytesPerFrame) {
+    reservedSize = std::max(reservedSize, bytesPerFrame);
+}
+
+void StreamBuffer::beginFrame() {
+    if (overflowed || reservedSize > segmentSize) {
+        // Re-create at twice the size after an overflow, or at the reserved size. Frames in flight may
+        // still be drawing from the old buffer, so it is retired rather than deleted (deleting it also
+        // drops its persistent mapping); the frame fence that releases it covers the old segment fences too.
+        size_t newSize = std::max(overflowed ? segmentSize * 2 : segmentSize, reservedSize);
+        if (overflowed) LOG_WARN("Stream buffer full, growing to %zu KB per frame", newSize / 1024);
+        else LOG_INFO("Stream buffer growing to %zu KB per frame for the new framebuffer size", newSize / 1024);
+        for (int i = 0; i < STREAM_BUFFER_FRAMES; ++i) {
+            if (fences[i]) glDeleteSync(fences[i]);
+            fences[i] = 0;
+        }
+        deletionQueue.retire(RETIRED_BUFFER, vbo);
+        persistentData = nullptr;
+        vbo = 0;
+        init(newSize);
+    }
+
+    if (fences[segment]) {
+        // Three frames old, so normally already signalled; the flush bit avoids waiting on an unflushed fence
+        while (glClientWaitSync(fences[segment], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED) {}
+        glDeleteSync(fences[segment]);
+        fences[segment] = 0;
+    }
+    cursor = 0;
+}
+
+void* StreamBuffer::allocate(size_t bytes, size_t alignment, size_t& offset) {
+    const size_t segmentStart = static_cast<size_t>(segment) * segmentSize;
+    offset = segmentStart + cursor;
+    offset = (offset + alignment - 1) / alignment * alignment;
+    if (offset + bytes > segmentStart + segmentSize) {
+        overflowed = true;
+        return nullptr;
+    }
+    cursor = offset + bytes - segmentStart;
+    bytesWritten += bytes;
+
+    const GLbitfield mapFlags = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+    void* target = nullptr;
+    if (useDirectStateAccess) {
+        if (persistentData) return persistentData + offset;
+        target = glMapNamedBufferRange(vbo, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(bytes), mapFlags);
+    }
+    else {
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        if (persistentData) return persistentData + offset;
+        target = glMapBufferRange(GL_ARRAY_BUFFER, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(bytes), mapFlags);
+    }
+    rangeMapped = target != nullptr;
+    return target;
+}
+
+void StreamBuffer::commit() {
+    if (!rangeMapped) return;
+    if (useDirectStateAccess) glUnmapNamedBuffer(vbo);
+    else {
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+    }
+    rangeMapped = false;
+}
+
+size_t StreamBuffer::write(const void* data, size_t bytes, size_t alignment) {
+    size_t offset = 0;
+    void* target = allocate(bytes, alignment, offset);
+    if (!target) return STREAM_WRITE_FAILED;
+    std::memcpy(target, data, bytes);
+    commit();
+    return offset;
+}
+
+void StreamBuffer::endFrame() {
+    fences[segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    segment = (segment + 1) % STREAM_BUFFER_FRAMES;
+}
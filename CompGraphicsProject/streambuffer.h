@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+
+#include <glad/glad.h>
+
+// ============================ STREAMING VERTEX BUFFER ============================
+// One GL buffer split into STREAM_BUFFER_FRAMES segments. Every frame writes all of its dynamic
+// geometry (ship outline, shield, bullets, asteroid instances) into the next segment, and a fence
+// per segment keeps the CPU from overwriting data the GPU may still be reading.
+// With GL 4.4 the buffer is created with glBufferStorage and stays persistently mapped; otherwise
+// each write maps its range with GL_MAP_UNSYNCHRONIZED_BIT, which is safe because of the fences.
+// With useDirectStateAccess it is created and mapped by name and nothing here binds it.
+const int STREAM_BUFFER_FRAMES = 3;
+const size_t STREAM_WRITE_FAILED = static_cast<size_t>(-1);
+
+struct StreamBuffer {
+    unsigned int vbo = 0;
+    size_t segmentSize = 0; // Bytes available to one frame
+    int segment = 0; // Segment the current frame writes into
+    size_t cursor = 0; // Next free byte within the current segment
+    unsigned char* persistentData = nullptr; // Whole-buffer mapping (persistent path only)
+    GLsync fences[STREAM_BUFFER_FRAMES] = {};
+    bool overflowed = false; // A write did not fit this frame; the buffer grows at the next beginFrame
+    size_t reservedSize = 0; // Smallest segment the next beginFrame must provide (see reserve)
+    bool rangeMapped = false; // allocate() mapped a range that commit() has not unmapped yet
+    unsigned long long bytesWritten = 0; // Every byte uploaded since startup (benchmark statistics)
+    unsigned int generation = 0; // Bumped whenever init creates vbo, so views of it know to re-attach
+
+    void init(size_t bytesPerFrame);
+    void destroy();
+    // Makes the next beginFrame grow the segments to at least `bytesPerFrame` (after a resize raises
+    // the worst case), so the frame that needs the room does not overflow and drop its geometry first
+    void reserve(size_t bytesPerFrame);
+    // Waits (normally not at all) until the GPU is done with the segment this frame reuses
+    void beginFrame();
+    // Copies data into this frame's segment, aligned to `alignment` bytes, and returns its byte offset
+    // in the buffer (used as the attribute offset or first vertex). Without DSA it leaves vbo bound to
+    // GL_ARRAY_BUFFER. Returns STREAM_WRITE_FAILED when the segment is full.
+    size_t write(const void* data, size_t bytes, size_t alignment);
+    // Reserves `bytes` the same way and returns a pointer to write them through, so producers can fill
+    // the buffer in place: the persistent mapping, or a range mapped until commit(). Sets `offset` as
+    // write() returns it. Returns nullptr when the segment is full. Call commit() before drawing.
+    void* allocate(size_t bytes, size_t alignment, size_t& offset);
+    void commit(); // Unmaps the range allocate() mapped (nothing to do on the persistent path)
+    // Fences the segment written this frame and moves on to the next one
+    void endFrame();
+};
+
+extern StreamBuffer streamBuffer;
@@ -0,0 +1,630 @@
+#include "swarm.h"
+#include "frameconstants.h"
+#include "glstate.h"
+#include "random.h"
+#include "shaders.h"
+#include "simulation.h"
+#include "log.h"
+#include "memreport.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/packing.hpp>
+
+bool useGpuSwarm = false;
+
+// ============================ GPU SWARM DATA ============================
+const unsigned int SWARM_STORAGE_BINDING = 0;
+const unsigned int SWARM_GROUP_SIZE = 256; // local_size_x of the per-rock and per-bullet shaders
+// Storage bindings of the collision passes (the rocks stay at SWARM_STORAGE_BINDING)
+enum SwarmGridBinding {
+    SWARM_CELL_COUNT_BINDING = 1,
+    SWARM_CELL_START_BINDING,
+    SWARM_CELL_CURSOR_BINDING,
+    SWARM_CELL_ROCKS_BINDING,
+    SWARM_BULLETS_BINDING,
+    SWARM_HITS_BINDING,
+    SWARM_COMMANDS_BINDING,
+    SWARM_VISIBLE_BINDING
+};
+const unsigned int SWARM_MAX_HITS = 4096; // Hit records kept per frame; later hits are counted but dropped
+const int SWARM_READBACK_FRAMES = 3;
+
+// Mirrors SwarmRock in the shaders (std430: 8 floats, no padding)
+struct SwarmRock {
+    glm::vec2 position;
+    glm::vec2 velocity;
+    float rotation;
+    float rotationSpeed;
+    float scale;
+    uint32_t color; // RGBA8, unpackUnorm4x8 in the vertex shader
+};
+static_assert(sizeof(SwarmRock) == 32, "SwarmRock must match the std430 struct");
+
+#define SWARM_ROCK_GLSL \
+    "struct SwarmRock {\n" \
+    "    vec2 position;\n" \
+    "    vec2 velocity;\n" \
+    "    float rotation;\n" \
+    "    float rotationSpeed;\n" \
+    "    float scale;\n" \
+    "    uint color;\n" \
+    "};\n"
+
+// A rock is alive while its color's alpha byte is set; a bullet hit clears it with one atomicAnd
+#define SWARM_CELL_GLSL \
+    "uniform int gridSize;\n" \
+    "ivec2 cellCoord(vec2 p) { return clamp(ivec2((p + 1.0) * 0.5 * float(gridSize)), 0, gridSize - 1); }\n" \
+    "bool rockAlive(uint color) { return (color >> 24) != 0u; }\n"
+
+static unsigned int swarmBuffer;
+static unsigned int stepProgram, drawProgram;
+static int dtLoc, rockCountLoc, colorScaleLoc;
+static size_t swarmCount = 0;
+
+// Collision grid: gridSize x gridSize cells over the field, each at least one rock radius wide
+static unsigned int countProgram, scanProgram, scatterProgram, hitProgram;
+static unsigned int cellCountBuffer, cellStartBuffer, cellCursorBuffer, cellRocksBuffer, bulletBuffer, hitBuffer;
+static int gridSize = 3;
+static int countRockCountLoc, countGridSizeLoc, scanCellTotalLoc, scatterRockCountLoc, scatterGridSizeLoc;
+static int hitBulletCountLoc, hitGridSizeLoc, hitRadiusPerScaleLoc, hitMaxHitsLoc;
+static size_t bulletCapacity = 0; // Positions bulletBuffer holds
+static std::vector<glm::vec2> bulletScratch;
+// Readback ring: each collided frame copies the hit buffer into the next slot and fences it
+static unsigned int readbackBuffers[SWARM_READBACK_FRAMES];
+static GLsync readbackFences[SWARM_READBACK_FRAMES];
+static int readbackNext = 0; // Slot the next collided frame copies into
+static std::vector<SwarmHit> collectedHits;
+// Rocks are generated sorted by shape, so shape k is the rock range [shapeStart[k], shapeStart[k + 1]).
+// Its visible rocks are compacted into the same range of visibleBuffer.
+static size_t shapeStart[ASTEROID_SHAPE_COUNT + 1];
+
+// Culling: one fill and one outline command per shape (fills first), instance counts from the cull pass
+struct SwarmDrawCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint first;
+    GLuint baseInstance;
+};
+static unsigned int cullProgram, commandBuffer, visibleBuffer, swarmVAO;
+static int cullRockCountLoc, cullShapeStartLoc;
+static SwarmDrawCommand drawCommands[2 * ASTEROID_SHAPE_COUNT];
+static_assert(ASTEROID_SHAPE_COUNT == 32, "The cull shader's SHAPES must match ASTEROID_SHAPE_COUNT");
+
+// ============================ SHADERS ============================
+static const char* stepComputeSource = R"(
+    #version 430 core
+    layout (local_size_x = 256) in;
+)" SWARM_ROCK_GLSL R"(
+    layout (std430, binding = 0) buffer SwarmRocks { SwarmRock rocks[]; };
+    uniform float dt;
+    uniform uint rockCount;
+
+    void main()
+    {
+        uint i = gl_GlobalInvocationID.x;
+        if (i >= rockCount) return;
+        // Same toroidal wrap as the CPU store: the field is [-1, 1) on both axes
+        vec2 p = rocks[i].position + rocks[i].velocity * dt;
+        rocks[i].position = p - 2.0 * floor((p + 1.0) * 0.5);
+        rocks[i].rotation = mod(rocks[i].rotation + rocks[i].rotationSpeed * dt, 6.28318530718);
+    }
+)";
+
+// Pass 1: count the live rocks per cell
+static const char* countComputeSource = R"(
+    #version 430 core
+    layout (local_size_x = 256) in;
+)" SWARM_ROCK_GLSL SWARM_CELL_GLSL R"(
+    layout (std430, binding = 0) readonly buffer SwarmRocks { SwarmRock rocks[]; };
+    layout (std430, binding = 1) buffer CellCounts { uint cellCount[]; };
+    uniform uint rockCount;
+
+    void main()
+    {
+        uint i = gl_GlobalInvocationID.x;
+        if (i >= rockCount || !rockAlive(rocks[i].color)) return;
+        ivec2 c = cellCoord(rocks[i].position);
+        atomicAdd(cellCount[c.y * gridSize + c.x], 1u);
+    }
+)";
+
+// Pass 2: exclusive prefix sum of the counts in one work group. Each thread sums a run of cells,
+// the run totals are scanned in shared memory, then each thread writes its run's starts.
+static const char* scanComputeSource = R"(
+    #version 430 core
+    layout (local_size_x = 1024) in;
+    layout (std430, binding = 1) readonly buffer CellCounts { uint cellCount[]; };
+    layout (std430, binding = 2) writeonly buffer CellStarts { uint cellStart[]; };
+    layout (std430, binding = 3) writeonly buffer CellCursors { uint cellCursor[]; };
+    uniform uint cellTotal;
+    shared uint partial[1024];
+
+    void main()
+    {
+        uint t = gl_LocalInvocationID.x;
+        uint run = (cellTotal + 1023u) / 1024u;
+        uint begin = min(t * run, cellTotal);
+        uint end = min(begin + run, cellTotal);
+        uint sum = 0u;
+        for (uint c = begin; c < end; ++c) sum += cellCount[c];
+        partial[t] = sum;
+        barrier();
+        for (uint offset = 1u; offset < 1024u; offset <<= 1) {
+            uint add = t >= offset ? partial[t - offset] : 0u;
+            barrier();
+            partial[t] += add;
+            barrier();
+        }
+        uint start = partial[t] - sum;
+        for (uint c = begin; c < end; ++c) {
+            cellStart[c] = start;
+            cellCursor[c] = start;
+            start += cellCount[c];
+        }
+    }
+)";
+
+// Pass 3: scatter the live rocks into their cells' ranges
+static const char* scatterComputeSource = R"(
+    #version 430 core
+    layout (local_size_x = 256) in;
+)" SWARM_ROCK_GLSL SWARM_CELL_GLSL R"(
+    layout (std430, binding = 0) readonly buffer SwarmRocks { SwarmRock rocks[]; };
+    layout (std430, binding = 3) buffer CellCursors { uint cellCursor[]; };
+    layout (std430, binding = 4) writeonly buffer CellRocks { uint cellRocks[]; };
+    uniform uint rockCount;
+
+    void main()
+    {
+        uint i = gl_GlobalInvocationID.x;
+        if (i >= rockCount || !rockAlive(rocks[i].color)) return;
+        ivec2 c = cellCoord(rocks[i].position);
+        cellRocks[atomicAdd(cellCursor[c.y * gridSize + c.x], 1u)] = i;
+    }
+)";
+
+// Pass 4: one thread per bullet walks its 3x3 cells (wrapping at the edges). The first bullet to
+// clear a rock's alive bit owns the hit and appends a record.
+static const char* hitComputeSource = R"(
+    #version 430 core
+    layout (local_size_x = 256) in;
+)" SWARM_ROCK_GLSL SWARM_CELL_GLSL R"(
+    layout (std430, binding = 0) buffer SwarmRocks { SwarmRock rocks[]; };
+    layout (std430, binding = 1) readonly buffer CellCounts { uint cellCount[]; };
+    layout (std430, binding = 2) readonly buffer CellStarts { uint cellStart[]; };
+    layout (std430, binding = 4) readonly buffer CellRocks { uint cellRocks[]; };
+    layout (std430, binding = 5) readonly buffer Bullets { vec2 bullets[]; };
+    layout (std430, binding = 6) buffer Hits { uint hitCount; uvec2 hitRecords[]; };
+    uniform uint bulletCount;
+    uniform float radiusPerScale; // Collision radius of a rock per unit of its draw scale
+    uniform uint maxHits;
+
+    void main()
+    {
+        uint b = gl_GlobalInvocationID.x;
+        if (b >= bulletCount) return;
+        vec2 p = bullets[b] - 2.0 * floor((bullets[b] + 1.0) * 0.5);
+        ivec2 home = cellCoord(p);
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                ivec2 n = (home + ivec2(dx, dy) + gridSize) % gridSize;
+                uint cell = uint(n.y * gridSize + n.x);
+                uint begin = cellStart[cell];
+                for (uint k = begin; k < begin + cellCount[cell]; ++k) {
+                    uint r = cellRocks[k];
+                    vec2 d = rocks[r].position - p;
+                    d -= 2.0 * round(d * 0.5); // Nearest image across the wrap
+                    float radius = rocks[r].scale * radiusPerScale;
+                    if (dot(d, d) >= radius * radius) continue;
+                    if (!rockAlive(atomicAnd(rocks[r].color, 0x00FFFFFFu))) continue; // Another bullet got it
+                    uint slot = atomicAdd(hitCount, 1u);
+                    if (slot < maxHits) hitRecords[slot] = uvec2(b, r);
+                    return;
+                }
+            }
+        }
+    }
+)";
+
+// Culling: each work group tallies its visible rocks per shape in shared memory, reserves room for
+// them with one atomicAdd per shape on the fill command (and the same add on the outline command),
+// then writes their indices. ASTEROID_SHAPE_COUNT is 32.
+static const char* cullComputeSource = R"(
+    #version 430 core
+    layout (local_size_x = 256) in;
+)" SWARM_ROCK_GLSL R"(
+    const uint SHAPES = 32u;
+    struct DrawCommand {
+        uint count;
+        uint instanceCount;
+        uint first;
+        uint baseInstance;
+    };
+    layout (std430, binding = 0) readonly buffer SwarmRocks { SwarmRock rocks[]; };
+    layout (std430, binding = 7) buffer Commands { DrawCommand commands[]; };
+    layout (std430, binding = 8) writeonly buffer Visible { uint visible[]; };
+    uniform uint rockCount;
+    uniform uint shapeStart[SHAPES + 1u];
+    shared uint groupCount[SHAPES];
+    shared uint groupBase[SHAPES];
+
+    // Same test as the game's rocks: the bounding circle at the outermost outline radius meets the view
+    bool onScreen(SwarmRock rock)
+    {
+        float reach = 1.0 + 1.2 * rock.scale;
+        return all(lessThanEqual(abs(rock.position), vec2(reach)));
+    }
+
+    void main()
+    {
+        uint t = gl_LocalInvocationID.x;
+        if (t < SHAPES) groupCount[t] = 0u;
+        barrier();
+
+        uint i = gl_GlobalInvocationID.x;
+        bool drawn = false;
+        uint shape = 0u, local = 0u;
+        if (i < rockCount && (rocks[i].color >> 24) != 0u && onScreen(rocks[i])) {
+            drawn = true;
+            uint lo = 0u, hi = SHAPES; // Last shape whose range starts at or before i
+            while (hi - lo > 1u) {
+                uint mid = (lo + hi) / 2u;
+                if (shapeStart[mid] <= i) lo = mid; else hi = mid;
+            }
+            shape = lo;
+            local = atomicAdd(groupCount[shape], 1u);
+        }
+        barrier();
+        if (t < SHAPES && groupCount[t] > 0u) {
+            groupBase[t] = atomicAdd(commands[t].instanceCount, groupCount[t]);
+            atomicAdd(commands[SHAPES + t].instanceCount, groupCount[t]);
+        }
+        barrier();
+        if (drawn) visible[shapeStart[shape] + groupBase[shape] + local] = i;
+    }
+)";
+
+// The instance attribute is the rock's index, fetched from the compacted visible list at baseInstance
+static const char* drawVertexSource = R"(
+    #version 430 core
+    layout (location = 0) in vec2 aPos;
+    layout (location = 1) in uint iRock;
+)" SWARM_ROCK_GLSL R"(
+    layout (std430, binding = 0) readonly buffer SwarmRocks { SwarmRock rocks[]; };
+    uniform float colorScale; // 0.5 for fills, 1.5 for outlines, like the game's rocks
+
+    out vec3 vertexColor;
+
+    void main()
+    {
+        SwarmRock rock = rocks[iRock];
+        float c = cos(rock.rotation);
+        float s = sin(rock.rotation);
+        vec2 world = mat2(c, s, -s, c) * (aPos * rock.scale) + rock.position;
+        vertexColor = clamp(unpackUnorm4x8(rock.color).rgb * colorScale, 0.0, 1.0);
+        gl_Position = vec4(world, 0.0, 1.0);
+    }
+)";
+
+static const char* drawFragmentSource = R"(
+    #version 430 core
+)" FRAME_CONSTANTS_GLSL R"(
+    in vec3 vertexColor;
+    out vec4 FragColor;
+
+    void main()
+    {
+        FragColor = vec4(vertexColor, 1.0f) * tint;
+    }
+)";
+
+// ============================ SETUP ============================
+bool setupGpuSwarm(size_t count, uint64_t seed, unsigned int atlasVBO)
+{
+    if (!GLAD_GL_VERSION_4_3 || !glDispatchCompute) return false;
+    stepProgram = buildComputeProgram("swarm step", stepComputeSource);
+    drawProgram = buildProgram("swarm draw", drawVertexSource, drawFragmentSource);
+    countProgram = buildComputeProgram("swarm count", countComputeSource);
+    scanProgram = buildComputeProgram("swarm scan", scanComputeSource);
+    scatterProgram = buildComputeProgram("swarm scatter", scatterComputeSource);
+    hitProgram = buildComputeProgram("swarm hits", hitComputeSource);
+    cullProgram = buildComputeProgram("swarm cull", cullComputeSource);
+    if (!stepProgram || !drawProgram || !countProgram || !scanProgram || !scatterProgram || !hitProgram || !cullProgram) {
+        destroyGpuSwarm();
+        return false;
+    }
+    bindFrameConstants(drawProgram);
+    dtLoc = glGetUniformLocation(stepProgram, "dt");
+    rockCountLoc = glGetUniformLocation(stepProgram, "rockCount");
+    colorScaleLoc = glGetUniformLocation(drawProgram, "colorScale");
+    countRockCountLoc = glGetUniformLocation(countProgram, "rockCount");
+    countGridSizeLoc = glGetUniformLocation(countProgram, "gridSize");
+    scanCellTotalLoc = glGetUniformLocation(scanProgram, "cellTotal");
+    scatterRockCountLoc = glGetUniformLocation(scatterProgram, "rockCount");
+    scatterGridSizeLoc = glGetUniformLocation(scatterProgram, "gridSize");
+    hitBulletCountLoc = glGetUniformLocation(hitProgram, "bulletCount");
+    hitGridSizeLoc = glGetUniformLocation(hitProgram, "gridSize");
+    hitRadiusPerScaleLoc = glGetUniformLocation(hitProgram, "radiusPerScale");
+    hitMaxHitsLoc = glGetUniformLocation(hitProgram, "maxHits");
+    cullRockCountLoc = glGetUniformLocation(cullProgram, "rockCount");
+    cullShapeStartLoc = glGetUniformLocation(cullProgram, "shapeStart");
+
+    // Same palette and speeds as spawned rocks, a little smaller than SMALL ones
+    Rng rng;
+    rng.seed(seed, RNG_STREAM_SWARM);
+    std::vector<SwarmRock> rocks(count);
+    for (size_t i = 0; i < count; ++i) {
+        SwarmRock& rock = rocks[i];
+        float angle = rng.uniform() * 2.0f * glm::pi<float>();
+        rock.position = glm::vec2(rng.range(-1.0f, 1.0f), rng.range(-1.0f, 1.0f));
+        rock.velocity = glm::vec2(cos(angle), sin(angle)) * rng.range(0.05f, 0.3f);
+        rock.rotation = rng.uniform() * 2.0f * glm::pi<float>();
+        rock.rotationSpeed = rng.range(-0.8f, 0.8f);
+        rock.scale = getScaleFactor(SMALL) * rng.range(0.3f, 1.0f);
+        rock.color = glm::packUnorm4x8(glm::vec4(asteroidPalette[rng.below(ASTEROID_PALETTE_SIZE)], 1.0f));
+    }
+    for (int k = 0; k <= ASTEROID_SHAPE_COUNT; ++k) shapeStart[k] = count * static_cast<size_t>(k) / ASTEROID_SHAPE_COUNT;
+
+    glGenBuffers(1, &swarmBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, swarmBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(count * sizeof(SwarmRock)), rocks.data(), GL_DYNAMIC_COPY);
+
+    // Cells no narrower than the largest rock radius, so a bullet's 3x3 cells hold every rock it can touch
+    const float maxRadius = getRadiusFactor(SMALL);
+    gridSize = std::min(256, std::max(3, static_cast<int>(2.0f / maxRadius)));
+    const GLsizeiptr cellBytes = static_cast<GLsizeiptr>(gridSize) * gridSize * sizeof(GLuint);
+    glGenBuffers(1, &cellCountBuffer);
+    glGenBuffers(1, &cellStartBuffer);
+    glGenBuffers(1, &cellCursorBuffer);
+    glGenBuffers(1, &cellRocksBuffer);
+    glGenBuffers(1, &bulletBuffer);
+    glGenBuffers(1, &hitBuffer);
+    for (unsigned int buffer : { cellCountBuffer, cellStartBuffer, cellCursorBuffer }) {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, cellBytes, NULL, GL_DYNAMIC_COPY);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, cellRocksBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(count * sizeof(GLuint)), NULL, GL_DYNAMIC_COPY);
+    const GLsizeiptr hitBytes = sizeof(GLuint) * 2 + SWARM_MAX_HITS * sizeof(SwarmHit); // Count padded to uvec2 alignment
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, hitBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, hitBytes, NULL, GL_DYNAMIC_COPY);
+    glGenBuffers(SWARM_READBACK_FRAMES, readbackBuffers);
+    for (unsigned int buffer : readbackBuffers) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, hitBytes, NULL, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    collectedHits.reserve(SWARM_MAX_HITS);
+
+    // Culling output, and a VAO that reads shape vertices from the atlas and rock indices from it
+    glGenBuffers(1, &commandBuffer);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(drawCommands), NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    glGenBuffers(1, &visibleBuffer);
+    glGenVertexArrays(1, &swarmVAO);
+    glBindVertexArray(swarmVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, atlasVBO);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, visibleBuffer);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(count * sizeof(GLuint)), NULL, GL_DYNAMIC_COPY);
+    glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(GLuint), (void*)0);
+    glVertexAttribDivisor(1, 1);
+    glEnableVertexAttribArray(1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    swarmCount = count;
+    useGpuSwarm = true;
+    LOG_INFO("GPU swarm: %zu rocks (%zu KB on the GPU)", count, count * sizeof(SwarmRock) / 1024);
+    return true;
+}
+
+void destroyGpuSwarm()
+{
+    for (unsigned int* buffer : { &swarmBuffer, &cellCountBuffer, &cellStartBuffer, &cellCursorBuffer, &cellRocksBuffer, &bulletBuffer, &hitBuffer,
+                                  &commandBuffer, &visibleBuffer }) {
+        if (*buffer) glDeleteBuffers(1, buffer);
+        *buffer = 0;
+    }
+    for (int i = 0; i < SWARM_READBACK_FRAMES; ++i) {
+        if (readbackFences[i]) glDeleteSync(readbackFences[i]);
+        if (readbackBuffers[i]) glDeleteBuffers(1, &readbackBuffers[i]);
+        readbackFences[i] = 0;
+        readbackBuffers[i] = 0;
+    }
+    for (unsigned int* program : { &stepProgram, &drawProgram, &countProgram, &scanProgram, &scatterProgram, &hitProgram, &cullProgram }) {
+        if (*program) glDeleteProgram(*program);
+        *program = 0;
+    }
+    if (swarmVAO) glDeleteVertexArrays(1, &swarmVAO);
+    swarmVAO = 0;
+    bulletCapacity = 0;
+    swarmCount = 0;
+    useGpuSwarm = false;
+}
+
+void collectGpuSwarmMemory(MemoryReport& report)
+{
+    if (swarmCount == 0) return;
+    report.add("gpu swarm", "rocks", MEMORY_GPU, glBufferBytes(swarmBuffer));
+    report.add("gpu swarm", "collision grid", MEMORY_GPU,
+               glBufferBytes(cellCountBuffer) + glBufferBytes(cellStartBuffer) + glBufferBytes(cellCursorBuffer) + glBufferBytes(cellRocksBuffer));
+    size_t hitBytes = glBufferBytes(bulletBuffer) + glBufferBytes(hitBuffer);
+    for (unsigned int buffer : readbackBuffers) hitBytes += glBufferBytes(buffer);
+    report.add("gpu swarm", "bullets and hits", MEMORY_GPU, hitBytes);
+    report.add("gpu swarm", "cull output", MEMORY_GPU, glBufferBytes(commandBuffer) + glBufferBytes(visibleBuffer));
+    report.add("gpu swarm", "bullet and hit scratch", MEMORY_CPU,
+               bulletScratch.capacity() * sizeof(glm::vec2) + collectedHits.capacity() * sizeof(SwarmHit));
+}
+
+size_t gpuSwarmCount()
+{
+    return swarmCount;
+}
+
+// ============================ STEP AND DRAW ============================
+void stepGpuSwarm(float dt)
+{
+    if (swarmCount == 0) return;
+    glState.useProgram(stepProgram);
+    glUniform1f(dtLoc, dt);
+    glUniform1ui(rockCountLoc, static_cast<GLuint>(swarmCount));
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SWARM_STORAGE_BINDING, swarmBuffer);
+    glDispatchCompute(static_cast<GLuint>((swarmCount + SWARM_GROUP_SIZE - 1) / SWARM_GROUP_SIZE), 1, 1);
+    // The draw reads the positions through the same storage block
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+// Dispatches one thread per rock of the bound program
+static void dispatchPerRock()
+{
+    glDispatchCompute(static_cast<GLuint>((swarmCount + SWARM_GROUP_SIZE - 1) / SWARM_GROUP_SIZE), 1, 1);
+}
+
+void collideGpuSwarm(const BulletStore& bullets)
+{
+    if (swarmCount == 0) return;
+    bulletScratch.clear();
+    for (size_t j = 0; j < bullets.capacity(); ++j) {
+        if (bullets.live(j)) bulletScratch.push_back(bullets.position(j));
+    }
+
+    const GLuint cellTotal = static_cast<GLuint>(gridSize * gridSize);
+    const GLuint zero = 0;
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SWARM_STORAGE_BINDING, swarmBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SWARM_CELL_COUNT_BINDING, cellCountBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SWARM_CELL_START_BINDING, cellStartBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SWARM_CELL_CURSOR_BINDING, cellCursorBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SWARM_CELL_ROCKS_BINDING, cellRocksBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SWARM_HITS_BINDING, hitBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, cellCountBuffer);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, hitBuffer);
+    glClearBufferSubData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, 0, sizeof(GLuint), GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+
+    glState.useProgram(countProgram);
+    glUniform1ui(countRockCountLoc, static_cast<GLuint>(swarmCount));
+    glUniform1i(countGridSizeLoc, gridSize);
+    dispatchPerRock();
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    glState.useProgram(scanProgram);
+    glUniform1ui(scanCellTotalLoc, cellTotal);
+    glDispatchCompute(1, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    glState.useProgram(scatterProgram);
+    glUniform1ui(scatterRockCountLoc, static_cast<GLuint>(swarmCount));
+    glUniform1i(scatterGridSizeLoc, gridSize);
+    dispatchPerRock();
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    if (!bulletScratch.empty()) {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, bulletBuffer);
+        if (bulletScratch.size() > bulletCapacity) {
+            bulletCapacity = std::max(bulletScratch.size(), bulletCapacity * 2);
+            glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(bulletCapacity * sizeof(glm::vec2)), NULL, GL_STREAM_DRAW);
+        }
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, static_cast<GLsizeiptr>(bulletScratch.size() * sizeof(glm::vec2)), bulletScratch.data());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SWARM_BULLETS_BINDING, bulletBuffer);
+
+        glState.useProgram(hitProgram);
+        glUniform1ui(hitBulletCountLoc, static_cast<GLuint>(bulletScratch.size()));
+        glUniform1i(hitGridSizeLoc, gridSize);
+        glUniform1f(hitRadiusPerScaleLoc, getRadiusFactor(SMALL) / getScaleFactor(SMALL));
+        glUniform1ui(hitMaxHitsLoc, SWARM_MAX_HITS);
+        glDispatchCompute(static_cast<GLuint>((bulletScratch.size() + SWARM_GROUP_SIZE - 1) / SWARM_GROUP_SIZE), 1, 1);
+    }
+    // The draw reads the alive bits, the copy reads the records
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    // Queue this frame's records for readback; a slot still in flight (three frames behind) is dropped
+    const int slot = readbackNext;
+    readbackNext = (readbackNext + 1) % SWARM_READBACK_FRAMES;
+    if (readbackFences[slot]) glDeleteSync(readbackFences[slot]);
+    glBindBuffer(GL_COPY_READ_BUFFER, hitBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, readbackBuffers[slot]);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, sizeof(GLuint) * 2 + SWARM_MAX_HITS * sizeof(SwarmHit));
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    readbackFences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+const std::vector<SwarmHit>& collectGpuSwarmHits()
+{
+    collectedHits.clear();
+    // Oldest pending slot first: the one the next collide would overwrite
+    for (int k = 0; k < SWARM_READBACK_FRAMES; ++k) {
+        const int slot = (readbackNext + k) % SWARM_READBACK_FRAMES;
+        if (!readbackFences[slot]) continue;
+        GLenum state = glClientWaitSync(readbackFences[slot], 0, 0);
+        if (state != GL_ALREADY_SIGNALED && state != GL_CONDITION_SATISFIED) break;
+        glDeleteSync(readbackFences[slot]);
+        readbackFences[slot] = 0;
+
+        glBindBuffer(GL_COPY_READ_BUFFER, readbackBuffers[slot]);
+        const GLsizeiptr bytes = sizeof(GLuint) * 2 + SWARM_MAX_HITS * sizeof(SwarmHit);
+        if (const GLuint* data = static_cast<const GLuint*>(glMapBufferRange(GL_COPY_READ_BUFFER, 0, bytes, GL_MAP_READ_BIT))) {
+            const GLuint hits = std::min(data[0], SWARM_MAX_HITS);
+            const SwarmHit* records = reinterpret_cast<const SwarmHit*>(data + 2);
+            collectedHits.assign(records, records + hits);
+            glUnmapBuffer(GL_COPY_READ_BUFFER);
+        }
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        break;
+    }
+    return collectedHits;
+}
+
+void cullGpuSwarm(int lod)
+{
+    if (swarmCount == 0) return;
+
+    // Reset the commands for this frame's level of detail; the cull pass fills in the instance counts
+    GLuint starts[ASTEROID_SHAPE_COUNT + 1];
+    for (int k = 0; k < ASTEROID_SHAPE_COUNT; ++k) {
+        const AsteroidMesh& mesh = asteroidShapes[k].lods[lod];
+        const GLuint base = static_cast<GLuint>(shapeStart[k]);
+        drawCommands[k] = { static_cast<GLuint>(mesh.vertexCount), 0, static_cast<GLuint>(mesh.baseVertex), base };
+        // Outline skips the center point
+        drawCommands[ASTEROID_SHAPE_COUNT + k] = { static_cast<GLuint>(mesh.vertexCount - 1), 0, static_cast<GLuint>(mesh.baseVertex + 1), base };
+        starts[k] = base;
+    }
+    starts[ASTEROID_SHAPE_COUNT] = static_cast<GLuint>(swarmCount);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+    glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(drawCommands), drawCommands);
+
+    glState.useProgram(cullProgram);
+    glUniform1ui(cullRockCountLoc, static_cast<GLuint>(swarmCount));
+    glUniform1uiv(cullShapeStartLoc, ASTEROID_SHAPE_COUNT + 1, starts);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SWARM_STORAGE_BINDING, swarmBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SWARM_COMMANDS_BINDING, commandBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SWARM_VISIBLE_BINDING, visibleBuffer);
+    dispatchPerRock();
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+}
+
+int drawGpuSwarm()
+{
+    if (swarmCount == 0) return 0;
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+    glState.useProgram(drawProgram);
+    glState.bindVertexArray(swarmVAO);
+    glState.setLineWidth(1.0f);
+    glUniform1f(colorScaleLoc, 0.5f);
+    glMultiDrawArraysIndirect(GL_TRIANGLE_FAN, (void*)0, ASTEROID_SHAPE_COUNT, 0);
+    glUniform1f(colorScaleLoc, 1.5f);
+    glMultiDrawArraysIndirect(GL_LINE_LOOP, (void*)(ASTEROID_SHAPE_COUNT * sizeof(SwarmDrawCommand)), ASTEROID_SHAPE_COUNT, 0);
+    glState.bindVertexArray(0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    return 2;
+}
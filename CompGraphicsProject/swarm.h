@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct BulletStore;
+struct MemoryReport;
+
+// GPU asteroid swarm for showcase builds (--swarm N, needs GL 4.3 compute shaders). The rocks live
+// only on the GPU: their state is a shader storage buffer, a compute shader integrates and wraps
+// them every frame, and the instanced draw reads the same buffer through gl_InstanceID, so nothing
+// is uploaded or read back per frame. The swarm is scenery drawn behind the game; the CPU
+// simulation stays authoritative for the ship, bullets and the game's own asteroids.
+//
+// Bullets hit swarm rocks on the GPU too: compute passes bin the rocks into a uniform grid (atomic
+// counts, one prefix sum, scatter), test each bullet against its 3x3 cells and append a record per
+// hit, and the hit rock is switched off in place. The records are copied to a readback buffer and
+// read one frame later once its fence has signalled, so the CPU never waits on the GPU or reads any
+// rock data. The game's bullets fly on; swarm hits only feed the profiler counters.
+//
+// The CPU does not know which rocks are visible either: a compute pass tests every rock's bounding
+// circle against the view, compacts the visible ones' indices per shape and counts them straight
+// into the indirect draw commands, so drawing is two glMultiDrawArraysIndirect calls at any count.
+
+// ============================ GPU SWARM STATE ============================
+extern bool useGpuSwarm; // Step and draw the swarm (set up by setupGpuSwarm, toggle with W)
+
+// ============================ GPU SWARM API ============================
+// Creates the storage buffer and programs for `count` rocks drawn from `seed`; the shapes come from
+// the mesh atlas in `atlasVBO`. Returns false (and leaves useGpuSwarm off) when the context has no
+// compute shaders.
+bool setupGpuSwarm(size_t count, uint64_t seed, unsigned int atlasVBO);
+void destroyGpuSwarm();
+size_t gpuSwarmCount();
+void collectGpuSwarmMemory(MemoryReport& report); // Nothing unless set up
+
+// Advances every rock by dt seconds with one compute dispatch
+void stepGpuSwarm(float dt);
+// Bins the rocks into the grid and tests the live bullets against them (after stepGpuSwarm)
+void collideGpuSwarm(const BulletStore& bullets);
+struct SwarmHit {
+    uint32_t bullet; // Index among the live bullets uploaded that frame
+    uint32_t rock;
+};
+// Hit records of the oldest collided frame whose readback is ready (usually the previous one);
+// empty if none is. Call once per frame before collideGpuSwarm.
+const std::vector<SwarmHit>& collectGpuSwarmHits();
+
+// Culls the rocks into the draw commands at atlas level `lod`; once a frame, before drawGpuSwarm
+void cullGpuSwarm(int lod);
+// Draws the culled fills and outlines (in each split-screen viewport). Returns the draw calls issued.
+int drawGpuSwarm();
@@ -0,0 +1,181 @@
+#include "telemetry.h"
+#include "alloctrack.h"
+#include "log.h"
+#include "threadconfig.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+typedef SOCKET TelemetrySocket;
+static const TelemetrySocket NO_SOCKET = INVALID_SOCKET;
+static void closeSocket(TelemetrySocket s) { closesocket(s); }
+#else
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int TelemetrySocket;
+static const TelemetrySocket NO_SOCKET = -1;
+static void closeSocket(TelemetrySocket s) { close(s); }
+#endif
+
+// ============================ REGISTRY ============================
+TelemetrySlot telemetryCounters[TELEMETRY_COUNTER_COUNT];
+TelemetrySlot telemetryGauges[TELEMETRY_GAUGE_COUNT];
+
+static const char* counterNames[TELEMETRY_COUNTER_COUNT] = {
+    "frames",
+    "frame_us",
+    "ticks",
+    "draw_calls",
+    "upload_bytes",
+    "gpu_buffers_created",
+    "gpu_vertex_arrays_created",
+    "gpu_evictions",
+};
+
+static const char* gaugeNames[TELEMETRY_GAUGE_COUNT] = {
+    "asteroids",
+    "bullets",
+    "shield",
+    "frame_ms_max",
+    "gpu_buffers",
+    "gpu_buffer_kb",
+    "gpu_vertex_arrays",
+    "gpu_available_kb",
+};
+
+// ============================ EXPORTER ============================
+static std::thread exporterThread;
+static std::mutex exporterMutex;
+static std::condition_variable exporterSignal;
+static bool exporterStopping = false;
+static TelemetrySocket exporterSocket = NO_SOCKET;
+static sockaddr_storage exporterAddress;
+static int exporterAddressLength = 0;
+static std::string metricPrefix;
+static long long packetsFailed = 0; // Exporter thread only
+
+static void appendCount(std::string& packet, const char* name, int64_t value) {
+    char line[128];
+    std::snprintf(line, sizeof(line), "%s.%s:%lld|c\n", metricPrefix.c_str(), name, static_cast<long long>(value));
+    packet += line;
+}
+
+static void appendGauge(std::string& packet, const char* name, double value) {
+    char line[128];
+    std::snprintf(line, sizeof(line), "%s.%s:%.3f|g\n", metricPrefix.c_str(), name, value);
+    packet += line;
+}
+
+static void exporterLoop() {
+    registerThread(THREAD_TELEMETRY);
+    AllowAllocations exporter; // Its own thread: the packet string is rebuilt every interval
+    int64_t previous[TELEMETRY_COUNTER_COUNT] = {};
+    for (int c = 0; c < TELEMETRY_COUNTER_COUNT; ++c) previous[c] = telemetryCounters[c].value.load(std::memory_order_relaxed);
+    std::chrono::steady_clock::time_point last = std::chrono::steady_clock::now();
+    std::string packet;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(exporterMutex);
+            if (exporterSignal.wait_for(lock, std::chrono::milliseconds(TELEMETRY_INTERVAL_MS), [] { return exporterStopping; })) break;
+        }
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        const double seconds = std::chrono::duration<double>(now - last).count();
+        last = now;
+
+        int64_t delta[TELEMETRY_COUNTER_COUNT];
+        for (int c = 0; c < TELEMETRY_COUNTER_COUNT; ++c) {
+            const int64_t value = telemetryCounters[c].value.load(std::memory_order_relaxed);
+            delta[c] = value - previous[c];
+            previous[c] = value;
+        }
+        packet.clear();
+        for (int c = 0; c < TELEMETRY_COUNTER_COUNT; ++c) appendCount(packet, counterNames[c], delta[c]);
+        for (int g = 0; g < TELEMETRY_GAUGE_COUNT; ++g) {
+            const int64_t value = g == TELEMETRY_LONGEST_FRAME_US ? telemetryGauges[g].value.exchange(0, std::memory_order_relaxed)
+                                                                 : telemetryGauges[g].value.load(std::memory_order_relaxed);
+            if (value < 0) continue; // Nothing reported (yet)
+            appendGauge(packet, gaugeNames[g], g == TELEMETRY_LONGEST_FRAME_US ? value / 1000.0 : static_cast<double>(value));
+        }
+        // Rates for dashboards that plot gauges only
+        if (delta[TELEMETRY_FRAMES] > 0) {
+            appendGauge(packet, "frame_ms", delta[TELEMETRY_FRAME_MICROSECONDS] / 1000.0 / delta[TELEMETRY_FRAMES]);
+        }
+        if (seconds > 0.0) {
+            appendGauge(packet, "fps", delta[TELEMETRY_FRAMES] / seconds);
+            appendGauge(packet, "tick_rate", delta[TELEMETRY_TICKS] / seconds);
+        }
+        if (sendto(exporterSocket, packet.data(), static_cast<int>(packet.size()), 0,
+                   reinterpret_cast<const sockaddr*>(&exporterAddress), exporterAddressLength) < 0) {
+            if (packetsFailed++ == 0) LOG_WARN("Telemetry: send failed (further failures are counted, not logged)");
+        }
+    }
+}
+
+// ============================ TELEMETRY API ============================
+bool startTelemetry(const char* target, const char* prefix) {
+    stopTelemetry();
+    const char* colon = std::strrchr(target, ':');
+    if (!colon || colon == target) {
+        LOG_WARN("Telemetry: %s is not host:port", target);
+        return false;
+    }
+    const std::string host(target, colon);
+    const char* port = colon + 1;
+#if defined(_WIN32)
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+        LOG_WARN("Telemetry: Winsock unavailable");
+        return false;
+    }
+#endif
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* result = nullptr;
+    if (getaddrinfo(host.c_str(), port, &hints, &result) != 0 || !result) {
+        LOG_WARN("Telemetry: cannot resolve %s", target);
+        return false;
+    }
+    exporterSocket = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+    std::memcpy(&exporterAddress, result->ai_addr, result->ai_addrlen);
+    exporterAddressLength = static_cast<int>(result->ai_addrlen);
+    freeaddrinfo(result);
+    if (exporterSocket == NO_SOCKET) {
+        LOG_WARN("Telemetry: no UDP socket");
+        return false;
+    }
+    metricPrefix = prefix;
+    exporterStopping = false;
+    packetsFailed = 0;
+    exporterThread = std::thread(exporterLoop);
+    LOG_INFO("Telemetry: StatsD to %s every %d ms as %s.*", target, TELEMETRY_INTERVAL_MS, prefix);
+    return true;
+}
+
+void stopTelemetry() {
+    if (!exporterThread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(exporterMutex);
+        exporterStopping = true;
+    }
+    exporterSignal.notify_all();
+    exporterThread.join();
+    closeSocket(exporterSocket);
+    exporterSocket = NO_SOCKET;
+#if defined(_WIN32)
+    WSACleanup();
+#endif
+    if (packetsFailed > 0) LOG_INFO("Telemetry: %lld packets failed to send", packetsFailed);
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// ============================ LIVE TELEMETRY ============================
+// Counters for the ops dashboard, pushed as StatsD lines over UDP (--telemetry HOST:PORT) by a thread
+// of their own every TELEMETRY_INTERVAL_MS. The game only touches atomics: each value sits on its
+// own cache line and is written with a relaxed add or store, so the hot path pays one uncontended
+// atomic op and never waits on the network. The exporter reads the values, turns the counters into
+// per-interval deltas (and a few rates) and sends one datagram; a lost packet is simply lost.
+// Metric names are "<prefix>.<name>", the prefix from --telemetry-name (default "asteroids"), so
+// every cabinet can report under its own name.
+const int TELEMETRY_INTERVAL_MS = 1000;
+
+// Monotonic counts: sent as "|c" deltas per interval
+enum TelemetryCounter {
+    TELEMETRY_FRAMES,
+    TELEMETRY_FRAME_MICROSECONDS, // Summed frame times (the exporter sends the average as frame_ms)
+    TELEMETRY_TICKS,
+    TELEMETRY_DRAW_CALLS,
+    TELEMETRY_UPLOAD_BYTES,
+    TELEMETRY_GPU_BUFFERS_CREATED, // GL buffers and vertex arrays created (gpumemory.h): churn shows here
+    TELEMETRY_GPU_VERTEX_ARRAYS_CREATED,
+    TELEMETRY_GPU_EVICTIONS, // As the driver counts them (GL_NVX_gpu_memory_info only)
+    TELEMETRY_COUNTER_COUNT
+};
+
+// Current values: sent as "|g", the latest value set (not sent while it is negative)
+enum TelemetryGauge {
+    TELEMETRY_ASTEROIDS,
+    TELEMETRY_BULLETS,
+    TELEMETRY_SHIELD_ACTIVE, // 0 or 1
+    TELEMETRY_LONGEST_FRAME_US, // Longest frame this interval, in microseconds (sent as frame_ms_max; the exporter resets it)
+    TELEMETRY_GPU_BUFFERS, // Live GL buffers the game created
+    TELEMETRY_GPU_BUFFER_KB, // ... and their allocated stores
+    TELEMETRY_GPU_VERTEX_ARRAYS,
+    TELEMETRY_GPU_AVAILABLE_KB, // Free video memory, as the driver reports it (-1 when it does not)
+    TELEMETRY_GAUGE_COUNT
+};
+
+struct alignas(64) TelemetrySlot {
+    std::atomic<int64_t> value{ 0 };
+};
+
+extern TelemetrySlot telemetryCounters[TELEMETRY_COUNTER_COUNT];
+extern TelemetrySlot telemetryGauges[TELEMETRY_GAUGE_COUNT];
+
+// ============================ TELEMETRY API ============================
+// Any thread, any time (also without an exporter running)
+inline void telemetryAdd(TelemetryCounter counter, int64_t amount) {
+    telemetryCounters[counter].value.fetch_add(amount, std::memory_order_relaxed);
+}
+inline void telemetrySet(TelemetryGauge gauge, int64_t value) {
+    telemetryGauges[gauge].value.store(value, std::memory_order_relaxed);
+}
+// Raises a gauge to `value` if it is higher (a maximum over the interval)
+inline void telemetryMax(TelemetryGauge gauge, int64_t value) {
+    int64_t current = telemetryGauges[gauge].value.load(std::memory_order_relaxed);
+    while (value > current && !telemetryGauges[gauge].value.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+}
+
+// Starts the exporter for "host:port" (a numeric IPv4 address or a name resolved once here); false
+// if the address does not resolve or no socket can be opened
+bool startTelemetry(const char* target, const char* prefix);
+void stopTelemetry(); // Sends nothing more and joins the exporter (safe to call without one)
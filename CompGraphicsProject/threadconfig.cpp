@@ -0,0 +1,304 @@
+#include "threadconfig.h"
+#include "log.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <fstream>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+enum ThreadPriority { PRIORITY_LOW, PRIORITY_NORMAL, PRIORITY_HIGH };
+
+struct CpuCore {
+    uint64_t cpus; // Its logical CPUs (the SMT siblings), as a mask
+    bool performance;
+};
+
+// What a thread gets: the CPUs it may run on (0 leaves its affinity alone) and its priority
+struct ThreadPlan {
+    uint64_t cpus = 0;
+    ThreadPriority priority = PRIORITY_NORMAL;
+};
+
+struct RegisteredThread {
+    ThreadRole role;
+    int index;
+    uint64_t id;
+};
+
+static const char* const roleNames[THREAD_ROLE_COUNT] = {
+    "main", "simulation", "render", "workers", "audio", "logger", "telemetry", "background"
+};
+static const char* const priorityNames[] = { "low", "normal", "high" };
+
+static std::mutex threadMutex;
+static bool configured = false;
+static ThreadPlacement activePlacement = THREADS_OFF;
+static std::vector<RegisteredThread> earlyThreads; // Registered before configureThreads
+static ThreadPlan rolePlans[THREAD_ROLE_COUNT];
+static std::vector<uint64_t> workerCores; // Pinned: worker N runs on workerCores[N - 1]; later workers follow rolePlans
+static bool priorityDenied = false;
+
+// ============================ PLATFORM ============================
+#if defined(_WIN32)
+static uint64_t currentThreadId() {
+    return GetCurrentThreadId();
+}
+
+static std::vector<CpuCore> readCpuCores() {
+    std::vector<CpuCore> cores;
+    DWORD_PTR processMask = 0, systemMask = 0;
+    GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask);
+    DWORD length = 0;
+    GetLogicalProcessorInformationEx(RelationProcessorCore, nullptr, &length);
+    std::vector<unsigned char> buffer(length);
+    if (length == 0 || !GetLogicalProcessorInformationEx(RelationProcessorCore, reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buffer.data()), &length)) return cores;
+
+    // EfficiencyClass is 0 everywhere but on hybrid CPUs, where the performance cores have the highest
+    std::vector<BYTE> classes;
+    BYTE highest = 0;
+    for (DWORD at = 0; at < length;) {
+        const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX* info = reinterpret_cast<const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buffer.data() + at);
+        const PROCESSOR_RELATIONSHIP& core = info->Processor;
+        const uint64_t cpus = core.GroupMask[0].Group == 0 ? static_cast<uint64_t>(core.GroupMask[0].Mask & processMask) : 0;
+        if (cpus != 0) {
+            cores.push_back({ cpus, false });
+            classes.push_back(core.EfficiencyClass);
+            highest = std::max(highest, core.EfficiencyClass);
+        }
+        at += info->Size;
+    }
+    for (size_t i = 0; i < cores.size(); ++i) cores[i].performance = classes[i] == highest;
+    return cores;
+}
+
+// False if the priority could not be raised
+static bool applyPlan(uint64_t id, const ThreadPlan& plan) {
+    HANDLE thread = OpenThread(THREAD_SET_INFORMATION | THREAD_QUERY_INFORMATION, FALSE, static_cast<DWORD>(id));
+    if (!thread) return true;
+    if (plan.cpus != 0) SetThreadAffinityMask(thread, static_cast<DWORD_PTR>(plan.cpus));
+    const int priorities[] = { THREAD_PRIORITY_BELOW_NORMAL, THREAD_PRIORITY_NORMAL, THREAD_PRIORITY_HIGHEST };
+    const bool raised = SetThreadPriority(thread, priorities[plan.priority]) || plan.priority != PRIORITY_HIGH;
+    CloseHandle(thread);
+    return raised;
+}
+#elif defined(__linux__)
+static uint64_t currentThreadId() {
+    return static_cast<uint64_t>(syscall(SYS_gettid));
+}
+
+// A sysfs CPU list ("0-3,8,10-11") as a mask; 0 if the file is missing
+static uint64_t readCpuList(const std::string& path) {
+    std::ifstream in(path);
+    std::string list;
+    if (!std::getline(in, list)) return 0;
+    uint64_t mask = 0;
+    const char* p = list.c_str();
+    while (*p) {
+        char* end = nullptr;
+        const long first = std::strtol(p, &end, 10);
+        if (end == p) break;
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            last = std::strtol(p + 1, &end, 10);
+            p = end;
+        }
+        for (long cpu = first; cpu <= last && cpu < 64; ++cpu) mask |= uint64_t(1) << cpu;
+        if (*p == ',') ++p;
+        else break;
+    }
+    return mask;
+}
+
+static std::vector<CpuCore> readCpuCores() {
+    std::vector<CpuCore> cores;
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return cores;
+    // Intel hybrid CPUs list their efficiency cores here; ARM big.LITTLE ranks cores by capacity instead
+    const uint64_t atom = readCpuList("/sys/devices/cpu_atom/cpus");
+    std::vector<int> capacities;
+    int highest = 0, lowest = 0;
+    uint64_t seen = 0;
+    for (int cpu = 0; cpu < 64; ++cpu) {
+        if (!CPU_ISSET(cpu, &allowed) || ((seen >> cpu) & 1)) continue;
+        const std::string base = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+        uint64_t siblings = readCpuList(base + "/topology/thread_siblings_list");
+        uint64_t allowedSiblings = 0;
+        for (int sibling = 0; sibling < 64; ++sibling) {
+            if (((siblings >> sibling) & 1) && CPU_ISSET(sibling, &allowed)) allowedSiblings |= uint64_t(1) << sibling;
+        }
+        siblings = allowedSiblings | (uint64_t(1) << cpu);
+        seen |= siblings;
+        std::ifstream capacityFile(base + "/cpu_capacity");
+        int capacity = 0;
+        capacityFile >> capacity;
+        capacities.push_back(capacity);
+        highest = cores.empty() ? capacity : std::max(highest, capacity);
+        lowest = cores.empty() ? capacity : std::min(lowest, capacity);
+        cores.push_back({ siblings, true });
+    }
+    for (size_t i = 0; i < cores.size(); ++i) {
+        if (atom != 0) cores[i].performance = (cores[i].cpus & atom) == 0;
+        else if (highest != lowest) cores[i].performance = capacities[i] == highest;
+    }
+    return cores;
+}
+
+static bool applyPlan(uint64_t id, const ThreadPlan& plan) {
+    const pid_t tid = static_cast<pid_t>(id);
+    if (plan.cpus != 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu = 0; cpu < 64; ++cpu) {
+            if ((plan.cpus >> cpu) & 1) CPU_SET(cpu, &set);
+        }
+        sched_setaffinity(tid, sizeof(set), &set);
+    }
+    // Linux keeps a nice value per thread; below 0 needs CAP_SYS_NICE
+    const int niceness[] = { 10, 0, -5 };
+    return setpriority(PRIO_PROCESS, static_cast<id_t>(tid), niceness[plan.priority]) == 0 || plan.priority != PRIORITY_HIGH;
+}
+#else
+static uint64_t currentThreadId() { return 0; }
+static std::vector<CpuCore> readCpuCores() { return {}; } // No affinity API: the scheduler places the threads
+static bool applyPlan(uint64_t, const ThreadPlan&) { return true; }
+#endif
+
+// ============================ LAYOUT ============================
+// "0-3,8,10-11"
+static std::string cpuListString(uint64_t cpus) {
+    if (cpus == 0) return "any";
+    std::string text;
+    for (int cpu = 0; cpu < 64; ++cpu) {
+        if (!((cpus >> cpu) & 1)) continue;
+        int last = cpu;
+        while (last + 1 < 64 && ((cpus >> (last + 1)) & 1)) ++last;
+        if (!text.empty()) text += ',';
+        text += std::to_string(cpu);
+        if (last > cpu) text += '-' + std::to_string(last);
+        cpu = last;
+    }
+    return text;
+}
+
+static ThreadPlan planFor(ThreadRole role, int index) {
+    ThreadPlan plan = rolePlans[role];
+    if (role == THREAD_WORKER && index >= 1 && static_cast<size_t>(index) <= workerCores.size()) plan.cpus = workerCores[static_cast<size_t>(index) - 1];
+    return plan;
+}
+
+static void applyThread(uint64_t id, ThreadRole role, int index) {
+    if (applyPlan(id, planFor(role, index)) || priorityDenied) return;
+    priorityDenied = true;
+    LOG_INFO("Threads: raising a priority was refused (CAP_SYS_NICE on Linux); the high-priority threads keep the default");
+}
+
+bool parseThreadPlacement(const char* name, ThreadPlacement& placement) {
+    if (std::strcmp(name, "off") == 0) placement = THREADS_OFF;
+    else if (std::strcmp(name, "auto") == 0) placement = THREADS_AUTO;
+    else if (std::strcmp(name, "pinned") == 0) placement = THREADS_PINNED;
+    else return false;
+    return true;
+}
+
+void registerThread(ThreadRole role, int index) {
+    std::lock_guard<std::mutex> lock(threadMutex);
+    const uint64_t id = currentThreadId();
+    if (!configured) earlyThreads.push_back({ role, index, id });
+    else if (activePlacement != THREADS_OFF) applyThread(id, role, index);
+}
+
+void configureThreads(ThreadPlacement placement, bool simThread, bool renderThread) {
+    std::lock_guard<std::mutex> lock(threadMutex);
+    configured = true;
+    const std::vector<CpuCore> cores = placement != THREADS_OFF ? readCpuCores() : std::vector<CpuCore>();
+    if (placement != THREADS_OFF && cores.empty()) LOG_INFO("Threads: no CPU topology on this platform; the scheduler places them");
+    activePlacement = cores.empty() ? THREADS_OFF : placement;
+    if (activePlacement == THREADS_OFF) {
+        earlyThreads.clear();
+        return;
+    }
+
+    uint64_t performance = 0, efficiency = 0;
+    std::vector<uint64_t> performanceCores;
+    int logical = 0;
+    for (const CpuCore& core : cores) {
+        for (int cpu = 0; cpu < 64; ++cpu) logical += static_cast<int>((core.cpus >> cpu) & 1);
+        if (core.performance) {
+            performance |= core.cpus;
+            performanceCores.push_back(core.cpus);
+        }
+        else efficiency |= core.cpus;
+    }
+    const bool hybrid = performance != 0 && efficiency != 0;
+    const uint64_t game = hybrid ? performance : 0;
+    const uint64_t background = hybrid ? efficiency : 0;
+    rolePlans[THREAD_MAIN] = { game, PRIORITY_HIGH };
+    rolePlans[THREAD_SIMULATION] = { game, PRIORITY_HIGH };
+    rolePlans[THREAD_RENDER] = { game, PRIORITY_HIGH };
+    rolePlans[THREAD_WORKER] = { game, PRIORITY_NORMAL };
+    rolePlans[THREAD_AUDIO] = { 0, PRIORITY_HIGH }; // Light, but late blocks are heard: any core that is free
+    rolePlans[THREAD_LOGGER] = { background, PRIORITY_LOW };
+    rolePlans[THREAD_TELEMETRY] = { background, PRIORITY_LOW };
+    rolePlans[THREAD_BACKGROUND] = { background, PRIORITY_LOW };
+    workerCores.clear();
+
+    if (activePlacement == THREADS_PINNED) {
+        // The main thread is never pinned: threads it creates later (the GL driver's among them)
+        // would inherit its single core on Linux
+        std::vector<ThreadRole> dedicated;
+        if (simThread) dedicated.push_back(THREAD_SIMULATION);
+        if (renderThread) dedicated.push_back(THREAD_RENDER);
+        // Core 0 takes most interrupts: the dedicated threads start at the next one with cores to spare
+        const size_t first = performanceCores.size() > dedicated.size() + 1 ? 1 : 0;
+        if (performanceCores.size() < first + dedicated.size() + 1) {
+            LOG_WARN("Threads: %zu performance cores are too few to pin %zu threads and keep one for the workers; placing them as with auto",
+                     performanceCores.size(), dedicated.size());
+            activePlacement = THREADS_AUTO;
+        }
+        else {
+            uint64_t taken = 0;
+            for (size_t i = 0; i < dedicated.size(); ++i) {
+                rolePlans[dedicated[i]].cpus = performanceCores[first + i];
+                taken |= performanceCores[first + i];
+            }
+            for (uint64_t core : performanceCores) {
+                if ((core & taken) == 0) workerCores.push_back(core);
+            }
+            // Workers past one per core float over every performance core, below the pinned threads' priority
+            rolePlans[THREAD_WORKER].cpus = performance;
+        }
+    }
+
+    LOG_INFO("Threads: %d logical CPUs on %zu cores (%zu performance, %zu efficiency), placement %s",
+             logical, cores.size(), performanceCores.size(), cores.size() - performanceCores.size(),
+             activePlacement == THREADS_PINNED ? "pinned" : "auto");
+    for (int role = 0; role < THREAD_ROLE_COUNT; ++role) {
+        const ThreadPlan& plan = rolePlans[role];
+        if (role == THREAD_WORKER && !workerCores.empty()) {
+            std::string pins;
+            for (uint64_t core : workerCores) pins += (pins.empty() ? "" : " ") + cpuListString(core);
+            LOG_INFO("  %-10s one per core on cpus %s, any more on %s, %s priority", roleNames[role], pins.c_str(),
+                     cpuListString(plan.cpus).c_str(), priorityNames[plan.priority]);
+        }
+        else LOG_INFO("  %-10s cpus %s, %s priority", roleNames[role], cpuListString(plan.cpus).c_str(), priorityNames[plan.priority]);
+    }
+
+    for (const RegisteredThread& thread : earlyThreads) applyThread(thread.id, thread.role, thread.index);
+    earlyThreads.clear();
+}
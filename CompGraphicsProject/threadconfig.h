@@ -0,0 +1,42 @@
+#pragma once
+
+// ============================ THREAD PLACEMENT ============================
+// Where the game's threads run and at what priority. Every long-lived thread registers its role as it
+// starts; configureThreads reads the CPU topology once (physical cores, their SMT siblings, and on
+// hybrid CPUs which cores are performance cores and which efficiency cores), logs the layout and
+// applies it to the threads registered so far, and each later registration applies its own entry.
+//   auto    the main, simulation, render and audio threads at high priority, the logger, telemetry
+//           exporter and file writers at low priority; on a hybrid CPU the game's threads are kept
+//           to the performance cores and the background ones to the efficiency cores
+//   pinned  auto, plus the simulation and render threads each on a performance core of its own and
+//           one job worker per remaining performance core (auto's layout with too few cores); the
+//           main thread stays on auto's cores, as threads it creates later would inherit its mask
+//   off     the scheduler's defaults
+// Windows and Linux only; on Linux raising a priority needs CAP_SYS_NICE (lowering always works).
+// Affinity covers the first 64 logical CPUs (one Windows processor group).
+enum ThreadPlacement {
+    THREADS_OFF,
+    THREADS_AUTO,
+    THREADS_PINNED
+};
+
+enum ThreadRole {
+    THREAD_MAIN,
+    THREAD_SIMULATION,
+    THREAD_RENDER,
+    THREAD_WORKER, // Job workers, numbered from 1
+    THREAD_AUDIO,
+    THREAD_LOGGER,
+    THREAD_TELEMETRY,
+    THREAD_BACKGROUND, // File writers (capture, replay) and the shape stream
+    THREAD_ROLE_COUNT
+};
+
+// Parses a --threads value ("off", "auto", "pinned"); false if unknown
+bool parseThreadPlacement(const char* name, ThreadPlacement& placement);
+
+// Call on the thread itself, as it starts (`index`: the worker's number)
+void registerThread(ThreadRole role, int index = 0);
+// Once, before the threads that register after it start. `simThread` and `renderThread` say whether
+// those threads will run, so pinning only sets cores aside for the ones that do.
+void configureThreads(ThreadPlacement placement, bool simThread, bool renderThread);
@@ -0,0 +1,64 @@
+#include "timebase.h"
+
+#include <cmath>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+// ============================ TICKS ============================
+#if defined(_WIN32)
+static int64_t queryFrequency() {
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency); // Fixed at boot; never fails on XP and later
+    return frequency.QuadPart;
+}
+
+static const int64_t ticksPerSecond = queryFrequency();
+
+int64_t clockTicks() {
+    LARGE_INTEGER count;
+    QueryPerformanceCounter(&count);
+    return count.QuadPart;
+}
+#else
+static const int64_t ticksPerSecond = 1000000000; // Nanoseconds
+
+int64_t clockTicks() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<int64_t>(now.tv_sec) * ticksPerSecond + now.tv_nsec;
+}
+#endif
+
+int64_t clockTicksPerSecond() {
+    return ticksPerSecond;
+}
+
+double ticksToSeconds(int64_t ticks) {
+    return static_cast<double>(ticks / ticksPerSecond) + static_cast<double>(ticks % ticksPerSecond) / static_cast<double>(ticksPerSecond);
+}
+
+// ============================ SESSION TIME ============================
+static int64_t sessionOrigin = 0;
+
+void startSessionClock() {
+    sessionOrigin = clockTicks();
+}
+
+double sessionSeconds() {
+    return sessionSecondsAt(clockTicks());
+}
+
+double sessionSecondsAt(int64_t ticks) {
+    return ticksToSeconds(ticks - sessionOrigin);
+}
+
+// ============================ SHADER TIME ============================
+float shaderTime(double seconds) {
+    return static_cast<float>(seconds - SHADER_TIME_WRAP_SECONDS * std::floor(seconds / SHADER_TIME_WRAP_SECONDS));
+}
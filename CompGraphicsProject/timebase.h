@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+// The window's clock. Time is a 64-bit count of the platform's monotonic counter
+// (QueryPerformanceCounter, clock_gettime(CLOCK_MONOTONIC)), which keeps its resolution however long
+// the session runs: frame deltas are differences of counts, turned into seconds only afterwards,
+// and the session time is a double (still under a microsecond a step after a century). A float of
+// seconds since startup, which this replaces, steps in whole milliseconds after a few hours and in
+// quarters of a second after a few weeks.
+// Shaders take a float, so they get the session time wrapped (shaderTime): at most
+// SHADER_TIME_WRAP_SECONDS, fine to a few milliseconds, at the cost of one seam in the background's
+// drift each time it wraps.
+
+// ============================ TICKS ============================
+int64_t clockTicks(); // Monotonic, from an arbitrary origin
+int64_t clockTicksPerSecond();
+double ticksToSeconds(int64_t ticks); // Exact whole seconds plus the fraction, for any count
+
+// ============================ SESSION TIME ============================
+void startSessionClock(); // Sets the origin; call once at startup
+double sessionSeconds(); // Since startSessionClock
+double sessionSecondsAt(int64_t ticks); // For a count clockTicks returned
+
+// ============================ SHADER TIME ============================
+const double SHADER_TIME_WRAP_SECONDS = 16384.0; // About 4.5 hours; a float step there is 2 ms
+float shaderTime(double seconds); // `seconds` wrapped into [0, SHADER_TIME_WRAP_SECONDS)
@@ -0,0 +1,144 @@
+#include "trace.h"
+#include "alloctrack.h"
+#include "log.h"
+
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// ============================ TRACE STATE ============================
+std::atomic<bool> traceRecording(false);
+
+struct TraceEvent {
+    const char* name;
+    const char* category;
+    int64_t start; // ns from traceStart
+    int64_t duration; // ns
+    uint32_t rangeBegin, rangeEnd;
+};
+
+// One thread's ring. Only its thread writes it: the event first, then the count (release), so the
+// writer of the file reads every counted event whole unless the ring has lapped it meanwhile.
+struct TraceBuffer {
+    std::unique_ptr<TraceEvent[]> events;
+    std::atomic<size_t> count{ 0 }; // Events ever recorded since startTrace; the ring holds the last TRACE_EVENTS_PER_THREAD
+    char name[32] = {};
+    int track = 0; // Trace tid
+};
+
+static std::mutex bufferMutex; // Guards buffers (the list, not the rings)
+static std::vector<std::unique_ptr<TraceBuffer>> buffers; // Kept for the whole process: a thread's pointer never dangles
+static std::chrono::steady_clock::time_point traceStart = std::chrono::steady_clock::now();
+static int traceIndex = 0;
+
+static thread_local TraceBuffer* threadBuffer = nullptr;
+static thread_local char threadName[32] = {};
+
+static TraceBuffer* createBuffer(const char* name) {
+    AllowAllocations once; // The thread's only allocation for the trace
+    std::unique_ptr<TraceBuffer> buffer(new TraceBuffer());
+    buffer->events.reset(new TraceEvent[TRACE_EVENTS_PER_THREAD]);
+    std::lock_guard<std::mutex> lock(bufferMutex);
+    buffer->track = static_cast<int>(buffers.size()) + 1;
+    if (name[0]) std::snprintf(buffer->name, sizeof(buffer->name), "%s", name);
+    else std::snprintf(buffer->name, sizeof(buffer->name), "thread %d", buffer->track);
+    buffers.push_back(std::move(buffer));
+    return buffers.back().get();
+}
+
+static TraceBuffer& ownBuffer() {
+    if (!threadBuffer) threadBuffer = createBuffer(threadName);
+    return *threadBuffer;
+}
+
+static TraceBuffer& gpuBuffer() {
+    static TraceBuffer* gpu = createBuffer("gpu");
+    return *gpu;
+}
+
+static void record(TraceBuffer& buffer, const TraceEvent& event) {
+    const size_t index = buffer.count.load(std::memory_order_relaxed);
+    buffer.events[index % TRACE_EVENTS_PER_THREAD] = event;
+    buffer.count.store(index + 1, std::memory_order_release);
+}
+
+static int64_t nanosecondsSinceStart(std::chrono::steady_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time - traceStart).count();
+}
+
+// ============================ TRACE API ============================
+void nameTraceThread(const char* name) {
+    std::snprintf(threadName, sizeof(threadName), "%s", name);
+    if (threadBuffer) {
+        std::lock_guard<std::mutex> lock(bufferMutex);
+        std::snprintf(threadBuffer->name, sizeof(threadBuffer->name), "%s", name);
+    }
+}
+
+void startTrace() {
+    if (traceActive()) return;
+    {
+        std::lock_guard<std::mutex> lock(bufferMutex);
+        for (std::unique_ptr<TraceBuffer>& buffer : buffers) buffer->count.store(0, std::memory_order_relaxed);
+    }
+    traceStart = std::chrono::steady_clock::now();
+    traceRecording.store(true, std::memory_order_release);
+    LOG_INFO("Trace: recording (last %zu spans per thread kept)", TRACE_EVENTS_PER_THREAD);
+}
+
+void traceSpan(const char* name, const char* category, std::chrono::steady_clock::time_point start,
+               std::chrono::steady_clock::time_point end, size_t rangeBegin, size_t rangeEnd) {
+    if (!traceActive()) return;
+    const int64_t startNs = nanosecondsSinceStart(start);
+    record(ownBuffer(), { name, category, startNs, nanosecondsSinceStart(end) - startNs,
+                          static_cast<uint32_t>(rangeBegin), static_cast<uint32_t>(rangeEnd) });
+}
+
+void traceGpuSpan(const char* name, std::chrono::steady_clock::time_point start, double milliseconds) {
+    if (!traceActive()) return;
+    record(gpuBuffer(), { name, "gpu", nanosecondsSinceStart(start), static_cast<int64_t>(milliseconds * 1.0e6), 0, 0 });
+}
+
+bool stopTrace(const char* path) {
+    if (!traceRecording.exchange(false, std::memory_order_acq_rel)) return false;
+    char numbered[32];
+    if (!path) {
+        std::snprintf(numbered, sizeof(numbered), "trace-%04d.json", traceIndex++);
+        path = numbered;
+    }
+
+    AllowAllocations writing; // Once per trace, outside any frame budget
+    std::FILE* file = std::fopen(path, "w");
+    if (!file) {
+        LOG_WARN("Could not write the trace to %s", path);
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(bufferMutex);
+    std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+    const char* separator = "";
+    size_t written = 0, dropped = 0;
+    for (const std::unique_ptr<TraceBuffer>& buffer : buffers) {
+        const size_t count = buffer->count.load(std::memory_order_acquire);
+        if (count == 0) continue;
+        std::fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                     separator, buffer->track, buffer->name);
+        separator = ",\n";
+        const size_t first = count > TRACE_EVENTS_PER_THREAD ? count - TRACE_EVENTS_PER_THREAD : 0;
+        dropped += first;
+        for (size_t i = first; i < count; ++i) {
+            const TraceEvent& event = buffer->events[i % TRACE_EVENTS_PER_THREAD];
+            std::fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f",
+                         event.name, event.category, buffer->track, event.start / 1000.0, event.duration / 1000.0);
+            if (event.rangeEnd > event.rangeBegin) std::fprintf(file, ",\"args\":{\"begin\":%u,\"end\":%u}", event.rangeBegin, event.rangeEnd);
+            std::fputc('}', file);
+        }
+        written += count - first;
+    }
+    std::fputs("\n]}\n", file);
+    const bool ok = std::ferror(file) == 0;
+    std::fclose(file);
+    if (ok) LOG_INFO("Trace: %zu spans written to %s (%zu older ones dropped)", written, path, dropped);
+    else LOG_WARN("Could not write the trace to %s", path);
+    return ok;
+}
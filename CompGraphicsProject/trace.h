@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// ============================ TIMELINE TRACE ============================
+// The profiler's rolling averages hide single hitches; the trace keeps every event instead. While
+// recording, each ProfileScope, each job the job system runs, each simulation tick and each GPU pass
+// (placed from timer queries) becomes one span with its thread, and the spans are written as Chrome
+// trace-event JSON, which chrome://tracing and ui.perfetto.dev open directly.
+// Every thread records into its own ring of TRACE_EVENTS_PER_THREAD spans (no locks, no allocation
+// after its first span), so a long session keeps its most recent stretch and drops the oldest.
+// GL-free: the renderer reads its timer queries and hands the GPU spans in with traceGpuSpan.
+const size_t TRACE_EVENTS_PER_THREAD = 1 << 17; // 5 MB per thread, a few minutes of a 60 FPS session
+
+extern std::atomic<bool> traceRecording;
+
+inline bool traceActive() { return traceRecording.load(std::memory_order_relaxed); }
+
+// ============================ TRACE API ============================
+// Starts recording (a no-op while already recording); earlier spans are discarded
+void startTrace();
+// Stops recording and writes every thread's spans to `path` (null: trace-NNNN.json in the working
+// directory); false if nothing was recording or the file could not be written
+bool stopTrace(const char* path);
+// Names the calling thread's track (any time; kept for spans it records later)
+void nameTraceThread(const char* name);
+// A span on the calling thread. `name` and `category` must be string literals or otherwise live
+// until the trace is written. A non-empty [rangeBegin, rangeEnd) goes into the span's args (job chunks).
+void traceSpan(const char* name, const char* category, std::chrono::steady_clock::time_point start,
+               std::chrono::steady_clock::time_point end, size_t rangeBegin = 0, size_t rangeEnd = 0);
+// A GPU pass, on the "gpu" track: `start` is on the steady clock (the renderer converts the GPU's
+// timestamps), `milliseconds` its length. Render thread only.
+void traceGpuSpan(const char* name, std::chrono::steady_clock::time_point start, double milliseconds);
+
+// Records the enclosing scope as a span (reads no clock while not recording)
+struct TraceScope {
+    const char* name;
+    const char* category;
+    bool enabled;
+    std::chrono::steady_clock::time_point start;
+
+    TraceScope(const char* n, const char* c) : name(n), category(c), enabled(traceActive()) {
+        if (enabled) start = std::chrono::steady_clock::now();
+    }
+    ~TraceScope() {
+        if (enabled) traceSpan(name, category, start, std::chrono::steady_clock::now());
+    }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+};
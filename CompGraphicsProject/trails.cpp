@@ -0,0 +1,247 @@
+#include "trails.h"
+#include "frameconstants.h"
+#include "glstate.h"
+#include "shaders.h"
+#include "simthread.h"
+#include "memreport.h"
+
+#include <bit>
+#include <cstddef>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+bool useTrails = true;
+
+// ============================ TRAIL DATA ============================
+// Ring entries are RGBA32UI texels: x and y (float bits), the row the slot's unbroken history
+// started on, and whether the slot holds anything
+typedef glm::uvec4 TrailEntry;
+static_assert(sizeof(TrailEntry) == 16, "The vertex shader reads a TrailEntry as one RGBA32UI texel");
+static_assert(TRAIL_TICKS == 12, "The vertex shader's TICKS must match TRAIL_TICKS");
+const GLuint TRAIL_RESTART_INDEX = 0xFFFFFFFFu;
+
+// What a slot's newest entry was written from
+struct SlotHistory {
+    uint32_t generation;
+    bool live;
+    glm::vec2 position;
+    uint32_t since; // Row its unbroken history started on
+};
+
+static unsigned int trailProgram, trailVAO, ringBuffer, indexBuffer, ringTexture;
+static int ringUnit = 0;
+static int historyLoc, slotsLoc, newestRowLoc, newestTickLoc, alphaLoc, bulletPaintLoc, shipPaintLoc;
+static std::vector<TrailEntry> row; // The row being appended
+static std::vector<SlotHistory> slotHistory;
+static size_t slots = 0; // Bullet ring slots, then the ship
+static int newestRow = -1; // -1: nothing appended since the ring was sized
+static uint32_t appended = 0; // Rows appended since the ring was sized
+static double lastClock = 0.0;
+static uint64_t bytesWritten = 0;
+
+// ============================ SHADERS ============================
+static const char* trailVertexShaderSource = R"(
+    #version 330 core
+    uniform usamplerBuffer history; // The ring, row-major
+    uniform int slots;
+    uniform int newestRow;
+    uniform uint newestTick; // Rows appended before the newest
+    uniform float alpha; // How far the frame is past the newest row
+    uniform uint bulletPaint;
+    uniform uint shipPaint;
+
+    out vec3 trailColor;
+    out float fade;
+
+    const int TICKS = 12;
+)" PALETTE_GLSL R"(
+    vec2 positionAt(int slot, int age)
+    {
+        uvec4 entry = texelFetch(history, ((newestRow - age + TICKS) % TICKS) * slots + slot);
+        return vec2(uintBitsToFloat(entry.x), uintBitsToFloat(entry.y));
+    }
+
+    void main()
+    {
+        int slot = gl_VertexID / TICKS;
+        int age = gl_VertexID - slot * TICKS;
+        uvec4 newest = texelFetch(history, newestRow * slots + slot);
+        trailColor = paintColor(slot == slots - 1 ? shipPaint : bulletPaint);
+        fade = 1.0 - float(age) / float(TICKS - 1);
+        if (newest.w == 0u) {
+            gl_Position = vec4(2.0, 2.0, 2.0, 1.0); // Outside the clip volume: the strip is dropped
+            return;
+        }
+        // Vertices older than the slot's unbroken history collapse onto its oldest point
+        int span = int(min(newestTick - newest.z, uint(TICKS - 1)));
+        vec2 position = mix(positionAt(slot, min(age + 1, span)), positionAt(slot, min(age, span)), alpha);
+        gl_Position = vec4(position, 0.0, 1.0);
+    }
+)";
+
+static const char* trailFragmentShaderSource = R"(
+    #version 330 core
+)" FRAME_CONSTANTS_GLSL R"(
+    in vec3 trailColor;
+    in float fade;
+    out vec4 FragColor;
+
+    void main()
+    {
+        FragColor = vec4(trailColor, 0.6 * fade) * tint;
+    }
+)";
+
+// ============================ SETUP ============================
+bool setupTrails(int unit)
+{
+    trailProgram = buildProgram("trails", trailVertexShaderSource, trailFragmentShaderSource);
+    if (!trailProgram) {
+        useTrails = false;
+        return false;
+    }
+    bindFrameConstants(trailProgram);
+    ringUnit = unit;
+    historyLoc = glGetUniformLocation(trailProgram, "history");
+    slotsLoc = glGetUniformLocation(trailProgram, "slots");
+    newestRowLoc = glGetUniformLocation(trailProgram, "newestRow");
+    newestTickLoc = glGetUniformLocation(trailProgram, "newestTick");
+    alphaLoc = glGetUniformLocation(trailProgram, "alpha");
+    bulletPaintLoc = glGetUniformLocation(trailProgram, "bulletPaint");
+    shipPaintLoc = glGetUniformLocation(trailProgram, "shipPaint");
+    glState.useProgram(trailProgram);
+    glUniform1i(historyLoc, unit);
+    glGenVertexArrays(1, &trailVAO);
+    glGenBuffers(1, &ringBuffer);
+    glGenBuffers(1, &indexBuffer);
+    glGenTextures(1, &ringTexture);
+    return true;
+}
+
+void destroyTrails()
+{
+    if (ringTexture) glDeleteTextures(1, &ringTexture);
+    if (indexBuffer) glDeleteBuffers(1, &indexBuffer);
+    if (ringBuffer) glDeleteBuffers(1, &ringBuffer);
+    if (trailVAO) glDeleteVertexArrays(1, &trailVAO);
+    if (trailProgram) glDeleteProgram(trailProgram);
+    ringTexture = indexBuffer = ringBuffer = trailVAO = trailProgram = 0;
+    row.clear();
+    slotHistory.clear();
+    slots = 0;
+    newestRow = -1;
+}
+
+void collectTrailMemory(MemoryReport& report)
+{
+    if (!trailProgram) return;
+    report.add("trails", "history ring", MEMORY_GPU, glBufferBytes(ringBuffer));
+    report.add("trails", "strip indices", MEMORY_GPU, glBufferBytes(indexBuffer));
+    report.add("trails", "row staging", MEMORY_CPU, row.capacity() * sizeof(TrailEntry) + slotHistory.capacity() * sizeof(SlotHistory));
+}
+
+bool trailsReady()
+{
+    return trailProgram != 0;
+}
+
+uint64_t trailBytesWritten()
+{
+    return bytesWritten;
+}
+
+// (Re)allocates the ring for `count` slots, every entry empty, and their strips' indices
+static void resizeRing(size_t count)
+{
+    slots = count;
+    row.assign(count, TrailEntry(0u));
+    slotHistory.assign(count, { 0, false, glm::vec2(0.0f), 0 });
+    newestRow = -1;
+    appended = 0;
+
+    const std::vector<TrailEntry> empty(count * TRAIL_TICKS, TrailEntry(0u));
+    glBindBuffer(GL_ARRAY_BUFFER, ringBuffer);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(empty.size() * sizeof(TrailEntry)), empty.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glActiveTexture(GL_TEXTURE0 + ringUnit);
+    glBindTexture(GL_TEXTURE_BUFFER, ringTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32UI, ringBuffer);
+    glActiveTexture(GL_TEXTURE0);
+
+    // The vertex ID is slot * TRAIL_TICKS + age; each slot's strip ends with a restart
+    std::vector<GLuint> indices;
+    indices.reserve(count * (TRAIL_TICKS + 1));
+    for (size_t s = 0; s < count; ++s) {
+        for (int age = 0; age < TRAIL_TICKS; ++age) indices.push_back(static_cast<GLuint>(s * TRAIL_TICKS + age));
+        indices.push_back(TRAIL_RESTART_INDEX);
+    }
+    glState.bindVertexArray(trailVAO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(indices.size() * sizeof(GLuint)), indices.data(), GL_STATIC_DRAW);
+    glState.bindVertexArray(0);
+}
+
+// ============================ SYNC ============================
+static TrailEntry trailEntry(size_t s, bool live, glm::vec2 position, uint32_t generation)
+{
+    SlotHistory& history = slotHistory[s];
+    if (!live) {
+        history.live = false;
+        return TrailEntry(0u);
+    }
+    if (!history.live || history.generation != generation || glm::distance(history.position, position) > TRAIL_BREAK_DISTANCE) {
+        history.since = appended;
+    }
+    history = { generation, true, position, history.since };
+    return TrailEntry(std::bit_cast<uint32_t>(position.x), std::bit_cast<uint32_t>(position.y), history.since, 1u);
+}
+
+void syncTrails(const RenderSnapshot& view)
+{
+    if (!trailProgram) return;
+    const BulletStore& bullets = view.bullets;
+    if (bullets.capacity() + 1 != slots) resizeRing(bullets.capacity() + 1);
+    if (newestRow >= 0 && bullets.clock == lastClock) return; // No new tick
+    lastClock = bullets.clock;
+
+    for (size_t j = 0; j < bullets.capacity(); ++j) row[j] = trailEntry(j, bullets.live(j), bullets.position(j), bullets.generation[j]);
+    row[slots - 1] = trailEntry(slots - 1, !view.isGameOver, view.player.position, 0);
+    newestRow = (newestRow + 1) % TRAIL_TICKS;
+    ++appended;
+
+    glBindBuffer(GL_ARRAY_BUFFER, ringBuffer);
+    glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(static_cast<size_t>(newestRow) * slots * sizeof(TrailEntry)),
+                    static_cast<GLsizeiptr>(slots * sizeof(TrailEntry)), row.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    bytesWritten += slots * sizeof(TrailEntry);
+}
+
+// ============================ DRAW ============================
+int drawTrails(float alpha, uint32_t bulletPaint, uint32_t shipPaint)
+{
+    if (!trailProgram || newestRow < 0) return 0;
+    glState.useProgram(trailProgram);
+    glUniform1i(slotsLoc, static_cast<GLint>(slots));
+    glUniform1i(newestRowLoc, newestRow);
+    glUniform1ui(newestTickLoc, appended - 1);
+    glUniform1f(alphaLoc, alpha);
+    glUniform1ui(bulletPaintLoc, bulletPaint);
+    glUniform1ui(shipPaintLoc, shipPaint);
+    glActiveTexture(GL_TEXTURE0 + ringUnit);
+    glBindTexture(GL_TEXTURE_BUFFER, ringTexture);
+    glActiveTexture(GL_TEXTURE0);
+
+    glState.bindVertexArray(trailVAO);
+    glState.setEnabled(GL_BLEND, true);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+    glState.setEnabled(GL_PRIMITIVE_RESTART, true);
+    glPrimitiveRestartIndex(TRAIL_RESTART_INDEX);
+    glState.setLineWidth(1.0f);
+    glDrawElements(GL_LINE_STRIP, static_cast<GLsizei>(slots * (TRAIL_TICKS + 1)), GL_UNSIGNED_INT, (void*)0);
+    glState.setEnabled(GL_PRIMITIVE_RESTART, false);
+    glState.setEnabled(GL_BLEND, false);
+    glState.bindVertexArray(0);
+    return 1;
+}
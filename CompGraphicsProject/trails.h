@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+struct RenderSnapshot;
+struct MemoryReport;
+
+// Motion trails (on by default, --no-trails turns them off, toggle with R): a fading line behind
+// every bullet and the ship. Their past positions are one ring of TRAIL_TICKS rows in a single
+// buffer, a row per tick with an entry per bullet ring slot and one for the ship, so each new tick
+// is one upload of one row. The entry holds the position and the row its unbroken history started
+// on (a new bullet in the slot, or a jump across the field's edge, starts it again). One indexed
+// GL_LINE_STRIP draw covers every slot, a strip of TRAIL_TICKS vertices each with primitive restart
+// between them; the vertex shader reads the ring as a texture buffer, clamps each vertex to the
+// slot's unbroken history and fades it with its age. Only for the one-screen field: the arena's
+// view moves with the ship.
+
+// ============================ TRAIL STATE ============================
+extern bool useTrails; // Record and draw the trails (toggle with R)
+const int TRAIL_TICKS = 12; // Rows in the ring: a tenth of a second of history
+const float TRAIL_BREAK_DISTANCE = 0.5f; // Field units between two ticks that count as a wrap, not a move
+
+// ============================ TRAIL API ============================
+// Builds the program, reading the ring from texture unit `unit`; false (and useTrails off) if it
+// fails. The ring is sized by the first sync.
+bool setupTrails(int unit);
+void destroyTrails();
+bool trailsReady(); // Set up, so useTrails may be turned on
+void collectTrailMemory(MemoryReport& report); // Nothing unless set up
+uint64_t trailBytesWritten(); // Row bytes uploaded so far
+
+// Appends a row when the snapshot holds a tick the ring has not seen (every slot's history starts
+// again when the bullet ring's capacity changes)
+void syncTrails(const RenderSnapshot& view);
+// Draws every trail up to the interpolated positions (`alpha` past the newest row) in palette entries
+// `bulletPaint` and `shipPaint`. Returns the draw calls issued.
+int drawTrails(float alpha, uint32_t bulletPaint, uint32_t shipPaint);
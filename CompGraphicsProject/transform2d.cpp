@@ -0,0 +1,90 @@
+#include "transform2d.h"
+#include "collision.h"
+#include "fastmath.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define TRANSFORM_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#define TRANSFORM_TARGET_AVX2
+#else
+#define TRANSFORM_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+// ============================ AFFINE ============================
+Affine2 Affine2::rotation(float angle) {
+    float s, c;
+    fastSinCos(angle, s, c);
+    return { c, s, -s, c, 0.0f, 0.0f };
+}
+
+Affine2 Affine2::object(glm::vec2 position, float angle, float scale) {
+    float s, c;
+    fastSinCos(angle, s, c);
+    return { c * scale, s * scale, -s * scale, c * scale, position.x, position.y };
+}
+
+Affine2 Affine2::fieldToPixels(int width, int height) {
+    const float halfWidth = static_cast<float>(width) / 2.0f, halfHeight = static_cast<float>(height) / 2.0f;
+    return { halfWidth, 0.0f, 0.0f, halfHeight, halfWidth, halfHeight };
+}
+
+Affine2 Affine2::operator*(const Affine2& rhs) const {
+    return { a * rhs.a + c * rhs.b, b * rhs.a + d * rhs.b,
+             a * rhs.c + c * rhs.d, b * rhs.c + d * rhs.d,
+             a * rhs.tx + c * rhs.ty + tx, b * rhs.tx + d * rhs.ty + ty };
+}
+
+Affine2 Affine2::inverse() const {
+    const float invDet = 1.0f / (a * d - b * c);
+    const float ia = d * invDet, ib = -b * invDet, ic = -c * invDet, id = a * invDet;
+    return { ia, ib, ic, id, -(ia * tx + ic * ty), -(ib * tx + id * ty) };
+}
+
+// ============================ BATCH ============================
+// The vector paths compute apply()'s sums in its order (no FMA), on the instruction set the collision
+// kernels picked (--simd)
+static void transformPointsScalar(const Affine2& t, const float* x, const float* y, size_t begin, size_t n, float* outX, float* outY) {
+    for (size_t i = begin; i < n; ++i) {
+        const glm::vec2 p = t.apply(glm::vec2(x[i], y[i]));
+        outX[i] = p.x;
+        outY[i] = p.y;
+    }
+}
+
+#if defined(TRANSFORM_X86)
+static void transformPointsSse2(const Affine2& t, const float* x, const float* y, size_t n, float* outX, float* outY) {
+    const __m128 a = _mm_set1_ps(t.a), b = _mm_set1_ps(t.b), c = _mm_set1_ps(t.c), d = _mm_set1_ps(t.d);
+    const __m128 tx = _mm_set1_ps(t.tx), ty = _mm_set1_ps(t.ty);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m128 px = _mm_loadu_ps(x + i), py = _mm_loadu_ps(y + i);
+        _mm_storeu_ps(outX + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, px), _mm_mul_ps(c, py)), tx));
+        _mm_storeu_ps(outY + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(b, px), _mm_mul_ps(d, py)), ty));
+    }
+    transformPointsScalar(t, x, y, i, n, outX, outY);
+}
+
+TRANSFORM_TARGET_AVX2
+static void transformPointsAvx2(const Affine2& t, const float* x, const float* y, size_t n, float* outX, float* outY) {
+    const __m256 a = _mm256_set1_ps(t.a), b = _mm256_set1_ps(t.b), c = _mm256_set1_ps(t.c), d = _mm256_set1_ps(t.d);
+    const __m256 tx = _mm256_set1_ps(t.tx), ty = _mm256_set1_ps(t.ty);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256 px = _mm256_loadu_ps(x + i), py = _mm256_loadu_ps(y + i);
+        _mm256_storeu_ps(outX + i, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a, px), _mm256_mul_ps(c, py)), tx));
+        _mm256_storeu_ps(outY + i, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(b, px), _mm256_mul_ps(d, py)), ty));
+    }
+    _mm256_zeroupper(); // The tail and the caller are legacy SSE code: avoid the AVX/SSE transition stall
+    transformPointsSse2(t, x + i, y + i, n - i, outX + i, outY + i);
+}
+#endif
+
+void transformPoints(const Affine2& transform, const float* x, const float* y, size_t n, float* outX, float* outY) {
+#if defined(TRANSFORM_X86)
+    if (activeCollisionKernel() == COLLISION_KERNEL_AVX2) return transformPointsAvx2(transform, x, y, n, outX, outY);
+    if (activeCollisionKernel() == COLLISION_KERNEL_SSE2) return transformPointsSse2(transform, x, y, n, outX, outY);
+#endif
+    transformPointsScalar(transform, x, y, 0, n, outX, outY);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+// 2D affine transforms for CPU-side work (pixel corners, outlines), in place of a glm::mat4 built by
+// translate/rotate/scale: six floats, and a point costs four multiplies and four adds instead of a
+// 4x4 product. Composition and the inverse stay affine. transformPoints runs one transform over
+// structure-of-arrays points 8 or 4 at a time, with the same bits as apply().
+
+// ============================ AFFINE ============================
+// | a  c  tx |
+// | b  d  ty |   (x', y') = (a x + c y + tx, b x + d y + ty)
+struct Affine2 {
+    float a = 1.0f, b = 0.0f, c = 0.0f, d = 1.0f;
+    float tx = 0.0f, ty = 0.0f;
+
+    static Affine2 translation(glm::vec2 offset) { return { 1.0f, 0.0f, 0.0f, 1.0f, offset.x, offset.y }; }
+    static Affine2 scaling(glm::vec2 factor) { return { factor.x, 0.0f, 0.0f, factor.y, 0.0f, 0.0f }; }
+    static Affine2 rotation(float angle); // Counterclockwise, in radians
+    // Scale, then rotate, then translate: the game object shader's order
+    static Affine2 object(glm::vec2 position, float angle, float scale);
+    // Field coordinates ([-1, 1] on both axes) to pixels of a width x height framebuffer
+    static Affine2 fieldToPixels(int width, int height);
+
+    glm::vec2 apply(glm::vec2 p) const { return glm::vec2(a * p.x + c * p.y + tx, b * p.x + d * p.y + ty); }
+    glm::vec2 applyLinear(glm::vec2 v) const { return glm::vec2(a * v.x + c * v.y, b * v.x + d * v.y); } // No translation (directions)
+
+    Affine2 operator*(const Affine2& rhs) const; // this after rhs
+    Affine2 inverse() const; // The transform must not be singular
+};
+
+// ============================ BATCH ============================
+// (outX[i], outY[i]) = transform.apply((x[i], y[i])); the outputs may alias the inputs
+void transformPoints(const Affine2& transform, const float* x, const float* y, size_t n, float* outX, float* outY);
@@ -0,0 +1,138 @@
+#include "udpsocket.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <windows.h>
+#pragma comment(lib, "ws2_32.lib")
+typedef SOCKET NativeSocket;
+static const NativeSocket NO_SOCKET = INVALID_SOCKET;
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+typedef int NativeSocket;
+static const NativeSocket NO_SOCKET = -1;
+#endif
+
+static_assert(sizeof(UdpAddress::bytes) >= sizeof(sockaddr_storage), "A UdpAddress holds any socket address");
+
+static NativeSocket native(intptr_t handle) { return static_cast<NativeSocket>(handle); }
+
+// ============================ ADDRESSES ============================
+bool UdpAddress::operator==(const UdpAddress& other) const {
+    return length == other.length && std::memcmp(bytes, other.bytes, static_cast<size_t>(length)) == 0;
+}
+
+size_t UdpAddress::hash() const {
+    uint64_t h = 1469598103934665603ull; // FNV-1a
+    for (int k = 0; k < length; ++k) h = (h ^ bytes[k]) * 1099511628211ull;
+    return static_cast<size_t>(h);
+}
+
+bool resolveUdpAddress(const char* hostAndPort, int defaultPort, UdpAddress& address) {
+    std::string host = hostAndPort;
+    int port = defaultPort;
+    const size_t colon = host.rfind(':');
+    if (colon != std::string::npos) {
+        port = std::atoi(host.c_str() + colon + 1);
+        host.resize(colon);
+    }
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    if (port <= 0 || port > 65535) return false;
+#if defined(_WIN32)
+    WSADATA wsa; // Counted like open's, so it may come before any socket is open (spectators, relays)
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) return false;
+#endif
+    addrinfo* found = nullptr;
+    const bool resolved = getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &found) == 0 && found;
+    if (resolved) {
+        address = UdpAddress();
+        address.length = static_cast<int>(found->ai_addrlen);
+        std::memcpy(address.bytes, found->ai_addr, found->ai_addrlen);
+    }
+    if (found) freeaddrinfo(found);
+#if defined(_WIN32)
+    WSACleanup();
+#endif
+    return resolved;
+}
+
+// ============================ SOCKETS ============================
+bool UdpSocket::open(int port) {
+    close();
+#if defined(_WIN32)
+    WSADATA wsa; // Counted: every open is matched by a WSACleanup in close
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) return false;
+#endif
+    const NativeSocket s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    if (s == NO_SOCKET || bind(s, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+#if defined(_WIN32)
+        if (s != NO_SOCKET) closesocket(s);
+        WSACleanup();
+#else
+        if (s != NO_SOCKET) ::close(s);
+#endif
+        return false;
+    }
+    handle = static_cast<intptr_t>(s);
+    return true;
+}
+
+void UdpSocket::close() {
+    if (handle == -1) return;
+#if defined(_WIN32)
+    closesocket(native(handle));
+    WSACleanup();
+#else
+    ::close(native(handle));
+#endif
+    handle = -1;
+}
+
+void UdpSocket::setReceiveTimeout(int ms) {
+#if defined(_WIN32)
+    u_long nonBlocking = ms == 0 ? 1 : 0;
+    ioctlsocket(native(handle), FIONBIO, &nonBlocking);
+    DWORD timeout = static_cast<DWORD>(ms);
+    setsockopt(native(handle), SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+#else
+    const int flags = fcntl(native(handle), F_GETFL, 0);
+    fcntl(native(handle), F_SETFL, ms == 0 ? flags | O_NONBLOCK : flags & ~O_NONBLOCK);
+    timeval timeout = { ms / 1000, (ms % 1000) * 1000 };
+    setsockopt(native(handle), SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+#endif
+}
+
+int UdpSocket::receive(void* data, size_t capacity, UdpAddress& from) {
+#if defined(_WIN32)
+    int length = static_cast<int>(sizeof(sockaddr_storage));
+#else
+    socklen_t length = sizeof(sockaddr_storage);
+#endif
+    const int received = static_cast<int>(recvfrom(native(handle), static_cast<char*>(data), static_cast<int>(capacity), 0,
+                                                   reinterpret_cast<sockaddr*>(from.bytes), &length));
+    from.length = received >= 0 ? static_cast<int>(length) : 0;
+    return received;
+}
+
+bool UdpSocket::send(const void* data, size_t bytes, const UdpAddress& to) {
+    return sendto(native(handle), static_cast<const char*>(data), static_cast<int>(bytes), 0,
+                  reinterpret_cast<const sockaddr*>(to.bytes), to.length) >= 0;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// A UDP socket for the processes that talk to the match server (server.h) from the outside: the
+// relay and the game's spectator mode. Blocking with a receive timeout, or non-blocking for a
+// caller that polls once a frame. Windows sockets are started by the first socket opened.
+
+// ============================ ADDRESSES ============================
+struct UdpAddress {
+    alignas(8) unsigned char bytes[128] = {}; // A sockaddr_storage
+    int length = 0;
+
+    bool operator==(const UdpAddress& other) const;
+    size_t hash() const;
+};
+
+struct UdpAddressHash {
+    size_t operator()(const UdpAddress& address) const { return address.hash(); }
+};
+
+// "HOST:PORT" (or a bare HOST with `defaultPort`) to an IPv4 address; false if it does not resolve.
+// Starts and stops Winsock around the lookup itself, so no socket needs to be open first.
+bool resolveUdpAddress(const char* hostAndPort, int defaultPort, UdpAddress& address);
+
+// ============================ SOCKETS ============================
+struct UdpSocket {
+    intptr_t handle = -1;
+
+    bool open(int port); // Bound to `port` on every interface (0: any free port)
+    void close();
+    ~UdpSocket() { close(); }
+
+    void setReceiveTimeout(int ms); // 0: receive() returns at once when nothing has arrived
+    // Bytes of the datagram received (it is cut to `capacity`), or -1 on the timeout or an error
+    int receive(void* data, size_t capacity, UdpAddress& from);
+    bool send(const void* data, size_t bytes, const UdpAddress& to);
+};
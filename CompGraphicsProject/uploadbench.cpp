@@ -0,0 +1,336 @@
+#include "uploadbench.h"
+#include "frameconstants.h"
+#include "glstate.h"
+#include "instanceformat.h"
+#include "log.h"
+#include "random.h"
+#include "raster.h"
+#include "shaders.h"
+#include "streambuffer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iterator>
+#include <vector>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+enum UploadStrategy {
+    UPLOAD_SUBDATA,
+    UPLOAD_ORPHAN,
+    UPLOAD_MAP_INVALIDATE,
+    UPLOAD_MAP_UNSYNCHRONIZED,
+    UPLOAD_PERSISTENT,
+    UPLOAD_STRATEGY_COUNT
+};
+
+static const char* const uploadStrategyNames[UPLOAD_STRATEGY_COUNT] = {
+    "subdata", "orphan", "map invalidate", "map unsync", "persistent"
+};
+
+// 16 KB is about a large shield plus the ship outline; 4 MB is past the asteroid instances at 100k rocks
+static const size_t UPLOAD_PAYLOAD_SIZES[] = { 16 * 1024, 256 * 1024, 1024 * 1024, 4 * 1024 * 1024 };
+// Rock instance counts for the instance payloads (a fill and an outline record per rock, as drawn)
+static const size_t UPLOAD_INSTANCE_COUNTS[] = { 1000, 10000, 50000, 100000 };
+static const int UPLOAD_WARMUP_FRAMES = 30;
+static const int UPLOAD_BENCH_FRAMES = 240;
+static const int UPLOAD_QUERY_RING = 4; // Timer results are read this many frames late, so reading them does not stall
+
+// One instance point per record, read through the same attribute formats as the batched pass
+static const char* uploadInstanceVertexSource = R"(
+    #version 330 core
+    layout (location = 1) in vec2 iPosition;
+    layout (location = 2) in vec2 iRotationScale; // x = rotation, y = scale
+    layout (location = 3) in uint iPaint;
+    layout (location = 4) in uint iShapeSeed;
+    uniform float positionScale;
+    flat out uint paint;
+
+    void main()
+    {
+        paint = iPaint ^ iShapeSeed;
+        vec2 heading = vec2(cos(iRotationScale.x), sin(iRotationScale.x)) * iRotationScale.y * 0.01;
+        gl_Position = vec4(iPosition * positionScale + heading, 0.0, 1.0);
+    }
+)";
+
+static const char* uploadInstanceFragmentSource = R"(
+    #version 330 core
+    flat in uint paint;
+    out vec4 FragColor;
+
+    void main()
+    {
+        FragColor = vec4(vec3(float(paint & 0xFFu) / 255.0), 1.0);
+    }
+)";
+
+// What a case uploads: `bytes` from `data` each frame, or with `pack`, `count` ObjectInstances packed
+// into CompactInstances on the way (the packing is part of the upload's cost, as in the game)
+struct UploadPayloadSource {
+    const void* data = nullptr;
+    size_t count = 0;
+    size_t bytes = 0;
+    bool pack = false;
+    bool instances = false; // Drawn as instances, else as pixel points
+    bool compact = false;
+};
+
+static void fillPayload(const UploadPayloadSource& source, void* target) {
+    if (source.pack) packInstances(static_cast<const ObjectInstance*>(source.data), source.count, static_cast<CompactInstance*>(target));
+    else std::memcpy(target, source.data, source.bytes);
+}
+
+struct UploadResult {
+    bool supported = false;
+    double cpuMeanMs = 0.0, cpuP99Ms = 0.0;
+    double waitMs = 0.0; // Per frame
+    double frameMs = 0.0;
+    double gpuMs = 0.0;
+};
+
+static bool usesRing(UploadStrategy strategy) {
+    return strategy == UPLOAD_MAP_UNSYNCHRONIZED || strategy == UPLOAD_PERSISTENT;
+}
+
+// Rocks scattered over the view and a little past it, each a fill and an outline record
+static std::vector<ObjectInstance> buildInstancePayload(size_t rocks) {
+    Rng rng;
+    rng.seed(1, RNG_STREAM_VALIDATION);
+    std::vector<ObjectInstance> records;
+    records.reserve(2 * rocks);
+    for (size_t i = 0; i < rocks; ++i) {
+        const ObjectInstance fill = { glm::vec2(rng.range(-1.2f, 1.2f), rng.range(-1.2f, 1.2f)), rng.range(-20.0f, 20.0f),
+                                      rng.range(0.05f, 0.15f), static_cast<uint32_t>(rng.below(8)) | PAINT_FILL, rng.next() | 1u };
+        records.push_back(fill);
+        records.push_back(fill);
+        records.back().paint ^= PAINT_FILL | PAINT_OUTLINE;
+    }
+    return records;
+}
+
+// Shield circles of growing radius, one after the other, until `points` pixels are filled
+static std::vector<PixelPoint> buildPayload(size_t points, int width, int height) {
+    std::vector<PixelPoint> payload;
+    payload.reserve(points);
+    std::vector<int> rows;
+    std::vector<PixelPoint> circle;
+    for (int radius = 8; payload.size() < points; radius = radius >= std::min(width, height) / 2 ? 8 : radius + 5) {
+        circle.resize(8 * walkMidpointCircle(radius, rows));
+        circle.resize(drawMidpointCircle(width / 2, height / 2, rows, circle.data()));
+        const size_t take = std::min(circle.size(), points - payload.size());
+        payload.insert(payload.end(), circle.begin(), circle.begin() + static_cast<std::ptrdiff_t>(take));
+    }
+    return payload;
+}
+
+static UploadResult runUploadCase(GLFWwindow* window, UploadStrategy strategy, const UploadPayloadSource& payload,
+                                  unsigned int program, unsigned int vao, const unsigned int* queries) {
+    UploadResult result;
+    if (strategy == UPLOAD_PERSISTENT && !(GLAD_GL_VERSION_4_4 && glBufferStorage)) return result;
+    result.supported = true;
+
+    const size_t bytes = payload.bytes;
+    std::vector<unsigned char> staging(payload.pack ? bytes : 0); // Where subdata packs before the copy
+    const int segments = usesRing(strategy) ? STREAM_BUFFER_FRAMES : 1;
+    const GLsizeiptr totalSize = static_cast<GLsizeiptr>(bytes * segments);
+    unsigned int buffer = 0;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    unsigned char* persistent = nullptr;
+    if (strategy == UPLOAD_PERSISTENT) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_ARRAY_BUFFER, totalSize, NULL, flags);
+        persistent = static_cast<unsigned char*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, totalSize, flags));
+    }
+    else glBufferData(GL_ARRAY_BUFFER, totalSize, NULL, GL_STREAM_DRAW);
+    glState.useProgram(program);
+    glState.bindVertexArray(vao);
+
+    GLsync fences[STREAM_BUFFER_FRAMES] = {};
+    std::vector<double> cpuTimes;
+    cpuTimes.reserve(UPLOAD_BENCH_FRAMES);
+    double waitTotal = 0.0, gpuTotal = 0.0;
+    int gpuSamples = 0;
+    const GLsizei points = static_cast<GLsizei>(payload.instances ? payload.count : bytes / sizeof(PixelPoint));
+    const void* subdataSource = payload.pack ? static_cast<const void*>(staging.data()) : payload.data;
+    std::chrono::steady_clock::time_point benchStart;
+    for (int frame = 0; frame < UPLOAD_WARMUP_FRAMES + UPLOAD_BENCH_FRAMES; ++frame) {
+        const bool measured = frame >= UPLOAD_WARMUP_FRAMES;
+        if (frame == UPLOAD_WARMUP_FRAMES) benchStart = std::chrono::steady_clock::now();
+        const int segment = frame % segments;
+        const size_t offset = static_cast<size_t>(segment) * bytes;
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        // The upload, timed; the ring strategies time their fence wait on its own as well
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        if (usesRing(strategy) && fences[segment]) {
+            const std::chrono::steady_clock::time_point waitStart = std::chrono::steady_clock::now();
+            glClientWaitSync(fences[segment], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+            if (measured) waitTotal += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - waitStart).count();
+            glDeleteSync(fences[segment]);
+            fences[segment] = 0;
+        }
+        switch (strategy) {
+        case UPLOAD_SUBDATA:
+            if (payload.pack) fillPayload(payload, staging.data());
+            glBufferSubData(GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(bytes), subdataSource);
+            break;
+        case UPLOAD_ORPHAN:
+            if (payload.pack) fillPayload(payload, staging.data());
+            glBufferData(GL_ARRAY_BUFFER, totalSize, NULL, GL_STREAM_DRAW);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(bytes), subdataSource);
+            break;
+        case UPLOAD_MAP_INVALIDATE:
+        case UPLOAD_MAP_UNSYNCHRONIZED: {
+            const GLbitfield access = strategy == UPLOAD_MAP_INVALIDATE ? GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT
+                                                                      : GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+            if (void* target = glMapBufferRange(GL_ARRAY_BUFFER, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(bytes), access)) {
+                fillPayload(payload, target);
+                glUnmapBuffer(GL_ARRAY_BUFFER);
+            }
+            break;
+        }
+        case UPLOAD_PERSISTENT:
+            if (persistent) fillPayload(payload, persistent + offset);
+            break;
+        default:
+            break;
+        }
+        if (measured) cpuTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+        // Read the timer query this slot used UPLOAD_QUERY_RING frames ago before reusing it
+        const unsigned int query = queries[frame % UPLOAD_QUERY_RING];
+        if (frame >= UPLOAD_QUERY_RING) {
+            GLuint64 nanoseconds = 0;
+            glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+            if (frame - UPLOAD_QUERY_RING >= UPLOAD_WARMUP_FRAMES) {
+                gpuTotal += nanoseconds / 1.0e6;
+                ++gpuSamples;
+            }
+        }
+        if (payload.instances) instanceAttributePointers(payload.compact, offset);
+        else glVertexAttribIPointer(0, 2, GL_SHORT, sizeof(PixelPoint), (void*)offset);
+        glBeginQuery(GL_TIME_ELAPSED, query);
+        if (payload.instances) glDrawArraysInstanced(GL_POINTS, 0, 1, points);
+        else glDrawArrays(GL_POINTS, 0, points);
+        glEndQuery(GL_TIME_ELAPSED);
+        if (usesRing(strategy)) fences[segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
+    const double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - benchStart).count();
+
+    glFinish(); // The last queries and fences are done before their objects go
+    for (int i = 0; i < UPLOAD_QUERY_RING; ++i) {
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(queries[i], GL_QUERY_RESULT, &nanoseconds); // Leaves no query pending for the next case
+    }
+    for (GLsync fence : fences) {
+        if (fence) glDeleteSync(fence);
+    }
+    if (persistent) glUnmapBuffer(GL_ARRAY_BUFFER);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glDeleteBuffers(1, &buffer);
+
+    double cpuTotal = 0.0;
+    for (double t : cpuTimes) cpuTotal += t;
+    std::sort(cpuTimes.begin(), cpuTimes.end());
+    result.cpuMeanMs = cpuTotal / UPLOAD_BENCH_FRAMES;
+    result.cpuP99Ms = cpuTimes[std::min(cpuTimes.size() - 1, cpuTimes.size() * 99 / 100)];
+    result.waitMs = waitTotal / UPLOAD_BENCH_FRAMES;
+    result.frameMs = elapsedMs / UPLOAD_BENCH_FRAMES;
+    result.gpuMs = gpuSamples > 0 ? gpuTotal / gpuSamples : 0.0;
+    return result;
+}
+
+// Every strategy on one payload, then the cheapest
+static void runUploadStrategies(GLFWwindow* window, const UploadPayloadSource& payload, unsigned int program, unsigned int vao,
+                                const unsigned int* queries) {
+    int best = -1;
+    double bestCost = 0.0;
+    for (int s = 0; s < UPLOAD_STRATEGY_COUNT; ++s) {
+        const UploadResult r = runUploadCase(window, static_cast<UploadStrategy>(s), payload, program, vao, queries);
+        if (!r.supported) {
+            LOG_INFO("    %-15s n/a (needs GL 4.4 buffer storage)", uploadStrategyNames[s]);
+            continue;
+        }
+        LOG_INFO("    %-15s cpu %.4f ms (p99 %.4f), wait %.4f ms, frame %.3f ms, gpu %.4f ms",
+                 uploadStrategyNames[s], r.cpuMeanMs, r.cpuP99Ms, r.waitMs, r.frameMs, r.gpuMs);
+        // The main thread pays for the upload, its stalls and the spikes; the frame time breaks ties
+        const double cost = r.cpuMeanMs + r.cpuP99Ms + r.frameMs * 1e-3;
+        if (best < 0 || cost < bestCost) {
+            best = s;
+            bestCost = cost;
+        }
+    }
+    if (best >= 0) LOG_INFO("    best: %s", uploadStrategyNames[best]);
+}
+
+int runUploadBenchmark(GLFWwindow* window, unsigned int pixelProgram, int framebufferWidth, int framebufferHeight, UploadPayload payloadKind) {
+    const bool instances = payloadKind != UPLOAD_PAYLOAD_PIXELS;
+    const bool compact = payloadKind == UPLOAD_PAYLOAD_COMPACT_INSTANCES;
+    unsigned int program = pixelProgram;
+    if (instances) {
+        program = buildProgram("upload instances", uploadInstanceVertexSource, uploadInstanceFragmentSource);
+        if (!program) return 1;
+        glState.useProgram(program);
+        glUniform1f(glGetUniformLocation(program, "positionScale"), compact ? INSTANCE_POSITION_RANGE : 1.0f);
+    }
+
+    unsigned int vao = 0;
+    glGenVertexArrays(1, &vao);
+    glState.bindVertexArray(vao);
+    if (instances) {
+        for (unsigned int attrib = 1; attrib <= 4; ++attrib) {
+            glEnableVertexAttribArray(attrib);
+            glVertexAttribDivisor(attrib, 1);
+        }
+    }
+    else glEnableVertexAttribArray(0);
+    unsigned int queries[UPLOAD_QUERY_RING];
+    glGenQueries(UPLOAD_QUERY_RING, queries);
+    glfwSwapInterval(0); // Vsync would hide the stalls behind the wait for the display
+
+    const char* payloadNames[] = { "shield pixels drawn as points", "float instance records (24 bytes)", "compact instance records (12 bytes)" };
+    LOG_INFO("Upload benchmark on %s / %s (%d frames per case, %s):",
+             reinterpret_cast<const char*>(glGetString(GL_VENDOR)), reinterpret_cast<const char*>(glGetString(GL_RENDERER)),
+             UPLOAD_BENCH_FRAMES, payloadNames[payloadKind]);
+    if (instances) {
+        const size_t most = *std::max_element(std::begin(UPLOAD_INSTANCE_COUNTS), std::end(UPLOAD_INSTANCE_COUNTS));
+        const std::vector<ObjectInstance> records = buildInstancePayload(most);
+        for (size_t rocks : UPLOAD_INSTANCE_COUNTS) {
+            UploadPayloadSource payload;
+            payload.data = records.data();
+            payload.count = 2 * rocks;
+            payload.bytes = payload.count * instanceRecordSize(compact);
+            payload.pack = compact;
+            payload.instances = true;
+            payload.compact = compact;
+            LOG_INFO("  %zu rocks, %zu KB per frame:", rocks, payload.bytes / 1024);
+            runUploadStrategies(window, payload, program, vao, queries);
+        }
+    }
+    else {
+        const size_t largest = *std::max_element(std::begin(UPLOAD_PAYLOAD_SIZES), std::end(UPLOAD_PAYLOAD_SIZES));
+        const std::vector<PixelPoint> pixels = buildPayload(largest / sizeof(PixelPoint), framebufferWidth, framebufferHeight);
+        for (size_t bytes : UPLOAD_PAYLOAD_SIZES) {
+            UploadPayloadSource payload;
+            payload.data = pixels.data();
+            payload.bytes = bytes;
+            LOG_INFO("  %zu KB per frame:", bytes / 1024);
+            runUploadStrategies(window, payload, program, vao, queries);
+        }
+    }
+
+    glDeleteQueries(UPLOAD_QUERY_RING, queries);
+    glState.bindVertexArray(0);
+    glDeleteVertexArrays(1, &vao);
+    if (instances) {
+        glState.useProgram(0);
+        glDeleteProgram(program);
+    }
+    return 0;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+struct GLFWwindow;
+
+// ============================ UPLOAD BENCHMARK ============================
+// --bench-upload: streams the CPU rasterizers' pixel points (shield circles, as the shield and ship
+// outline upload them) at several payload sizes, up to what the batched asteroid instances take, with
+// each way GL offers to update a buffer every frame, draws them, and reports per strategy and size:
+//   cpu    the upload calls' time, mean and 99th percentile (an implicit stall in the driver shows
+//          up here, as a spike)
+//   wait   time blocked on a fence before reusing a ring segment (the explicit stall)
+//   frame  swap to swap, so stalls that surface elsewhere in the pipeline count too
+//   gpu    the draw's GL_TIME_ELAPSED, which grows when the GPU reads from a slow heap
+// followed by the cheapest strategy per size, with the vendor and renderer they were measured on.
+// The strategies:
+//   subdata        glBufferSubData into one buffer
+//   orphan         glBufferData(NULL) to orphan the storage, then glBufferSubData
+//   map invalidate glMapBufferRange with GL_MAP_INVALIDATE_BUFFER_BIT
+//   map unsync     a ring of STREAM_BUFFER_FRAMES segments, each mapped with GL_MAP_UNSYNCHRONIZED_BIT
+//                  and fenced (the stream buffer's GL 3.3 path)
+//   persistent     the same ring persistently and coherently mapped (GL 4.4; the stream buffer's
+//                  default path)
+// The instance payloads stream 1k to 100k rocks' fill and outline records instead, as float records or
+// packed into compact ones on the way (instanceformat.h, the packing counted in the upload), each drawn
+// as one point per record through the batched pass's attribute formats: run it once with each to
+// compare the formats.
+// `pixelProgram` draws ivec2 pixel points at attribute 0 (the pixel point shader). Returns the exit code.
+enum UploadPayload {
+    UPLOAD_PAYLOAD_PIXELS,
+    UPLOAD_PAYLOAD_FLOAT_INSTANCES,
+    UPLOAD_PAYLOAD_COMPACT_INSTANCES
+};
+
+int runUploadBenchmark(GLFWwindow* window, unsigned int pixelProgram, int framebufferWidth, int framebufferHeight, UploadPayload payload);
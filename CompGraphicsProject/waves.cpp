@@ -0,0 +1,176 @@
+#include "waves.h"
+#include "mappedfile.h"
+#include "log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+const uint32_t WAVE_MAX_LARGE = 12; // Rocks in a wave's first group, at most (the asteroid limit still applies)
+
+// ============================ BUILT-IN WAVES ============================
+WaveScript classicWaves() {
+    static const SpawnSide sides[] = { SPAWN_LEFT, SPAWN_TOP, SPAWN_RIGHT, SPAWN_BOTTOM };
+    co_await waitSeconds(2.0f); // A moment to get going
+    for (uint32_t wave = 0;; ++wave) {
+        co_await spawnRocks(std::min(3 + wave, WAVE_MAX_LARGE), LARGE, sides[wave % 4]);
+        co_await waitSeconds(5.0f);
+        co_await spawnRocks(std::min(1 + wave, WAVE_MAX_LARGE), MEDIUM, sides[(wave + 2) % 4]);
+        co_await untilFieldClear();
+        co_await waitSeconds(3.0f);
+    }
+}
+
+// ============================ WAVE FILES ============================
+static MappedFile waveFile;
+static const WaveRecord* waveRecords = nullptr; // Inside the mapping
+static uint32_t waveRecordCount = 0, waveLoopFrom = 0;
+
+// Walks the records where they lie. The loader only checks the header, so a record out of range
+// is brought into range here rather than trusted.
+static WaveScript fileWaves(const WaveRecord* records, uint32_t count, uint32_t loopFrom) {
+    for (uint32_t pass = 0;; ++pass) {
+        bool waited = false;
+        for (uint32_t i = pass == 0 ? 0 : loopFrom; i < count; ++i) {
+            const WaveRecord& record = records[i];
+            uint32_t amount = record.count + pass * record.growth;
+            if (record.cap) amount = std::min<uint32_t>(amount, record.cap);
+            if (record.type == WAVE_SPAWN) {
+                co_await spawnRocks(amount, static_cast<AsteroidSize>(std::min<uint8_t>(record.size, LARGE)),
+                                    static_cast<SpawnSide>(std::min<uint8_t>(record.side, SPAWN_RIGHT)));
+                continue;
+            }
+            waited = true;
+            if (record.type == WAVE_WAIT_TICKS) co_await waitTicks(amount);
+            else co_await untilFieldClear();
+        }
+        if (loopFrom >= count || (pass > 0 && !waited)) co_return; // No loop, or one that never waits
+    }
+}
+
+WaveScript startWaveScript() {
+    return waveRecords ? fileWaves(waveRecords, waveRecordCount, waveLoopFrom) : classicWaves();
+}
+
+bool loadWaveFile(const char* path) {
+    unloadWaveFile();
+    WaveFileHeader header;
+    if (!waveFile.open(path) || waveFile.size < sizeof(header)) {
+        LOG_ERROR("Cannot read wave file %s", path);
+        waveFile.close();
+        return false;
+    }
+    std::memcpy(&header, waveFile.data, sizeof(header));
+    if (header.magic != WAVE_FILE_MAGIC || header.version != WAVE_FILE_VERSION || header.loopFrom > header.commandCount ||
+        waveFile.size != sizeof(header) + static_cast<size_t>(header.commandCount) * sizeof(WaveRecord)) {
+        LOG_ERROR("%s is not a version %u wave file", path, WAVE_FILE_VERSION);
+        waveFile.close();
+        return false;
+    }
+    waveRecords = reinterpret_cast<const WaveRecord*>(waveFile.data + sizeof(header)); // The mapping is page aligned
+    waveRecordCount = header.commandCount;
+    waveLoopFrom = header.loopFrom;
+    LOG_INFO("Wave file %s: %u commands, looping from %u", path, waveRecordCount, waveLoopFrom);
+    return true;
+}
+
+void unloadWaveFile() {
+    waveFile.close();
+    waveRecords = nullptr;
+    waveRecordCount = waveLoopFrom = 0;
+}
+
+// ============================ WAVE SOURCE COMPILER ============================
+static bool parseNamed(const std::string& word, const char* const* names, int count, uint8_t& value) {
+    for (int i = 0; i < count; ++i) {
+        if (word == names[i]) {
+            value = static_cast<uint8_t>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool compileWaveFile(const char* sourcePath, const char* outputPath) {
+    static const char* const sizeNames[] = { "small", "medium", "large" }; // AsteroidSize order
+    static const char* const sideNames[] = { "any", "top", "bottom", "left", "right" }; // SpawnSide order
+    std::ifstream source(sourcePath);
+    if (!source) {
+        LOG_ERROR("Cannot read wave source %s", sourcePath);
+        return false;
+    }
+    std::vector<WaveRecord> records;
+    WaveFileHeader header = { WAVE_FILE_MAGIC, WAVE_FILE_VERSION, 0, 0 };
+    bool looped = false, loopWaits = false;
+    std::string line;
+    for (int lineNumber = 1; std::getline(source, line); ++lineNumber) {
+        std::istringstream words(line.substr(0, line.find('#')));
+        std::string command;
+        if (!(words >> command)) continue;
+        WaveRecord record = {};
+        bool valid = true;
+        if (command == "spawn") {
+            long count = 0;
+            std::string size, word;
+            record.type = WAVE_SPAWN;
+            valid = (words >> count >> size) && count > 0 && count <= UINT16_MAX && parseNamed(size, sizeNames, 3, record.size);
+            record.count = static_cast<uint16_t>(count);
+            while (valid && (words >> word)) {
+                long value = 0;
+                if (parseNamed(word, sideNames, 5, record.side)) continue;
+                if (word.size() > 1 && word[0] == '+') {
+                    value = std::strtol(word.c_str() + 1, nullptr, 10);
+                    valid = value > 0 && value <= UINT16_MAX;
+                    record.growth = static_cast<uint16_t>(value);
+                }
+                else if (word == "max") {
+                    valid = (words >> value) && value > 0 && value <= UINT8_MAX;
+                    record.cap = static_cast<uint8_t>(value);
+                }
+                else valid = false;
+            }
+        }
+        else if (command == "wait") {
+            float seconds = 0.0f;
+            record.type = WAVE_WAIT_TICKS;
+            valid = (words >> seconds) && seconds > 0.0f && ticksFor(seconds) <= UINT16_MAX;
+            record.count = valid ? static_cast<uint16_t>(ticksFor(seconds)) : 0;
+            loopWaits |= looped;
+        }
+        else if (command == "clear") {
+            record.type = WAVE_WAIT_FIELD_CLEAR;
+            loopWaits |= looped;
+        }
+        else if (command == "loop" && !looped) {
+            header.loopFrom = static_cast<uint32_t>(records.size());
+            looped = true;
+            continue;
+        }
+        else valid = false;
+        std::string extra;
+        if (!valid || (words >> extra)) {
+            LOG_ERROR("%s:%d: cannot read \"%s\"", sourcePath, lineNumber, line.c_str());
+            return false;
+        }
+        records.push_back(record);
+    }
+    if (looped && !loopWaits) {
+        LOG_ERROR("%s: the loop never waits", sourcePath);
+        return false;
+    }
+    header.commandCount = static_cast<uint32_t>(records.size());
+    if (!looped) header.loopFrom = header.commandCount;
+
+    std::ofstream output(outputPath, std::ios::binary | std::ios::trunc);
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    output.write(reinterpret_cast<const char*>(records.data()), static_cast<std::streamsize>(records.size() * sizeof(WaveRecord)));
+    if (!output) {
+        LOG_ERROR("Failed writing wave file %s", outputPath);
+        return false;
+    }
+    LOG_INFO("Compiled %s into %s: %u commands", sourcePath, outputPath, header.commandCount);
+    return true;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+
+#include "simulation.h"
+
+// The wave scripts (--waves): coroutines that co_await the commands below, one at a time, in the
+// world's spawn phase (see WAVE SCRIPTS in simulation.h for how the world drives them). A script
+// may only co_await these: it has no world to look at, which is what lets a restored world replay
+// it to where it was. Like simulation.h, nothing here depends on GL.
+//
+// Wave sets can also ship as data (--waves-file): a text source compiled (--compile-waves) into a
+// flat binary file of fixed-size records that is memory-mapped at startup and read in place by the
+// script walking it, so loading is a header check and nothing is parsed, copied or allocated. The
+// text is one command per line ('#' starts a comment):
+//     spawn 10 large left +2 max 16   # rocks, size, side (any if left out), added per loop, at most
+//     wait 5                          # seconds
+//     clear                           # until no rocks are left
+//     loop                            # the commands after this repeat until the game ends
+// A loop must wait somewhere, or it would spawn forever within one tick.
+
+// ============================ WAVE COMMANDS ============================
+inline WaveCommand spawnRocks(uint32_t count, AsteroidSize size, SpawnSide side = SPAWN_ANY_SIDE) { return { WAVE_SPAWN, size, side, count }; }
+inline WaveCommand waitTicks(uint32_t ticks) { return { WAVE_WAIT_TICKS, LARGE, SPAWN_ANY_SIDE, ticks }; }
+inline WaveCommand waitSeconds(float seconds) { return waitTicks(static_cast<uint32_t>(ticksFor(seconds))); }
+inline WaveCommand untilFieldClear() { return { WAVE_WAIT_FIELD_CLEAR, LARGE, SPAWN_ANY_SIDE, 0 }; }
+
+// ============================ WAVE FILE FORMAT ============================
+// A WaveFileHeader, then commandCount WaveRecords, little-endian, nothing else (the file's size
+// is checked against the count)
+const uint32_t WAVE_FILE_MAGIC = 0x45564157; // "WAVE"
+const uint32_t WAVE_FILE_VERSION = 1;
+
+struct WaveFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t commandCount;
+    uint32_t loopFrom; // First command of the loop; commandCount: no loop (the script ends)
+};
+
+struct WaveRecord {
+    uint8_t type; // WaveCommandType
+    uint8_t size; // AsteroidSize (spawns)
+    uint8_t side; // SpawnSide (spawns)
+    uint8_t cap; // Most the count grows to (0: no limit)
+    uint16_t count; // Rocks, or ticks
+    uint16_t growth; // Added to the count on each pass through the loop
+};
+static_assert(sizeof(WaveRecord) == 8, "Wave records are read in place from the mapped file");
+
+// ============================ WAVE API ============================
+// The loaded wave file's script, or classicWaves without one
+WaveScript startWaveScript();
+// The game's built-in waves: each comes in over the next side, larger than the one before, with a
+// second group from the opposite side while the first is still on the field; the next starts a
+// little after the field is clear. Runs until the game ends.
+WaveScript classicWaves();
+
+// Compiles a text wave source into a wave file; false (with the line at fault logged) on an error
+bool compileWaveFile(const char* sourcePath, const char* outputPath);
+// Maps a compiled wave file for startWaveScript; false if it is missing or not a wave file. It stays
+// mapped until unloadWaveFile, which must wait until no world runs its script.
+bool loadWaveFile(const char* path);
+void unloadWaveFile();